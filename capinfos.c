@@ -1155,6 +1155,10 @@ process_cap_file(const char *filename, gboolean need_separator)
     wtap_set_cb_new_ipv6(cf_info.wth, count_ipv6_address);
     wtap_set_cb_new_secrets(cf_info.wth, count_decryption_secret);
 
+    /* We only look at record headers, so don't read the packet bytes
+       from file types that can skip them. */
+    wtap_set_skip_packet_data(cf_info.wth, TRUE);
+
     /* Tally up data that we need to parse through the file to find */
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
@@ -490,6 +490,15 @@ capture_get_if_list_capabilities(GList *if_cap_queries,
     jsmntok_t         *tokens, *inf_tok;
 
     caps_hash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_if_capabilities_cb);
+
+    /* Run the extcap queries in parallel rather than one by one below. */
+    GList *ifnames = NULL;
+    for (GList *li = if_cap_queries; li != NULL; li = g_list_next(li)) {
+        ifnames = g_list_prepend(ifnames, (void *)((if_cap_query_t *)li->data)->name);
+    }
+    extcap_prefetch_if_dlts(ifnames);
+    g_list_free(ifnames);
+
     for (GList *li = if_cap_queries; li != NULL; li = g_list_next(li)) {
 
         query = (if_cap_query_t *)li->data;
@@ -0,0 +1,543 @@
+/* cfilter-from-dfilter.c
+ * Translation of a subset of display filter syntax to capture filters
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Display filters are compiled and run in user space, after the packet
+ * has been captured; capture filters are compiled by libpcap to BPF and,
+ * on most platforms, run in the kernel (on Linux, JIT-compiled), so that
+ * packets they reject are never copied to us at all.  For filters on
+ * fields at fixed places in the packet the two are equivalent, so let
+ * people use the display filter syntax they already know for those.
+ *
+ * We don't use the display filter compiler, as dumpcap doesn't link with
+ * libwireshark; the subset is small enough that a little recursive
+ * descent parser does the job.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/inet_addr.h>
+
+#include "cfilter-from-dfilter.h"
+
+typedef enum {
+    TOK_END,
+    TOK_LPAREN,
+    TOK_RPAREN,
+    TOK_AND,
+    TOK_OR,
+    TOK_NOT,
+    TOK_EQ,
+    TOK_NE,
+    TOK_LT,
+    TOK_LE,
+    TOK_GT,
+    TOK_GE,
+    TOK_WORD
+} token_type;
+
+typedef struct {
+    const char *p;          /* where we are in the filter */
+    token_type  type;       /* the current token */
+    gchar      *word;       /* its text, if it's TOK_WORD */
+    gchar      *err_msg;    /* the first error */
+} parse_state;
+
+typedef enum {
+    VAL_UINT,
+    VAL_IPV4,
+    VAL_IPV6,
+    VAL_ETHER
+} value_type;
+
+typedef enum {
+    CMP_EQ_ONLY,    /* only == and != */
+    CMP_PORT,       /* also ordering, as a port range */
+    CMP_LEN         /* also ordering, as a comparison of the length */
+} compare_type;
+
+typedef struct {
+    const char  *field;
+    value_type   type;
+    compare_type cmp;
+    guint64      max;       /* for VAL_UINT */
+    const char  *host;      /* capture filter primitive for a single value */
+    const char  *net;       /* capture filter primitive for an address with a prefix */
+} fixed_field;
+
+static const fixed_field fixed_fields[] = {
+    { "eth.addr",    VAL_ETHER, CMP_EQ_ONLY, 0,          "ether host",     NULL },
+    { "eth.src",     VAL_ETHER, CMP_EQ_ONLY, 0,          "ether src host", NULL },
+    { "eth.dst",     VAL_ETHER, CMP_EQ_ONLY, 0,          "ether dst host", NULL },
+    { "eth.type",    VAL_UINT,  CMP_EQ_ONLY, 0xffff,     "ether proto",    NULL },
+    { "ip.addr",     VAL_IPV4,  CMP_EQ_ONLY, 0,          "ip host",        "ip net" },
+    { "ip.src",      VAL_IPV4,  CMP_EQ_ONLY, 0,          "ip src host",    "ip src net" },
+    { "ip.dst",      VAL_IPV4,  CMP_EQ_ONLY, 0,          "ip dst host",    "ip dst net" },
+    { "ip.proto",    VAL_UINT,  CMP_EQ_ONLY, 0xff,       "ip proto",       NULL },
+    { "ipv6.addr",   VAL_IPV6,  CMP_EQ_ONLY, 0,          "ip6 host",       "ip6 net" },
+    { "ipv6.src",    VAL_IPV6,  CMP_EQ_ONLY, 0,          "ip6 src host",   "ip6 src net" },
+    { "ipv6.dst",    VAL_IPV6,  CMP_EQ_ONLY, 0,          "ip6 dst host",   "ip6 dst net" },
+    { "tcp.port",    VAL_UINT,  CMP_PORT,    0xffff,     "tcp port",       "tcp portrange" },
+    { "tcp.srcport", VAL_UINT,  CMP_PORT,    0xffff,     "tcp src port",   "tcp src portrange" },
+    { "tcp.dstport", VAL_UINT,  CMP_PORT,    0xffff,     "tcp dst port",   "tcp dst portrange" },
+    { "udp.port",    VAL_UINT,  CMP_PORT,    0xffff,     "udp port",       "udp portrange" },
+    { "udp.srcport", VAL_UINT,  CMP_PORT,    0xffff,     "udp src port",   "udp src portrange" },
+    { "udp.dstport", VAL_UINT,  CMP_PORT,    0xffff,     "udp dst port",   "udp dst portrange" },
+    { "frame.len",   VAL_UINT,  CMP_LEN,     G_MAXUINT32, "len",           NULL },
+};
+
+static const struct {
+    const char *proto;
+    const char *primitive;
+} protocols[] = {
+    { "arp",    "arp" },
+    { "ip",     "ip" },
+    { "ipv6",   "ip6" },
+    { "icmp",   "icmp" },
+    { "icmpv6", "icmp6" },
+    { "tcp",    "tcp" },
+    { "udp",    "udp" },
+    { "sctp",   "sctp" },
+};
+
+static gchar *parse_or(parse_state *state);
+
+static void
+parse_error(parse_state *state, const char *fmt, ...) G_GNUC_PRINTF(2, 3);
+
+static void
+parse_error(parse_state *state, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (state->err_msg != NULL)
+        return;
+    va_start(ap, fmt);
+    state->err_msg = g_strdup_vprintf(fmt, ap);
+    va_end(ap);
+}
+
+static gboolean
+is_word_char(char c)
+{
+    return g_ascii_isalnum(c) || c == '_' || c == '.' || c == ':' ||
+           c == '/' || c == '-';
+}
+
+static void
+next_token(parse_state *state)
+{
+    const char *start;
+
+    g_free(state->word);
+    state->word = NULL;
+
+    while (g_ascii_isspace(*state->p))
+        state->p++;
+
+    switch (*state->p) {
+
+    case '\0':
+        state->type = TOK_END;
+        return;
+
+    case '(':
+        state->type = TOK_LPAREN;
+        state->p++;
+        return;
+
+    case ')':
+        state->type = TOK_RPAREN;
+        state->p++;
+        return;
+
+    case '&':
+        if (state->p[1] == '&') {
+            state->type = TOK_AND;
+            state->p += 2;
+            return;
+        }
+        break;
+
+    case '|':
+        if (state->p[1] == '|') {
+            state->type = TOK_OR;
+            state->p += 2;
+            return;
+        }
+        break;
+
+    case '=':
+        if (state->p[1] == '=') {
+            state->type = TOK_EQ;
+            state->p += 2;
+            return;
+        }
+        break;
+
+    case '!':
+        if (state->p[1] == '=') {
+            state->type = TOK_NE;
+            state->p += 2;
+        } else {
+            state->type = TOK_NOT;
+            state->p++;
+        }
+        return;
+
+    case '<':
+        if (state->p[1] == '=') {
+            state->type = TOK_LE;
+            state->p += 2;
+        } else {
+            state->type = TOK_LT;
+            state->p++;
+        }
+        return;
+
+    case '>':
+        if (state->p[1] == '=') {
+            state->type = TOK_GE;
+            state->p += 2;
+        } else {
+            state->type = TOK_GT;
+            state->p++;
+        }
+        return;
+
+    default:
+        if (is_word_char(*state->p)) {
+            start = state->p;
+            while (is_word_char(*state->p))
+                state->p++;
+            state->word = g_strndup(start, state->p - start);
+            /* Keywords */
+            if (strcmp(state->word, "and") == 0)
+                state->type = TOK_AND;
+            else if (strcmp(state->word, "or") == 0)
+                state->type = TOK_OR;
+            else if (strcmp(state->word, "not") == 0)
+                state->type = TOK_NOT;
+            else if (strcmp(state->word, "eq") == 0)
+                state->type = TOK_EQ;
+            else if (strcmp(state->word, "ne") == 0)
+                state->type = TOK_NE;
+            else if (strcmp(state->word, "lt") == 0)
+                state->type = TOK_LT;
+            else if (strcmp(state->word, "le") == 0)
+                state->type = TOK_LE;
+            else if (strcmp(state->word, "gt") == 0)
+                state->type = TOK_GT;
+            else if (strcmp(state->word, "ge") == 0)
+                state->type = TOK_GE;
+            else
+                state->type = TOK_WORD;
+            return;
+        }
+        break;
+    }
+    parse_error(state, "\"%.16s\" isn't supported in a capture filter", state->p);
+    state->type = TOK_END;
+}
+
+/*
+ * Check that a value is an integer, address, or prefix of the type the
+ * field wants, and return it in the form the capture filter wants, or
+ * NULL if it isn't.  We're strict about this, both because the capture
+ * filter compiler would otherwise look up names that the display filter
+ * compiler would treat differently, and so that nothing in the value can
+ * change the meaning of the capture filter.
+ */
+static gchar *
+check_value(const fixed_field *field, const char *value, guint64 *uint_val,
+            gboolean *is_prefix)
+{
+    const char *slash;
+    gchar      *addr;
+    gchar      *endp;
+    guint64     prefix = 0;
+    ws_in4_addr ipv4;
+    ws_in6_addr ipv6;
+    guint       bytes[6];
+    gboolean    ok;
+
+    *is_prefix = FALSE;
+    switch (field->type) {
+
+    case VAL_UINT:
+        if (!g_ascii_isdigit(*value))
+            return NULL;
+        *uint_val = g_ascii_strtoull(value, &endp, 0);
+        if (*endp != '\0' || *uint_val > field->max)
+            return NULL;
+        return g_strdup_printf("%" G_GUINT64_FORMAT, *uint_val);
+
+    case VAL_IPV4:
+    case VAL_IPV6:
+        slash = strchr(value, '/');
+        if (slash != NULL) {
+            if (!g_ascii_isdigit(slash[1]))
+                return NULL;
+            prefix = g_ascii_strtoull(slash + 1, &endp, 10);
+            if (*endp != '\0' ||
+                prefix > (field->type == VAL_IPV4 ? 32 : 128))
+                return NULL;
+            addr = g_strndup(value, slash - value);
+            *is_prefix = TRUE;
+        } else
+            addr = g_strdup(value);
+        if (field->type == VAL_IPV4)
+            ok = ws_inet_pton4(addr, &ipv4);
+        else
+            ok = ws_inet_pton6(addr, &ipv6);
+        g_free(addr);
+        return ok ? g_strdup(value) : NULL;
+
+    case VAL_ETHER:
+        if (strlen(value) != 17 ||
+            sscanf(value, "%2x%*1[:.-]%2x%*1[:.-]%2x%*1[:.-]%2x%*1[:.-]%2x%*1[:.-]%2x",
+                   &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5]) != 6)
+            return NULL;
+        return g_strdup_printf("%02x:%02x:%02x:%02x:%02x:%02x",
+                               bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+    }
+    return NULL;
+}
+
+static gchar *
+translate_comparison(parse_state *state, const fixed_field *field,
+                     token_type op, const char *value)
+{
+    gchar   *cvalue;
+    gchar   *result = NULL;
+    guint64  uint_val = 0;
+    gboolean is_prefix;
+
+    cvalue = check_value(field, value, &uint_val, &is_prefix);
+    if (cvalue == NULL) {
+        parse_error(state, "\"%s\" isn't a valid value for %s in a capture filter",
+                    value, field->field);
+        return NULL;
+    }
+
+    if (field->cmp == CMP_LEN) {
+        static const char *relops[] = {
+            [TOK_EQ] = "==", [TOK_NE] = "!=", [TOK_LT] = "<",
+            [TOK_LE] = "<=", [TOK_GT] = ">", [TOK_GE] = ">="
+        };
+
+        result = g_strdup_printf("%s %s %s", field->host, relops[op], cvalue);
+    } else if (op == TOK_EQ || op == TOK_NE) {
+        result = g_strdup_printf("%s%s %s", op == TOK_NE ? "not " : "",
+                                 is_prefix ? field->net : field->host, cvalue);
+    } else if (field->cmp == CMP_PORT) {
+        guint64 low = 0, high = field->max;
+
+        switch (op) {
+        case TOK_LT:
+            if (uint_val == 0)
+                break;
+            high = uint_val - 1;
+            break;
+        case TOK_LE:
+            high = uint_val;
+            break;
+        case TOK_GT:
+            if (uint_val == field->max)
+                break;
+            low = uint_val + 1;
+            break;
+        case TOK_GE:
+            low = uint_val;
+            break;
+        default:
+            break;
+        }
+        if ((op == TOK_LT && uint_val == 0) ||
+            (op == TOK_GT && uint_val == field->max)) {
+            parse_error(state, "%s can never match", field->field);
+        } else {
+            result = g_strdup_printf("%s %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+                                     field->net, low, high);
+        }
+    } else {
+        parse_error(state, "%s can only be compared with == or != in a capture filter",
+                    field->field);
+    }
+    g_free(cvalue);
+    return result;
+}
+
+/* A comparison, a protocol, a parenthesized expression, or a "not". */
+static gchar *
+parse_primary(parse_state *state)
+{
+    gchar      *result;
+    gchar      *name;
+    token_type  op;
+    size_t      i;
+
+    switch (state->type) {
+
+    case TOK_NOT:
+        next_token(state);
+        result = parse_primary(state);
+        if (result == NULL)
+            return NULL;
+        name = result;
+        result = g_strdup_printf("not %s", name);
+        g_free(name);
+        return result;
+
+    case TOK_LPAREN:
+        next_token(state);
+        result = parse_or(state);
+        if (result == NULL)
+            return NULL;
+        if (state->type != TOK_RPAREN) {
+            parse_error(state, "missing \")\"");
+            g_free(result);
+            return NULL;
+        }
+        next_token(state);
+        name = result;
+        result = g_strdup_printf("(%s)", name);
+        g_free(name);
+        return result;
+
+    case TOK_WORD:
+        name = state->word;
+        state->word = NULL;
+        next_token(state);
+        switch (state->type) {
+
+        case TOK_EQ:
+        case TOK_NE:
+        case TOK_LT:
+        case TOK_LE:
+        case TOK_GT:
+        case TOK_GE:
+            op = state->type;
+            next_token(state);
+            if (state->type != TOK_WORD) {
+                parse_error(state, "%s must be compared with a value", name);
+                g_free(name);
+                return NULL;
+            }
+            for (i = 0; i < G_N_ELEMENTS(fixed_fields); i++) {
+                if (strcmp(name, fixed_fields[i].field) == 0)
+                    break;
+            }
+            if (i == G_N_ELEMENTS(fixed_fields)) {
+                parse_error(state, "%s isn't supported in a capture filter", name);
+                g_free(name);
+                return NULL;
+            }
+            result = translate_comparison(state, &fixed_fields[i], op, state->word);
+            g_free(name);
+            if (result != NULL)
+                next_token(state);
+            return result;
+
+        default:
+            for (i = 0; i < G_N_ELEMENTS(protocols); i++) {
+                if (strcmp(name, protocols[i].proto) == 0) {
+                    g_free(name);
+                    return g_strdup(protocols[i].primitive);
+                }
+            }
+            parse_error(state, "%s isn't supported in a capture filter", name);
+            g_free(name);
+            return NULL;
+        }
+
+    case TOK_END:
+        parse_error(state, "unexpected end of filter");
+        return NULL;
+
+    default:
+        parse_error(state, "syntax error");
+        return NULL;
+    }
+}
+
+static gchar *
+parse_and(parse_state *state)
+{
+    gchar *left, *right, *result;
+
+    left = parse_primary(state);
+    while (left != NULL && state->type == TOK_AND) {
+        next_token(state);
+        right = parse_primary(state);
+        if (right == NULL) {
+            g_free(left);
+            return NULL;
+        }
+        result = g_strdup_printf("%s and %s", left, right);
+        g_free(left);
+        g_free(right);
+        left = result;
+    }
+    return left;
+}
+
+static gchar *
+parse_or(parse_state *state)
+{
+    gchar *left, *right, *result;
+
+    left = parse_and(state);
+    while (left != NULL && state->type == TOK_OR) {
+        next_token(state);
+        right = parse_and(state);
+        if (right == NULL) {
+            g_free(left);
+            return NULL;
+        }
+        /* "and" binds more tightly than "or" in both syntaxes */
+        result = g_strdup_printf("%s or %s", left, right);
+        g_free(left);
+        g_free(right);
+        left = result;
+    }
+    return left;
+}
+
+gchar *
+cfilter_from_dfilter(const char *dfilter, gchar **err_msg)
+{
+    parse_state state;
+    gchar      *result;
+
+    state.p = dfilter;
+    state.word = NULL;
+    state.err_msg = NULL;
+    next_token(&state);
+    result = parse_or(&state);
+    if (result != NULL && state.type != TOK_END) {
+        parse_error(&state, "syntax error");
+    }
+    if (state.err_msg != NULL) {
+        g_free(result);
+        result = NULL;
+    }
+    g_free(state.word);
+    if (err_msg != NULL)
+        *err_msg = state.err_msg;
+    else
+        g_free(state.err_msg);
+    return result;
+}
@@ -0,0 +1,43 @@
+/** @file
+ *
+ * Translation of a subset of display filter syntax to capture filters
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CFILTER_FROM_DFILTER_H__
+#define __CFILTER_FROM_DFILTER_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Translate a display filter into an equivalent capture filter, so that
+ * the packets it rejects can be dropped in the kernel.
+ *
+ * Only a small subset of display filter syntax is supported: comparisons
+ * of fields at fixed locations in the packet (eth.addr, eth.src, eth.dst,
+ * eth.type, ip.addr, ip.src, ip.dst, ip.proto, ipv6.addr, ipv6.src,
+ * ipv6.dst, tcp.port, tcp.srcport, tcp.dstport, the same for udp, and
+ * frame.len) with literal values, the protocols eth, arp, ip, ipv6, icmp,
+ * icmpv6, tcp, udp and sctp, and "and", "or", "not" and parentheses.
+ *
+ * @param dfilter the display filter
+ * @param err_msg set to an error message, to be freed with g_free(), if
+ * the filter uses anything outside that subset
+ * @return the capture filter, to be freed with g_free(), or NULL on error
+ */
+extern gchar *cfilter_from_dfilter(const char *dfilter, gchar **err_msg);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CFILTER_FROM_DFILTER_H__ */
@@ -40,6 +40,7 @@
 
 #include "capture/capture_ifinfo.h"
 #include "capture/capture-pcap-util.h"
+#include "capture/cfilter-from-dfilter.h"
 
 static gboolean capture_opts_output_to_pipe(const char *save_file, gboolean *is_pipe);
 
@@ -112,6 +113,7 @@ capture_opts_init(capture_options *capture_opts, GList *(*get_iface_list)(int *,
     capture_opts->file_duration                   = 60.0;             /* 1 min */
     capture_opts->has_file_interval               = FALSE;
     capture_opts->has_nametimenum                 = FALSE;
+    capture_opts->has_ring_prealloc               = FALSE;
     capture_opts->file_interval                   = 60;               /* 1 min */
     capture_opts->has_file_packets                = FALSE;
     capture_opts->file_packets                    = 0;
@@ -288,6 +290,7 @@ capture_opts_log(const char *log_domain, enum ws_log_level log_level, capture_op
     ws_log(log_domain, log_level, "FileInterval    (%u) : %u", capture_opts->has_file_interval, capture_opts->file_interval);
     ws_log(log_domain, log_level, "FilePackets     (%u) : %u", capture_opts->has_file_packets, capture_opts->file_packets);
     ws_log(log_domain, log_level, "FileNameType        : %s", (capture_opts->has_nametimenum) ? "prefix_time_num.suffix"  : "prefix_num_time.suffix");
+    ws_log(log_domain, log_level, "RingPrealloc        : %u", capture_opts->has_ring_prealloc);
     ws_log(log_domain, log_level, "RingNumFiles    (%u) : %u", capture_opts->has_ring_num_files, capture_opts->ring_num_files);
     ws_log(log_domain, log_level, "RingPrintFiles  (%u) : %s", capture_opts->print_file_names, (capture_opts->print_file_names ? capture_opts->print_name_to : ""));
 
@@ -378,6 +381,17 @@ static gboolean get_filter_arguments(capture_options* capture_opts, const char*
                 }
                 filterItem = filterItem->next;
             }
+        } else if (strcmp(arg, "dfilter") == 0) {
+            gchar *err_msg;
+
+            filter_exp = cfilter_from_dfilter(val, &err_msg);
+            if (filter_exp == NULL) {
+                cmdarg_err("Display filter \"%s\" can't be used as a capture filter: %s.",
+                           val, err_msg);
+                g_free(err_msg);
+                *colonp = ':';
+                return FALSE;
+            }
         }
     }
 
@@ -455,6 +469,9 @@ get_ring_arguments(capture_options *capture_opts, const char *arg)
     } else if (strcmp(arg,"nametimenum") == 0) {
         int val = get_positive_int(p, "file name: time before num");
         capture_opts->has_nametimenum = (val > 1);
+    } else if (strcmp(arg,"prealloc") == 0) {
+        int val = get_positive_int(p, "ring buffer file preallocation");
+        capture_opts->has_ring_prealloc = (val > 0);
     } else if (strcmp(arg,"packets") == 0) {
         capture_opts->has_file_packets = TRUE;
         capture_opts->file_packets = get_positive_int(p, "ring buffer packet count");
@@ -973,7 +990,9 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
     case 'f':        /* capture filter */
         if (capture_opts->capture_filters_list == NULL)
             capture_opts->capture_filters_list = ws_filter_list_read(CFILTER_LIST);
-        get_filter_arguments(capture_opts, optarg_str_p);
+        if (!get_filter_arguments(capture_opts, optarg_str_p)) {
+            return 1;
+        }
         break;
     case 'g':        /* enable group read access on the capture file(s) */
         capture_opts->group_read_access = TRUE;
@@ -1122,13 +1141,33 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
 #else
             cmdarg_err("'gzip' compression is not supported");
             return 1;
+#endif
+        } else if (strcmp(optarg_str_p, "zstd") == 0) {
+#ifdef HAVE_ZSTD
+            ;
+#else
+            cmdarg_err("'zstd' compression is not supported");
+            return 1;
+#endif
+        } else if (strcmp(optarg_str_p, "lz4") == 0) {
+#if defined(HAVE_LZ4) && defined(HAVE_LZ4FRAME_H)
+            ;
+#else
+            cmdarg_err("'lz4' compression is not supported");
+            return 1;
 #endif
         } else {
+            cmdarg_err("parameter of --compress-type can be 'none'"
 #ifdef HAVE_ZLIB
-            cmdarg_err("parameter of --compress-type can be 'none' or 'gzip'");
-#else
-            cmdarg_err("parameter of --compress-type can only be 'none'");
+                       ", 'gzip'"
+#endif
+#ifdef HAVE_ZSTD
+                       ", 'zstd'"
+#endif
+#if defined(HAVE_LZ4) && defined(HAVE_LZ4FRAME_H)
+                       ", 'lz4'"
 #endif
+                       );
             return 1;
         }
         capture_opts->compress_type = g_strdup(optarg_str_p);
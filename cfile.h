@@ -15,6 +15,8 @@
 #include <epan/epan.h>
 #include <epan/column-info.h>
 #include <epan/dfilter/dfilter.h>
+#include <epan/event_store.h>
+#include <epan/field_cache.h>
 #include <epan/frame_data.h>
 #include <epan/frame_data_sequence.h>
 #include <wiretap/wtap.h>
@@ -125,6 +127,8 @@ typedef struct _capture_file {
 
     gpointer                    window;               /* Top-level window associated with file */
     gulong                      computed_elapsed;     /* Elapsed time to load the file (in msec). */
+    field_cache_t              *field_cache;          /* Values of commonly filtered fields, for refiltering */
+    event_store_t              *event_store;          /* Fields of syscall and log records, for refiltering and sorting */
 
     guint32                     cum_bytes;
 } capture_file;
@@ -64,9 +64,18 @@ function(_lua_get_versions)
 endfunction()
 
 function(_lua_set_version_vars)
-  set(_lua_include_subdirs_raw "lua")
+  if (USE_LUAJIT)
+    # LuaJIT implements the Lua 5.1 API and installs its headers
+    # in a directory of its own.
+    set(_lua_include_subdirs_raw "luajit-2.1" "luajit-2.0")
+  else ()
+    set(_lua_include_subdirs_raw "lua")
+  endif ()
 
   foreach (ver IN LISTS _lua_append_versions)
+    if (USE_LUAJIT)
+      break()
+    endif ()
     string(REGEX MATCH "^([0-9]+)\\.([0-9]+)$" _ver "${ver}")
     list(APPEND _lua_include_subdirs_raw
         lua${CMAKE_MATCH_1}${CMAKE_MATCH_2}
@@ -169,7 +178,14 @@ _lua_find_header()
 _lua_get_header_version()
 unset(_lua_append_versions)
 
-if (LUA_VERSION_STRING)
+if (LUA_VERSION_STRING AND USE_LUAJIT)
+  if (EXISTS "${LUA_INCLUDE_DIR}/luajit.h")
+    set(_lua_library_names luajit-5.1 luajit)
+  else ()
+    message(WARNING "USE_LUAJIT is set but ${LUA_INCLUDE_DIR} has no luajit.h")
+    unset(LUA_VERSION_STRING)
+  endif ()
+elseif (LUA_VERSION_STRING)
   set(_lua_library_names
     lua${LUA_VERSION_MAJOR}${LUA_VERSION_MINOR}
     lua${LUA_VERSION_MAJOR}.${LUA_VERSION_MINOR}
@@ -178,8 +194,13 @@ if (LUA_VERSION_STRING)
     )
 endif ()
 
+if (USE_LUAJIT)
+  set(_lua_fallback_name)
+else ()
+  set(_lua_fallback_name lua)
+endif ()
 find_library(LUA_LIBRARY
-  NAMES ${_lua_library_names} lua
+  NAMES ${_lua_library_names} ${_lua_fallback_name}
   NAMES_PER_DIR
   HINTS
     ${LUA_HINTS}
@@ -187,6 +208,7 @@ find_library(LUA_LIBRARY
   PATH_SUFFIXES lib
 )
 unset(_lua_library_names)
+unset(_lua_fallback_name)
 
 if (LUA_LIBRARY)
   # include the math library for Unix
@@ -220,6 +242,9 @@ cmake_policy(POP)
 
 IF(Lua_FOUND)
   SET( LUA_INCLUDE_DIRS ${LUA_INCLUDE_DIR} )
+  if (USE_LUAJIT)
+    set(HAVE_LUAJIT True)
+  endif()
   if (WIN32)
     set ( LUA_DLL_DIR "${LUA_HINTS}" CACHE PATH "Path to Lua DLL")
     file( GLOB _lua_dll RELATIVE "${LUA_DLL_DIR}" "${LUA_DLL_DIR}/lua*.dll")
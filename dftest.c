@@ -22,6 +22,9 @@
 #include <ws_exit_codes.h>
 
 #include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/frame_data.h>
+#include <epan/tvbuff.h>
 #include <epan/timestamp.h>
 #include <epan/prefs.h>
 #include <epan/dfilter/dfilter.h>
@@ -30,6 +33,7 @@
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
 #endif
+#include <wsutil/buffer.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
@@ -54,6 +58,7 @@ static long opt_optimize = 1;
 static int opt_show_types = 0;
 static int opt_dump_refs = 0;
 static int opt_dump_macros = 0;
+static const char *opt_profile = NULL;
 
 static gint64 elapsed_expand = 0;
 static gint64 elapsed_compile = 0;
@@ -115,6 +120,8 @@ print_usage(int status)
      * development the --refs option to dftest is useless because it will just
      * print empty reference vectors. */
     fprintf(fp, "      --refs          dump some runtime data structures\n");
+    fprintf(fp, "      --profile=FILE  apply the filter to a capture file and print\n");
+    fprintf(fp, "                      the time spent in each instruction\n");
     fprintf(fp, "  -h, --help          display this help and exit\n");
     fprintf(fp, "  -v, --version       print version\n");
     fprintf(fp, "\n");
@@ -231,6 +238,80 @@ compile_filter(const char *text, dfilter_t **dfp)
     return ok;
 }
 
+/*
+ * Dissect every frame of a capture file, applying the filter to each
+ * one, and print where the filter spent its time.
+ */
+static gboolean
+profile_filter(dfilter_t *df, const char *path)
+{
+    static const struct packet_provider_funcs funcs = { NULL, NULL, NULL, NULL };
+    wtap        *wth;
+    epan_t      *session;
+    epan_dissect_t edt;
+    wtap_rec     rec;
+    Buffer       buf;
+    frame_data   fdata;
+    frame_data   ref_frame, prev_dis_frame;
+    const frame_data *ref = NULL, *prev_dis = NULL;
+    nstime_t     elapsed_time = NSTIME_INIT_ZERO;
+    guint32      framenum = 0;
+    guint32      cum_bytes = 0;
+    gint64       data_offset;
+    int          err;
+    gchar       *err_info = NULL;
+
+    wth = wtap_open_offline(path, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL) {
+        cfile_open_failure_message(path, err, err_info);
+        return FALSE;
+    }
+
+    session = epan_new(NULL, &funcs);
+    epan_dissect_init(&edt, session, TRUE, FALSE);
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    dfilter_profile_start(df);
+
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        frame_data_init(&fdata, ++framenum, &rec, data_offset, cum_bytes);
+        frame_data_set_before_dissect(&fdata, &elapsed_time, &ref, prev_dis);
+        if (ref == &fdata) {
+            ref_frame = fdata;
+            ref = &ref_frame;
+        }
+
+        epan_dissect_prime_with_dfilter(&edt, df);
+        epan_dissect_run(&edt, wtap_file_type_subtype(wth), &rec,
+                         tvb_new_real_data(ws_buffer_start_ptr(&buf),
+                                           fdata.cap_len, fdata.pkt_len),
+                         &fdata, NULL);
+        dfilter_apply_edt(df, &edt);
+
+        frame_data_set_after_dissect(&fdata, &cum_bytes);
+        prev_dis_frame = fdata;
+        prev_dis = &prev_dis_frame;
+
+        epan_dissect_reset(&edt);
+        frame_data_destroy(&fdata);
+        wtap_rec_reset(&rec);
+    }
+    if (err != 0)
+        cfile_read_failure_message(path, err, err_info);
+
+    printf("\n");
+    dfilter_profile_dump(stdout, df);
+
+    epan_dissect_cleanup(&edt);
+    epan_free(session);
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+    wtap_close(wth);
+
+    return err == 0;
+}
+
 static int
 optarg_to_digit(const char *arg)
 {
@@ -292,6 +373,7 @@ main(int argc, char **argv)
         { "optimize", ws_required_argument, 0, 1000 },
         { "types",    ws_no_argument,   0, 2000 },
         { "refs",     ws_no_argument,   0, 3000 },
+        { "profile",  ws_required_argument, 0, 4000 },
         { NULL,       0,                0,  0   }
     };
     int opt;
@@ -347,6 +429,9 @@ main(int argc, char **argv)
             case 3000:
                 opt_dump_refs = 1;
                 break;
+            case 4000:
+                opt_profile = ws_optarg;
+                break;
             case 'v':
                 show_version();
                 exit(EXIT_SUCCESS);
@@ -508,6 +593,13 @@ main(int argc, char **argv)
     if (opt_timer)
         print_elapsed();
 
+    if (opt_profile) {
+        if (!profile_filter(df, opt_profile)) {
+            exit_status = WS_EXIT_INVALID_FILE;
+            goto out;
+        }
+    }
+
     exit_status = 0;
 
 out:
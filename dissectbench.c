@@ -0,0 +1,652 @@
+/* dissectbench.c
+ * Measures dissection throughput over fixed packet corpora.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * The corpora are capture files given on the command line, typically from
+ * test/captures, and packets generated by randpkt_core from its protocol
+ * examples with a fixed seed, so that every run dissects the same bytes.
+ * Each corpus is read into memory first and then dissected with each
+ * configuration in turn, so that reading the file isn't measured. Results
+ * are written as JSON.
+ */
+
+#include <config.h>
+#define WS_LOG_DOMAIN  LOG_DOMAIN_MAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <locale.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+#include <ws_exit_codes.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/column.h>
+#include <epan/column-info.h>
+#include <epan/frame_data.h>
+#include <epan/tvbuff.h>
+#include <epan/timestamp.h>
+#include <epan/prefs.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef HAVE_PLUGINS
+#include <wsutil/plugins.h>
+#endif
+#include <wsutil/clopts_common.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/file_util.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/privileges.h>
+#include <wsutil/report_message.h>
+#include <wsutil/tempfile.h>
+#include <wsutil/wmem/wmem.h>
+#include <wsutil/wslog.h>
+#include <wsutil/ws_getopt.h>
+
+#include <wiretap/wtap.h>
+
+#include "ui/failure_message.h"
+#include "wsutil/cmdarg_err.h"
+#include "wsutil/version_info.h"
+
+#include "randpkt_core/randpkt_core.h"
+
+#define DEFAULT_SEED        1
+#define DEFAULT_COUNT       1000
+#define DEFAULT_RUNS        3
+#define DEFAULT_FILTER      "ip or ipv6"
+#define RANDPKT_MAX_BYTES   5000
+
+typedef struct {
+    wtap_rec  rec;
+    guint8   *data;
+} bench_packet_t;
+
+typedef struct {
+    char     *name;
+    int       file_type_subtype;
+    GArray   *packets;      /* of bench_packet_t */
+    guint64   bytes;
+} bench_corpus_t;
+
+typedef enum {
+    BENCH_NO_TREE,
+    BENCH_TREE,
+    BENCH_FILTER,
+    BENCH_COLUMNS
+} bench_config_t;
+
+static const char *bench_config_names[] = {
+    "no-tree",
+    "tree",
+    "filter",
+    "columns"
+};
+
+typedef struct {
+    gint64    usecs;        /* fastest run */
+    guint64   pool_bytes;   /* packet pool bytes over all packets of a run */
+    size_t    pool_peak;    /* largest packet pool use for one packet */
+} bench_result_t;
+
+static guint32 opt_seed = DEFAULT_SEED;
+static int opt_count = DEFAULT_COUNT;
+static int opt_runs = DEFAULT_RUNS;
+static const char *opt_filter = DEFAULT_FILTER;
+static gboolean opt_no_randpkt = FALSE;
+static GSList *opt_randpkt_types = NULL;
+
+static e_prefs *prefs_p;
+static column_info bench_cinfo;
+
+/*
+ * Report an error in command-line arguments.
+ */
+static void
+dissectbench_cmdarg_err(const char *fmt, va_list ap)
+{
+    fprintf(stderr, "dissectbench: ");
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+}
+
+/*
+ * Report additional information for an error in command-line arguments.
+ */
+static void
+dissectbench_cmdarg_err_cont(const char *fmt, va_list ap)
+{
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+}
+
+WS_NORETURN static void
+print_usage(int status)
+{
+    FILE *fp = status == EXIT_SUCCESS ? stdout : stderr;
+    fprintf(fp, "\n");
+    fprintf(fp, "Usage: dissectbench [OPTIONS] [FILE ...]\n");
+    fprintf(fp, "Options:\n");
+    fprintf(fp, "  -s, --seed=N        seed for the generated packets (default %u)\n", DEFAULT_SEED);
+    fprintf(fp, "  -c, --count=N       packets generated per randpkt example (default %d)\n", DEFAULT_COUNT);
+    fprintf(fp, "  -t, --type=TYPE     only generate packets of this randpkt type;\n");
+    fprintf(fp, "                      may be given more than once (default all types)\n");
+    fprintf(fp, "  -N, --no-randpkt    don't generate any packets, only use the files\n");
+    fprintf(fp, "  -n, --runs=N        runs per configuration, the fastest is reported\n");
+    fprintf(fp, "                      (default %d)\n", DEFAULT_RUNS);
+    fprintf(fp, "  -f, --filter=EXPR   display filter of the \"filter\" configuration\n");
+    fprintf(fp, "                      (default \"%s\")\n", DEFAULT_FILTER);
+    fprintf(fp, "  -o, --output=FILE   write the JSON results to FILE instead of\n");
+    fprintf(fp, "                      the standard output\n");
+    fprintf(fp, "  -h, --help          display this help and exit\n");
+    fprintf(fp, "  -v, --version       print version\n");
+    fprintf(fp, "\n");
+    ws_log_print_usage(fp);
+    exit(status);
+}
+
+static bench_corpus_t *
+corpus_new(const char *name, int file_type_subtype)
+{
+    bench_corpus_t *corpus = g_new0(bench_corpus_t, 1);
+
+    corpus->name = g_strdup(name);
+    corpus->file_type_subtype = file_type_subtype;
+    corpus->packets = g_array_new(FALSE, FALSE, sizeof(bench_packet_t));
+    return corpus;
+}
+
+static void
+corpus_free(bench_corpus_t *corpus)
+{
+    for (guint i = 0; i < corpus->packets->len; i++) {
+        g_free(g_array_index(corpus->packets, bench_packet_t, i).data);
+    }
+    g_array_free(corpus->packets, TRUE);
+    g_free(corpus->name);
+    g_free(corpus);
+}
+
+/*
+ * Read the packets of a capture file into a corpus. Only the record
+ * header and the packet bytes are kept; the options in the packet block
+ * (comments, verdicts and so on) are dropped.
+ */
+static bench_corpus_t *
+corpus_read(const char *name, const char *path)
+{
+    bench_corpus_t *corpus;
+    wtap       *wth;
+    wtap_rec    rec;
+    Buffer      buf;
+    gint64      data_offset;
+    int         err;
+    gchar      *err_info = NULL;
+
+    wth = wtap_open_offline(path, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL) {
+        cfile_open_failure_message(path, err, err_info);
+        return NULL;
+    }
+
+    corpus = corpus_new(name, wtap_file_type_subtype(wth));
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        if (rec.rec_type == REC_TYPE_PACKET) {
+            bench_packet_t pkt;
+
+            pkt.rec = rec;
+            pkt.rec.block = NULL;
+            pkt.rec.block_was_modified = FALSE;
+            memset(&pkt.rec.options_buf, 0, sizeof pkt.rec.options_buf);
+            pkt.data = (guint8 *)g_memdup2(ws_buffer_start_ptr(&buf), rec.rec_header.packet_header.caplen);
+            g_array_append_val(corpus->packets, pkt);
+            corpus->bytes += rec.rec_header.packet_header.caplen;
+        }
+        wtap_rec_reset(&rec);
+    }
+    if (err != 0) {
+        cfile_read_failure_message(path, err, err_info);
+        corpus_free(corpus);
+        corpus = NULL;
+    }
+
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+    wtap_close(wth);
+
+    return corpus;
+}
+
+/*
+ * Generate opt_count packets of a randpkt example into a temporary file
+ * and read them back. The generator is seeded for every example, so each
+ * corpus is the same whichever other examples are generated.
+ */
+static bench_corpus_t *
+corpus_generate(const char *abbrev)
+{
+    bench_corpus_t *corpus = NULL;
+    randpkt_example *example;
+    char       *tmpname = NULL;
+    char       *name;
+    GError     *err_tempfile = NULL;
+    int         fd;
+    int         type;
+
+    type = randpkt_parse_type((char *)abbrev);
+    example = randpkt_find_example(type);
+    if (!example)
+        return NULL;
+
+    fd = create_tempfile(NULL, &tmpname, "dissectbench", ".pcapng", &err_tempfile);
+    if (fd == -1) {
+        cmdarg_err("Couldn't create a temporary file: %s", err_tempfile->message);
+        g_error_free(err_tempfile);
+        return NULL;
+    }
+    ws_close(fd);
+
+    randpkt_seed(opt_seed);
+    if (randpkt_example_init(example, tmpname, RANDPKT_MAX_BYTES, wtap_pcapng_file_type_subtype()) == EXIT_SUCCESS) {
+        randpkt_loop(example, opt_count, 0);
+        if (randpkt_example_close(example)) {
+            name = ws_strdup_printf("randpkt:%s", abbrev);
+            corpus = corpus_read(name, tmpname);
+            g_free(name);
+        }
+    } else if (example->dump) {
+        randpkt_example_close(example);
+    }
+
+    ws_unlink(tmpname);
+    g_free(tmpname);
+    return corpus;
+}
+
+/*
+ * Dissect every packet of a corpus once with a configuration, and return
+ * the elapsed time in microseconds.
+ */
+static gint64
+dissect_corpus(const bench_corpus_t *corpus, bench_config_t config,
+               dfilter_t *df, bench_result_t *result)
+{
+    static const struct packet_provider_funcs funcs = { NULL, NULL, NULL, NULL };
+    epan_t      *session;
+    epan_dissect_t edt;
+    frame_data   fdata;
+    frame_data   ref_frame, prev_dis_frame;
+    const frame_data *ref = NULL, *prev_dis = NULL;
+    nstime_t     elapsed_time = NSTIME_INIT_ZERO;
+    guint32      cum_bytes = 0;
+    wmem_allocator_stats_t stats;
+    gboolean     create_tree;
+    gint64       start, elapsed;
+
+    /* Custom columns need the fields they show */
+    create_tree = config == BENCH_TREE ||
+                  (config == BENCH_COLUMNS && have_custom_cols(&bench_cinfo));
+
+    session = epan_new(NULL, &funcs);
+    epan_dissect_init(&edt, session, create_tree, config == BENCH_TREE);
+
+    result->pool_bytes = 0;
+    result->pool_peak = 0;
+
+    start = g_get_monotonic_time();
+    for (guint i = 0; i < corpus->packets->len; i++) {
+        const bench_packet_t *pkt = &g_array_index(corpus->packets, bench_packet_t, i);
+        const wtap_packet_header *phdr = &pkt->rec.rec_header.packet_header;
+        wtap_rec rec = pkt->rec;
+
+        frame_data_init(&fdata, i + 1, &rec, 0, cum_bytes);
+        frame_data_set_before_dissect(&fdata, &elapsed_time, &ref, prev_dis);
+        if (ref == &fdata) {
+            ref_frame = fdata;
+            ref = &ref_frame;
+        }
+
+        if (config == BENCH_FILTER)
+            epan_dissect_prime_with_dfilter(&edt, df);
+        else if (config == BENCH_COLUMNS)
+            col_custom_prime_edt(&edt, &bench_cinfo);
+        epan_dissect_run(&edt, corpus->file_type_subtype, &rec,
+                         tvb_new_real_data(pkt->data, phdr->caplen, phdr->len),
+                         &fdata, config == BENCH_COLUMNS ? &bench_cinfo : NULL);
+        if (config == BENCH_FILTER)
+            dfilter_apply_edt(df, &edt);
+        else if (config == BENCH_COLUMNS)
+            epan_dissect_fill_in_columns(&edt, FALSE, TRUE);
+
+        wmem_get_stats(edt.pi.pool, &stats);
+        result->pool_bytes += stats.in_use;
+        if (stats.in_use > result->pool_peak)
+            result->pool_peak = stats.in_use;
+
+        frame_data_set_after_dissect(&fdata, &cum_bytes);
+        prev_dis_frame = fdata;
+        prev_dis = &prev_dis_frame;
+
+        epan_dissect_reset(&edt);
+        frame_data_destroy(&fdata);
+    }
+    elapsed = g_get_monotonic_time() - start;
+
+    epan_dissect_cleanup(&edt);
+    epan_free(session);
+
+    return elapsed;
+}
+
+static void
+bench_corpus(json_dumper *dumper, const bench_corpus_t *corpus, dfilter_t *df)
+{
+    guint64 num_packets = corpus->packets->len;
+
+    for (int config = BENCH_NO_TREE; config <= BENCH_COLUMNS; config++) {
+        bench_result_t result = { 0 };
+        bench_result_t run;
+        double secs;
+
+        if (config == BENCH_FILTER && df == NULL)
+            continue;
+
+        for (int i = 0; i < opt_runs; i++) {
+            run.usecs = dissect_corpus(corpus, (bench_config_t)config, df, &run);
+            if (i == 0 || run.usecs < result.usecs)
+                result = run;
+        }
+        secs = result.usecs / 1000000.0;
+
+        json_dumper_begin_object(dumper);
+        json_dumper_set_member_name(dumper, "corpus");
+        json_dumper_value_string(dumper, corpus->name);
+        json_dumper_set_member_name(dumper, "config");
+        json_dumper_value_string(dumper, bench_config_names[config]);
+        json_dumper_set_member_name(dumper, "packets");
+        json_dumper_value_anyf(dumper, "%" PRIu64, num_packets);
+        json_dumper_set_member_name(dumper, "bytes");
+        json_dumper_value_anyf(dumper, "%" PRIu64, corpus->bytes);
+        json_dumper_set_member_name(dumper, "seconds");
+        json_dumper_value_double(dumper, secs);
+        json_dumper_set_member_name(dumper, "packets_per_second");
+        json_dumper_value_double(dumper, secs > 0 ? num_packets / secs : 0);
+        json_dumper_set_member_name(dumper, "pool_bytes_per_packet");
+        json_dumper_value_double(dumper, num_packets ? (double)result.pool_bytes / num_packets : 0);
+        json_dumper_set_member_name(dumper, "pool_peak_bytes");
+        json_dumper_value_anyf(dumper, "%zu", result.pool_peak);
+        json_dumper_end_object(dumper);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    char        *configuration_init_error;
+    GPtrArray   *corpora;
+    dfilter_t   *df = NULL;
+    df_error_t  *df_err = NULL;
+    const char  *output_path = NULL;
+    FILE        *output = stdout;
+    json_dumper  dumper = { 0 };
+    gboolean     corpora_ok = TRUE;
+    int          exit_status = EXIT_FAILURE;
+
+    /*
+     * Set the C-language locale to the native environment and set the
+     * code page to UTF-8 on Windows.
+     */
+#ifdef _WIN32
+    setlocale(LC_ALL, ".UTF-8");
+#else
+    setlocale(LC_ALL, "");
+#endif
+
+    cmdarg_err_init(dissectbench_cmdarg_err, dissectbench_cmdarg_err_cont);
+
+    /* Initialize log handler early for startup. */
+    ws_log_init("dissectbench", vcmdarg_err);
+
+    /* Early logging command-line initialization. */
+    ws_log_parse_args(&argc, argv, vcmdarg_err, 1);
+
+    ws_noisy("Finished log init and parsing command line log arguments");
+
+    ws_init_version_info("DissectBench", NULL, NULL);
+
+    const char *optstring = "hvs:c:t:Nn:f:o:";
+    static struct ws_option long_options[] = {
+        { "help",       ws_no_argument,       0, 'h' },
+        { "version",    ws_no_argument,       0, 'v' },
+        { "seed",       ws_required_argument, 0, 's' },
+        { "count",      ws_required_argument, 0, 'c' },
+        { "type",       ws_required_argument, 0, 't' },
+        { "no-randpkt", ws_no_argument,       0, 'N' },
+        { "runs",       ws_required_argument, 0, 'n' },
+        { "filter",     ws_required_argument, 0, 'f' },
+        { "output",     ws_required_argument, 0, 'o' },
+        { NULL,         0,                    0,  0  }
+    };
+    int opt;
+
+    for (;;) {
+        opt = ws_getopt_long(argc, argv, optstring, long_options, NULL);
+        if (opt == -1)
+            break;
+
+        switch (opt) {
+            case 's':
+                opt_seed = get_nonzero_guint32(ws_optarg, "seed");
+                break;
+            case 'c':
+                opt_count = get_positive_int(ws_optarg, "count");
+                break;
+            case 't':
+                opt_randpkt_types = g_slist_append(opt_randpkt_types, ws_optarg);
+                break;
+            case 'N':
+                opt_no_randpkt = TRUE;
+                break;
+            case 'n':
+                opt_runs = get_positive_int(ws_optarg, "runs");
+                break;
+            case 'f':
+                opt_filter = ws_optarg;
+                break;
+            case 'o':
+                output_path = ws_optarg;
+                break;
+            case 'v':
+                show_version();
+                exit(EXIT_SUCCESS);
+                break;
+            case 'h':
+                show_help_header(NULL);
+                print_usage(EXIT_SUCCESS);
+                break;
+            case '?':
+                print_usage(EXIT_FAILURE);
+            default:
+                ws_assert_not_reached();
+        }
+    }
+
+    if (opt_no_randpkt && argv[ws_optind] == NULL) {
+        cmdarg_err("No capture files given and no packets generated.");
+        print_usage(EXIT_FAILURE);
+    }
+
+    /*
+     * Get credential information for later use.
+     */
+    init_process_policies();
+
+    /*
+     * Attempt to get the pathname of the directory containing the
+     * executable file.
+     */
+    configuration_init_error = configuration_init(argv[0], NULL);
+    if (configuration_init_error != NULL) {
+        fprintf(stderr, "Error: Can't get pathname of directory containing "
+                        "the dissectbench program: %s.\n",
+            configuration_init_error);
+        g_free(configuration_init_error);
+    }
+
+    static const struct report_message_routines dissectbench_report_routines = {
+        failure_message,
+        failure_message,
+        open_failure_message,
+        read_failure_message,
+        write_failure_message,
+        cfile_open_failure_message,
+        cfile_dump_open_failure_message,
+        cfile_read_failure_message,
+        cfile_write_failure_message,
+        cfile_close_failure_message
+    };
+
+    init_report_message("dissectbench", &dissectbench_report_routines);
+
+    timestamp_set_type(TS_RELATIVE);
+    timestamp_set_precision(TS_PREC_AUTO);
+    timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
+
+    /*
+     * Libwiretap must be initialized before libwireshark is, so that
+     * dissection-time handlers for file-type-dependent blocks can
+     * register using the file type/subtype value for the file type.
+     */
+    wtap_init(TRUE);
+
+    if (!epan_init(NULL, NULL, TRUE))
+        goto out;
+
+    /* Load libwireshark settings from the current profile. */
+    prefs_p = epan_load_settings();
+
+    /* notify all registered modules that have had any of their preferences
+       changed either from one of the preferences file or from the command
+       line that its preferences have changed. */
+    prefs_apply_all();
+
+    build_column_format_array(&bench_cinfo, prefs_p->num_cols, TRUE);
+
+    if (*opt_filter != '\0' && !dfilter_compile(opt_filter, &df, &df_err)) {
+        cmdarg_err("%s", df_err->msg);
+        df_error_free(&df_err);
+        exit_status = WS_EXIT_INVALID_FILTER;
+        goto out;
+    }
+
+    /* Build all corpora before measuring anything */
+    corpora = g_ptr_array_new_with_free_func((GDestroyNotify)corpus_free);
+    for (int i = ws_optind; i < argc; i++) {
+        char *name = g_path_get_basename(argv[i]);
+        bench_corpus_t *corpus = corpus_read(name, argv[i]);
+
+        g_free(name);
+        if (corpus == NULL) {
+            exit_status = WS_EXIT_INVALID_FILE;
+            goto out_corpora;
+        }
+        g_ptr_array_add(corpora, corpus);
+    }
+    if (!opt_no_randpkt) {
+        char **abbrevs, **longnames;
+        GSList *types = opt_randpkt_types;
+
+        randpkt_example_list(&abbrevs, &longnames);
+        if (types == NULL) {
+            for (int i = 0; abbrevs[i] != NULL; i++)
+                types = g_slist_append(types, abbrevs[i]);
+        }
+        for (GSList *l = types; l != NULL && corpora_ok; l = l->next) {
+            bench_corpus_t *corpus = NULL;
+
+            if (g_strv_contains((const char * const *)abbrevs, (const char *)l->data))
+                corpus = corpus_generate((const char *)l->data);
+            else
+                cmdarg_err("\"%s\" isn't a randpkt type", (const char *)l->data);
+            if (corpus != NULL)
+                g_ptr_array_add(corpora, corpus);
+            else
+                corpora_ok = FALSE;
+        }
+        if (types != opt_randpkt_types)
+            g_slist_free(types);
+        g_strfreev(abbrevs);
+        g_strfreev(longnames);
+        if (!corpora_ok)
+            goto out_corpora;
+    }
+
+    if (output_path != NULL) {
+        output = ws_fopen(output_path, "w");
+        if (output == NULL) {
+            open_failure_message(output_path, errno, TRUE);
+            goto out_corpora;
+        }
+    }
+
+    dumper.output_file = output;
+    dumper.flags = JSON_DUMPER_FLAGS_PRETTY_PRINT;
+    json_dumper_begin_object(&dumper);
+    json_dumper_set_member_name(&dumper, "version");
+    json_dumper_value_string(&dumper, get_ws_vcs_version_info());
+    json_dumper_set_member_name(&dumper, "seed");
+    json_dumper_value_anyf(&dumper, "%u", opt_seed);
+    json_dumper_set_member_name(&dumper, "runs");
+    json_dumper_value_anyf(&dumper, "%d", opt_runs);
+    json_dumper_set_member_name(&dumper, "filter");
+    json_dumper_value_string(&dumper, opt_filter);
+    json_dumper_set_member_name(&dumper, "results");
+    json_dumper_begin_array(&dumper);
+    for (guint i = 0; i < corpora->len; i++) {
+        bench_corpus(&dumper, (const bench_corpus_t *)g_ptr_array_index(corpora, i), df);
+    }
+    json_dumper_end_array(&dumper);
+    json_dumper_end_object(&dumper);
+    if (json_dumper_finish(&dumper))
+        exit_status = EXIT_SUCCESS;
+
+    if (output != stdout)
+        fclose(output);
+
+out_corpora:
+    g_ptr_array_free(corpora, TRUE);
+out:
+    col_cleanup(&bench_cinfo);
+    dfilter_free(df);
+    g_slist_free(opt_randpkt_types);
+    epan_cleanup();
+    wtap_cleanup();
+    exit(exit_status);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
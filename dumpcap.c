@@ -118,11 +118,16 @@ FILE *debug_log;   /* for logging debug messages to  */
 #include <stdarg.h> /* va_copy */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
-static gint64 pcap_queue_packets;
-static gint64 pcap_queue_byte_limit = 0;
-static gint64 pcap_queue_packet_limit = 0;
+/*
+ * When using threads, each capture source has its own queue of packets,
+ * filled by the source's capture thread and emptied by the writer; the
+ * writer waits on pcap_queue_cond when all of the queues are empty.
+ */
+static GMutex pcap_queue_mutex;
+static GCond pcap_queue_cond;
+static gint pcap_queue_writer_waiting;  /* TRUE if the writer is waiting on pcap_queue_cond */
+static gint64 pcap_queue_byte_limit = 0;   /* per capture source */
+static gint64 pcap_queue_packet_limit = 0; /* per capture source */
 
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 static const char *report_capture_filename = NULL; /* capture child file name */
@@ -227,6 +232,11 @@ static void cap_pipe_close(int pipe_fd, gboolean from_socket);
  * XXX - with TPACKET_V1 and TPACKET_V2, it currently uses select()
  * internally, and, with TPACKET_V3, once that's supported, it'll
  * support timeouts, at least as I understand the way the code works.
+ *
+ * libpcap uses TPACKET_V3 where the kernel supports it; the descriptor
+ * becomes readable when the kernel retires a block of packets in the
+ * memory-mapped ring, so, once select() says it's readable, we process
+ * all of the packets in that block with one pcap_dispatch() call.
  */
 #define MUST_DO_SELECT
 #endif
@@ -268,6 +278,14 @@ struct _loop_data; /* forward declaration so we can use it in the cap_pipe_dispa
 /*
  * A source of packets from which we're capturing.
  */
+/*
+ * Number of buckets in the write latency histograms; bucket 0 counts
+ * writes that took less than a microsecond, bucket N, for N > 0, writes
+ * that took from 2^(N-1) up to 2^N microseconds, and the last bucket
+ * everything slower than that.
+ */
+#define STATS_LATENCY_BUCKETS 16
+
 typedef struct _capture_src {
     guint32                      received;
     guint32                      dropped;
@@ -280,6 +298,12 @@ typedef struct _capture_src {
     guint                        interface_id;
     guint                        idb_id;                 /**< If from_pcapng is false, the output IDB interface ID. Otherwise the mapping in src_iface_to_global is used. */
     GThread                     *tid;
+    struct _pcap_queue          *queue;                  /**< Packets queued by this source's thread for the writer */
+    guint64                      bytes_received;         /**< Bytes of packet data received; updated with STATS_ADD */
+    guint64                      packets_written;        /**< Packets written to the output file; updated with STATS_ADD */
+    guint64                      bytes_written;          /**< Bytes of packet data written to the output file; updated with STATS_ADD */
+    guint64                      write_latency[STATS_LATENCY_BUCKETS]; /**< Histogram of per-packet write times */
+    guint64                      write_latency_sum;      /**< Total of the per-packet write times, in microseconds */
     int                          snaplen;
     int                          linktype;
     gboolean                     ts_nsec;                /**< TRUE if we're using nanosecond precision. */
@@ -298,6 +322,9 @@ typedef struct _capture_src {
     gboolean                     cap_pipe_modified;      /**< TRUE if data in the pipe uses modified pcap headers */
     char *                       cap_pipe_databuf;       /**< Pointer to the data buffer we've allocated */
     size_t                       cap_pipe_databuf_size;  /**< Current size of the data buffer */
+    char *                       cap_pipe_readahead;     /**< Data read from the pipe or socket but not yet handed out */
+    size_t                       cap_pipe_readahead_off; /**< Offset of the first byte not yet handed out */
+    size_t                       cap_pipe_readahead_len; /**< Number of bytes in the read ahead buffer */
     guint                        cap_pipe_max_pkt_size;  /**< Maximum packet size allowed */
 #if defined(_WIN32)
     char *                       cap_pipe_buf;           /**< Pointer to the buffer we read into */
@@ -338,6 +365,7 @@ typedef struct _loop_data {
 #endif
     GArray   *pcaps;               /**< Array of capture_src's on which we're capturing */
     gboolean  pcapng_passthrough;  /**< We have one source and it's pcapng. Pass its SHB and IDBs through. */
+    guint64   ring_rotations;      /**< Number of times we've switched to a new ring buffer file */
     guint8   *saved_shb;           /**< SHB to write when we have one pcapng input */
     GArray   *saved_idbs;          /**< Array of saved_idb_t, written when we have a new section or output file. */
     GRWLock   saved_shb_idb_lock;  /**< Saved IDB RW mutex */
@@ -364,6 +392,25 @@ typedef struct _pcap_queue_element {
     u_char             *pd;
 } pcap_queue_element;
 
+/*
+ * Single-producer, single-consumer queue of packets from one capture
+ * source.  Only the source's capture thread writes tail, and only the
+ * writer writes head, so neither needs a lock.
+ */
+typedef struct _pcap_queue {
+    pcap_queue_element **elements;
+    guint               mask;       /**< number of slots - 1; the number of slots is a power of 2 */
+    gint                head;       /**< index of the next element to dequeue */
+    gint                tail;       /**< index of the next slot to fill */
+    gssize              bytes;      /**< number of bytes of packet data queued */
+    guint               max_count;  /**< largest number of elements that have been queued at once */
+    gssize              max_bytes;  /**< largest number of bytes that have been queued at once */
+} pcap_queue;
+
+/* Number of slots in a queue if there's no packet limit, and the maximum */
+#define PCAP_QUEUE_DEFAULT_SLOTS (1 << 16)
+#define PCAP_QUEUE_MAX_SLOTS     (1 << 20)
+
 /*
  * This needs to be static, so that the SIGINT handler can clear the "go"
  * flag and for saved_shb_idb_lock.
@@ -403,8 +450,45 @@ static gboolean need_timeout_workaround;
 #define PIPE_READ_TIMEOUT   250000
 #endif
 
+/*
+ * Size of the buffer into which we read ahead from a capture pipe or
+ * socket.  A capture pipe carries a stream of small headers and packets,
+ * so reading exactly what each of them needs costs a read() call per
+ * header and one per packet; reading up to this much at once, and handing
+ * out the pieces from the buffer, reduces that to one call per buffer
+ * full when the writer is ahead of us.
+ */
+#define CAP_PIPE_READ_AHEAD_SIZE (256 * 1024)
+
 #define WRITER_THREAD_TIMEOUT 100000 /* usecs */
 
+/*
+ * Maximum number of packets to write before telling the parent about
+ * them, even if the update interval hasn't elapsed.
+ */
+#define UPDATE_MAX_PACKETS 4096
+
+/*
+ * The counters reported in the --stats-file file are updated by the
+ * capture and writer threads and read by the writer thread.  Each counter
+ * has only one thread updating it, so they don't need read-modify-write
+ * atomicity or any ordering guarantees, just loads and stores that don't
+ * tear; use relaxed atomics where we have them.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define STATS_ADD(p, v)  __atomic_store_n((p), __atomic_load_n((p), __ATOMIC_RELAXED) + (v), __ATOMIC_RELAXED)
+#define STATS_LOAD(p)    __atomic_load_n((p), __ATOMIC_RELAXED)
+#define STATS_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#else
+/* Aligned 64-bit loads and stores don't tear on the 64-bit targets we build for with MSVC. */
+#define STATS_ADD(p, v)  (*(p) += (v))
+#define STATS_LOAD(p)    (*(p))
+#define STATS_STORE(p, v) (*(p) = (v))
+#endif
+
+/* How often, in microseconds, to rewrite the --stats-file file */
+#define STATS_FILE_INTERVAL 1000000
+
 static void
 dumpcap_log_writer(const char *domain, enum ws_log_level level,
                                    const char *file, long line, const char *func,
@@ -417,6 +501,7 @@ static capture_options global_capture_opts;
 static GPtrArray *capture_comments = NULL;
 static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
+static char *stats_file = NULL;
 static guint64 start_time;
 
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -516,8 +601,12 @@ print_usage(FILE *output)
     fprintf(output, "                            packets:NUM - ringbuffer: replace after NUM packets\n");
     fprintf(output, "                           interval:NUM - switch to next file when the time is\n");
     fprintf(output, "                                          an exact multiple of NUM secs\n");
+    fprintf(output, "                             prealloc:1 - ringbuffer: preallocate files of the\n");
+    fprintf(output, "                                          filesize and reuse them in place\n");
     fprintf(output, "                          printname:FILE - print filename to FILE when written\n");
     fprintf(output, "                                           (can use 'stdout' or 'stderr')\n");
+    fprintf(output, "  --compress-type <type>   compress ringbuffer files (none, gzip, zstd or lz4);\n");
+    fprintf(output, "                           zstd and lz4 files are compressed as they're written\n");
     fprintf(output, "  -n                       use pcapng format instead of pcap (default)\n");
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
     fprintf(output, "  --capture-comment <comment>\n");
@@ -532,10 +621,13 @@ print_usage(FILE *output)
 
     fprintf(output, "Miscellaneous:\n");
     fprintf(output, "  -N <packet_limit>        maximum number of packets buffered within dumpcap\n");
+    fprintf(output, "                           per interface\n");
     fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
-    fprintf(output, "                           within dumpcap\n");
+    fprintf(output, "                           within dumpcap per interface\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
     fprintf(output, "  -q                       don't report packet capture counts\n");
+    fprintf(output, "  --stats-file <file>      write per-interface counters to this file, in the\n");
+    fprintf(output, "                           Prometheus text format, once per second\n");
     fprintf(output, "  -v, --version            print version information and exit\n");
     fprintf(output, "  -h, --help               display this help and exit\n");
     fprintf(output, "\n");
@@ -1443,6 +1535,48 @@ cap_pipe_read(int pipe_fd, char *buf, size_t sz, gboolean from_socket _U_)
 #endif
 }
 
+/* Number of bytes read from the pipe or socket of a capture source that
+ * haven't been handed out yet; while there are any, there is no need to
+ * wait for the pipe or socket to become readable. */
+static inline size_t
+cap_pipe_buffered(const capture_src *pcap_src)
+{
+    return pcap_src->cap_pipe_readahead_len - pcap_src->cap_pipe_readahead_off;
+}
+
+/* Read up to sz bytes from the pipe or socket of a capture source, going
+ * through its read ahead buffer.  Returns what cap_pipe_read() would; as
+ * with cap_pipe_read(), that may be fewer bytes than were asked for.
+ */
+static ssize_t
+cap_pipe_read_buffered(capture_src *pcap_src, int pipe_fd, char *buf, size_t sz)
+{
+    ssize_t b;
+
+    if (cap_pipe_buffered(pcap_src) == 0) {
+        if (sz >= CAP_PIPE_READ_AHEAD_SIZE) {
+            /* Large enough to read straight into the caller's buffer. */
+            return cap_pipe_read(pipe_fd, buf, sz, pcap_src->from_cap_socket);
+        }
+        if (pcap_src->cap_pipe_readahead == NULL) {
+            pcap_src->cap_pipe_readahead = (char *)g_malloc(CAP_PIPE_READ_AHEAD_SIZE);
+        }
+        b = cap_pipe_read(pipe_fd, pcap_src->cap_pipe_readahead,
+                          CAP_PIPE_READ_AHEAD_SIZE, pcap_src->from_cap_socket);
+        if (b <= 0) {
+            return b;
+        }
+        pcap_src->cap_pipe_readahead_off = 0;
+        pcap_src->cap_pipe_readahead_len = (size_t)b;
+    }
+    if (sz > cap_pipe_buffered(pcap_src)) {
+        sz = cap_pipe_buffered(pcap_src);
+    }
+    memcpy(buf, pcap_src->cap_pipe_readahead + pcap_src->cap_pipe_readahead_off, sz);
+    pcap_src->cap_pipe_readahead_off += sz;
+    return (ssize_t)sz;
+}
+
 #if defined(_WIN32)
 /*
  * Thread function that reads from a pipe and pushes the data
@@ -1688,15 +1822,16 @@ cap_pipe_read_data_bytes(capture_src *pcap_src, char *errmsg, size_t errmsgl)
             return -1;
         }
 
-        sel_ret = cap_pipe_select(fd);
+        sel_ret = cap_pipe_buffered(pcap_src) > 0 ? 1 : cap_pipe_select(fd);
         if (sel_ret < 0) {
             snprintf(errmsg, errmsgl,
                        "Unexpected error from select: %s.", g_strerror(errno));
             pcap_src->cap_pipe_err = PIPERR;
             return -1;
         } else if (sel_ret > 0) {
-            b = cap_pipe_read(fd, pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
-                              sz-bytes_read, pcap_src->from_cap_socket);
+            b = cap_pipe_read_buffered(pcap_src, fd,
+                              pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
+                              sz-bytes_read);
             if (b <= 0) {
                 if (b == 0) {
                     snprintf(errmsg, errmsgl,
@@ -1970,16 +2105,16 @@ cap_pipe_open_live(char *pipename,
     {
         bytes_read = 0;
         while (bytes_read < sizeof magic) {
-            sel_ret = cap_pipe_select(fd);
+            sel_ret = cap_pipe_buffered(pcap_src) > 0 ? 1 : cap_pipe_select(fd);
             if (sel_ret < 0) {
                 snprintf(errmsg, errmsgl,
                            "Unexpected error from select: %s.",
                            g_strerror(errno));
                 goto error;
             } else if (sel_ret > 0) {
-                b = cap_pipe_read(fd, ((char *)&magic)+bytes_read,
-                                  sizeof magic-bytes_read,
-                                  pcap_src->from_cap_socket);
+                b = cap_pipe_read_buffered(pcap_src, fd,
+                                  ((char *)&magic)+bytes_read,
+                                  sizeof magic-bytes_read);
                 /* jump messaging, if extcap had an error, stderr will provide the correct message */
                 if (extcap_pipe && b <= 0)
                     goto error;
@@ -2121,16 +2256,16 @@ pcap_pipe_open_live(int fd,
         /* Keep reading until we get the rest of the header. */
         bytes_read = 0;
         while (bytes_read < sizeof(struct pcap_hdr)) {
-            sel_ret = cap_pipe_select(fd);
+            sel_ret = cap_pipe_buffered(pcap_src) > 0 ? 1 : cap_pipe_select(fd);
             if (sel_ret < 0) {
                 snprintf(errmsg, errmsgl,
                            "Unexpected error from select: %s.",
                            g_strerror(errno));
                 goto error;
             } else if (sel_ret > 0) {
-                b = cap_pipe_read(fd, ((char *)hdr)+bytes_read,
-                                  sizeof(struct pcap_hdr) - bytes_read,
-                                  pcap_src->from_cap_socket);
+                b = cap_pipe_read_buffered(pcap_src, fd,
+                                  ((char *)hdr)+bytes_read,
+                                  sizeof(struct pcap_hdr) - bytes_read);
                 if (b <= 0) {
                     if (b == 0)
                         snprintf(errmsg, errmsgl,
@@ -2546,8 +2681,9 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd, ((char *)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
-                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read, pcap_src->from_cap_socket);
+            b = cap_pipe_read_buffered(pcap_src, pcap_src->cap_pipe_fd,
+                 ((char *)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
+                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -2605,10 +2741,9 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd,
+            b = cap_pipe_read_buffered(pcap_src, pcap_src->cap_pipe_fd,
                               pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read,
-                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read,
-                              pcap_src->from_cap_socket);
+                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -3251,6 +3386,10 @@ static void capture_loop_close_input(loop_data *ld)
                 g_free(pcap_src->cap_pipe_databuf);
                 pcap_src->cap_pipe_databuf = NULL;
             }
+            g_free(pcap_src->cap_pipe_readahead);
+            pcap_src->cap_pipe_readahead = NULL;
+            pcap_src->cap_pipe_readahead_off = 0;
+            pcap_src->cap_pipe_readahead_len = 0;
             if (pcap_src->from_pcapng) {
                 g_array_free(pcap_src->cap_pipe_info.pcapng.src_iface_to_global, TRUE);
                 pcap_src->cap_pipe_info.pcapng.src_iface_to_global = NULL;
@@ -3579,7 +3718,7 @@ capture_loop_dispatch(loop_data *ld,
 #ifdef _WIN32
         if (pcap_src->from_cap_socket) {
 #endif
-            sel_ret = cap_pipe_select(pcap_src->cap_pipe_fd);
+            sel_ret = cap_pipe_buffered(pcap_src) > 0 ? 1 : cap_pipe_select(pcap_src->cap_pipe_fd);
             if (sel_ret <= 0) {
                 if (sel_ret < 0 && errno != EINTR) {
                     snprintf(errmsg, errmsg_len,
@@ -3600,8 +3739,23 @@ capture_loop_dispatch(loop_data *ld,
         if (sel_ret > 0) {
             /*
              * "select()" says we can read from the pipe without blocking
+             * (or we have data read ahead from it).
+             *
+             * Keep going for as long as there's data in the read ahead
+             * buffer, so that everything one read() got from the pipe is
+             * handed to the writer in one go rather than with a trip
+             * around the capture loop per record, as we do for the
+             * packets pcap_dispatch() finds in libpcap's buffer.
              */
             inpkts = pcap_src->cap_pipe_dispatch(ld, pcap_src, errmsg, errmsg_len);
+            while (inpkts >= 0 && ld->go && cap_pipe_buffered(pcap_src) > 0) {
+                int more = pcap_src->cap_pipe_dispatch(ld, pcap_src, errmsg, errmsg_len);
+                if (more < 0) {
+                    inpkts = more;
+                    break;
+                }
+                inpkts += more;
+            }
             if (inpkts < 0) {
                 ws_debug("%s: src %u pipe reached EOF or err, rcv: %u drop: %u flush: %u",
                       G_STRFUNC, pcap_src->interface_id, pcap_src->received, pcap_src->dropped, pcap_src->flushed);
@@ -3636,15 +3790,18 @@ capture_loop_dispatch(loop_data *ld,
                  * "select()" says we can read from it without blocking; go for
                  * it.
                  *
-                 * We don't have pcap_breakloop(), so we only process one packet
-                 * per pcap_dispatch() call, to allow a signal to stop the
-                 * processing immediately, rather than processing all packets
-                 * in a batch before quitting.
+                 * Process all of the packets libpcap has in its buffer (with
+                 * TPACKET_V3, a whole block of the ring), rather than making
+                 * a select() call per packet.  The callbacks are handed the
+                 * packet data in the ring itself, so, if we're not using
+                 * threads, it's written to the file without being copied
+                 * first.  capture_loop_stop() calls pcap_breakloop(), so a
+                 * signal still stops the processing after the current packet.
                  */
                 if (use_threads) {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
+                    inpkts = pcap_dispatch(pcap_src->pcap_h, -1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
                 } else {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_write_packet_cb, (u_char *)pcap_src);
+                    inpkts = pcap_dispatch(pcap_src->pcap_h, -1, capture_loop_write_packet_cb, (u_char *)pcap_src);
                 }
                 if (inpkts < 0) {
                     if (inpkts == -1) {
@@ -3819,7 +3976,9 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                                              (capture_opts->has_ring_num_files) ? capture_opts->ring_num_files : 0,
                                              capture_opts->group_read_access,
                                              capture_opts->compress_type,
-                                             capture_opts->has_nametimenum);
+                                             capture_opts->has_nametimenum,
+                                             (capture_opts->has_ring_prealloc && capture_opts->has_autostop_filesize) ?
+                                                 (gint64)capture_opts->autostop_filesize * 1000 : 0);
 
                 /* capfile_name is unused as the ringbuffer provides its own filename. */
                 if (*save_file_fd != -1) {
@@ -3983,6 +4142,7 @@ do_file_switch_or_stop(capture_options *capture_opts)
                                 &global_ld.save_file_fd, &global_ld.err)) {
 
             /* File switch succeeded: reset the conditions */
+            global_ld.ring_rotations++;
             global_ld.bytes_written = 0;
             global_ld.packets_written = 0;
             if (capture_opts->use_pcapng) {
@@ -4028,6 +4188,142 @@ do_file_switch_or_stop(capture_options *capture_opts)
     return TRUE;
 }
 
+static pcap_queue *
+pcap_queue_new(void)
+{
+    pcap_queue *queue = g_new0(pcap_queue, 1);
+    gint64      slots;
+    guint       size = 1;
+
+    slots = pcap_queue_packet_limit > 0 ? pcap_queue_packet_limit : PCAP_QUEUE_DEFAULT_SLOTS;
+    if (slots > PCAP_QUEUE_MAX_SLOTS)
+        slots = PCAP_QUEUE_MAX_SLOTS;
+    while (size < slots)
+        size <<= 1;
+    queue->elements = g_new(pcap_queue_element *, size);
+    queue->mask = size - 1;
+    return queue;
+}
+
+static void
+pcap_queue_free(pcap_queue *queue)
+{
+    guint head, tail;
+
+    if (queue == NULL)
+        return;
+    head = (guint)queue->head;
+    tail = (guint)queue->tail;
+    for (; head != tail; head++) {
+        g_free(queue->elements[head & queue->mask]->pd);
+        g_free(queue->elements[head & queue->mask]);
+    }
+    g_free(queue->elements);
+    g_free(queue);
+}
+
+static guint32
+pcap_queue_element_len(const pcap_queue_element *queue_element)
+{
+    if (queue_element->pcap_src->from_pcapng)
+        return queue_element->u.bh.block_total_length;
+    return queue_element->u.phdr.caplen;
+}
+
+/*
+ * Called by the capture thread; returns FALSE, without queueing the
+ * element, if this source's queue is at one of the limits.
+ */
+static gboolean
+pcap_queue_push(pcap_queue *queue, pcap_queue_element *queue_element)
+{
+    guint head = (guint)g_atomic_int_get(&queue->head);
+    guint tail = (guint)g_atomic_int_get(&queue->tail);
+    guint count = tail - head;
+    gssize bytes;
+
+    if (count > queue->mask ||
+        ((pcap_queue_packet_limit != 0) && (count >= pcap_queue_packet_limit)) ||
+        ((pcap_queue_byte_limit != 0) && ((gssize)g_atomic_pointer_get(&queue->bytes) >= pcap_queue_byte_limit)))
+        return FALSE;
+
+    queue->elements[tail & queue->mask] = queue_element;
+    bytes = (gssize)g_atomic_pointer_add(&queue->bytes, pcap_queue_element_len(queue_element)) + pcap_queue_element_len(queue_element);
+    g_atomic_int_set(&queue->tail, (gint)(tail + 1));
+
+    /* Only this thread updates the high-water marks. */
+    if (count + 1 > queue->max_count)
+        STATS_STORE(&queue->max_count, count + 1);
+    if (bytes > queue->max_bytes)
+        STATS_STORE(&queue->max_bytes, bytes);
+
+    /* Wake up the writer if it's waiting for something to write. */
+    if (g_atomic_int_get(&pcap_queue_writer_waiting)) {
+        g_mutex_lock(&pcap_queue_mutex);
+        g_cond_signal(&pcap_queue_cond);
+        g_mutex_unlock(&pcap_queue_mutex);
+    }
+    return TRUE;
+}
+
+/*
+ * Does a come before b?  Blocks from pcapng sources don't have a time
+ * stamp we can compare, so we treat them as coming before anything
+ * queued from other sources.
+ */
+static gboolean
+pcap_queue_element_before(const pcap_queue_element *a, const pcap_queue_element *b)
+{
+    gint64 a_subsecs, b_subsecs;
+
+    if (b->pcap_src->from_pcapng)
+        return FALSE;
+    if (a->pcap_src->from_pcapng)
+        return TRUE;
+    if (a->u.phdr.ts.tv_sec != b->u.phdr.ts.tv_sec)
+        return a->u.phdr.ts.tv_sec < b->u.phdr.ts.tv_sec;
+    /* tv_usec is in nanoseconds for sources with nanosecond precision */
+    a_subsecs = a->u.phdr.ts.tv_usec * (a->pcap_src->ts_nsec ? 1 : 1000);
+    b_subsecs = b->u.phdr.ts.tv_usec * (b->pcap_src->ts_nsec ? 1 : 1000);
+    return a_subsecs < b_subsecs;
+}
+
+/*
+ * Called by the writer; find the queue whose first element is the
+ * earliest of all of the queues' first elements, so that packets from
+ * different interfaces are written in time stamp order as far as we
+ * can tell.  Returns NULL if all of the queues are empty.
+ */
+static pcap_queue *
+pcap_queue_earliest(pcap_queue_element **queue_elementp)
+{
+    pcap_queue         *earliest = NULL;
+    pcap_queue_element *earliest_element = NULL;
+    pcap_queue_element *queue_element;
+    capture_src        *pcap_src;
+    pcap_queue         *queue;
+    guint               head;
+    guint               i;
+
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        queue = pcap_src->queue;
+        if (queue == NULL)
+            continue;
+        head = (guint)queue->head;
+        if (head == (guint)g_atomic_int_get(&queue->tail))
+            continue;
+        queue_element = queue->elements[head & queue->mask];
+        if (earliest_element == NULL ||
+            pcap_queue_element_before(queue_element, earliest_element)) {
+            earliest = queue;
+            earliest_element = queue_element;
+        }
+    }
+    *queue_elementp = earliest_element;
+    return earliest;
+}
+
 static void *
 pcap_read_handler(void* arg)
 {
@@ -4051,18 +4347,26 @@ pcap_read_handler(void* arg)
 static gboolean
 capture_loop_dequeue_packet(void) {
     pcap_queue_element *queue_element;
+    pcap_queue         *queue;
 
-    g_async_queue_lock(pcap_queue);
-    queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
+    queue = pcap_queue_earliest(&queue_element);
+    if (queue == NULL) {
+        /* Nothing queued; wait until something is, or we time out. */
+        gint64 end_time = g_get_monotonic_time() + WRITER_THREAD_TIMEOUT;
+
+        g_mutex_lock(&pcap_queue_mutex);
+        g_atomic_int_set(&pcap_queue_writer_waiting, TRUE);
+        while ((queue = pcap_queue_earliest(&queue_element)) == NULL) {
+            if (!g_cond_wait_until(&pcap_queue_cond, &pcap_queue_mutex, end_time))
+                break;
         }
-        pcap_queue_packets -= 1;
+        g_atomic_int_set(&pcap_queue_writer_waiting, FALSE);
+        g_mutex_unlock(&pcap_queue_mutex);
+    }
+    if (queue != NULL) {
+        g_atomic_pointer_add(&queue->bytes, -(gssize)pcap_queue_element_len(queue_element));
+        g_atomic_int_set(&queue->head, queue->head + 1);
     }
-    g_async_queue_unlock(pcap_queue);
     if (queue_element) {
         if (queue_element->pcap_src->from_pcapng) {
             ws_info("Dequeued a block of type 0x%08x of length %d captured on interface %d.",
@@ -4118,6 +4422,225 @@ handle_npcap_bug(char *adapter_name _U_, char *cap_err_str _U_)
                           "be reported as a Wireshark or Npcap bug.");
 }
 
+/*
+ * Called by the writer to add a write that took "usecs" microseconds to
+ * the source's write latency histogram.
+ */
+static void
+capture_loop_record_write_latency(capture_src *pcap_src, gint64 usecs)
+{
+    guint bucket = 0;
+
+    if (usecs < 0)
+        usecs = 0;
+    if (usecs > 0)
+        bucket = g_bit_storage((gulong)usecs);
+    if (bucket >= STATS_LATENCY_BUCKETS)
+        bucket = STATS_LATENCY_BUCKETS - 1;
+    STATS_ADD(&pcap_src->write_latency[bucket], 1);
+    STATS_ADD(&pcap_src->write_latency_sum, (guint64)usecs);
+}
+
+/* Write a Prometheus label value, escaped as the text format requires */
+static void
+capture_loop_write_stats_label(FILE *fh, const char *value)
+{
+    for (; *value != '\0'; value++) {
+        switch (*value) {
+
+        case '\\':
+            fputs("\\\\", fh);
+            break;
+
+        case '"':
+            fputs("\\\"", fh);
+            break;
+
+        case '\n':
+            fputs("\\n", fh);
+            break;
+
+        default:
+            putc(*value, fh);
+            break;
+        }
+    }
+}
+
+static void
+capture_loop_write_stats_metric(FILE *fh, const char *name, const char *type, const char *help)
+{
+    fprintf(fh, "# HELP %s %s\n", name, help);
+    fprintf(fh, "# TYPE %s %s\n", name, type);
+}
+
+static void
+capture_loop_write_stats_value(FILE *fh, const char *name, const char *iface, guint64 value)
+{
+    fprintf(fh, "%s{interface=\"", name);
+    capture_loop_write_stats_label(fh, iface);
+    fprintf(fh, "\"} %" PRIu64 "\n", value);
+}
+
+/* A snapshot of one source's counters, for capture_loop_write_stats() */
+typedef struct _capture_src_stats {
+    const char *iface;
+    guint64     received;
+    guint64     bytes_received;
+    guint64     dropped;
+    gboolean    kernel_dropped_known;
+    guint64     kernel_dropped;
+    guint64     packets_written;
+    guint64     bytes_written;
+    guint64     queue_packets;
+    guint64     queue_bytes;
+    guint64     queue_max_packets;
+    guint64     queue_max_bytes;
+    guint64     write_latency[STATS_LATENCY_BUCKETS];
+    guint64     write_latency_sum;
+} capture_src_stats;
+
+/*
+ * Write our counters to the --stats-file file, in the Prometheus text
+ * exposition format, so that they can be collected by, for example, the
+ * node_exporter textfile collector.  We write a temporary file and rename
+ * it over the old one, so that readers never see a partial file.
+ *
+ * This is called by the writer, so it can read the writer's counters
+ * directly; the capture threads' counters are read with STATS_LOAD.
+ */
+static void
+capture_loop_write_stats(capture_options *capture_opts)
+{
+    capture_src_stats *snap;
+    capture_src       *pcap_src;
+    struct pcap_stat   ps;
+    char              *tmp_name;
+    FILE              *fh;
+    guint64            cumulative;
+    guint              i, bucket, num_srcs = global_ld.pcaps->len;
+
+    snap = g_new0(capture_src_stats, num_srcs);
+    for (i = 0; i < num_srcs; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        snap[i].iface = g_array_index(capture_opts->ifaces, interface_options, i).display_name;
+        snap[i].received = STATS_LOAD(&pcap_src->received);
+        snap[i].bytes_received = STATS_LOAD(&pcap_src->bytes_received);
+        snap[i].dropped = STATS_LOAD(&pcap_src->dropped);
+        /*
+         * With a separate thread per interface, the threads are using the
+         * pcap_t's, so we can't safely ask for their statistics.
+         */
+        if (!use_threads && pcap_src->pcap_h != NULL && pcap_stats(pcap_src->pcap_h, &ps) >= 0) {
+            snap[i].kernel_dropped_known = TRUE;
+            snap[i].kernel_dropped = ps.ps_drop;
+        }
+        snap[i].packets_written = pcap_src->packets_written;
+        snap[i].bytes_written = pcap_src->bytes_written;
+        if (pcap_src->queue != NULL) {
+            snap[i].queue_packets = (guint)g_atomic_int_get(&pcap_src->queue->tail) - (guint)pcap_src->queue->head;
+            snap[i].queue_bytes = (gssize)g_atomic_pointer_get(&pcap_src->queue->bytes);
+            snap[i].queue_max_packets = STATS_LOAD(&pcap_src->queue->max_count);
+            snap[i].queue_max_bytes = STATS_LOAD(&pcap_src->queue->max_bytes);
+        }
+        memcpy(snap[i].write_latency, pcap_src->write_latency, sizeof snap[i].write_latency);
+        snap[i].write_latency_sum = pcap_src->write_latency_sum;
+    }
+
+    tmp_name = ws_strdup_printf("%s.tmp", stats_file);
+    fh = ws_fopen(tmp_name, "w");
+    if (fh == NULL) {
+        ws_warning("Can't create the statistics file \"%s\": %s.", tmp_name, g_strerror(errno));
+        g_free(tmp_name);
+        g_free(snap);
+        return;
+    }
+
+    capture_loop_write_stats_metric(fh, "dumpcap_packets_received_total", "counter",
+        "Packets received from the interface.");
+    for (i = 0; i < num_srcs; i++)
+        capture_loop_write_stats_value(fh, "dumpcap_packets_received_total", snap[i].iface, snap[i].received);
+
+    capture_loop_write_stats_metric(fh, "dumpcap_bytes_received_total", "counter",
+        "Bytes of packet data received from the interface.");
+    for (i = 0; i < num_srcs; i++)
+        capture_loop_write_stats_value(fh, "dumpcap_bytes_received_total", snap[i].iface, snap[i].bytes_received);
+
+    capture_loop_write_stats_metric(fh, "dumpcap_packets_dropped_total", "counter",
+        "Packets received from the interface but dropped by dumpcap.");
+    for (i = 0; i < num_srcs; i++)
+        capture_loop_write_stats_value(fh, "dumpcap_packets_dropped_total", snap[i].iface, snap[i].dropped);
+
+    capture_loop_write_stats_metric(fh, "dumpcap_kernel_packets_dropped_total", "counter",
+        "Packets dropped by the capture library or operating system.");
+    for (i = 0; i < num_srcs; i++) {
+        if (snap[i].kernel_dropped_known)
+            capture_loop_write_stats_value(fh, "dumpcap_kernel_packets_dropped_total", snap[i].iface, snap[i].kernel_dropped);
+    }
+
+    capture_loop_write_stats_metric(fh, "dumpcap_packets_written_total", "counter",
+        "Packets written to the output file.");
+    for (i = 0; i < num_srcs; i++)
+        capture_loop_write_stats_value(fh, "dumpcap_packets_written_total", snap[i].iface, snap[i].packets_written);
+
+    capture_loop_write_stats_metric(fh, "dumpcap_bytes_written_total", "counter",
+        "Bytes of packet data written to the output file.");
+    for (i = 0; i < num_srcs; i++)
+        capture_loop_write_stats_value(fh, "dumpcap_bytes_written_total", snap[i].iface, snap[i].bytes_written);
+
+    if (use_threads) {
+        capture_loop_write_stats_metric(fh, "dumpcap_queue_packets", "gauge",
+            "Packets queued for the writer.");
+        for (i = 0; i < num_srcs; i++)
+            capture_loop_write_stats_value(fh, "dumpcap_queue_packets", snap[i].iface, snap[i].queue_packets);
+
+        capture_loop_write_stats_metric(fh, "dumpcap_queue_bytes", "gauge",
+            "Bytes of packet data queued for the writer.");
+        for (i = 0; i < num_srcs; i++)
+            capture_loop_write_stats_value(fh, "dumpcap_queue_bytes", snap[i].iface, snap[i].queue_bytes);
+
+        capture_loop_write_stats_metric(fh, "dumpcap_queue_max_packets", "gauge",
+            "Largest number of packets that have been queued for the writer at once.");
+        for (i = 0; i < num_srcs; i++)
+            capture_loop_write_stats_value(fh, "dumpcap_queue_max_packets", snap[i].iface, snap[i].queue_max_packets);
+
+        capture_loop_write_stats_metric(fh, "dumpcap_queue_max_bytes", "gauge",
+            "Largest number of bytes of packet data that have been queued for the writer at once.");
+        for (i = 0; i < num_srcs; i++)
+            capture_loop_write_stats_value(fh, "dumpcap_queue_max_bytes", snap[i].iface, snap[i].queue_max_bytes);
+    }
+
+    capture_loop_write_stats_metric(fh, "dumpcap_write_latency_seconds", "histogram",
+        "Time taken to write each packet to the output file.");
+    for (i = 0; i < num_srcs; i++) {
+        cumulative = 0;
+        for (bucket = 0; bucket < STATS_LATENCY_BUCKETS; bucket++) {
+            cumulative += snap[i].write_latency[bucket];
+            fputs("dumpcap_write_latency_seconds_bucket{interface=\"", fh);
+            capture_loop_write_stats_label(fh, snap[i].iface);
+            if (bucket < STATS_LATENCY_BUCKETS - 1)
+                fprintf(fh, "\",le=\"%g\"} %" PRIu64 "\n", (double)(G_GUINT64_CONSTANT(1) << bucket) / 1000000, cumulative);
+            else
+                fprintf(fh, "\",le=\"+Inf\"} %" PRIu64 "\n", cumulative);
+        }
+        fputs("dumpcap_write_latency_seconds_sum{interface=\"", fh);
+        capture_loop_write_stats_label(fh, snap[i].iface);
+        fprintf(fh, "\"} %g\n", (double)snap[i].write_latency_sum / 1000000);
+        capture_loop_write_stats_value(fh, "dumpcap_write_latency_seconds_count", snap[i].iface, cumulative);
+    }
+
+    capture_loop_write_stats_metric(fh, "dumpcap_ring_rotations_total", "counter",
+        "Number of times dumpcap has switched to a new ring buffer file.");
+    fprintf(fh, "dumpcap_ring_rotations_total %" PRIu64 "\n", global_ld.ring_rotations);
+
+    if (fclose(fh) != 0 || ws_rename(tmp_name, stats_file) != 0) {
+        ws_warning("Can't write the statistics file \"%s\": %s.", stats_file, g_strerror(errno));
+        ws_unlink(tmp_name);
+    }
+    g_free(tmp_name);
+    g_free(snap);
+}
+
 /* Do the low-level work of a capture.
    Returns TRUE if it succeeds, FALSE otherwise. */
 static gboolean
@@ -4131,6 +4654,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     int               err_close;
     int               inpkts;
     GTimer           *autostop_duration_timer = NULL;
+    gint64            next_stats_time       = 0;
     gboolean          write_ok;
     gboolean          close_ok;
     gboolean          cfilter_error         = FALSE;
@@ -4150,6 +4674,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     global_ld.report_packet_count = FALSE;
 #endif
     global_ld.inpkts_to_sync_pipe = 0;
+    global_ld.ring_rotations      = 0;
     global_ld.err                 = 0;  /* no error seen yet */
     global_ld.pdh                 = NULL;
     global_ld.save_file_fd        = -1;
@@ -4264,9 +4789,10 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
-        pcap_queue_bytes = 0;
-        pcap_queue_packets = 0;
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            pcap_src->queue = pcap_queue_new();
+        }
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             /* XXX - Add an interface name here? */
@@ -4327,16 +4853,20 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         /* Only update after an interval so as not to overload slow displays.
          * This also prevents too much context-switching between the dumpcap
          * and wireshark processes.
-         * XXX: Should we send updates sooner if there have been lots of
-         * packets we haven't notified the parent about, such as on fast links?
+         * On fast links, though, we send an update as soon as we have
+         * UPDATE_MAX_PACKETS packets we haven't notified the parent about,
+         * so that it can read them while they're still in the page cache
+         * rather than getting them in one large burst per interval.
          */
 #ifdef _WIN32
         cur_time = GetTickCount();  /* Note: wraps to 0 if sys runs for 49.7 days */
-        if ((cur_time - upd_time) > capture_opts->update_interval) /* wrap just causes an extra update */
+        if ((cur_time - upd_time) > capture_opts->update_interval /* wrap just causes an extra update */
+            || global_ld.inpkts_to_sync_pipe >= UPDATE_MAX_PACKETS)
 #else
         gettimeofday(&cur_time, NULL);
         if (((guint64)cur_time.tv_sec * 1000000 + cur_time.tv_usec) >
-            ((guint64)upd_time.tv_sec * 1000000 + upd_time.tv_usec + capture_opts->update_interval*1000))
+            ((guint64)upd_time.tv_sec * 1000000 + upd_time.tv_usec + capture_opts->update_interval*1000)
+            || global_ld.inpkts_to_sync_pipe >= UPDATE_MAX_PACKETS)
 #endif
         {
 
@@ -4360,6 +4890,11 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 global_ld.inpkts_to_sync_pipe = 0;
             }
 
+            if (stats_file && g_get_monotonic_time() >= next_stats_time) {
+                capture_loop_write_stats(capture_opts);
+                next_stats_time = g_get_monotonic_time() + STATS_FILE_INTERVAL;
+            }
+
             /* check capture duration condition */
             if (autostop_duration_timer != NULL && g_timer_elapsed(autostop_duration_timer, NULL) >= capture_opts->autostop_duration) {
                 /* The maximum capture time has elapsed; stop the capture. */
@@ -4401,6 +4936,11 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 fflush(global_ld.pdh);
             }
         }
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            pcap_queue_free(pcap_src->queue);
+            pcap_src->queue = NULL;
+        }
     }
 
 
@@ -4572,6 +5112,11 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 
     report_capture_count(TRUE);
 
+    /* write the final values of our counters */
+    if (stats_file) {
+        capture_loop_write_stats(capture_opts);
+    }
+
     /* get packet drop statistics from pcap */
     for (i = 0; i < capture_opts->ifaces->len; i++) {
         guint32 received;
@@ -4705,17 +5250,20 @@ capture_loop_get_errmsg(char *errmsg, size_t errmsglen, char *secondary_errmsg,
 }
 
 /*
- * We wrote one packet. Update some statistics and check if we've met any
- * autostop or ring buffer conditions.
+ * We wrote one packet of "len" bytes. Update some statistics and check if
+ * we've met any autostop or ring buffer conditions.
  */
 static void
-capture_loop_wrote_one_packet(capture_src *pcap_src) {
+capture_loop_wrote_one_packet(capture_src *pcap_src, guint32 len) {
     global_ld.packets_captured++;
     global_ld.packets_written++;
     global_ld.inpkts_to_sync_pipe++;
+    STATS_ADD(&pcap_src->packets_written, 1);
+    STATS_ADD(&pcap_src->bytes_written, len);
 
     if (!use_threads) {
-        pcap_src->received++;
+        STATS_ADD(&pcap_src->received, 1);
+        STATS_ADD(&pcap_src->bytes_received, len);
     }
 
     /* check -c NUM */
@@ -4781,6 +5329,7 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
 
     if (global_ld.pdh) {
         gboolean successful;
+        gint64   write_start = stats_file ? g_get_monotonic_time() : 0;
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
@@ -4791,6 +5340,8 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
                                        &global_ld.bytes_written, &err);
 
         fflush(global_ld.pdh);
+        if (stats_file)
+            capture_loop_record_write_latency(pcap_src, g_get_monotonic_time() - write_start);
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -4799,7 +5350,7 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
             /* Count packets for block types that should be dissected, i.e. ones that show up in the packet list. */
             ws_debug("Wrote a pcapng block type %u of length %d captured on interface %u.",
                    bh->block_type, bh->block_total_length, pcap_src->interface_id);
-            capture_loop_wrote_one_packet(pcap_src);
+            capture_loop_wrote_one_packet(pcap_src, bh->block_total_length);
         } else if (bh->block_type == BLOCK_TYPE_SHB && report_capture_filename) {
             ws_debug("Sending SP_FILE on first SHB");
             /* SHB is now ready for capture parent to read on SP_FILE message */
@@ -4830,6 +5381,7 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
 
     if (global_ld.pdh) {
         gboolean successful;
+        gint64   write_start = stats_file ? g_get_monotonic_time() : 0;
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
@@ -4850,6 +5402,8 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                               pd,
                                               &global_ld.bytes_written, &err);
         }
+        if (stats_file)
+            capture_loop_record_write_latency(pcap_src, g_get_monotonic_time() - write_start);
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -4857,7 +5411,7 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         } else {
             ws_debug("Wrote a pcap packet of length %d captured on interface %u.",
                    phdr->caplen, pcap_src->interface_id);
-            capture_loop_wrote_one_packet(pcap_src);
+            capture_loop_wrote_one_packet(pcap_src, phdr->caplen);
         }
     }
 }
@@ -4893,32 +5447,23 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
     memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
+    limit_reached = !pcap_queue_push(pcap_src->queue, queue_element);
     if (limit_reached) {
-        pcap_src->dropped++;
+        STATS_ADD(&pcap_src->dropped, 1);
         g_free(queue_element->pd);
         g_free(queue_element);
         ws_info("Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
     } else {
-        pcap_src->received++;
+        STATS_ADD(&pcap_src->received, 1);
+        STATS_ADD(&pcap_src->bytes_received, phdr->caplen);
         ws_info("Queued a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    ws_info("Queue size is now %" PRId64 " bytes (%" PRId64 " packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+    /* The writer may be dequeueing as we look, so this may be out of date */
+    ws_info("Queue size for interface %u is now %" PRId64 " bytes (%u packets)",
+          pcap_src->interface_id, (gint64)(gssize)g_atomic_pointer_get(&pcap_src->queue->bytes),
+          (guint)g_atomic_int_get(&pcap_src->queue->tail) - (guint)g_atomic_int_get(&pcap_src->queue->head));
 }
 
 /* one pcapng block was captured, queue it */
@@ -4950,32 +5495,23 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
     memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
+    limit_reached = !pcap_queue_push(pcap_src->queue, queue_element);
     if (limit_reached) {
-        pcap_src->dropped++;
+        STATS_ADD(&pcap_src->dropped, 1);
         g_free(queue_element->pd);
         g_free(queue_element);
         ws_info("Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
     } else {
-        pcap_src->received++;
+        STATS_ADD(&pcap_src->received, 1);
+        STATS_ADD(&pcap_src->bytes_received, bh->block_total_length);
         ws_info("Queued a block of type 0x%08x of length %d captured on interface %u.",
               bh->block_type, bh->block_total_length, pcap_src->interface_id);
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    ws_info("Queue size is now %" PRId64 " bytes (%" PRId64 " packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+    /* The writer may be dequeueing as we look, so this may be out of date */
+    ws_info("Queue size for interface %u is now %" PRId64 " bytes (%u packets)",
+          pcap_src->interface_id, (gint64)(gssize)g_atomic_pointer_get(&pcap_src->queue->bytes),
+          (guint)g_atomic_int_get(&pcap_src->queue->tail) - (guint)g_atomic_int_get(&pcap_src->queue->head));
 }
 
 static int
@@ -5057,6 +5593,7 @@ gather_dumpcap_runtime_info(feature_list l)
 #ifdef _WIN32
 #define LONGOPT_SIGNAL_PIPE        LONGOPT_BASE_APPLICATION+4
 #endif
+#define LONGOPT_STATS_FILE         LONGOPT_BASE_APPLICATION+5
 
 /* And now our feature presentation... [ fade to music ] */
 int
@@ -5071,6 +5608,7 @@ main(int argc, char *argv[])
         {"ifname", ws_required_argument, NULL, LONGOPT_IFNAME},
         {"ifdescr", ws_required_argument, NULL, LONGOPT_IFDESCR},
         {"capture-comment", ws_required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
+        {"stats-file", ws_required_argument, NULL, LONGOPT_STATS_FILE},
 #ifdef _WIN32
         {"signal-pipe", ws_required_argument, NULL, LONGOPT_SIGNAL_PIPE},
 #endif
@@ -5466,6 +6004,10 @@ main(int argc, char *argv[])
             }
             g_ptr_array_add(capture_comments, g_strdup(ws_optarg));
             break;
+        case LONGOPT_STATS_FILE:       /* statistics file */
+            g_free(stats_file);
+            stats_file = g_strdup(ws_optarg);
+            break;
         case 'Z':
             capture_child = TRUE;
             /*
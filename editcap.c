@@ -40,6 +40,7 @@
 #include <wiretap/wtap.h>
 
 #include "epan/etypes.h"
+#include "epan/ipproto.h"
 #include "epan/dissectors/packet-ieee80211-radiotap-defs.h"
 
 #ifdef _WIN32
@@ -99,6 +100,55 @@ typedef struct _fd_hash_t {
 static fd_hash_t fd_hash[MAX_DUP_DEPTH];
 static int       dup_window    = DEFAULT_DUP_DEPTH;
 static int       cur_dup_entry = 0;
+static int       dup_entries_used = 0;
+
+/*
+ * Index of the frames in the duplicate window, keyed by length and digest,
+ * so that a new frame can be checked in constant time instead of being
+ * compared with every frame in the window.
+ */
+typedef struct _fd_hash_index_t {
+    guint32    newest;  /* fd_hash[] index + 1 of the newest frame with this key, 0 if unused */
+    guint32    count;   /* number of frames in the window with this key */
+} fd_hash_index_t;
+
+static fd_hash_index_t *fd_index;
+static guint32   fd_index_mask;
+
+/*
+ * Flow partitioning (--split-flows). Each packet goes to one of several
+ * output files chosen by a hash of its addresses, IP protocol and ports
+ * that is the same in both directions, so that every conversation ends
+ * up wholly in one file.
+ */
+#define MAX_FLOW_FILES          1024
+#define FLOW_FRAG_SLOTS         4096    /* fragmented datagrams remembered; must be a power of 2 */
+#define FLOW_MAX_DEPTH          8       /* maximum nesting of tunnels */
+#define FLOW_VXLAN_PORT         4789
+
+typedef struct _flow_key_t {
+    guint8     addr_len;    /* 4 or 16 */
+    guint8     proto;
+    guint16    src_port;
+    guint16    dst_port;
+    guint8     src[16];
+    guint8     dst[16];
+    gboolean   hashed;      /* hash already known, from a fragment table entry */
+    guint32    hash;
+} flow_key_t;
+
+/*
+ * The first fragment of a datagram carries the ports; the hash it gets
+ * is remembered here so that the other fragments can follow it.
+ */
+typedef struct _flow_frag_t {
+    gboolean   used;
+    guint32    frag_id;
+    flow_key_t key;         /* addresses and protocol of the fragmented datagram */
+    guint32    hash;
+} flow_frag_t;
+
+static flow_frag_t *flow_frags;
 
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
@@ -639,9 +689,107 @@ set_unused_info(const wtap_packet_header *phdr, guint8* fd) {
     }
 }
 
+static void
+dup_index_init(void)
+{
+    guint32 size = 1;
+
+    /* Keep the index at most half full */
+    while (size < 2 * (guint32)MAX(dup_window, 1))
+        size <<= 1;
+
+    fd_index = g_new0(fd_hash_index_t, size);
+    fd_index_mask = size - 1;
+}
+
+static guint32
+dup_index_home(const fd_hash_t *entry)
+{
+    /* The digest is already uniformly distributed */
+    return (pntoh32(entry->digest) ^ entry->len) & fd_index_mask;
+}
+
+/* Return the index slot for the key of entry, or the unused slot where it belongs. */
+static guint32
+dup_index_lookup(const fd_hash_t *entry)
+{
+    guint32 slot = dup_index_home(entry);
+
+    while (fd_index[slot].newest != 0) {
+        const fd_hash_t *other = &fd_hash[fd_index[slot].newest - 1];
+        if (other->len == entry->len && memcmp(other->digest, entry->digest, 16) == 0)
+            break;
+        slot = (slot + 1) & fd_index_mask;
+    }
+    return slot;
+}
+
+/* Drop fd_hash[entry_num], which is about to be overwritten, from the index. */
+static void
+dup_index_remove(int entry_num)
+{
+    guint32 hole = dup_index_lookup(&fd_hash[entry_num]);
+    guint32 slot = hole;
+
+    if (fd_index[hole].newest == 0 || --fd_index[hole].count > 0)
+        return;
+
+    /* Last frame with this key: empty the slot and close the gap behind it */
+    fd_index[hole].newest = 0;
+    for (;;) {
+        guint32 home;
+
+        slot = (slot + 1) & fd_index_mask;
+        if (fd_index[slot].newest == 0)
+            return;
+        home = dup_index_home(&fd_hash[fd_index[slot].newest - 1]);
+        if ((hole <= slot) ? (home <= hole || home > slot) : (home <= hole && home > slot)) {
+            fd_index[hole] = fd_index[slot];
+            fd_index[slot].newest = 0;
+            hole = slot;
+        }
+    }
+}
+
+/*
+ * Add a frame to the duplicate window, replacing the oldest one if the
+ * window is full. Returns the fd_hash[] index of the newest earlier frame
+ * in the window with the same length and digest, or -1 if there is none.
+ */
+static int
+dup_window_add(const guint8 *fd, guint32 digest_len, guint32 len)
+{
+    guint32 slot;
+    int prev = -1;
+
+    cur_dup_entry++;
+    if (cur_dup_entry >= dup_window)
+        cur_dup_entry = 0;
+
+    if (dup_entries_used < MAX(dup_window, 1))
+        dup_entries_used++;
+    else
+        dup_index_remove(cur_dup_entry);
+
+    /* Calculate our digest */
+    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, fd, digest_len);
+
+    fd_hash[cur_dup_entry].len = len;
+
+    slot = dup_index_lookup(&fd_hash[cur_dup_entry]);
+    if (fd_index[slot].newest != 0) {
+        prev = fd_index[slot].newest - 1;
+        fd_index[slot].count++;
+    } else {
+        fd_index[slot].count = 1;
+    }
+    fd_index[slot].newest = cur_dup_entry + 1;
+
+    return prev;
+}
+
 static gboolean
 is_duplicate(guint8* fd, guint32 len) {
-    int i;
     const struct ieee80211_radiotap_header* tap_header;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
@@ -664,32 +812,14 @@ is_duplicate(guint8* fd, guint32 len) {
     new_fd  = &fd[offset];
     new_len = len - (offset);
 
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
-
     /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
-
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
-        }
-    }
-
-    return FALSE;
+    return dup_window_add(new_fd, new_len, len) >= 0;
 }
 
 static gboolean
 is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
-    int i;
+    int prev;
+    nstime_t delta;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
@@ -703,103 +833,439 @@ is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
     new_fd  = &fd[offset];
     new_len = len - (offset);
 
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
+    prev = dup_window_add(new_fd, new_len, len);
     fd_hash[cur_dup_entry].frame_time.secs = current->secs;
     fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
 
     /*
-     * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
-     * We check starting from the most recently added hash
-     * entries and work backwards towards older packets.
-     * This approach allows the dup test to be terminated
-     * when the relative time of a cached entry is found to
-     * be beyond the dup time window.
+     * Look for relative time related duplicates. Only the most recent
+     * earlier copy of this frame needs checking: if it is outside the
+     * dup time window, so are all the older ones.
      *
      * Of course this assumes that the input trace file is
      * "well-formed" in the sense that the packet timestamps are
      * in strict chronologically increasing order (which is NOT
      * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
      */
+    if (prev < 0) {
+        return FALSE;
+    }
 
-    for (i = cur_dup_entry - 1;; i--) {
-        nstime_t delta;
-        int cmp;
+    nstime_delta(&delta, current, &fd_hash[prev].frame_time);
 
-        if (i < 0)
-            i = dup_window - 1;
+    if (delta.secs < 0 || delta.nsecs < 0) {
+        /*
+         * A negative delta implies that the current packet
+         * has an absolute timestamp less than the cached packet
+         * that it is being compared to.  This is NOT a normal
+         * situation since trace files usually have packets in
+         * chronological order (oldest to newest). Don't treat
+         * such packets as duplicates.
+         */
+        return FALSE;
+    }
 
-        if (i == cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
-            break;
-        }
+    return nstime_cmp(&delta, &relative_time_window) <= 0;
+}
 
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
+#define FLOW_FNV_OFFSET 2166136261U
+#define FLOW_FNV_PRIME  16777619U
+
+static guint32
+flow_hash_bytes(guint32 h, const guint8 *p, size_t len)
+{
+    for (size_t n = 0; n < len; n++) {
+        h ^= p[n];
+        h *= FLOW_FNV_PRIME;
+    }
+    return h;
+}
+
+/* Spread the FNV-1a bits so that taking the hash modulo the file count is fair */
+static guint32
+flow_hash_finish(guint32 h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+/* Hash the endpoints in a canonical order, so both directions agree */
+static guint32
+flow_key_hash(const flow_key_t *key)
+{
+    const guint8 *lo_addr = key->src, *hi_addr = key->dst;
+    guint16 lo_port = key->src_port, hi_port = key->dst_port;
+    guint8 rest[5];
+    guint32 h;
+    int cmp;
+
+    cmp = memcmp(key->src, key->dst, key->addr_len);
+    if (cmp > 0 || (cmp == 0 && key->src_port > key->dst_port)) {
+        lo_addr = key->dst;
+        hi_addr = key->src;
+        lo_port = key->dst_port;
+        hi_port = key->src_port;
+    }
+
+    rest[0] = lo_port >> 8;
+    rest[1] = lo_port & 0xff;
+    rest[2] = hi_port >> 8;
+    rest[3] = hi_port & 0xff;
+    rest[4] = key->proto;
+
+    h = flow_hash_bytes(FLOW_FNV_OFFSET, lo_addr, key->addr_len);
+    h = flow_hash_bytes(h, hi_addr, key->addr_len);
+    h = flow_hash_bytes(h, rest, sizeof rest);
+    return flow_hash_finish(h);
+}
+
+static flow_frag_t *
+flow_frag_slot(const flow_key_t *key, guint32 frag_id)
+{
+    guint8 id[5];
+    guint32 h;
+
+    id[0] = frag_id >> 24;
+    id[1] = (frag_id >> 16) & 0xff;
+    id[2] = (frag_id >> 8) & 0xff;
+    id[3] = frag_id & 0xff;
+    id[4] = key->proto;
+
+    h = flow_hash_bytes(FLOW_FNV_OFFSET, key->src, key->addr_len);
+    h = flow_hash_bytes(h, key->dst, key->addr_len);
+    h = flow_hash_bytes(h, id, sizeof id);
+    return &flow_frags[flow_hash_finish(h) & (FLOW_FRAG_SLOTS - 1)];
+}
+
+static gboolean flow_parse_ethertype(guint16 type, const guint8 *pd, guint32 len,
+                                     int depth, flow_key_t *key);
+static gboolean flow_parse_ip(const guint8 *pd, guint32 len, int depth, flow_key_t *key);
+
+static gboolean
+flow_parse_ether(const guint8 *pd, guint32 len, int depth, flow_key_t *key)
+{
+    if (len < 14)
+        return FALSE;
+    return flow_parse_ethertype(pntoh16(pd + 12), pd + 14, len - 14, depth, key);
+}
+
+static gboolean
+flow_parse_gre(const guint8 *pd, guint32 len, int depth, flow_key_t *key)
+{
+    guint16 flags;
+    guint32 off = 4;
+
+    if (len < 4)
+        return FALSE;
+    flags = pntoh16(pd);
+    if ((flags & 0x0007) != 0)          /* only version 0 carries a protocol type */
+        return FALSE;
+    if (flags & 0x8000)                 /* checksum and reserved */
+        off += 4;
+    if (flags & 0x2000)                 /* key */
+        off += 4;
+    if (flags & 0x1000)                 /* sequence number */
+        off += 4;
+    if (off > len)
+        return FALSE;
+    return flow_parse_ethertype(pntoh16(pd + 2), pd + off, len - off, depth, key);
+}
+
+/*
+ * Fill in the ports of the transport header, or, for a tunnel, replace
+ * the key with that of the innermost packet we can parse.
+ */
+static void
+flow_parse_transport(const guint8 *pd, guint32 len, int depth, flow_key_t *key)
+{
+    flow_key_t inner;
+
+    switch (key->proto) {
+
+    case IP_PROTO_TCP:
+    case IP_PROTO_UDP:
+    case IP_PROTO_SCTP:
+    case IP_PROTO_DCCP:
+    case IP_PROTO_UDPLITE:
+        if (len < 4)
             break;
-        }
+        key->src_port = pntoh16(pd);
+        key->dst_port = pntoh16(pd + 2);
+        if (key->proto == IP_PROTO_UDP && key->dst_port == FLOW_VXLAN_PORT &&
+            len >= 16 && flow_parse_ether(pd + 16, len - 16, depth + 1, &inner))
+            *key = inner;
+        break;
+
+    case IP_PROTO_IPIP:
+    case IP_PROTO_IPV6:
+        if (flow_parse_ip(pd, len, depth + 1, &inner))
+            *key = inner;
+        break;
+
+    case IP_PROTO_GRE:
+        if (flow_parse_gre(pd, len, depth + 1, &inner))
+            *key = inner;
+        break;
+    }
+}
 
-        nstime_delta(&delta, current, &fd_hash[i].frame_time);
+/*
+ * Handle the payload of an IP datagram whose addresses are already in key.
+ * For a fragmented datagram only the first fragment can be parsed; the
+ * others use the hash it got, or, if they arrive before it, fall back to
+ * a hash without ports.
+ */
+static gboolean
+flow_parse_ip_payload(guint8 proto, guint32 frag_offset, gboolean more_frags,
+                      guint32 frag_id, const guint8 *pd, guint32 len,
+                      int depth, flow_key_t *key)
+{
+    flow_frag_t *slot;
+    flow_key_t frag_key;
 
-        if (delta.secs < 0 || delta.nsecs < 0) {
-            /*
-             * A negative delta implies that the current packet
-             * has an absolute timestamp less than the cached packet
-             * that it is being compared to.  This is NOT a normal
-             * situation since trace files usually have packets in
-             * chronological order (oldest to newest).
-             *
-             * There are several possible ways to deal with this:
-             * 1. 'continue' dup checking with the next cached frame.
-             * 2. 'break' from looking for a duplicate of the current frame.
-             * 3. Take the absolute value of the delta and see if that
-             * falls within the specified dup time window.
-             *
-             * Currently this code does option 1.  But it would pretty
-             * easy to add yet-another-editcap-option to select one of
-             * the other behaviors for dealing with out-of-sequence
-             * packets.
-             */
-            continue;
+    key->proto = proto;
+    if (frag_offset == 0 && !more_frags) {
+        flow_parse_transport(pd, len, depth, key);
+        return TRUE;
+    }
+
+    slot = flow_frag_slot(key, frag_id);
+    if (frag_offset != 0) {
+        if (slot->used && slot->frag_id == frag_id &&
+            slot->key.addr_len == key->addr_len && slot->key.proto == proto &&
+            memcmp(slot->key.src, key->src, key->addr_len) == 0 &&
+            memcmp(slot->key.dst, key->dst, key->addr_len) == 0) {
+            key->hash = slot->hash;
+            key->hashed = TRUE;
         }
+        return TRUE;
+    }
 
-        cmp = nstime_cmp(&delta, &relative_time_window);
+    frag_key = *key;
+    flow_parse_transport(pd, len, depth, key);
+    if (!key->hashed) {
+        key->hash = flow_key_hash(key);
+        key->hashed = TRUE;
+    }
+    slot->used = TRUE;
+    slot->frag_id = frag_id;
+    slot->key = frag_key;
+    slot->hash = key->hash;
+    return TRUE;
+}
 
-        if (cmp > 0) {
-            /*
-             * The delta time indicates that we are now looking at
-             * cached packets beyond the specified dup time window.
-             * Check no more!
-             */
+static gboolean
+flow_parse_ipv4(const guint8 *pd, guint32 len, int depth, flow_key_t *key)
+{
+    guint32 hlen, total_len;
+    guint16 frag;
+
+    if (len < 20)
+        return FALSE;
+    hlen = (pd[0] & 0x0f) * 4;
+    if (hlen < 20 || hlen > len)
+        return FALSE;
+    total_len = pntoh16(pd + 2);
+    if (total_len >= hlen && total_len < len)
+        len = total_len;                /* ignore link layer padding */
+
+    memset(key, 0, sizeof *key);
+    key->addr_len = 4;
+    memcpy(key->src, pd + 12, 4);
+    memcpy(key->dst, pd + 16, 4);
+    frag = pntoh16(pd + 6);
+    return flow_parse_ip_payload(pd[9], frag & 0x1fff, (frag & 0x2000) != 0,
+                                 pntoh16(pd + 4), pd + hlen, len - hlen,
+                                 depth, key);
+}
+
+static gboolean
+flow_parse_ipv6(const guint8 *pd, guint32 len, int depth, flow_key_t *key)
+{
+    guint32 off = 40, payload_len, frag_id = 0, frag_offset = 0;
+    gboolean more_frags = FALSE;
+    guint8 nxt;
+
+    if (len < 40)
+        return FALSE;
+    payload_len = pntoh16(pd + 4);
+    if (payload_len != 0 && payload_len < len - 40)
+        len = 40 + payload_len;         /* ignore link layer padding */
+
+    memset(key, 0, sizeof *key);
+    key->addr_len = 16;
+    memcpy(key->src, pd + 8, 16);
+    memcpy(key->dst, pd + 24, 16);
+
+    /* Walk the extension headers to the upper layer protocol */
+    nxt = pd[6];
+    for (;;) {
+        if (nxt != IP_PROTO_HOPOPTS && nxt != IP_PROTO_ROUTING &&
+            nxt != IP_PROTO_DSTOPTS && nxt != IP_PROTO_AH &&
+            nxt != IP_PROTO_FRAGMENT)
             break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
+        if (len - off < 8) {
+            /* Truncated; hash on the addresses alone */
+            key->proto = nxt;
+            return TRUE;
+        }
+        if (nxt == IP_PROTO_FRAGMENT) {
+            frag_offset = pntoh16(pd + off + 2) >> 3;
+            more_frags = (pntoh16(pd + off + 2) & 0x0001) != 0;
+            frag_id = pntoh32(pd + off + 4);
+            nxt = pd[off];
+            off += 8;
+        } else if (nxt == IP_PROTO_AH) {
+            nxt = pd[off];
+            off += (pd[off + 1] + 2) * 4;
+        } else {
+            nxt = pd[off];
+            off += (pd[off + 1] + 1) * 8;
+        }
+        if (off > len) {
+            key->proto = nxt;
             return TRUE;
         }
     }
 
+    return flow_parse_ip_payload(nxt, frag_offset, more_frags, frag_id,
+                                 pd + off, len - off, depth, key);
+}
+
+static gboolean
+flow_parse_ip(const guint8 *pd, guint32 len, int depth, flow_key_t *key)
+{
+    if (len < 1 || depth > FLOW_MAX_DEPTH)
+        return FALSE;
+    switch (pd[0] >> 4) {
+    case 4:
+        return flow_parse_ipv4(pd, len, depth, key);
+    case 6:
+        return flow_parse_ipv6(pd, len, depth, key);
+    }
     return FALSE;
 }
 
+static gboolean
+flow_parse_ethertype(guint16 type, const guint8 *pd, guint32 len, int depth,
+                     flow_key_t *key)
+{
+    guint32 off = 0;
+
+    if (depth > FLOW_MAX_DEPTH)
+        return FALSE;
+    for (;;) {
+        switch (type) {
+
+        case ETHERTYPE_IP:
+        case ETHERTYPE_IPv6:
+            return flow_parse_ip(pd + off, len - off, depth, key);
+
+        case ETHERTYPE_VLAN:
+        case ETHERTYPE_IEEE_802_1AD:
+        case ETHERTYPE_QINQ_OLD:
+            if (len - off < 4)
+                return FALSE;
+            type = pntoh16(pd + off + 2);
+            off += 4;
+            break;
+
+        case ETHERTYPE_MPLS:
+        case ETHERTYPE_MPLS_MULTI:
+            /* Skip the label stack; only IP directly below it is handled */
+            do {
+                if (len - off < 4)
+                    return FALSE;
+                off += 4;
+            } while (!(pd[off - 2] & 0x01));
+            return flow_parse_ip(pd + off, len - off, depth, key);
+
+        case ETHERTYPE_PPPOES:
+            if (len - off < 8)
+                return FALSE;
+            switch (pntoh16(pd + off + 6)) {
+            case 0x0021:
+                type = ETHERTYPE_IP;
+                break;
+            case 0x0057:
+                type = ETHERTYPE_IPv6;
+                break;
+            default:
+                return FALSE;
+            }
+            off += 8;
+            break;
+
+        case ETHERTYPE_ETHBRIDGE:
+            return flow_parse_ether(pd + off, len - off, depth + 1, key);
+
+        default:
+            return FALSE;
+        }
+    }
+}
+
+/*
+ * Return the flow hash of a packet. Records that aren't IP packets on a
+ * link layer we understand all hash to 0.
+ */
+static guint32
+flow_hash_packet(const wtap_rec *rec, const guint8 *pd)
+{
+    flow_key_t key;
+    guint32 len;
+    gboolean found;
+
+    if (rec->rec_type != REC_TYPE_PACKET)
+        return 0;
+    len = rec->rec_header.packet_header.caplen;
+
+    switch (rec->rec_header.packet_header.pkt_encap) {
+
+    case WTAP_ENCAP_ETHERNET:
+        found = flow_parse_ether(pd, len, 0, &key);
+        break;
+
+    case WTAP_ENCAP_RAW_IP:
+    case WTAP_ENCAP_RAW_IP4:
+    case WTAP_ENCAP_RAW_IP6:
+        found = flow_parse_ip(pd, len, 0, &key);
+        break;
+
+    case WTAP_ENCAP_SLL:
+        found = len >= sizeof(struct sll_header) &&
+                flow_parse_ethertype(pntoh16(pd + offsetof(struct sll_header, sll_protocol)),
+                                     pd + sizeof(struct sll_header),
+                                     len - (guint32)sizeof(struct sll_header), 0, &key);
+        break;
+
+    case WTAP_ENCAP_SLL2:
+        found = len >= sizeof(struct sll2_header) &&
+                flow_parse_ethertype(pntoh16(pd + offsetof(struct sll2_header, sll2_protocol)),
+                                     pd + sizeof(struct sll2_header),
+                                     len - (guint32)sizeof(struct sll2_header), 0, &key);
+        break;
+
+    case WTAP_ENCAP_NULL:
+    case WTAP_ENCAP_LOOP:
+        /* The 4 byte address family is in varying byte orders; look at the IP version instead */
+        found = len >= 4 && flow_parse_ip(pd + 4, len - 4, 0, &key);
+        break;
+
+    default:
+        found = FALSE;
+        break;
+    }
+
+    if (!found)
+        return 0;
+    return key.hashed ? key.hash : flow_key_hash(&key);
+}
+
 static void
 print_usage(FILE *output)
 {
@@ -887,6 +1353,9 @@ print_usage(FILE *output)
     fprintf(output, "  -i <seconds per file>  split the packet output to different files based on\n");
     fprintf(output, "                         uniform time intervals with a maximum of\n");
     fprintf(output, "                         <seconds per file> each.\n");
+    fprintf(output, "  --split-flows <files>  split the packet output into <files> files by a\n");
+    fprintf(output, "                         hash of each packet's addresses and ports, so that\n");
+    fprintf(output, "                         every conversation is wholly in one file.\n");
     fprintf(output, "  -F <capture type>      set the output file type; default is pcapng.\n");
     fprintf(output, "                         An empty \"-F\" option will list the file types.\n");
     fprintf(output, "  -T <encap type>        set the output file encapsulation type; default is the\n");
@@ -1115,8 +1584,8 @@ editcap_dump_open(const char *filename, const wtap_dump_params *params,
 }
 
 static gboolean
-process_new_idbs(wtap *wth, wtap_dumper *pdh, GArray *idbs_seen,
-                 int *err, gchar **err_info)
+process_new_idbs(wtap *wth, wtap_dumper **pdhs, guint num_pdhs,
+                 GArray *idbs_seen, int *err, gchar **err_info)
 {
     wtap_block_t if_data;
 
@@ -1128,38 +1597,40 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, GArray *idbs_seen,
          * That mean that the abstract interface provided by libwiretap
          * involves WTAP_BLOCK_IF_ID_AND_INFO blocks.
          */
-        if (pdh != NULL && wtap_file_type_subtype_supports_block(wtap_dump_file_type_subtype(pdh),
+        if (pdhs[0] != NULL && wtap_file_type_subtype_supports_block(wtap_dump_file_type_subtype(pdhs[0]),
                                                   WTAP_BLOCK_IF_ID_AND_INFO) != BLOCK_NOT_SUPPORTED) {
             wtap_block_t if_data_copy;
 
-            /*
-             * Make a copy of this IDB, so that we can change the
-             * encapsulation type without trashing the original.
-             */
-            if_data_copy = wtap_block_make_copy(if_data);
+            for (guint p = 0; p < num_pdhs; p++) {
+                /*
+                 * Make a copy of this IDB, so that we can change the
+                 * encapsulation type without trashing the original.
+                 */
+                if_data_copy = wtap_block_make_copy(if_data);
 
-            /*
-             * If an encapsulation type was specified, override the
-             * encapsulation type of the interface.
-             */
-            if (out_frame_type != -2) {
-                wtapng_if_descr_mandatory_t *if_mand;
+                /*
+                 * If an encapsulation type was specified, override the
+                 * encapsulation type of the interface.
+                 */
+                if (out_frame_type != -2) {
+                    wtapng_if_descr_mandatory_t *if_mand;
 
-                if_mand = (wtapng_if_descr_mandatory_t *)wtap_block_get_mandatory_data(if_data_copy);
-                if_mand->wtap_encap = out_frame_type;
-            }
+                    if_mand = (wtapng_if_descr_mandatory_t *)wtap_block_get_mandatory_data(if_data_copy);
+                    if_mand->wtap_encap = out_frame_type;
+                }
 
-            /*
-             * Add this possibly-modified IDB to the file to which
-             * we're currently writing.
-             */
-            if (!wtap_dump_add_idb(pdh, if_data_copy, err, err_info))
-                return FALSE;
+                /*
+                 * Add this possibly-modified IDB to the file(s) to which
+                 * we're currently writing.
+                 */
+                if (!wtap_dump_add_idb(pdhs[p], if_data_copy, err, err_info))
+                    return FALSE;
 
-            /*
-             * Release the copy - wtap_dump_add_idb() makes its own copy.
-             */
-            wtap_block_unref(if_data_copy);
+                /*
+                 * Release the copy - wtap_dump_add_idb() makes its own copy.
+                 */
+                wtap_block_unref(if_data_copy);
+            }
 
             /*
              * Also add an unmodified copy to the set of IDBs we've seen,
@@ -1174,6 +1645,34 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, GArray *idbs_seen,
     return TRUE;
 }
 
+/*
+ * Read the next record.  next is the number of records read so far, and
+ * no more are read once it reaches end.  If frame_index isn't NULL, records
+ * are read from the offsets in that frame index rather than sequentially.
+ */
+static gboolean
+read_next_record(wtap *wth, const wtap_frame_index_entry *frame_index,
+                 guint64 *next, guint64 end, wtap_rec *rec, Buffer *buf,
+                 int *err, gchar **err_info, gint64 *data_offset)
+{
+    gboolean ok;
+
+    if (*next >= end) {
+        *err = 0;
+        *err_info = NULL;
+        return FALSE;
+    }
+    if (frame_index != NULL) {
+        *data_offset = frame_index[*next].file_off;
+        ok = wtap_seek_read(wth, *data_offset, rec, buf, err, err_info);
+    } else {
+        ok = wtap_read(wth, rec, buf, err, err_info, data_offset);
+    }
+    if (ok)
+        (*next)++;
+    return ok;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -1204,6 +1703,7 @@ main(int argc, char *argv[])
 #define LONGOPT_DISCARD_CAPTURE_COMMENT LONGOPT_BASE_APPLICATION+7
 #define LONGOPT_SET_UNUSED           LONGOPT_BASE_APPLICATION+8
 #define LONGOPT_DISCARD_PACKET_COMMENTS LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_SPLIT_FLOWS          LONGOPT_BASE_APPLICATION+10
 
     static const struct ws_option long_options[] = {
         {"novlan", ws_no_argument, NULL, LONGOPT_NO_VLAN},
@@ -1217,6 +1717,7 @@ main(int argc, char *argv[])
         {"discard-capture-comment", ws_no_argument, NULL, LONGOPT_DISCARD_CAPTURE_COMMENT},
         {"set-unused", ws_no_argument, NULL, LONGOPT_SET_UNUSED},
         {"discard-packet-comments", ws_no_argument, NULL, LONGOPT_DISCARD_PACKET_COMMENTS},
+        {"split-flows", ws_required_argument, NULL, LONGOPT_SPLIT_FLOWS},
         {0, 0, 0, 0 }
     };
 
@@ -1232,7 +1733,12 @@ main(int argc, char *argv[])
     int           err_type;
     guint8       *buf;
     guint32       read_count         = 0;
+    guint32       skipped_count      = 0;
     guint32       split_packet_count = 0;
+    guint32       split_flow_count   = 0;
+    wtap_dumper **flow_pdhs          = NULL;
+    gchar       **flow_filenames     = NULL;
+    guint32       flow_bucket        = 0;
     int           written_count      = 0;
     char         *filename           = NULL;
     gboolean      ts_okay;
@@ -1245,6 +1751,13 @@ main(int argc, char *argv[])
     guint         max_packet_number  = 0;
     GArray       *dsb_types          = NULL;
     GPtrArray    *dsb_filenames      = NULL;
+    gboolean      use_time_index;
+    gchar        *time_index_path;
+    wtap_frame_index_entry *time_index = NULL;
+    guint64       time_index_count   = 0;
+    guint64       time_index_next    = 0;
+    guint64       time_index_end     = G_MAXUINT64;
+    gboolean      time_index_seek    = FALSE;
     wtap_rec                     read_rec;
     Buffer                       read_buf;
     const wtap_rec              *rec;
@@ -1407,6 +1920,18 @@ main(int argc, char *argv[])
             break;
         }
 
+        case LONGOPT_SPLIT_FLOWS:
+        {
+            split_flow_count = get_nonzero_guint32(ws_optarg, "flow file count");
+            if (split_flow_count > MAX_FLOW_FILES) {
+                fprintf(stderr, "editcap: \"%u\" flow file count must be between 1 and %d inclusive.\n",
+                        split_flow_count, MAX_FLOW_FILES);
+                ret = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+            }
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1708,7 +2233,23 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
-    wth = wtap_open_offline(argv[ws_optind], WTAP_TYPE_AUTO, &read_err, &read_err_info, FALSE);
+    if (split_flow_count != 0 &&
+        (split_packet_count != 0 || !nstime_is_unset(&secs_per_block))) {
+        fprintf(stderr, "editcap: can't split by flow and on packet count or time interval\n");
+        fprintf(stderr, "editcap: at the same time\n");
+        ret = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
+    /*
+     * If only the packets in a time range are wanted, we can use the
+     * frame index to avoid reading the others, which takes random access.
+     * Not when splitting on a time interval, as every interval up to the
+     * end of the file gets a file, even if it has no packets.
+     */
+    use_time_index = check_startstop && nstime_is_unset(&secs_per_block);
+
+    wth = wtap_open_offline(argv[ws_optind], WTAP_TYPE_AUTO, &read_err, &read_err_info, use_time_index);
 
     if (!wth) {
         cfile_open_failure_message(argv[ws_optind], read_err, read_err_info);
@@ -1858,6 +2399,45 @@ main(int argc, char *argv[])
             fd_hash[i].len = 0;
             nstime_set_unset(&fd_hash[i].frame_time);
         }
+        dup_index_init();
+    }
+
+    if (use_time_index) {
+        time_index_path = g_strconcat(argv[ws_optind], WTAP_FRAME_INDEX_SUFFIX, NULL);
+        time_index = wtap_load_frame_index(wth, time_index_path, &time_index_count, &read_err);
+        g_free(time_index_path);
+        read_err = 0;
+    }
+    if (time_index != NULL) {
+        guint64 first;
+
+        /*
+         * No record after the last one in the time range is written,
+         * so stop reading there.  If every interface is described at
+         * the beginning of the file, the records before the first one
+         * in the range needn't be read either; otherwise they must be,
+         * for the interface descriptions among them.
+         */
+        if (!wtap_frame_index_time_range(time_index, time_index_count,
+                                         have_starttime ? &starttime : NULL,
+                                         have_stoptime ? &stoptime : NULL,
+                                         &first, &time_index_end)) {
+            first = 0;
+            time_index_end = 0;
+        }
+        if (first != 0 && first < G_MAXUINT32 &&
+            wtap_file_type_subtype_supports_block(wtap_file_type_subtype(wth),
+                                                  WTAP_BLOCK_IF_ID_AND_INFO) != MULTIPLE_BLOCKS_SUPPORTED) {
+            time_index_seek = TRUE;
+            time_index_next = first;
+            skipped_count = (guint32)first;
+            read_count = skipped_count;
+            count += skipped_count;
+        }
+        if (verbose) {
+            fprintf(stderr, "Using the frame index: reading records %" PRIu64 " to %" PRIu64 " of %" PRIu64 ".\n",
+                    time_index_next + 1, time_index_end, time_index_count);
+        }
     }
 
     /* Set up an array of all IDBs seen */
@@ -1866,7 +2446,10 @@ main(int argc, char *argv[])
     /* Read all of the packets in turn */
     wtap_rec_init(&read_rec);
     ws_buffer_init(&read_buf, 1514);
-    while (wtap_read(wth, &read_rec, &read_buf, &read_err, &read_err_info, &data_offset)) {
+    while (read_next_record(wth, time_index_seek ? time_index : NULL,
+                            &time_index_next, time_index_end,
+                            &read_rec, &read_buf, &read_err, &read_err_info,
+                            &data_offset)) {
         /*
          * XXX - what about non-packet records in the file after this?
          * NRBs, DSBs, and ISBs are now written when wtap_dump_close() calls
@@ -1881,8 +2464,9 @@ main(int argc, char *argv[])
         rec = &read_rec;
 
         /* Extra actions for the first packet */
-        if (read_count == 1) {
-            if (split_packet_count != 0 || !nstime_is_unset(&secs_per_block)) {
+        if (read_count == skipped_count + 1) {
+            if (split_packet_count != 0 || !nstime_is_unset(&secs_per_block) ||
+                split_flow_count != 0) {
                 if (!fileset_extract_prefix_suffix(argv[ws_optind+1], &fprefix, &fsuffix)) {
                     ret = CANT_EXTRACT_PREFIX;
                     goto clean_exit;
@@ -1899,22 +2483,48 @@ main(int argc, char *argv[])
                 wtap_block_add_string_option_format(g_array_index(params.shb_hdrs, wtap_block_t, 0), OPT_SHB_USERAPPL, "%s", get_appname_and_version());
             }
 
-            pdh = editcap_dump_open(filename, &params, idbs_seen, &write_err,
-                                    &write_err_info);
+            if (split_flow_count != 0) {
+                /*
+                 * Open all of the flow files now, so that each of them
+                 * gets every IDB and there is one file per bucket even
+                 * if no packet hashes to it.
+                 */
+                flow_pdhs = g_new0(wtap_dumper *, split_flow_count);
+                flow_filenames = g_new0(gchar *, split_flow_count + 1);
+                flow_frags = g_new0(flow_frag_t, FLOW_FRAG_SLOTS);
+                for (guint32 f = 0; f < split_flow_count; f++) {
+                    flow_filenames[f] = fileset_get_filename_by_pattern(f, rec, fprefix, fsuffix);
+                    flow_pdhs[f] = editcap_dump_open(flow_filenames[f], &params, idbs_seen,
+                                                     &write_err, &write_err_info);
+                    if (flow_pdhs[f] == NULL) {
+                        cfile_dump_open_failure_message(flow_filenames[f],
+                                                        write_err, write_err_info,
+                                                        out_file_type_subtype);
+                        ret = WS_EXIT_INVALID_FILE;
+                        goto clean_exit;
+                    }
+                }
+                pdh = flow_pdhs[0];
+            } else {
+                pdh = editcap_dump_open(filename, &params, idbs_seen, &write_err,
+                                        &write_err_info);
 
-            if (pdh == NULL) {
-                cfile_dump_open_failure_message(filename,
-                                                write_err, write_err_info,
-                                                out_file_type_subtype);
-                ret = WS_EXIT_INVALID_FILE;
-                goto clean_exit;
+                if (pdh == NULL) {
+                    cfile_dump_open_failure_message(filename,
+                                                    write_err, write_err_info,
+                                                    out_file_type_subtype);
+                    ret = WS_EXIT_INVALID_FILE;
+                    goto clean_exit;
+                }
             }
         } /* first packet only handling */
 
         /*
          * Process whatever IDBs we haven't seen yet.
          */
-        if (!process_new_idbs(wth, pdh, idbs_seen, &write_err, &write_err_info)) {
+        if (!process_new_idbs(wth, flow_pdhs != NULL ? flow_pdhs : &pdh,
+                              flow_pdhs != NULL ? split_flow_count : 1,
+                              idbs_seen, &write_err, &write_err_info)) {
             cfile_write_failure_message(argv[ws_optind], filename,
                                         write_err, write_err_info,
                                         read_count,
@@ -2382,17 +2992,28 @@ main(int argc, char *argv[])
                 }
             }
 
+            if (flow_pdhs != NULL) {
+                flow_bucket = flow_hash_packet(rec, buf) % split_flow_count;
+                pdh = flow_pdhs[flow_bucket];
+            }
+
             if (discard_all_secrets) {
                 /*
                  * Discard any secrets we've read since the last packet
                  * we wrote.
                  */
-                wtap_dump_discard_decryption_secrets(pdh);
+                if (flow_pdhs != NULL) {
+                    for (guint32 f = 0; f < split_flow_count; f++)
+                        wtap_dump_discard_decryption_secrets(flow_pdhs[f]);
+                } else {
+                    wtap_dump_discard_decryption_secrets(pdh);
+                }
             }
 
             /* Attempt to dump out current frame to the output file */
             if (!wtap_dump(pdh, rec, buf, &write_err, &write_err_info)) {
-                cfile_write_failure_message(argv[ws_optind], filename,
+                cfile_write_failure_message(argv[ws_optind],
+                                            flow_pdhs != NULL ? flow_filenames[flow_bucket] : filename,
                                             write_err, write_err_info,
                                             read_count,
                                             out_file_type_subtype);
@@ -2446,7 +3067,9 @@ main(int argc, char *argv[])
     /*
      * Process whatever IDBs we haven't seen yet.
      */
-    if (!process_new_idbs(wth, pdh, idbs_seen, &write_err, &write_err_info)) {
+    if (!process_new_idbs(wth, flow_pdhs != NULL ? flow_pdhs : &pdh,
+                          flow_pdhs != NULL ? split_flow_count : 1,
+                          idbs_seen, &write_err, &write_err_info)) {
         cfile_write_failure_message(argv[ws_optind], filename,
                                     write_err, write_err_info,
                                     read_count,
@@ -2462,7 +3085,20 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
-    if (!wtap_dump_close(pdh, NULL, &write_err, &write_err_info)) {
+    if (flow_pdhs != NULL) {
+        /* pdh is one of the flow files; they're all closed here */
+        pdh = NULL;
+        for (guint32 f = 0; f < split_flow_count; f++) {
+            wtap_dumper *flow_pdh = flow_pdhs[f];
+
+            flow_pdhs[f] = NULL;
+            if (!wtap_dump_close(flow_pdh, NULL, &write_err, &write_err_info)) {
+                cfile_close_failure_message(flow_filenames[f], write_err, write_err_info);
+                ret = WRITE_ERROR;
+                goto clean_exit;
+            }
+        }
+    } else if (!wtap_dump_close(pdh, NULL, &write_err, &write_err_info)) {
         cfile_close_failure_message(filename, write_err, write_err_info);
         ret = WRITE_ERROR;
         goto clean_exit;
@@ -2484,6 +3120,22 @@ clean_exit:
     if (filename) {
         g_free(filename);
     }
+    if (flow_pdhs != NULL) {
+        /*
+         * Close any flow files still open after an error; pdh, if set,
+         * has already been closed by the code that reported the error.
+         */
+        for (guint32 f = 0; f < split_flow_count; f++) {
+            if (flow_pdhs[f] != NULL && flow_pdhs[f] != pdh) {
+                wtap_dump_close(flow_pdhs[f], NULL, &write_err, &write_err_info);
+            }
+        }
+        g_free(flow_pdhs);
+    }
+    g_strfreev(flow_filenames);
+    g_free(flow_frags);
+    g_free(fd_index);
+    g_free(time_index);
     if (frames_user_comments) {
         g_tree_destroy(frames_user_comments);
     }
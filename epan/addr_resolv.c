@@ -852,7 +852,7 @@ _serv_name_lookup(port_type proto, guint port, serv_port_t **value_ret)
     serv_port_t *serv_port_names;
     const char* name = NULL;
     ws_services_proto_t p;
-    ws_services_entry_t *serv;
+    const ws_services_entry_t *serv;
 
     /* Look in the cache */
     serv_port_names = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(port));
@@ -3182,22 +3182,15 @@ disable_name_resolution(void) {
     gbl_resolv_flags.maxmind_geoip                      = FALSE;
 }
 
-gboolean
-host_name_lookup_process(void) {
+/*
+ * Submit queued asynchronous requests, as long as no more than
+ * name_resolve_concurrency of them are in flight.
+ */
+static void
+submit_async_dns_queue(void) {
     async_dns_queue_msg_t *caqm;
-    struct timeval tv = { 0, 0 };
-    int nfds;
-    fd_set rfds, wfds;
-    gboolean nro = new_resolved_objects;
     wmem_list_frame_t* head;
 
-    new_resolved_objects = FALSE;
-    nro |= maxmind_db_lookup_process();
-
-    if (!async_dns_initialized)
-        /* c-ares not initialized. Bail out and cancel timers. */
-        return nro;
-
     head = wmem_list_head(async_dns_queue_head);
 
     while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
@@ -3215,6 +3208,23 @@ host_name_lookup_process(void) {
 
         head = wmem_list_head(async_dns_queue_head);
     }
+}
+
+gboolean
+host_name_lookup_process(void) {
+    struct timeval tv = { 0, 0 };
+    int nfds;
+    fd_set rfds, wfds;
+    gboolean nro = new_resolved_objects;
+
+    new_resolved_objects = FALSE;
+    nro |= maxmind_db_lookup_process();
+
+    if (!async_dns_initialized)
+        /* c-ares not initialized. Bail out and cancel timers. */
+        return nro;
+
+    submit_async_dns_queue();
 
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
@@ -3233,6 +3243,44 @@ host_name_lookup_process(void) {
     return nro;
 }
 
+void
+host_name_lookup_wait(void) {
+    struct timeval tv;
+    int nfds;
+    fd_set rfds, wfds;
+
+    maxmind_db_lookup_wait();
+
+    if (!async_dns_initialized)
+        return;
+
+    while (wmem_list_count(async_dns_queue_head) > 0 || async_dns_in_flight > 0) {
+        submit_async_dns_queue();
+
+        /*
+         * As in wait_for_sync_resolv(), don't use ares_timeout(), which
+         * is linear in the number of outstanding requests; ares_process()
+         * handles requests that have timed out whether or not any of
+         * the descriptors are ready.
+         */
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        nfds = ares_fds(ghba_chan, &rfds, &wfds);
+        if (nfds == 0)
+            break;
+        if (select(nfds, &rfds, &wfds, NULL, &tv) == -1) { /* call to select() failed */
+            /* If it's interrupted by a signal, no need to put out a message */
+            if (errno != EINTR)
+                fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
+            return;
+        }
+        ares_process(ghba_chan, &rfds, &wfds);
+    }
+}
+
 static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
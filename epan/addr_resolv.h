@@ -199,6 +199,15 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC gboolean host_name_lookup_process(void);
 
+/** If we're using c-ares, submit all queued asynchronous host name
+ *  lookups, no more than the "name_resolve_concurrency" preference at a
+ *  time, and wait until all of them have completed or timed out.
+ *  Outstanding MaxMind database lookups are waited for as well.
+ *  This lets TShark resolve the addresses seen in its first pass in bulk,
+ *  rather than one at a time in its second pass.
+ */
+WS_DLL_PUBLIC void host_name_lookup_wait(void);
+
 /* get_hostname returns the host name or "%d.%d.%d.%d" if not found */
 WS_DLL_PUBLIC const gchar *get_hostname(const guint addr);
 
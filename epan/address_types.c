@@ -948,6 +948,26 @@ address_to_display(wmem_allocator_t *allocator, const address *addr)
     return str;
 }
 
+void
+address_to_display_buf(const address *addr, gchar *buf, int buf_len)
+{
+    const gchar *result;
+
+    if (!buf || !buf_len)
+        return;
+
+    result = address_to_name(addr);
+    if (result != NULL) {
+        (void) g_strlcpy(buf, result, buf_len);
+    }
+    else if (addr->type == AT_NONE) {
+        (void) g_strlcpy(buf, "NONE", buf_len);
+    }
+    else {
+        address_to_str_buf(addr, buf, buf_len);
+    }
+}
+
 static void address_with_resolution_to_str_buf(const address* addr, gchar *buf, int buf_len)
 {
     address_type_t *at;
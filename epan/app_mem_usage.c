@@ -31,6 +31,7 @@
 #endif
 
 #include "wsutil/file_util.h"
+#include "wsutil/wmem/wmem_profile.h"
 #include "app_mem_usage.h"
 
 #define MAX_COMPONENTS 16
@@ -175,9 +176,24 @@ memory_usage_component_register(const ws_mem_usage_t *component)
 	memory_components[memory_register_num++] = component;
 }
 
+static gsize
+wmem_profile_get_total_usage(void)
+{
+	return (gsize) wmem_profile_get_total();
+}
+
+/* Listed after the registered components while the profiler is running */
+static const ws_mem_usage_t wmem_profile_usage = { "wmem allocated (sampled)", wmem_profile_get_total_usage, NULL };
+
 const char *
 memory_usage_get(guint idx, gsize *value)
 {
+	if (idx == memory_register_num && wmem_profile_is_running()) {
+		if (value)
+			*value = wmem_profile_usage.fetch();
+		return wmem_profile_usage.name;
+	}
+
 	if (idx >= memory_register_num)
 		return NULL;
 
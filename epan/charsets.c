@@ -11,6 +11,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 #include <glib.h>
 
 #include <epan/proto.h>
@@ -21,6 +22,23 @@
 
 #include "charsets.h"
 
+/*
+ * Return a copy of a string of bytes known to be valid UTF-8, allocated
+ * using the wmem scope; this is what most strings in packets turn out to
+ * be, for most of the encodings below.
+ */
+static guint8 *
+get_valid_utf_8_copy(wmem_allocator_t *scope, const guint8 *ptr, gint length)
+{
+    guint8 *str;
+
+    str = (guint8 *)wmem_alloc(scope, length + 1);
+    if (length > 0)
+        memcpy(str, ptr, length);
+    str[length] = '\0';
+    return str;
+}
+
 /*
  * 6-character abbreviation for "Unicode REPLACEMENT CHARACTER", so it
  * takes up the same amount of space as the 6-character hex values for
@@ -83,28 +101,29 @@ guint8 *
 get_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
     wmem_strbuf_t *str;
-    const guint8 *prev = ptr;
-    size_t valid_bytes = 0;
+    size_t valid_bytes;
+
+    if (length <= 0)
+        return get_valid_utf_8_copy(scope, ptr, 0);
+
+    valid_bytes = ws_ascii_prefix_len(ptr, length);
+    if (valid_bytes == (size_t)length)
+        return get_valid_utf_8_copy(scope, ptr, length);
 
     str = wmem_strbuf_new_sized(scope, length+1);
 
     while (length > 0) {
-        guint8 ch = *ptr++;
-
-        if (ch < 0x80) {
-            valid_bytes++;
-        } else {
-            if (valid_bytes) {
-                wmem_strbuf_append_len(str, prev, valid_bytes);
-                valid_bytes = 0;
-            }
-            prev = ptr;
+        if (valid_bytes) {
+            wmem_strbuf_append_len(str, ptr, valid_bytes);
+            ptr += valid_bytes;
+            length -= (gint)valid_bytes;
+        }
+        if (length > 0) {
             wmem_strbuf_append_unichar_repl(str);
+            ptr++;
+            length--;
         }
-        length--;
-    }
-    if (valid_bytes) {
-        wmem_strbuf_append_len(str, prev, valid_bytes);
+        valid_bytes = ws_ascii_prefix_len(ptr, length > 0 ? length : 0);
     }
 
     return (guint8 *) wmem_strbuf_finalize(str);
@@ -177,29 +196,44 @@ get_iso_646_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, cons
 guint8 *
 get_8859_1_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
-    wmem_strbuf_t *str;
+    guint8 *str, *out;
+    size_t ascii_len;
 
-    str = wmem_strbuf_new_sized(scope, length+1);
+    if (length <= 0)
+        return get_valid_utf_8_copy(scope, ptr, 0);
+
+    ascii_len = ws_ascii_prefix_len(ptr, length);
+    if (ascii_len == (size_t)length)
+        return get_valid_utf_8_copy(scope, ptr, length);
+
+    /*
+     * Every octet after the ASCII prefix is at most 2 octets of UTF-8.
+     */
+    str = out = (guint8 *)wmem_alloc(scope, ascii_len + 2 * (length - ascii_len) + 1);
 
     while (length > 0) {
-        guint8 ch = *ptr;
+        memcpy(out, ptr, ascii_len);
+        out += ascii_len;
+        ptr += ascii_len;
+        length -= (gint)ascii_len;
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else {
-            /*
-             * Note: we assume here that the code points
-             * 0x80-0x9F are used for C1 control characters,
-             * and thus have the same value as the corresponding
-             * Unicode code points.
-             */
-            wmem_strbuf_append_unichar(str, ch);
+        /*
+         * Note: we assume here that the code points
+         * 0x80-0x9F are used for C1 control characters,
+         * and thus have the same value as the corresponding
+         * Unicode code points.
+         */
+        while (length > 0 && *ptr >= 0x80) {
+            *out++ = 0xC0 | (*ptr >> 6);
+            *out++ = 0x80 | (*ptr & 0x3F);
+            ptr++;
+            length--;
         }
-        ptr++;
-        length--;
+        ascii_len = ws_ascii_prefix_len(ptr, length > 0 ? length : 0);
     }
+    *out = '\0';
 
-    return (guint8 *) wmem_strbuf_finalize(str);
+    return str;
 }
 
 /*
@@ -695,6 +729,18 @@ get_unichar2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, con
     return (guint8 *) wmem_strbuf_finalize(str);
 }
 
+/*
+ * The largest number of octets, including the terminating NUL, that a
+ * UCS-2 or UTF-16 string of length octets can turn into as UTF-8: each
+ * code unit becomes at most 3 octets (a surrogate pair becomes 4), and
+ * a trailing odd octet becomes a 3 octet REPLACEMENT CHARACTER.
+ */
+static inline size_t
+utf_16_max_utf_8_len(gint length)
+{
+    return length > 0 ? 3 * ((size_t)length / 2) + 3 + 1 : 1;
+}
+
 /*
  * Given a wmem scope, a pointer, and a length, treat the string of bytes
  * referred to by the pointer and length as a UCS-2 encoded string
@@ -712,9 +758,10 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
 {
     gunichar2      uchar;
     gint           i = 0;       /* Byte counter for string */
-    wmem_strbuf_t *strbuf;
+    guint8        *str, *out;
+    size_t         ascii_len;
 
-    strbuf = wmem_strbuf_new_sized(scope, length+1);
+    str = out = (guint8 *)wmem_alloc(scope, utf_16_max_utf_8_len(length));
 
     if (encoding & ENC_BOM && length >= 2) {
         if (pletoh16(ptr) == BYTE_ORDER_MARK) {
@@ -729,12 +776,20 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
     encoding = encoding & ENC_LITTLE_ENDIAN;
 
     for(; i + 1 < length; i += 2) {
+        /* Convert any run of ASCII characters in one go. */
+        ascii_len = ws_utf16_ascii_prefix(out, ptr + i, (length - i) / 2,
+                                          encoding == ENC_LITTLE_ENDIAN);
+        out += ascii_len;
+        i += 2 * (gint)ascii_len;
+        if (i + 1 >= length)
+            break;
+
         if (encoding == ENC_BIG_ENDIAN) {
             uchar = pntoh16(ptr + i);
         } else {
             uchar = pletoh16(ptr + i);
         }
-        wmem_strbuf_append_unichar_validated(strbuf, uchar);
+        out += g_unichar_to_utf8(g_unichar_validate(uchar) ? uchar : UNREPL, (gchar *)out);
     }
 
     /*
@@ -742,9 +797,10 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
      * insert a REPLACEMENT CHARACTER to mark the error.
      */
     if (i < length) {
-        wmem_strbuf_append_unichar_repl(strbuf);
+        out += g_unichar_to_utf8(UNREPL, (gchar *)out);
     }
-    return (guint8 *) wmem_strbuf_finalize(strbuf);
+    *out = '\0';
+    return str;
 }
 
 /*
@@ -762,12 +818,13 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
 guint8 *
 get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint encoding)
 {
-    wmem_strbuf_t *strbuf;
+    guint8        *str, *out;
     gunichar2      uchar2, lead_surrogate;
     gunichar       uchar;
     gint           i = 0;       /* Byte counter for string */
+    size_t         ascii_len;
 
-    strbuf = wmem_strbuf_new_sized(scope, length+1);
+    str = out = (guint8 *)wmem_alloc(scope, utf_16_max_utf_8_len(length));
 
     if (encoding & ENC_BOM && length >= 2) {
         if (pletoh16(ptr) == BYTE_ORDER_MARK) {
@@ -782,6 +839,14 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
     encoding = encoding & ENC_LITTLE_ENDIAN;
 
     for(; i + 1 < length; i += 2) {
+        /* Convert any run of ASCII characters in one go. */
+        ascii_len = ws_utf16_ascii_prefix(out, ptr + i, (length - i) / 2,
+                                          encoding == ENC_LITTLE_ENDIAN);
+        out += ascii_len;
+        i += 2 * (gint)ascii_len;
+        if (i + 1 >= length)
+            break;
+
         if (encoding == ENC_BIG_ENDIAN)
             uchar2 = pntoh16(ptr + i);
         else
@@ -800,7 +865,7 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
                  * Insert a REPLACEMENT CHARACTER to mark the error,
                  * and quit.
                  */
-                wmem_strbuf_append_unichar(strbuf, UNREPL);
+                out += g_unichar_to_utf8(UNREPL, (gchar *)out);
                 break;
             }
             lead_surrogate = uchar2;
@@ -811,7 +876,7 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
             if (IS_TRAIL_SURROGATE(uchar2)) {
                 /* Trail surrogate. */
                 uchar = SURROGATE_VALUE(lead_surrogate, uchar2);
-                wmem_strbuf_append_unichar(strbuf, uchar);
+                out += g_unichar_to_utf8(uchar, (gchar *)out);
             } else {
                 /*
                  * Not a trail surrogate.
@@ -819,7 +884,7 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
                  * Insert a REPLACEMENT CHARACTER to mark the error,
                  * and continue;
                  */
-                wmem_strbuf_append_unichar(strbuf, UNREPL);
+                out += g_unichar_to_utf8(UNREPL, (gchar *)out);
             }
         } else {
             if (IS_TRAIL_SURROGATE(uchar2)) {
@@ -830,12 +895,12 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
                  * Insert a REPLACEMENT CHARACTER to mark the error,
                  * and continue;
                  */
-                wmem_strbuf_append_unichar(strbuf, UNREPL);
+                out += g_unichar_to_utf8(UNREPL, (gchar *)out);
             } else {
                 /*
                  * Non-surrogate; just append it.
                  */
-                wmem_strbuf_append_unichar(strbuf, uchar2);
+                out += g_unichar_to_utf8(uchar2, (gchar *)out);
             }
         }
     }
@@ -846,8 +911,9 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
      * to mark the error.
      */
     if (i < length)
-        wmem_strbuf_append_unichar(strbuf, UNREPL);
-    return (guint8 *) wmem_strbuf_finalize(strbuf);
+        out += g_unichar_to_utf8(UNREPL, (gchar *)out);
+    *out = '\0';
+    return str;
 }
 
 /*
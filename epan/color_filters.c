@@ -48,6 +48,11 @@ static GSList *color_filter_list = NULL;
 static GSList *color_filter_deleted_list = NULL;
 static GSList *color_filter_valid_list   = NULL;
 
+/* Shares the tests common to several filters when colorizing a packet.
+ * It doesn't refer to the filters, only to the tests seen so far, so it
+ * is only recreated when the list is replaced, to forget old tests. */
+static dfilter_set_t *color_filter_set = NULL;
+
 /* Color Filters can en-/disabled. */
 static gboolean filters_enabled = TRUE;
 
@@ -364,6 +369,8 @@ color_filters_reload(gchar** err_msg, color_filter_add_cb_func add_cb)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    dfilter_set_free(color_filter_set);
+    color_filter_set = NULL;
 
     /* now try to construct the filters list */
     return color_filters_get(err_msg, add_cb);
@@ -374,6 +381,9 @@ color_filters_cleanup(void)
 {
     /* delete the previously deleted filters */
     color_filter_list_delete(&color_filter_deleted_list);
+
+    dfilter_set_free(color_filter_set);
+    color_filter_set = NULL;
 }
 
 typedef struct _color_clone
@@ -462,6 +472,8 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, gchar** err_msg)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    dfilter_set_free(color_filter_set);
+    color_filter_set = NULL;
 
     /* clone all list entries from tmp/edit to normal list */
     color_filter_list_delete(&color_filter_valid_list);
@@ -565,6 +577,20 @@ color_filters_use_proto(int proto_id)
     return (item != NULL);
 }
 
+gboolean
+color_filters_dfilter_uses_rule(const dfilter_t *df)
+{
+    int hf_name, hf_text;
+
+    if (df == NULL || !color_filters_used())
+        return FALSE;
+
+    hf_name = proto_registrar_get_id_byname("frame.coloring_rule.name");
+    hf_text = proto_registrar_get_id_byname("frame.coloring_rule.string");
+    return (hf_name > 0 && dfilter_interested_in_field(df, hf_name)) ||
+           (hf_text > 0 && dfilter_interested_in_field(df, hf_text));
+}
+
 /* * Return the color_t for later use */
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
@@ -576,11 +602,15 @@ color_filters_colorize_packet(epan_dissect_t *edt)
     if ((edt->tree != NULL) && (color_filters_used())) {
         curr = color_filter_list;
 
+        if (color_filter_set == NULL)
+            color_filter_set = dfilter_set_new();
+        dfilter_set_reset(color_filter_set);
+
         while(curr != NULL) {
             colorf = (color_filter_t *)curr->data;
             if ( (!colorf->disabled) &&
                  (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
+                 dfilter_set_apply_edt(color_filter_set, colorf->c_colorfilter, edt)) {
                 return colorf;
             }
             curr = g_slist_next(curr);
@@ -127,6 +127,17 @@ color_filters_use_hfid(int hfid);
 WS_DLL_PUBLIC gboolean
 color_filters_use_proto(int proto_id);
 
+/** Check if a display filter reads the name or string of the coloring
+ * rule that matched a packet (frame.coloring_rule.*), in which case packets
+ * must be colorized while they're dissected for it to work.  Otherwise
+ * colorizing can wait until a packet is shown.
+ *
+ * @param df The compiled display filter, or NULL
+ * @return TRUE if coloring rules are in use and the filter reads them
+ */
+WS_DLL_PUBLIC gboolean
+color_filters_dfilter_uses_rule(const struct epan_dfilter *df);
+
 /** Colorize a specific packet.
  *
  * @param edt the dissected packet
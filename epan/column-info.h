@@ -47,6 +47,7 @@ typedef struct {
   gchar              *col_buf;              /**< Buffer into which to copy data for column */
   int                 col_fence;            /**< Stuff in column buffer before this index is immutable */
   gboolean            writable;             /**< writable or not */
+  gboolean            wanted;               /**< needed by the consumer; see col_set_wanted() */
   int                 hf_id;
 } col_item_t;
 
@@ -69,6 +69,7 @@ col_setup(column_info *cinfo, const gint num_cols)
   cinfo->col_last              = g_new(int, NUM_COL_FMTS);
   for (i = 0; i < num_cols; i++) {
     cinfo->columns[i].col_custom_fields_ids = NULL;
+    cinfo->columns[i].wanted = TRUE;
   }
   cinfo->col_expr.col_expr     = g_new(const gchar*, num_cols + 1);
   cinfo->col_expr.col_expr_val = g_new(gchar*, num_cols + 1);
@@ -145,7 +146,7 @@ col_init(column_info *cinfo, const struct epan_session *epan)
     col_item->col_buf[0] = '\0';
     col_item->col_data = col_item->col_buf;
     col_item->col_fence = 0;
-    col_item->writable = TRUE;
+    col_item->writable = col_item->wanted;
     cinfo->col_expr.col_expr[i] = "";
     cinfo->col_expr.col_expr_val[i][0] = '\0';
   }
@@ -198,6 +199,13 @@ col_set_writable(column_info *cinfo, const gint col, const gboolean writable)
   }
 }
 
+void
+col_set_wanted(column_info *cinfo, const gint col, const gboolean wanted)
+{
+  if (cinfo && col >= 0 && col < cinfo->num_cols)
+    cinfo->columns[col].wanted = wanted;
+}
+
 /* Checks to see if a particular packet information element is needed for the packet list */
 #define CHECK_COL(cinfo, el) \
     /* We are constructing columns, and they're writable */ \
@@ -357,6 +365,7 @@ void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo)
        i <= cinfo->col_last[COL_CUSTOM]; i++) {
     col_item = &cinfo->columns[i];
     if (col_item->fmt_matx[COL_CUSTOM] &&
+        col_item->wanted &&
         col_item->col_custom_fields &&
         col_item->col_custom_fields_ids) {
         col_item->col_data = col_item->col_buf;
@@ -1891,6 +1900,8 @@ col_fill_in(packet_info *pinfo, const gboolean fill_col_exprs, const gboolean fi
 
   for (i = 0; i < pinfo->cinfo->num_cols; i++) {
     col_item = &pinfo->cinfo->columns[i];
+    if (!col_item->wanted)
+      continue;
     if (col_based_on_frame_data(pinfo->cinfo, i)) {
       if (fill_fd_colums)
         col_fill_in_frame_data(pinfo->fd, pinfo->cinfo, i, fill_col_exprs);
@@ -109,6 +109,17 @@ WS_DLL_PUBLIC gboolean col_get_writable(column_info *cinfo, const gint col);
  */
 WS_DLL_PUBLIC void col_set_writable(column_info *cinfo, const gint col, const gboolean writable);
 
+/** Say whether the consumer of the columns needs a column. Columns that
+ * aren't wanted start each packet unwritable and aren't filled in, so
+ * the col_...() calls for them return without formatting anything and
+ * their text stays empty. All columns are wanted after col_setup().
+ *
+ * @param cinfo the column information
+ * @param col the column number (not format)
+ * @param wanted TRUE if the column's text is needed, FALSE if not
+ */
+WS_DLL_PUBLIC void col_set_wanted(column_info *cinfo, const gint col, const gboolean wanted);
+
 /** Sets a fence for the current column content,
  * so this content won't be affected by further col_... function calls.
  *
@@ -105,8 +105,46 @@ static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
  */
 static wmem_map_t *conversation_hashtable_id = NULL;
 
+/*
+ * Index of the exact address/port conversations between two IPv4 or two
+ * IPv6 addresses, by far the most common kind.  Looking these up in
+ * conversation_hashtable_exact_addr_port means hashing and comparing the
+ * element lists; here the key is stored inline next to its hash, in an
+ * open-addressing table with linear probing, so that a lookup usually
+ * touches a single cache line.  The hash table remains authoritative;
+ * the index only maps keys to the heads of their chains, and is kept in
+ * step with it by conversation_map_insert() and conversation_map_steal().
+ */
+typedef struct {
+    conversation_t *chain_head;     /* NULL if the slot is empty */
+    guint32 hash;
+    guint32 port1;
+    guint32 port2;
+    conversation_type ctype;
+    guint8  addr_len;               /* 4 for IPv4, 16 for IPv6 */
+    guint8  addr1[16];
+    guint8  addr2[16];
+} conversation_tuple_t;
+
+/* The index is allocated in file scope, and reset with it. */
+static conversation_tuple_t *tuple_index = NULL;
+static guint tuple_index_size = 0;          /* Always a power of two */
+static guint tuple_index_count = 0;
+
+#define TUPLE_INDEX_MIN_SIZE 1024
+
 static guint32 new_index;
 
+/*
+ * Functions that free protocol data when conversations expire.
+ */
+typedef struct {
+    int proto;
+    conversation_proto_data_free_func free_func;
+} proto_data_free_func_t;
+
+static wmem_array_t *proto_data_free_funcs = NULL;
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -463,6 +501,195 @@ conversation_match_element_list(gconstpointer v1, gconstpointer v2)
     return TRUE;
 }
 
+/*
+ * Fill in a tuple from an exact address/port key, if it is one that
+ * the index holds.
+ */
+static bool
+conversation_tuple_from_key(const conversation_element_t *key, conversation_tuple_t *tuple)
+{
+    const address *addr1 = &key[ADDR1_IDX].addr_val;
+    const address *addr2 = &key[ADDR2_IDX].addr_val;
+    const guint8 *data;
+    guint32 hash, word;
+
+    if (key[ADDR1_IDX].type != CE_ADDRESS || key[PORT1_IDX].type != CE_PORT
+            || key[ADDR2_IDX].type != CE_ADDRESS || key[PORT2_IDX].type != CE_PORT
+            || key[ENDP_EXACT_IDX].type != CE_CONVERSATION_TYPE) {
+        return false;
+    }
+
+    if (addr1->type != addr2->type || addr1->len != addr2->len)
+        return false;
+    if (!((addr1->type == AT_IPv4 && addr1->len == 4) ||
+          (addr1->type == AT_IPv6 && addr1->len == 16)))
+        return false;
+
+    tuple->port1 = key[PORT1_IDX].port_val;
+    tuple->port2 = key[PORT2_IDX].port_val;
+    tuple->ctype = key[ENDP_EXACT_IDX].conversation_type_val;
+    tuple->addr_len = (guint8)addr1->len;
+    memcpy(tuple->addr1, addr1->data, addr1->len);
+    memcpy(tuple->addr2, addr2->data, addr2->len);
+
+    /* Mix in 32 bits at a time; this is cheap and good enough for
+     * linear probing. */
+    hash = (guint32)tuple->ctype * 0x9e3779b1;
+    hash = (hash ^ tuple->port1) * 0x85ebca6b;
+    hash = (hash ^ tuple->port2) * 0xc2b2ae35;
+    for (data = tuple->addr1; data < tuple->addr1 + tuple->addr_len; data += 4) {
+        memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * 0x9e3779b1;
+        hash ^= hash >> 15;
+    }
+    for (data = tuple->addr2; data < tuple->addr2 + tuple->addr_len; data += 4) {
+        memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * 0x85ebca6b;
+        hash ^= hash >> 13;
+    }
+    tuple->hash = hash ^ (hash >> 16);
+
+    return true;
+}
+
+static inline bool
+conversation_tuple_equal(const conversation_tuple_t *t1, const conversation_tuple_t *t2)
+{
+    return t1->hash == t2->hash && t1->port1 == t2->port1 && t1->port2 == t2->port2
+        && t1->ctype == t2->ctype && t1->addr_len == t2->addr_len
+        && memcmp(t1->addr1, t2->addr1, t1->addr_len) == 0
+        && memcmp(t1->addr2, t2->addr2, t1->addr_len) == 0;
+}
+
+/*
+ * Return the slot holding a tuple, or the empty slot where it would go.
+ */
+static guint
+tuple_index_find(const conversation_tuple_t *tuple)
+{
+    guint mask = tuple_index_size - 1;
+    guint i = tuple->hash & mask;
+
+    while (tuple_index[i].chain_head != NULL && !conversation_tuple_equal(&tuple_index[i], tuple))
+        i = (i + 1) & mask;
+
+    return i;
+}
+
+static void
+tuple_index_grow(void)
+{
+    conversation_tuple_t *old_index = tuple_index;
+    guint old_size = tuple_index_size;
+
+    tuple_index_size = old_size ? old_size * 2 : TUPLE_INDEX_MIN_SIZE;
+    tuple_index = wmem_alloc0_array(wmem_file_scope(), conversation_tuple_t, tuple_index_size);
+
+    for (guint i = 0; i < old_size; i++) {
+        if (old_index[i].chain_head != NULL)
+            tuple_index[tuple_index_find(&old_index[i])] = old_index[i];
+    }
+    wmem_free(wmem_file_scope(), old_index);
+}
+
+static bool
+tuple_index_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
+        void *user_data _U_)
+{
+    tuple_index = NULL;
+    tuple_index_size = 0;
+    tuple_index_count = 0;
+
+    return true;
+}
+
+/*
+ * Look up the chain head for a key in the index.  Returns false if the
+ * key is not one the index holds, in which case the hash table must be
+ * searched instead.
+ */
+static bool
+tuple_index_lookup(const conversation_element_t *key, conversation_t **chain_head)
+{
+    conversation_tuple_t tuple;
+
+    if (!conversation_tuple_from_key(key, &tuple))
+        return false;
+
+    *chain_head = tuple_index ? tuple_index[tuple_index_find(&tuple)].chain_head : NULL;
+    return true;
+}
+
+static void
+tuple_index_insert(const conversation_element_t *key, conversation_t *chain_head)
+{
+    conversation_tuple_t tuple;
+    guint i;
+
+    if (!conversation_tuple_from_key(key, &tuple))
+        return;
+
+    /* Keep the load factor under one half so that probes stay short. */
+    if (tuple_index_count >= tuple_index_size / 2)
+        tuple_index_grow();
+
+    i = tuple_index_find(&tuple);
+    if (tuple_index[i].chain_head == NULL) {
+        tuple_index_count++;
+    }
+    tuple.chain_head = chain_head;
+    tuple_index[i] = tuple;
+}
+
+static void
+tuple_index_remove(const conversation_element_t *key)
+{
+    conversation_tuple_t tuple;
+    guint mask, i, j, home;
+
+    if (tuple_index == NULL || !conversation_tuple_from_key(key, &tuple))
+        return;
+
+    i = tuple_index_find(&tuple);
+    if (tuple_index[i].chain_head == NULL)
+        return;
+    tuple_index[i].chain_head = NULL;
+    tuple_index_count--;
+
+    /* Move back any entries that would no longer be found past the gap. */
+    mask = tuple_index_size - 1;
+    for (j = (i + 1) & mask; tuple_index[j].chain_head != NULL; j = (j + 1) & mask) {
+        home = tuple_index[j].hash & mask;
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            tuple_index[i] = tuple_index[j];
+            tuple_index[j].chain_head = NULL;
+            i = j;
+        }
+    }
+}
+
+/*
+ * Set the chain head for a key in a conversation hash table.
+ */
+static void
+conversation_map_insert(wmem_map_t *hashtable, conversation_t *chain_head)
+{
+    wmem_map_insert(hashtable, chain_head->key_ptr, chain_head);
+    if (hashtable == conversation_hashtable_exact_addr_port)
+        tuple_index_insert(chain_head->key_ptr, chain_head);
+}
+
+/*
+ * Remove a key from a conversation hash table without freeing it.
+ */
+static void
+conversation_map_steal(wmem_map_t *hashtable, conversation_element_t *key)
+{
+    wmem_map_steal(hashtable, key);
+    if (hashtable == conversation_hashtable_exact_addr_port)
+        tuple_index_remove(key);
+}
+
 /**
  * Create a new hash tables for conversations.
  */
@@ -492,6 +719,7 @@ conversation_init(void)
                                                                     conversation_match_element_list);
     wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), exact_map_key),
                     conversation_hashtable_exact_addr_port);
+    wmem_register_callback(wmem_file_scope(), tuple_index_reset_cb, NULL);
 
     conversation_element_t addrs_elements[ADDRS_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
@@ -585,7 +813,7 @@ conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
         conv->next = NULL;
         conv->last = conv;
 
-        wmem_map_insert(hashtable, conv->key_ptr, conv);
+        conversation_map_insert(hashtable, conv);
         DPRINT(("created a new conversation chain"));
     }
     else {
@@ -614,7 +842,7 @@ conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
                 conv->next = chain_head;
                 conv->last = chain_tail;
                 chain_head->last = NULL;
-                wmem_map_insert(hashtable, conv->key_ptr, conv);
+                conversation_map_insert(hashtable, conv);
             }
             else {
                 /* Inserting into the middle of the chain */
@@ -637,6 +865,11 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 
     chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
 
+    if (chain_head == NULL) {
+        /* XXX: Conversation not found. Wrong hashtable, or expired? */
+        return;
+    }
+
     if (conv == chain_head) {
         /* We are currently the front of the chain */
         if (NULL == conv->next) {
@@ -644,7 +877,7 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
              * update next pointer, but do not call
              * wmem_map_remove() either because the conv data
              * will be re-inserted. */
-            wmem_map_steal(hashtable, conv->key_ptr);
+            conversation_map_steal(hashtable, conv->key_ptr);
         }
         else {
             /* Update the head of the chain */
@@ -656,7 +889,7 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
             else
                 chain_head->latest_found = conv->latest_found;
 
-            wmem_map_insert(hashtable, chain_head->key_ptr, chain_head);
+            conversation_map_insert(hashtable, chain_head);
         }
     }
     else {
@@ -1035,7 +1268,11 @@ static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_ha
     conversation_t* convo = NULL;
     conversation_t* match = NULL;
     conversation_t* chain_head = NULL;
-    chain_head = (conversation_t *)wmem_map_lookup(conversation_hashtable, conv_key);
+
+    if (conversation_hashtable != conversation_hashtable_exact_addr_port ||
+            !tuple_index_lookup(conv_key, &chain_head)) {
+        chain_head = (conversation_t *)wmem_map_lookup(conversation_hashtable, conv_key);
+    }
 
     if (chain_head && (chain_head->setup_frame <= frame_num)) {
         match = chain_head;
@@ -1055,6 +1292,8 @@ static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_ha
 
     if (match) {
         chain_head->latest_found = match;
+        if (frame_num > match->last_lookup_frame)
+            match->last_lookup_frame = frame_num;
     }
 
     return match;
@@ -1621,6 +1860,110 @@ conversation_delete_proto_data(conversation_t *conv, const int proto)
         wmem_tree_remove32(conv->data_list, proto);
 }
 
+void
+conversation_set_proto_data_free_func(const int proto, conversation_proto_data_free_func free_func)
+{
+    proto_data_free_func_t entry = { proto, free_func };
+
+    if (proto_data_free_funcs == NULL)
+        proto_data_free_funcs = wmem_array_new(wmem_epan_scope(), sizeof(proto_data_free_func_t));
+    wmem_array_append_one(proto_data_free_funcs, entry);
+}
+
+void
+conversation_add_frame(conversation_t *conv, const guint32 frame_num)
+{
+    guint count;
+
+    if (conv->frames == NULL)
+        conv->frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+
+    count = wmem_array_get_count(conv->frames);
+    if (count > 0 && *(guint32 *)wmem_array_index(conv->frames, count - 1) >= frame_num)
+        return;
+    wmem_array_append_one(conv->frames, frame_num);
+}
+
+const guint32 *
+conversation_get_frames(const conversation_t *conv, guint *num_frames)
+{
+    if (conv->frames == NULL) {
+        *num_frames = 0;
+        return NULL;
+    }
+    *num_frames = wmem_array_get_count(conv->frames);
+    return (const guint32 *)wmem_array_get_raw(conv->frames);
+}
+
+/*
+ * Unlink an idle conversation and drop everything associated with it.
+ */
+static void
+conversation_expire(wmem_map_t *hashtable, conversation_t *conv)
+{
+    conversation_remove_from_hashtable(hashtable, conv);
+
+    if (conv->data_list != NULL) {
+        if (proto_data_free_funcs != NULL) {
+            for (guint i = 0; i < wmem_array_get_count(proto_data_free_funcs); i++) {
+                proto_data_free_func_t *entry = (proto_data_free_func_t *)wmem_array_index(proto_data_free_funcs, i);
+                void *proto_data = wmem_tree_lookup32(conv->data_list, entry->proto);
+
+                if (proto_data != NULL) {
+                    wmem_tree_remove32(conv->data_list, entry->proto);
+                    entry->free_func(conv, proto_data);
+                }
+            }
+        }
+        wmem_tree_destroy(conv->data_list, FALSE, FALSE);
+        conv->data_list = NULL;
+    }
+    if (conv->dissector_tree != NULL) {
+        wmem_tree_destroy(conv->dissector_tree, FALSE, FALSE);
+        conv->dissector_tree = NULL;
+    }
+}
+
+static void
+collect_hashtable(gpointer key _U_, gpointer value, gpointer user_data)
+{
+    g_ptr_array_add((GPtrArray *)user_data, value);
+}
+
+void
+conversation_expire_idle(const guint32 frame_num)
+{
+    GPtrArray *hashtables = g_ptr_array_new();
+    GPtrArray *chains = g_ptr_array_new();
+    GPtrArray *idle = g_ptr_array_new();
+
+    wmem_map_foreach(conversation_hashtable_element_list, collect_hashtable, hashtables);
+
+    for (guint i = 0; i < hashtables->len; i++) {
+        wmem_map_t *hashtable = (wmem_map_t *)g_ptr_array_index(hashtables, i);
+
+        /* Removing conversations changes the chain heads in the table,
+         * so find them all first. */
+        g_ptr_array_set_size(chains, 0);
+        wmem_map_foreach(hashtable, collect_hashtable, chains);
+
+        for (guint j = 0; j < chains->len; j++) {
+            g_ptr_array_set_size(idle, 0);
+            for (conversation_t *conv = (conversation_t *)g_ptr_array_index(chains, j); conv; conv = conv->next) {
+                if (conv->last_frame < frame_num && conv->last_lookup_frame < frame_num)
+                    g_ptr_array_add(idle, conv);
+            }
+            for (guint k = 0; k < idle->len; k++) {
+                conversation_expire(hashtable, (conversation_t *)g_ptr_array_index(idle, k));
+            }
+        }
+    }
+
+    g_ptr_array_free(idle, TRUE);
+    g_ptr_array_free(chains, TRUE);
+    g_ptr_array_free(hashtables, TRUE);
+}
+
 void
 conversation_set_dissector_from_frame_number(conversation_t *conversation,
         const guint32 starting_frame_num, const dissector_handle_t handle)
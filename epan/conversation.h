@@ -211,10 +211,12 @@ typedef struct conversation {
     guint32 setup_frame;		/** frame number that setup this conversation */
     /* Assume that setup_frame is also the lowest frame number for now. */
     guint32 last_frame;		/** highest frame number in this conversation */
+    guint32 last_lookup_frame;	/** highest frame number this conversation was looked up for */
     wmem_tree_t *data_list;		/** list of data associated with conversation */
     wmem_tree_t *dissector_tree;	/** tree containing protocol dissector client associated with conversation */
     guint	options;		/** wildcard flags */
     conversation_element_t *key_ptr;	/** Keys are conversation element arrays terminated with a CE_CONVERSATION_TYPE */
+    wmem_array_t *frames;		/** frames added with conversation_add_frame(), NULL if none */
 } conversation_t;
 
 /*
@@ -269,6 +271,16 @@ extern void conversation_init(void);
  */
 extern void conversation_epan_reset(void);
 
+/**
+ * Remove from the conversation tables every conversation that has not
+ * been seen or looked up since before the given frame, freeing the data
+ * associated with it, for long-running single-pass captures.  The
+ * conversation_t structures themselves are kept, so that pointers to them
+ * stay valid, but they are no longer found by lookups.
+ * @param frame_num The first frame that isn't idle.
+ */
+extern void conversation_expire_idle(const guint32 frame_num);
+
 /**
  * Create a new conversation identified by a list of elements.
  * @param setup_frame The first frame in the conversation.
@@ -404,6 +416,36 @@ WS_DLL_PUBLIC void *conversation_get_proto_data(const conversation_t *conv, cons
  */
 WS_DLL_PUBLIC void conversation_delete_proto_data(conversation_t *conv, const int proto);
 
+/** Function called to free the data a protocol associated with a
+ * conversation when the conversation expires.
+ */
+typedef void (*conversation_proto_data_free_func)(conversation_t *conv, void *proto_data);
+
+/** Register a function that frees the data a protocol associates with
+ * conversations, when idle conversations are expired (see
+ * epan_set_idle_timeout()).  The data of protocols that don't register
+ * one is kept until the capture file is closed.
+ * @param proto Protocol ID.
+ * @param free_func Function called with the data when it is dropped.
+ */
+WS_DLL_PUBLIC void conversation_set_proto_data_free_func(const int proto, conversation_proto_data_free_func free_func);
+
+/** Record that a frame belongs to a conversation, so that the frames of
+ * the conversation can be processed again without reading the others
+ * (see cf_retap_packets_for_frames()). Frames must be added in
+ * increasing order; adding the most recent one again does nothing.
+ * @param conv Conversation.
+ * @param frame_num Frame number.
+ */
+WS_DLL_PUBLIC void conversation_add_frame(conversation_t *conv, const guint32 frame_num);
+
+/** Get the frames recorded with conversation_add_frame().
+ * @param conv Conversation.
+ * @param num_frames Set to the number of frames.
+ * @return The frame numbers in increasing order, or NULL if there are none.
+ */
+WS_DLL_PUBLIC const guint32 *conversation_get_frames(const conversation_t *conv, guint *num_frames);
+
 WS_DLL_PUBLIC void conversation_set_dissector(conversation_t *conversation, const dissector_handle_t handle);
 
 WS_DLL_PUBLIC void conversation_set_dissector_from_frame_number(conversation_t *conversation,
@@ -206,6 +206,186 @@ guint conversation_table_get_num(void)
     return wmem_tree_count(registered_ct_tables);
 }
 
+/*
+ * Open addressing index for conversations and endpoints whose addresses
+ * have a small fixed size, which is what the bulk of any large capture
+ * consists of. The keys are stored inline in the slots, so a new entry
+ * costs no allocations beyond the occasional doubling of the table, and
+ * they are hashed with the seeded wmem_strong_hash() so that crafted
+ * traffic can't force long probe sequences.
+ *
+ * Conversation keys are stored with their endpoints in a canonical order,
+ * so a single probe finds a conversation in either direction.
+ */
+#define CT_FIXED_ADDR_LEN       16
+#define CT_FIXED_INITIAL_SIZE   1024
+#define CT_FIXED_SWAPPED        0x80000000U
+
+typedef struct {
+    conv_id_t   conv_id;
+    guint32     port1;
+    guint32     port2;
+    guint8      type;
+    guint8      len;
+    guint8      addr1[CT_FIXED_ADDR_LEN];
+    guint8      addr2[CT_FIXED_ADDR_LEN];
+} ct_fixed_key_t;
+
+typedef struct {
+    guint32         hash;
+    guint32         entry;  /* 0 if unused, else (array index + 1) | CT_FIXED_SWAPPED if the key's endpoints are swapped */
+    ct_fixed_key_t  key;
+} ct_fixed_slot_t;
+
+struct _ct_fixed_table_t {
+    ct_fixed_slot_t *slots;
+    guint32         mask;   /* number of slots - 1 */
+    guint32         count;
+};
+
+static gboolean
+ct_fixed_address(const address *addr)
+{
+    switch (addr->type) {
+    case AT_IPv4:
+    case AT_IPv6:
+    case AT_ETHER:
+        return addr->len > 0 && addr->len <= CT_FIXED_ADDR_LEN;
+    default:
+        return FALSE;
+    }
+}
+
+/*
+ * Fill in the key for a conversation, if its addresses can be stored inline.
+ * *swapped is set if dst/dst_port come first in the key.
+ */
+static gboolean
+ct_fixed_conversation_key(ct_fixed_key_t *key, gboolean *swapped,
+        const address *src, const address *dst, guint32 src_port, guint32 dst_port, conv_id_t conv_id)
+{
+    int cmp;
+
+    if (!ct_fixed_address(src) || src->type != dst->type || src->len != dst->len) {
+        return FALSE;
+    }
+
+    cmp = memcmp(src->data, dst->data, src->len);
+    if (cmp == 0) {
+        cmp = (src_port > dst_port) - (src_port < dst_port);
+    }
+    *swapped = cmp > 0;
+
+    memset(key, 0, sizeof(*key));
+    key->conv_id = conv_id;
+    key->type = (guint8)src->type;
+    key->len = (guint8)src->len;
+    if (*swapped) {
+        key->port1 = dst_port;
+        key->port2 = src_port;
+        memcpy(key->addr1, dst->data, dst->len);
+        memcpy(key->addr2, src->data, src->len);
+    } else {
+        key->port1 = src_port;
+        key->port2 = dst_port;
+        memcpy(key->addr1, src->data, src->len);
+        memcpy(key->addr2, dst->data, dst->len);
+    }
+    return TRUE;
+}
+
+static gboolean
+ct_fixed_endpoint_key(ct_fixed_key_t *key, const address *addr, guint32 port)
+{
+    if (!ct_fixed_address(addr)) {
+        return FALSE;
+    }
+
+    memset(key, 0, sizeof(*key));
+    key->type = (guint8)addr->type;
+    key->len = (guint8)addr->len;
+    key->port1 = port;
+    memcpy(key->addr1, addr->data, addr->len);
+    return TRUE;
+}
+
+static struct _ct_fixed_table_t *
+ct_fixed_table_new(void)
+{
+    struct _ct_fixed_table_t *table = g_new(struct _ct_fixed_table_t, 1);
+
+    table->slots = g_new0(ct_fixed_slot_t, CT_FIXED_INITIAL_SIZE);
+    table->mask = CT_FIXED_INITIAL_SIZE - 1;
+    table->count = 0;
+    return table;
+}
+
+static void
+ct_fixed_table_free(struct _ct_fixed_table_t *table)
+{
+    if (table) {
+        g_free(table->slots);
+        g_free(table);
+    }
+}
+
+/*
+ * Return the slot holding key, or the unused slot where it belongs.
+ */
+static ct_fixed_slot_t *
+ct_fixed_table_lookup(struct _ct_fixed_table_t *table, const ct_fixed_key_t *key, guint32 hash)
+{
+    guint32 i = hash & table->mask;
+
+    for (;;) {
+        ct_fixed_slot_t *slot = &table->slots[i];
+        if (slot->entry == 0 ||
+                (slot->hash == hash && memcmp(&slot->key, key, sizeof(*key)) == 0)) {
+            return slot;
+        }
+        i = (i + 1) & table->mask;
+    }
+}
+
+static void
+ct_fixed_table_grow(struct _ct_fixed_table_t *table)
+{
+    ct_fixed_slot_t *old_slots = table->slots;
+    guint32 old_size = table->mask + 1;
+    guint32 i;
+
+    table->slots = g_new0(ct_fixed_slot_t, (gsize)old_size * 2);
+    table->mask = old_size * 2 - 1;
+    for (i = 0; i < old_size; i++) {
+        if (old_slots[i].entry != 0) {
+            guint32 j = old_slots[i].hash & table->mask;
+            while (table->slots[j].entry != 0) {
+                j = (j + 1) & table->mask;
+            }
+            table->slots[j] = old_slots[i];
+        }
+    }
+    g_free(old_slots);
+}
+
+/*
+ * Fill in a slot returned by ct_fixed_table_lookup(). The table may be
+ * resized, so the slot must not be used afterwards.
+ */
+static void
+ct_fixed_table_insert(struct _ct_fixed_table_t *table, ct_fixed_slot_t *slot,
+        const ct_fixed_key_t *key, guint32 hash, guint idx, gboolean swapped)
+{
+    slot->hash = hash;
+    slot->entry = (idx + 1) | (swapped ? CT_FIXED_SWAPPED : 0);
+    slot->key = *key;
+
+    /* Keep the load factor at or below 3/4 */
+    if (++table->count > table->mask - (table->mask >> 2)) {
+        ct_fixed_table_grow(table);
+    }
+}
+
 /** Compute the hash value for two given address/port pairs.
  * (Parameter type is gconstpointer for GHashTable compatibility.)
  *
@@ -285,9 +465,15 @@ reset_conversation_table_data(conv_hash_t *ch)
     if (ch->hashtable != NULL) {
         g_hash_table_destroy(ch->hashtable);
     }
+    ct_fixed_table_free(ch->fixed_table);
+    if (ch->addr_strings != NULL) {
+        g_hash_table_destroy(ch->addr_strings);
+    }
 
     ch->conv_array=NULL;
     ch->hashtable=NULL;
+    ch->fixed_table=NULL;
+    ch->addr_strings=NULL;
 }
 
 void reset_endpoint_table_data(conv_hash_t *ch)
@@ -309,9 +495,15 @@ void reset_endpoint_table_data(conv_hash_t *ch)
     if (ch->hashtable != NULL) {
         g_hash_table_destroy(ch->hashtable);
     }
+    ct_fixed_table_free(ch->fixed_table);
+    if (ch->addr_strings != NULL) {
+        g_hash_table_destroy(ch->addr_strings);
+    }
 
     ch->conv_array=NULL;
     ch->hashtable=NULL;
+    ch->fixed_table=NULL;
+    ch->addr_strings=NULL;
 }
 
 /* For backwards source and binary compatibility */
@@ -329,6 +521,58 @@ char *get_conversation_address(wmem_allocator_t *allocator, address *addr, gbool
     }
 }
 
+static guint
+ct_addr_string_hash(gconstpointer key)
+{
+    return add_address_to_hash(0, (const address *)key);
+}
+
+static gboolean
+ct_addr_string_equal(gconstpointer a, gconstpointer b)
+{
+    return addresses_equal((const address *)a, (const address *)b);
+}
+
+static void
+ct_addr_string_free_key(gpointer key)
+{
+    free_address((address *)key);
+    g_free(key);
+}
+
+const char *get_conversation_address_str(conv_hash_t *ch, const address *addr, gboolean resolve_names)
+{
+    const char *name;
+    address *key;
+    char *str;
+
+    if (resolve_names) {
+        /* Resolved names are already interned by addr_resolv, and can
+         * change as names get resolved, so don't cache them here. */
+        name = address_to_name(addr);
+        if (name != NULL) {
+            return name;
+        }
+        if (addr->type == AT_NONE) {
+            return "NONE";
+        }
+    }
+
+    if (ch->addr_strings == NULL) {
+        ch->addr_strings = g_hash_table_new_full(ct_addr_string_hash, ct_addr_string_equal,
+                                                 ct_addr_string_free_key, g_free);
+    }
+
+    str = (char *)g_hash_table_lookup(ch->addr_strings, addr);
+    if (str == NULL) {
+        key = g_new(address, 1);
+        copy_address(key, addr);
+        str = address_to_str(NULL, addr);
+        g_hash_table_insert(ch->addr_strings, key, str);
+    }
+    return str;
+}
+
 char *get_conversation_port(wmem_allocator_t *allocator, guint32 port, conversation_type ctype, gboolean resolve_names)
 {
 
@@ -646,11 +890,27 @@ add_conversation_table_data_with_conv_id(
 {
     conv_item_t *conv_item = NULL;
     gboolean is_fwd_direction = FALSE; /* direction of any conversation found */
+    ct_fixed_key_t fixed_key;
+    ct_fixed_slot_t *fixed_slot = NULL;
+    guint32 fixed_hash = 0;
+    gboolean fixed_swapped = FALSE;
 
     /* if we don't have any entries at all yet */
     if (ch->conv_array == NULL) {
         ch->conv_array = g_array_sized_new(FALSE, FALSE, sizeof(conv_item_t), 10000);
+    }
 
+    if (ct_fixed_conversation_key(&fixed_key, &fixed_swapped, src, dst, src_port, dst_port, conv_id)) {
+        if (ch->fixed_table == NULL) {
+            ch->fixed_table = ct_fixed_table_new();
+        }
+        fixed_hash = wmem_strong_hash((const guint8 *)&fixed_key, sizeof(fixed_key));
+        fixed_slot = ct_fixed_table_lookup(ch->fixed_table, &fixed_key, fixed_hash);
+        if (fixed_slot->entry != 0) {
+            conv_item = &g_array_index(ch->conv_array, conv_item_t, (fixed_slot->entry & ~CT_FIXED_SWAPPED) - 1);
+            is_fwd_direction = ((fixed_slot->entry & CT_FIXED_SWAPPED) != 0) == fixed_swapped;
+        }
+    } else if (ch->hashtable == NULL) {
         ch->hashtable = g_hash_table_new_full(conversation_hash,
                                               conversation_equal, /* key_equal_func */
                                               g_free,             /* key_destroy_func */
@@ -720,14 +980,18 @@ add_conversation_table_data_with_conv_id(
         conversation_idx = ch->conv_array->len - 1;
         conv_item = &g_array_index(ch->conv_array, conv_item_t, conversation_idx);
 
-        /* ct->conversations address is not a constant but src/dst_address.data are */
-        new_key = g_new(conv_key_t, 1);
-        set_address(&new_key->addr1, conv_item->src_address.type, conv_item->src_address.len, conv_item->src_address.data);
-        set_address(&new_key->addr2, conv_item->dst_address.type, conv_item->dst_address.len, conv_item->dst_address.data);
-        new_key->port1 = src_port;
-        new_key->port2 = dst_port;
-        new_key->conv_id = conv_id;
-        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
+        if (fixed_slot) {
+            ct_fixed_table_insert(ch->fixed_table, fixed_slot, &fixed_key, fixed_hash, conversation_idx, fixed_swapped);
+        } else {
+            /* ct->conversations address is not a constant but src/dst_address.data are */
+            new_key = g_new(conv_key_t, 1);
+            set_address(&new_key->addr1, conv_item->src_address.type, conv_item->src_address.len, conv_item->src_address.data);
+            set_address(&new_key->addr2, conv_item->dst_address.type, conv_item->dst_address.len, conv_item->dst_address.data);
+            new_key->port1 = src_port;
+            new_key->port2 = dst_port;
+            new_key->conv_id = conv_id;
+            g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
+        }
 
         /* update the conversation struct */
         conv_item->tx_frames_total += num_frames;
@@ -811,12 +1075,28 @@ void
 add_endpoint_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboolean sender, int num_frames, int num_bytes, et_dissector_info_t *et_info, endpoint_type etype)
 {
     endpoint_item_t *endpoint_item = NULL;
+    ct_fixed_key_t fixed_key;
+    ct_fixed_slot_t *fixed_slot = NULL;
+    guint32 fixed_hash = 0;
 
     /* XXX should be optimized to allocate n extra entries at a time
        instead of just one */
     /* if we don't have any entries at all yet */
     if(ch->conv_array==NULL){
         ch->conv_array=g_array_sized_new(FALSE, FALSE, sizeof(endpoint_item_t), 10000);
+    }
+
+    if (ct_fixed_endpoint_key(&fixed_key, addr, port)) {
+        if (ch->fixed_table == NULL) {
+            ch->fixed_table = ct_fixed_table_new();
+        }
+        fixed_hash = wmem_strong_hash((const guint8 *)&fixed_key, sizeof(fixed_key));
+        fixed_slot = ct_fixed_table_lookup(ch->fixed_table, &fixed_key, fixed_hash);
+        if (fixed_slot->entry != 0) {
+            endpoint_item = &g_array_index(ch->conv_array, endpoint_item_t, fixed_slot->entry - 1);
+        }
+    }
+    else if(ch->hashtable==NULL){
         ch->hashtable = g_hash_table_new_full(endpoint_hash,
                                               endpoint_match, /* key_equal_func */
                                               g_free,     /* key_destroy_func */
@@ -861,11 +1141,15 @@ add_endpoint_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboo
         endpoint_idx = ch->conv_array->len - 1;
         endpoint_item = &g_array_index(ch->conv_array, endpoint_item_t, endpoint_idx);
 
-        /* hl->hosts address is not a constant but address.data is */
-        new_key = g_new(endpoint_key_t,1);
-        set_address(&new_key->myaddress, endpoint_item->myaddress.type, endpoint_item->myaddress.len, endpoint_item->myaddress.data);
-        new_key->port = port;
-        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(endpoint_idx));
+        if (fixed_slot) {
+            ct_fixed_table_insert(ch->fixed_table, fixed_slot, &fixed_key, fixed_hash, endpoint_idx, FALSE);
+        } else {
+            /* hl->hosts address is not a constant but address.data is */
+            new_key = g_new(endpoint_key_t,1);
+            set_address(&new_key->myaddress, endpoint_item->myaddress.type, endpoint_item->myaddress.len, endpoint_item->myaddress.data);
+            new_key->port = port;
+            g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(endpoint_idx));
+        }
     }
 
     /* if this is a new endpoint we need to initialize the struct */
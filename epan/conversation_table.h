@@ -47,14 +47,20 @@ typedef enum {
     CONV_DIR_ANY_FROM_B
 } conv_direction_e;
 
+struct _ct_fixed_table_t;
+
 /** Conversation hash + value storage
  * Hash table keys are conv_key_t. Hash table values are indexes into conv_array.
+ * Entries with IPv4, IPv6 or Ethernet addresses are indexed by fixed_table
+ * instead, which keeps its keys inline.
  */
 typedef struct _conversation_hash_t {
     GHashTable  *hashtable;       /**< conversations hash table */
     GArray      *conv_array;      /**< array of conversation values */
     void        *user_data;       /**< "GUI" specifics (if necessary) */
     guint       flags;            /**< flags given to the tap packet */
+    struct _ct_fixed_table_t *fixed_table; /**< index for fixed size addresses */
+    GHashTable  *addr_strings;    /**< interned unresolved address strings */
 } conv_hash_t;
 
 /** Key for hash lookups */
@@ -290,6 +296,19 @@ WS_DLL_PUBLIC void dissector_hostlist_init(const char *opt_arg, void* userdata);
  */
 WS_DLL_PUBLIC char *get_conversation_address(wmem_allocator_t *allocator, address *addr, gboolean resolve_names);
 
+/** Get the string representation of an address without allocating it
+ *  each time.  Resolved names come from the name resolution tables and
+ *  other strings are interned in the table, so they're only formatted
+ *  once per address.
+ *
+ * @param ch The conversation hash table of the address.
+ * @param addr The address.
+ * @param resolve_names Enable name resolution.
+ * @return A string representing the address, valid until the table is
+ * reset or, for resolved names, until the name resolution tables are.
+ */
+WS_DLL_PUBLIC const char *get_conversation_address_str(conv_hash_t *ch, const address *addr, gboolean resolve_names);
+
 /** Get the string representation of a port.
  *
  * @param allocator The wmem allocator to use when allocating the string
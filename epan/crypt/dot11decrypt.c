@@ -112,32 +112,12 @@ extern const uint32_t crc32_table[256];
 extern "C" {
 #endif
 
-/**
- * It is a step of the PBKDF2 (specifically the PKCS #5 v2.0) defined in
- * the RFC 2898 to derive a key (used as PMK in WPA)
- * @param ppbytes [IN] pointer to a password (sequence of between 8 and
- * 63 ASCII encoded characters)
- * @param ssid [IN] pointer to the SSID string encoded in max 32 ASCII
- * encoded characters
- * @param iterations [IN] times to hash the password (4096 for WPA)
- * @param count [IN] ???
- * @param output [OUT] pointer to a preallocated buffer of
- * SHA1_DIGEST_LEN characters that will contain a part of the key
- */
-static int Dot11DecryptRsnaPwd2PskStep(
-    const uint8_t *ppbytes,
-    const unsigned passLength,
-    const char *ssid,
-    const size_t ssidLength,
-    const int iterations,
-    const int count,
-    unsigned char *output)
-    ;
-
 /**
  * It calculates the passphrase-to-PSK mapping reccomanded for use with
  * RSNAs. This implementation uses the PBKDF2 method defined in the RFC
- * 2898.
+ * 2898. Derived PSKs are cached in the context, since with a wildcard
+ * SSID they are needed again for every handshake.
+ * @param ctx [IN] pointer to the current context
  * @param userPwd [IN] pointer to the struct containing a password
  * (octet string between 8 and 63 octets) and optional SSID octet
  * string of up to 32 octets (both are usually ASCII but in fact
@@ -147,6 +127,7 @@ static int Dot11DecryptRsnaPwd2PskStep(
  * Described in 802.11i-2004, page 165
  */
 static int Dot11DecryptRsnaPwd2Psk(
+    PDOT11DECRYPT_CONTEXT ctx,
     const struct DOT11DECRYPT_KEY_ITEMDATA_PWD *userPwd,
     unsigned char *output)
     ;
@@ -1078,7 +1059,7 @@ int Dot11DecryptSetKeys(
     for (i=0, success=0; i<(int)keys_nr; i++) {
         if (Dot11DecryptValidateKey(keys+i)==true) {
             if (keys[i].KeyType==DOT11DECRYPT_KEY_TYPE_WPA_PWD) {
-                Dot11DecryptRsnaPwd2Psk(&keys[i].UserPwd, keys[i].KeyData.Wpa.Psk);
+                Dot11DecryptRsnaPwd2Psk(ctx, &keys[i].UserPwd, keys[i].KeyData.Wpa.Psk);
                 keys[i].KeyData.Wpa.PskLen = DOT11DECRYPT_WPA_PWD_PSK_LEN;
             }
             memcpy(&ctx->keys[success], &keys[i], sizeof(keys[i]));
@@ -1149,9 +1130,13 @@ int Dot11DecryptSetLastSSID(
 static unsigned
 Dot11DecryptSaHash(gconstpointer key)
 {
-    GBytes *bytes = g_bytes_new_static(key, sizeof(DOT11DECRYPT_SEC_ASSOCIATION_ID));
-    unsigned hash = g_bytes_hash(bytes);
-    g_bytes_unref(bytes);
+    /* Same hash as g_bytes_hash(), without allocating a GBytes per lookup */
+    const uint8_t *p = (const uint8_t *)key;
+    unsigned hash = 5381;
+
+    for (size_t i = 0; i < sizeof(DOT11DECRYPT_SEC_ASSOCIATION_ID); i++) {
+        hash = (hash << 5) + hash + p[i];
+    }
     return hash;
 }
 
@@ -1178,6 +1163,11 @@ int Dot11DecryptInitContext(
     if (ctx->sa_hash == NULL) {
         return DOT11DECRYPT_RET_UNSUCCESS;
     }
+    /* Derived PSKs stay valid when the keys are set again */
+    if (ctx->psk_hash == NULL) {
+        ctx->psk_hash = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                              (GDestroyNotify)g_bytes_unref, g_free);
+    }
 
     ws_debug("Context initialized!");
     return DOT11DECRYPT_RET_SUCCESS;
@@ -1193,6 +1183,10 @@ int Dot11DecryptDestroyContext(
 
     Dot11DecryptCleanKeys(ctx);
     Dot11DecryptCleanSecAssoc(ctx);
+    if (ctx->psk_hash != NULL) {
+        g_hash_table_destroy(ctx->psk_hash);
+        ctx->psk_hash = NULL;
+    }
 
     ws_debug("Context destroyed!");
     return DOT11DECRYPT_RET_SUCCESS;
@@ -1684,7 +1678,7 @@ Dot11DecryptRsna4WHandshake(
                 memcpy(&pkt_key, tmp_key, sizeof(pkt_key));
                 memcpy(&pkt_key.UserPwd.Ssid, ctx->pkt_ssid, ctx->pkt_ssid_len);
                 pkt_key.UserPwd.SsidLen = ctx->pkt_ssid_len;
-                Dot11DecryptRsnaPwd2Psk(&pkt_key.UserPwd, pkt_key.KeyData.Wpa.Psk);
+                Dot11DecryptRsnaPwd2Psk(ctx, &pkt_key.UserPwd, pkt_key.KeyData.Wpa.Psk);
                 tmp_pkt_key = &pkt_key;
             } else {
                 tmp_pkt_key = tmp_key;
@@ -1893,7 +1887,7 @@ Dot11DecryptScanFtAssocForKeys(
             memcpy(&pkt_key, tmp_key, sizeof(pkt_key));
             memcpy(&pkt_key.UserPwd.Ssid, ctx->pkt_ssid, ctx->pkt_ssid_len);
             pkt_key.UserPwd.SsidLen = ctx->pkt_ssid_len;
-            Dot11DecryptRsnaPwd2Psk(&pkt_key.UserPwd, pkt_key.KeyData.Wpa.Psk);
+            Dot11DecryptRsnaPwd2Psk(ctx, &pkt_key.UserPwd, pkt_key.KeyData.Wpa.Psk);
             tmp_pkt_key = &pkt_key;
         } else {
             tmp_pkt_key = tmp_key;
@@ -2646,69 +2640,54 @@ Dot11DecryptFtDerivePtk(
 #define MAX_SSID_LENGTH 32 /* maximum SSID length */
 
 static int
-Dot11DecryptRsnaPwd2PskStep(
-    const uint8_t *ppBytes,
-    const unsigned ppLength,
-    const char *ssid,
-    const size_t ssidLength,
-    const int iterations,
-    const int count,
+Dot11DecryptRsnaPwd2Psk(
+    PDOT11DECRYPT_CONTEXT ctx,
+    const struct DOT11DECRYPT_KEY_ITEMDATA_PWD *userPwd,
     unsigned char *output)
 {
-    unsigned char digest[MAX_SSID_LENGTH+4] = { 0 };  /* SSID plus 4 bytes of count */
-    int i, j;
+    GByteArray *id_ba;
+    GBytes *id;
+    const unsigned char *psk;
+    unsigned char pw_len;
 
-    if (ssidLength > MAX_SSID_LENGTH) {
+    if (userPwd->SsidLen > MAX_SSID_LENGTH) {
         /* This "should not happen" */
         return DOT11DECRYPT_RET_UNSUCCESS;
     }
 
-    /* U1 = PRF(P, S || int(i)) */
-    memcpy(digest, ssid, ssidLength);
-    digest[ssidLength] = (unsigned char)((count>>24) & 0xff);
-    digest[ssidLength+1] = (unsigned char)((count>>16) & 0xff);
-    digest[ssidLength+2] = (unsigned char)((count>>8) & 0xff);
-    digest[ssidLength+3] = (unsigned char)(count & 0xff);
-    if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, (uint32_t) ssidLength + 4, ppBytes, ppLength)) {
-      return DOT11DECRYPT_RET_UNSUCCESS;
+    /* Cache key: passphrase length, passphrase and SSID */
+    pw_len = (unsigned char)userPwd->PassphraseLen;
+    id_ba = g_byte_array_new();
+    g_byte_array_append(id_ba, &pw_len, 1);
+    g_byte_array_append(id_ba, (const uint8_t *)userPwd->Passphrase, (unsigned)userPwd->PassphraseLen);
+    g_byte_array_append(id_ba, (const uint8_t *)userPwd->Ssid, (unsigned)userPwd->SsidLen);
+    id = g_byte_array_free_to_bytes(id_ba);
+
+    psk = ctx->psk_hash ? (const unsigned char *)g_hash_table_lookup(ctx->psk_hash, id) : NULL;
+    if (psk != NULL) {
+        memcpy(output, psk, DOT11DECRYPT_WPA_PWD_PSK_LEN);
+        g_bytes_unref(id);
+        return DOT11DECRYPT_RET_SUCCESS;
     }
 
-    /* output = U1 */
-    memcpy(output, digest, 20);
-    for (i = 1; i < iterations; i++) {
-        /* Un = PRF(P, Un-1) */
-        if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, HASH_SHA1_LENGTH, ppBytes, ppLength)) {
-          return DOT11DECRYPT_RET_UNSUCCESS;
-        }
+    /* PSK = PBKDF2(HMAC-SHA1, passphrase, ssid, 4096, 256) */
+    if (gcry_kdf_derive(userPwd->Passphrase, userPwd->PassphraseLen,
+                        GCRY_KDF_PBKDF2, GCRY_MD_SHA1,
+                        userPwd->Ssid, userPwd->SsidLen, 4096,
+                        DOT11DECRYPT_WPA_PWD_PSK_LEN, output)) {
+        g_bytes_unref(id);
+        return DOT11DECRYPT_RET_UNSUCCESS;
+    }
 
-        /* output = output xor Un */
-        for (j = 0; j < 20; j++) {
-            output[j] ^= digest[j];
-        }
+    if (ctx->psk_hash) {
+        g_hash_table_insert(ctx->psk_hash, id, g_memdup2(output, DOT11DECRYPT_WPA_PWD_PSK_LEN));
+    } else {
+        g_bytes_unref(id);
     }
 
     return DOT11DECRYPT_RET_SUCCESS;
 }
 
-static int
-Dot11DecryptRsnaPwd2Psk(
-    const struct DOT11DECRYPT_KEY_ITEMDATA_PWD *userPwd,
-    unsigned char *output)
-{
-    unsigned char m_output[40] = { 0 };
-    GByteArray *pp_ba = g_byte_array_new();
-
-    g_byte_array_append(pp_ba, userPwd->Passphrase, (unsigned)userPwd->PassphraseLen);
-
-    Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, userPwd->Ssid, userPwd->SsidLen, 4096, 1, m_output);
-    Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, userPwd->Ssid, userPwd->SsidLen, 4096, 2, &m_output[20]);
-
-    memcpy(output, m_output, DOT11DECRYPT_WPA_PWD_PSK_LEN);
-    g_byte_array_free(pp_ba, true);
-
-    return 0;
-}
-
 /*
  * Returns the decryption_key_t struct given a string describing the key.
  * Returns NULL if the input_string cannot be parsed.
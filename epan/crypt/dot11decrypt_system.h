@@ -123,6 +123,7 @@ typedef struct _DOT11DECRYPT_SEC_ASSOCIATION {
 
 typedef struct _DOT11DECRYPT_CONTEXT {
 	GHashTable *sa_hash;
+	GHashTable *psk_hash;	/* PSKs derived from passphrases, by passphrase and SSID */
 	DOT11DECRYPT_KEY_ITEM keys[DOT11DECRYPT_MAX_KEYS_NR];
 	size_t keys_nr;
 	char pkt_ssid[DOT11DECRYPT_WPA_SSID_MAX_LEN];
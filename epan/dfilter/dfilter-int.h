@@ -24,6 +24,7 @@ typedef struct {
 
 typedef struct {
 	GPtrArray *array;
+	GPtrArray *spare; /* Emptied array kept for the next run */
 } df_cell_t;
 
 typedef struct {
@@ -33,6 +34,8 @@ typedef struct {
 
 /* Passed back to user */
 struct epan_dfilter {
+	/* Compiled filters are shared through the compile cache. */
+	unsigned	refcount;
 	GPtrArray	*insns;
 	unsigned	num_registers;
 	df_cell_t	*registers;
@@ -47,8 +50,32 @@ struct epan_dfilter {
 	/* Used to pass arguments to functions. List of Lists (list of registers). */
 	GSList		*function_stack;
 	GSList		*set_stack;
+	/* Filter set the filter is being applied through, or NULL. */
+	struct epan_dfilter_set *set;
+	/* Serial number of the set the slots belong to, 0 if none. */
+	unsigned	set_serial;
+	/* For each instruction, its result slot in the set, or -1. */
+	int		*set_slots;
+	/* Execution statistics, if they are being collected. */
+	struct dfvm_profile *profile;
 };
 
+/* Results of the shareable tests of all the filters applied
+ * through the set since the last dfilter_set_reset(). */
+struct epan_dfilter_set {
+	unsigned	serial;
+	/* The first instruction seen for each slot, to match the
+	 * instructions of other filters against. */
+	GPtrArray	*tests;
+	/* One of DF_SET_RESULT_* for each slot. */
+	uint8_t		*results;
+	unsigned	results_size;
+};
+
+#define DF_SET_RESULT_UNKNOWN	0
+#define DF_SET_RESULT_FALSE	1
+#define DF_SET_RESULT_TRUE	2
+
 typedef struct {
 	df_error_t *error;
 	/* more fields. */
@@ -196,6 +223,15 @@ WS_DLL_PUBLIC
 void
 df_cell_clear(df_cell_t *rp);
 
+/* Like df_cell_clear() but keeps the (emptied) array to be reused by the
+ * next df_cell_init(). Nothing else may hold a reference to the array. */
+void
+df_cell_recycle(df_cell_t *rp);
+
+/* Frees the array kept by df_cell_recycle(). */
+void
+df_cell_free_spare(df_cell_t *rp);
+
 /* Cell must not be cleared while iter is alive. */
 WS_DLL_PUBLIC
 void
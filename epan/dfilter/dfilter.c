@@ -19,6 +19,7 @@
 #include "dfvm.h"
 #include <epan/epan_dissect.h>
 #include <epan/exceptions.h>
+#include <epan/prefs.h>
 #include "dfilter.h"
 #include "dfunctions.h"
 #include "dfilter-macro.h"
@@ -26,6 +27,7 @@
 #include "scanner_lex.h"
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 #include "grammar.h"
 
 
@@ -34,6 +36,37 @@
 /* Holds the singular instance of our Lemon parser object */
 static void*	ParserObj = NULL;
 
+/*
+ * Recently compiled filters, most recently used first, so that compiling
+ * the same text again (sharkd requests, syntax checks as the user types)
+ * doesn't go through the parser again.  An entry is only used if no fields
+ * have been registered or deregistered and no preferences applied since
+ * it was compiled.
+ */
+#define DFILTER_CACHE_SIZE	32
+
+typedef struct {
+	char		*text;		/* After macro expansion */
+	unsigned	flags;
+	unsigned	registrar_epoch;
+	unsigned	prefs_epoch;
+	dfilter_t	*df;		/* NULL for an empty filter or an error */
+	df_error_t	*error;		/* NULL on success */
+} dfilter_cache_entry_t;
+
+static GQueue dfilter_cache = G_QUEUE_INIT;
+
+static void
+cache_entry_free(void *data)
+{
+	dfilter_cache_entry_t *entry = data;
+
+	g_free(entry->text);
+	dfilter_free(entry->df);
+	df_error_free(&entry->error);
+	g_free(entry);
+}
+
 df_loc_t loc_empty = {-1, 0};
 
 void
@@ -124,6 +157,8 @@ dfilter_init(void)
 void
 dfilter_cleanup(void)
 {
+	g_queue_clear_full(&dfilter_cache, cache_entry_free);
+
 	dfilter_plugins_cleanup();
 	dfilter_macro_cleanup();
 	df_func_cleanup();
@@ -143,6 +178,7 @@ dfilter_new(GPtrArray *deprecated)
 	dfilter_t	*df;
 
 	df = g_new0(dfilter_t, 1);
+	df->refcount = 1;
 	df->insns = NULL;
 	df->function_stack = NULL;
 	df->set_stack = NULL;
@@ -173,6 +209,9 @@ dfilter_free(dfilter_t *df)
 	if (!df)
 		return;
 
+	if (--df->refcount > 0)
+		return;
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
@@ -198,7 +237,13 @@ dfilter_free(dfilter_t *df)
 	if (df->warnings)
 		g_slist_free_full(df->warnings, g_free);
 
+	for (unsigned i = 0; i < df->num_registers; i++) {
+		df_cell_clear(&df->registers[i]);
+		df_cell_free_spare(&df->registers[i]);
+	}
 	g_free(df->registers);
+	g_free(df->set_slots);
+	dfvm_profile_free(df->profile);
 	g_free(df->expanded_text);
 	g_free(df->syntax_tree_str);
 	g_free(df);
@@ -582,6 +627,60 @@ FAILURE:
 	return NULL;
 }
 
+static dfilter_cache_entry_t *
+cache_lookup(const char *text, unsigned flags)
+{
+	unsigned registrar_epoch = proto_registrar_epoch();
+	unsigned prefs_epoch = prefs_get_epoch();
+	GList *link, *next;
+	dfilter_cache_entry_t *entry;
+
+	for (link = dfilter_cache.head; link != NULL; link = next) {
+		next = link->next;
+		entry = link->data;
+		if (entry->registrar_epoch != registrar_epoch ||
+				entry->prefs_epoch != prefs_epoch) {
+			/* Stale; the fields it refers to may be gone. */
+			g_queue_delete_link(&dfilter_cache, link);
+			cache_entry_free(entry);
+			continue;
+		}
+		if (entry->flags == flags && strcmp(entry->text, text) == 0) {
+			g_queue_unlink(&dfilter_cache, link);
+			g_queue_push_head_link(&dfilter_cache, link);
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void
+cache_insert(const char *text, unsigned flags, dfilter_t *df, df_error_t *error)
+{
+	dfilter_cache_entry_t *entry;
+
+	/* Field references are loaded into the filter itself, so a filter
+	 * using them can't be shared. */
+	if (df && (g_hash_table_size(df->references) > 0 ||
+				g_hash_table_size(df->raw_references) > 0))
+		return;
+
+	entry = g_new(dfilter_cache_entry_t, 1);
+	entry->text = g_strdup(text);
+	entry->flags = flags;
+	/* After compiling, which may have registered fields on demand. */
+	entry->registrar_epoch = proto_registrar_epoch();
+	entry->prefs_epoch = prefs_get_epoch();
+	entry->df = df;
+	if (df)
+		df->refcount++;
+	entry->error = error ? df_error_new(error->code, g_strdup(error->msg), &error->loc) : NULL;
+	g_queue_push_head(&dfilter_cache, entry);
+
+	while (g_queue_get_length(&dfilter_cache) > DFILTER_CACHE_SIZE)
+		cache_entry_free(g_queue_pop_tail(&dfilter_cache));
+}
+
 static inline bool
 compile_failure(df_error_t *error, df_error_t **err_ptr)
 {
@@ -604,6 +703,7 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 	char *expanded_text;
 	dfilter_t *dfcode;
 	df_error_t *error = NULL;
+	dfilter_cache_entry_t *entry;
 
 	ws_assert(dfp);
 	*dfp = NULL;
@@ -633,7 +733,23 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 		ws_noisy("Verbatim text: %s", expanded_text);
 	}
 
+	entry = cache_lookup(expanded_text, flags);
+	if (entry != NULL) {
+		g_free(expanded_text);
+		if (entry->error != NULL) {
+			error = df_error_new(entry->error->code,
+					g_strdup(entry->error->msg), &entry->error->loc);
+			return compile_failure(error, err_ptr);
+		}
+		if (entry->df != NULL)
+			entry->df->refcount++;
+		*dfp = entry->df;
+		ws_info("Compiled display filter (cached): %s", text);
+		return true;
+	}
+
 	dfcode = compile_filter(expanded_text, flags, &error);
+	cache_insert(expanded_text, flags, dfcode, error);
 	g_free(expanded_text);
 	expanded_text = NULL;
 
@@ -656,7 +772,93 @@ dfilter_apply(dfilter_t *df, proto_tree *tree)
 bool
 dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 {
-	return dfvm_apply(df, edt->tree);
+	int64_t start = ws_trace_begin();
+	bool passed;
+
+	passed = dfvm_apply(df, edt->tree);
+	ws_trace_end("dfilter", "dfilter_apply_edt", start);
+	return passed;
+}
+
+dfilter_set_t *
+dfilter_set_new(void)
+{
+	/* Never 0, which means "no set" in dfilter_t.set_serial. */
+	static unsigned next_serial = 1;
+	dfilter_set_t *set;
+
+	set = g_new0(dfilter_set_t, 1);
+	set->serial = next_serial++;
+	if (next_serial == 0)
+		next_serial = 1;
+	set->tests = g_ptr_array_new_with_free_func((GDestroyNotify)dfvm_insn_free);
+	return set;
+}
+
+void
+dfilter_set_free(dfilter_set_t *set)
+{
+	if (!set)
+		return;
+	g_ptr_array_free(set->tests, true);
+	g_free(set->results);
+	g_free(set);
+}
+
+void
+dfilter_set_reset(dfilter_set_t *set)
+{
+	if (set->results_size > 0)
+		memset(set->results, DF_SET_RESULT_UNKNOWN, set->results_size);
+}
+
+/* Assigns a result slot in the set to each shareable instruction of the
+ * filter, adding the tests the set hasn't seen yet. */
+static void
+set_resolve_slots(dfilter_set_t *set, dfilter_t *df)
+{
+	dfvm_insn_t	*insn;
+	unsigned	slot;
+
+	g_free(df->set_slots);
+	df->set_slots = g_new(int, df->insns->len);
+
+	for (unsigned i = 0; i < df->insns->len; i++) {
+		insn = g_ptr_array_index(df->insns, i);
+		df->set_slots[i] = -1;
+		if (!dfvm_insn_is_shareable(insn))
+			continue;
+
+		for (slot = 0; slot < set->tests->len; slot++) {
+			if (dfvm_insn_same_test(insn, g_ptr_array_index(set->tests, slot)))
+				break;
+		}
+		if (slot == set->tests->len)
+			g_ptr_array_add(set->tests, dfvm_insn_dup(insn));
+		df->set_slots[i] = slot;
+	}
+
+	if (set->tests->len > set->results_size) {
+		set->results = g_realloc(set->results, set->tests->len);
+		memset(set->results + set->results_size, DF_SET_RESULT_UNKNOWN,
+				set->tests->len - set->results_size);
+		set->results_size = set->tests->len;
+	}
+	df->set_serial = set->serial;
+}
+
+bool
+dfilter_set_apply_edt(dfilter_set_t *set, dfilter_t *df, epan_dissect_t *edt)
+{
+	bool passed;
+
+	if (df->set_serial != set->serial)
+		set_resolve_slots(set, df);
+
+	df->set = set;
+	passed = dfvm_apply(df, edt->tree);
+	df->set = NULL;
+	return passed;
 }
 
 
@@ -730,6 +932,50 @@ dfilter_requires_columns(const dfilter_t *df)
 	return dfilter_interested_in_proto(df, proto_cols);
 }
 
+static bool
+arg_reads_only_fields(dfvm_value_t *arg, dfilter_field_cb accept, void *data)
+{
+	header_field_info *hfinfo;
+
+	if (arg == NULL)
+		return true;
+	if (arg->type == RAW_HFINFO)
+		return false;
+	if (arg->type != HFINFO)
+		return true;
+
+	for (hfinfo = arg->value.hfinfo; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+		if (!accept(hfinfo->id, data))
+			return false;
+	}
+	return true;
+}
+
+bool
+dfilter_reads_only_fields(const dfilter_t *df, dfilter_field_cb accept, void *data)
+{
+	dfvm_insn_t *insn;
+
+	if (df == NULL)
+		return false;
+
+	for (unsigned i = 0; i < df->insns->len; i++) {
+		insn = g_ptr_array_index(df->insns, i);
+		switch (insn->op) {
+			case DFVM_READ_REFERENCE:
+			case DFVM_READ_REFERENCE_R:
+				return false;
+			default:
+				break;
+		}
+		if (!arg_reads_only_fields(insn->arg1, accept, data) ||
+				!arg_reads_only_fields(insn->arg2, accept, data) ||
+				!arg_reads_only_fields(insn->arg3, accept, data))
+			return false;
+	}
+	return true;
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
@@ -750,6 +996,22 @@ dfilter_dump(FILE *fp, dfilter_t *df, uint16_t flags)
 	dfvm_dump(fp, df, flags);
 }
 
+void
+dfilter_profile_start(dfilter_t *df)
+{
+	dfvm_profile_free(df->profile);
+	df->profile = dfvm_profile_new(df->insns->len);
+}
+
+void
+dfilter_profile_dump(FILE *fp, dfilter_t *df)
+{
+	char *str = dfvm_profile_str(NULL, df);
+	fputs(str, fp);
+	fputc('\n', fp);
+	wmem_free(NULL, str);
+}
+
 const char *
 dfilter_text(dfilter_t *df)
 {
@@ -968,7 +1230,13 @@ void
 df_cell_init(df_cell_t *rp, bool free_seg)
 {
 	df_cell_clear(rp);
-	if (free_seg)
+	if (rp->spare) {
+		rp->array = rp->spare;
+		rp->spare = NULL;
+		g_ptr_array_set_free_func(rp->array,
+				free_seg ? (GDestroyNotify)fvalue_free : NULL);
+	}
+	else if (free_seg)
 		rp->array = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
 	else
 		rp->array = g_ptr_array_new();
@@ -982,6 +1250,28 @@ df_cell_clear(df_cell_t *rp)
 	rp->array = NULL;
 }
 
+void
+df_cell_recycle(df_cell_t *rp)
+{
+	if (rp->array == NULL)
+		return;
+	/* Frees the values too, if the cell owns them. */
+	g_ptr_array_set_size(rp->array, 0);
+	if (rp->spare == NULL)
+		rp->spare = rp->array;
+	else
+		g_ptr_array_unref(rp->array);
+	rp->array = NULL;
+}
+
+void
+df_cell_free_spare(df_cell_t *rp)
+{
+	if (rp->spare)
+		g_ptr_array_unref(rp->spare);
+	rp->spare = NULL;
+}
+
 void
 df_cell_iter_init(df_cell_t *rp, df_cell_iter_t *iter)
 {
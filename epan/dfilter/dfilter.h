@@ -18,6 +18,9 @@
 /* Passed back to user */
 typedef struct epan_dfilter dfilter_t;
 
+/* Shares test results between filters applied to the same packet */
+typedef struct epan_dfilter_set dfilter_set_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -114,6 +117,31 @@ dfilter_apply_edt(dfilter_t *df, struct epan_dissect *edt);
 bool
 dfilter_apply(dfilter_t *df, proto_tree *tree);
 
+/* Create a filter set. Filters applied through a set share the results
+ * of the tests they have in common, such as "tcp" or "tcp.port == 80",
+ * so that applying many filters to a packet evaluates each of those
+ * tests only once. Filters don't belong to a set and may be added to or
+ * freed independently of it. */
+WS_DLL_PUBLIC
+dfilter_set_t *
+dfilter_set_new(void);
+
+/* Frees the filter set. */
+WS_DLL_PUBLIC
+void
+dfilter_set_free(dfilter_set_t *set);
+
+/* Forget the shared results. Must be called before applying filters
+ * through the set to another packet or another tree. */
+WS_DLL_PUBLIC
+void
+dfilter_set_reset(dfilter_set_t *set);
+
+/* Apply compiled dfilter, reusing and recording test results in the set. */
+WS_DLL_PUBLIC
+bool
+dfilter_set_apply_edt(dfilter_set_t *set, dfilter_t *df, struct epan_dissect *edt);
+
 /* Prime a proto_tree using the fields/protocols used in a dfilter. */
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
@@ -138,6 +166,7 @@ dfilter_has_interesting_fields(const dfilter_t *df);
  * @param hfid The header field info ID to check
  * @return true if the field is interesting to the dfilter
  */
+WS_DLL_PUBLIC
 bool
 dfilter_interested_in_field(const dfilter_t *df, int hfid);
 
@@ -148,6 +177,7 @@ dfilter_interested_in_field(const dfilter_t *df, int hfid);
  * @return true if the dfilter is interested in a field whose
  * parent is proto_id
  */
+WS_DLL_PUBLIC
 bool
 dfilter_interested_in_proto(const dfilter_t *df, int proto_id);
 
@@ -155,6 +185,21 @@ WS_DLL_PUBLIC
 bool
 dfilter_requires_columns(const dfilter_t *df);
 
+typedef bool (*dfilter_field_cb)(int hfid, void *data);
+
+/* Check if dfilter looks at nothing but the values of fields accepted by
+ * the callback, i.e. no raw bytes and no field references, so that it can
+ * be applied to a tree that holds only those fields.
+ *
+ * @param df The dfilter
+ * @param accept Called with the ID of each field the dfilter reads
+ * @param data Passed to the callback
+ * @return true if every field was accepted
+ */
+WS_DLL_PUBLIC
+bool
+dfilter_reads_only_fields(const dfilter_t *df, dfilter_field_cb accept, void *data);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
@@ -171,6 +216,18 @@ WS_DLL_PUBLIC
 void
 dfilter_dump(FILE *fp, dfilter_t *df, uint16_t flags);
 
+/* Collect execution statistics (counts, results, jumps taken and time
+ * spent per instruction) each time the dfilter is applied from now on,
+ * discarding any collected before. Slows the dfilter down. */
+WS_DLL_PUBLIC
+void
+dfilter_profile_start(dfilter_t *df);
+
+/* Print the statistics collected since dfilter_profile_start() to fp */
+WS_DLL_PUBLIC
+void
+dfilter_profile_dump(FILE *fp, dfilter_t *df);
+
 /* Text after macro expansion. */
 WS_DLL_PUBLIC
 const char *
@@ -13,6 +13,7 @@
 
 #include <ftypes/ftypes.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/time_util.h>
 
 static void
 debug_register(GSList *reg, uint32_t num);
@@ -70,6 +71,8 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 		case DFVM_STACK_PUSH:		return "STACK_PUSH";
 		case DFVM_STACK_POP:		return "STACK_POP";
 		case DFVM_NOT_ALL_ZERO:		return "NOT_ALL_ZERO";
+		case DFVM_TREE_CMP_UINT:	return "TREE_CMP_UINT";
+		case DFVM_TREE_CMP_SINT:	return "TREE_CMP_SINT";
 		case DFVM_NO_OP:		return "NO_OP";
 	}
 	return "(fix-opcode-string)";
@@ -88,6 +91,13 @@ dfvm_value_free(dfvm_value_t *v)
 		case PCRE:
 			ws_regex_free(v->value.pcre);
 			break;
+		case FVALUE_SET:
+			g_hash_table_destroy(v->value.fvalue_set->table);
+			g_ptr_array_unref(v->value.fvalue_set->elems);
+			g_ptr_array_unref(v->value.fvalue_set->low);
+			g_ptr_array_unref(v->value.fvalue_set->high);
+			g_free(v->value.fvalue_set);
+			break;
 		case EMPTY:
 		case HFINFO:
 		case RAW_HFINFO:
@@ -165,6 +175,50 @@ dfvm_insn_free(dfvm_insn_t *insn)
 	g_free(insn);
 }
 
+bool
+dfvm_insn_is_shareable(const dfvm_insn_t *insn)
+{
+	switch (insn->op) {
+		case DFVM_CHECK_EXISTS:
+			return insn->arg1->type == HFINFO;
+		case DFVM_TREE_CMP_UINT:
+		case DFVM_TREE_CMP_SINT:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool
+dfvm_insn_same_test(const dfvm_insn_t *a, const dfvm_insn_t *b)
+{
+	const fvalue_t *fv_a, *fv_b;
+
+	if (a->op != b->op || a->arg1->value.hfinfo != b->arg1->value.hfinfo)
+		return false;
+	if (a->op == DFVM_CHECK_EXISTS)
+		return true;
+
+	if (a->arg3->value.numeric != b->arg3->value.numeric)
+		return false;
+	fv_a = dfvm_value_get_fvalue(a->arg2);
+	fv_b = dfvm_value_get_fvalue(b->arg2);
+	return fvalue_type_ftenum(fv_a) == fvalue_type_ftenum(fv_b) &&
+		fvalue_eq(fv_a, fv_b) == FT_TRUE;
+}
+
+dfvm_insn_t*
+dfvm_insn_dup(const dfvm_insn_t *insn)
+{
+	dfvm_insn_t	*dup;
+
+	dup = dfvm_insn_new(insn->op);
+	dup->id = insn->id;
+	dup->arg1 = dfvm_value_ref(insn->arg1);
+	dup->arg2 = dfvm_value_ref(insn->arg2);
+	dup->arg3 = dfvm_value_ref(insn->arg3);
+	return dup;
+}
 
 dfvm_value_t*
 dfvm_value_new(dfvm_value_type_t type)
@@ -239,6 +293,147 @@ dfvm_value_new_guint(unsigned num)
 	return v;
 }
 
+/* Values that compare equal only to values with the same hash, so that
+ * they can be looked up in a hash table. Two values of the same hash
+ * class that compare equal must have the same hash. IPv4 and IPv6
+ * addresses compare equal to the subnets containing them, so only
+ * host addresses qualify. */
+enum fvalue_hash_class {
+	HASH_CLASS_NONE,
+	HASH_CLASS_INTEGER,
+	HASH_CLASS_STRING,
+	HASH_CLASS_BYTES,
+	HASH_CLASS_IPV4,
+	HASH_CLASS_IPV6,
+};
+
+static unsigned
+fvalue_set_hash(const void *fv)
+{
+	return fvalue_hash(fv);
+}
+
+static gboolean
+fvalue_set_equal(const void *a, const void *b)
+{
+	return fvalue_equal(a, b);
+}
+
+dfvm_value_t*
+dfvm_value_new_fvalue_set(void)
+{
+	dfvm_value_t *v = dfvm_value_new(FVALUE_SET);
+	dfvm_fvalue_set_t *set = g_new(dfvm_fvalue_set_t, 1);
+
+	set->table = g_hash_table_new_full(fvalue_set_hash, fvalue_set_equal,
+				(GDestroyNotify)fvalue_free, NULL);
+	set->elems = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+	set->low = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+	set->high = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+	set->table_class = HASH_CLASS_NONE;
+	v->value.fvalue_set = set;
+	return v;
+}
+
+static enum fvalue_hash_class
+fvalue_hash_class(const fvalue_t *fv)
+{
+	ftenum_t ft = fvalue_type_ftenum(fv);
+
+	if (FT_IS_INTEGER(ft))
+		return HASH_CLASS_INTEGER;
+	if (FT_IS_STRING(ft))
+		return HASH_CLASS_STRING;
+	if (ft == FT_BYTES || ft == FT_ETHER)
+		return HASH_CLASS_BYTES;
+	if (ft == FT_IPv4 && fvalue_get_ipv4((fvalue_t *)fv)->nmask == 0xffffffff)
+		return HASH_CLASS_IPV4;
+	if (ft == FT_IPv6 && fvalue_get_ipv6((fvalue_t *)fv)->prefix == 128)
+		return HASH_CLASS_IPV6;
+	return HASH_CLASS_NONE;
+}
+
+void
+dfvm_fvalue_set_add(dfvm_fvalue_set_t *set, fvalue_t *fv)
+{
+	enum fvalue_hash_class class = fvalue_hash_class(fv);
+
+	/* Semantic checking converted all the elements to the same type,
+	 * so the class is the same for all hashed elements. */
+	if (class != HASH_CLASS_NONE &&
+			(set->table_class == HASH_CLASS_NONE || set->table_class == (int)class)) {
+		g_hash_table_add(set->table, fv);
+		set->table_class = class;
+	}
+	else {
+		g_ptr_array_add(set->elems, fv);
+	}
+}
+
+void
+dfvm_fvalue_set_add_range(dfvm_fvalue_set_t *set, fvalue_t *low, fvalue_t *high)
+{
+	g_ptr_array_add(set->low, low);
+	g_ptr_array_add(set->high, high);
+}
+
+static bool
+fvalue_set_contains(const dfvm_fvalue_set_t *set, fvalue_t *fv)
+{
+	GHashTableIter	iter;
+	void		*key;
+
+	if (g_hash_table_size(set->table) > 0) {
+		if ((int)fvalue_hash_class(fv) == set->table_class) {
+			if (g_hash_table_contains(set->table, fv))
+				return true;
+		}
+		else {
+			/* A subnet can be equal to several elements. */
+			g_hash_table_iter_init(&iter, set->table);
+			while (g_hash_table_iter_next(&iter, &key, NULL)) {
+				if (fvalue_eq(fv, key) == FT_TRUE)
+					return true;
+			}
+		}
+	}
+
+	for (unsigned i = 0; i < set->elems->len; i++) {
+		if (fvalue_eq(fv, set->elems->pdata[i]) == FT_TRUE)
+			return true;
+	}
+
+	for (unsigned i = 0; i < set->low->len; i++) {
+		if (fvalue_ge(fv, set->low->pdata[i]) == FT_TRUE &&
+				fvalue_le(fv, set->high->pdata[i]) == FT_TRUE)
+			return true;
+	}
+
+	return false;
+}
+
+static const char *
+cmp_op_tostr(dfvm_opcode_t op)
+{
+	switch (op) {
+		case DFVM_ALL_EQ:	return "===";
+		case DFVM_ANY_EQ:	return "==";
+		case DFVM_ALL_NE:	return "!=";
+		case DFVM_ANY_NE:	return "!==";
+		case DFVM_ALL_GT:
+		case DFVM_ANY_GT:	return ">";
+		case DFVM_ALL_GE:
+		case DFVM_ANY_GE:	return ">=";
+		case DFVM_ALL_LT:
+		case DFVM_ANY_LT:	return "<";
+		case DFVM_ALL_LE:
+		case DFVM_ANY_LE:	return "<=";
+		default:
+			ASSERT_DFVM_OP_NOT_REACHED(op);
+	}
+	ws_assert_not_reached();
+}
+
 static char *
 dfvm_value_tostr(dfvm_value_t *v)
 {
@@ -278,6 +473,12 @@ dfvm_value_tostr(dfvm_value_t *v)
 		case INSN_NUMBER:
 			s = ws_strdup_printf("INSN(%"PRIu32")", v->value.numeric);
 			break;
+		case FVALUE_SET:
+			s = ws_strdup_printf("{%u elements, %u ranges}",
+					g_hash_table_size(v->value.fvalue_set->table) +
+						v->value.fvalue_set->elems->len,
+					v->value.fvalue_set->low->len);
+			break;
 	}
 	return s;
 }
@@ -534,6 +735,14 @@ append_op_args(wmem_strbuf_t *buf, dfvm_insn_t *insn, GSList **stack_print,
 						arg1_str, arg1_str_type);
 			break;
 
+		case DFVM_TREE_CMP_UINT:
+		case DFVM_TREE_CMP_SINT:
+			wmem_strbuf_append_printf(buf, "%s%s %s %s%s",
+						arg1_str, arg1_str_type,
+						cmp_op_tostr(arg3->value.numeric),
+						arg2_str, arg2_str_type);
+			break;
+
 		case DFVM_ALL_CONTAINS:
 		case DFVM_ANY_CONTAINS:
 			wmem_strbuf_append_printf(buf, "%s%s contains %s%s",
@@ -550,8 +759,14 @@ append_op_args(wmem_strbuf_t *buf, dfvm_insn_t *insn, GSList **stack_print,
 		case DFVM_SET_ANY_IN:
 		case DFVM_SET_ALL_NOT_IN:
 		case DFVM_SET_ANY_NOT_IN:
-			wmem_strbuf_append_printf(buf, "%s%s",
+			if (arg2) {
+				wmem_strbuf_append_printf(buf, "%s%s in %s",
+						arg1_str, arg1_str_type, arg2_str);
+			}
+			else {
+				wmem_strbuf_append_printf(buf, "%s%s",
 						arg1_str, arg1_str_type);
+			}
 			break;
 
 		case DFVM_SET_ADD:
@@ -722,6 +937,240 @@ dfvm_dump_str(wmem_allocator_t *alloc, dfilter_t *df, uint16_t flags)
 	return wmem_strbuf_finalize(buf);
 }
 
+dfvm_profile_t *
+dfvm_profile_new(unsigned num_insns)
+{
+	dfvm_profile_t *profile = g_new0(dfvm_profile_t, 1);
+
+	profile->num_insns = num_insns;
+	profile->count = g_new0(uint64_t, num_insns);
+	profile->true_count = g_new0(uint64_t, num_insns);
+	profile->jumps = g_new0(uint64_t, num_insns);
+	profile->nsecs = g_new0(uint64_t, num_insns);
+	profile->cur_id = -1;
+	return profile;
+}
+
+void
+dfvm_profile_free(dfvm_profile_t *profile)
+{
+	if (profile == NULL)
+		return;
+	g_free(profile->count);
+	g_free(profile->true_count);
+	g_free(profile->jumps);
+	g_free(profile->nsecs);
+	g_free(profile);
+}
+
+/* Does the instruction set the result the jumps test? */
+static bool
+op_has_result(dfvm_opcode_t op)
+{
+	switch (op) {
+		case DFVM_PUT_FVALUE:
+		case DFVM_STACK_PUSH:
+		case DFVM_STACK_POP:
+		case DFVM_SLICE:
+		case DFVM_LENGTH:
+		case DFVM_BITWISE_AND:
+		case DFVM_UNARY_MINUS:
+		case DFVM_ADD:
+		case DFVM_SUBTRACT:
+		case DFVM_MULTIPLY:
+		case DFVM_DIVIDE:
+		case DFVM_MODULO:
+		case DFVM_SET_ADD:
+		case DFVM_SET_ADD_RANGE:
+		case DFVM_SET_CLEAR:
+		case DFVM_IF_TRUE_GOTO:
+		case DFVM_IF_FALSE_GOTO:
+		case DFVM_RETURN:
+		case DFVM_NO_OP:
+		case DFVM_NULL:
+			return false;
+		default:
+			return true;
+	}
+}
+
+static void
+append_percent(wmem_strbuf_t *buf, uint64_t part, uint64_t total)
+{
+	if (total == 0)
+		wmem_strbuf_append_printf(buf, " %6s", "-");
+	else
+		wmem_strbuf_append_printf(buf, " %5.1f%%", 100.0 * part / total);
+}
+
+typedef struct {
+	header_field_info *hfinfo;
+	uint64_t	count;
+	uint64_t	nsecs;
+} field_profile_t;
+
+static int
+compare_field_profile(const void *a, const void *b)
+{
+	const field_profile_t *fa = *(const field_profile_t **)a;
+	const field_profile_t *fb = *(const field_profile_t **)b;
+
+	if (fa->nsecs != fb->nsecs)
+		return fa->nsecs < fb->nsecs ? 1 : -1;
+	if (fa->count != fb->count)
+		return fa->count < fb->count ? 1 : -1;
+	return strcmp(fa->hfinfo->abbrev, fb->hfinfo->abbrev);
+}
+
+/* Add up the tree reads (and checks) for each field. */
+static GPtrArray *
+profile_fields(dfilter_t *df)
+{
+	dfvm_profile_t *profile = df->profile;
+	GHashTable *table = g_hash_table_new(g_direct_hash, g_direct_equal);
+	GPtrArray *fields = g_ptr_array_new_with_free_func(g_free);
+	dfvm_insn_t *insn;
+	field_profile_t *field;
+
+	for (unsigned id = 0; id < df->insns->len; id++) {
+		insn = g_ptr_array_index(df->insns, id);
+		switch (insn->op) {
+			case DFVM_CHECK_EXISTS:
+			case DFVM_CHECK_EXISTS_R:
+			case DFVM_READ_TREE:
+			case DFVM_READ_TREE_R:
+			case DFVM_TREE_CMP_UINT:
+			case DFVM_TREE_CMP_SINT:
+				break;
+			default:
+				continue;
+		}
+		if (profile->count[id] == 0)
+			continue;
+		field = g_hash_table_lookup(table, insn->arg1->value.hfinfo);
+		if (field == NULL) {
+			field = g_new0(field_profile_t, 1);
+			field->hfinfo = insn->arg1->value.hfinfo;
+			g_hash_table_insert(table, field->hfinfo, field);
+			g_ptr_array_add(fields, field);
+		}
+		field->count += profile->count[id];
+		field->nsecs += profile->nsecs[id];
+	}
+	g_hash_table_destroy(table);
+	g_ptr_array_sort(fields, compare_field_profile);
+	return fields;
+}
+
+char *
+dfvm_profile_str(wmem_allocator_t *alloc, dfilter_t *df)
+{
+	dfvm_profile_t	*profile = df->profile;
+	wmem_strbuf_t	*buf;
+	dfvm_insn_t	*insn;
+	GSList		*stack_print = NULL;
+	GPtrArray	*fields;
+	uint64_t	total_nsecs = 0;
+	size_t		col_start;
+
+	buf = wmem_strbuf_new(alloc, NULL);
+
+	if (profile == NULL || profile->runs == 0) {
+		wmem_strbuf_append(buf, "Profile: (no runs)");
+		return wmem_strbuf_finalize(buf);
+	}
+
+	for (unsigned id = 0; id < profile->num_insns; id++)
+		total_nsecs += profile->nsecs[id];
+
+	wmem_strbuf_append_printf(buf, "Profile: %"PRIu64" runs, %"PRIu64" passed",
+			profile->runs, profile->passed);
+	append_percent(buf, profile->passed, profile->runs);
+	wmem_strbuf_append_printf(buf, ", %.3f ms, %.0f ns/run\n\n",
+			total_nsecs / 1e6, (double)total_nsecs / profile->runs);
+
+	/* Count and time of each instruction, how often it left the result
+	 * true, and how often its jump was taken (short-circuiting the rest
+	 * of an "and" or "or"). */
+	wmem_strbuf_append(buf, "Instructions:      Count   Exec   True  Jumps    Time  ns/exec");
+	for (unsigned id = 0; id < profile->num_insns; id++) {
+		insn = g_ptr_array_index(df->insns, id);
+		wmem_strbuf_append_printf(buf, "\n %04u %15"PRIu64, id, profile->count[id]);
+		append_percent(buf, profile->count[id], profile->runs);
+		if (op_has_result(insn->op))
+			append_percent(buf, profile->true_count[id], profile->count[id]);
+		else
+			wmem_strbuf_append_printf(buf, " %6s", "-");
+		if (insn->op == DFVM_IF_TRUE_GOTO || insn->op == DFVM_IF_FALSE_GOTO)
+			append_percent(buf, profile->jumps[id], profile->count[id]);
+		else
+			wmem_strbuf_append_printf(buf, " %6s", "-");
+		append_percent(buf, profile->nsecs[id], total_nsecs);
+		wmem_strbuf_append_printf(buf, " %8.0f  ", profile->count[id] ?
+				(double)profile->nsecs[id] / profile->count[id] : 0.0);
+
+		col_start = buf->len;
+		wmem_strbuf_append(buf, dfvm_opcode_tostr(insn->op));
+		switch (insn->op) {
+			case DFVM_NOT:
+			case DFVM_RETURN:
+			case DFVM_SET_CLEAR:
+			case DFVM_NO_OP:
+				break;
+			default:
+				indent2(buf, col_start);
+				append_op_args(buf, insn, &stack_print, 0);
+				break;
+		}
+	}
+	g_slist_free_full(stack_print, g_free);
+
+	fields = profile_fields(df);
+	if (fields->len > 0) {
+		wmem_strbuf_append(buf, "\n\nFields read:        Reads    Time");
+		for (unsigned i = 0; i < fields->len; i++) {
+			field_profile_t *field = g_ptr_array_index(fields, i);
+			wmem_strbuf_append_printf(buf, "\n %-15s %10"PRIu64,
+					field->hfinfo->abbrev, field->count);
+			append_percent(buf, field->nsecs, total_nsecs);
+		}
+	}
+	g_ptr_array_free(fields, true);
+
+	return wmem_strbuf_finalize(buf);
+}
+
+static inline uint64_t
+timespec_diff_ns(const struct timespec *start, const struct timespec *end)
+{
+	return (uint64_t)((end->tv_sec - start->tv_sec) * 1000000000LL +
+			(end->tv_nsec - start->tv_nsec));
+}
+
+/* Charge the time since the last step to the instruction being timed,
+ * with the result it produced, and start timing instruction id, or stop
+ * if id is -1. */
+static void
+profile_step(dfvm_profile_t *profile, int id, bool accum)
+{
+	struct timespec now;
+
+	ws_clock_get_realtime(&now);
+	if (profile->cur_id >= 0) {
+		/* Ignore the wall clock going backwards. */
+		uint64_t elapsed = timespec_diff_ns(&profile->cur_start, &now);
+		if (elapsed < ((uint64_t)1 << 62))
+			profile->nsecs[profile->cur_id] += elapsed;
+		if (accum)
+			profile->true_count[profile->cur_id]++;
+	}
+	profile->cur_id = id;
+	if (id >= 0) {
+		profile->count[id]++;
+		profile->cur_start = now;
+	}
+}
+
 void
 dfvm_dump(FILE *f, dfilter_t *df, uint16_t flags)
 {
@@ -1178,29 +1627,37 @@ test_in_internal(fvalue_t *fv, GPtrArray *range[2])
 	return low_ok;
 }
 
+/* Tests a value against the constant set in arg2, or against the
+ * set stack if there is none. */
+static bool
+value_in_set(dfilter_t *df, fvalue_t *fv, dfvm_value_t *arg2)
+{
+	GSList *stack;
+
+	if (arg2) {
+		return fvalue_set_contains(arg2->value.fvalue_set, fv);
+	}
+
+	for (stack = df->set_stack; stack; stack = stack->next) {
+		if (test_in_internal(fv, stack->data)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 static bool
-any_in(dfilter_t *df, dfvm_value_t *arg1)
+any_in(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
 {
 	df_cell_t *rp = &df->registers[arg1->value.numeric];
 	GPtrArray *value;
-	GSList *stack;
-	bool ok;
 
 	/* If the read failed we jump over the membership test. */
 	ws_assert(!df_cell_is_empty(rp));
 	value = df_cell_ptr(rp);
 
 	for (size_t i = 0; i < value->len; i++) {
-		stack = df->set_stack;
-		ok = false;
-		while (stack) {
-			if (test_in_internal(value->pdata[i], stack->data)) {
-				ok = true;
-				break;
-			}
-			stack = stack->next;
-		}
-		if (ok) {
+		if (value_in_set(df, value->pdata[i], arg2)) {
 			return true;
 		}
 	}
@@ -1208,28 +1665,17 @@ any_in(dfilter_t *df, dfvm_value_t *arg1)
 }
 
 static bool
-all_in(dfilter_t *df, dfvm_value_t *arg1)
+all_in(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
 {
 	df_cell_t *rp = &df->registers[arg1->value.numeric];
 	GPtrArray *value;
-	GSList *stack;
-	bool ok;
 
 	/* If the read failed we jump over the membership test. */
 	ws_assert(!df_cell_is_empty(rp));
 	value = df_cell_ptr(rp);
 
 	for (size_t i = 0; i < value->len; i++) {
-		stack = df->set_stack;
-		ok = false;
-		while (stack) {
-			if (test_in_internal(value->pdata[i], stack->data)) {
-				ok = true;
-				break;
-			}
-			stack = stack->next;
-		}
-		if (!ok) {
+		if (!value_in_set(df, value->pdata[i], arg2)) {
 			return false;
 		}
 	}
@@ -1237,12 +1683,15 @@ all_in(dfilter_t *df, dfvm_value_t *arg1)
 }
 
 /* Clear registers that were populated during evaluation.
- * If we created the values, then these will be freed as well. */
+ * If we created the values, then these will be freed as well.
+ * The arrays themselves are kept for the next run, so that a filter
+ * doesn't allocate and free one per register for every packet; by
+ * now the function and set stacks no longer refer to them. */
 static void
 free_register_overhead(dfilter_t* df)
 {
 	for (unsigned i = 0; i < df->num_registers; i++) {
-		df_cell_clear(&df->registers[i]);
+		df_cell_recycle(&df->registers[i]);
 	}
 }
 
@@ -1628,6 +2077,135 @@ check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 	return false;
 }
 
+static inline bool
+cmp_op_is_all(dfvm_opcode_t op)
+{
+	switch (op) {
+		case DFVM_ALL_EQ:
+		case DFVM_ALL_NE:
+		case DFVM_ALL_GT:
+		case DFVM_ALL_GE:
+		case DFVM_ALL_LT:
+		case DFVM_ALL_LE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static inline bool
+cmp_op_holds(dfvm_opcode_t op, int cmp)
+{
+	switch (op) {
+		case DFVM_ALL_EQ:
+		case DFVM_ANY_EQ:
+			return cmp == 0;
+		case DFVM_ALL_NE:
+		case DFVM_ANY_NE:
+			return cmp != 0;
+		case DFVM_ALL_GT:
+		case DFVM_ANY_GT:
+			return cmp > 0;
+		case DFVM_ALL_GE:
+		case DFVM_ANY_GE:
+			return cmp >= 0;
+		case DFVM_ALL_LT:
+		case DFVM_ANY_LT:
+			return cmp < 0;
+		case DFVM_ALL_LE:
+		case DFVM_ANY_LE:
+			return cmp <= 0;
+		default:
+			ASSERT_DFVM_OP_NOT_REACHED(op);
+	}
+	ws_assert_not_reached();
+}
+
+/* Compares the integer values of a field in the tree with a constant,
+ * without loading them into a register first. arg1 is the field, arg2
+ * the constant and arg3 the comparison opcode being replaced. The code
+ * generator only fuses the comparison if every field with that name has
+ * the same signedness as the constant. */
+static bool
+tree_cmp_integer(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2,
+				dfvm_value_t *arg3, bool is_signed)
+{
+	header_field_info *hfinfo = arg1->value.hfinfo;
+	dfvm_opcode_t	op = arg3->value.numeric;
+	bool		want_all = cmp_op_is_all(op);
+	bool		found = false;
+	const fvalue_t	*fv_const = dfvm_value_get_fvalue(arg2);
+	uint64_t	uval, uconst = 0;
+	int64_t		sval, sconst = 0;
+	GPtrArray	*finfos;
+	field_info	*finfo;
+	bool		match;
+	int		cmp;
+
+	if (is_signed)
+		fvalue_to_sinteger64(fv_const, &sconst);
+	else
+		fvalue_to_uinteger64(fv_const, &uconst);
+
+	for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL)
+			continue;
+
+		for (unsigned i = 0; i < finfos->len; i++) {
+			finfo = finfos->pdata[i];
+			if (is_signed) {
+				fvalue_to_sinteger64(finfo->value, &sval);
+				cmp = sval == sconst ? 0 : (sval < sconst ? -1 : 1);
+			}
+			else {
+				fvalue_to_uinteger64(finfo->value, &uval);
+				cmp = uval == uconst ? 0 : (uval < uconst ? -1 : 1);
+			}
+			match = cmp_op_holds(op, cmp);
+			if (want_all && !match) {
+				return false;
+			}
+			else if (!want_all && match) {
+				return true;
+			}
+			found = true;
+		}
+	}
+	/* Like READ_TREE, fail if the field isn't present. */
+	return want_all && found;
+}
+
+/* Looks up the result of instruction id in the filter set the filter is
+ * being applied through. */
+static inline bool
+set_lookup(dfilter_t *df, int id, bool *accum)
+{
+	int slot = df->set_slots[id];
+
+	if (slot < 0)
+		return false;
+	switch (df->set->results[slot]) {
+		case DF_SET_RESULT_TRUE:
+			*accum = true;
+			return true;
+		case DF_SET_RESULT_FALSE:
+			*accum = false;
+			return true;
+		default:
+			return false;
+	}
+}
+
+static inline void
+set_store(dfilter_t *df, int id, bool accum)
+{
+	int slot = df->set_slots[id];
+
+	if (slot >= 0)
+		df->set->results[slot] = accum ? DF_SET_RESULT_TRUE : DF_SET_RESULT_FALSE;
+}
+
 bool
 dfvm_apply(dfilter_t *df, proto_tree *tree)
 {
@@ -1645,6 +2223,9 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	for (id = 0; id < length; id++) {
 
 	  AGAIN:
+		if (G_UNLIKELY(df->profile))
+			profile_step(df->profile, id, accum);
+
 		insn = g_ptr_array_index(df->insns, id);
 		arg1 = insn->arg1;
 		arg2 = insn->arg2;
@@ -1652,7 +2233,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 		switch (insn->op) {
 			case DFVM_CHECK_EXISTS:
+				if (df->set && set_lookup(df, id, &accum))
+					break;
 				accum = check_exists(tree, arg1, NULL);
+				if (df->set)
+					set_store(df, id, accum);
 				break;
 
 			case DFVM_CHECK_EXISTS_R:
@@ -1779,6 +2364,16 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				accum = !all_test_unary(df, fvalue_is_zero, arg1);
 				break;
 
+			case DFVM_TREE_CMP_UINT:
+			case DFVM_TREE_CMP_SINT:
+				if (df->set && set_lookup(df, id, &accum))
+					break;
+				accum = tree_cmp_integer(tree, arg1, arg2, arg3,
+						insn->op == DFVM_TREE_CMP_SINT);
+				if (df->set)
+					set_store(df, id, accum);
+				break;
+
 			case DFVM_ALL_CONTAINS:
 				accum = all_test(df, fvalue_contains, arg1, arg2);
 				break;
@@ -1804,19 +2399,19 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				break;
 
 			case DFVM_SET_ALL_IN:
-				accum = all_in(df, arg1);
+				accum = all_in(df, arg1, arg2);
 				break;
 
 			case DFVM_SET_ANY_IN:
-				accum = any_in(df, arg1);
+				accum = any_in(df, arg1, arg2);
 				break;
 
 			case DFVM_SET_ALL_NOT_IN:
-				accum = !all_in(df, arg1);
+				accum = !all_in(df, arg1, arg2);
 				break;
 
 			case DFVM_SET_ANY_NOT_IN:
-				accum = !any_in(df, arg1);
+				accum = !any_in(df, arg1, arg2);
 				break;
 
 			case DFVM_SET_CLEAR:
@@ -1833,6 +2428,12 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case DFVM_RETURN:
 				free_register_overhead(df);
+				if (G_UNLIKELY(df->profile)) {
+					profile_step(df->profile, -1, accum);
+					df->profile->runs++;
+					if (accum)
+						df->profile->passed++;
+				}
 				return accum;
 
 			case DFVM_NO_OP:
@@ -1840,6 +2441,8 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case DFVM_IF_TRUE_GOTO:
 				if (accum) {
+					if (G_UNLIKELY(df->profile))
+						df->profile->jumps[id]++;
 					id = arg1->value.numeric;
 					goto AGAIN;
 				}
@@ -1847,6 +2450,8 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case DFVM_IF_FALSE_GOTO:
 				if (!accum) {
+					if (G_UNLIKELY(df->profile))
+						df->profile->jumps[id]++;
 					id = arg1->value.numeric;
 					goto AGAIN;
 				}
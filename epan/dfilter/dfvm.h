@@ -31,8 +31,21 @@ typedef enum {
 	DRANGE,
 	FUNCTION_DEF,
 	PCRE,
+	FVALUE_SET,
 } dfvm_value_type_t;
 
+/* A set with only constant elements, for the "in" operator. */
+typedef struct {
+	/* Elements that are equal to no other value, looked up by hash. */
+	GHashTable	*table;
+	int		table_class;
+	/* Other single elements, such as IPv4 and IPv6 subnets. */
+	GPtrArray	*elems;
+	/* Ranges, low[i] .. high[i]. */
+	GPtrArray	*low;
+	GPtrArray	*high;
+} dfvm_fvalue_set_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -43,6 +56,7 @@ typedef struct {
 		header_field_info	*hfinfo;
 		df_func_def_t		*funcdef;
 		ws_regex_t		*pcre;
+		dfvm_fvalue_set_t	*fvalue_set;
 	} value;
 
 	int ref_count;
@@ -100,6 +114,8 @@ typedef enum {
 	DFVM_STACK_PUSH,
 	DFVM_STACK_POP,
 	DFVM_NOT_ALL_ZERO,
+	DFVM_TREE_CMP_UINT,	/* Fused READ_TREE and comparison with an unsigned constant */
+	DFVM_TREE_CMP_SINT,	/* Fused READ_TREE and comparison with a signed constant */
 	DFVM_NO_OP,
 } dfvm_opcode_t;
 
@@ -123,6 +139,19 @@ dfvm_insn_replace_no_op(dfvm_insn_t *insn);
 void
 dfvm_insn_free(dfvm_insn_t *insn);
 
+/* True if the result of insn depends only on the tree, so that it
+ * can be shared with other filters through a dfilter_set_t. */
+bool
+dfvm_insn_is_shareable(const dfvm_insn_t *insn);
+
+/* True if two shareable instructions test the same thing. */
+bool
+dfvm_insn_same_test(const dfvm_insn_t *a, const dfvm_insn_t *b);
+
+/* Copy of a shareable instruction, sharing its arguments. */
+dfvm_insn_t*
+dfvm_insn_dup(const dfvm_insn_t *insn);
+
 dfvm_value_t*
 dfvm_value_new(dfvm_value_type_t type);
 
@@ -153,12 +182,46 @@ dfvm_value_new_pcre(ws_regex_t *re);
 dfvm_value_t*
 dfvm_value_new_guint(unsigned num);
 
+dfvm_value_t*
+dfvm_value_new_fvalue_set(void);
+
+/* Takes ownership of fv. */
+void
+dfvm_fvalue_set_add(dfvm_fvalue_set_t *set, fvalue_t *fv);
+
+/* Takes ownership of low and high. */
+void
+dfvm_fvalue_set_add_range(dfvm_fvalue_set_t *set, fvalue_t *low, fvalue_t *high);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df, uint16_t flags);
 
 char *
 dfvm_dump_str(wmem_allocator_t *alloc, dfilter_t *df,  uint16_t flags);
 
+/* Execution statistics of a filter, per instruction. */
+typedef struct dfvm_profile {
+	uint64_t	runs;
+	uint64_t	passed;
+	unsigned	num_insns;
+	uint64_t	*count;		/* Times executed */
+	uint64_t	*true_count;	/* Times it left the result true */
+	uint64_t	*jumps;		/* Times its jump was taken */
+	uint64_t	*nsecs;		/* Time spent in it */
+	/* The instruction being timed and when it started. */
+	int		cur_id;
+	struct timespec	cur_start;
+} dfvm_profile_t;
+
+dfvm_profile_t *
+dfvm_profile_new(unsigned num_insns);
+
+void
+dfvm_profile_free(dfvm_profile_t *profile);
+
+char *
+dfvm_profile_str(wmem_allocator_t *alloc, dfilter_t *df);
+
 bool
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
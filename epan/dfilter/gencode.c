@@ -442,6 +442,54 @@ fixup_jumps(void *data, void *user_data)
 	}
 }
 
+/* True if all the elements of the set are constants. */
+static bool
+set_is_constant(GSList *nodelist)
+{
+	stnode_t	*node1, *node2;
+
+	while (nodelist) {
+		node1 = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		node2 = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+
+		if (stnode_type_id(node1) != STTYPE_FVALUE)
+			return false;
+		if (node2 && stnode_type_id(node2) != STTYPE_FVALUE)
+			return false;
+	}
+	return true;
+}
+
+/* Build a set of constants, which is tested in place by the membership
+ * instruction instead of being pushed on the set stack element by element
+ * for every packet. Most of the elements are looked up by hash, so that
+ * large sets don't have to be searched linearly. */
+static dfvm_value_t *
+gen_constant_set(GSList *nodelist)
+{
+	dfvm_value_t	*val;
+	stnode_t	*node1, *node2;
+
+	val = dfvm_value_new_fvalue_set();
+	while (nodelist) {
+		node1 = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		node2 = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+
+		if (node2) {
+			dfvm_fvalue_set_add_range(val->value.fvalue_set,
+					stnode_steal_data(node1), stnode_steal_data(node2));
+		}
+		else {
+			dfvm_fvalue_set_add(val->value.fvalue_set, stnode_steal_data(node1));
+		}
+	}
+	return val;
+}
+
 /* Generate the code for the in operator. Pushes set values into a stack
  * and then evaluates membership in a single instruction. */
 static void
@@ -458,8 +506,22 @@ gen_relation_in(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 	/* Create code for the LHS of the relation */
 	val1 = gen_entity(dfw, st_arg1, &jumps);
 
-	/* Create code to populate the set stack */
 	nodelist_head = nodelist = stnode_steal_data(st_arg2);
+
+	if (set_is_constant(nodelist_head)) {
+		insn = dfvm_insn_new(select_opcode(op, how));
+		insn->arg1 = dfvm_value_ref(val1);
+		insn->arg2 = dfvm_value_ref(gen_constant_set(nodelist_head));
+		dfw_append_insn(dfw, insn);
+		set_nodelist_free(nodelist_head);
+
+		/* Jump here if the LHS entity was not present */
+		g_slist_foreach(jumps, fixup_jumps, dfw);
+		g_slist_free(jumps);
+		return;
+	}
+
+	/* Create code to populate the set stack */
 	while (nodelist) {
 		node1 = nodelist->data;
 		nodelist = g_slist_next(nodelist);
@@ -822,6 +884,184 @@ gencode(dfwork_t *dfw, stnode_t *st_node)
 }
 
 
+/* Returns the comparison to use when the operands of op are swapped. */
+static dfvm_opcode_t
+mirror_cmp_opcode(dfvm_opcode_t op)
+{
+	switch (op) {
+		case DFVM_ALL_GT:	return DFVM_ALL_LT;
+		case DFVM_ANY_GT:	return DFVM_ANY_LT;
+		case DFVM_ALL_GE:	return DFVM_ALL_LE;
+		case DFVM_ANY_GE:	return DFVM_ANY_LE;
+		case DFVM_ALL_LT:	return DFVM_ALL_GT;
+		case DFVM_ANY_LT:	return DFVM_ANY_GT;
+		case DFVM_ALL_LE:	return DFVM_ALL_GE;
+		case DFVM_ANY_LE:	return DFVM_ANY_GE;
+		default:		return op;
+	}
+}
+
+static bool
+is_integer_cmp_opcode(dfvm_opcode_t op)
+{
+	switch (op) {
+		case DFVM_ALL_EQ:
+		case DFVM_ANY_EQ:
+		case DFVM_ALL_NE:
+		case DFVM_ANY_NE:
+		case DFVM_ALL_GT:
+		case DFVM_ANY_GT:
+		case DFVM_ALL_GE:
+		case DFVM_ANY_GE:
+		case DFVM_ALL_LT:
+		case DFVM_ANY_LT:
+		case DFVM_ALL_LE:
+		case DFVM_ANY_LE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/* Returns DFVM_TREE_CMP_UINT or DFVM_TREE_CMP_SINT if every field named
+ * like hfinfo can be compared with the constant fv as a 64-bit integer,
+ * DFVM_NULL otherwise. */
+static dfvm_opcode_t
+select_tree_cmp_opcode(const header_field_info *hfinfo, const fvalue_t *fv)
+{
+	ftenum_t ft = fvalue_type_ftenum(fv);
+	dfvm_opcode_t op;
+
+	if (FT_IS_UINT(ft))
+		op = DFVM_TREE_CMP_UINT;
+	else if (FT_IS_INT(ft))
+		op = DFVM_TREE_CMP_SINT;
+	else
+		return DFVM_NULL;
+
+	for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+		if (op == DFVM_TREE_CMP_UINT && !FT_IS_UINT(hfinfo->type))
+			return DFVM_NULL;
+		if (op == DFVM_TREE_CMP_SINT && !FT_IS_INT(hfinfo->type))
+			return DFVM_NULL;
+	}
+	return op;
+}
+
+/* Fuse the sequence generated for comparing a field with an integer
+ * constant:
+ *
+ *   id     READ_TREE      field -> Rn
+ *   id+1   IF_FALSE_GOTO  id+3
+ *   id+2   ANY_EQ         Rn == constant
+ *
+ * into a single TREE_CMP_UINT or TREE_CMP_SINT instruction, which compares
+ * the field values in place instead of collecting them in a register and
+ * going through the generic fvalue comparison for each of them. The other
+ * two instructions become no-ops.
+ *
+ * Removing the READ_TREE is safe because registers are not shared across
+ * relations: every use of a field is preceded by its own READ_TREE, which
+ * loads the register if it hasn't been loaded already. */
+static void
+fuse_tree_cmp(dfwork_t *dfw)
+{
+	int		id, length;
+	dfvm_insn_t	*read, *jump, *cmp;
+	dfvm_value_t	*reg, *constant;
+	dfvm_opcode_t	cmp_op, fused_op;
+
+	length = dfw->insns->len;
+
+	for (id = 0; id + 2 < length; id++) {
+		read = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+		if (read->op != DFVM_READ_TREE || read->arg1->type != HFINFO)
+			continue;
+
+		jump = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id + 1);
+		if (jump->op != DFVM_IF_FALSE_GOTO || jump->arg1->value.numeric != (uint32_t)id + 3)
+			continue;
+
+		cmp = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id + 2);
+		if (!is_integer_cmp_opcode(cmp->op))
+			continue;
+
+		reg = read->arg2;
+		cmp_op = cmp->op;
+		if (cmp->arg1->type == REGISTER && cmp->arg1->value.numeric == reg->value.numeric &&
+				cmp->arg2->type == FVALUE) {
+			constant = cmp->arg2;
+		}
+		else if (cmp->arg2->type == REGISTER && cmp->arg2->value.numeric == reg->value.numeric &&
+				cmp->arg1->type == FVALUE) {
+			constant = cmp->arg1;
+			cmp_op = mirror_cmp_opcode(cmp_op);
+		}
+		else {
+			continue;
+		}
+
+		fused_op = select_tree_cmp_opcode(read->arg1->value.hfinfo,
+						dfvm_value_get_fvalue(constant));
+		if (fused_op == DFVM_NULL)
+			continue;
+
+		/* Keep the field in arg1 and replace the register. */
+		read->op = fused_op;
+		read->arg2 = dfvm_value_ref(constant);
+		read->arg3 = dfvm_value_ref(dfvm_value_new_guint(cmp_op));
+		dfvm_value_unref(reg);
+
+		dfvm_insn_replace_no_op(jump);
+		dfvm_insn_replace_no_op(cmp);
+		id += 2;
+	}
+}
+
+/* Drop the no-ops left behind by the other passes and renumber the jumps,
+ * so that they don't cost a dispatch each when the filter is run. A jump
+ * to a no-op goes to the next instruction that isn't one. */
+static void
+remove_no_ops(dfwork_t *dfw)
+{
+	int		id, new_id, length;
+	int		*new_ids;
+	dfvm_insn_t	*insn;
+
+	length = dfw->insns->len;
+	new_ids = g_new(int, length + 1);
+
+	for (id = 0, new_id = 0; id < length; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+		new_ids[id] = new_id;
+		if (insn->op != DFVM_NO_OP)
+			new_id++;
+	}
+	new_ids[length] = new_id;
+
+	if (new_id == length) {
+		g_free(new_ids);
+		return;
+	}
+
+	for (id = 0, new_id = 0; id < length; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+		if (insn->op == DFVM_NO_OP) {
+			dfvm_insn_free(insn);
+			continue;
+		}
+		if (insn->op == DFVM_IF_TRUE_GOTO || insn->op == DFVM_IF_FALSE_GOTO) {
+			insn->arg1->value.numeric = new_ids[insn->arg1->value.numeric];
+		}
+		insn->id = new_id;
+		g_ptr_array_index(dfw->insns, new_id) = insn;
+		new_id++;
+	}
+	g_ptr_array_set_size(dfw->insns, new_id);
+	dfw->next_insn_id = new_id;
+	g_free(new_ids);
+}
+
 static void
 optimize(dfwork_t *dfw)
 {
@@ -829,6 +1069,8 @@ optimize(dfwork_t *dfw)
 	dfvm_insn_t	*insn, *insn1, *prev;
 	dfvm_value_t	*arg1;
 
+	fuse_tree_cmp(dfw);
+
 	length = dfw->insns->len;
 
 	for (id = 0, prev = NULL; id < length; prev = insn, id++) {
@@ -873,6 +1115,8 @@ optimize(dfwork_t *dfw)
 			}
 		}
 	}
+
+	remove_no_ops(dfw);
 }
 
 void
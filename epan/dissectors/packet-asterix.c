@@ -55648,6 +55648,10 @@ static int dissect_asterix (tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     col_set_str (pinfo->cinfo, COL_PROTOCOL, "ASTERIX");
     col_clear (pinfo->cinfo, COL_INFO);
 
+    /* Load header fields if not already done */
+    if (hf_asterix_category <= 0)
+        proto_registrar_get_byname ("asterix.category");
+
     if (tree) { /* we are being asked for details */
         dissect_asterix_packet (tvb, pinfo, tree);
     }
@@ -56030,7 +56034,7 @@ static int asterix_message_length (tvbuff_t *tvb, unsigned offset, uint8_t categ
     return 0;
 }
 
-void proto_register_asterix (void)
+static void register_asterix_fields (const char *unused _U_)
 {
     static hf_register_info hf[] = {
         { &hf_asterix_category, { "Category", "asterix.category", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL } },
@@ -65091,6 +65095,11 @@ void proto_register_asterix (void)
 /* insert2 */
     };
 
+    proto_register_field_array (proto_asterix, hf, array_length (hf));
+}
+
+void proto_register_asterix (void)
+{
     /* Setup protocol subtree array */
     static int *ett[] = {
         &ett_asterix,
@@ -65108,7 +65117,9 @@ void proto_register_asterix (void)
         "asterix"         /* abbrev     */
     );
 
-    proto_register_field_array (proto_asterix, hf, array_length (hf));
+    /* Delay registration of the ASTERIX fields, of which there are
+     * thousands, until one of them is needed */
+    proto_register_prefix ("asterix", register_asterix_fields);
     proto_register_subtree_array (ett, array_length (ett));
 
     asterix_handle = register_dissector ("asterix", dissect_asterix, proto_asterix);
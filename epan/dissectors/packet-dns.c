@@ -551,8 +551,17 @@ typedef struct _dns_transaction_t {
   nstime_t req_time;
   guint id;
   gboolean multiple_responds;
+  const gchar *qname;   /* first query name, from dns_qnames; NULL if none */
+  guint16 qtype;
 } dns_transaction_t;
 
+/*
+ * Query names of the transactions, interned so that each distinct name is
+ * stored only once however many queries there are for it, and so that
+ * names can be compared by pointer.
+ */
+static wmem_map_t *dns_qnames;
+
 /* Structure containing conversation specific information */
 typedef struct _dns_conv_info_t {
   wmem_tree_t *pdus;
@@ -4281,6 +4290,8 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   int                name_len;
   nstime_t           delta = NSTIME_INIT_ZERO;
   gboolean           is_multiple_responds = FALSE;
+  volatile gboolean  qname_parsed = FALSE;
+  const gchar       *qname_interned = NULL;
 
   dns_data_offset = offset;
 
@@ -4360,15 +4371,42 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   key[2].length = 0;
   key[2].key = NULL;
 
+  /*
+   * Get the first query name and type, which both match the transaction
+   * and are used for the statistics.  A malformed question is reported
+   * when the questions are dissected.
+   */
+  TRY {
+    if (tvb_get_ntohs(tvb, offset + DNS_QUEST) > 0) {
+      get_dns_name_type_class(tvb, offset + DNS_HDRLEN, dns_data_offset, &name, &name_len, &qtype, &qclass);
+      qname_parsed = TRUE;
+    }
+  }
+  CATCH_NONFATAL_ERRORS {
+    qtype = 0;
+  }
+  ENDTRY;
+
   if (!pinfo->flags.in_error_pkt) {
     if (!pinfo->fd->visited) {
+      /* mDNS responses need not repeat the question. */
+      if (qname_parsed && !is_mdns) {
+        qname_interned = (const gchar *)wmem_map_lookup(dns_qnames, name);
+        if (qname_interned == NULL) {
+          qname_interned = wmem_strdup(wmem_file_scope(), name);
+          wmem_map_insert(dns_qnames, qname_interned, (void *)qname_interned);
+        }
+      }
+
       if (!(flags&F_RESPONSE)) {
         /* This is a request */
         gboolean new_transaction = FALSE;
 
         /* Check if we've seen this transaction before */
         dns_trans=(dns_transaction_t *)wmem_tree_lookup32_array_le(dns_info->pdus, key);
-        if ((dns_trans == NULL) || (dns_trans->id != reqresp_id) || (dns_trans->rep_frame > 0)) {
+        if ((dns_trans == NULL) || (dns_trans->id != reqresp_id) || (dns_trans->rep_frame > 0) ||
+            (dns_trans->qname != qname_interned) || (dns_trans->qtype != qtype)) {
+          /* A reused ID with a different question is a new query. */
           new_transaction = TRUE;
         } else {
           nstime_t request_delta;
@@ -4389,6 +4427,8 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
           dns_trans->req_time=pinfo->abs_ts;
           dns_trans->id = reqresp_id;
           dns_trans->multiple_responds=FALSE;
+          dns_trans->qname = qname_interned;
+          dns_trans->qtype = qtype;
           wmem_tree_insert32_array(dns_info->pdus, key, (void *)dns_trans);
         }
       } else {
@@ -4396,6 +4436,10 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
         if (dns_trans) {
           if (dns_trans->id != reqresp_id) {
             dns_trans = NULL;
+          } else if (qname_interned && dns_trans->qname &&
+                     (dns_trans->qname != qname_interned || dns_trans->qtype != qtype)) {
+            /* The response is to a different question. */
+            dns_trans = NULL;
           } else if (dns_trans->rep_frame == 0) {
             dns_trans->rep_frame=pinfo->num;
           } else if (!dns_trans->multiple_responds) {
@@ -4643,7 +4687,8 @@ dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     dns_stats->packet_opcode = opcode;
     dns_stats->packet_qr = flags >> 15;
     if (quest > 0) {
-      get_dns_name_type_class(tvb, offset + DNS_HDRLEN, dns_data_offset, &name, &name_len, &qtype, &qclass);
+      if (!qname_parsed)
+        get_dns_name_type_class(tvb, offset + DNS_HDRLEN, dns_data_offset, &name, &name_len, &qtype, &qclass);
       dns_stats->packet_qtype = qtype;
       dns_stats->packet_qclass = qclass;
     }
@@ -6667,6 +6712,8 @@ proto_register_dns(void)
   doq_handle = register_dissector("dns.doq", dissect_dns_doq, proto_dns);
 
   dns_tap = register_tap("dns");
+
+  dns_qnames = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_str_hash, g_str_equal);
 }
 
 /*
@@ -32,6 +32,7 @@
 #include <epan/prefs.h>
 #include <epan/proto_data.h>
 #include <epan/exceptions.h>
+#include <epan/crc32-tvb.h>
 #include "packet-http.h" /* for getting status reason-phrase */
 #include "packet-http2.h"
 #include "packet-media-type.h"
@@ -1174,9 +1175,82 @@ get_fake_header_value(packet_info* pinfo, const gchar* name, gboolean the_other_
 }
 #endif
 
+/*
+ * Uncompressed bodies are kept in file scope, so that later passes don't
+ * have to uncompress them again, as long as they take less than this much
+ * memory in total.
+ */
+#define HTTP2_UNCOMPRESSED_CACHE_MAX_SIZE   (64 * 1024 * 1024)
+
+/* The per-frame proto data keys of the cached bodies start here. */
+#define HTTP2_UNCOMPRESSED_KEY_BASE         0x10000
+
+typedef struct {
+    guint32 compressed_len;
+    guint32 compressed_crc;     /* to check that it's the same body */
+    gboolean failed;
+    guint32 len;
+    guint8 *data;
+} http2_uncompressed_t;
+
+static gsize http2_uncompressed_cache_size;
+
+tvbuff_t *
+http2_cached_uncompress(tvbuff_t *tvb, packet_info *pinfo, int proto, int offset, int length,
+                        http2_uncompress_func uncompress)
+{
+    guint32 *seq;
+    guint32 key, crc;
+    http2_uncompressed_t *cached;
+    tvbuff_t *uncompressed_tvb;
+
+    if (length <= 0 || tvb_captured_length_remaining(tvb, offset) < length) {
+        return uncompress(tvb, tvb, offset, length);
+    }
+
+    /* The bodies of a frame are uncompressed in the same order on
+     * every pass, so the nth one of the frame is the same body. */
+    seq = (guint32 *)p_get_proto_data(pinfo->pool, pinfo, proto, HTTP2_UNCOMPRESSED_KEY_BASE);
+    if (!seq) {
+        seq = wmem_new0(pinfo->pool, guint32);
+        p_add_proto_data(pinfo->pool, pinfo, proto, HTTP2_UNCOMPRESSED_KEY_BASE, seq);
+    }
+    key = HTTP2_UNCOMPRESSED_KEY_BASE + 1 + (*seq)++;
+
+    crc = crc32_ccitt_tvb_offset(tvb, offset, length);
+    cached = (http2_uncompressed_t *)p_get_proto_data(wmem_file_scope(), pinfo, proto, key);
+    if (cached && cached->compressed_len == (guint32)length && cached->compressed_crc == crc) {
+        if (cached->failed) {
+            return NULL;
+        }
+        return tvb_new_child_real_data(tvb, cached->data, cached->len, cached->len);
+    }
+
+    uncompressed_tvb = uncompress(tvb, tvb, offset, length);
+
+    if (!cached) {
+        guint len = uncompressed_tvb ? tvb_captured_length(uncompressed_tvb) : 0;
+
+        if (http2_uncompressed_cache_size + len <= HTTP2_UNCOMPRESSED_CACHE_MAX_SIZE) {
+            cached = wmem_new(wmem_file_scope(), http2_uncompressed_t);
+            cached->compressed_len = length;
+            cached->compressed_crc = crc;
+            cached->failed = (uncompressed_tvb == NULL);
+            cached->len = len;
+            cached->data = len ? (guint8 *)tvb_memdup(wmem_file_scope(), uncompressed_tvb, 0, len) : NULL;
+            p_add_proto_data(wmem_file_scope(), pinfo, proto, key, cached);
+            http2_uncompressed_cache_size += len;
+        }
+    }
+
+    return uncompressed_tvb;
+}
+
 static void
 http2_init_protocol(void)
 {
+    http2_uncompressed_cache_size = 0;
+
     /* Init hash table with mapping of stream id -> frames count for Follow HTTP2 */
     streamid_hash = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify)g_hash_table_destroy);
 }
@@ -2880,9 +2954,9 @@ dissect_http2_data_full_body(tvbuff_t *tvb, packet_info *pinfo, http2_session_t*
 
         tvbuff_t *uncompressed_tvb = NULL;
         if (uncompression == BODY_UNCOMPRESSION_ZLIB) {
-            uncompressed_tvb = tvb_child_uncompress(tvb, tvb, 0, datalen);
+            uncompressed_tvb = http2_cached_uncompress(tvb, pinfo, proto_http2, 0, datalen, tvb_child_uncompress);
         } else if (uncompression == BODY_UNCOMPRESSION_BROTLI) {
-            uncompressed_tvb = tvb_child_uncompress_brotli(tvb, tvb, 0, datalen);
+            uncompressed_tvb = http2_cached_uncompress(tvb, pinfo, proto_http2, 0, datalen, tvb_child_uncompress_brotli);
         }
 
         http2_data_stream_body_info_t *body_info = get_data_stream_body_info(pinfo, h2session);
@@ -31,6 +31,23 @@ extern "C" {
 
 int dissect_http2_pdu(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_ );
 
+typedef tvbuff_t *(*http2_uncompress_func)(tvbuff_t *parent, tvbuff_t *tvb, const int offset, int comprlen);
+
+/** Uncompress a body, as tvb_child_uncompress() or tvb_child_uncompress_brotli()
+ * would, keeping the result in file scope so that later passes over the frame
+ * get it without uncompressing the body again.
+ * @param tvb  the tvb holding the compressed body; the result is its child.
+ * @param pinfo  packet info pointer.
+ * @param proto  the protocol of the caller, whose per-frame proto data holds
+ *               the results; its own keys must be below 0x10000.
+ * @param offset  offset of the compressed body in tvb.
+ * @param length  length of the compressed body.
+ * @param uncompress  the function that uncompresses it.
+ * @return  the uncompressed body, or NULL if it could not be uncompressed.
+ */
+tvbuff_t *http2_cached_uncompress(tvbuff_t *tvb, packet_info *pinfo, int proto, int offset, int length,
+                                  http2_uncompress_func uncompress);
+
 /** Get header value from current or the other direction stream.
  * Return the value of a header if it appear in previous HEADERS or PROMISE frames in
  * current or the other direction stream. Subdissector may invoke this function to get http2
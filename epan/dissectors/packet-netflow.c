@@ -327,6 +327,7 @@ typedef struct _v9_v10_tmplt {
     guint    length;
     guint16  field_count[TF_NUM];                /* 0:scopes; 1:entries  */
     v9_v10_tmplt_entry_t *fields_p[TF_NUM_EXT];  /* 0:scopes; 1:entries; n:vendor_entries  */
+    gboolean records_skippable;                  /* See v9_v10_tmplt_records_skippable() */
 } v9_v10_tmplt_t;
 
 
@@ -4154,6 +4155,7 @@ static int      flow_process_sizecount(proto_tree *pdutree, tvbuff_t *tvb,
                                        int offset);
 
 static v9_v10_tmplt_t *v9_v10_tmplt_build_key(v9_v10_tmplt_t *tmplt_p, packet_info *pinfo, guint32 src_id, guint16 tmplt_id);
+static gboolean v9_v10_tmplt_records_skippable(const v9_v10_tmplt_t *tmplt_p);
 
 
 static int
@@ -4981,6 +4983,12 @@ dissect_v9_v10_data(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdutree, int
         int count = 1;
         proto_item *ti;
 
+        if ((pdutree == NULL) && tmplt_p->records_skippable) {
+            /* Without a tree there is nothing to do for these records but count them */
+            *flows_seen += length / tmplt_p->length;
+            return (0);
+        }
+
         /* Provide a link back to template frame */
         ti = proto_tree_add_uint(pdutree, hf_template_frame, tvb,
                                  0, 0, tmplt_p->template_frame_number);
@@ -12926,6 +12934,7 @@ dissect_v9_v10_options_template(tvbuff_t *tvb, packet_info *pinfo, proto_tree *p
             copy_address_wmem(wmem_file_scope(), &tmplt_p->dst_addr, &pinfo->net_dst);
             /* Remember when we saw this template */
             tmplt_p->template_frame_number = pinfo->num;
+            tmplt_p->records_skippable = v9_v10_tmplt_records_skippable(tmplt_p);
             /* Add completed entry into table */
             wmem_map_insert(v9_v10_tmplt_table, tmplt_p, tmplt_p);
         }
@@ -13034,6 +13043,7 @@ dissect_v9_v10_data_template(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdut
             copy_address_wmem(wmem_file_scope(), &tmplt_p->dst_addr, &pinfo->net_dst);
             /* Remember when we saw this template */
             tmplt_p->template_frame_number = pinfo->num;
+            tmplt_p->records_skippable = v9_v10_tmplt_records_skippable(tmplt_p);
             wmem_map_insert(v9_v10_tmplt_table, tmplt_p, tmplt_p);
 
             /* Create if necessary observation domain entry (for use with sequence analysis) */
@@ -13055,6 +13065,44 @@ dissect_v9_v10_data_template(tvbuff_t *tvb, packet_info *pinfo, proto_tree *pdut
     return length;
 }
 
+/* Check whether the records of a template have a fixed length and contain
+   no fields whose dissection does anything other than add tree items, so
+   that they can be skipped when there's no tree. */
+static gboolean
+v9_v10_tmplt_records_skippable(const v9_v10_tmplt_t *tmplt_p)
+{
+    int ft, i;
+
+    /* XXX - These IDs are currently hard-coded in procflow.py; see the end
+       of dissect_v9_v10_pdu_data(). */
+    if ((tmplt_p->tmplt_id >= 256) && (tmplt_p->tmplt_id <= 259))
+        return FALSE;
+
+    for (ft = TF_SCOPES; ft < TF_NUM; ft++) {
+        const v9_v10_tmplt_entry_t *entries_p = tmplt_p->fields_p[ft];
+
+        if (entries_p == NULL)
+            continue;
+        for (i = 0; i < tmplt_p->field_count[ft]; i++) {
+            if (entries_p[i].length == VARIABLE_LENGTH)
+                return FALSE;
+            /* Several Ixia fields are subTemplateLists */
+            if (entries_p[i].pen == VENDOR_IXIA)
+                return FALSE;
+            switch (entries_p[i].type & 0x7fff) {
+            case 291: /* basicList */
+            case 292: /* subTemplateList */
+            case 293: /* subTemplateMultiList */
+            case 315: /* Data Link Frame Section */
+                return FALSE;
+            default:
+                break;
+            }
+        }
+    }
+    return TRUE;
+}
+
 /* build temporary key */
 /* Note: address at *(pinfo->net_???.data) is *not* copied */
 static v9_v10_tmplt_t *v9_v10_tmplt_build_key(v9_v10_tmplt_t *tmplt_p, packet_info *pinfo, guint32 src_id, guint16 tmplt_id)
@@ -25,6 +25,7 @@ proper helper routines
 #include <epan/asn1.h>
 #include <epan/expert.h>
 #include <wsutil/str_util.h>
+#include <wsutil/bits_ctz.h>
 #include "packet-per.h"
 
 void proto_register_per(void);
@@ -304,8 +305,6 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 	guint32 len;
 	proto_item *pi;
 	int num_bits;
-	int i, bit, str_length, str_index;
-	gboolean tmp;
 
 	if(!length){
 		length=&len;
@@ -320,56 +319,37 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 		byte=tvb_get_guint8(tvb, offset>>3);
 		offset+=8;
 	}else{
-		char *str;
+		guint32 bit_offset = offset;
+		char *str = NULL;
 		guint32 val;
 
-		val = 0;
-
-		/* prepare the string (max number of bits + quartet separators + prepended space) */
-		str_length = 256+64+1;
-		str=(char *)wmem_alloc(wmem_packet_scope(), str_length+1);
-		str_index = 0;
-
-		str_length = snprintf(str, str_length+1, " ");
-		for(bit=0;bit<((int)(offset&0x07));bit++){
-			if(bit&&(!(bit%4))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			if (str_index < str_length) str[str_index++] = '.';
+		/*
+		 * Read the whole octet (or two) at once rather than bit by
+		 * bit, and only spell out the bits when they are shown.
+		 */
+		if (!is_fragmented && tvb_get_bits8(tvb, offset, 2) == 3) {
+			/* bits 8 and 7 both 1, so unconstrained */
+			*length = 0;
+			actx->created_item = NULL;
+			dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "10.9 Unconstrained");
+			return offset+2;
 		}
-		/* read the bits for the int */
+		val = tvb_get_bits8(tvb, offset, 8);
+		offset += 8;
 		num_bits = 8;
-		for(i=0;i<num_bits;i++){
-			if(bit&&(!(bit%4))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			if(bit&&(!(bit%8))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			bit++;
-			offset=dissect_per_boolean(tvb, offset, actx, tree, -1, &tmp);
-			val<<=1;
-			if(tmp){
-				val|=1;
-				if (str_index < str_length) str[str_index++] = '1';
-				if (i==0) { /* bit 8 is 1, so not a single byte length */
-					num_bits = 16;
-				}
-				else if (i==1 && val==3) { /* bits 8 and 7 both 1, so unconstrained */
-					if (!is_fragmented) {
-						*length = 0;
-						dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "10.9 Unconstrained");
-						return offset;
-					} else {
-						num_bits = 8;
-						*is_fragmented = TRUE;
-					}
-				}
-			} else {
-				if (str_index < str_length) str[str_index++] = '0';
-			}
+		if ((val&0xc0) == 0xc0) {
+			*is_fragmented = TRUE;
+		} else if (val&0x80) {
+			/* bit 8 is 1, so not a single byte length */
+			val = (val<<8) | tvb_get_bits8(tvb, offset, 8);
+			offset += 8;
+			num_bits = 16;
 		}
-		str[str_index] = '\0'; /* Terminate string */
+		actx->created_item = NULL;
+		if (hf_index > 0 && tree && display_internal_per_fields) {
+			str = decode_bits_in_field(actx->pinfo->pool, bit_offset&0x07, num_bits, val, ENC_BIG_ENDIAN);
+		}
+
 		if(is_fragmented && *is_fragmented==TRUE){
 			*length = val&0x3f;
 			if (*length>4 || *length==0) {
@@ -379,44 +359,20 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 				return offset;
 			}
 			*length *= 0x4000;
-			if(hf_index > 0){
-				pi = proto_tree_add_uint(tree, hf_index, tvb, (offset>>3)-1, 1, *length);
-				if (display_internal_per_fields)
-					proto_item_append_text(pi," %s", str);
-				else
-					proto_item_set_hidden(pi);
-			}
-
-			return offset;
-		}
-		else if((val&0x80)==0 && num_bits==8){
+		} else if (num_bits==8) {
 			*length = val;
-			if(hf_index > 0){
-				pi = proto_tree_add_uint(tree, hf_index, tvb, (offset>>3)-1, 1, *length);
-				if (display_internal_per_fields)
-					proto_item_append_text(pi," %s", str);
-				else
-					proto_item_set_hidden(pi);
-			}
-
-			return offset;
-		}
-		else if (num_bits==16) {
+		} else {
 			*length = val&0x3fff;
-			if(hf_index > 0){
-				pi = proto_tree_add_uint(tree, hf_index, tvb, (offset>>3)-2, 2, *length);
-				if (display_internal_per_fields)
-					proto_item_append_text(pi," %s", str);
-				else
-					proto_item_set_hidden(pi);
-			}
-
-			return offset;
 		}
-		*length = 0;
-		dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "10.9 Unaligned");
-		return offset;
+		if(hf_index > 0){
+			pi = proto_tree_add_uint(tree, hf_index, tvb, (offset>>3)-(num_bits>>3), num_bits>>3, *length);
+			if (str)
+				proto_item_append_text(pi," %s", str);
+			else
+				proto_item_set_hidden(pi);
+		}
 
+		return offset;
 	}
 
 	/* 10.9.3.6 */
@@ -1393,21 +1349,10 @@ DEBUG_ENTRY("dissect_per_constrained_integer");
 		 * number of bits necessary to represent the range.
 		 */
 		char *str;
-		int i, length;
-		guint32 mask,mask2;
-		/* We only handle 32 bit integers */
-		mask  = 0x80000000;
-		mask2 = 0x7fffffff;
-		i = 32;
-		while ((range & mask)== 0){
-			i = i - 1;
-			mask = mask>>1;
-			mask2 = mask2>>1;
-		}
-		if ((range & mask2) == 0)
-			i = i-1;
+		int length;
 
-		num_bits = i;
+		/* We only handle 32 bit integers; range is at least 2 here. */
+		num_bits = ws_ilog2(range - 1) + 1;
 		length=(num_bits+7)>>3;
 		if(range<=2){
 			num_bits=1;
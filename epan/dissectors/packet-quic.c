@@ -2982,32 +2982,39 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
     err = gcry_cipher_setiv(pp_cipher->pp_cipher, nonce, TLS13_AEAD_NONCE_LENGTH);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (setiv) failed: %s", gcry_strerror(err));
-        return;
+        goto failed;
     }
 
     /* associated data (A) is the contents of QUIC header */
     err = gcry_cipher_authenticate(pp_cipher->pp_cipher, header, header_length);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (authenticate) failed: %s", gcry_strerror(err));
-        return;
+        goto failed;
     }
 
     /* Output ciphertext (C) */
     err = gcry_cipher_decrypt(pp_cipher->pp_cipher, buffer, buffer_length, NULL, 0);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (decrypt) failed: %s", gcry_strerror(err));
-        return;
+        goto failed;
     }
 
     err = gcry_cipher_checktag(pp_cipher->pp_cipher, atag, 16);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (checktag) failed: %s", gcry_strerror(err));
-        return;
+        goto failed;
     }
 
     result->error = NULL;
     result->data = buffer;
     result->data_len = buffer_length;
+    return;
+
+failed:
+    /* Nothing keeps the ciphertext copy, give it back now rather than
+     * at the end of the file (trial decryptions of misdetected packets
+     * can fail often). */
+    wmem_free(wmem_file_scope(), buffer);
 }
 
 static gboolean
@@ -4955,7 +4962,7 @@ follow_quic_tap_listener(void *tapdata, packet_info *pinfo, epan_dissect_t *edt
 
     follow_info->bytes_written[follow_record->is_server] += follow_record->data->len;
 
-    follow_info->payload = g_list_prepend(follow_info->payload, follow_record);
+    follow_add_record(follow_info, follow_record);
     return TAP_PACKET_DONT_REDRAW;
 }
 
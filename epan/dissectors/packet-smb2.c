@@ -6396,6 +6396,18 @@ smb2_pipe_set_file_id(packet_info *pinfo, smb2_info_t *si)
 	dcerpc_set_transport_salt(persistent, pinfo);
 }
 
+/*
+ * READ and WRITE data can only be named pipe traffic on a pipe share.
+ * If we saw the tree connect and it was for anything else, the data is
+ * file contents, and there is no point in handing it (possibly megabytes
+ * of it per request) to the pipe heuristics and reassembly.
+ */
+static gboolean
+smb2_data_may_be_pipe(const smb2_info_t *si)
+{
+	return si->tree == NULL || si->tree->share_type == SMB2_SHARE_TYPE_PIPE;
+}
+
 static gboolean smb2_pipe_reassembly = TRUE;
 static gboolean smb2_verify_signatures = FALSE;
 static reassembly_table smb2_pipe_reassembly_table;
@@ -6742,7 +6754,7 @@ dissect_smb2_write_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 	data_tvb_len=(guint32)tvb_captured_length_remaining(tvb, offset);
 
 	/* data or namedpipe ?*/
-	if (length) {
+	if (length && smb2_data_may_be_pipe(si)) {
 		int oldoffset = offset;
 		smb2_pipe_set_file_id(pinfo, si);
 		offset = dissect_file_data_smb2_pipe(tvb, pinfo, tree, offset, length, si->top_tree, si);
@@ -8267,12 +8279,14 @@ dissect_smb2_read_blob(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, smb2
 	gint offset = 0;
 	gint length = tvb_captured_length_remaining(tvb, offset);
 
-	smb2_pipe_set_file_id(pinfo, si);
+	if (smb2_data_may_be_pipe(si)) {
+		smb2_pipe_set_file_id(pinfo, si);
 
-	offset = dissect_file_data_smb2_pipe(tvb, pinfo, tree, offset, length, si->top_tree, si);
-	if (offset != 0) {
-		/* managed to dissect pipe data */
-		return;
+		offset = dissect_file_data_smb2_pipe(tvb, pinfo, tree, offset, length, si->top_tree, si);
+		if (offset != 0) {
+			/* managed to dissect pipe data */
+			return;
+		}
 	}
 
 	/* data */
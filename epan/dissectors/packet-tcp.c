@@ -740,6 +740,7 @@ static capture_dissector_handle_t tcp_cap_handle;
 
 static guint32 tcp_stream_count;
 static guint32 mptcp_stream_count;
+static wmem_array_t *tcp_stream_conversations; /* conversation_t *, indexed by stream */
 
 
 
@@ -1282,7 +1283,7 @@ check_follow_fragments(follow_info_t *follow_info, gboolean is_server, guint32 a
                                                               fragment->data->data + new_pos,
                                                               new_frag_size);
 
-                    follow_info->payload = g_list_prepend(follow_info->payload, follow_record);
+                    follow_add_record(follow_info, follow_record);
                 }
 
                 follow_info->seq[is_server] += (fragment->data->len - new_pos);
@@ -1300,7 +1301,7 @@ check_follow_fragments(follow_info_t *follow_info, gboolean is_server, guint32 a
         if( EQ_SEQ(fragment->seq, follow_info->seq[is_server]) ) {
             /* this fragment fits the stream */
             if( fragment->data->len > 0 ) {
-                follow_info->payload = g_list_prepend(follow_info->payload, fragment);
+                follow_add_record(follow_info, fragment);
             }
 
             follow_info->seq[is_server] += fragment->data->len;
@@ -1329,7 +1330,7 @@ check_follow_fragments(follow_info_t *follow_info, gboolean is_server, guint32 a
         follow_record->seq = lowest_seq;
 
         follow_info->seq[is_server] = lowest_seq;
-        follow_info->payload = g_list_prepend(follow_info->payload, follow_record);
+        follow_add_record(follow_info, follow_record);
         return TRUE;
     }
 
@@ -1421,7 +1422,7 @@ follow_tcp_tap_listener(void *tapdata, packet_info *pinfo,
         /* The segment overlaps or extends the previous end of stream. */
         follow_info->seq[is_server] += length;
         follow_info->bytes_written[is_server] += follow_record->data->len;
-        follow_info->payload = g_list_prepend(follow_info->payload, follow_record);
+        follow_add_record(follow_info, follow_record);
 
         /* done with the packet, see if it caused a fragment to fit */
         while(check_follow_fragments(follow_info, is_server, 0, pinfo->fd->num, FALSE));
@@ -1675,6 +1676,9 @@ static gboolean tcp_analyze_mptcp                   = TRUE;
 static gboolean mptcp_relative_seq                  = TRUE;
 static gboolean mptcp_analyze_mappings              = FALSE;
 static gboolean mptcp_intersubflows_retransmission  = FALSE;
+static guint    mptcp_max_mappings_per_subflow      = 0;
+
+static mptcp_mapping_stats_t mptcp_mapping_stats;
 
 
 #define TCP_A_RETRANSMISSION          0x0001
@@ -1875,6 +1879,7 @@ get_tcp_conversation_data(conversation_t *conv, packet_info *pinfo)
     if (!tcpd) {
         tcpd = init_tcp_conversation_data(pinfo, direction);
         conversation_add_proto_data(conv, proto_tcp, tcpd);
+        wmem_array_append_one(tcp_stream_conversations, conv);
     }
 
     if (!tcpd) {
@@ -1941,6 +1946,16 @@ guint32 get_tcp_stream_count(void)
     return tcp_stream_count;
 }
 
+const guint32 *
+get_tcp_stream_frames(guint32 stream, guint *num_frames)
+{
+    if (stream >= wmem_array_get_count(tcp_stream_conversations)) {
+        *num_frames = 0;
+        return NULL;
+    }
+    return conversation_get_frames(*(conversation_t **)wmem_array_index(tcp_stream_conversations, stream), num_frames);
+}
+
 /* Return the mptcp current stream count */
 guint32 get_mptcp_stream_count(void)
 {
@@ -2199,12 +2214,148 @@ tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean c
 
 
 
+/*
+ * The i'th oldest segment not ACKed yet.
+ */
+static inline tcp_unacked_t *
+tcp_unacked_segment(tcp_analyze_seq_flow_info_t *info, guint i)
+{
+    return &info->segments[(info->segment_first + i) & (info->segment_capacity - 1)];
+}
+
+static void
+tcp_unacked_segment_add(tcp_analyze_seq_flow_info_t *info, guint32 frame,
+                        guint32 seq, guint32 nextseq, const nstime_t *ts)
+{
+    tcp_unacked_t *ual;
+
+    if (info->segment_count == info->segment_capacity) {
+        guint16 capacity = info->segment_capacity ? info->segment_capacity * 2 : 16;
+        tcp_unacked_t *segments = wmem_alloc_array(wmem_file_scope(), tcp_unacked_t, capacity);
+
+        for (guint i = 0; i < info->segment_count; i++) {
+            segments[i] = *tcp_unacked_segment(info, i);
+        }
+        wmem_free(wmem_file_scope(), info->segments);
+        info->segments = segments;
+        info->segment_first = 0;
+        info->segment_capacity = capacity;
+    }
+
+    if (info->segment_count == 0) {
+        info->segments_sorted = TRUE;
+    } else if (LT_SEQ(nextseq, tcp_unacked_segment(info, info->segment_count - 1)->nextseq)) {
+        info->segments_sorted = FALSE;
+    }
+    if (nextseq - seq > info->segment_max_len) {
+        info->segment_max_len = nextseq - seq;
+    }
+
+    ual = tcp_unacked_segment(info, info->segment_count);
+    info->segment_count++;
+    ual->frame = frame;
+    ual->seq = seq;
+    ual->nextseq = nextseq;
+    ual->ts = *ts;
+}
+
+/*
+ * Remove the segments in the reverse direction that an ACK acknowledges,
+ * and trim those it acknowledges part of.  If the ACK matches the end of
+ * a segment, it's recorded as the one ACKed (the oldest one, if several
+ * match).
+ */
+static void
+tcp_remove_acked_segments(packet_info *pinfo, guint32 seq, guint32 ack, struct tcp_analysis *tcpd)
+{
+    tcp_analyze_seq_flow_info_t *info = tcpd->rev->tcp_analyze_seq_info;
+    gboolean acked_found = FALSE;
+    guint i, kept;
+    tcp_unacked_t *ual;
+
+    if (info->segments_sorted) {
+        /* Everything ACKed is at the start. */
+        while (info->segment_count) {
+            ual = tcp_unacked_segment(info, 0);
+            if (GT_SEQ(ual->nextseq, ack)) {
+                break;
+            }
+            if (ack == ual->nextseq && !acked_found) {
+                tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
+                tcpd->ta->frame_acked=ual->frame;
+                nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &ual->ts);
+                acked_found = TRUE;
+            }
+            if (tcpd->rev->scps_capable) {
+              /* Track largest segment successfully sent for SNACK analysis*/
+              if ((ual->nextseq - ual->seq) > tcpd->fwd->maxsizeacked) {
+                tcpd->fwd->maxsizeacked = (ual->nextseq - ual->seq);
+              }
+            }
+            info->segment_first = (info->segment_first + 1) & (info->segment_capacity - 1);
+            info->segment_count--;
+        }
+
+        /* A segment this acknowledges part of ends less than the longest
+         * segment past the ACK. */
+        for (i = 0; i < info->segment_count; i++) {
+            ual = tcp_unacked_segment(info, i);
+            if (GE_SEQ(ual->nextseq, ack + info->segment_max_len)) {
+                break;
+            }
+            if (GT_SEQ(ack, ual->seq)) {
+                ual->seq = ack;
+            }
+        }
+        return;
+    }
+
+    /* Look at every segment, oldest first, keeping those not ACKed. */
+    kept = 0;
+    info->segments_sorted = TRUE;
+    for (i = 0; i < info->segment_count; i++) {
+        ual = tcp_unacked_segment(info, i);
+
+        /* If this acknowledges a segment prior to this one, leave this segment alone and move on */
+        if (GT_SEQ(ual->nextseq, ack)) {
+            /* If this acknowledges part of the segment, adjust the segment info for the acked part */
+            if (GT_SEQ(ack, ual->seq)) {
+                ual->seq = ack;
+            }
+            if (kept && LT_SEQ(ual->nextseq, tcp_unacked_segment(info, kept - 1)->nextseq)) {
+                info->segments_sorted = FALSE;
+            }
+            *tcp_unacked_segment(info, kept++) = *ual;
+            continue;
+        }
+
+        /* This segment is old, or an exact match.  Delete the segment from the list */
+        if (ack == ual->nextseq && !acked_found) {
+            tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
+            tcpd->ta->frame_acked=ual->frame;
+            nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &ual->ts);
+            acked_found = TRUE;
+        }
+        if (tcpd->rev->scps_capable) {
+          /* Track largest segment successfully sent for SNACK analysis*/
+          if ((ual->nextseq - ual->seq) > tcpd->fwd->maxsizeacked) {
+            tcpd->fwd->maxsizeacked = (ual->nextseq - ual->seq);
+          }
+        }
+    }
+    info->segment_count = kept;
+}
+
 /* fwd contains a list of all segments processed but not yet ACKed in the
  *     same direction as the current segment.
  * rev contains a list of all segments received but not yet ACKed in the
  *     opposite direction to the current segment.
  *
- * New segments are always added to the head of the fwd/rev lists.
+ * New segments are always added to the end of the fwd/rev lists, and
+ * the lists are searched newest first.  As long as the segments are
+ * sorted by nextseq, which they are unless there were retransmissions,
+ * the segments an ACK acknowledges are at the start of the list and are
+ * removed without looking at the others.
  *
  * Changes below should be synced with ChAdvTCPAnalysis in the User's
  * Guide: docbook/wsug_src/WSUG_chapter_advanced.adoc
@@ -2213,17 +2364,20 @@ static void
 tcp_analyze_sequence_number(packet_info *pinfo, guint32 seq, guint32 ack, guint32 seglen, guint16 flags, guint32 window, struct tcp_analysis *tcpd, struct tcp_per_packet_data_t *tcppd)
 {
     tcp_unacked_t *ual=NULL;
-    tcp_unacked_t *prevual=NULL;
     guint32 nextseq;
 
 #if 0
     printf("\nanalyze_sequence numbers   frame:%u\n",pinfo->num);
     printf("FWD list lastflags:0x%04x base_seq:%u: nextseq:%u lastack:%u\n",tcpd->fwd->lastsegmentflags,tcpd->fwd->base_seq,tcpd->fwd->tcp_analyze_seq_info->nextseq,tcpd->rev->tcp_analyze_seq_info->lastack);
-    for(ual=tcpd->fwd->tcp_analyze_seq_info->segments; ual; ual=ual->next)
+    for(guint i=0; i<tcpd->fwd->tcp_analyze_seq_info->segment_count; i++) {
+            ual=tcp_unacked_segment(tcpd->fwd->tcp_analyze_seq_info, i);
             printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    }
     printf("REV list lastflags:0x%04x base_seq:%u nextseq:%u lastack:%u\n",tcpd->rev->lastsegmentflags,tcpd->rev->base_seq,tcpd->rev->tcp_analyze_seq_info->nextseq,tcpd->fwd->tcp_analyze_seq_info->lastack);
-    for(ual=tcpd->rev->tcp_analyze_seq_info->segments; ual; ual=ual->next)
+    for(guint i=0; i<tcpd->rev->tcp_analyze_seq_info->segment_count; i++) {
+            ual=tcp_unacked_segment(tcpd->rev->tcp_analyze_seq_info, i);
             printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    }
 #endif
 
     if (!tcpd) {
@@ -2453,8 +2607,8 @@ finished_fwd:
              */
             gboolean is_seq_in_unacked = FALSE;
             guint32 maxseqtail = ack;
-            ual = tcpd->rev->tcp_analyze_seq_info->segments;
-            while(ual) {
+            for(guint i=tcpd->rev->tcp_analyze_seq_info->segment_count; i-- > 0; ) {
+                ual = tcp_unacked_segment(tcpd->rev->tcp_analyze_seq_info, i);
                 /* prevent false positives */
                 if(GT_SEQ(ack,ual->seq) && LE_SEQ(ack,ual->nextseq)) {
                     is_seq_in_unacked = TRUE;
@@ -2463,7 +2617,6 @@ finished_fwd:
                 if(maxseqtail==ual->seq) {
                     maxseqtail = ual->nextseq;
                 }
-                ual=ual->next;
             }
 
             /* update 'max seq to be acked' in the other direction so we don't get
@@ -2599,13 +2752,12 @@ finished_fwd:
                      * XXX: if compared packets have different sizes, it's not handled yet
                      */
                     gboolean pk_already_seen = FALSE;
-                    ual = tcpd->fwd->tcp_analyze_seq_info->segments;
-                    while(ual) {
+                    for(guint i=tcpd->fwd->tcp_analyze_seq_info->segment_count; i-- > 0; ) {
+                        ual = tcp_unacked_segment(tcpd->fwd->tcp_analyze_seq_info, i);
                         if(GE_SEQ(seq,ual->seq) && LE_SEQ(seq+seglen,ual->nextseq)) {
                             pk_already_seen = TRUE;
                             break;
                         }
-                        ual=ual->next;
                     }
 
                     if(seq_not_advanced && t < ooo_thres && !pk_already_seen) {
@@ -2659,13 +2811,12 @@ finished_fwd:
              * See : issue #12259
              * See : issue #17714
              */
-            ual = tcpd->fwd->tcp_analyze_seq_info->segments;
-            while(ual) {
+            for(guint i=tcpd->fwd->tcp_analyze_seq_info->segment_count; i-- > 0; ) {
+                ual = tcp_unacked_segment(tcpd->fwd->tcp_analyze_seq_info, i);
                 if(GE_SEQ(ual->seq, seq)) {
                     nstime_delta(&tcpd->ta->rto_ts, &pinfo->abs_ts, &ual->ts );
                     tcpd->ta->rto_frame=ual->frame;
                 }
-                ual=ual->next;
             }
         }
     }
@@ -2724,19 +2875,12 @@ finished_checking_retransmission_type:
         /* Add this new sequence number to the fwd list.  But only if there
          * aren't "too many" unacked segments (e.g., we're not seeing the ACKs).
          */
-        ual = wmem_new(wmem_file_scope(), tcp_unacked_t);
-        ual->next=tcpd->fwd->tcp_analyze_seq_info->segments;
-        tcpd->fwd->tcp_analyze_seq_info->segments=ual;
-        tcpd->fwd->tcp_analyze_seq_info->segment_count++;
-        ual->frame=pinfo->num;
-        ual->seq=seq;
-        ual->ts=pinfo->abs_ts;
 
         /* next sequence number is seglen bytes away, plus SYN/FIN which counts as one byte */
         if( (flags&(TH_SYN|TH_FIN)) ) {
             nextseq+=1;
         }
-        ual->nextseq=nextseq;
+        tcp_unacked_segment_add(tcpd->fwd->tcp_analyze_seq_info, pinfo->num, seq, nextseq, &pinfo->abs_ts);
     }
 
     /* Every time we are moving the highest number seen,
@@ -2800,49 +2944,7 @@ finished_checking_retransmission_type:
 
     /* remove all segments this ACKs and we don't need to keep around any more
      */
-    prevual = NULL;
-    ual = tcpd->rev->tcp_analyze_seq_info->segments;
-    while(ual) {
-        tcp_unacked_t *tmpual;
-
-        /* If this ack matches the segment, process accordingly */
-        if(ack==ual->nextseq) {
-            tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
-            tcpd->ta->frame_acked=ual->frame;
-            nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &ual->ts);
-        }
-        /* If this acknowledges part of the segment, adjust the segment info for the acked part */
-        else if (GT_SEQ(ack, ual->seq) && LE_SEQ(ack, ual->nextseq)) {
-            ual->seq = ack;
-            continue;
-        }
-        /* If this acknowledges a segment prior to this one, leave this segment alone and move on */
-        else if (GT_SEQ(ual->nextseq,ack)) {
-            prevual = ual;
-            ual = ual->next;
-            continue;
-        }
-
-        /* This segment is old, or an exact match.  Delete the segment from the list */
-        tmpual=ual->next;
-
-        if (tcpd->rev->scps_capable) {
-          /* Track largest segment successfully sent for SNACK analysis*/
-          if ((ual->nextseq - ual->seq) > tcpd->fwd->maxsizeacked) {
-            tcpd->fwd->maxsizeacked = (ual->nextseq - ual->seq);
-          }
-        }
-
-        if (!prevual) {
-            tcpd->rev->tcp_analyze_seq_info->segments = tmpual;
-        }
-        else{
-            prevual->next = tmpual;
-        }
-        wmem_free(wmem_file_scope(), ual);
-        ual = tmpual;
-        tcpd->rev->tcp_analyze_seq_info->segment_count--;
-    }
+    tcp_remove_acked_segments(pinfo, seq, ack, tcpd);
 
     /* how many bytes of data are there in flight after this frame
      * was sent
@@ -2864,23 +2966,24 @@ finished_checking_retransmission_type:
          * by now still the default.
          */
         if(!tcp_bif_seq_based) {
-            ual=tcpd->fwd->tcp_analyze_seq_info->segments;
+            tcp_analyze_seq_flow_info_t *info = tcpd->fwd->tcp_analyze_seq_info;
 
-            if (seglen!=0 && ual && tcpd->fwd->valid_bif) {
+            if (seglen!=0 && info->segment_count && tcpd->fwd->valid_bif) {
                 guint32 first_seq, last_seq;
 
                 dry_bif_handling = TRUE;
 
+                ual = tcp_unacked_segment(info, info->segment_count - 1);
                 first_seq = ual->seq - tcpd->fwd->base_seq;
                 last_seq = ual->nextseq - tcpd->fwd->base_seq;
-                while (ual) {
+                for (guint i = 0; i < info->segment_count; i++) {
+                    ual = tcp_unacked_segment(info, i);
                     if ((ual->nextseq-tcpd->fwd->base_seq)>last_seq) {
                         last_seq = ual->nextseq-tcpd->fwd->base_seq;
                     }
                     if ((ual->seq-tcpd->fwd->base_seq)<first_seq) {
                         first_seq = ual->seq-tcpd->fwd->base_seq;
                     }
-                    ual = ual->next;
                 }
                 in_flight = last_seq-first_seq;
             }
@@ -3357,16 +3460,25 @@ mptcp_analysis_dsn_lookup(packet_info *pinfo , tvbuff_t *tvb,
             && !PINFO_FD_VISITED(pinfo)
             && tcph->th_seglen > 0
           ) {
+            struct mptcp_subflow *sf = tcpd->fwd->mptcp_subflow;
+
+            if (mptcp_max_mappings_per_subflow && sf->num_dsn2packet >= mptcp_max_mappings_per_subflow) {
+                mptcp_mapping_stats.dropped++;
+            } else {
                 mptcp_dsn2packet_mapping_t *packet = 0;
                 packet = wmem_new0(wmem_file_scope(), mptcp_dsn2packet_mapping_t);
                 packet->frame = pinfo->fd->num;
                 packet->subflow = tcpd;
 
-                wmem_itree_insert(tcpd->fwd->mptcp_subflow->dsn2packet_map,
+                wmem_itree_insert(sf->dsn2packet_map,
                         tcph->th_mptcp->mh_rawdsn64,
                         tcph->th_mptcp->mh_rawdsn64 + (tcph->th_seglen - 1 ),
                         packet
                         );
+                sf->num_dsn2packet++;
+                mptcp_mapping_stats.dsn2packet++;
+                mptcp_mapping_stats.bytes += sizeof(mptcp_dsn2packet_mapping_t) + sizeof(struct _wmem_range_t);
+            }
         }
         proto_item_set_generated(item);
 
@@ -4513,7 +4625,9 @@ again:
             /* We only enter here if dissect_tcp set can_desegment,
              * which means that these bytes exist. */
             fd->data = tvb_memdup(wmem_file_scope(), tvb, offset, fd->len);
-            wmem_list_insert_sorted(tcpd->fwd->ooo_segments, fd, compare_ooo_segment_item);
+            /* Segments after a gap mostly arrive in order, so look for
+             * the place to insert from the end of the list. */
+            wmem_list_append_sorted(tcpd->fwd->ooo_segments, fd, compare_ooo_segment_item);
         }
         ipfd_head = NULL;
     } else {
@@ -5953,6 +6067,32 @@ void analyze_mapping(struct tcp_analysis *tcpd, packet_info *pinfo, guint16 len,
         return;
     }
 
+    struct mptcp_subflow *sf = tcpd->fwd->mptcp_subflow;
+    mptcp_dss_mapping_t *last = sf->last_mapping;
+    guint32 ssn_high = ssn + len - 1;
+
+    /* A DSS option is often repeated on every segment it maps, and
+     * consecutive mappings often follow on from each other; keep a
+     * single range for those rather than one per segment. */
+    if (last && last->extended_dsn == extended &&
+            ssn >= last->ssn_low && ssn <= last->ssn_high + 1 &&
+            dsn == last->rawdsn + (ssn - last->ssn_low)) {
+        if (ssn_high > last->ssn_high) {
+            if (!wmem_itree_extend(sf->ssn2dsn_mappings, last->ssn_low, ssn_high)) {
+                goto new_mapping;
+            }
+            last->ssn_high = ssn_high;
+        }
+        mptcp_mapping_stats.coalesced++;
+        return;
+    }
+
+new_mapping:
+    if (mptcp_max_mappings_per_subflow && sf->num_mappings >= mptcp_max_mappings_per_subflow) {
+        mptcp_mapping_stats.dropped++;
+        return;
+    }
+
     /* register SSN range described by the mapping into a subflow interval_tree */
     mptcp_dss_mapping_t *mapping = NULL;
     mapping = wmem_new0(wmem_file_scope(), mptcp_dss_mapping_t);
@@ -5961,13 +6101,23 @@ void analyze_mapping(struct tcp_analysis *tcpd, packet_info *pinfo, guint16 len,
     mapping->extended_dsn = extended;
     mapping->frame = pinfo->fd->num;
     mapping->ssn_low = ssn;
-    mapping->ssn_high = ssn + len - 1;
+    mapping->ssn_high = ssn_high;
 
-    wmem_itree_insert(tcpd->fwd->mptcp_subflow->ssn2dsn_mappings,
+    wmem_itree_insert(sf->ssn2dsn_mappings,
         mapping->ssn_low,
         mapping->ssn_high,
         mapping
         );
+    sf->last_mapping = mapping;
+    sf->num_mappings++;
+    mptcp_mapping_stats.mappings++;
+    mptcp_mapping_stats.bytes += sizeof(mptcp_dss_mapping_t) + sizeof(struct _wmem_range_t);
+}
+
+void
+get_mptcp_mapping_stats(mptcp_mapping_stats_t *stats)
+{
+    *stats = mptcp_mapping_stats;
 }
 
 /*
@@ -7955,6 +8105,12 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
          */
         tcph->th_stream = tcpd->stream;
 
+        /* Remember the frames of the stream, so that they can be retapped
+         * on their own. */
+        if (!PINFO_FD_VISITED(pinfo)) {
+            conversation_add_frame(conv, pinfo->num);
+        }
+
         /* initialize the SACK blocks seen to 0 */
         if(tcp_analyze_seq && tcpd->fwd->tcp_analyze_seq_info) {
             tcpd->fwd->tcp_analyze_seq_info->num_sack_ranges = 0;
@@ -8793,14 +8949,60 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     return tvb_captured_length(tvb);
 }
 
+static void
+tcp_free_flow(tcp_flow_t *flow)
+{
+    wmem_tree_destroy(flow->multisegment_pdus, FALSE, TRUE);
+    if (flow->ooo_segments) {
+        wmem_list_frame_t *frame;
+
+        for (frame = wmem_list_head(flow->ooo_segments); frame; frame = wmem_list_frame_next(frame)) {
+            ooo_segment_item *fd = (ooo_segment_item *)wmem_list_frame_data(frame);
+
+            wmem_free(wmem_file_scope(), fd->data);
+            wmem_free(wmem_file_scope(), fd);
+        }
+        wmem_destroy_list(flow->ooo_segments);
+    }
+    if (flow->tcp_analyze_seq_info) {
+        wmem_free(wmem_file_scope(), flow->tcp_analyze_seq_info->segments);
+        wmem_free(wmem_file_scope(), flow->tcp_analyze_seq_info);
+    }
+    if (flow->process_info) {
+        wmem_free(wmem_file_scope(), flow->process_info->username);
+        wmem_free(wmem_file_scope(), flow->process_info->command);
+        wmem_free(wmem_file_scope(), flow->process_info);
+    }
+}
+
+/*
+ * Free the state of an expired conversation.  MPTCP connections are
+ * left alone, as the connection refers to all of its subflows.
+ */
+static void
+tcp_free_conversation_data(conversation_t *conv _U_, void *proto_data)
+{
+    struct tcp_analysis *tcpd = (struct tcp_analysis *)proto_data;
+
+    if (tcpd->mptcp_analysis)
+        return;
+
+    tcp_free_flow(&tcpd->flow1);
+    tcp_free_flow(&tcpd->flow2);
+    wmem_tree_destroy(tcpd->acked_table, FALSE, TRUE);
+    wmem_free(wmem_file_scope(), tcpd);
+}
+
 static void
 tcp_init(void)
 {
     tcp_stream_count = 0;
+    tcp_stream_conversations = wmem_array_new(wmem_file_scope(), sizeof(conversation_t *));
 
     /* MPTCP init */
     mptcp_stream_count = 0;
     mptcp_tokens = wmem_tree_new(wmem_file_scope());
+    memset(&mptcp_mapping_stats, 0, sizeof(mptcp_mapping_stats));
 }
 
 void
@@ -10022,6 +10224,7 @@ proto_register_tcp(void)
         &read_seq_as_syn_cookie);
 
     register_init_routine(tcp_init);
+    conversation_set_proto_data_free_func(proto_tcp, tcp_free_conversation_data);
     reassembly_table_register(&tcp_reassembly_table,
                           &tcp_reassembly_table_functions);
 
@@ -10067,6 +10270,13 @@ proto_register_tcp(void)
         "You need to enable DSS mapping analysis for this option to work",
         &mptcp_intersubflows_retransmission);
 
+    prefs_register_uint_preference(mptcp_module, "max_mappings_per_subflow",
+        "Maximum number of DSS mappings per subflow",
+        "Stop recording DSS mappings, and the data sent on a subflow for the"
+        " duplication check, once a subflow direction has this many of"
+        " each, to bound memory use (0 means no limit)",
+        10, &mptcp_max_mappings_per_subflow);
+
     register_conversation_table(proto_mptcp, FALSE, mptcpip_conversation_packet, tcpip_endpoint_packet);
     register_follow_stream(proto_tcp, "tcp_follow", tcp_follow_conv_filter, tcp_follow_index_filter, tcp_follow_address_filter,
                             tcp_port_to_display, follow_tcp_tap_listener, get_tcp_stream_count, NULL);
@@ -152,7 +152,6 @@ extern struct tcp_multisegment_pdu *
 pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_tree_t *multisegment_pdus);
 
 typedef struct _tcp_unacked_t {
-	struct _tcp_unacked_t *next;
 	guint32 frame;
 	guint32	seq;
 	guint32	nextseq;
@@ -281,6 +280,10 @@ struct mptcp_subflow {
 	 * hence some packets may have been mapped by previous DSS,
 	 * whence the necessity to be able to look for SSN -> DSN */
 	wmem_itree_t *ssn2dsn_mappings;
+	/* Last mapping added to ssn2dsn_mappings, which the next one may extend */
+	mptcp_dss_mapping_t *last_mapping;
+	guint32 num_mappings;		/* entries in ssn2dsn_mappings */
+	guint32 num_dsn2packet;		/* entries in dsn2packet_map */
 	/* meta flow to which it is attached. Helps setting forward and backward meta flow */
 	mptcp_meta_flow_t *meta;
 };
@@ -302,8 +305,16 @@ typedef enum {
  * is enabled, so save the memory when it isn't
  */
 typedef struct tcp_analyze_seq_flow_info_t {
-	tcp_unacked_t *segments;/* List of segments for which we haven't seen an ACK */
+	/* Segments for which we haven't seen an ACK, oldest first, in a ring
+	 * buffer of segment_capacity (a power of two) entries starting at
+	 * segment_first.
+	 */
+	tcp_unacked_t *segments;
 	guint16 segment_count;	/* How many unacked segments we're currently storing */
+	guint16 segment_first;
+	guint16 segment_capacity;
+	gboolean segments_sorted; /* Whether nextseq never decreases from one segment to the next */
+	guint32 segment_max_len; /* The longest segment stored so far */
 	guint32 lastack;	/* Last seen ack for the reverse flow */
 	nstime_t lastacktime;	/* Time of the last ack packet */
 	guint32 lastnondupack;	/* frame number of last seen non dupack */
@@ -554,12 +565,35 @@ extern void add_tcp_process_info(guint32 frame_num, address *local_addr, address
  */
 WS_DLL_PUBLIC guint32 get_tcp_stream_count(void);
 
+/** Get the frames of a TCP stream, as seen in the first pass
+ *
+ * @param stream The TCP stream index (tcp.stream)
+ * @param num_frames Set to the number of frames
+ * @return The frame numbers in increasing order, or NULL if there are none
+ */
+WS_DLL_PUBLIC const guint32 *get_tcp_stream_frames(guint32 stream, guint *num_frames);
+
 /** Get the current number of MPTCP streams
  *
  * @return The number of MPTCP streams
  */
 WS_DLL_PUBLIC guint32 get_mptcp_stream_count(void);
 
+/** Memory used by the MPTCP DSS mapping analysis */
+typedef struct _mptcp_mapping_stats_t {
+	guint64 mappings;	/* SSN to DSN mappings stored */
+	guint64 coalesced;	/* mappings merged into a previous one */
+	guint64 dsn2packet;	/* DSN to packet entries stored */
+	guint64 dropped;	/* mappings and entries not stored because a subflow was full */
+	guint64 bytes;		/* approximate size of the stored entries */
+} mptcp_mapping_stats_t;
+
+/** Get the memory used by the MPTCP DSS mapping analysis of the current file
+ *
+ * @param stats Filled in with the totals over all subflows
+ */
+WS_DLL_PUBLIC void get_mptcp_mapping_stats(mptcp_mapping_stats_t *stats);
+
 /* Follow Stream functionality shared with HTTP (and SSL?) */
 extern gchar *tcp_follow_conv_filter(epan_dissect_t *edt, packet_info *pinfo, guint *stream, guint *sub_stream);
 extern gchar *tcp_follow_index_filter(guint stream, guint sub_stream);
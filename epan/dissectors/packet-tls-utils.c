@@ -13,6 +13,7 @@
  */
 
 #include "config.h"
+#define WS_LOG_DOMAIN "packet-tls-utils"
 
 #ifdef HAVE_ZLIB
 #define ZLIB_CONST
@@ -5870,6 +5871,14 @@ tls_add_packet_info(gint proto, packet_info *pinfo, guint8 curr_layer_num_ssl)
  * @param type TLS Content Type (such as handshake or application_data).
  * @param curr_layer_num_ssl The layer identifier for this TLS session.
  */
+/*
+ * Decrypted records are kept for the life of the file, and later passes
+ * use them instead of decrypting again (which the cipher state wouldn't
+ * allow anyway); count them so that the memory they take can be seen.
+ */
+static guint64 ssl_stored_records;
+static guint64 ssl_stored_bytes;
+
 void
 ssl_add_record_info(gint proto, packet_info *pinfo, const guchar *data, gint data_len, gint record_id, SslFlow *flow, ContentType type, guint8 curr_layer_num_ssl)
 {
@@ -5882,6 +5891,8 @@ ssl_add_record_info(gint proto, packet_info *pinfo, const guchar *data, gint dat
     rec->id = record_id;
     rec->type = type;
     rec->next = NULL;
+    ssl_stored_records++;
+    ssl_stored_bytes += data_len;
 
     if (flow && type == SSL_ID_APP_DATA) {
         rec->seq = flow->byte_seq;
@@ -5962,14 +5973,21 @@ ssl_common_cleanup(ssl_master_key_map_t *mk_map, FILE **ssl_keylog_file,
 
     g_hash_table_destroy(mk_map->used_crandom);
 
+    if (ssl_stored_records) {
+        ws_debug("%" PRIu64 " decrypted records stored, %" PRIu64 " bytes",
+                 ssl_stored_records, ssl_stored_bytes);
+        ssl_stored_records = 0;
+        ssl_stored_bytes = 0;
+    }
+
     g_free(decrypted_data->data);
     g_free(compressed_data->data);
 
-    /* close the previous keylog file now that the cache are cleared, this
-     * allows the cache to be filled with the full keylog file contents. */
+    /* The keylog file stays open.  The secrets read from it so far are
+     * put back in the map from memory the next time it's needed, and only
+     * what was appended since is read. */
     if (*ssl_keylog_file) {
-        fclose(*ssl_keylog_file);
-        *ssl_keylog_file = NULL;
+        tls_keylog_store.map = NULL;
     }
 }
 /* }}} */
@@ -6434,10 +6452,12 @@ typedef struct ssl_master_key_match_group {
     GHashTable *master_key_ht;
 } ssl_master_key_match_group_t;
 
-void
-tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data, guint datalen)
+#define TLS_KEYLOG_NUM_GROUPS   11
+
+static void
+tls_keylog_get_groups(const ssl_master_key_map_t *mk_map, ssl_master_key_match_group_t *mk_groups)
 {
-    ssl_master_key_match_group_t mk_groups[] = {
+    const ssl_master_key_match_group_t groups[TLS_KEYLOG_NUM_GROUPS] = {
         { "encrypted_pmk",  mk_map->pre_master },
         { "session_id",     mk_map->session },
         { "client_random",  mk_map->crandom },
@@ -6452,6 +6472,161 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
         { "exporter",           mk_map->tls13_exporter },
     };
 
+    memcpy(mk_groups, groups, sizeof(groups));
+}
+
+/*
+ * The secrets read from the keylog file, so that they can be put back in
+ * the (file scope) secrets map when a new file is dissected, or the same
+ * one dissected again, without reading and parsing the keylog file from
+ * the start.  The keylog file stays open, and only what is appended to
+ * it is read.
+ *
+ * Each entry is the group (index into tls_keylog_get_groups()), the
+ * length of the key and of the secret (guint16 each) and their bytes.
+ */
+#define TLS_KEYLOG_ENTRY_HEADER_LEN 5
+
+static struct {
+    GByteArray *entries;
+    const ssl_master_key_map_t *map;    /* map holding the entries, if any */
+    gint64 pending_offset;              /* start of an unterminated last line */
+    gint64 pending_len;
+} tls_keylog_store = { NULL, NULL, -1, 0 };
+
+static void
+tls_keylog_store_entry(guint group, const StringInfo *key, const StringInfo *secret)
+{
+    guint8 header[TLS_KEYLOG_ENTRY_HEADER_LEN];
+    guint16 len;
+
+    if (!tls_keylog_store.entries) {
+        tls_keylog_store.entries = g_byte_array_new();
+    }
+    header[0] = (guint8)group;
+    len = (guint16)key->data_len;
+    memcpy(header + 1, &len, sizeof(len));
+    len = (guint16)secret->data_len;
+    memcpy(header + 3, &len, sizeof(len));
+    g_byte_array_append(tls_keylog_store.entries, header, sizeof(header));
+    g_byte_array_append(tls_keylog_store.entries, key->data, key->data_len);
+    g_byte_array_append(tls_keylog_store.entries, secret->data, secret->data_len);
+}
+
+/* Put the stored secrets in a map that doesn't have them yet. */
+static void
+tls_keylog_store_replay(const ssl_master_key_map_t *mk_map)
+{
+    ssl_master_key_match_group_t mk_groups[TLS_KEYLOG_NUM_GROUPS];
+    const guint8 *entry, *end;
+    guint count = 0;
+
+    tls_keylog_store.map = mk_map;
+    if (!tls_keylog_store.entries) {
+        return;
+    }
+
+    tls_keylog_get_groups(mk_map, mk_groups);
+    entry = tls_keylog_store.entries->data;
+    end = entry + tls_keylog_store.entries->len;
+    while (entry < end) {
+        guint16 key_len, secret_len;
+        StringInfo *key = wmem_new(wmem_file_scope(), StringInfo);
+        StringInfo *secret = wmem_new(wmem_file_scope(), StringInfo);
+
+        memcpy(&key_len, entry + 1, sizeof(key_len));
+        memcpy(&secret_len, entry + 3, sizeof(secret_len));
+        key->data = (guchar *)wmem_memdup(wmem_file_scope(), entry + TLS_KEYLOG_ENTRY_HEADER_LEN, key_len);
+        key->data_len = key_len;
+        secret->data = (guchar *)wmem_memdup(wmem_file_scope(), entry + TLS_KEYLOG_ENTRY_HEADER_LEN + key_len, secret_len);
+        secret->data_len = secret_len;
+        g_hash_table_insert(mk_groups[entry[0]].master_key_ht, key, secret);
+
+        entry += TLS_KEYLOG_ENTRY_HEADER_LEN + key_len + secret_len;
+        count++;
+    }
+    ssl_debug_printf("%s restored %u secrets\n", G_STRFUNC, count);
+}
+
+static void
+tls_keylog_store_reset(void)
+{
+    if (tls_keylog_store.entries) {
+        g_byte_array_set_size(tls_keylog_store.entries, 0);
+    }
+    tls_keylog_store.map = NULL;
+    tls_keylog_store.pending_offset = -1;
+}
+
+static void
+tls_keylog_process_line(const ssl_master_key_map_t *mk_map, const char *line, gssize linelen, gboolean store)
+{
+    ssl_master_key_match_group_t mk_groups[TLS_KEYLOG_NUM_GROUPS];
+    GRegex *regex = ssl_compile_keyfile_regex();
+    GMatchInfo *mi;
+
+    if (!regex)
+        return;
+
+    ssl_debug_printf("  checking keylog line: %.*s\n", (int)linelen, line);
+    if (g_regex_match_full(regex, line, linelen, 0, G_REGEX_MATCH_ANCHORED, &mi, NULL)) {
+        gchar *hex_key, *hex_pre_ms_or_ms;
+        StringInfo *key = wmem_new(wmem_file_scope(), StringInfo);
+        StringInfo *pre_ms_or_ms = NULL;
+        GHashTable *ht = NULL;
+        unsigned i;
+
+        /* Is the PMS being supplied with the PMS_CLIENT_RANDOM
+         * otherwise we will use the Master Secret
+         */
+        hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "master_secret");
+        if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
+            g_free(hex_pre_ms_or_ms);
+            hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "pms");
+        }
+        if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
+            g_free(hex_pre_ms_or_ms);
+            hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "derived_secret");
+        }
+        /* There is always a match, otherwise the regex is wrong. */
+        DISSECTOR_ASSERT(hex_pre_ms_or_ms && strlen(hex_pre_ms_or_ms));
+
+        /* convert from hex to bytes and save to hashtable */
+        pre_ms_or_ms = wmem_new(wmem_file_scope(), StringInfo);
+        from_hex(pre_ms_or_ms, hex_pre_ms_or_ms, strlen(hex_pre_ms_or_ms));
+        g_free(hex_pre_ms_or_ms);
+
+        /* Find a master key from any format (CLIENT_RANDOM, SID, ...) */
+        tls_keylog_get_groups(mk_map, mk_groups);
+        for (i = 0; i < G_N_ELEMENTS(mk_groups); i++) {
+            ssl_master_key_match_group_t *g = &mk_groups[i];
+            hex_key = g_match_info_fetch_named(mi, g->re_group_name);
+            if (hex_key && *hex_key) {
+                ssl_debug_printf("    matched %s\n", g->re_group_name);
+                ht = g->master_key_ht;
+                from_hex(key, hex_key, strlen(hex_key));
+                g_free(hex_key);
+                break;
+            }
+            g_free(hex_key);
+        }
+        DISSECTOR_ASSERT(ht); /* Cannot be reached, or regex is wrong. */
+
+        g_hash_table_insert(ht, key, pre_ms_or_ms);
+        if (store) {
+            tls_keylog_store_entry(i, key, pre_ms_or_ms);
+        }
+
+    } else if (linelen > 0 && line[0] != '#') {
+        ssl_debug_printf("    unrecognized line\n");
+    }
+    /* always free match info even if there is no match. */
+    g_match_info_free(mi);
+}
+
+void
+tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data, guint datalen)
+{
     /* The format of the file is a series of records with one of the following formats:
      *   - "RSA xxxx yyyy"
      *     Where xxxx are the first 8 bytes of the encrypted pre-master secret (hex-encoded)
@@ -6490,10 +6665,6 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
      *     handshake or master secrets. (This format is introduced with TLS 1.3
      *     and supported by BoringSSL, OpenSSL, etc. See bug 12779.)
      */
-    GRegex *regex = ssl_compile_keyfile_regex();
-    if (!regex)
-        return;
-
     const char *next_line = (const char *)data;
     const char *line_end = next_line + datalen;
     while (next_line && next_line < line_end) {
@@ -6511,56 +6682,7 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
             linelen--;      /* drop CR */
         }
 
-        ssl_debug_printf("  checking keylog line: %.*s\n", (int)linelen, line);
-        GMatchInfo *mi;
-        if (g_regex_match_full(regex, line, linelen, 0, G_REGEX_MATCH_ANCHORED, &mi, NULL)) {
-            gchar *hex_key, *hex_pre_ms_or_ms;
-            StringInfo *key = wmem_new(wmem_file_scope(), StringInfo);
-            StringInfo *pre_ms_or_ms = NULL;
-            GHashTable *ht = NULL;
-
-            /* Is the PMS being supplied with the PMS_CLIENT_RANDOM
-             * otherwise we will use the Master Secret
-             */
-            hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "master_secret");
-            if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
-                g_free(hex_pre_ms_or_ms);
-                hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "pms");
-            }
-            if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
-                g_free(hex_pre_ms_or_ms);
-                hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "derived_secret");
-            }
-            /* There is always a match, otherwise the regex is wrong. */
-            DISSECTOR_ASSERT(hex_pre_ms_or_ms && strlen(hex_pre_ms_or_ms));
-
-            /* convert from hex to bytes and save to hashtable */
-            pre_ms_or_ms = wmem_new(wmem_file_scope(), StringInfo);
-            from_hex(pre_ms_or_ms, hex_pre_ms_or_ms, strlen(hex_pre_ms_or_ms));
-            g_free(hex_pre_ms_or_ms);
-
-            /* Find a master key from any format (CLIENT_RANDOM, SID, ...) */
-            for (unsigned i = 0; i < G_N_ELEMENTS(mk_groups); i++) {
-                ssl_master_key_match_group_t *g = &mk_groups[i];
-                hex_key = g_match_info_fetch_named(mi, g->re_group_name);
-                if (hex_key && *hex_key) {
-                    ssl_debug_printf("    matched %s\n", g->re_group_name);
-                    ht = g->master_key_ht;
-                    from_hex(key, hex_key, strlen(hex_key));
-                    g_free(hex_key);
-                    break;
-                }
-                g_free(hex_key);
-            }
-            DISSECTOR_ASSERT(ht); /* Cannot be reached, or regex is wrong. */
-
-            g_hash_table_insert(ht, key, pre_ms_or_ms);
-
-        } else if (linelen > 0 && line[0] != '#') {
-            ssl_debug_printf("    unrecognized line\n");
-        }
-        /* always free match info even if there is no match. */
-        g_match_info_free(mi);
+        tls_keylog_process_line(mk_map, line, linelen, FALSE);
     }
 }
 
@@ -6589,16 +6711,36 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
         *keylog_file = NULL;
     }
 
+    /* if it was truncated and written again, read it from the start */
+    if (*keylog_file) {
+        ws_statb64 st;
+
+        if (ws_fstat64(ws_fileno(*keylog_file), &st) == 0 &&
+                st.st_size < ws_ftell64(*keylog_file)) {
+            ssl_debug_printf("%s file got truncated, trying to re-open\n", G_STRFUNC);
+            fclose(*keylog_file);
+            *keylog_file = NULL;
+        }
+    }
+
     if (*keylog_file == NULL) {
+        tls_keylog_store_reset();
         *keylog_file = ws_fopen(tls_keylog_filename, "r");
         if (!*keylog_file) {
             ssl_debug_printf("%s failed to open SSL keylog\n", G_STRFUNC);
             return;
         }
+        tls_keylog_store.map = mk_map;
+    } else if (tls_keylog_store.map != mk_map) {
+        /* The secrets map was emptied since we read the file. */
+        tls_keylog_store_replay(mk_map);
     }
 
     for (;;) {
         char buf[1110], *line;
+        gint64 line_offset = ws_ftell64(*keylog_file);
+        gsize linelen;
+
         line = fgets(buf, sizeof(buf), *keylog_file);
         if (!line) {
             if (feof(*keylog_file)) {
@@ -6608,11 +6750,44 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
                 ssl_debug_printf("%s Error while reading key log file, closing it!\n", G_STRFUNC);
                 fclose(*keylog_file);
                 *keylog_file = NULL;
+                tls_keylog_store_reset();
             }
             break;
         }
-        tls_keylog_process_lines(mk_map, (guint8 *)line, (int)strlen(line));
+        linelen = strlen(line);
+        if (line[linelen - 1] != '\n' && feof(*keylog_file) && line_offset >= 0 &&
+                (tls_keylog_store.pending_offset != line_offset ||
+                 tls_keylog_store.pending_len != (gint64)linelen)) {
+            /* The last line may still be being written; read it again
+             * next time, and only use it as it is if it hasn't grown. */
+            tls_keylog_store.pending_offset = line_offset;
+            tls_keylog_store.pending_len = (gint64)linelen;
+            ws_fseek64(*keylog_file, line_offset, SEEK_SET);
+            break;
+        }
+        tls_keylog_store.pending_offset = -1;
+        if (line[linelen - 1] == '\n') {
+            linelen--;      /* drop LF */
+        }
+        if (linelen > 0 && line[linelen - 1] == '\r') {
+            linelen--;      /* drop CR */
+        }
+        tls_keylog_process_line(mk_map, line, (gssize)linelen, TRUE);
+    }
+}
+
+void
+ssl_keylog_shutdown(FILE **keylog_file)
+{
+    if (*keylog_file) {
+        fclose(*keylog_file);
+        *keylog_file = NULL;
+    }
+    if (tls_keylog_store.entries) {
+        g_byte_array_free(tls_keylog_store.entries, TRUE);
+        tls_keylog_store.entries = NULL;
     }
+    tls_keylog_store.map = NULL;
 }
 /** SSL keylog file handling. }}} */
 
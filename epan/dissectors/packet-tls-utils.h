@@ -777,6 +777,10 @@ extern void
 ssl_load_keyfile(const gchar *ssl_keylog_filename, FILE **keylog_file,
                  const ssl_master_key_map_t *mk_map);
 
+/* closes the keylog file and forgets the secrets read from it */
+extern void
+ssl_keylog_shutdown(FILE **keylog_file);
+
 #ifdef HAVE_LIBGNUTLS
 /* parse ssl related preferences (private keys and ports association strings) */
 extern void
@@ -984,7 +984,7 @@ follow_cdc_data_tap_listener(void *tapdata, packet_info *pinfo, epan_dissect_t *
                                               data_length);
 
     follow_info->bytes_written[is_server] += follow_record->data->len;
-    follow_info->payload = g_list_prepend(follow_info->payload, follow_record);
+    follow_add_record(follow_info, follow_record);
 
     return TAP_PACKET_DONT_REDRAW;
 }
@@ -17,6 +17,8 @@
 
 #include <epan/packet.h>
 #include <epan/tfs.h>
+#include <epan/tap.h>
+#include <epan/stats_tree.h>
 #include "packet-vxlan.h"
 
 #define UDP_PORT_VXLAN  4789
@@ -51,6 +53,16 @@ static int hf_vxlan_next_proto;
 static int ett_vxlan;
 static int ett_vxlan_flags;
 
+static int vxlan_tap;
+
+typedef struct _vxlan_tap_info {
+    guint32 vni;
+    guint   payload_len;
+} vxlan_tap_info_t;
+
+static const gchar *st_str_vni = "Packets by VNI";
+static int st_node_vni = -1;
+
 static int * const flags_fields[] = {
         &hf_vxlan_flag_g,
         &hf_vxlan_flag_i,
@@ -82,6 +94,25 @@ static const value_string vxlan_next_protocols[] = {
 static dissector_handle_t eth_handle;
 static dissector_table_t vxlan_dissector_table;
 
+static void
+vxlan_stats_tree_init(stats_tree *st)
+{
+    st_node_vni = stats_tree_create_node(st, st_str_vni, 0, STAT_DT_INT, TRUE);
+}
+
+static tap_packet_status
+vxlan_stats_tree_packet(stats_tree *st, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *p, tap_flags_t flags _U_)
+{
+    const vxlan_tap_info_t *tap = (const vxlan_tap_info_t *)p;
+    gchar vni_str[12];
+
+    snprintf(vni_str, sizeof(vni_str), "%u", tap->vni);
+    avg_stat_node_add_value_int(st, st_str_vni, 0, FALSE, tap->payload_len);
+    avg_stat_node_add_value_int(st, vni_str, st_node_vni, FALSE, tap->payload_len);
+
+    return TAP_PACKET_REDRAW;
+}
+
 static int
 dissect_vxlan_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int is_gpe)
 {
@@ -89,37 +120,41 @@ dissect_vxlan_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int is
     proto_item *ti;
     tvbuff_t *next_tvb;
     int offset = 0;
-    guint32 vxlan_next_proto;
+    guint32 vxlan_next_proto = 0;
 
     col_set_str(pinfo->cinfo, COL_PROTOCOL, "VxLAN");
     col_clear(pinfo->cinfo, COL_INFO);
 
-
-    ti = proto_tree_add_item(tree, proto_vxlan, tvb, offset, 8, ENC_NA);
-    vxlan_tree = proto_item_add_subtree(ti, ett_vxlan);
+    /* The header is only needed for the tree; only the next protocol
+     * (GPE) and the VNI (for the tap) are looked at otherwise. */
+    if (tree) {
+        ti = proto_tree_add_item(tree, proto_vxlan, tvb, offset, 8, ENC_NA);
+        vxlan_tree = proto_item_add_subtree(ti, ett_vxlan);
+
+        if(is_gpe) {
+            proto_tree_add_bitmask(vxlan_tree, tvb, offset, hf_vxlan_gpe_flags, ett_vxlan_flags, gpe_flags_fields, ENC_BIG_ENDIAN);
+            proto_tree_add_item(vxlan_tree, hf_vxlan_gpe_reserved_16, tvb, offset + 1, 2, ENC_BIG_ENDIAN);
+            proto_tree_add_item(vxlan_tree, hf_vxlan_next_proto, tvb, offset + 3, 1, ENC_BIG_ENDIAN);
+        } else {
+            proto_tree_add_bitmask(vxlan_tree, tvb, offset, hf_vxlan_flags, ett_vxlan_flags, flags_fields, ENC_BIG_ENDIAN);
+            proto_tree_add_item(vxlan_tree, hf_vxlan_gbp, tvb, offset + 2, 2, ENC_BIG_ENDIAN);
+        }
+        proto_tree_add_item(vxlan_tree, hf_vxlan_vni, tvb, offset + 4, 3, ENC_BIG_ENDIAN);
+        proto_tree_add_item(vxlan_tree, hf_vxlan_reserved_8, tvb, offset + 7, 1, ENC_BIG_ENDIAN);
+    }
 
     if(is_gpe) {
-        proto_tree_add_bitmask(vxlan_tree, tvb, offset, hf_vxlan_gpe_flags, ett_vxlan_flags, gpe_flags_fields, ENC_BIG_ENDIAN);
-        offset += 1;
-
-        proto_tree_add_item(vxlan_tree, hf_vxlan_gpe_reserved_16, tvb, offset, 2, ENC_BIG_ENDIAN);
-        offset += 2;
-
-        proto_tree_add_item_ret_uint(vxlan_tree, hf_vxlan_next_proto, tvb, offset, 1, ENC_BIG_ENDIAN, &vxlan_next_proto);
-        offset += 1;
-    } else {
-        proto_tree_add_bitmask(vxlan_tree, tvb, offset, hf_vxlan_flags, ett_vxlan_flags, flags_fields, ENC_BIG_ENDIAN);
-        offset += 2;
-
-        proto_tree_add_item(vxlan_tree, hf_vxlan_gbp, tvb, offset, 2, ENC_BIG_ENDIAN);
-        offset += 2;
+        vxlan_next_proto = tvb_get_guint8(tvb, offset + 3);
     }
 
-    proto_tree_add_item(vxlan_tree, hf_vxlan_vni, tvb, offset, 3, ENC_BIG_ENDIAN);
-    offset += 3;
+    if (have_tap_listener(vxlan_tap)) {
+        vxlan_tap_info_t *tap_info = wmem_new(pinfo->pool, vxlan_tap_info_t);
 
-    proto_tree_add_item(vxlan_tree, hf_vxlan_reserved_8, tvb, offset, 1, ENC_BIG_ENDIAN);
-    offset += 1;
+        tap_info->vni = tvb_get_ntoh24(tvb, offset + 4);
+        tap_info->payload_len = tvb_reported_length_remaining(tvb, offset + 8);
+        tap_queue_packet(vxlan_tap, pinfo, tap_info);
+    }
+    offset += 8;
 
     next_tvb = tvb_new_subset_remaining(tvb, offset);
 
@@ -279,6 +314,9 @@ proto_register_vxlan(void)
     /* Register dissector handles */
     vxlan_handle = register_dissector("vxlan", dissect_vxlan, proto_vxlan);
     vxlan_gpe_handle = register_dissector("vxlan_gpe", dissect_vxlan_gpe, proto_vxlan_gpe);
+
+    vxlan_tap = register_tap("vxlan");
+    stats_tree_register("vxlan", "vxlan", "VXLAN/Packets by VNI", 0, vxlan_stats_tree_packet, vxlan_stats_tree_init, NULL);
 }
 
 void
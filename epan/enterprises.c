@@ -22,7 +22,7 @@ typedef struct
     const char* values[61328];
 } global_enterprises_table_t;
 
-static global_enterprises_table_t table =
+static const global_enterprises_table_t table =
 {
     61327,
     {
@@ -33,6 +33,7 @@
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/version_info.h>
+#include <wsutil/ws_trace.h>
 
 #include "conversation.h"
 #include "except.h"
@@ -64,6 +65,9 @@
 
 #ifdef HAVE_LUA
 #include <lua.h>
+#ifdef HAVE_LUAJIT
+#include <luajit.h>
+#endif
 #include <wslua/wslua.h>
 #endif
 
@@ -107,6 +111,20 @@ static GSList *epan_plugin_register_all_handoffs = NULL;
 
 static wmem_allocator_t *pinfo_pool_cache = NULL;
 
+/*
+ * Expiry of idle state.  We remember the number of the frame seen at
+ * regular intervals of capture time; anything that hasn't been touched
+ * since the frame seen idle_timeout seconds ago has been idle at least
+ * that long.
+ */
+typedef struct {
+	time_t secs;
+	guint32 frame_num;
+} idle_checkpoint_t;
+
+static guint idle_timeout = 0;
+static GQueue idle_checkpoints = G_QUEUE_INIT;
+
 /* Global variables holding the content of the corresponding environment variable
  * to save fetching it repeatedly.
  */
@@ -255,6 +273,9 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 		wireshark_abort_on_too_many_items = FALSE;
 	}
 
+	/* WIRESHARK_TRACE_FILE turns on tracing of where the time goes. */
+	ws_trace_init_from_env();
+
 	/*
 	 * proto_init -> register_all_protocols -> g_async_queue_new which
 	 * requires threads to be initialized. This happens automatically with
@@ -382,6 +403,9 @@ epan_load_settings(void)
 void
 epan_cleanup(void)
 {
+	/* Write the trace while the protocol names in it are still valid. */
+	ws_trace_finish();
+
 	g_slist_foreach(epan_plugins, epan_plugin_cleanup, NULL);
 	g_slist_free(epan_plugins);
 	epan_plugins = NULL;
@@ -443,6 +467,11 @@ epan_cleanup(void)
 	libwireshark_plugins = NULL;
 
 	if (pinfo_pool_cache != NULL) {
+		wmem_allocator_stats_t pool_stats;
+
+		wmem_get_stats(pinfo_pool_cache, &pool_stats);
+		ws_info("Packet pool: peak %zu bytes per packet, %zu bytes retained, %" PRIu64 " packets",
+		    pool_stats.peak, pool_stats.retained, pool_stats.resets);
 		wmem_destroy_allocator(pinfo_pool_cache);
 		pinfo_pool_cache = NULL;
 	}
@@ -513,12 +542,68 @@ epan_get_frame_ts(const epan_t *session, guint32 frame_num)
 	return abs_ts;
 }
 
+static void
+clear_idle_checkpoints(void)
+{
+	while (!g_queue_is_empty(&idle_checkpoints))
+		g_free(g_queue_pop_head(&idle_checkpoints));
+}
+
+void
+epan_set_idle_timeout(guint timeout)
+{
+	idle_timeout = timeout;
+	clear_idle_checkpoints();
+}
+
+gboolean
+epan_get_packet_pool_stats(wmem_allocator_stats_t *stats)
+{
+	if (pinfo_pool_cache == NULL)
+		return FALSE;
+
+	wmem_get_stats(pinfo_pool_cache, stats);
+	return TRUE;
+}
+
+static void
+expire_idle_state(const frame_data *fd)
+{
+	idle_checkpoint_t *checkpoint;
+	guint32 idle_frame = 0;
+	time_t interval = MAX(idle_timeout / 4, 1);
+
+	if (fd->visited)
+		return;
+
+	checkpoint = (idle_checkpoint_t *)g_queue_peek_tail(&idle_checkpoints);
+	if (checkpoint != NULL && fd->abs_ts.secs - checkpoint->secs < interval)
+		return;
+
+	checkpoint = g_new(idle_checkpoint_t, 1);
+	checkpoint->secs = fd->abs_ts.secs;
+	checkpoint->frame_num = fd->num;
+	g_queue_push_tail(&idle_checkpoints, checkpoint);
+
+	while ((checkpoint = (idle_checkpoint_t *)g_queue_peek_head(&idle_checkpoints)) != NULL &&
+	       fd->abs_ts.secs - checkpoint->secs >= (time_t)idle_timeout) {
+		idle_frame = checkpoint->frame_num;
+		g_free(g_queue_pop_head(&idle_checkpoints));
+	}
+
+	if (idle_frame != 0) {
+		conversation_expire_idle(idle_frame);
+		reassembly_tables_expire_idle(idle_frame);
+	}
+}
+
 void
 epan_free(epan_t *session)
 {
 	if (session) {
 		/* XXX, it should take session as param */
 		cleanup_dissection();
+		clear_idle_checkpoints();
 
 		g_slice_free(epan_t, session);
 	}
@@ -559,6 +644,7 @@ epan_dissect_init(epan_dissect_t *edt, epan_t *session, const gboolean create_pr
 	}
 	else {
 		edt->pi.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+		wmem_allocator_set_name(edt->pi.pool, "pinfo->pool");
 	}
 
 	if (create_proto_tree) {
@@ -631,6 +717,8 @@ epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 #ifdef HAVE_LUA
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
+	if (idle_timeout)
+		expire_idle_state(fd);
 	wmem_enter_packet_scope();
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
 
@@ -645,6 +733,8 @@ epan_dissect_run_with_taps(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, tvbuff_t *tvb, frame_data *fd,
 	column_info *cinfo)
 {
+	if (idle_timeout)
+		expire_idle_state(fd);
 	wmem_enter_packet_scope();
 	tap_queue_init(edt);
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
@@ -794,7 +884,9 @@ epan_gather_compile_info(feature_list l)
 
 	/* Lua */
 #ifdef HAVE_LUA
-#ifdef HAVE_LUA_UNICODE
+#if defined(HAVE_LUAJIT)
+	with_feature(l, "%s", LUAJIT_VERSION);
+#elif defined(HAVE_LUA_UNICODE)
 	with_feature(l, "%s", LUA_RELEASE" (with UfW patches)");
 #else /* HAVE_LUA_UNICODE */
 	with_feature(l, "%s", LUA_RELEASE);
@@ -153,7 +153,16 @@ void epan_conversation_init(void);
  * sequentially, in a single session. A session corresponds to a single
  * packet trace file. The reasons epan_t exists is that some packets in
  * some protocols cannot be decoded without knowledge of previous packets.
- * This inter-packet "state" is stored in the epan_t.
+ *
+ * Note that, currently, the epan_t only holds the packet provider; the
+ * inter-packet state itself is global.  That includes the conversation
+ * tables in conversation.c, the file and packet wmem scopes in
+ * wmem_scopes.c, the reassembly tables and other per-file state kept by
+ * individual dissectors, and the state of the address resolution and
+ * expert info code.  epan_new() reinitializes all of it, so only one
+ * session may exist at a time, and dissection must be done on one
+ * thread.  To dissect several captures concurrently, use a process per
+ * capture.
  */
 typedef struct epan_session epan_t;
 
@@ -188,6 +197,27 @@ WS_DLL_PUBLIC void epan_get_version_number(int *major, int *minor, int *micro);
 WS_DLL_PUBLIC
 void epan_set_always_visible(gboolean force);
 
+/**
+ * Discard conversations and reassembly state that have seen no packets
+ * for more than idle_timeout seconds of capture time, so that memory use
+ * stays bounded in long-running live captures.  This is only safe when
+ * each frame is dissected once, in order, and never revisited, i.e. in
+ * single-pass mode; protocols that keep conversation data must register
+ * a conversation_set_proto_data_free_func() for it to be freed.
+ * 0 (the default) keeps everything until the file is closed.
+ */
+WS_DLL_PUBLIC
+void epan_set_idle_timeout(guint idle_timeout);
+
+/**
+ * Get the memory usage of the pool that holds each packet's pinfo->pool
+ * allocations, which is kept and reused from one epan_dissect_t to the
+ * next.  Returns FALSE if there's no such pool, i.e. an epan_dissect_t
+ * that has one is still in use, or none has been created.
+ */
+WS_DLL_PUBLIC
+gboolean epan_get_packet_pool_stats(wmem_allocator_stats_t *stats);
+
 /** initialize an existing single packet dissection */
 WS_DLL_PUBLIC
 void
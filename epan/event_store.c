@@ -0,0 +1,571 @@
+/* event_store.c
+ * A columnar store of the fields of system call and log records, filled
+ * directly from the records as they are read, so that those records can
+ * be filtered and sorted without being dissected.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/proto.h>
+#include <wsutil/pint.h>
+
+#include "event_store.h"
+
+/*
+ * Where a stored value comes from.  Syscall values come from the record
+ * header, journal values from the "KEY=value" lines of the entry.
+ */
+typedef enum {
+    SOURCE_SYSCALL_EVENT_TYPE,
+    SOURCE_SYSCALL_CPU_ID,
+    SOURCE_SYSCALL_THREAD_ID,
+    SOURCE_JOURNAL
+} value_source_t;
+
+typedef struct {
+    const char     *field;
+    value_source_t  source;
+    const char     *journal_key;    /* Including the '=' */
+} stored_field_t;
+
+/*
+ * The fields we store.  They must be added to the tree by their
+ * dissectors exactly as they are found in the record, and only once per
+ * record, so that applying a filter to the stored values gives the same
+ * result as applying it to the dissection.
+ */
+static const stored_field_t stored_fields[] = {
+    { "sysdig.event_type",          SOURCE_SYSCALL_EVENT_TYPE,  NULL },
+    { "sysdig.cpu_id",              SOURCE_SYSCALL_CPU_ID,      NULL },
+    { "sysdig.thread_id",           SOURCE_SYSCALL_THREAD_ID,   NULL },
+    { "systemd_journal.priority",   SOURCE_JOURNAL,             "PRIORITY=" },
+    { "systemd_journal.pid",        SOURCE_JOURNAL,             "_PID=" },
+    { "systemd_journal.comm",       SOURCE_JOURNAL,             "_COMM=" },
+    { "systemd_journal.syslog_id",  SOURCE_JOURNAL,             "SYSLOG_IDENTIFIER=" },
+};
+
+/* See packet-sysdig-event.c */
+#define SYSDIG_EVENT_MIN_LENGTH 8
+#define EVT_PLUGINEVENT_E       322
+
+/*
+ * Stop storing, and drop what we have, if the values would take more
+ * than this much memory.
+ */
+#define EVENT_STORE_MAX_SIZE    ((gsize)2 * 1024 * 1024 * 1024)
+
+/*
+ * Each column holds one value per frame, in frame order.  Values with all
+ * bits set mean that the frame doesn't have the field; string values are
+ * indices into the store's interned strings.  A column's values are only
+ * allocated once a frame has the field, so storing the journal fields
+ * costs nothing for a syscall capture and vice versa.
+ */
+typedef struct {
+    const stored_field_t *def;
+    header_field_info *hfinfo;
+    guint       width;          /* Size of a value */
+    gboolean    is_string;
+    gboolean    valid;          /* Values match the dissection */
+    GByteArray *values;
+} event_store_column_t;
+
+struct _event_store {
+    GArray     *columns;        /* event_store_column_t */
+    guint32     num_frames;     /* Frames added, 1 .. num_frames */
+    gboolean    valid;
+    gsize       size;
+    gboolean    have_falco_bridge;
+    /* Interned string values. */
+    GStringChunk *string_chunk;
+    GHashTable *string_ids;     /* string -> index + 1 */
+    GPtrArray  *strings;        /* index -> string */
+    guint32    *string_ranks;   /* index -> position in sorted order */
+    gboolean    ranks_valid;
+    GString    *scratch;
+    /* Used to hold the values of a frame while applying a filter. */
+    packet_info *pinfo;
+    proto_tree *tree;
+};
+
+static guint
+value_width(enum ftenum type)
+{
+    switch (type) {
+        case FT_UINT8:
+            return 1;
+        case FT_UINT16:
+            return 2;
+        case FT_UINT32:
+        case FT_STRING:
+            return 4;
+        case FT_UINT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+static inline guint64
+absent_value(guint width)
+{
+    return width == 8 ? G_MAXUINT64 : ((guint64)1 << (width * 8)) - 1;
+}
+
+static inline guint64
+column_value(const event_store_column_t *col, guint32 framenum)
+{
+    const guint8 *p;
+    guint8  v8;
+    guint16 v16;
+    guint32 v32;
+    guint64 v64;
+
+    if (col->values == NULL)
+        return absent_value(col->width);
+
+    p = col->values->data + (gsize)(framenum - 1) * col->width;
+    switch (col->width) {
+        case 1:
+            memcpy(&v8, p, sizeof(v8));
+            return v8;
+        case 2:
+            memcpy(&v16, p, sizeof(v16));
+            return v16;
+        case 4:
+            memcpy(&v32, p, sizeof(v32));
+            return v32;
+        default:
+            memcpy(&v64, p, sizeof(v64));
+            return v64;
+    }
+}
+
+static void
+append_value(event_store_t *es, event_store_column_t *col, guint64 value)
+{
+    guint8  v8  = (guint8)value;
+    guint16 v16 = (guint16)value;
+    guint32 v32 = (guint32)value;
+
+    switch (col->width) {
+        case 1:
+            g_byte_array_append(col->values, &v8, sizeof(v8));
+            break;
+        case 2:
+            g_byte_array_append(col->values, (const guint8 *)&v16, sizeof(v16));
+            break;
+        case 4:
+            g_byte_array_append(col->values, (const guint8 *)&v32, sizeof(v32));
+            break;
+        default:
+            g_byte_array_append(col->values, (const guint8 *)&value, sizeof(value));
+            break;
+    }
+    es->size += col->width;
+}
+
+static void
+invalidate(event_store_t *es)
+{
+    es->valid = FALSE;
+    for (guint i = 0; i < es->columns->len; i++) {
+        event_store_column_t *col = &g_array_index(es->columns, event_store_column_t, i);
+
+        if (col->values != NULL) {
+            g_byte_array_free(col->values, TRUE);
+            col->values = NULL;
+        }
+    }
+    es->size = 0;
+}
+
+static guint32
+intern_string(event_store_t *es, const char *str)
+{
+    gpointer idx_p = g_hash_table_lookup(es->string_ids, str);
+    char *interned;
+
+    if (idx_p != NULL)
+        return GPOINTER_TO_UINT(idx_p) - 1;
+
+    interned = g_string_chunk_insert(es->string_chunk, str);
+    g_ptr_array_add(es->strings, interned);
+    g_hash_table_insert(es->string_ids, interned, GUINT_TO_POINTER(es->strings->len));
+    es->size += strlen(interned) + 1 + 2 * sizeof(gpointer);
+    es->ranks_valid = FALSE;
+
+    return es->strings->len - 1;
+}
+
+event_store_t *
+event_store_new(void)
+{
+    event_store_t *es = g_new0(event_store_t, 1);
+
+    es->columns = g_array_new(FALSE, FALSE, sizeof(event_store_column_t));
+    for (gsize i = 0; i < G_N_ELEMENTS(stored_fields); i++) {
+        header_field_info *hfinfo = proto_registrar_get_byname(stored_fields[i].field);
+        event_store_column_t col;
+
+        if (hfinfo == NULL || value_width(hfinfo->type) == 0)
+            continue;
+        col.def = &stored_fields[i];
+        col.hfinfo = hfinfo;
+        col.width = value_width(hfinfo->type);
+        col.is_string = hfinfo->type == FT_STRING;
+        col.valid = TRUE;
+        col.values = NULL;
+        g_array_append_val(es->columns, col);
+    }
+    es->string_chunk = g_string_chunk_new(4096);
+    es->string_ids = g_hash_table_new(g_str_hash, g_str_equal);
+    es->strings = g_ptr_array_new();
+    es->scratch = g_string_new(NULL);
+    es->have_falco_bridge = find_dissector("falcobridge") != NULL;
+    es->valid = TRUE;
+
+    return es;
+}
+
+void
+event_store_free(event_store_t *es)
+{
+    if (es == NULL)
+        return;
+
+    invalidate(es);
+    g_array_free(es->columns, TRUE);
+    g_string_chunk_free(es->string_chunk);
+    g_hash_table_destroy(es->string_ids);
+    g_ptr_array_free(es->strings, TRUE);
+    g_free(es->string_ranks);
+    g_string_free(es->scratch, TRUE);
+    if (es->tree != NULL)
+        proto_tree_free(es->tree);
+    if (es->pinfo != NULL) {
+        wmem_destroy_allocator(es->pinfo->pool);
+        g_free(es->pinfo);
+    }
+    g_free(es);
+}
+
+/*
+ * Get the value of a journal field the way the dissector does, or mark
+ * the column as unusable if we can't.
+ */
+static gboolean
+journal_value(event_store_t *es, event_store_column_t *col,
+    const guint8 *val, gsize val_len, guint64 *value)
+{
+    g_string_truncate(es->scratch, 0);
+    g_string_append_len(es->scratch, (const char *)val, val_len);
+
+    if (col->is_string) {
+        /* The dissector replaces invalid UTF-8. */
+        if (memchr(es->scratch->str, '\0', val_len) != NULL ||
+                !g_utf8_validate(es->scratch->str, val_len, NULL)) {
+            col->valid = FALSE;
+            return FALSE;
+        }
+        *value = intern_string(es, es->scratch->str);
+    } else {
+        *value = (guint32)strtoul(es->scratch->str, NULL, 10);
+        if (*value >= absent_value(col->width)) {
+            col->valid = FALSE;
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void
+journal_values(event_store_t *es, const guint8 *data, gsize len,
+    guint64 *values)
+{
+    gsize offset = 0;
+
+    while (offset < len) {
+        const guint8 *line = data + offset;
+        const guint8 *line_end = (const guint8 *)memchr(line, '\n', len - offset);
+        gsize line_len = line_end ? (gsize)(line_end - line) : len - offset;
+        const guint8 *eq = (const guint8 *)memchr(line, '=', line_len);
+
+        /* The dissector skips these. */
+        if (line_len < 3) {
+            offset += line_len + 1;
+            continue;
+        }
+
+        for (guint i = 0; i < es->columns->len; i++) {
+            event_store_column_t *col = &g_array_index(es->columns, event_store_column_t, i);
+            const char *key = col->def->journal_key;
+            gsize key_len;
+
+            if (key == NULL || !col->valid)
+                continue;
+            key_len = strlen(key);
+
+            if (eq == NULL) {
+                /* A binary field; the dissector doesn't convert these
+                 * the same way. */
+                if (line_len == key_len - 1 && memcmp(line, key, line_len) == 0)
+                    col->valid = FALSE;
+                continue;
+            }
+            if (line_len < key_len || memcmp(line, key, key_len) != 0)
+                continue;
+            if (values[i] != absent_value(col->width)) {
+                /* We keep one value per frame. */
+                col->valid = FALSE;
+                continue;
+            }
+            journal_value(es, col, line + key_len, line_len - key_len, &values[i]);
+        }
+
+        if (eq == NULL) {
+            /* Binary field: the name, a newline, a 64-bit little endian
+             * length, the data and a newline. */
+            guint64 data_len;
+
+            offset += line_len + 1;
+            if (line_end == NULL || len - offset < 8)
+                break;
+            data_len = pletoh64(data + offset);
+            if (data_len >= len - offset - 8)
+                break;
+            offset += 8 + (gsize)data_len + 1;
+        } else {
+            offset += line_len + 1;
+        }
+    }
+}
+
+void
+event_store_add_record(event_store_t *es, guint32 framenum,
+    const wtap_rec *rec, const guint8 *data)
+{
+    guint64 values[G_N_ELEMENTS(stored_fields)];
+    gboolean any = FALSE;
+
+    if (!es->valid)
+        return;
+
+    if (framenum != es->num_frames + 1) {
+        invalidate(es);
+        return;
+    }
+
+    for (guint i = 0; i < es->columns->len; i++) {
+        values[i] = absent_value(g_array_index(es->columns, event_store_column_t, i).width);
+    }
+
+    if (rec->rec_type == REC_TYPE_SYSCALL) {
+        const wtap_syscall_header *hdr = &rec->rec_header.syscall_header;
+
+        /* Plugin events are handed to the Falco bridge, if there is one. */
+        if ((hdr->event_type != EVT_PLUGINEVENT_E || !es->have_falco_bridge) &&
+                hdr->event_len >= SYSDIG_EVENT_MIN_LENGTH) {
+            for (guint i = 0; i < es->columns->len; i++) {
+                event_store_column_t *col = &g_array_index(es->columns, event_store_column_t, i);
+
+                switch (col->def->source) {
+                    case SOURCE_SYSCALL_EVENT_TYPE:
+                        values[i] = hdr->event_type;
+                        break;
+                    case SOURCE_SYSCALL_CPU_ID:
+                        values[i] = hdr->cpu_id;
+                        break;
+                    case SOURCE_SYSCALL_THREAD_ID:
+                        values[i] = hdr->thread_id;
+                        break;
+                    default:
+                        break;
+                }
+                /* We can't tell this value from a missing one. */
+                if (col->def->source != SOURCE_JOURNAL && values[i] == absent_value(col->width))
+                    col->valid = FALSE;
+            }
+        }
+    } else if (rec->rec_type == REC_TYPE_SYSTEMD_JOURNAL_EXPORT && data != NULL) {
+        journal_values(es, data, rec->rec_header.systemd_journal_export_header.record_len, values);
+    }
+
+    if (!es->valid)
+        return;
+
+    for (guint i = 0; i < es->columns->len; i++) {
+        event_store_column_t *col = &g_array_index(es->columns, event_store_column_t, i);
+
+        if (!col->valid) {
+            if (col->values != NULL) {
+                es->size -= col->values->len;
+                g_byte_array_free(col->values, TRUE);
+                col->values = NULL;
+            }
+            continue;
+        }
+        if (col->values == NULL) {
+            if (values[i] == absent_value(col->width))
+                continue;
+            /* The first frame with this field; fill in the ones before. */
+            col->values = g_byte_array_sized_new((framenum + 1023) * col->width);
+            g_byte_array_set_size(col->values, (framenum - 1) * col->width);
+            memset(col->values->data, 0xff, col->values->len);
+            es->size += col->values->len;
+        }
+        append_value(es, col, values[i]);
+        any = TRUE;
+    }
+
+    if (any && es->size > EVENT_STORE_MAX_SIZE) {
+        invalidate(es);
+        return;
+    }
+
+    es->num_frames = framenum;
+}
+
+static int
+find_column(const event_store_t *es, int hfid)
+{
+    for (guint i = 0; i < es->columns->len; i++) {
+        const event_store_column_t *col = &g_array_index(es->columns, event_store_column_t, i);
+
+        if (col->hfinfo->id == hfid) {
+            /* A disabled protocol doesn't add its fields. */
+            if (!col->valid || !proto_is_protocol_enabled(find_protocol_by_id(col->hfinfo->parent)))
+                return -1;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool
+is_stored_field(int hfid, void *data)
+{
+    return find_column((const event_store_t *)data, hfid) >= 0;
+}
+
+gboolean
+event_store_can_apply(const event_store_t *es, const dfilter_t *df, guint32 num_frames)
+{
+    if (es == NULL || !es->valid || es->num_frames != num_frames || df == NULL)
+        return FALSE;
+
+    return dfilter_reads_only_fields(df, is_stored_field, (void *)es);
+}
+
+gboolean
+event_store_apply(event_store_t *es, dfilter_t *df, guint32 framenum)
+{
+    gboolean passed;
+
+    if (es->tree == NULL) {
+        es->pinfo = g_new0(packet_info, 1);
+        es->pinfo->pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+        es->tree = proto_tree_create_root(es->pinfo);
+    }
+
+    /* Only the fields the filter wants are put in the tree. */
+    dfilter_prime_proto_tree(df, es->tree);
+
+    /* Both dissectors are called directly from the frame dissector. */
+    es->pinfo->curr_proto_layer_num = 2;
+
+    for (guint i = 0; i < es->columns->len; i++) {
+        event_store_column_t *col = &g_array_index(es->columns, event_store_column_t, i);
+        guint64 value;
+
+        if (col->hfinfo->ref_type != HF_REF_TYPE_DIRECT)
+            continue;
+        value = column_value(col, framenum);
+        if (value == absent_value(col->width))
+            continue;
+
+        if (col->is_string)
+            proto_tree_add_string(es->tree, col->hfinfo->id, NULL, 0, 0,
+                (const char *)g_ptr_array_index(es->strings, (guint)value));
+        else if (col->width == 8)
+            proto_tree_add_uint64(es->tree, col->hfinfo->id, NULL, 0, 0, value);
+        else
+            proto_tree_add_uint(es->tree, col->hfinfo->id, NULL, 0, 0, (guint32)value);
+    }
+
+    passed = dfilter_apply(df, es->tree);
+
+    proto_tree_reset(es->tree);
+    wmem_free_all(es->pinfo->pool);
+
+    return passed;
+}
+
+int
+event_store_find_column(const event_store_t *es, int hfid, guint32 num_frames)
+{
+    if (es == NULL || !es->valid || es->num_frames != num_frames)
+        return -1;
+
+    return find_column(es, hfid);
+}
+
+static int
+compare_string_idx(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const GPtrArray *strings = (const GPtrArray *)user_data;
+
+    return strcmp((const char *)g_ptr_array_index(strings, *(const guint32 *)a),
+                  (const char *)g_ptr_array_index(strings, *(const guint32 *)b));
+}
+
+static void
+update_string_ranks(event_store_t *es)
+{
+    guint32 *order;
+
+    if (es->ranks_valid)
+        return;
+
+    order = g_new(guint32, es->strings->len);
+    for (guint32 i = 0; i < es->strings->len; i++) {
+        order[i] = i;
+    }
+    g_qsort_with_data(order, es->strings->len, sizeof(guint32), compare_string_idx, es->strings);
+
+    es->string_ranks = g_renew(guint32, es->string_ranks, es->strings->len);
+    for (guint32 i = 0; i < es->strings->len; i++) {
+        es->string_ranks[order[i]] = i;
+    }
+    g_free(order);
+    es->ranks_valid = TRUE;
+}
+
+gboolean
+event_store_get_sort_key(event_store_t *es, int column, guint32 framenum, guint64 *key)
+{
+    event_store_column_t *col = &g_array_index(es->columns, event_store_column_t, column);
+    guint64 value = column_value(col, framenum);
+
+    if (value == absent_value(col->width))
+        return FALSE;
+
+    if (col->is_string) {
+        update_string_ranks(es);
+        value = es->string_ranks[value];
+    }
+    *key = value;
+    return TRUE;
+}
@@ -0,0 +1,86 @@
+/** @file
+ *
+ * A columnar store of the fields of system call and log records, filled
+ * directly from the records as they are read, so that those records can
+ * be filtered and sorted without being dissected.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __EVENT_STORE_H__
+#define __EVENT_STORE_H__
+
+#include <glib.h>
+#include "ws_symbol_export.h"
+
+#include <wiretap/wtap.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _event_store event_store_t;
+
+/**
+ * Create an empty store for the fields it knows how to fill (the event
+ * type, CPU and thread of sysdig events and the priority, PID, command
+ * and syslog identifier of systemd journal entries).  Must be called
+ * after the fields have been registered.
+ */
+WS_DLL_PUBLIC event_store_t *event_store_new(void);
+
+/** Free a store and all the values in it. */
+WS_DLL_PUBLIC void event_store_free(event_store_t *es);
+
+/**
+ * Store the values of a record's fields.  Records must be added in
+ * order, starting with frame 1; anything else makes the store unusable.
+ * Records of other types are counted, but have no values.
+ */
+WS_DLL_PUBLIC void event_store_add_record(event_store_t *es, guint32 framenum,
+    const wtap_rec *rec, const guint8 *data);
+
+/**
+ * Check whether a display filter can be applied from the store to each of
+ * the first num_frames frames, i.e. the store holds all of those frames
+ * and every field the display filter reads.
+ */
+WS_DLL_PUBLIC gboolean event_store_can_apply(const event_store_t *es,
+    const dfilter_t *df, guint32 num_frames);
+
+/**
+ * Apply a display filter to a frame using the stored values.  Only valid
+ * if event_store_can_apply() returned TRUE for the filter.
+ */
+WS_DLL_PUBLIC gboolean event_store_apply(event_store_t *es, dfilter_t *df,
+    guint32 framenum);
+
+/**
+ * Find the column holding a field, if the store holds all of the first
+ * num_frames frames.
+ *
+ * @return The column index, or -1 if the field isn't stored.
+ */
+WS_DLL_PUBLIC int event_store_find_column(const event_store_t *es,
+    int hfid, guint32 num_frames);
+
+/**
+ * Get a key for sorting frames by the value of a column: the value itself
+ * for numeric fields and the rank of the value among all stored values
+ * for string fields.
+ *
+ * @return TRUE if the frame has a value, FALSE if it doesn't.
+ */
+WS_DLL_PUBLIC gboolean event_store_get_sort_key(event_store_t *es,
+    int column, guint32 framenum, guint64 *key);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EVENT_STORE_H__ */
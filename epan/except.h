@@ -48,6 +48,22 @@ extern "C" {
 
 enum { except_no_call, except_call };
 
+/*
+ * A catcher only needs the registers saved, not the signal mask, and
+ * on the BSDs and macOS setjmp() saves the signal mask with a system
+ * call, which every TRY would pay for.  Use the variant that doesn't
+ * save it where there is one.
+ */
+#ifdef _WIN32
+typedef jmp_buf except_jmp_buf;
+#define except_setjmp(env)      setjmp(env)
+#define except_longjmp(env, v)  longjmp(env, v)
+#else
+typedef sigjmp_buf except_jmp_buf;
+#define except_setjmp(env)      sigsetjmp(env, 0)
+#define except_longjmp(env, v)  siglongjmp(env, v)
+#endif
+
 typedef struct {
     unsigned long except_group;
     unsigned long except_code;
@@ -68,7 +84,7 @@ struct except_catch {
     const except_id_t *except_id;
     size_t except_size;
     except_t except_obj;
-    jmp_buf except_jmp;
+    except_jmp_buf except_jmp;
 };
 
 enum except_stacktype {
@@ -174,7 +190,7 @@ WS_DLL_PUBLIC void except_free(void *);
         struct except_stacknode except_sn;                      \
         struct except_catch except_ch;                          \
         except_setup_try(&except_sn, &except_ch, ID, NUM);      \
-        if (setjmp(except_ch.except_jmp))                       \
+        if (except_setjmp(except_ch.except_jmp))                \
             *(PPE) = &except_ch.except_obj;                     \
         else                                                    \
             *(PPE) = 0
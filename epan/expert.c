@@ -530,13 +530,33 @@ expert_create_tree(proto_item *pi, int group, int severity, const char *msg)
 	return proto_item_add_subtree(ti, ett_subexpert);
 }
 
+/* Does anything look at the expert subtree of pi? Only a visible tree
+ * or a filter, colouring rule or column referencing the expert fields
+ * (or the filterable expert field itself, or _ws.malformed) does;
+ * otherwise all of the items would be faked anyway. */
+static gboolean
+expert_tree_is_referenced(proto_item *pi, int group, int hf_index)
+{
+	if (pi == NULL)
+		return FALSE;
+
+	if (proto_field_is_referenced((proto_tree *)pi, proto_expert))
+		return TRUE;
+
+	if (group == PI_MALFORMED && proto_field_is_referenced((proto_tree *)pi, proto_malformed))
+		return TRUE;
+
+	return hf_index > 0 && proto_field_is_referenced((proto_tree *)pi, hf_index);
+}
+
 static proto_tree*
 expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int severity, int hf_index, gboolean use_vaformat,
 			const char *format, va_list ap)
 {
 	char           formatted[ITEM_LABEL_LENGTH];
 	int            pos;
-	int            tap;
+	gboolean       tap;
+	gboolean       need_tree;
 	expert_info_t *ei;
 	proto_tree    *tree;
 	proto_item    *ti;
@@ -564,6 +584,13 @@ expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int sever
 		col_add_str(pinfo->cinfo, COL_EXPERT, val_to_str(severity, expert_severity_vals, "Unknown (%u)"));
 	}
 
+	/* Only format the message if something is going to show it */
+	tap = have_tap_listener(expert_tap);
+	need_tree = expert_tree_is_referenced(pi, group, hf_index);
+	if (!tap && !need_tree) {
+		return NULL;
+	}
+
 	if (use_vaformat) {
 		pos = vsnprintf(formatted, ITEM_LABEL_LENGTH, format, ap);
 	} else {
@@ -578,30 +605,32 @@ expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int sever
 		ws_utf8_truncate(formatted, ITEM_LABEL_LENGTH - 1);
 	}
 
-	tree = expert_create_tree(pi, group, severity, formatted);
+	if (need_tree) {
+		tree = expert_create_tree(pi, group, severity, formatted);
 
-	if (hf_index <= 0) {
-		/* If no filterable expert info, just add the message */
-		ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, formatted);
+		if (hf_index <= 0) {
+			/* If no filterable expert info, just add the message */
+			ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, formatted);
+			proto_item_set_generated(ti);
+		} else {
+			/* If filterable expert info, hide the "generic" form of the message,
+			   and generate the formatted filterable expert info */
+			ti = proto_tree_add_none_format(tree, hf_index, NULL, 0, 0, "%s", formatted);
+			proto_item_set_generated(ti);
+			ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, formatted);
+			proto_item_set_hidden(ti);
+		}
+
+		ti = proto_tree_add_uint_format_value(tree, hf_expert_severity, NULL, 0, 0, severity,
+						      "%s", val_to_str_const(severity, expert_severity_vals, "Unknown"));
 		proto_item_set_generated(ti);
-	} else {
-		/* If filterable expert info, hide the "generic" form of the message,
-		   and generate the formatted filterable expert info */
-		ti = proto_tree_add_none_format(tree, hf_index, NULL, 0, 0, "%s", formatted);
+		ti = proto_tree_add_uint_format_value(tree, hf_expert_group, NULL, 0, 0, group,
+						      "%s", val_to_str_const(group, expert_group_vals, "Unknown"));
 		proto_item_set_generated(ti);
-		ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, formatted);
-		proto_item_set_hidden(ti);
+	} else {
+		tree = NULL;
 	}
 
-	ti = proto_tree_add_uint_format_value(tree, hf_expert_severity, NULL, 0, 0, severity,
-					      "%s", val_to_str_const(severity, expert_severity_vals, "Unknown"));
-	proto_item_set_generated(ti);
-	ti = proto_tree_add_uint_format_value(tree, hf_expert_group, NULL, 0, 0, group,
-					      "%s", val_to_str_const(group, expert_group_vals, "Unknown"));
-	proto_item_set_generated(ti);
-
-	tap = have_tap_listener(expert_tap);
-
 	if (!tap)
 		return tree;
 
@@ -102,7 +102,8 @@ expert_update_comment_count(guint64 count);
         pi is supplied
  @param pi Current protocol item (or NULL)
  @param eiindex The registered expert info item
- @return the newly created expert info tree
+ @return the newly created expert info tree, or NULL if neither the tree
+        nor an expert tap would see it (the message is then not formatted)
  */
 WS_DLL_PUBLIC proto_item *
 expert_add_info(packet_info *pinfo, proto_item *pi, expert_field *eiindex);
@@ -115,7 +116,8 @@ expert_add_info(packet_info *pinfo, proto_item *pi, expert_field *eiindex);
  @param pi Current protocol item (or NULL)
  @param eiindex The registered expert info item
  @param format Printf-style format string for additional arguments
- @return the newly created expert info tree
+ @return the newly created expert info tree, or NULL if neither the tree
+        nor an expert tap would see it (the message is then not formatted)
  */
 WS_DLL_PUBLIC proto_item *
 expert_add_info_format(packet_info *pinfo, proto_item *pi, expert_field *eiindex,
@@ -0,0 +1,395 @@
+/* field_cache.c
+ * A per-frame cache of the values of commonly filtered fields, so that
+ * display filters using only those fields can be applied without
+ * dissecting the frames again.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/proto.h>
+#include <wsutil/inet_cidr.h>
+
+#include "field_cache.h"
+
+/*
+ * The fields we cache.  They are the ones most often used to pick
+ * conversations out of a capture, and all have values with a small,
+ * fixed size.
+ */
+static const char *cached_fields[] = {
+    "eth.src", "eth.dst", "eth.addr",
+    "ip.src", "ip.dst", "ip.addr", "ip.proto",
+    "ipv6.src", "ipv6.dst", "ipv6.addr",
+    "tcp.srcport", "tcp.dstport", "tcp.port", "tcp.stream",
+    "udp.srcport", "udp.dstport", "udp.port", "udp.stream",
+};
+
+/*
+ * Stop caching, and drop what we have, if the values would take more
+ * than this much memory.
+ */
+#define FIELD_CACHE_MAX_SIZE    (256 * 1024 * 1024)
+
+/*
+ * Each column holds the values of one field, in frame order.  An entry
+ * is the frame number (4 bytes), the protocol layer number (1 byte) and
+ * the value itself; frames without the field have no entries.
+ */
+#define ENTRY_HEADER_LEN    5
+
+typedef struct {
+    header_field_info *hfinfo;
+    guint       width;          /* Size of a value */
+    GByteArray *entries;
+    guint       num_entries;
+    guint       cursor;         /* Index of the entry after the last one looked up */
+} field_cache_column_t;
+
+struct _field_cache {
+    GArray     *columns;        /* field_cache_column_t */
+    guint32     num_frames;     /* Frames added, 1 .. num_frames */
+    gboolean    valid;
+    gsize       size;
+    /* Used to hold the values of a frame while applying a filter. */
+    packet_info *pinfo;
+    proto_tree *tree;
+};
+
+static guint
+value_width(enum ftenum type)
+{
+    switch (type) {
+        case FT_CHAR:
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+            return 4;
+        case FT_IPv4:
+            return 4;
+        case FT_IPv6:
+            return 16;
+        case FT_ETHER:
+            return FT_ETHER_LEN;
+        default:
+            return 0;
+    }
+}
+
+static gboolean
+encode_value(const field_cache_column_t *col, fvalue_t *fv, guint8 *buf)
+{
+    switch (col->hfinfo->type) {
+        case FT_CHAR:
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        {
+            guint32 value = fvalue_get_uinteger(fv);
+            memcpy(buf, &value, sizeof(value));
+            return TRUE;
+        }
+        case FT_IPv4:
+        {
+            const ipv4_addr_and_mask *ipv4 = fvalue_get_ipv4(fv);
+            ws_in4_addr addr;
+
+            /* Only plain addresses can be added back to a tree. */
+            if (ipv4->nmask != 0xffffffff)
+                return FALSE;
+            addr = g_htonl(ipv4->addr);
+            memcpy(buf, &addr, sizeof(addr));
+            return TRUE;
+        }
+        case FT_IPv6:
+        {
+            const ipv6_addr_and_prefix *ipv6 = fvalue_get_ipv6(fv);
+
+            if (ipv6->prefix != 128)
+                return FALSE;
+            memcpy(buf, &ipv6->addr, sizeof(ipv6->addr));
+            return TRUE;
+        }
+        case FT_ETHER:
+            memcpy(buf, fvalue_get_bytes_data(fv), FT_ETHER_LEN);
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static void
+add_value(proto_tree *tree, const field_cache_column_t *col, const guint8 *buf)
+{
+    int hfid = col->hfinfo->id;
+
+    switch (col->hfinfo->type) {
+        case FT_CHAR:
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        {
+            guint32 value;
+            memcpy(&value, buf, sizeof(value));
+            proto_tree_add_uint(tree, hfid, NULL, 0, 0, value);
+            break;
+        }
+        case FT_IPv4:
+        {
+            ws_in4_addr addr;
+            memcpy(&addr, buf, sizeof(addr));
+            proto_tree_add_ipv4(tree, hfid, NULL, 0, 0, addr);
+            break;
+        }
+        case FT_IPv6:
+        {
+            ws_in6_addr addr;
+            memcpy(&addr, buf, sizeof(addr));
+            proto_tree_add_ipv6(tree, hfid, NULL, 0, 0, &addr);
+            break;
+        }
+        case FT_ETHER:
+            proto_tree_add_ether(tree, hfid, NULL, 0, 0, buf);
+            break;
+        default:
+            ws_assert_not_reached();
+    }
+}
+
+static inline const guint8 *
+column_entry(const field_cache_column_t *col, guint idx)
+{
+    return col->entries->data + (gsize)idx * (ENTRY_HEADER_LEN + col->width);
+}
+
+static inline guint32
+entry_frame(const guint8 *entry)
+{
+    guint32 framenum;
+    memcpy(&framenum, entry, sizeof(framenum));
+    return framenum;
+}
+
+/* Find the first entry of a column for a frame at or after framenum. */
+static guint
+column_seek(const field_cache_column_t *col, guint32 framenum)
+{
+    guint low = 0, high = col->num_entries, mid;
+
+    /* Usually we're asked for the frame after the previous one, and the
+     * cursor is already at its entries, if it has any. */
+    if (col->cursor == 0 || entry_frame(column_entry(col, col->cursor - 1)) < framenum) {
+        if (col->cursor == col->num_entries ||
+                entry_frame(column_entry(col, col->cursor)) >= framenum)
+            return col->cursor;
+        low = col->cursor;
+    } else {
+        high = col->cursor;
+    }
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (entry_frame(column_entry(col, mid)) < framenum)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+static void
+free_columns(field_cache_t *fc)
+{
+    for (guint i = 0; i < fc->columns->len; i++) {
+        field_cache_column_t *col = &g_array_index(fc->columns, field_cache_column_t, i);
+
+        g_byte_array_set_size(col->entries, 0);
+        col->num_entries = 0;
+        col->cursor = 0;
+    }
+    fc->size = 0;
+}
+
+static void
+invalidate(field_cache_t *fc)
+{
+    fc->valid = FALSE;
+    free_columns(fc);
+}
+
+field_cache_t *
+field_cache_new(void)
+{
+    field_cache_t *fc = g_new0(field_cache_t, 1);
+
+    fc->columns = g_array_new(FALSE, FALSE, sizeof(field_cache_column_t));
+    for (gsize i = 0; i < G_N_ELEMENTS(cached_fields); i++) {
+        header_field_info *hfinfo = proto_registrar_get_byname(cached_fields[i]);
+
+        /* Fields with the same name are cached separately. */
+        for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            field_cache_column_t col;
+
+            col.width = value_width(hfinfo->type);
+            if (col.width == 0)
+                continue;
+            col.hfinfo = hfinfo;
+            col.entries = g_byte_array_new();
+            col.num_entries = 0;
+            col.cursor = 0;
+            g_array_append_val(fc->columns, col);
+        }
+    }
+    fc->valid = TRUE;
+
+    return fc;
+}
+
+void
+field_cache_free(field_cache_t *fc)
+{
+    if (fc == NULL)
+        return;
+
+    for (guint i = 0; i < fc->columns->len; i++) {
+        g_byte_array_free(g_array_index(fc->columns, field_cache_column_t, i).entries, TRUE);
+    }
+    g_array_free(fc->columns, TRUE);
+    if (fc->tree != NULL)
+        proto_tree_free(fc->tree);
+    if (fc->pinfo != NULL) {
+        wmem_destroy_allocator(fc->pinfo->pool);
+        g_free(fc->pinfo);
+    }
+    g_free(fc);
+}
+
+void
+field_cache_prime_edt(field_cache_t *fc, epan_dissect_t *edt)
+{
+    if (!fc->valid || edt->tree == NULL)
+        return;
+
+    for (guint i = 0; i < fc->columns->len; i++) {
+        epan_dissect_prime_with_hfid(edt,
+            g_array_index(fc->columns, field_cache_column_t, i).hfinfo->id);
+    }
+}
+
+void
+field_cache_add_frame(field_cache_t *fc, guint32 framenum, epan_dissect_t *edt)
+{
+    guint8 entry[ENTRY_HEADER_LEN + 16];
+
+    if (!fc->valid)
+        return;
+
+    if (framenum != fc->num_frames + 1 || edt->tree == NULL) {
+        invalidate(fc);
+        return;
+    }
+
+    for (guint i = 0; i < fc->columns->len; i++) {
+        field_cache_column_t *col = &g_array_index(fc->columns, field_cache_column_t, i);
+        GPtrArray *finfos = proto_get_finfo_ptr_array(edt->tree, col->hfinfo->id);
+
+        if (finfos == NULL)
+            continue;
+
+        for (guint j = 0; j < finfos->len; j++) {
+            field_info *fi = (field_info *)g_ptr_array_index(finfos, j);
+
+            if (fi->proto_layer_num > G_MAXUINT8 ||
+                    !encode_value(col, fi->value, entry + ENTRY_HEADER_LEN)) {
+                invalidate(fc);
+                return;
+            }
+            memcpy(entry, &framenum, sizeof(framenum));
+            entry[4] = (guint8)fi->proto_layer_num;
+            g_byte_array_append(col->entries, entry, ENTRY_HEADER_LEN + col->width);
+            col->num_entries++;
+            fc->size += ENTRY_HEADER_LEN + col->width;
+        }
+    }
+
+    if (fc->size > FIELD_CACHE_MAX_SIZE) {
+        invalidate(fc);
+        return;
+    }
+
+    fc->num_frames = framenum;
+}
+
+static bool
+is_cached_field(int hfid, void *data)
+{
+    const field_cache_t *fc = (const field_cache_t *)data;
+
+    for (guint i = 0; i < fc->columns->len; i++) {
+        if (g_array_index(fc->columns, field_cache_column_t, i).hfinfo->id == hfid)
+            return true;
+    }
+    return false;
+}
+
+gboolean
+field_cache_can_apply(const field_cache_t *fc, const dfilter_t *df, guint32 num_frames)
+{
+    if (fc == NULL || !fc->valid || fc->num_frames != num_frames || df == NULL)
+        return FALSE;
+
+    return dfilter_reads_only_fields(df, is_cached_field, (void *)fc);
+}
+
+gboolean
+field_cache_apply(field_cache_t *fc, dfilter_t *df, guint32 framenum)
+{
+    gboolean passed;
+
+    if (fc->tree == NULL) {
+        fc->pinfo = g_new0(packet_info, 1);
+        fc->pinfo->pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+        fc->tree = proto_tree_create_root(fc->pinfo);
+    }
+
+    /* Only the fields the filter wants are put in the tree. */
+    dfilter_prime_proto_tree(df, fc->tree);
+
+    for (guint i = 0; i < fc->columns->len; i++) {
+        field_cache_column_t *col = &g_array_index(fc->columns, field_cache_column_t, i);
+        guint idx = column_seek(col, framenum);
+
+        while (idx < col->num_entries) {
+            const guint8 *entry = column_entry(col, idx);
+
+            if (entry_frame(entry) != framenum)
+                break;
+            if (col->hfinfo->ref_type == HF_REF_TYPE_DIRECT) {
+                fc->pinfo->curr_proto_layer_num = entry[4];
+                add_value(fc->tree, col, entry + ENTRY_HEADER_LEN);
+            }
+            idx++;
+        }
+        col->cursor = idx;
+    }
+
+    passed = dfilter_apply(df, fc->tree);
+
+    proto_tree_reset(fc->tree);
+    wmem_free_all(fc->pinfo->pool);
+
+    return passed;
+}
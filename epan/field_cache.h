@@ -0,0 +1,74 @@
+/** @file
+ *
+ * A per-frame cache of the values of commonly filtered fields, so that
+ * display filters using only those fields can be applied without
+ * dissecting the frames again.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FIELD_CACHE_H__
+#define __FIELD_CACHE_H__
+
+#include <glib.h>
+#include "ws_symbol_export.h"
+
+#include <epan/epan_dissect.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _field_cache field_cache_t;
+
+/**
+ * Create an empty cache for the fields it knows how to store
+ * (addresses and ports of the common link, network and transport
+ * layers).  Must be called after the fields have been registered.
+ */
+WS_DLL_PUBLIC field_cache_t *field_cache_new(void);
+
+/** Free a cache and all the values in it. */
+WS_DLL_PUBLIC void field_cache_free(field_cache_t *fc);
+
+/**
+ * Prime an epan_dissect_t with the cached fields, so that they are
+ * available to field_cache_add_frame() after the dissection.
+ */
+WS_DLL_PUBLIC void field_cache_prime_edt(field_cache_t *fc, epan_dissect_t *edt);
+
+/**
+ * Store the values of the cached fields from a dissected frame.  Frames
+ * must be added in order, starting with frame 1; anything else (or a
+ * dissection without a tree, or running out of room) makes the cache
+ * unusable.
+ */
+WS_DLL_PUBLIC void field_cache_add_frame(field_cache_t *fc, guint32 framenum,
+    epan_dissect_t *edt);
+
+/**
+ * Check whether a display filter can be applied from the cache to each of
+ * the first num_frames frames, i.e. the cache holds all of those frames
+ * and every field the display filter reads.
+ */
+WS_DLL_PUBLIC gboolean field_cache_can_apply(const field_cache_t *fc,
+    const dfilter_t *df, guint32 num_frames);
+
+/**
+ * Apply a display filter to a frame using the cached values.  Only valid
+ * if field_cache_can_apply() returned TRUE for the filter.  Looking up
+ * frames in increasing order is cheapest.
+ */
+WS_DLL_PUBLIC gboolean field_cache_apply(field_cache_t *fc, dfilter_t *df,
+    guint32 framenum);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FIELD_CACHE_H__ */
@@ -199,6 +199,18 @@ follow_reset_stream(follow_info_t* info)
 #endif
 }
 
+void
+follow_add_record(follow_info_t *info, follow_record_t *record)
+{
+    if (info->record_func && info->record_func(info, record)) {
+        if (record->data)
+            g_byte_array_free(record->data, TRUE);
+        g_free(record);
+        return;
+    }
+    info->payload = g_list_prepend(info->payload, record);
+}
+
 void
 follow_info_free(follow_info_t* follow_info)
 {
@@ -238,7 +250,7 @@ follow_tvb_tap_listener(void *tapdata, packet_info *pinfo,
     /* update stream counter */
     follow_info->bytes_written[follow_record->is_server] += follow_record->data->len;
 
-    follow_info->payload = g_list_prepend(follow_info->payload, follow_record);
+    follow_add_record(follow_info, follow_record);
     return TAP_PACKET_DONT_REDRAW;
 }
 
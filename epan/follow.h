@@ -57,6 +57,12 @@ typedef struct {
     GByteArray *data;
 } follow_record_t;
 
+/** Called by follow_add_record() for each new record. Returns TRUE if it
+ * has consumed the record, which is then freed instead of being added to
+ * the payload list.
+ */
+typedef gboolean (*follow_record_func)(struct _follow_info *info, follow_record_t *record);
+
 typedef struct _follow_info {
     show_stream_t   show_stream;
     char            *filter_out_filter;
@@ -70,6 +76,7 @@ typedef struct _follow_info {
     address         server_ip;
     void*           gui_data;
     guint64         substream_id;  /**< Sub-stream; used only by HTTP2 and QUIC */
+    follow_record_func record_func; /**< If set, lets records be written out as they are tapped */
 } follow_info_t;
 
 struct register_follow;
@@ -178,6 +185,16 @@ WS_DLL_PUBLIC follow_sub_stream_id_func get_follow_sub_stream_id_func(register_f
 WS_DLL_PUBLIC tap_packet_status
 follow_tvb_tap_listener(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data, tap_flags_t flags);
 
+/** Add a record, in stream order, to the payload of a follow_info_t, or
+ * hand it to the follow_info_t's record_func. Followers must use this
+ * rather than adding to the payload list themselves, so that long streams
+ * can be written out without being kept in memory.
+ *
+ * @param info [in] Follow info of the stream
+ * @param record [in] The record; this function takes ownership of it
+ */
+WS_DLL_PUBLIC void follow_add_record(follow_info_t *info, follow_record_t *record);
+
 /** Interator to walk all registered followers and execute func
  *
  * @param func action to be performed on all converation tables
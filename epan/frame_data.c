@@ -11,6 +11,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/epan.h>
@@ -161,7 +163,7 @@ frame_data_init(frame_data *fdata, guint32 num, const wtap_rec *rec,
   fdata->subnum = 0;
   fdata->passed_dfilter = 1;
   fdata->dependent_of_displayed = 0;
-  fdata->dependent_frames = NULL;
+  fdata->cold = NULL;
   fdata->encoding = PACKET_CHAR_ENC_CHAR_ASCII;
   fdata->visited = 0;
   fdata->marked = 0;
@@ -232,12 +234,59 @@ frame_data_init(frame_data *fdata, guint32 num, const wtap_rec *rec,
   fdata->has_modified_block = 0;
   fdata->need_colorize = 0;
   fdata->color_filter = NULL;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
 }
 
+frame_data_cold *
+frame_data_get_cold(frame_data *fdata)
+{
+  if (fdata->cold == NULL)
+    fdata->cold = g_new0(frame_data_cold, 1);
+  return fdata->cold;
+}
+
+void
+frame_data_add_dependent_frame(frame_data *fdata, guint32 frame_num)
+{
+  frame_data_cold *cold = frame_data_get_cold(fdata);
+  guint32 *frames = cold->dependent_frames;
+  guint32 lo = 0, hi = cold->num_dependent_frames, mid;
+
+  /* Dependencies are nearly always found in ascending order, so check
+     for appending before searching for the place to insert. */
+  if (hi > 0 && frames[hi - 1] >= frame_num) {
+    while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      if (frames[mid] < frame_num)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (frames[lo] == frame_num)
+      return;
+  } else {
+    lo = hi;
+  }
+
+  if (cold->num_dependent_frames == cold->max_dependent_frames) {
+    cold->max_dependent_frames = cold->max_dependent_frames ? 2 * cold->max_dependent_frames : 4;
+    cold->dependent_frames = frames = g_renew(guint32, frames, cold->max_dependent_frames);
+  }
+  memmove(&frames[lo + 1], &frames[lo], (cold->num_dependent_frames - lo) * sizeof frames[0]);
+  frames[lo] = frame_num;
+  cold->num_dependent_frames++;
+}
+
+void
+frame_data_set_shift_offset(frame_data *fdata, const nstime_t *offset)
+{
+  /* Most frames are never shifted; don't allocate to unshift them. */
+  if (fdata->cold == NULL && nstime_is_zero(offset))
+    return;
+  frame_data_get_cold(fdata)->shift_offset = *offset;
+}
+
 void
 frame_data_set_before_dissect(frame_data *fdata,
                 nstime_t *elapsed_time,
@@ -315,9 +364,12 @@ frame_data_reset(frame_data *fdata)
     fdata->pfd = NULL;
   }
 
-  if (fdata->dependent_frames) {
-    g_hash_table_destroy(fdata->dependent_frames);
-    fdata->dependent_frames = NULL;
+  /* The dependencies are found again by dissecting; keep the shift. */
+  if (fdata->cold && fdata->cold->dependent_frames) {
+    g_free(fdata->cold->dependent_frames);
+    fdata->cold->dependent_frames = NULL;
+    fdata->cold->num_dependent_frames = 0;
+    fdata->cold->max_dependent_frames = 0;
   }
 }
 
@@ -329,9 +381,10 @@ frame_data_destroy(frame_data *fdata)
     fdata->pfd = NULL;
   }
 
-  if (fdata->dependent_frames) {
-    g_hash_table_destroy(fdata->dependent_frames);
-    fdata->dependent_frames = NULL;
+  if (fdata->cold) {
+    g_free(fdata->cold->dependent_frames);
+    g_free(fdata->cold);
+    fdata->cold = NULL;
   }
 }
 
@@ -55,10 +55,15 @@ typedef enum {
    Try to keep it close to, and less than or equal to, a power of 2.
    "Smaller than a power of 2" is OK for ILP32 platforms.
 
+   Fields that only a few frames ever have set are kept in a separate
+   frame_data_cold structure, allocated only for the frames that need
+   one; use the accessors below for them.
+
    XXX - shuffle the fields to try to keep the most commonly-accessed
    fields within the first 16 or 32 bytes, so they all fit in a cache
    line? */
 struct _color_filter; /* Forward */
+struct _frame_data_cold; /* Forward */
 DIAG_OFF_PEDANTIC
 typedef struct _frame_data {
   guint32      num;          /**< Frame number */
@@ -66,12 +71,14 @@ typedef struct _frame_data {
   guint32      cap_len;      /**< Amount actually captured */
   guint32      cum_bytes;    /**< Cumulative bytes into the capture */
   gint64       file_off;     /**< File offset */
-  /* These two are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
+  /* These are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
      LLP64 (64-bit Windows) platforms.  Put them here, one after the
      other, so they don't require padding between them. */
   GSList      *pfd;          /**< Per frame proto data */
-  GHashTable  *dependent_frames;     /**< A hash table of frames which this one depends on */
+  struct _frame_data_cold *cold;     /**< Rarely set fields, or NULL if none are set */
   const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
+  guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
+  guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
   guint16      subnum;       /**< subframe number, for protocols that require this */
   /* Keep the bitfields below to 16 bits, so this plus the previous field
      are 32 bits. */
@@ -87,14 +94,54 @@ typedef struct _frame_data {
   unsigned int has_modified_block : 1; /** 1 = block for this packet has been modified */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
-  nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
-  guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
-  guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
   guint8       tcp_snd_manual_analysis;   /**< TCP SEQ Analysis Overriding, 0 = none, 1 = OOO, 2 = RET , 3 = Fast RET, 4 = Spurious RET */
+  nstime_t     abs_ts;       /**< Absolute timestamp */
 } frame_data;
 DIAG_ON_PEDANTIC
 
+/** The fields of a frame that are rarely set. */
+typedef struct _frame_data_cold {
+  guint32     *dependent_frames;     /**< Frames which this one depends on, in ascending order */
+  guint32      num_dependent_frames; /**< Number of entries used in dependent_frames */
+  guint32      max_dependent_frames; /**< Number of entries allocated in dependent_frames */
+  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
+} frame_data_cold;
+
+/** Get the rarely set fields of a frame, allocating them if the frame
+    doesn't have them yet. */
+WS_DLL_PUBLIC frame_data_cold *frame_data_get_cold(frame_data *fdata);
+
+/** Get the numbers of the frames this frame depends on, in ascending
+    order, and set *count to how many there are. */
+static inline const guint32 *
+frame_data_get_dependent_frames(const frame_data *fdata, guint32 *count)
+{
+  if (fdata->cold == NULL) {
+    *count = 0;
+    return NULL;
+  }
+  *count = fdata->cold->num_dependent_frames;
+  return fdata->cold->dependent_frames;
+}
+
+/** Record that a frame depends on another frame. */
+WS_DLL_PUBLIC void frame_data_add_dependent_frame(frame_data *fdata,
+                guint32 frame_num);
+
+/** Get how much the time stamp of a frame has been shifted. */
+static inline void
+frame_data_get_shift_offset(const frame_data *fdata, nstime_t *offset)
+{
+  if (fdata->cold)
+    *offset = fdata->cold->shift_offset;
+  else
+    nstime_set_zero(offset);
+}
+
+/** Set how much the time stamp of a frame has been shifted. */
+WS_DLL_PUBLIC void frame_data_set_shift_offset(frame_data *fdata,
+                const nstime_t *offset);
+
 /** compare two frame_datas */
 WS_DLL_PUBLIC gint frame_data_compare(const struct epan_session *epan, const frame_data *fdata1, const frame_data *fdata2, int field);
 
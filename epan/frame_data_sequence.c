@@ -312,24 +312,36 @@ free_frame_data_sequence(frame_data_sequence *fds)
 }
 
 void
-find_and_mark_frame_depended_upon(gpointer key, gpointer value _U_, gpointer user_data)
+frame_data_sequence_mark_depended_upon(frame_data_sequence *fds, const frame_data *fdata)
 {
+  GArray       *stack;
+  const guint32 *frames;
+  guint32       count;
   frame_data   *dependent_fd;
-  guint32       dependent_frame = GPOINTER_TO_UINT(key);
-  frame_data_sequence *frames   = (frame_data_sequence *)user_data;
-
-  if (dependent_frame && frames) {
-    dependent_fd = frame_data_sequence_find(frames, dependent_frame);
-    /* Don't recurse for packets we've already marked. Note we assume that no
-     * packet depends on a future packet; we assume that in other places too.
-     */
-    if (!(dependent_fd->dependent_of_displayed || dependent_fd->passed_dfilter)) {
-      dependent_fd->dependent_of_displayed = 1;
-      if (dependent_fd->dependent_frames) {
-        g_hash_table_foreach(dependent_fd->dependent_frames, find_and_mark_frame_depended_upon, frames);
-      }
-    }
+
+  frames = frame_data_get_dependent_frames(fdata, &count);
+  if (count == 0 || fds == NULL)
+    return;
+
+  /* Walk the dependencies with an explicit stack rather than recursively,
+   * as chains of them (of reassembled segments, for example) can be very
+   * long.  Don't go further for packets we've already marked. Note we
+   * assume that no packet depends on a future packet; we assume that in
+   * other places too.
+   */
+  stack = g_array_sized_new(FALSE, FALSE, sizeof(guint32), count);
+  g_array_append_vals(stack, frames, count);
+  while (stack->len > 0) {
+    dependent_fd = frame_data_sequence_find(fds, g_array_index(stack, guint32, stack->len - 1));
+    g_array_set_size(stack, stack->len - 1);
+    if (dependent_fd == NULL || dependent_fd->dependent_of_displayed || dependent_fd->passed_dfilter)
+      continue;
+    dependent_fd->dependent_of_displayed = 1;
+    frames = frame_data_get_dependent_frames(dependent_fd, &count);
+    if (count > 0)
+      g_array_append_vals(stack, frames, count);
   }
+  g_array_free(stack, TRUE);
 }
 
 /*
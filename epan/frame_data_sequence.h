@@ -33,7 +33,12 @@ WS_DLL_PUBLIC frame_data *frame_data_sequence_find(frame_data_sequence *fds,
  */
 WS_DLL_PUBLIC void free_frame_data_sequence(frame_data_sequence *fds);
 
-WS_DLL_PUBLIC void find_and_mark_frame_depended_upon(gpointer key, gpointer value, gpointer user_data);
+/*
+ * Mark all the frames that a frame depends on, directly or indirectly,
+ * as depended upon by a displayed frame.
+ */
+WS_DLL_PUBLIC void frame_data_sequence_mark_depended_upon(frame_data_sequence *fds,
+    const frame_data *fdata);
 
 
 #ifdef __cplusplus
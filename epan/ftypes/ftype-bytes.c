@@ -55,6 +55,53 @@ bytes_fvalue_get(fvalue_t *fv)
 	return g_bytes_ref(fv->value.bytes);
 }
 
+/*
+ * Fixed length addresses (FT_IS_FIXED_BYTES) are stored in the fvalue_t
+ * itself, so setting one doesn't allocate, and copying or freeing one
+ * needs nothing beyond the fvalue_t.
+ */
+static void
+fixed_bytes_fvalue_new(fvalue_t *fv)
+{
+	fv->value.fixed_bytes.len = 0;
+}
+
+static void
+fixed_bytes_set_data(fvalue_t *fv, const uint8_t *data, size_t size)
+{
+	ws_assert(size <= FT_FIXED_BYTES_MAX_LEN);
+	if (size > 0)
+		memcpy(fv->value.fixed_bytes.data, data, size);
+	fv->value.fixed_bytes.len = (uint8_t)size;
+}
+
+static void
+fixed_bytes_fvalue_set(fvalue_t *fv, GBytes *value)
+{
+	const uint8_t *data;
+	size_t size;
+
+	data = g_bytes_get_data(value, &size);
+	fixed_bytes_set_data(fv, data, size);
+}
+
+static GBytes *
+fixed_bytes_fvalue_get(fvalue_t *fv)
+{
+	return g_bytes_new(fv->value.fixed_bytes.data, fv->value.fixed_bytes.len);
+}
+
+/* Get the bytes of a value, however they're stored. */
+static const uint8_t *
+bytes_get_data(const fvalue_t *fv, size_t *size)
+{
+	if (FT_IS_FIXED_BYTES(fv->ftype->ftype)) {
+		*size = fv->value.fixed_bytes.len;
+		return fv->value.fixed_bytes.data;
+	}
+	return g_bytes_get_data(fv->value.bytes, size);
+}
+
 static char *
 oid_to_repr(wmem_allocator_t *scope, const fvalue_t *fv, ftrepr_t rtype _U_, int field_display _U_)
 {
@@ -99,7 +146,7 @@ bytes_to_repr(wmem_allocator_t *scope, const fvalue_t *fv, ftrepr_t rtype, int f
 	const uint8_t *bytes;
 	size_t bytes_size;
 
-	bytes = g_bytes_get_data(fv->value.bytes, &bytes_size);
+	bytes = bytes_get_data(fv, &bytes_size);
 
 	if (rtype == FTREPR_DFILTER) {
 		if (bytes_size == 0) {
@@ -275,23 +322,47 @@ bytes_from_sinteger64(fvalue_t *fv, const char *s, int64_t num, char **err_msg)
 	return bytes_from_uinteger64(fv, s, (uint64_t)num, err_msg);
 }
 
+/*
+ * Parse a literal as a fixed length address, storing it if it's no longer
+ * than max_len bytes; *len is set to the number of bytes in the literal,
+ * so the caller can report one that's too long or too short.
+ */
+static bool
+fixed_bytes_from_literal(fvalue_t *fv, const char *s, size_t max_len,
+			size_t *len)
+{
+	GByteArray	*bytes;
+
+	bytes = byte_array_from_literal(s, NULL);
+	if (bytes == NULL)
+		return false;
+
+	*len = bytes->len;
+	if (bytes->len <= max_len)
+		fixed_bytes_set_data(fv, bytes->data, bytes->len);
+	g_byte_array_free(bytes, true);
+	return true;
+}
+
 static bool
 ax25_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value, char **err_msg)
 {
+	size_t addr_len;
+
 	/*
-	 * Don't request an error message if bytes_from_literal fails;
+	 * Don't request an error message if fixed_bytes_from_literal fails;
 	 * if it does, we'll report an error specific to this address
 	 * type.
 	 */
-	if (bytes_from_literal(fv, s, true, NULL)) {
-		if (g_bytes_get_size(fv->value.bytes) > FT_AX25_ADDR_LEN) {
+	if (fixed_bytes_from_literal(fv, s, FT_AX25_ADDR_LEN, &addr_len)) {
+		if (addr_len > FT_AX25_ADDR_LEN) {
 			if (err_msg != NULL) {
 				*err_msg = ws_strdup_printf("\"%s\" contains too many bytes to be a valid AX.25 address.",
 				    s);
 			}
 			return false;
 		}
-		else if (g_bytes_get_size(fv->value.bytes) < FT_AX25_ADDR_LEN && !allow_partial_value) {
+		else if (addr_len < FT_AX25_ADDR_LEN && !allow_partial_value) {
 			if (err_msg != NULL) {
 				*err_msg = ws_strdup_printf("\"%s\" contains too few bytes to be a valid AX.25 address.",
 				    s);
@@ -341,20 +412,22 @@ ax25_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value, char **
 static bool
 vines_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value, char **err_msg)
 {
+	size_t addr_len;
+
 	/*
-	 * Don't request an error message if bytes_from_literal fails;
+	 * Don't request an error message if fixed_bytes_from_literal fails;
 	 * if it does, we'll report an error specific to this address
 	 * type.
 	 */
-	if (bytes_from_literal(fv, s, true, NULL)) {
-		if (g_bytes_get_size(fv->value.bytes) > FT_VINES_ADDR_LEN) {
+	if (fixed_bytes_from_literal(fv, s, FT_VINES_ADDR_LEN, &addr_len)) {
+		if (addr_len > FT_VINES_ADDR_LEN) {
 			if (err_msg != NULL) {
 				*err_msg = ws_strdup_printf("\"%s\" contains too many bytes to be a valid Vines address.",
 				    s);
 			}
 			return false;
 		}
-		else if (g_bytes_get_size(fv->value.bytes) < FT_VINES_ADDR_LEN && !allow_partial_value) {
+		else if (addr_len < FT_VINES_ADDR_LEN && !allow_partial_value) {
 			if (err_msg != NULL) {
 				*err_msg = ws_strdup_printf("\"%s\" contains too few bytes to be a valid Vines address.",
 				    s);
@@ -375,20 +448,22 @@ vines_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value, char *
 static bool
 ether_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value, char **err_msg)
 {
+	size_t addr_len;
+
 	/*
-	 * Don't request an error message if bytes_from_literal fails;
+	 * Don't request an error message if fixed_bytes_from_literal fails;
 	 * if it does, we'll report an error specific to this address
 	 * type.
 	 */
-	if (bytes_from_literal(fv, s, true, NULL)) {
-		if (g_bytes_get_size(fv->value.bytes) > FT_ETHER_LEN) {
+	if (fixed_bytes_from_literal(fv, s, FT_ETHER_LEN, &addr_len)) {
+		if (addr_len > FT_ETHER_LEN) {
 			if (err_msg != NULL) {
 				*err_msg = ws_strdup_printf("\"%s\" contains too many bytes to be a valid Ethernet address.",
 				    s);
 			}
 			return false;
 		}
-		else if (g_bytes_get_size(fv->value.bytes) < FT_ETHER_LEN && !allow_partial_value) {
+		else if (addr_len < FT_ETHER_LEN && !allow_partial_value) {
 			if (err_msg != NULL) {
 				*err_msg = ws_strdup_printf("\"%s\" contains too few bytes to be a valid Ethernet address.",
 				    s);
@@ -493,13 +568,15 @@ system_id_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value _U_
 static bool
 fcwwn_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value _U_, char **err_msg)
 {
+	size_t addr_len;
+
 	/*
-	 * Don't request an error message if bytes_from_literal fails;
+	 * Don't request an error message if fixed_bytes_from_literal fails;
 	 * if it does, we'll report an error specific to this address
 	 * type.
 	 */
-	if (bytes_from_literal(fv, s, true, NULL)) {
-		if (g_bytes_get_size(fv->value.bytes) > FT_FCWWN_LEN) {
+	if (fixed_bytes_from_literal(fv, s, FT_FCWWN_LEN, &addr_len)) {
+		if (addr_len > FT_FCWWN_LEN) {
 			if (err_msg != NULL) {
 				*err_msg = ws_strdup_printf("\"%s\" contains too many bytes to be a valid FCWWN.",
 				    s);
@@ -520,20 +597,35 @@ fcwwn_from_literal(fvalue_t *fv, const char *s, bool allow_partial_value _U_, ch
 static unsigned
 len(fvalue_t *fv)
 {
-	return (unsigned)g_bytes_get_size(fv->value.bytes);
+	size_t size;
+
+	bytes_get_data(fv, &size);
+	return (unsigned)size;
 }
 
 static void
 slice(fvalue_t *fv, GByteArray *bytes, unsigned offset, unsigned length)
 {
-	const uint8_t *data = (const uint8_t *)g_bytes_get_data(fv->value.bytes, NULL) + offset;
+	size_t size;
+	const uint8_t *data = bytes_get_data(fv, &size) + offset;
 	g_byte_array_append(bytes, data, length);
 }
 
 static enum ft_result
 cmp_order(const fvalue_t *fv_a, const fvalue_t *fv_b, int *cmp)
 {
-	*cmp = g_bytes_compare(fv_a->value.bytes, fv_b->value.bytes);
+	const uint8_t *p_a, *p_b;
+	size_t size_a, size_b;
+	int ret = 0;
+
+	/* Ordered as g_bytes_compare() orders them. */
+	p_a = bytes_get_data(fv_a, &size_a);
+	p_b = bytes_get_data(fv_b, &size_b);
+	if (size_a > 0 && size_b > 0)
+		ret = memcmp(p_a, p_b, MIN(size_a, size_b));
+	if (ret == 0 && size_a != size_b)
+		ret = size_a < size_b ? -1 : 1;
+	*cmp = ret;
 	return FT_OK;
 }
 
@@ -544,10 +636,17 @@ bytes_bitwise_and(fvalue_t *fv_dst, const fvalue_t *fv_a, const fvalue_t *fv_b,
 	const uint8_t *p_a, *p_b;
 	size_t size_a, size_b;
 
-	p_a = g_bytes_get_data(fv_a->value.bytes, &size_a);
-	p_b = g_bytes_get_data(fv_b->value.bytes, &size_b);
+	p_a = bytes_get_data(fv_a, &size_a);
+	p_b = bytes_get_data(fv_b, &size_b);
 
 	size_t len = MIN(size_a, size_b);
+	if (FT_IS_FIXED_BYTES(fv_dst->ftype->ftype)) {
+		ws_assert(len <= FT_FIXED_BYTES_MAX_LEN);
+		for (size_t i = 0; i < len; i++)
+			fv_dst->value.fixed_bytes.data[i] = p_a[i] & p_b[i];
+		fv_dst->value.fixed_bytes.len = (uint8_t)len;
+		return FT_OK;
+	}
 	if (len == 0) {
 		fv_dst->value.bytes = g_bytes_new(NULL, 0);
 		return FT_OK;
@@ -568,8 +667,8 @@ cmp_contains(const fvalue_t *fv_a, const fvalue_t *fv_b, bool *contains)
 	const void *data_a, *data_b;
 	size_t size_a, size_b;
 
-	data_a = g_bytes_get_data(fv_a->value.bytes, &size_a);
-	data_b = g_bytes_get_data(fv_b->value.bytes, &size_b);
+	data_a = bytes_get_data(fv_a, &size_a);
+	data_b = bytes_get_data(fv_b, &size_b);
 
 	if (ws_memmem(data_a, size_a, data_b, size_b)) {
 		*contains = true;
@@ -587,7 +686,7 @@ cmp_matches(const fvalue_t *fv, const ws_regex_t *regex, bool *matches)
 	const void *data;
 	size_t data_size;
 
-	data = g_bytes_get_data(fv->value.bytes, &data_size);
+	data = bytes_get_data(fv, &data_size);
 
 	*matches = ws_regex_matches_length(regex, data, data_size);
 	return FT_OK;
@@ -596,7 +695,15 @@ cmp_matches(const fvalue_t *fv, const ws_regex_t *regex, bool *matches)
 static unsigned
 bytes_hash(const fvalue_t *fv)
 {
-	return g_bytes_hash(fv->value.bytes);
+	const signed char *data;
+	size_t data_size;
+	uint32_t h = 5381;
+
+	/* The same hash as g_bytes_hash(), however the bytes are stored. */
+	data = (const signed char *)bytes_get_data(fv, &data_size);
+	for (size_t i = 0; i < data_size; i++)
+		h = (h << 5) + h + data[i];
+	return h;
 }
 
 static bool
@@ -605,7 +712,7 @@ bytes_is_zero(const fvalue_t *fv)
 	const uint8_t *data;
 	size_t data_size;
 
-	data = g_bytes_get_data(fv->value.bytes, &data_size);
+	data = bytes_get_data(fv, &data_size);
 
 	if (data_size == 0)
 		return true;
@@ -703,9 +810,9 @@ ftype_register_bytes(void)
 	static ftype_t ax25_type = {
 		FT_AX25,			/* ftype */
 		FT_AX25_ADDR_LEN,		/* wire_size */
-		bytes_fvalue_new,		/* new_value */
-		bytes_fvalue_copy,		/* copy_value */
-		bytes_fvalue_free,		/* free_value */
+		fixed_bytes_fvalue_new,		/* new_value */
+		NULL,				/* copy_value */
+		NULL,				/* free_value */
 		ax25_from_literal,		/* val_from_literal */
 		NULL,				/* val_from_string */
 		NULL,				/* val_from_charconst */
@@ -718,8 +825,8 @@ ftype_register_bytes(void)
 		NULL,				/* val_to_sinteger64 */
 		NULL,				/* val_to_double */
 
-		{ .set_value_bytes = bytes_fvalue_set },	/* union set_value */
-		{ .get_value_bytes = bytes_fvalue_get },	/* union get_value */
+		{ .set_value_bytes = fixed_bytes_fvalue_set },	/* union set_value */
+		{ .get_value_bytes = fixed_bytes_fvalue_get },	/* union get_value */
 
 		cmp_order,
 		cmp_contains,
@@ -742,9 +849,9 @@ ftype_register_bytes(void)
 	static ftype_t vines_type = {
 		FT_VINES,			/* ftype */
 		FT_VINES_ADDR_LEN,		/* wire_size */
-		bytes_fvalue_new,		/* new_value */
-		bytes_fvalue_copy,		/* copy_value */
-		bytes_fvalue_free,		/* free_value */
+		fixed_bytes_fvalue_new,		/* new_value */
+		NULL,				/* copy_value */
+		NULL,				/* free_value */
 		vines_from_literal,		/* val_from_literal */
 		NULL,				/* val_from_string */
 		NULL,				/* val_from_charconst */
@@ -757,8 +864,8 @@ ftype_register_bytes(void)
 		NULL,				/* val_to_sinteger64 */
 		NULL,				/* val_to_double */
 
-		{ .set_value_bytes = bytes_fvalue_set },	/* union set_value */
-		{ .get_value_bytes = bytes_fvalue_get },	/* union get_value */
+		{ .set_value_bytes = fixed_bytes_fvalue_set },	/* union set_value */
+		{ .get_value_bytes = fixed_bytes_fvalue_get },	/* union get_value */
 
 		cmp_order,
 		cmp_contains,
@@ -781,9 +888,9 @@ ftype_register_bytes(void)
 	static ftype_t ether_type = {
 		FT_ETHER,			/* ftype */
 		FT_ETHER_LEN,			/* wire_size */
-		bytes_fvalue_new,		/* new_value */
-		bytes_fvalue_copy,		/* copy_value */
-		bytes_fvalue_free,		/* free_value */
+		fixed_bytes_fvalue_new,		/* new_value */
+		NULL,				/* copy_value */
+		NULL,				/* free_value */
 		ether_from_literal,		/* val_from_literal */
 		NULL,				/* val_from_string */
 		NULL,				/* val_from_charconst */
@@ -796,8 +903,8 @@ ftype_register_bytes(void)
 		NULL,				/* val_to_sinteger64 */
 		NULL,				/* val_to_double */
 
-		{ .set_value_bytes = bytes_fvalue_set },	/* union set_value */
-		{ .get_value_bytes = bytes_fvalue_get },	/* union get_value */
+		{ .set_value_bytes = fixed_bytes_fvalue_set },	/* union set_value */
+		{ .get_value_bytes = fixed_bytes_fvalue_get },	/* union get_value */
 
 		cmp_order,
 		cmp_contains,
@@ -937,9 +1044,9 @@ ftype_register_bytes(void)
 	static ftype_t fcwwn_type = {
 		FT_FCWWN,			/* ftype */
 		FT_FCWWN_LEN,			/* wire_size */
-		bytes_fvalue_new,		/* new_value */
-		bytes_fvalue_copy,		/* copy_value */
-		bytes_fvalue_free,		/* free_value */
+		fixed_bytes_fvalue_new,		/* new_value */
+		NULL,				/* copy_value */
+		NULL,				/* free_value */
 		fcwwn_from_literal,		/* val_from_literal */
 		NULL,				/* val_from_string */
 		NULL,				/* val_from_charconst */
@@ -952,8 +1059,8 @@ ftype_register_bytes(void)
 		NULL,				/* val_to_sinteger64 */
 		NULL,				/* val_to_double */
 
-		{ .set_value_bytes = bytes_fvalue_set },	/* union set_value */
-		{ .get_value_bytes = bytes_fvalue_get },	/* union get_value */
+		{ .set_value_bytes = fixed_bytes_fvalue_set },	/* union set_value */
+		{ .get_value_bytes = fixed_bytes_fvalue_get },	/* union get_value */
 
 		cmp_order,
 		cmp_contains,
@@ -14,6 +14,15 @@
 #include <epan/proto.h>
 #include <epan/packet.h>
 
+/*
+ * Fixed length addresses are short enough to be stored in the fvalue_t
+ * itself, rather than in a GBytes; see ftype-bytes.c.
+ */
+#define FT_FIXED_BYTES_MAX_LEN	FT_FCWWN_LEN
+
+#define FT_IS_FIXED_BYTES(ft) \
+	((ft) == FT_AX25 || (ft) == FT_VINES || (ft) == FT_ETHER || (ft) == FT_FCWWN)
+
 struct _fvalue_t {
 	ftype_t	*ftype;
 	union {
@@ -23,6 +32,10 @@ struct _fvalue_t {
 		double			floating;
 		wmem_strbuf_t		*strbuf;
 		GBytes			*bytes;
+		struct {
+			uint8_t		data[FT_FIXED_BYTES_MAX_LEN];
+			uint8_t		len;
+		} fixed_bytes;
 		ipv4_addr_and_mask	ipv4;
 		ipv6_addr_and_prefix	ipv6;
 		e_guid_t		guid;
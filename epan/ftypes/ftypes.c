@@ -472,6 +472,16 @@ fvalue_new(ftenum_t ftype)
 	return fv;
 }
 
+fvalue_t*
+fvalue_new_in_scope(wmem_allocator_t *scope, ftenum_t ftype)
+{
+	fvalue_t		*fv;
+
+	fv = wmem_new(scope, fvalue_t);
+	fvalue_init(fv, ftype);
+	return fv;
+}
+
 fvalue_t*
 fvalue_dup(const fvalue_t *fv_orig)
 {
@@ -922,6 +932,14 @@ fvalue_set_byte_array(fvalue_t *fv, GByteArray *value)
 void
 fvalue_set_bytes_data(fvalue_t *fv, const void *data, size_t size)
 {
+	if (FT_IS_FIXED_BYTES(fv->ftype->ftype)) {
+		/* Stored in the fvalue_t itself; no need for a GBytes. */
+		ws_assert(size <= FT_FIXED_BYTES_MAX_LEN);
+		memcpy(fv->value.fixed_bytes.data, data, size);
+		fv->value.fixed_bytes.len = (uint8_t)size;
+		return;
+	}
+
 	GBytes *bytes = g_bytes_new(data, size);
 	fvalue_set_bytes(fv, bytes);
 	g_bytes_unref(bytes);
@@ -930,33 +948,25 @@ fvalue_set_bytes_data(fvalue_t *fv, const void *data, size_t size)
 void
 fvalue_set_fcwwn(fvalue_t *fv, const uint8_t *value)
 {
-	GBytes *bytes = g_bytes_new(value, FT_FCWWN_LEN);
-	fvalue_set_bytes(fv, bytes);
-	g_bytes_unref(bytes);
+	fvalue_set_bytes_data(fv, value, FT_FCWWN_LEN);
 }
 
 void
 fvalue_set_ax25(fvalue_t *fv, const uint8_t *value)
 {
-	GBytes *bytes = g_bytes_new(value, FT_AX25_ADDR_LEN);
-	fvalue_set_bytes(fv, bytes);
-	g_bytes_unref(bytes);
+	fvalue_set_bytes_data(fv, value, FT_AX25_ADDR_LEN);
 }
 
 void
 fvalue_set_vines(fvalue_t *fv, const uint8_t *value)
 {
-	GBytes *bytes = g_bytes_new(value, FT_VINES_ADDR_LEN);
-	fvalue_set_bytes(fv, bytes);
-	g_bytes_unref(bytes);
+	fvalue_set_bytes_data(fv, value, FT_VINES_ADDR_LEN);
 }
 
 void
 fvalue_set_ether(fvalue_t *fv, const uint8_t *value)
 {
-	GBytes *bytes = g_bytes_new(value, FT_ETHER_LEN);
-	fvalue_set_bytes(fv, bytes);
-	g_bytes_unref(bytes);
+	fvalue_set_bytes_data(fv, value, FT_ETHER_LEN);
 }
 
 void
@@ -1098,6 +1108,9 @@ fvalue_get_bytes(fvalue_t *fv)
 size_t
 fvalue_get_bytes_size(fvalue_t *fv)
 {
+	if (FT_IS_FIXED_BYTES(fv->ftype->ftype))
+		return fv->value.fixed_bytes.len;
+
 	GBytes *bytes = fvalue_get_bytes(fv);
 	size_t size = g_bytes_get_size(bytes);
 	g_bytes_unref(bytes);
@@ -1107,6 +1120,10 @@ fvalue_get_bytes_size(fvalue_t *fv)
 const void *
 fvalue_get_bytes_data(fvalue_t *fv)
 {
+	/* The GBytes we'd get for these is a copy, freed before we return. */
+	if (FT_IS_FIXED_BYTES(fv->ftype->ftype))
+		return fv->value.fixed_bytes.data;
+
 	GBytes *bytes = fvalue_get_bytes(fv);
 	const void *data = g_bytes_get_data(bytes, NULL);
 	g_bytes_unref(bytes);
@@ -307,6 +307,13 @@ WS_DLL_PUBLIC
 fvalue_t*
 fvalue_new(ftenum_t ftype);
 
+/* Allocate an fvalue_t from a wmem scope; the fvalue_t itself is freed
+ * with the scope, so release what it refers to with fvalue_cleanup(),
+ * not fvalue_free(). */
+WS_DLL_PUBLIC
+fvalue_t*
+fvalue_new_in_scope(wmem_allocator_t *scope, ftenum_t ftype);
+
 WS_DLL_PUBLIC
 fvalue_t*
 fvalue_dup(const fvalue_t *fv);
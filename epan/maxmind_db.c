@@ -76,6 +76,7 @@ static wmem_map_t *mmdb_ipv4_map;
 static wmem_map_t *mmdb_ipv6_map;
 static GAsyncQueue *mmdbr_response_q; // g_allocated mmdbr_response_t *
 static GThread *read_mmdbr_stdout_thread;
+static guint mmdbr_in_flight; // Requests without a response. Main thread only.
 
 // Interned strings
 static wmem_map_t *mmdb_str_chunk;
@@ -341,15 +342,11 @@ read_mmdbr_stdout_worker(gpointer data _U_) {
                 g_async_queue_push(mmdbr_response_q, response); // Will be freed by maxmind_db_pop_response.
                 response = g_new0(mmdb_response_t, 1);
             } else if (strcmp(cur_addr, "init") != 0) {
-                if (resolve_synchronously) {
-                    // Synchronous lookups expect a 1-in 1-out resolution.
-                    ws_debug("Pushing not-found result due to bad address");
-                    g_async_queue_push(mmdbr_response_q, response); // Will be freed by maxmind_db_pop_response.
-                    response = g_new0(mmdb_response_t, 1);
-                }
-                else {
-                    ws_debug("Discarded previous values due to bad address");
-                }
+                // Each request gets exactly one response, so that the main
+                // thread can tell when all of them have been answered.
+                ws_debug("Pushing not-found result");
+                g_async_queue_push(mmdbr_response_q, response); // Will be freed by maxmind_db_pop_response.
+                response = g_new0(mmdb_response_t, 1);
             }
             cur_addr[0] = '\0';
             init_lookup(&response->mmdb_val);
@@ -376,6 +373,7 @@ static void mmdb_resolve_stop(void) {
     while (mmdbr_request_q && (request = (char *) g_async_queue_try_pop(mmdbr_request_q)) != NULL) {
         g_free(request);
     }
+    mmdbr_in_flight = 0;
 
     if (!mmdbr_pipe_valid()) {
         ws_debug("not cleaning up, invalid PID %"G_PID_FORMAT, mmdbr_pipe.pid);
@@ -673,7 +671,13 @@ static void maxmind_db_pop_response(mmdb_response_t *response)
     if (response->fatal_err == TRUE) {
         mmdb_resolve_stop();
         /* XXX: We could call mmdb_resolve_start() instead */
+    } else if (!response->mmdb_val.found) {
+        /* The address is already in the map as mmdb_not_found. */
+        if (mmdbr_in_flight > 0)
+            mmdbr_in_flight--;
     } else {
+        if (mmdbr_in_flight > 0)
+            mmdbr_in_flight--;
         mmdb_lookup_t *mmdb_val = (mmdb_lookup_t *) wmem_memdup(wmem_epan_scope(), &response->mmdb_val, sizeof(mmdb_lookup_t));
         if (response->mmdb_val.country_iso) {
             char *country_iso = (char *) response->mmdb_val.country_iso;
@@ -706,15 +710,21 @@ static void maxmind_db_pop_response(mmdb_response_t *response)
     g_free(response);
 }
 
-static void maxmind_db_await_response(void)
+/*
+ * Wait for the responses to all outstanding requests, including any that
+ * were made asynchronously before the one we're interested in.
+ */
+static void maxmind_db_await_responses(void)
 {
     mmdb_response_t *response;
 
     if (mmdbr_response_q != NULL) {
-        ws_debug("entering blocking wait for response");
-        response = (mmdb_response_t *) g_async_queue_pop(mmdbr_response_q);
-        ws_debug("exiting blocking wait for response");
-        maxmind_db_pop_response(response);
+        ws_debug("entering blocking wait for %u responses", mmdbr_in_flight);
+        while (mmdbr_in_flight > 0) {
+            response = (mmdb_response_t *) g_async_queue_pop(mmdbr_response_q);
+            maxmind_db_pop_response(response);
+        }
+        ws_debug("exiting blocking wait for responses");
     }
 }
 
@@ -735,6 +745,11 @@ gboolean maxmind_db_lookup_process(void)
     return new_entries;
 }
 
+void maxmind_db_lookup_wait(void)
+{
+    maxmind_db_await_responses();
+}
+
 const mmdb_lookup_t *
 maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
     if (!gbl_resolv_flags.maxmind_geoip) {
@@ -752,8 +767,9 @@ maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
             ws_inet_ntop4(addr, addr_str, WS_INET_ADDRSTRLEN);
             ws_debug("looking up %s", addr_str);
             g_async_queue_push(mmdbr_request_q, ws_strdup_printf("%s\n", addr_str));
+            mmdbr_in_flight++;
             if (resolve_synchronously) {
-                maxmind_db_await_response();
+                maxmind_db_await_responses();
                 result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
             }
         }
@@ -779,8 +795,9 @@ maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
             ws_inet_ntop6(addr, addr_str, WS_INET6_ADDRSTRLEN);
             ws_debug("looking up %s", addr_str);
             g_async_queue_push(mmdbr_request_q, ws_strdup_printf("%s\n", addr_str));
+            mmdbr_in_flight++;
             if (resolve_synchronously) {
-                maxmind_db_await_response();
+                maxmind_db_await_responses();
                 result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
             }
         }
@@ -835,6 +852,9 @@ maxmind_db_lookup_process(void)
     return FALSE;
 }
 
+void
+maxmind_db_lookup_wait(void) {}
+
 const mmdb_lookup_t *
 maxmind_db_lookup_ipv4(const ws_in4_addr *addr _U_) {
     return &mmdb_not_found;
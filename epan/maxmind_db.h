@@ -77,6 +77,12 @@ WS_DLL_PUBLIC gchar *maxmind_db_get_paths(void);
  */
 WS_DLL_LOCAL gboolean maxmind_db_lookup_process(void);
 
+/**
+ * Wait until every outstanding request has been answered, and process
+ * the responses.
+ */
+WS_DLL_LOCAL void maxmind_db_lookup_wait(void);
+
 /**
  * Checks whether the lookup result was successful and has valid coordinates.
  */
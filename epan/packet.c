@@ -43,6 +43,7 @@
 #include <wsutil/str_util.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 
 static gint proto_malformed;
 static dissector_handle_t frame_handle = NULL;
@@ -92,6 +93,10 @@ struct dissector_table {
 	protocol_t	*protocol;
 	GHashFunc	hash_func;
 	gboolean	supports_decode_as;
+	/* Direct-indexed copy of a busy uint table, see find_uint_dtbl_entry() */
+	dtbl_entry_t	**uint_array;
+	guint32		uint_array_len;
+	guint		uint_lookups;
 };
 
 /*
@@ -144,6 +149,27 @@ static GArray *postdissectors = NULL;
  */
 #define POSTDISSECTORS(i)	g_array_index(postdissectors, postdissector, i)
 
+/*
+ * Protocols set with set_wanted_protocols(), or NULL if we dissect
+ * everything.
+ */
+static GArray *wanted_protocols = NULL;
+
+/*
+ * Time spent in the dissectors of each protocol, keyed by protocol ID,
+ * or NULL if set_dissector_timing() hasn't turned timing on.
+ */
+typedef struct {
+	guint64 calls;
+	gint64  total_time;	/* Including the dissectors it called */
+	gint64  self_time;	/* Excluding them */
+} dissector_timing_t;
+
+static GHashTable *dissector_timings = NULL;
+
+/* Time spent in the dissectors called by the one being timed. */
+static gint64 *dissector_timing_child_time = NULL;
+
 static void
 destroy_depend_dissector_list(void *data)
 {
@@ -192,6 +218,7 @@ destroy_dissector_table(void *data)
 	struct dissector_table *table = (struct dissector_table *)data;
 
 	g_hash_table_destroy(table->hash_table);
+	g_free(table->uint_array);
 	g_slist_free(table->dissector_handles);
 	g_slice_free(struct dissector_table, data);
 }
@@ -296,6 +323,8 @@ packet_cleanup(void)
 		}
 		g_array_free(postdissectors, TRUE);
 	}
+	set_wanted_protocols(NULL, 0);
+	set_dissector_timing(FALSE);
 }
 
 /*
@@ -476,10 +505,7 @@ mark_frame_as_depended_upon(frame_data *fd, guint32 frame_num)
 		/* ws_assert(frame_num < fd->num) - we assume in several other
 		 * places in the code that frames don't depend on future
 		 * frames. */
-		if (fd->dependent_frames == NULL) {
-			fd->dependent_frames = g_hash_table_new(g_direct_hash, g_direct_equal);
-		}
-		g_hash_table_add(fd->dependent_frames, GUINT_TO_POINTER(frame_num));
+		frame_data_add_dependent_frame(fd, frame_num);
 	}
 }
 
@@ -650,6 +676,9 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 	frame_dissector_data.file_type_subtype = file_type_subtype;
 	frame_dissector_data.color_edt = edt; /* Used strictly for "coloring rules" */
 
+	/* Attribute any profiled allocations to the protocol being dissected */
+	wmem_profile_set_context(&edt->pi.current_proto);
+
 	TRY {
 		/* Add this tvbuffer into the data_src list */
 		add_new_data_source(&edt->pi, edt->tvb, record_type);
@@ -669,6 +698,7 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 					       record_type);
 	}
 	ENDTRY;
+	wmem_profile_set_context(NULL);
 	wtap_block_unref(rec->block);
 	rec->block = NULL;
 
@@ -710,6 +740,7 @@ dissect_file(epan_dissect_t *edt, wtap_rec *rec,
 
 	frame_delta_abs_time(edt->session, fd, fd->frame_ref_num, &edt->pi.rel_ts);
 
+	wmem_profile_set_context(&edt->pi.current_proto);
 
 	TRY {
 		/*
@@ -743,6 +774,7 @@ dissect_file(epan_dissect_t *edt, wtap_rec *rec,
 					       "[Malformed Record: Packet Length]");
 	}
 	ENDTRY;
+	wmem_profile_set_context(NULL);
 	wtap_block_unref(rec->block);
 	rec->block = NULL;
 
@@ -766,6 +798,9 @@ struct dissector_handle {
 	void		*dissector_func;
 	void		*dissector_data;
 	protocol_t	*protocol;
+	dissector_fast_t fast_func;	/* columns and taps only entry point, or NULL */
+	int * const	*fast_fields;	/* fields the dissector can add to the tree */
+	guint		fast_flags;	/* DISSECTOR_FAST_ flags */
 };
 
 static void
@@ -839,9 +874,79 @@ remove_last_layer(packet_info *pinfo, gboolean reduce_count)
  * The only time this function will return 0 is if it is a new style dissector
  * and if the dissector rejected the packet.
  */
+static int
+call_dissector_func(dissector_handle_t handle, tvbuff_t *tvb,
+		    packet_info *pinfo, proto_tree *tree, gboolean fast, void *data)
+{
+	if (fast) {
+		return handle->fast_func(tvb, pinfo, data);
+	}
+	else if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
+		return ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
+	}
+	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
+		return ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
+	}
+	ws_assert_not_reached();
+}
+
+static void
+dissector_timing_add(dissector_handle_t handle, gint64 elapsed, gint64 child_time)
+{
+	int proto_id = handle->protocol != NULL ? proto_get_id(handle->protocol) : -1;
+	dissector_timing_t *timing;
+
+	timing = (dissector_timing_t *)g_hash_table_lookup(dissector_timings, GINT_TO_POINTER(proto_id));
+	if (timing == NULL) {
+		timing = g_new0(dissector_timing_t, 1);
+		g_hash_table_insert(dissector_timings, GINT_TO_POINTER(proto_id), timing);
+	}
+	timing->calls++;
+	timing->total_time += elapsed;
+	timing->self_time += elapsed - child_time;
+}
+
+/*
+ * Call a dissector, adding the time it takes to its protocol's totals
+ * (and to the time of the dissector that called it, if that's being
+ * timed) and to the trace, even if it throws an exception.
+ */
+static int
+call_dissector_func_timed(dissector_handle_t handle, tvbuff_t *tvb,
+			  packet_info *pinfo, proto_tree *tree, gboolean fast, void *data)
+{
+	gint64 * volatile saved_child_time = dissector_timing_child_time;
+	volatile gint64 child_time = 0;
+	volatile gint64 start;
+	volatile int len = 0;
+	gint64 elapsed;
+
+	dissector_timing_child_time = (gint64 *)&child_time;
+	start = g_get_monotonic_time();
+	TRY {
+		len = call_dissector_func(handle, tvb, pinfo, tree, fast, data);
+	}
+	FINALLY {
+		elapsed = g_get_monotonic_time() - start;
+		dissector_timing_child_time = saved_child_time;
+		if (saved_child_time != NULL)
+			*saved_child_time += elapsed;
+		if (dissector_timings != NULL)
+			dissector_timing_add(handle, elapsed, child_time);
+		if (ws_trace_enabled())
+			ws_trace_add("dissector", handle->protocol != NULL ?
+			    proto_get_protocol_short_name(handle->protocol) :
+			    (handle->name != NULL ? handle->name : "(unknown)"),
+			    start, elapsed);
+	}
+	ENDTRY;
+
+	return len;
+}
+
 static int
 call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
-			      packet_info *pinfo, proto_tree *tree, void *data)
+			      packet_info *pinfo, proto_tree *tree, gboolean fast, void *data)
 {
 	const char *saved_proto;
 	int         len;
@@ -853,14 +958,11 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
-	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
-		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
-	}
-	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
-		len = ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
+	if (dissector_timings != NULL || ws_trace_enabled()) {
+		len = call_dissector_func_timed(handle, tvb, pinfo, tree, fast, data);
 	}
 	else {
-		ws_assert_not_reached();
+		len = call_dissector_func(handle, tvb, pinfo, tree, fast, data);
 	}
 	pinfo->current_proto = saved_proto;
 
@@ -887,6 +989,113 @@ call_dissector_work_error(dissector_handle_t handle, tvbuff_t *tvb,
  */
 #define PINFO_LAYER_MAX_RECURSION_DEPTH 500
 
+void
+set_dissector_timing(gboolean enable)
+{
+	if (enable && dissector_timings == NULL) {
+		dissector_timings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	}
+	else if (!enable && dissector_timings != NULL) {
+		g_hash_table_destroy(dissector_timings);
+		dissector_timings = NULL;
+	}
+}
+
+void
+dissector_timing_foreach(dissector_timing_func func, gpointer user_data)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	if (dissector_timings == NULL)
+		return;
+
+	g_hash_table_iter_init(&iter, dissector_timings);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		const dissector_timing_t *timing = (const dissector_timing_t *)value;
+
+		func(GPOINTER_TO_INT(key), timing->calls, timing->total_time,
+		    timing->self_time, user_data);
+	}
+}
+
+void
+set_wanted_protocols(const int *proto_ids, guint num_proto_ids)
+{
+	if (wanted_protocols) {
+		g_array_free(wanted_protocols, TRUE);
+		wanted_protocols = NULL;
+	}
+	if (proto_ids != NULL && num_proto_ids != 0) {
+		wanted_protocols = g_array_sized_new(FALSE, FALSE, sizeof (int), num_proto_ids);
+		g_array_append_vals(wanted_protocols, proto_ids, num_proto_ids);
+	}
+}
+
+/*
+ * Do we need to call the dissector for this protocol?  We do if it's
+ * wanted, or if some wanted protocol hasn't appeared in this packet yet,
+ * as that protocol might be above this one.
+ */
+static gboolean
+protocol_is_wanted(packet_info *pinfo, int proto_id)
+{
+	guint i;
+
+	for (i = 0; i < wanted_protocols->len; i++) {
+		if (g_array_index(wanted_protocols, int, i) == proto_id)
+			return TRUE;
+	}
+	if (pinfo->proto_layers == NULL)
+		return TRUE;
+	for (i = 0; i < wanted_protocols->len; i++) {
+		int *proto_layer_num_ptr;
+
+		/* A count of 0 means the dissector was tried but rejected the packet. */
+		proto_layer_num_ptr = (int *)wmem_map_lookup(pinfo->proto_layers,
+		    GINT_TO_POINTER(g_array_index(wanted_protocols, int, i)));
+		if (proto_layer_num_ptr == NULL || *proto_layer_num_ptr == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Can we call the columns and taps only entry point of a dissector
+ * rather than the full dissector?  We can if nothing will look at what
+ * the dissector would add to the tree, and, if the dissector keeps
+ * state, if the state has already been built on the first pass.
+ */
+static gboolean
+dissector_can_use_fast_path(dissector_handle_t handle, packet_info *pinfo,
+			    proto_tree *tree)
+{
+	int * const *field;
+
+	if (handle->fast_func == NULL)
+		return FALSE;
+
+	if (!(handle->fast_flags & DISSECTOR_FAST_STATELESS) &&
+	    !pinfo->fd->visited)
+		return FALSE;
+
+	if (tree == NULL)
+		return TRUE;
+
+	if (handle->protocol != NULL &&
+	    proto_field_is_referenced(tree, proto_get_id(handle->protocol)))
+		return FALSE;
+
+	if (handle->fast_fields != NULL) {
+		for (field = handle->fast_fields; *field != NULL; field++) {
+			if (proto_field_is_referenced(tree, **field))
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 static int
 call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo,
 		    proto_tree *tree, gboolean add_proto_name, void *data)
@@ -895,7 +1104,7 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 	guint16      saved_can_desegment;
 	int          len;
 	guint        saved_layers_len = 0;
-	guint        saved_tree_count = tree ? tree->tree_data->count : 0;
+	guint        saved_tree_count;
 
 	if (handle->protocol != NULL &&
 	    !proto_is_protocol_enabled(handle->protocol)) {
@@ -905,6 +1114,15 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 		return 0;
 	}
 
+	if (wanted_protocols != NULL && handle->protocol != NULL &&
+	    !protocol_is_wanted(pinfo, proto_get_id(handle->protocol))) {
+		/*
+		 * Nobody's interested in this protocol or anything that
+		 * might be above it; claim the data without looking at it.
+		 */
+		return tvb_captured_length(tvb);
+	}
+
 	saved_proto = pinfo->current_proto;
 	saved_can_desegment = pinfo->can_desegment;
 	saved_layers_len = wmem_list_count(pinfo->layers);
@@ -940,12 +1158,23 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 	}
 
 	if (pinfo->flags.in_error_pkt) {
+		saved_tree_count = tree ? tree->tree_data->count : 0;
 		len = call_dissector_work_error(handle, tvb, pinfo, tree, data);
+	} else if (dissector_can_use_fast_path(handle, pinfo, tree)) {
+		/*
+		 * Nothing wants the tree items; call the columns and
+		 * taps only entry point, and treat the layer as we
+		 * would if we had no tree.
+		 */
+		tree = NULL;
+		saved_tree_count = 0;
+		len = call_dissector_through_handle(handle, tvb, pinfo, NULL, TRUE, data);
 	} else {
 		/*
 		 * Just call the subdissector.
 		 */
-		len = call_dissector_through_handle(handle, tvb, pinfo, tree, data);
+		saved_tree_count = tree ? tree->tree_data->count : 0;
+		len = call_dissector_through_handle(handle, tvb, pinfo, tree, FALSE, data);
 	}
 	if (handle->protocol != NULL && !proto_is_pino(handle->protocol) && add_proto_name &&
 		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
@@ -1017,7 +1246,7 @@ call_dissector_work_error(dissector_handle_t handle, tvbuff_t *tvb,
 
 	/* Dissect the contained packet. */
 	TRY {
-		len = call_dissector_through_handle(handle, tvb,pinfo, tree, data);
+		len = call_dissector_through_handle(handle, tvb, pinfo, tree, FALSE, data);
 	}
 	CATCH(BoundsError) {
 		/*
@@ -1102,6 +1331,54 @@ find_dissector_table(const char *name)
 }
 
 /* Find an entry in a uint dissector table. */
+/*
+ * Tables with small keys that are looked up often (ethertypes, IP
+ * protocols, TCP and UDP ports...) are also put in an array indexed by
+ * the key, so that each layer of each packet doesn't need a hash table
+ * lookup.  The array is built once a table has been looked up
+ * UINT_ARRAY_MIN_LOOKUPS times, and only if all of its keys are below
+ * UINT_ARRAY_MAX_LEN; it is thrown away whenever the table changes and
+ * built again later.
+ */
+#define UINT_ARRAY_MIN_LOOKUPS	1000
+#define UINT_ARRAY_MAX_LEN	65536
+
+static void
+uint_table_changed(dissector_table_t sub_dissectors)
+{
+	g_free(sub_dissectors->uint_array);
+	sub_dissectors->uint_array = NULL;
+	sub_dissectors->uint_array_len = 0;
+	sub_dissectors->uint_lookups = 0;
+}
+
+static void
+uint_array_build(dissector_table_t sub_dissectors)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	guint32 len = 0;
+
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, &key, NULL)) {
+		guint32 pattern = GPOINTER_TO_UINT(key);
+
+		if (pattern >= UINT_ARRAY_MAX_LEN)
+			return;
+		if (pattern >= len)
+			len = pattern + 1;
+	}
+	if (len == 0)
+		return;
+
+	sub_dissectors->uint_array = g_new0(dtbl_entry_t *, len);
+	sub_dissectors->uint_array_len = len;
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		sub_dissectors->uint_array[GPOINTER_TO_UINT(key)] = (dtbl_entry_t *)value;
+	}
+}
+
 static dtbl_entry_t *
 find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 {
@@ -1127,6 +1404,14 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 		ws_assert_not_reached();
 	}
 
+	if (sub_dissectors->uint_array != NULL) {
+		return pattern < sub_dissectors->uint_array_len ?
+		    sub_dissectors->uint_array[pattern] : NULL;
+	}
+	if (++sub_dissectors->uint_lookups == UINT_ARRAY_MIN_LOOKUPS) {
+		uint_array_build(sub_dissectors);
+	}
+
 	/*
 	 * Find the entry.
 	 */
@@ -1211,6 +1496,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	dtbl_entry->initial = dtbl_entry->current;
 
 	/* do the table insertion */
+	uint_table_changed(sub_dissectors);
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
 
@@ -1362,6 +1648,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		/*
 		 * Found - remove it.
 		 */
+		uint_table_changed(sub_dissectors);
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
 	}
@@ -1434,6 +1721,7 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	dissector_table_t sub_dissectors = find_dissector_table(name);
 	ws_assert (sub_dissectors);
 
+	uint_table_changed(sub_dissectors);
 	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
 }
 
@@ -1443,6 +1731,7 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	dissector_table_t sub_dissectors = (dissector_table_t) value;
 	ws_assert (sub_dissectors);
 
+	uint_table_changed(sub_dissectors);
 	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
@@ -1487,6 +1776,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	dtbl_entry->current = handle;
 
 	/* do the table insertion */
+	uint_table_changed(sub_dissectors);
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
 }
@@ -1515,6 +1805,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	if (dtbl_entry->initial != NULL) {
 		dtbl_entry->current = dtbl_entry->initial;
 	} else {
+		uint_table_changed(sub_dissectors);
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
 	}
@@ -2640,7 +2931,7 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
-	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors = g_slice_new0(struct dissector_table);
 	switch (type) {
 
 	case FT_UINT8:
@@ -2713,7 +3004,7 @@ dissector_table_t register_custom_dissector_table(const char *name,
 
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
-	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors = g_slice_new0(struct dissector_table);
 	sub_dissectors->hash_func = hash_func;
 	sub_dissectors->hash_table = g_hash_table_new_full(hash_func,
 							       key_equal_func,
@@ -2882,6 +3173,8 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
 	hdtbl_entry->enabled_by_default = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->tries     = 0;
+	hdtbl_entry->accepts   = 0;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -3004,6 +3297,7 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 		pinfo->heur_list_name = hdtbl_entry->list_name;
 
+		hdtbl_entry->tries++;
 		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
 		if (hdtbl_entry->protocol != NULL &&
 			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
@@ -3028,6 +3322,7 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			}
 
 			*heur_dtbl_entry = hdtbl_entry;
+			hdtbl_entry->accepts++;
 
 			/* Bubble the matched entry to the top for faster search next time. */
 			if (prev_entry != NULL) {
@@ -3317,6 +3612,9 @@ new_dissector_handle(enum dissector_e type, void *dissector, const int proto, co
 	handle->dissector_func	= dissector;
 	handle->dissector_data	= cb_data;
 	handle->protocol	= find_protocol_by_id(proto);
+	handle->fast_func	= NULL;
+	handle->fast_fields	= NULL;
+	handle->fast_flags	= 0;
 
 	if (handle->description == NULL) {
 		/*
@@ -3434,6 +3732,23 @@ register_dissector_with_data(const char *name, dissector_cb_t dissector, const i
 	return register_dissector_handle(name, handle);
 }
 
+dissector_handle_t
+register_dissector_fast(const char *name, dissector_t dissector,
+			dissector_fast_t fast_dissector, const int proto,
+			int * const *fields, guint flags)
+{
+	struct dissector_handle *handle;
+
+	DISSECTOR_ASSERT(fast_dissector != NULL);
+
+	handle = new_dissector_handle(DISSECTOR_TYPE_SIMPLE, dissector, proto, name, NULL, NULL);
+	handle->fast_func = fast_dissector;
+	handle->fast_fields = fields;
+	handle->fast_flags = flags;
+
+	return register_dissector_handle(name, handle);
+}
+
 static gboolean
 remove_depend_dissector_from_list(depend_dissector_list_t sub_dissectors, const char *dependent)
 {
@@ -84,6 +84,13 @@ typedef int (*dissector_t)(tvbuff_t *, packet_info *, proto_tree *, void *);
 /* Same as dissector_t with an extra parameter for callback pointer */
 typedef int (*dissector_cb_t)(tvbuff_t *, packet_info *, proto_tree *, void *, void *);
 
+/*
+ * Columns and taps only entry point of a dissector registered with
+ * register_dissector_fast(); it returns the same values as the
+ * dissector_t, but never has a tree to add items to.
+ */
+typedef int (*dissector_fast_t)(tvbuff_t *, packet_info *, void *);
+
 /** Type of a heuristic dissector, used in heur_dissector_add().
  *
  * @param tvb the tvbuff with the (remaining) packet data
@@ -470,6 +477,8 @@ typedef struct heur_dtbl_entry {
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
 	bool enabled_by_default;
+	guint64 tries;        /* number of times the dissector was called */
+	guint64 accepts;      /* number of times it accepted the packet */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -571,6 +580,32 @@ WS_DLL_PUBLIC dissector_handle_t register_dissector_with_description(const char
 /** Register a new dissector with a callback pointer. */
 WS_DLL_PUBLIC dissector_handle_t register_dissector_with_data(const char *name, dissector_cb_t dissector, const int proto, void *cb_data);
 
+/** The dissector keeps no state between packets, so its columns and taps
+ *  only entry point can be used on the first pass as well. */
+#define DISSECTOR_FAST_STATELESS	0x00000001
+
+/** Register a new dissector that also has a columns and taps only entry
+ *  point.  That entry point is called instead of the dissector when
+ *  nothing will look at the items the dissector would add to the tree:
+ *  there is no tree, or the tree isn't visible and neither the protocol
+ *  nor any of the fields are referenced by a filter, column, or the like.
+ *  Unless the dissector is DISSECTOR_FAST_STATELESS, the full dissector
+ *  is always called on the first pass so that it can build its state.
+ *
+ * @param name the name of the dissector
+ * @param dissector the full dissector
+ * @param fast_dissector the columns and taps only entry point
+ * @param proto the protocol id of the dissector
+ * @param fields NULL-terminated array of pointers to the hf ids of all of
+ *        the fields the dissector can add, or NULL if it adds only its
+ *        protocol item; it must remain valid as long as the dissector is
+ *        registered
+ * @param flags DISSECTOR_FAST_ flags
+ */
+WS_DLL_PUBLIC dissector_handle_t register_dissector_fast(const char *name,
+    dissector_t dissector, dissector_fast_t fast_dissector, const int proto,
+    int * const *fields, guint flags);
+
 /** Deregister a dissector. */
 void deregister_dissector(const char *name);
 
@@ -662,6 +697,51 @@ WS_DLL_PUBLIC int call_dissector_only(dissector_handle_t handle, tvbuff_t *tvb,
 WS_DLL_PUBLIC void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tvb,
     packet_info *pinfo, proto_tree *tree, void *data);
 
+/**
+ * Only dissect as far as the given protocols.
+ *
+ * Once every one of the protocols has been dissected in a packet, the
+ * dissectors for any other protocols are no longer called for that
+ * packet; they're treated as having dissected all of their data.  For
+ * example, with only "ip" wanted, IP is dissected but TCP and anything
+ * above it isn't, whereas with "tls" wanted, TCP is dissected in order to
+ * get to TLS.  Fields of a skipped protocol that would have been added to
+ * the trees of the protocols below it, and further instances of a wanted
+ * protocol tunneled inside a skipped one, are not seen.
+ *
+ * This is only suitable when the caller knows every field it will look
+ * at, and no taps, column values or postdissectors are involved.
+ *
+ *   @param proto_ids The protocol IDs, or NULL to dissect everything.
+ *   @param num_proto_ids The number of protocol IDs.
+ */
+WS_DLL_PUBLIC void set_wanted_protocols(const int *proto_ids, guint num_proto_ids);
+
+/**
+ * Turn on, or off and discard, timing of the dissectors called through
+ * handles.  While it's on, the number of calls and the time spent in the
+ * dissectors of each protocol are added up, both with and without the
+ * time spent in the dissectors they call.  Heuristic dissectors aren't
+ * called through handles; their time counts towards the dissector that
+ * tried them.  Timing makes each call somewhat slower.
+ *
+ *   @param enable TRUE to start timing, FALSE to stop.
+ */
+WS_DLL_PUBLIC void set_dissector_timing(gboolean enable);
+
+/** Called by dissector_timing_foreach() with the totals of a protocol, or
+ * of dissector handles without a protocol if proto_id is -1.  Times are
+ * in microseconds.
+ */
+typedef void (*dissector_timing_func)(int proto_id, guint64 calls,
+    gint64 total_time, gint64 self_time, gpointer user_data);
+
+/** Call func for each protocol whose dissectors have been timed since
+ * set_dissector_timing() turned timing on.
+ */
+WS_DLL_PUBLIC void dissector_timing_foreach(dissector_timing_func func,
+    gpointer user_data);
+
 /* This is opaque outside of "packet.c". */
 struct depend_dissector_list;
 typedef struct depend_dissector_list *depend_dissector_list_t;
@@ -86,6 +86,12 @@ static gchar *gpf_path = NULL;
 static gchar *cols_hidden_list = NULL;
 static gboolean gui_theme_is_dark = FALSE;
 
+/* Changed whenever changed preferences are applied. */
+static guint prefs_epoch = 0;
+
+/* Set by prefs_reset(), which stashes all preferences before resetting them. */
+static gboolean prefs_reset_stashed = FALSE;
+
 /*
  * XXX - variables to allow us to attempt to interpret the first
  * "mgcp.{tcp,udp}.port" in a preferences file as
@@ -911,6 +917,100 @@ prefs_modules_foreach_submodules(module_t *module, module_cb callback,
     return prefs_module_list_foreach((module)?module->submodules:prefs_top_level_modules, callback, user_data, TRUE);
 }
 
+typedef struct {
+    unsigned int flags;     /* Effects of the preferences that differ */
+    gboolean uncomparable;  /* The module has preferences that can't be compared */
+} stash_diff_t;
+
+static guint
+pref_stash_diff(pref_t *pref, gpointer user_data)
+{
+    stash_diff_t *diff = (stash_diff_t *)user_data;
+    gboolean differs = FALSE;
+
+    switch (pref->type) {
+
+    case PREF_DECODE_AS_UINT:
+    case PREF_UINT:
+        differs = *pref->varp.uint != pref->stashed_val.uint;
+        break;
+
+    case PREF_BOOL:
+        differs = *pref->varp.boolp != pref->stashed_val.boolval;
+        break;
+
+    case PREF_ENUM:
+        differs = *pref->varp.enump != pref->stashed_val.enumval;
+        break;
+
+    case PREF_STRING:
+    case PREF_SAVE_FILENAME:
+    case PREF_OPEN_FILENAME:
+    case PREF_DIRNAME:
+    case PREF_PASSWORD:
+    case PREF_DISSECTOR:
+        differs = g_strcmp0(*pref->varp.string, pref->stashed_val.string) != 0;
+        break;
+
+    case PREF_DECODE_AS_RANGE:
+    case PREF_RANGE:
+        /*
+         * Resetting a range that wasn't the default replaced it, and
+         * dissectors may hold on to the old one; see reset_pref_cb().
+         */
+        differs = !ranges_are_equal(*pref->varp.range, pref->stashed_val.range) ||
+                  !ranges_are_equal(pref->stashed_val.range, pref->default_val.range);
+        break;
+
+    case PREF_COLOR:
+        differs = (pref->varp.colorp->red != pref->stashed_val.color.red) ||
+                  (pref->varp.colorp->green != pref->stashed_val.color.green) ||
+                  (pref->varp.colorp->blue != pref->stashed_val.color.blue);
+        break;
+
+    case PREF_CUSTOM:
+    case PREF_PROTO_TCP_SNDAMB_ENUM:
+        diff->uncomparable = TRUE;
+        break;
+
+    default:
+        break;
+    }
+
+    if (differs)
+        diff->flags |= prefs_get_effect_flags(pref);
+    return 0;
+}
+
+/*
+ * After prefs_reset() and reading another profile, a module's changed
+ * flags say which of its preferences were set again, not which of them
+ * ended up with a different value.  Replace them with the latter, so that
+ * modules that were set to what they already had aren't applied.
+ */
+static bool
+set_changed_flags_from_stash(const void *key _U_, void *value, void *data _U_)
+{
+    module_t *module = (module_t *)value;
+    stash_diff_t diff = { 0, FALSE };
+
+    prefs_pref_foreach(module, pref_stash_diff, &diff);
+    if (diff.uncomparable)
+        module->prefs_changed_flags |= diff.flags;
+    else
+        module->prefs_changed_flags = diff.flags;
+    return FALSE;
+}
+
+static bool
+stash_module_prefs(const void *key _U_, void *value, void *data _U_)
+{
+    module_t *module = (module_t *)value;
+
+    prefs_pref_foreach(module, pref_stash, NULL);
+    return FALSE;
+}
+
 static bool
 call_apply_cb(const void *key _U_, void *value, void *data _U_)
 {
@@ -922,12 +1022,19 @@ call_apply_cb(const void *key _U_, void *value, void *data _U_)
         if (module->apply_cb != NULL)
             (*module->apply_cb)();
         module->prefs_changed_flags = 0;
+        prefs_epoch++;
     }
     if (module->submodules)
         wmem_tree_foreach(module->submodules, call_apply_cb, NULL);
     return FALSE;
 }
 
+guint
+prefs_get_epoch(void)
+{
+    return prefs_epoch;
+}
+
 /*
  * Call the "apply" callback function for each module if any of its
  * preferences have changed, and then clear the flag saying its
@@ -937,6 +1044,10 @@ call_apply_cb(const void *key _U_, void *value, void *data _U_)
 void
 prefs_apply_all(void)
 {
+    if (prefs_reset_stashed) {
+        wmem_tree_foreach(prefs_modules, set_changed_flags_from_stash, NULL);
+        prefs_reset_stashed = FALSE;
+    }
     wmem_tree_foreach(prefs_modules, call_apply_cb, NULL);
 }
 
@@ -3606,7 +3717,7 @@ prefs_register_modules(void)
 
     prefs_register_uint_preference(gui_module, "packet_list_cached_rows_max",
                                    "Maximum cached rows",
-                                   "Maximum number of rows that can be sorted by columns that require dissection. Increasing this increases memory consumption by caching column text",
+                                   "Maximum number of rows whose column text is cached. Increasing this increases memory consumption, but fewer rows are dissected again when scrolling",
                                    10,
                                    &prefs.gui_packet_list_cached_rows_max);
 
@@ -4470,6 +4581,14 @@ prefs_reset(void)
      */
     oids_cleanup();
 
+    /*
+     * Remember the current values, so that prefs_apply_all() can tell
+     * which modules end up with different ones once the new preferences
+     * have been read.
+     */
+    wmem_tree_foreach(prefs_modules, stash_module_prefs, NULL);
+    prefs_reset_stashed = TRUE;
+
     /*
      * Reset the non-dissector preferences.
      */
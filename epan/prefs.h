@@ -401,6 +401,13 @@ WS_DLL_PUBLIC guint prefs_modules_foreach_submodules(module_t *module, module_cb
  */
 WS_DLL_PUBLIC void prefs_apply_all(void);
 
+/**
+ * Get a number that changes whenever changed preferences are applied,
+ * so that callers can tell when something derived from them may have
+ * gone stale.
+ */
+WS_DLL_PUBLIC guint prefs_get_epoch(void);
+
 /**
  * Call the "apply" callback function for a specific module if any of
  * its preferences have changed, and then clear the flag saying its
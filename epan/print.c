@@ -82,6 +82,7 @@ struct _output_fields {
     gchar         quote;
     gboolean      escape;
     gboolean      includes_col_fields;
+    GArray       *hfids;    /* Every field with the name of a field, see output_fields_prime_edt() */
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -898,9 +899,13 @@ write_json_proto_node(GSList *node_values_head,
     // Retrieve json key from first value.
     proto_node *first_value = (proto_node *) node_values_head->data;
     const char *json_key = proto_node_to_json_key(first_value);
-    gchar* json_key_suffix = ws_strdup_printf("%s%s", json_key, suffix);
-    json_dumper_set_member_name(pdata->dumper, json_key_suffix);
-    g_free(json_key_suffix);
+    if (suffix[0] == '\0') {
+        json_dumper_set_member_name(pdata->dumper, json_key);
+    } else {
+        gchar* json_key_suffix = ws_strdup_printf("%s%s", json_key, suffix);
+        json_dumper_set_member_name(pdata->dumper, json_key_suffix);
+        g_free(json_key_suffix);
+    }
     write_json_proto_node_value_list(node_values_head, value_writer, pdata);
 }
 
@@ -1090,34 +1095,39 @@ proto_node_group_children_by_json_key(proto_node *node)
 {
     /**
      * For each different json key we store a linked list of values corresponding to that json key. These lists are kept
-     * in both a linked list and a hashmap. The hashmap is used to quickly retrieve the values of a json key. The linked
-     * list is used to preserve the ordering of keys as they are encountered which is not guaranteed when only using a
-     * hashmap.
+     * in a linked list, which preserves the ordering of keys as they are encountered. A hashmap from each json key to
+     * the last element of its list of values is used to quickly append another value.
      */
     GSList *same_key_nodes_list = NULL;
-    GHashTable *lookup_by_json_key = g_hash_table_new(g_str_hash, g_str_equal);
+    GHashTable *lookup_by_json_key;
     proto_node *current_child = node->first_child;
 
+    // A single child needs no lookups.
+    if (current_child != NULL && current_child->next == NULL) {
+        return g_slist_prepend(NULL, g_slist_prepend(NULL, current_child));
+    }
+
+    lookup_by_json_key = g_hash_table_new(g_str_hash, g_str_equal);
+
     /**
-     * For each child of the node get the key and get the list of values already associated with that key from the
+     * For each child of the node get the key and get the last value already associated with that key from the
      * hashmap. If no list exist yet for that key create a new one and add it to both the linked list and hashmap. If a
-     * list already exists add the node to that list.
+     * list already exists add the node after its last value. Appending with g_slist_append() would walk the whole list,
+     * which is quadratic for nodes with many children with the same key.
      */
     while (current_child != NULL) {
         char *json_key = (char *) proto_node_to_json_key(current_child);
-        GSList *json_key_nodes = (GSList *) g_hash_table_lookup(lookup_by_json_key, json_key);
+        GSList *json_key_last = (GSList *) g_hash_table_lookup(lookup_by_json_key, json_key);
 
-        if (json_key_nodes == NULL) {
-            json_key_nodes = g_slist_append(json_key_nodes, current_child);
+        if (json_key_last == NULL) {
+            GSList *json_key_nodes = g_slist_prepend(NULL, current_child);
             // Prepending in single linked list is O(1), appending is O(n). Better to prepend here and reverse at the
             // end than potentially looping to the end of the linked list for each child.
             same_key_nodes_list = g_slist_prepend(same_key_nodes_list, json_key_nodes);
             g_hash_table_insert(lookup_by_json_key, json_key, json_key_nodes);
         } else {
-            // Store and insert value again to circumvent unused_variable warning.
-            // Append in this case since most value lists will only have a single value.
-            json_key_nodes = g_slist_append(json_key_nodes, current_child);
-            g_hash_table_insert(lookup_by_json_key, json_key, json_key_nodes);
+            json_key_last->next = g_slist_prepend(NULL, current_child);
+            g_hash_table_insert(lookup_by_json_key, json_key, json_key_last->next);
         }
 
         current_child = current_child->next;
@@ -1211,10 +1221,14 @@ ek_fill_attr(proto_node *node, GHashTable *attr_table, write_json_data *pdata)
         /* dissection with an invisible proto tree? */
         ws_assert(fi);
 
+        /* The abbreviation is owned by the registered field, so it can be
+         * the key as it is. The instances are prepended, which unlike
+         * appending doesn't walk the list, and put back in order when
+         * they are written. */
         attr_instances = (GSList *) g_hash_table_lookup(attr_table, fi->hfinfo->abbrev);
-        attr_instances = g_slist_append(attr_instances, current_node);
+        attr_instances = g_slist_prepend(attr_instances, current_node);
         // Update instance list for this attr in hash table
-        g_hash_table_insert(attr_table, g_strdup(fi->hfinfo->abbrev), attr_instances);
+        g_hash_table_insert(attr_table, (gpointer) fi->hfinfo->abbrev, attr_instances);
 
         /* Field, recurse through children*/
         if (fi->hfinfo->type != FT_PROTOCOL && current_node->first_child != NULL) {
@@ -1365,7 +1379,7 @@ ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
     // Raw name
     ek_write_name(pnode, "_raw", pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_begin_array(pdata->dumper);
     }
 
@@ -1379,7 +1393,7 @@ ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
         current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_end_array(pdata->dumper);
     }
 }
@@ -1400,7 +1414,7 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
     // Print attr name
     ek_write_name(pnode, NULL, pdata);
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_begin_array(pdata->dumper);
     }
 
@@ -1455,7 +1469,7 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
         current_node = current_node->next;
     }
 
-    if (g_slist_length(attr_instances) > 1) {
+    if (attr_instances->next != NULL) {
         json_dumper_end_array(pdata->dumper);
     }
 }
@@ -1470,7 +1484,7 @@ void process_ek_attrs(gpointer key _U_, gpointer value, gpointer pdata)
 static void
 proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
 {
-    GHashTable *attr_table  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GHashTable *attr_table  = g_hash_table_new(g_str_hash, g_str_equal);
     GHashTableIter iter;
     gpointer key, value;
     ek_fill_attr(node, attr_table, pdata);
@@ -1478,11 +1492,13 @@ proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
     // Print attributes
     g_hash_table_iter_init(&iter, attr_table);
     while (g_hash_table_iter_next (&iter, &key, &value)) {
+        /* ek_fill_attr() prepends the instances */
+        value = g_slist_reverse((GSList*)value);
         process_ek_attrs(key, value, pdata);
         g_hash_table_iter_remove(&iter);
-        /* We lookup a list in the table, append to it, and re-insert it; as
-         * g_slist_append() can change the start pointer of the list we can't
-         * just append to the list without replacing the old value. In turn,
+        /* We lookup a list in the table, prepend to it, and re-insert it; as
+         * g_slist_prepend() changes the start pointer of the list we can't
+         * just prepend to the list without replacing the old value. In turn,
          * that means we can't set the value_destroy_func when creating
          * the hash table, because on re-insertion that would destroy the
          * nodes of the old list, which are still being used by the new list.
@@ -2036,6 +2052,10 @@ void output_fields_free(output_fields_t* fields)
             g_free(fields->field_values);
         }
 
+        if (NULL != fields->hfids) {
+            g_array_free(fields->hfids, TRUE);
+        }
+
         for (i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
             g_free(field);
@@ -2274,6 +2294,90 @@ gboolean output_fields_has_cols(output_fields_t* fields)
     return fields->includes_col_fields;
 }
 
+gboolean output_fields_interested_in_proto(output_fields_t* fields, int proto_id)
+{
+    gsize i;
+
+    ws_assert(fields);
+    if (fields->fields == NULL) {
+        return FALSE;
+    }
+
+    for (i = 0; i < fields->fields->len; i++) {
+        header_field_info *hfinfo = proto_registrar_get_byname((const gchar *)g_ptr_array_index(fields->fields, i));
+
+        /* A protocol's parent is -1, so this checks protocols and fields */
+        if (hfinfo != NULL && (hfinfo->id == proto_id || hfinfo->parent == proto_id)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+gboolean output_fields_interested_in_field(output_fields_t* fields, int hf_id)
+{
+    gsize i;
+
+    ws_assert(fields);
+    if (fields->fields == NULL) {
+        return FALSE;
+    }
+
+    for (i = 0; i < fields->fields->len; i++) {
+        header_field_info *hfinfo = proto_registrar_get_byname((const gchar *)g_ptr_array_index(fields->fields, i));
+
+        if (hfinfo != NULL && hfinfo->id == hf_id) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+gboolean output_fields_need_visible_tree(output_fields_t* fields)
+{
+    gsize i;
+
+    ws_assert(fields);
+    if (fields->fields == NULL) {
+        return FALSE;
+    }
+
+    for (i = 0; i < fields->fields->len; i++) {
+        header_field_info *hfinfo = proto_registrar_get_byname((const gchar *)g_ptr_array_index(fields->fields, i));
+
+        for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            /* These are printed as their labels (see get_node_field_value()) */
+            if (hfinfo->id == hf_text_only ||
+                (hfinfo->type == FT_PROTOCOL && hfinfo->id != proto_data)) {
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+void output_fields_prime_edt(output_fields_t* fields, epan_dissect_t *edt)
+{
+    ws_assert(fields);
+    if (fields->fields == NULL) {
+        return;
+    }
+
+    if (fields->hfids == NULL) {
+        gsize i;
+
+        fields->hfids = g_array_new(FALSE, FALSE, sizeof(int));
+        for (i = 0; i < fields->fields->len; i++) {
+            header_field_info *hfinfo = proto_registrar_get_byname((const gchar *)g_ptr_array_index(fields->fields, i));
+
+            for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+                g_array_append_val(fields->hfids, hfinfo->id);
+            }
+        }
+    }
+    epan_dissect_prime_with_hfid_array(edt, fields->hfids);
+}
+
 void write_fields_preamble(output_fields_t* fields, FILE *fh)
 {
     gsize i;
@@ -2369,7 +2473,7 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     /* dissection with an invisible proto tree? */
     ws_assert(fi);
 
-    field_index = g_hash_table_lookup(call_data->fields->field_indicies, fi->hfinfo->abbrev);
+    field_index = g_hash_table_lookup(call_data->fields->field_indicies, fi->hfinfo);
     if (NULL != field_index) {
         format_field_values(call_data->fields, field_index,
                             get_node_field_value(fi, call_data->edt) /* g_ alloc'd string */
@@ -2403,17 +2507,24 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     data.edt = edt;
 
     if (NULL == fields->field_indicies) {
-        /* Prepare a lookup table from string abbreviation for field to its index. */
-        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+        /* Prepare a lookup table from the header_field_info of each field
+         * (including any other fields with the same abbreviation) to its
+         * index, so that the nodes of the tree can be matched without
+         * hashing and comparing abbreviations.
+         */
+        fields->field_indicies = g_hash_table_new(g_direct_hash, g_direct_equal);
 
         i = 0;
         while (i < fields->fields->len) {
             gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+            header_field_info *hfinfo = proto_registrar_get_byname(field);
             /* Store field indicies +1 so that zero is not a valid value,
              * and can be distinguished from NULL as a pointer.
              */
             ++i;
-            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
+            for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+                g_hash_table_insert(fields->field_indicies, hfinfo, GUINT_TO_POINTER(i));
+            }
         }
     }
 
@@ -2685,6 +2796,7 @@ output_fields_t* output_fields_new(void)
     fields->quote               ='\0';
     fields->escape              = TRUE;
     fields->includes_col_fields = FALSE;
+    fields->hfids               = NULL;
     return fields;
 }
 
@@ -71,6 +71,23 @@ WS_DLL_PUBLIC gboolean output_fields_set_option(output_fields_t* info, gchar* op
 WS_DLL_PUBLIC void output_fields_list_options(FILE *fh);
 WS_DLL_PUBLIC bool output_fields_add_protocolfilter(output_fields_t* info, const char* field, pf_flags filter_flags);
 WS_DLL_PUBLIC gboolean output_fields_has_cols(output_fields_t* info);
+WS_DLL_PUBLIC gboolean output_fields_interested_in_proto(output_fields_t* info, int proto_id);
+WS_DLL_PUBLIC gboolean output_fields_interested_in_field(output_fields_t* info, int hf_id);
+
+/**
+ * Check whether the values of the fields are only known from a visible
+ * protocol tree.  That's the case for protocols, which are printed as
+ * their labels; other fields can be printed from a tree that isn't
+ * visible, as long as it's primed with output_fields_prime_edt().
+ */
+WS_DLL_PUBLIC gboolean output_fields_need_visible_tree(output_fields_t* info);
+
+/**
+ * Prime an epan_dissect_t with the fields, so that they're in its
+ * protocol tree even if the tree isn't visible.  Must be called before
+ * each dissection.
+ */
+WS_DLL_PUBLIC void output_fields_prime_edt(output_fields_t* info, epan_dissect_t *edt);
 
 /*
  * Higher-level packet-printing code.
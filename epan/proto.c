@@ -454,11 +454,23 @@ static GHashTable *gpa_protocol_aliases = NULL;
 
 /*
  * We're called repeatedly with the same field name when sorting a column.
- * Cache our last gpa_name_map hit for faster lookups.
+ * Cache our last gpa_name_map hit for faster lookups; the name to compare
+ * against is the hit's own abbreviation, so nothing has to be copied.
  */
-static char *last_field_name = NULL;
 static header_field_info *last_hfinfo;
 
+/* Changed whenever fields or aliases are registered or deregistered. */
+static guint registrar_epoch = 0;
+
+/*
+ * The first field registered under each abbreviation, sorted by
+ * abbreviation ignoring case, for prefix searches.  Built on first use
+ * and rebuilt when registrar_epoch has changed since.
+ */
+static header_field_info **abbrev_index;
+static guint abbrev_index_len;
+static guint abbrev_index_epoch;
+
 static void save_same_name_hfinfo(gpointer data)
 {
 	same_name_hfinfo = (header_field_info*)data;
@@ -657,8 +669,10 @@ proto_cleanup_base(void)
 		g_hash_table_destroy(gpa_protocol_aliases);
 		gpa_protocol_aliases = NULL;
 	}
-	g_free(last_field_name);
-	last_field_name = NULL;
+	last_hfinfo = NULL;
+	g_free(abbrev_index);
+	abbrev_index = NULL;
+	abbrev_index_len = 0;
 
 	while (protocols) {
 		protocol = (protocol_t *)protocols->data;
@@ -815,7 +829,8 @@ proto_tree_free_node(proto_node *node, gpointer data _U_)
 
 	proto_tree_children_foreach(node, proto_tree_free_node, NULL);
 
-	fvalue_free(finfo->value);
+	/* The fvalue_t itself is in the tree's pool; see new_field_info(). */
+	fvalue_cleanup(finfo->value);
 	finfo->value = NULL;
 }
 
@@ -1002,6 +1017,82 @@ proto_initialize_all_prefixes(void) {
  * table and if so it looks again.
  */
 
+guint
+proto_registrar_epoch(void)
+{
+	return registrar_epoch;
+}
+
+static int
+abbrev_index_compare(const void *a, const void *b)
+{
+	const header_field_info *hfinfo_a = *(const header_field_info * const *)a;
+	const header_field_info *hfinfo_b = *(const header_field_info * const *)b;
+
+	return g_ascii_strcasecmp(hfinfo_a->abbrev, hfinfo_b->abbrev);
+}
+
+static void
+abbrev_index_build(void)
+{
+	GHashTableIter     iter;
+	gpointer           value;
+	header_field_info *hfinfo;
+
+	g_free(abbrev_index);
+	abbrev_index = g_new(header_field_info *, g_hash_table_size(gpa_name_map));
+	abbrev_index_len = 0;
+
+	/* gpa_name_map holds the last field registered under each name;
+	 * index the first one, as that's where the same_name_next list
+	 * starts. */
+	g_hash_table_iter_init(&iter, gpa_name_map);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		hfinfo = (header_field_info *)value;
+		while (hfinfo->same_name_prev_id != -1)
+			PROTO_REGISTRAR_GET_NTH(hfinfo->same_name_prev_id, hfinfo);
+		abbrev_index[abbrev_index_len++] = hfinfo;
+	}
+	qsort(abbrev_index, abbrev_index_len, sizeof(header_field_info *),
+	      abbrev_index_compare);
+	abbrev_index_epoch = registrar_epoch;
+}
+
+void
+proto_registrar_foreach_prefix(const char *prefix,
+			       gboolean (*func)(header_field_info *hfinfo, void *user_data),
+			       void *user_data)
+{
+	size_t prefix_len;
+	guint  lo, hi, mid;
+
+	if (!gpa_name_map)
+		return;
+
+	if (!abbrev_index || abbrev_index_epoch != registrar_epoch)
+		abbrev_index_build();
+
+	/* Find the first abbreviation that doesn't sort before the prefix;
+	 * all those starting with the prefix follow it. */
+	prefix_len = strlen(prefix);
+	lo = 0;
+	hi = abbrev_index_len;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (g_ascii_strncasecmp(abbrev_index[mid]->abbrev, prefix, prefix_len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < abbrev_index_len; lo++) {
+		if (g_ascii_strncasecmp(abbrev_index[lo]->abbrev, prefix, prefix_len) != 0)
+			break;
+		if (!func(abbrev_index[lo], user_data))
+			break;
+	}
+}
+
 header_field_info *
 proto_registrar_get_byname(const char *field_name)
 {
@@ -1011,15 +1102,13 @@ proto_registrar_get_byname(const char *field_name)
 	if (!field_name)
 		return NULL;
 
-	if (g_strcmp0(field_name, last_field_name) == 0) {
+	if (last_hfinfo && strcmp(field_name, last_hfinfo->abbrev) == 0) {
 		return last_hfinfo;
 	}
 
 	hfinfo = (header_field_info *)g_hash_table_lookup(gpa_name_map, field_name);
 
 	if (hfinfo) {
-		g_free(last_field_name);
-		last_field_name = g_strdup(field_name);
 		last_hfinfo = hfinfo;
 		return hfinfo;
 	}
@@ -1037,8 +1126,6 @@ proto_registrar_get_byname(const char *field_name)
 	hfinfo = (header_field_info *)g_hash_table_lookup(gpa_name_map, field_name);
 
 	if (hfinfo) {
-		g_free(last_field_name);
-		last_field_name = g_strdup(field_name);
 		last_hfinfo = hfinfo;
 	}
 	return hfinfo;
@@ -2680,7 +2767,7 @@ static void
 free_fvalue_cb(void *data)
 {
 	fvalue_t *fv = (fvalue_t*)data;
-	fvalue_free(fv);
+	fvalue_cleanup(fv);
 }
 
 /* Add an item to a proto_tree, using the text label registered to that item;
@@ -6333,7 +6420,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		for (tnode = tree; tnode != NULL; tnode = tnode->parent) {
 			depth++;
 			if (G_UNLIKELY(depth > prefs.gui_max_tree_depth)) {
-				fvalue_free(fi->value);
+				fvalue_cleanup(fi->value);
 				fi->value = NULL;
 				THROW_MESSAGE(DissectorError, wmem_strdup_printf(PNODE_POOL(tree),
 						     "Maximum tree depth %d exceeded for \"%s\" - \"%s\" (%s:%u) (Maximum depth can be increased in advanced preferences)",
@@ -6358,7 +6445,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		/* Since we are not adding fi to a node, its fvalue won't get
 		 * freed by proto_tree_free_node(), so free it now.
 		 */
-		fvalue_free(fi->value);
+		fvalue_cleanup(fi->value);
 		fi->value = NULL;
 		REPORT_DISSECTOR_BUG("\"%s\" - \"%s\" tfi->tree_type: %d invalid (%s:%u)",
 				     fi->hfinfo->name, fi->hfinfo->abbrev, tfi->tree_type, __FILE__, __LINE__);
@@ -6711,7 +6798,12 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 	fi->flags      = 0;
 	if (!PTREE_DATA(tree)->visible)
 		FI_SET_FLAG(fi, FI_HIDDEN);
-	fi->value = fvalue_new(fi->hfinfo->type);
+	/*
+	 * Allocate the value from the same pool as the field_info, so that
+	 * both go away when the pool is freed after the packet; only what
+	 * the value refers to has to be released node by node.
+	 */
+	fi->value = fvalue_new_in_scope(PNODE_POOL(tree), fi->hfinfo->type);
 	fi->rep        = NULL;
 
 	/* add the data source tvbuff */
@@ -6835,8 +6927,7 @@ hfinfo_same_name_get_prev(const header_field_info *hfinfo)
 static void
 hfinfo_remove_from_gpa_name_map(const header_field_info *hfinfo)
 {
-	g_free(last_field_name);
-	last_field_name = NULL;
+	last_hfinfo = NULL;
 
 	if (!hfinfo->same_name_next && hfinfo->same_name_prev_id == -1) {
 		/* No hfinfo with the same name */
@@ -6893,15 +6984,19 @@ proto_item_fill_display_label(field_info *finfo, gchar *display_label_str, const
 			break;
 
 		case FT_ABSOLUTE_TIME:
-			tmp_str = abs_time_to_str(NULL, fvalue_get_time(finfo->value), hfinfo->display, TRUE);
-			label_len = protoo_strlcpy(display_label_str, tmp_str, label_str_size);
-			wmem_free(NULL, tmp_str);
+			if (label_str_size == 0)
+				return 0;
+			abs_time_to_str_ex_buf(display_label_str, label_str_size,
+				fvalue_get_time(finfo->value), hfinfo->display, ABS_TIME_TO_STR_SHOW_ZONE);
+			label_len = (int)strlen(display_label_str);
 			break;
 
 		case FT_RELATIVE_TIME:
-			tmp_str = rel_time_to_secs_str(NULL, fvalue_get_time(finfo->value));
-			label_len = protoo_strlcpy(display_label_str, tmp_str, label_str_size);
-			wmem_free(NULL, tmp_str);
+			if (label_str_size == 0)
+				return 0;
+			display_signed_time(display_label_str, label_str_size,
+				fvalue_get_time(finfo->value), WS_TSPREC_NSEC);
+			label_len = (int)strlen(display_label_str);
 			break;
 
 		case FT_BOOLEAN:
@@ -8035,6 +8130,8 @@ proto_deregister_protocol(const char *short_name)
 	if (protocol == NULL)
 		return FALSE;
 
+	registrar_epoch++;
+
 	g_hash_table_remove(proto_names, protocol->name);
 	g_hash_table_remove(proto_short_names, (gpointer)short_name);
 	g_hash_table_remove(proto_filter_names, (gpointer)protocol->filter_name);
@@ -8058,8 +8155,7 @@ proto_deregister_protocol(const char *short_name)
 	g_ptr_array_add(deregistered_fields, gpa_hfinfo.hfi[proto_id]);
 	g_hash_table_steal(gpa_name_map, protocol->filter_name);
 
-	g_free(last_field_name);
-	last_field_name = NULL;
+	last_hfinfo = NULL;
 
 	return TRUE;
 }
@@ -8071,6 +8167,7 @@ proto_register_alias(const int proto_id, const char *alias_name)
 
 	protocol = find_protocol_by_id(proto_id);
 	if (alias_name && protocol) {
+		registrar_epoch++;
 		g_hash_table_insert(gpa_protocol_aliases, (gpointer) alias_name, (gpointer)protocol->filter_name);
 	}
 }
@@ -8527,12 +8624,13 @@ proto_deregister_field (const int parent, gint hf_id)
 	protocol_t       *proto;
 	guint             i;
 
-	g_free(last_field_name);
-	last_field_name = NULL;
+	last_hfinfo = NULL;
 
 	if (hf_id == -1 || hf_id == 0)
 		return;
 
+	registrar_epoch++;
+
 	proto = find_protocol_by_id (parent);
 	if (!proto || proto->fields == NULL) {
 		return;
@@ -9420,6 +9518,8 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 
 	tmp_fld_check_assert(hfinfo);
 
+	registrar_epoch++;
+
 	hfinfo->parent         = parent;
 	hfinfo->same_name_next = NULL;
 	hfinfo->same_name_prev_id = -1;
@@ -9759,17 +9859,25 @@ proto_item_fill_label(field_info *fi, gchar *label_str)
 			break;
 
 		case FT_ABSOLUTE_TIME:
-			tmp = abs_time_to_str(NULL, fvalue_get_time(fi->value), hfinfo->display, TRUE);
-			label_fill(label_str, 0, hfinfo, tmp);
-			wmem_free(NULL, tmp);
+		{
+			char time_buf[ABS_TIME_STR_MAX_LEN];
+
+			abs_time_to_str_ex_buf(time_buf, sizeof(time_buf),
+				fvalue_get_time(fi->value), hfinfo->display, ABS_TIME_TO_STR_SHOW_ZONE);
+			label_fill(label_str, 0, hfinfo, time_buf);
 			break;
+		}
 
 		case FT_RELATIVE_TIME:
-			tmp = rel_time_to_secs_str(NULL, fvalue_get_time(fi->value));
+		{
+			char time_buf[NSTIME_SECS_STR_LEN];
+
+			display_signed_time(time_buf, sizeof(time_buf),
+				fvalue_get_time(fi->value), WS_TSPREC_NSEC);
 			snprintf(label_str, ITEM_LABEL_LENGTH,
-				   "%s: %s seconds", hfinfo->name, tmp);
-			wmem_free(NULL, tmp);
+				   "%s: %s seconds", hfinfo->name, time_buf);
 			break;
+		}
 
 		case FT_IPXNET:
 			integer = fvalue_get_uinteger(fi->value);
@@ -11266,7 +11374,8 @@ proto_registrar_dump_protocols(void)
  * Field 2 = Field abbreviation to which this extended value string header corresponds
  * Field 3 = Extended Value String "Name"
  * Field 4 = Number of entries in the associated value_string array
- * Field 5 = Access Type: "Linear Search", "Binary Search", "Direct (indexed) Access"
+ * Field 5 = Access Type: "Linear Search", "Binary Search", "Direct (indexed) Access",
+ *           "Direct (lookup table) Access", "Binary Search (sorted index)"
  *
  * Range Strings
  * -------------
@@ -2658,6 +2658,23 @@ WS_DLL_PUBLIC header_field_info* proto_registrar_get_nth(guint hfindex);
  @return the registered item */
 WS_DLL_PUBLIC header_field_info* proto_registrar_get_byname(const char *field_name);
 
+/** Get a number that changes whenever fields or protocol aliases are
+    registered or deregistered, so that callers can tell when something
+    they looked up by name may have gone stale.
+ @return the current registration epoch */
+WS_DLL_PUBLIC guint proto_registrar_epoch(void);
+
+/** Call a function for each registered field or protocol whose
+    abbreviation starts with a prefix, ignoring case, in order of
+    abbreviation.  Only the first of several fields registered under the
+    same abbreviation is passed; the others follow it in same_name_next.
+ @param prefix the prefix to match
+ @param func called for each match; return FALSE to stop
+ @param user_data passed to func */
+WS_DLL_PUBLIC void proto_registrar_foreach_prefix(const char *prefix,
+        gboolean (*func)(header_field_info *hfinfo, void *user_data),
+        void *user_data);
+
 /** Get the header_field information based upon a field alias.
  @param alias_name the aliased field name to search for
  @return the registered item */
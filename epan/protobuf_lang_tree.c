@@ -393,16 +393,20 @@ pbl_method_descriptor_full_name(const pbl_method_descriptor_t* method)
 const pbl_message_descriptor_t*
 pbl_method_descriptor_input_type(const pbl_method_descriptor_t* method)
 {
-    const pbl_node_t* n = pbl_find_node_in_context((pbl_node_t*)method, method->in_msg_type, PBL_MESSAGE);
-    return n ? (const pbl_message_descriptor_t*)n : NULL;
+    if (method->in_msg_node == NULL) {
+        ((pbl_method_descriptor_t*)method)->in_msg_node = pbl_find_node_in_context((pbl_node_t*)method, method->in_msg_type, PBL_MESSAGE);
+    }
+    return (const pbl_message_descriptor_t*)method->in_msg_node;
 }
 
 /* like MethodDescriptor::output_type() */
 const pbl_message_descriptor_t*
 pbl_method_descriptor_output_type(const pbl_method_descriptor_t* method)
 {
-    const pbl_node_t* n = pbl_find_node_in_context((pbl_node_t*)method, method->out_msg_type, PBL_MESSAGE);
-    return n ? (const pbl_message_descriptor_t*)n : NULL;
+    if (method->out_msg_node == NULL) {
+        ((pbl_method_descriptor_t*)method)->out_msg_node = pbl_find_node_in_context((pbl_node_t*)method, method->out_msg_type, PBL_MESSAGE);
+    }
+    return (const pbl_message_descriptor_t*)method->out_msg_node;
 }
 
 /* like descriptor_pool::FindMessageTypeByName() */
@@ -494,11 +498,13 @@ pbl_field_descriptor_type(const pbl_field_descriptor_t* field)
         node = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_ENUM);
         if (node) {
             ((pbl_field_descriptor_t*)field)->type = PROTOBUF_TYPE_ENUM;
+            ((pbl_field_descriptor_t*)field)->type_node = node;
         } else {
             /* try to lookup as MESSAGE */
             node = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_MESSAGE);
             if (node) {
                 ((pbl_field_descriptor_t*)field)->type = PROTOBUF_TYPE_MESSAGE;
+                ((pbl_field_descriptor_t*)field)->type_node = node;
             }
         }
     }
@@ -561,10 +567,14 @@ pbl_field_descriptor_TypeName(int field_type)
 const pbl_message_descriptor_t*
 pbl_field_descriptor_message_type(const pbl_field_descriptor_t* field)
 {
-    const pbl_node_t* n;
     if (field->type == PROTOBUF_TYPE_MESSAGE || field->type == PROTOBUF_TYPE_GROUP) {
-        n = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_MESSAGE);
-        return n ? (const pbl_message_descriptor_t*)n : NULL;
+        /* Resolving the name means building and looking up every scoped
+         * candidate name, which is too slow to do for each field while
+         * dissecting; the pool doesn't change once loaded, so keep the result. */
+        if (field->type_node == NULL) {
+            ((pbl_field_descriptor_t*)field)->type_node = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_MESSAGE);
+        }
+        return (const pbl_message_descriptor_t*)field->type_node;
     }
     return NULL;
 }
@@ -573,10 +583,12 @@ pbl_field_descriptor_message_type(const pbl_field_descriptor_t* field)
 const pbl_enum_descriptor_t*
 pbl_field_descriptor_enum_type(const pbl_field_descriptor_t* field)
 {
-    const pbl_node_t* n;
     if (field->type == PROTOBUF_TYPE_ENUM) {
-        n = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_ENUM);
-        return n ? (const pbl_enum_descriptor_t*)n : NULL;
+        /* see pbl_field_descriptor_message_type() */
+        if (field->type_node == NULL) {
+            ((pbl_field_descriptor_t*)field)->type_node = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_ENUM);
+        }
+        return (const pbl_enum_descriptor_t*)field->type_node;
     }
     return NULL;
 }
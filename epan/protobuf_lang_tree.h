@@ -80,6 +80,8 @@ typedef struct {
     gboolean in_is_stream;
     gchar* out_msg_type;
     gboolean out_is_stream;
+    const pbl_node_t* in_msg_node; /* message in_msg_type refers to, resolved during first access */
+    const pbl_node_t* out_msg_node; /* message out_msg_type refers to, resolved during first access */
 } pbl_method_descriptor_t;
 
 /* like google::protobuf::Descriptor of protobuf cpp library */
@@ -101,6 +103,7 @@ typedef struct {
     int number;
     int type; /* refer to PROTOBUF_TYPE_XXX of protobuf-helper.h */
     gchar* type_name;
+    const pbl_node_t* type_node; /* message or enum type_name refers to, resolved during first access */
     pbl_node_t* options_node;
     gboolean is_repeated;
     gboolean is_required;
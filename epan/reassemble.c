@@ -9,6 +9,7 @@
  */
 
 #include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_EPAN
 
 #include <string.h>
 
@@ -19,6 +20,31 @@
 
 #include <wsutil/str_util.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/wslog.h>
+
+/*
+ * Addresses up to this length (which includes IPv4 and IPv6 addresses)
+ * are stored in persistent keys themselves, so that creating a key is a
+ * single allocation.
+ */
+#define FRAGMENT_KEY_ADDR_LEN	16
+
+/*
+ * Copy an address into a persistent key, using the storage in the key if
+ * it fits. free_address() leaves such addresses alone, as they don't own
+ * their data.
+ */
+static void
+copy_key_address(address *to, guint8 *buf, const address *from)
+{
+	if (from->type != AT_NONE && from->len > 0 &&
+	    from->len <= FRAGMENT_KEY_ADDR_LEN) {
+		memcpy(buf, from->data, from->len);
+		set_address(to, from->type, from->len, buf);
+	} else {
+		copy_address(to, from);
+	}
+}
 
 /*
  * Functions for reassembly tables where the endpoint addresses, and a
@@ -28,6 +54,8 @@ typedef struct _fragment_addresses_key {
 	address src;
 	address dst;
 	guint32 id;
+	guint8 src_data[FRAGMENT_KEY_ADDR_LEN];	/* persistent keys only */
+	guint8 dst_data[FRAGMENT_KEY_ADDR_LEN];	/* persistent keys only */
 } fragment_addresses_key;
 
 GList* reassembly_table_list = NULL;
@@ -37,23 +65,15 @@ fragment_addresses_hash(gconstpointer k)
 {
 	const fragment_addresses_key* key = (const fragment_addresses_key*) k;
 	guint hash_val;
-/*
-	int i;
-*/
-
-	hash_val = 0;
 
-/*	More than likely: in most captures src and dst addresses are the
-	same, and would hash the same.
-	We only use id as the hash as an optimization.
-
-	for (i = 0; i < key->src.len; i++)
-		hash_val += key->src.data[i];
-	for (i = 0; i < key->dst.len; i++)
-		hash_val += key->dst.data[i];
-*/
-
-	hash_val += key->id;
+	/*
+	 * The ID alone is a poor hash when many hosts send fragments
+	 * (IP IDs are only 16 bits, and often start at the same value),
+	 * so mix in the addresses as well.
+	 */
+	hash_val = key->id;
+	hash_val = add_address_to_hash(hash_val, &key->src);
+	hash_val = add_address_to_hash(hash_val, &key->dst);
 
 	return hash_val;
 }
@@ -108,8 +128,8 @@ fragment_addresses_persistent_key(const packet_info *pinfo, const guint32 id,
 	/*
 	 * Do a deep copy of the addresses.
 	 */
-	copy_address(&key->src, &pinfo->src);
-	copy_address(&key->dst, &pinfo->dst);
+	copy_key_address(&key->src, key->src_data, &pinfo->src);
+	copy_key_address(&key->dst, key->dst_data, &pinfo->dst);
 	key->id = id;
 
 	return (gpointer)key;
@@ -158,6 +178,8 @@ typedef struct _fragment_addresses_ports_key {
 	guint32 src_port;
 	guint32 dst_port;
 	guint32 id;
+	guint8 src_data[FRAGMENT_KEY_ADDR_LEN];	/* persistent keys only */
+	guint8 dst_data[FRAGMENT_KEY_ADDR_LEN];	/* persistent keys only */
 } fragment_addresses_ports_key;
 
 static guint
@@ -165,25 +187,12 @@ fragment_addresses_ports_hash(gconstpointer k)
 {
 	const fragment_addresses_ports_key* key = (const fragment_addresses_ports_key*) k;
 	guint hash_val;
-/*
-	int i;
-*/
 
-	hash_val = 0;
-
-/*	More than likely: in most captures src and dst addresses and ports
-	are the same, and would hash the same.
-	We only use id as the hash as an optimization.
-
-	for (i = 0; i < key->src.len; i++)
-		hash_val += key->src_addr.data[i];
-	for (i = 0; i < key->dst.len; i++)
-		hash_val += key->dst_addr.data[i];
-	hash_val += key->src_port;
-	hash_val += key->dst_port;
-*/
-
-	hash_val += key->id;
+	/* See fragment_addresses_hash(). */
+	hash_val = key->id;
+	hash_val = add_address_to_hash(hash_val, &key->src_addr);
+	hash_val = add_address_to_hash(hash_val, &key->dst_addr);
+	hash_val ^= (key->src_port << 16) | (key->dst_port & 0xffff);
 
 	return hash_val;
 }
@@ -242,8 +251,8 @@ fragment_addresses_ports_persistent_key(const packet_info *pinfo,
 	/*
 	 * Do a deep copy of the addresses.
 	 */
-	copy_address(&key->src_addr, &pinfo->src);
-	copy_address(&key->dst_addr, &pinfo->dst);
+	copy_key_address(&key->src_addr, key->src_data, &pinfo->src);
+	copy_key_address(&key->dst_addr, key->dst_data, &pinfo->dst);
 	key->src_port = pinfo->srcport;
 	key->dst_port = pinfo->destport;
 	key->id = id;
@@ -552,6 +561,41 @@ reassembly_table_destroy(reassembly_table *table)
 	}
 }
 
+static void
+add_fragment_stats(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	const fragment_head *fd_head = (const fragment_head *)value;
+	reassembly_table_stats *stats = (reassembly_table_stats *)user_data;
+	guint chain = 0;
+
+	if (fd_head->tvb_data && !(fd_head->flags & FD_SUBSET_TVB))
+		stats->bytes += tvb_captured_length(fd_head->tvb_data);
+	for (const fragment_item *fd = fd_head->next; fd; fd = fd->next) {
+		if (fd->tvb_data && !(fd->flags & FD_SUBSET_TVB))
+			stats->bytes += tvb_captured_length(fd->tvb_data);
+		chain++;
+	}
+	stats->fragments += chain;
+	stats->longest_chain = MAX(stats->longest_chain, chain);
+}
+
+/*
+ * Get the number of entries and fragments in a reassembly table, and
+ * the amount of data they hold.
+ */
+void
+reassembly_table_get_stats(const reassembly_table *table,
+			   reassembly_table_stats *stats)
+{
+	memset(stats, 0, sizeof *stats);
+	if (table->fragment_table != NULL) {
+		stats->fragment_entries = g_hash_table_size(table->fragment_table);
+		g_hash_table_foreach(table->fragment_table, add_fragment_stats, stats);
+	}
+	if (table->reassembled_table != NULL)
+		stats->reassembled_entries = g_hash_table_size(table->reassembled_table);
+}
+
 /*
  * Look up an fd_head in the fragment table, optionally returning the key
  * for it.
@@ -746,6 +790,8 @@ static void fragment_reset_first_gap(fragment_head *fd_head)
  */
 static void fragment_items_removed(fragment_head *fd_head, fragment_item *modified)
 {
+	/* The last fragment may have been among the removed ones. */
+	fd_head->last = NULL;
 	if ((fd_head->first_gap == modified) ||
 	    ((modified != NULL) && (modified->offset > fd_head->contiguous_len))) {
 		/* Removed elements were after first gap */
@@ -1103,6 +1149,14 @@ LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 		/* New first fragment */
 		fd->next = fd_head->next;
 		fd_head->next = fd;
+	} else if (fd_head->last != NULL && fd->offset >= fd_head->last->offset) {
+		/*
+		 * New last fragment. Fragments after a gap (e.g. while
+		 * waiting for a retransmission) usually arrive in order,
+		 * so don't walk the list from the first gap each time.
+		 */
+		fd->next = NULL;
+		fd_head->last->next = fd;
 	} else {
 		fd_i = fd_head->next;
 		if (fd_head->first_gap != NULL) {
@@ -1118,6 +1172,9 @@ LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 		fd->next = fd_i->next;
 		fd_i->next = fd;
 	}
+	if (fd->next == NULL) {
+		fd_head->last = fd;
+	}
 
 	update_first_gap(fd_head, fd, FALSE);
 }
@@ -1131,6 +1188,7 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 	if (fd == NULL) return;
 
 	multi_insert = (fd->next != NULL);
+	fd_head->last = NULL;
 
 	if (fd_head->next == NULL) {
 		fd_head->next = fd;
@@ -2454,6 +2512,7 @@ fragment_add_seq_single_move(reassembly_table *table, const packet_info *pinfo,
 			} else {
 				fh->next = fd;
 			}
+			fh->last = NULL;
 			for (; fd; fd=fd->next) {
 				fd->offset += offset;
 				if (fh->frame < fd->frame) {
@@ -2759,6 +2818,7 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 		fd_head = g_slice_new(fragment_head);
 		fd_head->next = NULL;
 		fd_head->first_gap = NULL;
+		fd_head->last = NULL;
 		fd_head->contiguous_len = 0;
 		fd_head->frame = 0;
 		fd_head->len = 0;
@@ -3144,6 +3204,19 @@ static void
 reassembly_table_cleanup_reg_table(gpointer p, gpointer user_data _U_)
 {
 	register_reassembly_table_t* reg_table = (register_reassembly_table_t*)p;
+
+	if (ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG)) {
+		reassembly_table_stats stats;
+
+		reassembly_table_get_stats(reg_table->table, &stats);
+		if (stats.fragment_entries != 0 || stats.reassembled_entries != 0) {
+			ws_debug("Reassembly table %p: %u reassemblies, %u reassembled entries, "
+			    "%" PRIu64 " fragments (at most %u in one), %" PRIu64 " bytes",
+			    (void *)reg_table->table, stats.fragment_entries,
+			    stats.reassembled_entries, stats.fragments,
+			    stats.longest_chain, stats.bytes);
+		}
+	}
 	reassembly_table_destroy(reg_table->table);
 }
 
@@ -3174,6 +3247,44 @@ reassembly_table_cleanup(void)
 	g_list_free(reassembly_table_list);
 }
 
+static gboolean
+expire_idle_fragments(gpointer key, gpointer value, gpointer user_data)
+{
+	const fragment_head *fd_head = (const fragment_head *)value;
+
+	if (fd_head->frame >= GPOINTER_TO_UINT(user_data))
+		return FALSE;
+
+	return free_all_fragments(key, value, NULL);
+}
+
+static gboolean
+expire_idle_reassembled(gpointer key, gpointer value _U_, gpointer user_data)
+{
+	const reassembled_key *r_key = (const reassembled_key *)key;
+
+	/* The key and the reference to the value are freed by the table. */
+	return r_key->frame < GPOINTER_TO_UINT(user_data);
+}
+
+static void
+reassembly_table_expire_idle(gpointer p, gpointer user_data)
+{
+	register_reassembly_table_t* reg_table = (register_reassembly_table_t*)p;
+	reassembly_table *table = reg_table->table;
+
+	if (table->fragment_table != NULL)
+		g_hash_table_foreach_remove(table->fragment_table, expire_idle_fragments, user_data);
+	if (table->reassembled_table != NULL)
+		g_hash_table_foreach_remove(table->reassembled_table, expire_idle_reassembled, user_data);
+}
+
+void
+reassembly_tables_expire_idle(const guint32 frame_num)
+{
+	g_list_foreach(reassembly_table_list, reassembly_table_expire_idle, GUINT_TO_POINTER(frame_num));
+}
+
 /* One instance of this structure is created for each pdu that spans across
  * multiple segments. (MSP) */
 typedef struct _multisegment_pdu_t {
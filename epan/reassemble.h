@@ -65,6 +65,8 @@ typedef struct _fragment_head {
 	struct _fragment_item *next;
 	struct _fragment_item *first_gap;	/**< pointer to last fragment before first gap.
 					 * NULL if there is no fragment starting at offset 0 */
+	struct _fragment_item *last;	/**< pointer to last fragment in the list,
+					 * NULL if not known */
 	guint ref_count; 		/**< reference count in reassembled_table */
 	guint32 contiguous_len;	/**< contigous length from head up to first gap */
 	guint32 frame;			/**< maximum of all frame numbers added to reassembly */
@@ -186,6 +188,25 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * Statistics for a reassembly table.
+ */
+typedef struct {
+	guint fragment_entries;		/* reassemblies in the fragment table */
+	guint reassembled_entries;	/* entries in the reassembled table */
+	guint64 fragments;		/* fragments in all the reassemblies */
+	guint longest_chain;		/* most fragments in one reassembly */
+	guint64 bytes;			/* fragment and reassembled data held */
+} reassembly_table_stats;
+
+/*
+ * Get the statistics for a reassembly table. They are also logged at
+ * debug level for each registered table when a capture file is closed.
+ */
+WS_DLL_PUBLIC void
+reassembly_table_get_stats(const reassembly_table *table,
+			   reassembly_table_stats *stats);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
@@ -562,6 +583,13 @@ extern void reassembly_tables_init(void);
 extern void
 reassembly_table_cleanup(void);
 
+/* Free, in all registered reassembly tables, the fragments of reassemblies
+ * that got none after the given frame, and the reassembled data of frames
+ * before it, for long-running single-pass captures.
+ */
+extern void
+reassembly_tables_expire_idle(const guint32 frame_num);
+
 /* ===================== Streaming data reassembly helper ===================== */
 /**
  * Macro to help to define ett or hf items variables for reassembly (especially for streaming reassembly).
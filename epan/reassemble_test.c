@@ -3203,6 +3203,65 @@ test_fragment_add_check_duplicate_conflict(void)
         print_fragment_table();
     }
 }
+
+/**********************************************************************************
+ *
+ * reassembly_table_get_stats
+ *
+ *********************************************************************************/
+
+/* Adds fragments for two datagrams, one of which gets reassembled, and checks
+ * the table statistics along the way.
+ */
+static void
+test_reassembly_table_stats(void)
+{
+    fragment_head *fd_head;
+    reassembly_table_stats stats;
+
+    printf("Starting test test_reassembly_table_stats\n");
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(0,stats.fragment_entries);
+    ASSERT_EQ(0,stats.reassembled_entries);
+    ASSERT_EQ(0,stats.fragments);
+    ASSERT_EQ(0,stats.longest_chain);
+    ASSERT_EQ(0,stats.bytes);
+
+    pinfo.num = 1;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                         0, 50, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    pinfo.num = 2;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 15, &pinfo, 13, NULL,
+                         0, 60, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    pinfo.num = 3;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 5, &pinfo, 12, NULL,
+                         110, 60, FALSE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(2,stats.fragment_entries);
+    ASSERT_EQ(0,stats.reassembled_entries);
+    ASSERT_EQ(3,stats.fragments);
+    ASSERT_EQ(2,stats.longest_chain);
+    ASSERT_EQ(170,stats.bytes);
+
+    /* fill the gap; the fragment data is replaced by the reassembled data */
+    pinfo.num = 4;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 15, &pinfo, 12, NULL,
+                         50, 60, TRUE);
+    ASSERT_NE_POINTER(NULL,fd_head);
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(2,stats.fragment_entries);
+    ASSERT_EQ(0,stats.reassembled_entries);
+    ASSERT_EQ(4,stats.fragments);
+    ASSERT_EQ(3,stats.longest_chain);
+    ASSERT_EQ(230,stats.bytes);
+}
+
 /**********************************************************************************
  *
  * main
@@ -3251,6 +3310,7 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_check_duplicate_last,
 #endif
         test_fragment_add_check_duplicate_conflict,
+        test_reassembly_table_stats,
     };
 
     /* a tvbuff for testing with */
@@ -17,7 +17,7 @@
  * https://www.iana.org/assignments/service-names-port-numbers/service-names-port-numbers.csv
  */
 
-static ws_services_entry_t global_tcp_udp_services_table[] = {
+static const ws_services_entry_t global_tcp_udp_services_table[] = {
     { 1, "tcpmux",              "TCP Port Service Multiplexer" },
     { 2, "compressnet",         "Management Utility" },
     { 3, "compressnet",         "Compression Process" },
@@ -5211,7 +5211,7 @@ static ws_services_entry_t global_tcp_udp_services_table[] = {
     { 48653, "robotraconteur",  "Robot Raconteur transport" },
 };
 
-static ws_services_entry_t global_tcp_services_table[] = {
+static const ws_services_entry_t global_tcp_services_table[] = {
     { 113, "ident",             "" },
     { 143, "imap",              "Internet Message Access Protocol" },
     { 271, "pt-tls",            "IETF Network Endpoint Assessment (NEA) Posture Transport Protocol over TLS (PT-TLS)" },
@@ -5903,7 +5903,7 @@ static ws_services_entry_t global_tcp_services_table[] = {
     { 49150, "inspider",        "InSpider System" },
 };
 
-static ws_services_entry_t global_udp_services_table[] = {
+static const ws_services_entry_t global_udp_services_table[] = {
     { 113, "auth",              "Authentication Service" },
     { 270, "gist",              "Q-mode encapsulation for GIST messages" },
     { 456, "macon-udp",         "" },
@@ -6209,7 +6209,7 @@ static ws_services_entry_t global_udp_services_table[] = {
     { 49001, "nusdp-disc",      "Nuance Unity Service Discovery Protocol" },
 };
 
-static ws_services_entry_t global_sctp_services_table[] = {
+static const ws_services_entry_t global_sctp_services_table[] = {
     { 9, "discard",             "Discard" },
     { 20, "ftp-data",           "File Transfer [Default Data]" },
     { 21, "ftp",                "File Transfer Protocol [Control]" },
@@ -6299,7 +6299,7 @@ static ws_services_entry_t global_sctp_services_table[] = {
     { 38472, "f1-control",      "F1 Control Plane (3GPP)" },
 };
 
-static ws_services_entry_t global_dccp_services_table[] = {
+static const ws_services_entry_t global_dccp_services_table[] = {
     { 9, "discard",             "Discard" },
     { 1021, "exp1",             "RFC3692-style Experiment 1" },
     { 1022, "exp2",             "RFC3692-style Experiment 2" },
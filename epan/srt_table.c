@@ -17,6 +17,8 @@
 #include "srt_table.h"
 #include <wsutil/ws_assert.h>
 
+#define NANOSECS_PER_SEC G_GUINT64_CONSTANT(1000000000)
+
 struct register_srt {
     int proto_id;              /* protocol id (0-indexed) */
     const char* tap_listen_str;      /* string used in register_tap_listener (NULL to use protocol name) */
@@ -68,6 +70,8 @@ free_srt_table_data(srt_stat_table *rst)
     for(i=0;i<rst->num_procs;i++){
         g_free(rst->procedures[i].procedure);
         rst->procedures[i].procedure=NULL;
+        ws_quantiles_free(rst->procedures[i].quantiles);
+        rst->procedures[i].quantiles=NULL;
     }
     g_free(rst->filter_string);
     rst->filter_string=NULL;
@@ -103,6 +107,9 @@ static void reset_srt_table_data(srt_stat_table *rst)
 
     for(i=0;i<rst->num_procs;i++){
         time_stat_init(&rst->procedures[i].stats);
+        if (rst->procedures[i].quantiles) {
+            ws_quantiles_reset(rst->procedures[i].quantiles);
+        }
     }
 }
 
@@ -216,6 +223,7 @@ init_srt_table(const char *name, const char *short_name, GArray *srt_array, int
         time_stat_init(&table->procedures[i].stats);
         table->procedures[i].proc_index = 0;
         table->procedures[i].procedure = NULL;
+        table->procedures[i].quantiles = NULL;
     }
 
     g_array_insert_val(srt_array, srt_array->len, table);
@@ -239,6 +247,7 @@ init_srt_table_row(srt_stat_table *rst, int indx, const char *procedure)
             time_stat_init(&rst->procedures[i].stats);
             rst->procedures[i].proc_index = i;
             rst->procedures[i].procedure=NULL;
+            rst->procedures[i].quantiles=NULL;
         }
     }
     rst->procedures[indx].proc_index = indx;
@@ -259,6 +268,25 @@ add_srt_table_data(srt_stat_table *rst, int indx, const nstime_t *req_time, pack
     nstime_delta(&delta, &t, req_time);
 
     time_stat_update(&rp->stats, &delta, pinfo);
+
+    /* Tail latencies, in a fixed size histogram per row */
+    if (rp->quantiles == NULL) {
+        rp->quantiles = ws_quantiles_new();
+    }
+    if (delta.secs >= 0 && delta.nsecs >= 0) {
+        ws_quantiles_add(rp->quantiles, (guint64)delta.secs * NANOSECS_PER_SEC + (guint64)delta.nsecs);
+    } else {
+        ws_quantiles_add(rp->quantiles, 0);
+    }
+}
+
+void
+get_srt_procedure_quantile(const srt_procedure_t *procedure, double q, nstime_t *result)
+{
+    guint64 ns = procedure->quantiles ? ws_quantiles_get(procedure->quantiles, q) : 0;
+
+    result->secs = (time_t)(ns / NANOSECS_PER_SEC);
+    result->nsecs = (int)(ns % NANOSECS_PER_SEC);
 }
 
 /*
@@ -13,6 +13,7 @@
 
 #include "tap.h"
 #include "timestats.h"
+#include <wsutil/sketch.h>
 #include <epan/wmem_scopes.h>
 
 #ifdef __cplusplus
@@ -24,6 +25,7 @@ typedef struct _srt_procedure_t {
 	int  proc_index;
 	timestat_t stats;   /**< stats */
 	char *procedure;   /**< column entries */
+	ws_quantiles_t *quantiles; /**< response time distribution in ns, allocated on the first response */
 } srt_procedure_t;
 
 /** Statistics table */
@@ -198,6 +200,14 @@ WS_DLL_PUBLIC void init_srt_table_row(srt_stat_table *rst, int proc_index, const
  */
 WS_DLL_PUBLIC void add_srt_table_data(srt_stat_table *rst, int proc_index, const nstime_t *req_time, packet_info *pinfo);
 
+/** Estimate a response time quantile for a table row.
+ *
+ * @param procedure the table row
+ * @param q the quantile, e.g. 0.99 for the 99th percentile
+ * @param result set to the estimated response time, or zero if there were no responses
+ */
+WS_DLL_PUBLIC void get_srt_procedure_quantile(const srt_procedure_t *procedure, double q, nstime_t *result);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -113,6 +113,11 @@ free_stat_node(stat_node *node)
         node->bh = bucket->next;
         g_free(bucket);
     }
+    while (node->bfree) {
+        bucket = node->bfree;
+        node->bfree = bucket->next;
+        g_free(bucket);
+    }
 
     g_free(node->rng);
     g_free(node->name);
@@ -177,6 +182,11 @@ reset_stat_node(stat_node *node)
         node->bh = bucket->next;
         g_free(bucket);
     }
+    while (node->bfree) {
+        bucket = node->bfree;
+        node->bfree = bucket->next;
+        g_free(bucket);
+    }
     node->bh = g_new0(burst_bucket, 1);
     node->bt = node->bh;
     node->bcount = 0;
@@ -216,6 +226,7 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
     st->root.counter = 0;
     switch (st->root.datatype)
     {
@@ -509,17 +520,13 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
 
     if (node->parent->children) {
         /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
+        last_chld = node->parent->last_child;
         last_chld->next = node;
-
     } else {
         /* insert as first child */
         node->parent->children = node;
     }
+    node->parent->last_child = node;
 
     if(node->parent->hash) {
         g_hash_table_replace(node->parent->hash,node->name,node);
@@ -554,6 +561,22 @@ stats_tree_create_node_by_pname(stats_tree *st, const gchar *name,
     return stats_tree_create_node(st,name,stats_tree_parent_id_by_name(st,parent_name),datatype,with_children);
 }
 
+/* Internal function to get a zeroed burst bucket, reusing one that has
+   left the burst window if there is one */
+static burst_bucket *
+new_burst_bucket(stat_node *node)
+{
+    burst_bucket *bn = node->bfree;
+
+    if (bn) {
+        node->bfree = bn->next;
+        memset(bn, 0, sizeof(*bn));
+    } else {
+        bn = g_new0(burst_bucket, 1);
+    }
+    return bn;
+}
+
 /* Internal function to update the burst calculation data - add entry to bucket */
 static void
 update_burst_calc(stat_node *node, gint value)
@@ -573,7 +596,7 @@ update_burst_calc(stat_node *node, gint value)
     burstwin = prefs.st_burst_windowlen/prefs.st_burst_resolution;
     if (current_bucket>node->bt->bucket_no) {
         /* Must add a new bucket at the burst list tail */
-        bn = g_new0(burst_bucket, 1);
+        bn = new_burst_bucket(node);
         bn->count = value;
         bn->bucket_no = current_bucket;
         bn->start_time = node->st->now;
@@ -589,14 +612,15 @@ update_burst_calc(stat_node *node, gint value)
             node->bh = bn->next;
             node->bh->prev = NULL;
             node->bcount -= bn->count;
-            g_free(bn);
+            bn->next = node->bfree;
+            node->bfree = bn;
         }
     }
     else if (current_bucket<node->bh->bucket_no) {
         /* Packet must be added at head of burst list - check if not too old */
         if ((current_bucket+burstwin)>node->bt->bucket_no) {
             /* packet still within the window */
-            bn = g_new0(burst_bucket, 1);
+            bn = new_burst_bucket(node);
             bn->count = value;
             bn->bucket_no = current_bucket;
             bn->start_time = node->st->now;
@@ -623,7 +647,7 @@ update_burst_calc(stat_node *node, gint value)
         }
         else {
             /* must add a new bucket after bn. */
-            bn = g_new0(burst_bucket, 1);
+            bn = new_burst_bucket(node);
             bn->count = value;
             bn->bucket_no = current_bucket;
             bn->start_time = node->st->now;
@@ -78,6 +78,8 @@ struct _stat_node {
 	/** fields for burst rate calculation */
 	gint			bcount;
 	burst_bucket	*bh, *bt;
+	/** buckets that left the window, reused for new ones */
+	burst_bucket	*bfree;
 	gint			max_burst;
 	double			burst_time;
 
@@ -90,6 +92,7 @@ struct _stat_node {
 	/** relatives */
 	stat_node		*parent;
 	stat_node		*children;
+	stat_node		*last_child;
 	stat_node		*next;
 
 	/** used to check if value is within range */
@@ -80,21 +80,54 @@ static guint tap_packet_index;
 
 typedef struct _tap_listener_t {
 	struct _tap_listener_t *next;
+	struct _tap_listener_t *next_same_tap;	/* next listener for tap_id */
 	int tap_id;
 	gboolean needs_redraw;
 	gboolean failed;
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	guint filter_push;	/* tap_push_count when filter_passed was set */
+	gboolean filter_passed;
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
 	tap_draw_cb draw;
 	tap_finish_cb finish;
+	tap_partial_new_cb partial_new;
+	tap_merge_cb merge;
 } tap_listener_t;
 
 static tap_listener_t *tap_listener_queue=NULL;
 
+/*
+ * The listeners of each tap, indexed by tap_id, in the same order as in
+ * tap_listener_queue, so that pushing a queued packet only looks at the
+ * listeners that want it.
+ */
+static GPtrArray *tap_listeners_by_id=NULL;
+
+/*
+ * The tests shared by the filters of the listeners are only run once
+ * per packet, and each filter only once however many times the packet
+ * was queued.
+ */
+static dfilter_set_t *tap_filter_set=NULL;
+static guint tap_push_count;
+
+/* Time spent pushing packets to the listeners, if tap_set_timing() turned timing on. */
+static gboolean tap_timing=FALSE;
+static gint64 tap_elapsed_time;
+
+static tap_listener_t *
+first_listener_for_tap(int tap_id)
+{
+	if(!tap_listeners_by_id || (guint)tap_id>=tap_listeners_by_id->len){
+		return NULL;
+	}
+	return (tap_listener_t *)g_ptr_array_index(tap_listeners_by_id, tap_id);
+}
+
 static GSList *tap_plugins = NULL;
 
 #ifdef HAVE_PLUGINS
@@ -306,6 +339,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 	tap_packet_t *tp;
 	tap_listener_t *tl;
 	guint i;
+	gint64 start=0;
 
 	/* nothing to do, just return */
 	if(!tapping_is_active){
@@ -319,69 +353,99 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
-	/* loop over all tap listeners and call the listener callback
-	   for all packets that match the filter. */
+	if(tap_timing)
+		start=g_get_monotonic_time();
+
+	if(!tap_filter_set){
+		tap_filter_set=dfilter_set_new();
+	}
+	dfilter_set_reset(tap_filter_set);
+	/* Never 0, so that a new listener's filter_push doesn't match. */
+	if(++tap_push_count==0)
+		tap_push_count=1;
+
+	/* loop over all tapped packets and call the callback of each
+	   listener of their tap for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
-		for(tl=tap_listener_queue;tl;tl=tl->next){
-			tp=&tap_packet_array[i];
+		tp=&tap_packet_array[i];
+		for(tl=first_listener_for_tap(tp->tap_id);tl;tl=tl->next_same_tap){
 			/* Don't tap the packet if it's an "error packet"
 			 * unless the listener has requested that we do so.
 			 */
-			if (!(tp->flags & TAP_PACKET_IS_ERROR_PACKET) || (tl->flags & TL_REQUIRES_ERROR_PACKETS))
-			{
-				if(tp->tap_id==tl->tap_id){
-					if(!tl->packet){
-						/* There isn't a per-packet
-						 * routine for this tap.
-						 */
-						continue;
-					}
-					if(tl->failed){
-						/* A previous call failed,
-						 * meaning "stop running this
-						 * tap", so don't call the
-						 * packet routine.
-						 */
+			if ((tp->flags & TAP_PACKET_IS_ERROR_PACKET) && !(tl->flags & TL_REQUIRES_ERROR_PACKETS))
+				continue;
+
+			if(!tl->packet){
+				/* There isn't a per-packet
+				 * routine for this tap.
+				 */
+				continue;
+			}
+			if(tl->failed){
+				/* A previous call failed,
+				 * meaning "stop running this
+				 * tap", so don't call the
+				 * packet routine.
+				 */
+				continue;
+			}
+
+			/* If we have a filter, see if the
+			 * packet passes; the answer is the same
+			 * for every entry of this packet.
+			 */
+			guint flags = tl->flags;
+			if(tl->code){
+				if (tl->filter_push != tap_push_count) {
+					tl->filter_passed = dfilter_set_apply_edt(tap_filter_set, tl->code, edt);
+					tl->filter_push = tap_push_count;
+				}
+				if (!tl->filter_passed){
+					/* The packet didn't
+					 * pass the filter. */
+					if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
+						flags |= TL_DISPLAY_FILTER_IGNORED;
+					else
 						continue;
-					}
-
-					/* If we have a filter, see if the
-					 * packet passes.
-					 */
-					guint flags = tl->flags;
-					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
-							/* The packet didn't
-							 * pass the filter. */
-							if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
-								flags |= TL_DISPLAY_FILTER_IGNORED;
-							else
-								continue;
-						}
-					}
-
-					/* So call the per-packet routine. */
-					tap_packet_status status;
-
-					status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
-
-					switch (status) {
-
-					case TAP_PACKET_DONT_REDRAW:
-						break;
-
-					case TAP_PACKET_REDRAW:
-						tl->needs_redraw=TRUE;
-						break;
-
-					case TAP_PACKET_FAILED:
-						tl->failed=TRUE;
-						break;
-					}
 				}
 			}
+
+			/* So call the per-packet routine. */
+			tap_packet_status status;
+
+			status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
+
+			switch (status) {
+
+			case TAP_PACKET_DONT_REDRAW:
+				break;
+
+			case TAP_PACKET_REDRAW:
+				tl->needs_redraw=TRUE;
+				break;
+
+			case TAP_PACKET_FAILED:
+				tl->failed=TRUE;
+				break;
+			}
 		}
 	}
+
+	if(tap_timing)
+		tap_elapsed_time+=g_get_monotonic_time()-start;
+}
+
+void
+tap_set_timing(gboolean enable)
+{
+	tap_timing=enable;
+	tap_elapsed_time=0;
+}
+
+gint64
+tap_get_elapsed_time(void)
+{
+	return tap_elapsed_time;
 }
 
 
@@ -526,6 +590,45 @@ free_tap_listener(tap_listener_t *tl)
 	g_free(tl);
 }
 
+static void
+link_tap_listener(tap_listener_t *tl)
+{
+	if(!tap_listeners_by_id){
+		tap_listeners_by_id=g_ptr_array_new();
+	}
+	if((guint)tl->tap_id>=tap_listeners_by_id->len){
+		g_ptr_array_set_size(tap_listeners_by_id, tl->tap_id+1);
+	}
+	tl->next_same_tap=first_listener_for_tap(tl->tap_id);
+	g_ptr_array_index(tap_listeners_by_id, tl->tap_id)=tl;
+
+	tl->next=tap_listener_queue;
+	tap_listener_queue=tl;
+}
+
+static void
+unlink_tap_listener_for_tap(tap_listener_t *tl)
+{
+	tap_listener_t **tlp;
+
+	tlp=(tap_listener_t **)&g_ptr_array_index(tap_listeners_by_id, tl->tap_id);
+	for(;*tlp;tlp=&(*tlp)->next_same_tap){
+		if(*tlp==tl){
+			*tlp=tl->next_same_tap;
+			break;
+		}
+	}
+}
+
+/* The filters have changed; start again with an empty set of shared
+ * tests rather than keep the tests of filters that are gone. */
+static void
+tap_filters_changed(void)
+{
+	dfilter_set_free(tap_filter_set);
+	tap_filter_set=NULL;
+}
+
 /* this function attaches the tap_listener to the named tap.
  * function returns :
  *     NULL: ok.
@@ -574,9 +677,10 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->packet=packet;
 	tl->draw=draw;
 	tl->finish=finish;
-	tl->next=tap_listener_queue;
-
-	tap_listener_queue=tl;
+	link_tap_listener(tl);
+	if(tl->code){
+		tap_filters_changed();
+	}
 
 	return NULL;
 }
@@ -612,6 +716,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 			dfilter_free(tl->code);
 			tl->code=NULL;
 		}
+		tap_filters_changed();
 		tl->needs_redraw=TRUE;
 		g_free(tl->fstring);
 		if(fstring){
@@ -640,6 +745,7 @@ tap_listeners_dfilter_recompile(void)
 	tap_listener_t *tl;
 	dfilter_t *code;
 
+	tap_filters_changed();
 	for(tl=tap_listener_queue;tl;tl=tl->next){
 		if(tl->code){
 			dfilter_free(tl->code);
@@ -685,6 +791,10 @@ remove_tap_listener(void *tapdata)
 			return;
 		}
 	}
+	unlink_tap_listener_for_tap(tl);
+	if(tl->code){
+		tap_filters_changed();
+	}
 	free_tap_listener(tl);
 }
 
@@ -735,18 +845,52 @@ tap_listeners_require_columns(void)
 gboolean
 have_tap_listener(int tap_id)
 {
-	tap_listener_t *tap_queue = tap_listener_queue;
+	return first_listener_for_tap(tap_id) != NULL;
+}
 
-	while(tap_queue) {
-		if(tap_queue->tap_id == tap_id)
-			return TRUE;
+guint
+tap_listeners_count(void)
+{
+	tap_listener_t *tap_queue;
+	guint count = 0;
 
-		tap_queue = tap_queue->next;
-	}
+	for (tap_queue = tap_listener_queue; tap_queue; tap_queue = tap_queue->next)
+		count++;
+
+	return count;
+}
+
+gboolean
+set_tap_listener_mergeable(void *tapdata, tap_partial_new_cb partial_new,
+    tap_merge_cb merge)
+{
+	tap_listener_t *tl;
 
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			tl->partial_new=partial_new;
+			tl->merge=merge;
+			return TRUE;
+		}
+	}
 	return FALSE;
 }
 
+gboolean
+tap_listeners_mergeable(void)
+{
+	tap_listener_t *tl;
+
+	if(!tap_listener_queue){
+		return FALSE;
+	}
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(!tl->partial_new || !tl->merge)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 /*
  * Return TRUE if we have any tap listeners with filters, FALSE otherwise.
  */
@@ -803,6 +947,11 @@ void tap_cleanup(void)
 		free_tap_listener(elem_lq);
 	}
 	tap_listener_queue = NULL;
+	if (tap_listeners_by_id) {
+		g_ptr_array_free(tap_listeners_by_id, TRUE);
+		tap_listeners_by_id = NULL;
+	}
+	tap_filters_changed();
 
 	while(head_dl){
 		elem_dl = head_dl;
@@ -34,6 +34,8 @@ typedef void (*tap_reset_cb)(void *tapdata);
 typedef tap_packet_status (*tap_packet_cb)(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags);
 typedef void (*tap_draw_cb)(void *tapdata);
 typedef void (*tap_finish_cb)(void *tapdata);
+typedef void *(*tap_partial_new_cb)(void *tapdata);
+typedef void (*tap_merge_cb)(void *tapdata, void *partial);
 
 /**
  * Flags to indicate what a tap listener's packet routine requires.
@@ -260,6 +262,29 @@ WS_DLL_PUBLIC gboolean have_tap_listener(int tap_id);
 /** Return TRUE if we have any tap listeners with filters, FALSE otherwise. */
 WS_DLL_PUBLIC gboolean have_filtering_tap_listeners(void);
 
+/** Returns the number of registered tap listeners. */
+WS_DLL_PUBLIC guint tap_listeners_count(void);
+
+/**
+ * Declare that the results of a tap listener don't depend on the order in
+ * which it sees the packets, so that they could be computed separately for
+ * parts of the frames and combined afterwards.
+ *
+ * @param tapdata     the instance identifier passed to register_tap_listener()
+ * @param partial_new returns new, empty state for the same listener, to be
+ *                    passed as tapdata to its packet callback
+ * @param merge       adds the results in partial to tapdata, and frees partial
+ * @return TRUE if there is a listener with that tapdata
+ */
+WS_DLL_PUBLIC gboolean set_tap_listener_mergeable(void *tapdata,
+    tap_partial_new_cb partial_new, tap_merge_cb merge);
+
+/**
+ * Return TRUE if there are tap listeners and all of them have declared
+ * themselves mergeable with set_tap_listener_mergeable(), FALSE otherwise.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_mergeable(void);
+
 /** If any tap listeners have a filter with references to the currently
  * selected frame in the GUI (edt->tree), update them.
  */
@@ -272,6 +297,16 @@ WS_DLL_PUBLIC void tap_listeners_load_field_references(epan_dissect_t *edt);
  */
 WS_DLL_PUBLIC guint union_of_tap_listener_flags(void);
 
+/** Turn on or off adding up the time spent calling the listeners' packet
+ * routines and filters, and start again from zero.
+ */
+WS_DLL_PUBLIC void tap_set_timing(gboolean enable);
+
+/** Get the time, in microseconds, spent calling the listeners since
+ * tap_set_timing() turned timing on.
+ */
+WS_DLL_PUBLIC gint64 tap_get_elapsed_time(void);
+
 /** This function can be used by a dissector to fetch any tapped data before
  * returning.
  * This can be useful if one wants to extract the data inside dissector  BEFORE
@@ -109,17 +109,15 @@ get_fmt_broken_down_time(field_display_e fmt, const time_t *secs)
     ws_assert_not_reached();
 }
 
-static char *
-snprint_abs_time_secs(wmem_allocator_t *scope,
+static void
+snprint_abs_time_secs(char *buf, size_t buf_size,
                         field_display_e fmt, struct tm *tmp,
                         const char *nsecs_str, const char *tzone_sep,
                         const char *tzone_str, gboolean add_quotes)
 {
-    char *buf;
-
     switch (fmt) {
         case ABSOLUTE_TIME_DOY_UTC:
-            buf = wmem_strdup_printf(scope,
+            snprintf(buf, buf_size,
                     "%s%04d/%03d:%02d:%02d:%02d%s%s%s%s",
                     add_quotes ? "\"" : "",
                     tmp->tm_year + 1900,
@@ -135,7 +133,7 @@ snprint_abs_time_secs(wmem_allocator_t *scope,
         case ABSOLUTE_TIME_NTP_UTC:	/* FALLTHROUGH */
         case ABSOLUTE_TIME_UTC:		/* FALLTHROUGH */
         case ABSOLUTE_TIME_LOCAL:
-            buf = wmem_strdup_printf(scope,
+            snprintf(buf, buf_size,
                     "%s%s %2d, %d %02d:%02d:%02d%s%s%s%s",
                     add_quotes ? "\"" : "",
                     mon_names[tmp->tm_mon],
@@ -152,34 +150,39 @@ snprint_abs_time_secs(wmem_allocator_t *scope,
         default:
             ws_assert_not_reached();
     }
-    return buf;
 }
 
-char *
-abs_time_to_str_ex(wmem_allocator_t *scope, const nstime_t *abs_time, field_display_e fmt,
-                    int flags)
+void
+abs_time_to_str_ex_buf(char *buf, size_t buf_size, const nstime_t *abs_time,
+                        field_display_e fmt, int flags)
 {
     struct tm *tmp;
     char buf_nsecs[32];
     const char *tzone_sep, *tzone_str;
 
+    if (buf_size == 0)
+        return;
+
     if (fmt == BASE_NONE)
         fmt = ABSOLUTE_TIME_LOCAL;
 
     ws_assert(FIELD_DISPLAY_IS_ABSOLUTE_TIME(fmt));
 
     if (fmt == ABSOLUTE_TIME_UNIX) {
-        return abs_time_to_unix_str(scope, abs_time);
+        display_epoch_time(buf, buf_size, abs_time, WS_TSPREC_NSEC);
+        return;
     }
 
     if (fmt == ABSOLUTE_TIME_NTP_UTC && abs_time->secs == 0 &&
                 (abs_time->nsecs == 0 || abs_time->nsecs == G_MAXINT)) {
-        return wmem_strdup(scope, "NULL");
+        (void) g_strlcpy(buf, "NULL", buf_size);
+        return;
     }
 
     tmp = get_fmt_broken_down_time(fmt, &abs_time->secs);
     if (tmp == NULL) {
-        return wmem_strdup(scope, "Not representable");
+        (void) g_strlcpy(buf, "Not representable", buf_size);
+        return;
     }
 
     *buf_nsecs = '\0';
@@ -210,7 +213,17 @@ abs_time_to_str_ex(wmem_allocator_t *scope, const nstime_t *abs_time, field_disp
         }
     }
 
-    return snprint_abs_time_secs(scope, fmt, tmp, buf_nsecs, tzone_sep, tzone_str, flags & ABS_TIME_TO_STR_ADD_DQUOTES);
+    snprint_abs_time_secs(buf, buf_size, fmt, tmp, buf_nsecs, tzone_sep, tzone_str, flags & ABS_TIME_TO_STR_ADD_DQUOTES);
+}
+
+char *
+abs_time_to_str_ex(wmem_allocator_t *scope, const nstime_t *abs_time, field_display_e fmt,
+                    int flags)
+{
+    char buf[ABS_TIME_STR_MAX_LEN];
+
+    abs_time_to_str_ex_buf(buf, sizeof(buf), abs_time, fmt, flags);
+    return wmem_strdup(scope, buf);
 }
 
 char *
@@ -235,6 +248,49 @@ abs_time_secs_to_str_ex(wmem_allocator_t *scope, const time_t abs_time_secs, fie
  */
 #define TIME_SECS_LEN	(10+1+4+2+2+5+2+2+7+2+2+7+4)
 
+/*
+ * A caller's buffer being filled in by the routines below; "len" is
+ * the length of the string so far, which never reaches "size".
+ */
+typedef struct {
+    char   *buf;
+    size_t  size;
+    size_t  len;
+} time_str_buf_t;
+
+static void
+time_str_buf_append_printf(time_str_buf_t *tsb, const char *fmt, ...)
+    G_GNUC_PRINTF(2, 3);
+
+static void
+time_str_buf_append_printf(time_str_buf_t *tsb, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    if (tsb->len + 1 >= tsb->size)
+        return;
+
+    va_start(ap, fmt);
+    len = vsnprintf(tsb->buf + tsb->len, tsb->size - tsb->len, fmt, ap);
+    va_end(ap);
+
+    if (len < 0)
+        return;
+    tsb->len += (size_t)len;
+    if (tsb->len >= tsb->size)
+        tsb->len = tsb->size - 1;
+}
+
+static void
+time_str_buf_init(time_str_buf_t *tsb, char *buf, size_t size)
+{
+    tsb->buf = buf;
+    tsb->size = size;
+    tsb->len = 0;
+    buf[0] = '\0';
+}
+
 /*
  * Convert an unsigned value in seconds and fractions of a second to a string,
  * giving time in days, hours, minutes, and seconds, and put the result
@@ -244,7 +300,7 @@ abs_time_secs_to_str_ex(wmem_allocator_t *scope, const time_t abs_time_secs, fie
  */
 static void
 unsigned_time_secs_to_str_buf(guint32 time_val, const guint32 frac,
-                                const gboolean is_nsecs, wmem_strbuf_t *buf)
+                                const gboolean is_nsecs, time_str_buf_t *buf)
 {
     int hours, mins, secs;
     gboolean do_comma = FALSE;
@@ -257,42 +313,42 @@ unsigned_time_secs_to_str_buf(guint32 time_val, const guint32 frac,
     time_val /= 24;
 
     if (time_val != 0) {
-        wmem_strbuf_append_printf(buf, "%u day%s", time_val, PLURALIZE(time_val));
+        time_str_buf_append_printf(buf, "%u day%s", time_val, PLURALIZE(time_val));
         do_comma = TRUE;
     }
     if (hours != 0) {
-        wmem_strbuf_append_printf(buf, "%s%u hour%s", COMMA(do_comma), hours, PLURALIZE(hours));
+        time_str_buf_append_printf(buf, "%s%u hour%s", COMMA(do_comma), hours, PLURALIZE(hours));
         do_comma = TRUE;
     }
     if (mins != 0) {
-        wmem_strbuf_append_printf(buf, "%s%u minute%s", COMMA(do_comma), mins, PLURALIZE(mins));
+        time_str_buf_append_printf(buf, "%s%u minute%s", COMMA(do_comma), mins, PLURALIZE(mins));
         do_comma = TRUE;
     }
     if (secs != 0 || frac != 0) {
         if (frac != 0) {
             if (is_nsecs)
-                wmem_strbuf_append_printf(buf, "%s%u.%09u seconds", COMMA(do_comma), secs, frac);
+                time_str_buf_append_printf(buf, "%s%u.%09u seconds", COMMA(do_comma), secs, frac);
             else
-                wmem_strbuf_append_printf(buf, "%s%u.%03u seconds", COMMA(do_comma), secs, frac);
+                time_str_buf_append_printf(buf, "%s%u.%03u seconds", COMMA(do_comma), secs, frac);
         } else
-            wmem_strbuf_append_printf(buf, "%s%u second%s", COMMA(do_comma), secs, PLURALIZE(secs));
+            time_str_buf_append_printf(buf, "%s%u second%s", COMMA(do_comma), secs, PLURALIZE(secs));
     }
 }
 
 gchar *
 unsigned_time_secs_to_str(wmem_allocator_t *scope, const guint32 time_val)
 {
-    wmem_strbuf_t *buf;
+    char buf[TIME_SECS_LEN+1];
+    time_str_buf_t tsb;
 
     if (time_val == 0) {
         return wmem_strdup(scope, "0 seconds");
     }
 
-    buf = wmem_strbuf_new_sized(scope, TIME_SECS_LEN+1);
+    time_str_buf_init(&tsb, buf, sizeof(buf));
+    unsigned_time_secs_to_str_buf(time_val, 0, FALSE, &tsb);
 
-    unsigned_time_secs_to_str_buf(time_val, 0, FALSE, buf);
-
-    return wmem_strbuf_finalize(buf);
+    return wmem_strdup(scope, buf);
 }
 
 /*
@@ -304,10 +360,10 @@ unsigned_time_secs_to_str(wmem_allocator_t *scope, const guint32 time_val)
  */
 static void
 signed_time_secs_to_str_buf(gint32 time_val, const guint32 frac,
-    const gboolean is_nsecs, wmem_strbuf_t *buf)
+    const gboolean is_nsecs, time_str_buf_t *buf)
 {
     if(time_val < 0){
-        wmem_strbuf_append_printf(buf, "-");
+        time_str_buf_append_printf(buf, "-");
         if(time_val == G_MININT32) {
             /*
              * You can't fit time_val's absolute value into
@@ -336,17 +392,17 @@ signed_time_secs_to_str_buf(gint32 time_val, const guint32 frac,
 gchar *
 signed_time_secs_to_str(wmem_allocator_t *scope, const gint32 time_val)
 {
-    wmem_strbuf_t *buf;
+    char buf[TIME_SECS_LEN+1];
+    time_str_buf_t tsb;
 
     if (time_val == 0) {
         return wmem_strdup(scope, "0 seconds");
     }
 
-    buf = wmem_strbuf_new_sized(scope, TIME_SECS_LEN+1);
-
-    signed_time_secs_to_str_buf(time_val, 0, FALSE, buf);
+    time_str_buf_init(&tsb, buf, sizeof(buf));
+    signed_time_secs_to_str_buf(time_val, 0, FALSE, &tsb);
 
-    return wmem_strbuf_finalize(buf);
+    return wmem_strdup(scope, buf);
 }
 
 /*
@@ -356,15 +412,14 @@ signed_time_secs_to_str(wmem_allocator_t *scope, const gint32 time_val)
 gchar *
 signed_time_msecs_to_str(wmem_allocator_t *scope, gint32 time_val)
 {
-    wmem_strbuf_t *buf;
+    char buf[TIME_SECS_LEN+1+3+1];
+    time_str_buf_t tsb;
     int msecs;
 
     if (time_val == 0) {
         return wmem_strdup(scope, "0 seconds");
     }
 
-    buf = wmem_strbuf_new_sized(scope, TIME_SECS_LEN+1+3+1);
-
     if (time_val<0) {
         /* oops we got passed a negative time */
         time_val= -time_val;
@@ -376,21 +431,25 @@ signed_time_msecs_to_str(wmem_allocator_t *scope, gint32 time_val)
         time_val /= 1000;
     }
 
-    signed_time_secs_to_str_buf(time_val, msecs, FALSE, buf);
+    time_str_buf_init(&tsb, buf, sizeof(buf));
+    signed_time_secs_to_str_buf(time_val, msecs, FALSE, &tsb);
 
-    return wmem_strbuf_finalize(buf);
+    return wmem_strdup(scope, buf);
 }
 
 /*
  * Display a relative time as days/hours/minutes/seconds.
  */
-gchar *
-rel_time_to_str(wmem_allocator_t *scope, const nstime_t *rel_time)
+void
+rel_time_to_str_buf(char *buf, size_t buf_size, const nstime_t *rel_time)
 {
-    wmem_strbuf_t *buf;
+    time_str_buf_t tsb;
     gint32 time_val;
     gint32 nsec;
 
+    if (buf_size == 0)
+        return;
+
     /* If the nanoseconds part of the time stamp is negative,
        print its absolute value and, if the seconds part isn't
        (the seconds part should be zero in that case), stick
@@ -398,14 +457,15 @@ rel_time_to_str(wmem_allocator_t *scope, const nstime_t *rel_time)
     time_val = (gint) rel_time->secs;
     nsec = rel_time->nsecs;
     if (time_val == 0 && nsec == 0) {
-        return wmem_strdup(scope, "0.000000000 seconds");
+        (void) g_strlcpy(buf, "0.000000000 seconds", buf_size);
+        return;
     }
 
-    buf = wmem_strbuf_new_sized(scope, 1+TIME_SECS_LEN+1+6+1);
+    time_str_buf_init(&tsb, buf, buf_size);
 
     if (nsec < 0) {
         nsec = -nsec;
-        wmem_strbuf_append_c(buf, '-');
+        time_str_buf_append_printf(&tsb, "-");
 
         /*
          * We assume here that "rel_time->secs" is negative
@@ -415,9 +475,16 @@ rel_time_to_str(wmem_allocator_t *scope, const nstime_t *rel_time)
         time_val = (gint) -rel_time->secs;
     }
 
-    signed_time_secs_to_str_buf(time_val, nsec, TRUE, buf);
+    signed_time_secs_to_str_buf(time_val, nsec, TRUE, &tsb);
+}
+
+gchar *
+rel_time_to_str(wmem_allocator_t *scope, const nstime_t *rel_time)
+{
+    char buf[REL_TIME_STR_MAX_LEN];
 
-    return wmem_strbuf_finalize(buf);
+    rel_time_to_str_buf(buf, sizeof(buf), rel_time);
+    return wmem_strdup(scope, buf);
 }
 
 /*
@@ -432,6 +499,8 @@ rel_time_to_str(wmem_allocator_t *scope, const nstime_t *rel_time)
 /* Includes terminating '\0' */
 #define NSTIME_SECS_LEN	(CHARS_64_BIT_SIGNED+CHARS_NANOSECONDS+1)
 
+G_STATIC_ASSERT(NSTIME_SECS_LEN <= NSTIME_SECS_STR_LEN);
+
 /*
  * Display a relative time as seconds.
  */
@@ -72,6 +72,12 @@ WS_DLL_PUBLIC const gchar *address_to_name(const address *addr);
  */
 WS_DLL_PUBLIC gchar *address_to_display(wmem_allocator_t *allocator, const address *addr);
 
+/*
+ * Like address_to_display, but writes the string, truncated if need be,
+ * into a caller-supplied buffer of buf_len bytes instead of allocating it.
+ */
+WS_DLL_PUBLIC void address_to_display_buf(const address *addr, gchar *buf, int buf_len);
+
 WS_DLL_PUBLIC void address_to_str_buf(const address *addr, gchar *buf, int buf_len);
 
 WS_DLL_PUBLIC const gchar *port_type_to_str (port_type type);
@@ -125,10 +131,29 @@ WS_DLL_PUBLIC gchar* tvb_address_var_to_str(wmem_allocator_t *scope, tvbuff_t *t
 #define ABS_TIME_TO_STR_ADD_DQUOTES     (1U << 1)
 #define ABS_TIME_TO_STR_SHOW_UTC_ONLY   (1U << 2)
 
+/** Size of a buffer big enough for any absolute time string, including
+ *  the terminating '\0' */
+#define ABS_TIME_STR_MAX_LEN    128
+
+/** Size of a buffer big enough for any relative time string from
+ *  rel_time_to_str_buf(), including the terminating '\0' */
+#define REL_TIME_STR_MAX_LEN    80
+
+/** Size of a buffer big enough for a time in seconds with nanosecond
+ *  precision, as written by display_signed_time() and display_epoch_time(),
+ *  including the terminating '\0' */
+#define NSTIME_SECS_STR_LEN     32
+
 WS_DLL_PUBLIC char *abs_time_to_str_ex(wmem_allocator_t *scope,
                                         const nstime_t *, field_display_e fmt,
                                         int flags);
 
+/** Like abs_time_to_str_ex(), but writes the string, truncated if need be,
+ *  into a caller-supplied buffer of buf_size bytes instead of allocating it. */
+WS_DLL_PUBLIC void abs_time_to_str_ex_buf(char *buf, size_t buf_size,
+                                        const nstime_t *, field_display_e fmt,
+                                        int flags);
+
 #define abs_time_to_str(scope, nst, fmt, show_zone) \
         abs_time_to_str_ex(scope, nst, fmt, (show_zone) ? ABS_TIME_TO_STR_SHOW_ZONE : 0)
 
@@ -150,6 +175,10 @@ WS_DLL_PUBLIC gchar *signed_time_msecs_to_str(wmem_allocator_t *scope, gint32 ti
 
 WS_DLL_PUBLIC gchar *rel_time_to_str(wmem_allocator_t *scope, const nstime_t *);
 
+/** Like rel_time_to_str(), but writes the string, truncated if need be,
+ *  into a caller-supplied buffer of buf_size bytes instead of allocating it. */
+WS_DLL_PUBLIC void rel_time_to_str_buf(char *buf, size_t buf_size, const nstime_t *);
+
 WS_DLL_PUBLIC gchar *rel_time_to_secs_str(wmem_allocator_t *scope, const nstime_t *);
 
 /*
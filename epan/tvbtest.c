@@ -405,10 +405,12 @@ run_tests(void)
 	guint		subset_length[6];
 	guint		subset_reported_length[6];
 	guint8		temp;
-	guint8		*comp[6];
-	tvbuff_t	*tvb_comp[6];
-	guint		comp_length[6];
-	guint		comp_reported_length[6];
+	guint8		*comp[7];
+	tvbuff_t	*tvb_comp[7];
+	guint		comp_length[7];
+	guint		comp_reported_length[7];
+	tvbuff_t	*tvb_member;
+	guint		member_length;
 	tvbuff_t	*tvb_comp_subset;
 	guint		comp_subset_length;
 	guint		comp_subset_reported_length;
@@ -580,6 +582,22 @@ run_tests(void)
 	tvb_composite_append(tvb_comp[5], tvb_comp[3]);
 	tvb_composite_finalize(tvb_comp[5]);
 
+	/* Many small subsets, so that reads span several members */
+	printf("Making Composite 6\n");
+	tvb_comp[6]		= tvb_new_composite();
+	comp_length[6]		= 0;
+	comp_reported_length[6]	= 0;
+	comp[6]			= (guint8*)g_malloc(40 * 5);
+	for (i = 0; i < 40; i++) {
+		member_length = 1 + i % 5;
+		tvb_member = tvb_new_subset_length_caplen(tvb_large[i % 3], i % 7, member_length, member_length + 1);
+		memcpy(&comp[6][comp_length[6]], &large[i % 3][i % 7], member_length);
+		comp_length[6] += member_length;
+		comp_reported_length[6] += member_length + 1;
+		tvb_composite_append(tvb_comp[6], tvb_member);
+	}
+	tvb_composite_finalize(tvb_comp[6]);
+
 	/* A subset of one of the composites. */
 	tvb_comp_subset = tvb_new_subset_remaining(tvb_comp[1], 1);
 	comp_subset = &comp[1][1];
@@ -593,6 +611,7 @@ run_tests(void)
 	test(tvb_comp[3], "Composite 3", comp[3], comp_length[3], comp_reported_length[3]);
 	test(tvb_comp[4], "Composite 4", comp[4], comp_length[4], comp_reported_length[4]);
 	test(tvb_comp[5], "Composite 5", comp[5], comp_length[5], comp_reported_length[5]);
+	test(tvb_comp[6], "Composite 6", comp[6], comp_length[6], comp_reported_length[6]);
 
 	/* Test the subset of the composite. */
 	test(tvb_comp_subset, "Subset of Composite", comp_subset, comp_subset_length, comp_subset_reported_length);
@@ -604,6 +623,7 @@ run_tests(void)
 	g_free(comp[3]);
 	g_free(comp[4]);
 	g_free(comp[5]);
+	g_free(comp[6]);
 
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
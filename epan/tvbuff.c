@@ -889,6 +889,24 @@ ensure_contiguous(tvbuff_t *tvb, const gint offset, const gint length)
 	return p;
 }
 
+/*
+ * The exceptions for fast_ensure_contiguous(), kept out of line so that
+ * each tvb_get_* accessor only carries the in-range test and the load.
+ */
+static WS_NORETURN void
+fast_ensure_contiguous_throw(const tvbuff_t *tvb, const guint end_offset)
+{
+	if (end_offset <= tvb->contained_length) {
+		THROW(BoundsError);
+	} else if (tvb->flags & TVBUFF_FRAGMENT) {
+		THROW(FragmentBoundsError);
+	} else if (end_offset <= tvb->reported_length) {
+		THROW(ContainedBoundsError);
+	} else {
+		THROW(ReportedBoundsError);
+	}
+}
+
 static inline const guint8*
 fast_ensure_contiguous(tvbuff_t *tvb, const gint offset, const guint length)
 {
@@ -908,17 +926,15 @@ fast_ensure_contiguous(tvbuff_t *tvb, const gint offset, const guint length)
 
 	if (G_LIKELY(end_offset <= tvb->length)) {
 		return tvb->real_data + u_offset;
-	} else if (end_offset <= tvb->contained_length) {
-		THROW(BoundsError);
-	} else if (tvb->flags & TVBUFF_FRAGMENT) {
-		THROW(FragmentBoundsError);
-	} else if (end_offset <= tvb->reported_length) {
-		THROW(ContainedBoundsError);
-	} else {
-		THROW(ReportedBoundsError);
 	}
-	/* not reached */
-	return NULL;
+	fast_ensure_contiguous_throw(tvb, end_offset);
+}
+
+void
+tvb_span_bad_access(const guint offset, const guint size, const guint length)
+{
+	REPORT_DISSECTOR_BUG("tvb_span access of %u bytes at offset %u is outside the span of %u bytes",
+	    size, offset, length);
 }
 
 
@@ -2431,7 +2447,7 @@ tvb_find_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const gu
 	if (tvb->ops->tvb_find_guint8)
 		return tvb->ops->tvb_find_guint8(tvb, abs_offset, limit, needle);
 
-	return tvb_find_guint8_generic(tvb, offset, limit, needle);
+	return tvb_find_guint8_generic(tvb, abs_offset, limit, needle);
 }
 
 /* Same as tvb_find_guint8() with 16bit needle. */
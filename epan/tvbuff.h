@@ -27,7 +27,9 @@
 
 #include <wsutil/inet_cidr.h>
 #include <wsutil/nstime.h>
+#include <wsutil/pint.h>
 #include "wsutil/ws_mempbrk.h"
+#include "ws_attributes.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -559,6 +561,98 @@ WS_DLL_PUBLIC void *tvb_memdup(wmem_allocator_t *scope, tvbuff_t *tvb,
 WS_DLL_PUBLIC const guint8 *tvb_get_ptr(tvbuff_t *tvb, const gint offset,
     const gint length);
 
+/** A span of bytes of a tvbuff that are known to be present, for fixed-size
+ * headers whose fields are all needed anyway.
+ *
+ * tvb_span_init() checks the whole header once, throwing the same
+ * exception as tvb_get_ptr() if it isn't all there; the tvb_span_get_*()
+ * accessors then read fields at offsets relative to the start of the span.
+ * Each of them still checks that the field is inside the span, but when
+ * the span length and the field offsets are constants, as they are for
+ * fixed headers, the compiler removes those checks. Reading outside the
+ * span is a dissector bug.
+ *
+ * Don't use this if the fields before a truncation should still be
+ * dissected; the regular tvb_get_*() routines are already fast.
+ */
+typedef struct {
+    const guint8 *data;
+    guint length;
+} tvb_span_t;
+
+WS_DLL_PUBLIC WS_NORETURN void tvb_span_bad_access(const guint offset,
+    const guint size, const guint length);
+
+static inline void
+tvb_span_init(tvb_span_t *span, tvbuff_t *tvb, const gint offset,
+    const guint length)
+{
+    span->data = tvb_get_ptr(tvb, offset, (gint) length);
+    span->length = length;
+}
+
+static inline const guint8 *
+tvb_span_ptr(const tvb_span_t *span, const guint offset, const guint size)
+{
+    if (G_UNLIKELY(offset > span->length || size > span->length - offset))
+        tvb_span_bad_access(offset, size, span->length);
+    return span->data + offset;
+}
+
+static inline guint8
+tvb_span_get_guint8(const tvb_span_t *span, const guint offset)
+{
+    return *tvb_span_ptr(span, offset, 1);
+}
+
+static inline guint16
+tvb_span_get_ntohs(const tvb_span_t *span, const guint offset)
+{
+    return pntoh16(tvb_span_ptr(span, offset, 2));
+}
+
+static inline guint32
+tvb_span_get_ntoh24(const tvb_span_t *span, const guint offset)
+{
+    return pntoh24(tvb_span_ptr(span, offset, 3));
+}
+
+static inline guint32
+tvb_span_get_ntohl(const tvb_span_t *span, const guint offset)
+{
+    return pntoh32(tvb_span_ptr(span, offset, 4));
+}
+
+static inline guint64
+tvb_span_get_ntoh64(const tvb_span_t *span, const guint offset)
+{
+    return pntoh64(tvb_span_ptr(span, offset, 8));
+}
+
+static inline guint16
+tvb_span_get_letohs(const tvb_span_t *span, const guint offset)
+{
+    return pletoh16(tvb_span_ptr(span, offset, 2));
+}
+
+static inline guint32
+tvb_span_get_letoh24(const tvb_span_t *span, const guint offset)
+{
+    return pletoh24(tvb_span_ptr(span, offset, 3));
+}
+
+static inline guint32
+tvb_span_get_letohl(const tvb_span_t *span, const guint offset)
+{
+    return pletoh32(tvb_span_ptr(span, offset, 4));
+}
+
+static inline guint64
+tvb_span_get_letoh64(const tvb_span_t *span, const guint offset)
+{
+    return pletoh64(tvb_span_ptr(span, offset, 8));
+}
+
 /** Find first occurrence of needle in tvbuff, starting at offset. Searches
  * at most maxlength number of bytes; if maxlength is -1, searches to
  * end of tvbuff.
@@ -26,6 +26,7 @@
  * use that too.
  */
 #define TVB_BROTLI_BUFSIZ (1 << 19)
+#define TVB_BROTLI_MIN_BUFSIZ (1 << 12)
 
 static void*
 brotli_g_malloc_wrapper(void *opaque _U_, size_t size)
@@ -48,12 +49,11 @@ brotli_g_free_wrapper(void *opaque _U_, void *address)
 tvbuff_t *
 tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
 {
-    guint8              *compr;
-    guint8              *uncompr        = NULL;
+    const guint8        *compr;
+    guint8              *uncompr;
     tvbuff_t            *uncompr_tvb;
     BrotliDecoderState  *decoder;
-    guint8              *strmbuf;
-    const size_t         bufsiz         = TVB_BROTLI_BUFSIZ;
+    size_t               bufsiz;
     size_t               available_in;
     const guint8        *next_in;
     size_t               available_out;
@@ -66,7 +66,8 @@ tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
         return NULL;
     }
 
-    compr = (guint8 *)tvb_memdup(NULL, tvb, offset, comprlen);
+    /* Read the compressed data in place rather than copying it. */
+    compr = tvb_get_ptr(tvb, offset, comprlen);
     if (compr == NULL) {
         return NULL;
     }
@@ -76,10 +77,17 @@ tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
       &brotli_g_free_wrapper /*free_func*/,
       NULL /*opaque*/);
     if (decoder == NULL) {
-        wmem_free(NULL, compr);
         return NULL;
     }
-    strmbuf = (guint8 *)g_malloc(bufsiz);
+
+    /*
+     * Decompress straight into the buffer that becomes the new tvb,
+     * doubling it whenever the decoder runs out of room, instead of
+     * going through a bounce buffer and growing the result every pass.
+     */
+    bufsiz = (size_t)comprlen * 2;
+    bufsiz = CLAMP(bufsiz, TVB_BROTLI_MIN_BUFSIZ, TVB_BROTLI_BUFSIZ);
+    uncompr = (guint8 *)g_malloc(bufsiz);
 
     available_in = comprlen;
     next_in = compr;
@@ -88,8 +96,12 @@ tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
     finished = 0;
     while (available_in > 0 || needs_more_output) {
         needs_more_output = 0;
-        available_out = bufsiz;
-        next_out = strmbuf;
+        if (total_out == bufsiz) {
+            bufsiz *= 2;
+            uncompr = (guint8 *)g_realloc(uncompr, bufsiz);
+        }
+        available_out = bufsiz - total_out;
+        next_out = uncompr + total_out;
 
         BrotliDecoderResult result = BrotliDecoderDecompressStream(
           decoder, &available_in, &next_in, &available_out, &next_out, &total_out);
@@ -121,43 +133,29 @@ tvb_uncompress_brotli(tvbuff_t *tvb, const int offset, int comprlen)
         if (total_out > G_MAXINT) {
             goto cleanup;
         }
+    }
 
+    if (total_out == 0 && !finished) {
         /*
-         * BrotliDecoderDecompressStream sets available_out to the number of bytes
-         * left unused from the buffer. But we are interested in the bytes it wrote
-         * to the buffer in this pass, so we calculate pass_out.
+         * A validly decompressed length of 0 gives an empty tvb;
+         * anything else without output is a failure.
          */
-        size_t pass_out = bufsiz - available_out;
-        if (pass_out > 0) {
-            uncompr = (guint8 *)g_realloc(uncompr, total_out);
-            memcpy(uncompr + (total_out - pass_out), strmbuf, pass_out);
-        }
+        goto cleanup;
     }
 
-    if (uncompr == NULL) {
-        /*
-         * This is for the case when the validly decompressed
-         * length is 0.
-         */
-        if (finished) {
-            uncompr = (guint8 *)g_strdup("");
-        } else {
-            goto cleanup;
-        }
+    /* Give back what the last doubling didn't need. */
+    if (total_out > 0 && total_out < bufsiz) {
+        uncompr = (guint8 *)g_realloc(uncompr, total_out);
     }
 
     uncompr_tvb = tvb_new_real_data((guint8 *)uncompr, (guint)total_out, (gint)total_out);
     tvb_set_free_cb(uncompr_tvb, g_free);
 
-    g_free(strmbuf);
-    wmem_free(NULL, compr);
     BrotliDecoderDestroyInstance(decoder);
     return uncompr_tvb;
 
 cleanup:
-    g_free(strmbuf);
     g_free(uncompr);
-    wmem_free(NULL, compr);
     BrotliDecoderDestroyInstance(decoder);
     return NULL;
 }
@@ -39,14 +39,14 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 {
 	gint       err;
 	guint      bytes_out      = 0;
-	guint8    *compr;
+	const guint8 *compr;
 	guint8    *uncompr        = NULL;
+	gboolean   inflated       = FALSE;
 	tvbuff_t  *uncompr_tvb    = NULL;
 	z_streamp  strm;
-	Bytef     *strmbuf;
 	guint      inits_done     = 0;
 	gint       wbits          = MAX_WBITS;
-	guint8    *next;
+	const guint8 *next;
 	guint      bufsiz;
 	guint      inflate_passes = 0;
 	guint      bytes_in       = tvb_captured_length_remaining(tvb, offset);
@@ -55,14 +55,16 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 		return NULL;
 	}
 
-	compr = (guint8 *)tvb_memdup(NULL, tvb, offset, comprlen);
+	/* Read the compressed data in place rather than copying it. */
+	compr = tvb_get_ptr(tvb, offset, comprlen);
 	if (compr == NULL) {
 		return NULL;
 	}
 
 	/*
 	 * Assume that the uncompressed data is at least twice as big as
-	 * the compressed size.
+	 * the compressed size.  Inflate straight into the buffer that
+	 * becomes the new tvb, doubling it when it fills up.
 	 */
 	bufsiz = tvb_captured_length_remaining(tvb, offset) * 2;
 	bufsiz = CLAMP(bufsiz, TVB_Z_MIN_BUFSIZ, TVB_Z_MAX_BUFSIZ);
@@ -75,8 +77,8 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 	strm->next_in   = next;
 	strm->avail_in  = comprlen;
 
-	strmbuf         = (Bytef *)g_malloc0(bufsiz);
-	strm->next_out  = strmbuf;
+	uncompr         = (guint8 *)g_malloc(bufsiz);
+	strm->next_out  = uncompr;
 	strm->avail_out = bufsiz;
 
 	err = inflateInit2(strm, wbits);
@@ -84,38 +86,38 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 	if (err != Z_OK) {
 		inflateEnd(strm);
 		g_free(strm);
-		wmem_free(NULL, compr);
-		g_free(strmbuf);
+		g_free(uncompr);
 		return NULL;
 	}
 
 	while (1) {
-		memset(strmbuf, '\0', bufsiz);
-		strm->next_out  = strmbuf;
-		strm->avail_out = bufsiz;
+		if (bytes_out == bufsiz) {
+			if (bufsiz > G_MAXUINT / 2) {
+				/* Too big for a tvb; keep what we have. */
+				inflateEnd(strm);
+				g_free(strm);
+				break;
+			}
+			bufsiz *= 2;
+			uncompr = (guint8 *)g_realloc(uncompr, bufsiz);
+		}
+		strm->next_out  = uncompr + bytes_out;
+		strm->avail_out = bufsiz - bytes_out;
 
 		err = inflate(strm, Z_SYNC_FLUSH);
 
 		if (err == Z_OK || err == Z_STREAM_END) {
-			guint bytes_pass = bufsiz - strm->avail_out;
+			guint bytes_pass = (bufsiz - bytes_out) - strm->avail_out;
 
 			++inflate_passes;
 
-			if (uncompr == NULL) {
-				/*
-				 * This is ugly workaround for bug #6480
-				 * (https://gitlab.com/wireshark/wireshark/-/issues/6480)
-				 *
-				 * g_memdup2(..., 0) returns NULL (g_malloc(0) also)
-				 * when uncompr is NULL logic below doesn't create tvb
-				 * which is later interpreted as decompression failed.
-				 */
-				uncompr = (guint8 *)((bytes_pass || err != Z_STREAM_END) ?
-						g_memdup2(strmbuf, bytes_pass) :
-						g_strdup(""));
-			} else {
-				uncompr = (guint8 *)g_realloc(uncompr, bytes_out + bytes_pass);
-				memcpy(uncompr + bytes_out, strmbuf, bytes_pass);
+			/*
+			 * An empty stream still gives an (empty) tvb, see
+			 * bug #6480
+			 * (https://gitlab.com/wireshark/wireshark/-/issues/6480)
+			 */
+			if (bytes_pass || err == Z_STREAM_END) {
+				inflated = TRUE;
 			}
 
 			bytes_out += bytes_pass;
@@ -123,7 +125,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			if (err == Z_STREAM_END) {
 				inflateEnd(strm);
 				g_free(strm);
-				g_free(strmbuf);
 				break;
 			}
 		} else if (err == Z_BUF_ERROR) {
@@ -134,17 +135,16 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			 */
 			inflateEnd(strm);
 			g_free(strm);
-			g_free(strmbuf);
 
-			if (uncompr != NULL) {
+			if (inflated) {
 				break;
 			} else {
-				wmem_free(NULL, compr);
+				g_free(uncompr);
 				return NULL;
 			}
 
 		} else if (err == Z_DATA_ERROR && inits_done == 1
-			&& uncompr == NULL && comprlen >= 2 &&
+			&& !inflated && comprlen >= 2 &&
 			(*compr  == 0x1f) && (*(compr + 1) == 0x8b)) {
 			/*
 			 * inflate() is supposed to handle both gzip and deflate
@@ -160,7 +160,7 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			 * fix to make it work (setting windowBits to 31)
 			 * doesn't work with all versions of the library.
 			 */
-			Bytef *c = compr + 2;
+			const Bytef *c = compr + 2;
 			Bytef  flags = 0;
 
 			/* we read two bytes already (0x1f, 0x8b) and
@@ -169,8 +169,7 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			if (comprlen < 10 || *c != Z_DEFLATED) {
 				inflateEnd(strm);
 				g_free(strm);
-				wmem_free(NULL, compr);
-				g_free(strmbuf);
+				g_free(uncompr);
 				return NULL;
 			}
 
@@ -228,8 +227,7 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			if (c - compr > comprlen) {
 				inflateEnd(strm);
 				g_free(strm);
-				wmem_free(NULL, compr);
-				g_free(strmbuf);
+				g_free(uncompr);
 				return NULL;
 			}
 			/* Drop gzip header */
@@ -243,7 +241,7 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			inflateEnd(strm);
 			inflateInit2(strm, wbits);
 			inits_done++;
-		} else if (err == Z_DATA_ERROR && uncompr == NULL &&
+		} else if (err == Z_DATA_ERROR && !inflated &&
 			inits_done <= 3) {
 
 			/*
@@ -261,9 +259,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 			strm->avail_in  = comprlen;
 
 			inflateEnd(strm);
-			memset(strmbuf, '\0', bufsiz);
-			strm->next_out  = strmbuf;
-			strm->avail_out = bufsiz;
 
 			err = inflateInit2(strm, wbits);
 
@@ -271,8 +266,6 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 
 			if (err != Z_OK) {
 				g_free(strm);
-				g_free(strmbuf);
-				wmem_free(NULL, compr);
 				g_free(uncompr);
 
 				return NULL;
@@ -280,10 +273,9 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 		} else {
 			inflateEnd(strm);
 			g_free(strm);
-			g_free(strmbuf);
 
-			if (uncompr == NULL) {
-				wmem_free(NULL, compr);
+			if (!inflated) {
+				g_free(uncompr);
 				return NULL;
 			}
 
@@ -294,11 +286,12 @@ tvb_uncompress(tvbuff_t *tvb, const int offset, int comprlen)
 	ws_debug("inflate() total passes: %u\n", inflate_passes);
 	ws_debug("bytes  in: %u\nbytes out: %u\n\n", bytes_in, bytes_out);
 
-	if (uncompr != NULL) {
-		uncompr_tvb =  tvb_new_real_data(uncompr, bytes_out, bytes_out);
-		tvb_set_free_cb(uncompr_tvb, g_free);
+	/* Give back what the last doubling didn't need. */
+	if (bytes_out > 0 && bytes_out < bufsiz) {
+		uncompr = (guint8 *)g_realloc(uncompr, bytes_out);
 	}
-	wmem_free(NULL, compr);
+	uncompr_tvb =  tvb_new_real_data(uncompr, bytes_out, bytes_out);
+	tvb_set_free_cb(uncompr_tvb, g_free);
 	return uncompr_tvb;
 }
 #else
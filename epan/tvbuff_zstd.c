@@ -34,39 +34,36 @@ tvbuff_t *tvb_uncompress_zstd(tvbuff_t *tvb, const int offset, int comprlen)
     (void)comprlen;
     return NULL;
 #else
-    ZSTD_inBuffer input = {tvb_memdup(NULL, tvb, offset, comprlen), comprlen, 0};
+    // Read the compressed data in place rather than copying it.
+    ZSTD_inBuffer input = {tvb_get_ptr(tvb, offset, comprlen), comprlen, 0};
     ZSTD_DStream *zds = ZSTD_createDStream();
     size_t rc = 0;
-    uint8_t *uncompr = NULL;
-    size_t uncompr_len = 0;
     bool ok = false;
     int count = 0;
 
+    // Decompress straight into the buffer that becomes the new tvb,
+    // doubling it when it fills up, rather than copying each chunk out
+    // of a bounce buffer and growing the result by that much.
+    ZSTD_outBuffer output = {g_malloc(ZSTD_DStreamOutSize()), ZSTD_DStreamOutSize(), 0};
+
     // ZSTD does not consume the last byte of the frame until it has flushed all of the decompressed data of the frame.
     // Therefore, loop while there is more input.
-    ZSTD_outBuffer output = {g_malloc(ZSTD_DStreamOutSize()), ZSTD_DStreamOutSize(), 0};
     while (input.pos < input.size && count < MAX_LOOP_ITERATIONS)
     {
+        if (output.pos == output.size)
+        {
+            if (output.size > G_MAXINT / 2)
+            {
+                goto end;
+            }
+            output.size *= 2;
+            output.dst = g_realloc(output.dst, output.size);
+        }
         rc = ZSTD_decompressStream(zds, &output, &input);
         if (ZSTD_isError(rc))
         {
             goto end;
         }
-
-        if (output.pos > 0)
-        {
-            if (!uncompr)
-            {
-                DISSECTOR_ASSERT (uncompr_len == 0);
-                uncompr = g_malloc(output.pos);
-            } else {
-                uncompr = g_realloc(uncompr, uncompr_len + output.pos);
-            }
-            memcpy (uncompr + uncompr_len, output.dst, output.pos);
-            uncompr_len += output.pos;
-            // Reset the output buffer.
-            output.pos = 0;
-        }
         count++;
         DISSECTOR_ASSERT_HINT(count < MAX_LOOP_ITERATIONS, "MAX_LOOP_ITERATIONS exceeded");
     }
@@ -78,21 +75,23 @@ tvbuff_t *tvb_uncompress_zstd(tvbuff_t *tvb, const int offset, int comprlen)
 
     ok = true;
 end:
-    g_free((void *)output.dst);
-    wmem_free(NULL, (void *)input.src);
     ZSTD_freeDStream(zds);
     if (ok)
     {
         tvbuff_t *uncompr_tvb;
-        uncompr_tvb = tvb_new_real_data (uncompr, (guint)uncompr_len, (guint)uncompr_len);
+        uint8_t *uncompr = (uint8_t *)output.dst;
+
+        // Give back what the last doubling didn't need.
+        if (output.pos < output.size)
+        {
+            uncompr = g_realloc(uncompr, output.pos);
+        }
+        uncompr_tvb = tvb_new_real_data (uncompr, (guint)output.pos, (guint)output.pos);
         tvb_set_free_cb (uncompr_tvb, g_free);
         return uncompr_tvb;
     }
 
-    if (uncompr)
-    {
-        g_free (uncompr);
-    }
+    g_free (output.dst);
 
     return NULL;
 #endif /* HAVE_ZSTD */
@@ -60,6 +60,10 @@ struct epan_uat {
     uat_rep_t* rep;
     uat_rep_free_cb_t free_rep;
     bool loaded;
+    char* loaded_from;      /**< The file the records were read from, if they haven't been changed since. */
+    int64_t loaded_mtime;   /**< Its modification time and size then. */
+    int64_t loaded_size;
+    bool stale;             /**< Unloaded, but with the records of loaded_from kept in case it's loaded again unchanged. */
 };
 
 WS_DLL_PUBLIC
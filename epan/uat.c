@@ -91,6 +91,8 @@ uat_t* uat_new(const char* name,
     uat->valid_data = g_array_new(false,FALSE,sizeof(bool));
     uat->changed = false;
     uat->loaded = false;
+    uat->loaded_from = NULL;
+    uat->stale = false;
     uat->rep = NULL;
     uat->free_rep = NULL;
     uat->help = g_strdup(help);
@@ -438,6 +440,10 @@ bool uat_save(uat_t* uat, char** error) {
     fclose(fp);
 
     uat->changed = false;
+    /* Only the valid records were written, so the file no longer matches
+     * what's in memory. */
+    g_free(uat->loaded_from);
+    uat->loaded_from = NULL;
 
     return true;
 }
@@ -477,6 +483,10 @@ void uat_clear(uat_t* uat) {
     *((uat)->user_ptr) = NULL;
     *((uat)->nrows_p) = 0;
 
+    g_free(uat->loaded_from);
+    uat->loaded_from = NULL;
+    uat->stale = false;
+
     if (uat->reset_cb) {
         uat->reset_cb();
     }
@@ -489,7 +499,14 @@ void uat_unload_all(void) {
         uat_t* u = (uat_t *)g_ptr_array_index(all_uats,i);
         /* Do not unload if not in profile */
         if (u->from_profile) {
-            uat_clear(u);
+            /* Keep the records of an unmodified file; uat_load() clears
+             * them unless it's asked to load the same file again, also
+             * unmodified. */
+            if (u->loaded_from && !u->changed) {
+                u->stale = true;
+            } else {
+                uat_clear(u);
+            }
             u->loaded = false;
         }
     }
@@ -503,6 +520,7 @@ static void free_uat(uat_t *uat)
     g_free(uat->help);
     g_free(uat->name);
     g_free(uat->filename);
+    g_free(uat->loaded_from);
     g_array_free(uat->user_data, true);
     g_array_free(uat->raw_data, true);
     g_array_free(uat->valid_data, true);
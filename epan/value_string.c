@@ -281,6 +281,7 @@ value_string_ext_new(const value_string *vs, guint vs_tot_num_entries,
     vse->_vs_first_value = 0;
     vse->_vs_match2      = _try_val_to_str_ext_init;
     vse->_vs_name        = vs_name;
+    vse->_vs_lookup      = NULL;
 
     return vse;
 }
@@ -288,6 +289,7 @@ value_string_ext_new(const value_string *vs, guint vs_tot_num_entries,
 void
 value_string_ext_free(value_string_ext *vse)
 {
+    g_free(vse->_vs_lookup);
     wmem_free(wmem_epan_scope(), vse);
 }
 
@@ -414,6 +416,59 @@ _try_val_to_str_bsearch(const guint32 val, value_string_ext *vse)
     return NULL;
 }
 
+/* Constant-time matching algorithm for sorted extended value strings with
+ * few gaps. _vs_lookup holds, for each value from the first to the last,
+ * the index of its entry plus one, or 0 if there is no entry. */
+static const value_string *
+_try_val_to_str_lookup(const guint32 val, value_string_ext *vse)
+{
+    guint32 i;
+
+    i = val - vse->_vs_first_value;
+    if (i <= vse->_vs_p[vse->_vs_num_entries - 1].value - vse->_vs_first_value &&
+        vse->_vs_lookup[i] != 0) {
+        return &(vse->_vs_p[vse->_vs_lookup[i] - 1]);
+    }
+    return NULL;
+}
+
+/* log(n)-time matching algorithm for unsorted extended value strings.
+ * _vs_lookup holds the indexes of the entries, sorted (stably) by value;
+ * like the linear search, the first entry with the value is returned. */
+static const value_string *
+_try_val_to_str_sorted_lookup(const guint32 val, value_string_ext *vse)
+{
+    guint low, i, max;
+
+    for (low = 0, max = vse->_vs_num_entries; low < max; ) {
+        i = (low + max) / 2;
+        if (vse->_vs_p[vse->_vs_lookup[i]].value < val)
+            low = i + 1;
+        else
+            max = i;
+    }
+    if (low < vse->_vs_num_entries && vse->_vs_p[vse->_vs_lookup[low]].value == val)
+        return &(vse->_vs_p[vse->_vs_lookup[low]]);
+    return NULL;
+}
+
+static gint
+value_string_index_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const value_string *vs_p = (const value_string *)user_data;
+    guint32 val_a = vs_p[*(const guint32 *)a].value;
+    guint32 val_b = vs_p[*(const guint32 *)b].value;
+
+    return val_a < val_b ? -1 : (val_a > val_b ? 1 : 0);
+}
+
+/*
+ * A sorted value_string whose values span less than this many times
+ * the number of entries gets a direct lookup table rather than a binary
+ * search.
+ */
+#define VS_LOOKUP_MAX_SPAN_FACTOR 4
+
 /* Initializes an extended value string. Behaves like a match function to
  * permit lazy initialization of extended value strings.
  * - Goes through the value_string array to determine the fastest possible
@@ -428,8 +483,11 @@ _try_val_to_str_ext_init(const guint32 val, value_string_ext *vse)
     const guint         vs_num_entries = vse->_vs_num_entries;
 
     /* The matching algorithm used:
-     * VS_SEARCH   - slow sequential search (as in a normal value string)
-     * VS_BIN_TREE - log(n)-time binary search, the values must be sorted
+     * VS_SEARCH   - log(n)-time binary search through a sorted table of
+     *               indexes, for values that aren't sorted
+     * VS_BIN_TREE - log(n)-time binary search, the values must be sorted;
+     *               if they have few gaps, a constant-time lookup table of
+     *               indexes is used instead
      * VS_INDEX    - constant-time index lookup, the values must be contiguous
      */
     enum { VS_SEARCH, VS_BIN_TREE, VS_INDEX } type = VS_INDEX;
@@ -472,14 +530,14 @@ _try_val_to_str_ext_init(const guint32 val, value_string_ext *vse)
         /* XXX: Should check for dups ?? */
         if (type == VS_BIN_TREE) {
             if (prev_value > vs_p[i].value) {
-                ws_warning("Extended value string '%s' forced to fall back to linear search:\n"
+                ws_warning("Extended value string '%s' isn't sorted; using a sorted index:\n"
                           "  entry %u, value %u [%#x] < previous entry, value %u [%#x]",
                           vse->_vs_name, i, vs_p[i].value, vs_p[i].value, prev_value, prev_value);
                 type = VS_SEARCH;
                 break;
             }
             if (first_value > vs_p[i].value) {
-                ws_warning("Extended value string '%s' forced to fall back to linear search:\n"
+                ws_warning("Extended value string '%s' isn't sorted; using a sorted index:\n"
                           "  entry %u, value %u [%#x] < first entry, value %u [%#x]",
                           vse->_vs_name, i, vs_p[i].value, vs_p[i].value, first_value, first_value);
                 type = VS_SEARCH;
@@ -492,10 +550,29 @@ _try_val_to_str_ext_init(const guint32 val, value_string_ext *vse)
 
     switch (type) {
         case VS_SEARCH:
-            vse->_vs_match2 = _try_val_to_str_linear;
+            vse->_vs_lookup = g_new(guint32, vs_num_entries);
+            for (i = 0; i < vs_num_entries; i++) {
+                vse->_vs_lookup[i] = i;
+            }
+            g_qsort_with_data(vse->_vs_lookup, vs_num_entries, sizeof (guint32),
+                              value_string_index_compare, (gpointer)vs_p);
+            vse->_vs_match2 = _try_val_to_str_sorted_lookup;
             break;
         case VS_BIN_TREE:
-            vse->_vs_match2 = _try_val_to_str_bsearch;
+            if ((guint64)(vs_p[vs_num_entries - 1].value - first_value) <
+                (guint64)vs_num_entries * VS_LOOKUP_MAX_SPAN_FACTOR) {
+                guint32 span = vs_p[vs_num_entries - 1].value - first_value + 1;
+
+                vse->_vs_lookup = g_new0(guint32, span);
+                /* Fill from the end so that the first of any entries
+                 * with the same value wins, as with the linear search. */
+                for (i = vs_num_entries; i > 0; i--) {
+                    vse->_vs_lookup[vs_p[i - 1].value - first_value] = i;
+                }
+                vse->_vs_match2 = _try_val_to_str_lookup;
+            } else {
+                vse->_vs_match2 = _try_val_to_str_bsearch;
+            }
             break;
         case VS_INDEX:
             vse->_vs_match2 = _try_val_to_str_index;
@@ -1024,7 +1101,9 @@ value_string_ext_validate(const value_string_ext *vse)
     if ((vse->_vs_match2 != _try_val_to_str_ext_init) &&
         (vse->_vs_match2 != _try_val_to_str_linear)   &&
         (vse->_vs_match2 != _try_val_to_str_bsearch)  &&
-        (vse->_vs_match2 != _try_val_to_str_index))
+        (vse->_vs_match2 != _try_val_to_str_index)    &&
+        (vse->_vs_match2 != _try_val_to_str_lookup)   &&
+        (vse->_vs_match2 != _try_val_to_str_sorted_lookup))
         return FALSE;
 #endif
     return TRUE;
@@ -1041,6 +1120,10 @@ value_string_ext_match_type_str(const value_string_ext *vse)
         return "[Binary Search]";
     if (vse->_vs_match2 == _try_val_to_str_index)
         return "[Direct (indexed) Access]";
+    if (vse->_vs_match2 == _try_val_to_str_lookup)
+        return "[Direct (lookup table) Access]";
+    if (vse->_vs_match2 == _try_val_to_str_sorted_lookup)
+        return "[Binary Search (sorted index)]";
     return "[Invalid]";
 }
 
@@ -959,6 +959,7 @@ wslua_get_expert_field(const int group, const int severity)
     return &ei_lua_error;
 }
 
+#ifndef HAVE_LUAJIT
 static void *
 wslua_allocf(void *ud _U_, void *ptr, size_t osize _U_, size_t nsize)
 {
@@ -966,6 +967,7 @@ wslua_allocf(void *ud _U_, void *ptr, size_t osize _U_, size_t nsize)
      * Furthermore it simplifies error handling by aborting on OOM */
     return g_realloc(ptr, nsize);
 }
+#endif
 
 #define WSLUA_EPAN_ENUMS_TABLE  "_EPAN"
 #define WSLUA_WTAP_ENUMS_TABLE  "_WTAP"
@@ -1530,7 +1532,12 @@ void wslua_init(register_cb cb, gpointer client_data) {
     }
 
     if (!L) {
+#ifdef HAVE_LUAJIT
+        /* 64-bit LuaJIT without GC64 can't use a custom allocator */
+        L = luaL_newstate();
+#else
         L = lua_newstate(wslua_allocf, NULL);
+#endif
     }
 
     WSLUA_INIT(L);
@@ -1762,6 +1769,7 @@ void wslua_cleanup(void) {
         lua_close(L);
         L = NULL;
     }
+    wslua_pools_cleanup();
     init_routine_initialized = FALSE;
 }
 
@@ -675,6 +675,45 @@ extern int wslua_reg_attributes(lua_State *L, const wslua_attribute_table *t, gb
     } \
 }
 
+/*
+ * Free lists for the structs behind the userdata that is created for every
+ * packet (Tvb, TvbRange, Pinfo and TreeItem). A struct is only returned to
+ * its pool once both the garbage collector and the end of the packet are
+ * done with it, so no userdata can refer to a struct that is handed out again.
+ */
+typedef struct _wslua_wrapper_pool {
+    const char *name;
+    size_t size;
+    GPtrArray *free_list;
+    guint64 allocated;    /* structs obtained with g_malloc() */
+    guint64 reused;       /* structs taken from free_list */
+} wslua_wrapper_pool;
+
+#define WSLUA_WRAPPER_POOL(C) { #C, sizeof(*(C)NULL), NULL, 0, 0 }
+
+extern wslua_wrapper_pool Tvb_pool;
+extern wslua_wrapper_pool TvbRange_pool;
+extern wslua_wrapper_pool Pinfo_pool;
+extern wslua_wrapper_pool TreeItem_pool;
+
+extern void *wslua_pool_alloc(wslua_wrapper_pool *pool);
+extern void wslua_pool_free(wslua_wrapper_pool *pool, void *p);
+extern void wslua_pools_cleanup(void);
+extern void wslua_push_pool_stats(lua_State *L);
+
+/* Like CLEAR_OUTSTANDING, for classes whose structs come from C##_pool */
+#define CLEAR_OUTSTANDING_POOLED(C, marker, marker_val) void clear_outstanding_##C(void) { \
+    while (outstanding_##C->len) { \
+        C p = (C)g_ptr_array_remove_index_fast(outstanding_##C,outstanding_##C->len-1); \
+        if (p) { \
+            if (p->marker != marker_val) \
+                p->marker = marker_val; \
+            else \
+                wslua_pool_free(&C##_pool, p); \
+        } \
+    } \
+}
+
 #define WSLUA_CLASS_DECLARE(C) \
 extern C to##C(lua_State* L, int idx); \
 extern C check##C(lua_State* L, int idx); \
@@ -459,6 +459,74 @@ static void wslua_push_attributes(lua_State *L, const wslua_attribute_table *t,
  * Registers the metatable for class instances. See the documentation of
  * wslua_register_class for the exact metatable.
  */
+/* Most packets need only a handful of structs; a long burst of TvbRanges
+ * from one packet shouldn't keep its memory around forever. */
+#define WSLUA_POOL_MAX_FREE 1024
+
+wslua_wrapper_pool Tvb_pool = WSLUA_WRAPPER_POOL(Tvb);
+wslua_wrapper_pool TvbRange_pool = WSLUA_WRAPPER_POOL(TvbRange);
+wslua_wrapper_pool Pinfo_pool = WSLUA_WRAPPER_POOL(Pinfo);
+wslua_wrapper_pool TreeItem_pool = WSLUA_WRAPPER_POOL(TreeItem);
+
+static wslua_wrapper_pool *wslua_pools[] = {
+    &Tvb_pool, &TvbRange_pool, &Pinfo_pool, &TreeItem_pool
+};
+
+void *wslua_pool_alloc(wslua_wrapper_pool *pool)
+{
+    if (pool->free_list && pool->free_list->len) {
+        pool->reused++;
+        return g_ptr_array_remove_index_fast(pool->free_list, pool->free_list->len - 1);
+    }
+    pool->allocated++;
+    return g_malloc(pool->size);
+}
+
+void wslua_pool_free(wslua_wrapper_pool *pool, void *p)
+{
+    if (!p) return;
+
+    if (!pool->free_list) {
+        pool->free_list = g_ptr_array_new();
+    }
+    if (pool->free_list->len < WSLUA_POOL_MAX_FREE) {
+        g_ptr_array_add(pool->free_list, p);
+    } else {
+        g_free(p);
+    }
+}
+
+void wslua_pools_cleanup(void)
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(wslua_pools); i++) {
+        wslua_wrapper_pool *pool = wslua_pools[i];
+        if (pool->free_list) {
+            g_ptr_array_free(pool->free_list, TRUE);
+            pool->free_list = NULL;
+        }
+        pool->allocated = 0;
+        pool->reused = 0;
+    }
+}
+
+/* Pushes a table with one { allocated, reused, pooled } table per class. */
+void wslua_push_pool_stats(lua_State *L)
+{
+    lua_newtable(L);
+    for (size_t i = 0; i < G_N_ELEMENTS(wslua_pools); i++) {
+        const wslua_wrapper_pool *pool = wslua_pools[i];
+
+        lua_newtable(L);
+        lua_pushnumber(L, (lua_Number)pool->allocated);
+        lua_setfield(L, -2, "allocated");
+        lua_pushnumber(L, (lua_Number)pool->reused);
+        lua_setfield(L, -2, "reused");
+        lua_pushnumber(L, pool->free_list ? pool->free_list->len : 0);
+        lua_setfield(L, -2, "pooled");
+        lua_setfield(L, -2, pool->name);
+    }
+}
+
 void wslua_register_classinstance_meta(lua_State *L, const wslua_class *cls_def)
 {
     /* Register metatable for use by class instances. STACK = { MT } */
@@ -118,7 +118,7 @@ static tap_packet_status lua_tap_packet(void *tapdata, packet_info *pinfo, epan_
     lua_pinfo = NULL;
     lua_tvb = NULL;
     lua_tree = NULL;
-    g_free(lua_tree_tap);
+    wslua_pool_free(&TreeItem_pool, lua_tree_tap);
 
     return retval;
 }
@@ -33,13 +33,13 @@
 static GPtrArray* outstanding_Pinfo = NULL;
 static GPtrArray* outstanding_PrivateTable = NULL;
 
-CLEAR_OUTSTANDING(Pinfo,expired, TRUE)
+CLEAR_OUTSTANDING_POOLED(Pinfo,expired, TRUE)
 CLEAR_OUTSTANDING(PrivateTable,expired, TRUE)
 
 Pinfo* push_Pinfo(lua_State* L, packet_info* ws_pinfo) {
     Pinfo pinfo = NULL;
     if (ws_pinfo) {
-        pinfo = (Pinfo)g_malloc(sizeof(struct _wslua_pinfo));
+        pinfo = (Pinfo)wslua_pool_alloc(&Pinfo_pool);
         pinfo->ws_pinfo = ws_pinfo;
         pinfo->expired = FALSE;
         g_ptr_array_add(outstanding_Pinfo,pinfo);
@@ -423,7 +423,7 @@ static int Pinfo__gc(lua_State* L) {
     if (!pinfo->expired)
         pinfo->expired = TRUE;
     else
-        g_free(pinfo);
+        wslua_pool_free(&Pinfo_pool, pinfo);
 
     return 0;
 
@@ -1452,6 +1452,23 @@ PROTOFIELD_OTHER(rel_oid,FT_REL_OID)
 PROTOFIELD_OTHER(systemid,FT_SYSTEM_ID)
 PROTOFIELD_OTHER(eui64,FT_EUI64)
 
+WSLUA_METHOD ProtoField_hfid(lua_State* L) {
+    /* Get the number Wireshark gave this field when its protocol was registered,
+       for <<lua_class_TreeItem,`TreeItem:add_hfid()`>> or for libwireshark functions
+       called through LuaJIT's FFI. Look it up once, outside the dissector function.
+
+       @since 4.3.0
+     */
+    ProtoField f = checkProtoField(L,1);
+
+    if (f->hfid < 0) {
+        lua_pushnil(L);
+    } else {
+        lua_pushnumber(L, f->hfid);
+    }
+    WSLUA_RETURN(1); /* The field number, or nil if the field hasn't been registered yet. */
+}
+
 WSLUA_METAMETHOD ProtoField__tostring(lua_State* L) {
     /* Returns a string with info about a protofield (for debugging purposes). */
     ProtoField f = checkProtoField(L,1);
@@ -1523,6 +1540,7 @@ WSLUA_METHODS ProtoField_methods[] = {
     WSLUA_CLASS_FNREG(ProtoField,rel_oid),
     WSLUA_CLASS_FNREG(ProtoField,systemid),
     WSLUA_CLASS_FNREG(ProtoField,eui64),
+    WSLUA_CLASS_FNREG(ProtoField,hfid),
     { NULL, NULL }
 };
 
@@ -28,7 +28,7 @@ static GPtrArray* outstanding_TreeItem = NULL;
 
 /* pushing a TreeItem with a NULL item or subtree is completely valid for this function */
 TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item) {
-    TreeItem ti = g_new(struct _wslua_treeitem, 1);
+    TreeItem ti = (TreeItem)wslua_pool_alloc(&TreeItem_pool);
 
     ti->tree = tree;
     ti->item = item;
@@ -42,7 +42,7 @@ TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item) {
 /* creates the TreeItem but does NOT push it into Lua */
 TreeItem create_TreeItem(proto_tree* tree, proto_item* item)
 {
-    TreeItem tree_item = (TreeItem)g_malloc(sizeof(struct _wslua_treeitem));
+    TreeItem tree_item = (TreeItem)wslua_pool_alloc(&TreeItem_pool);
     tree_item->tree = tree;
     tree_item->item = item;
     tree_item->expired = FALSE;
@@ -50,7 +50,7 @@ TreeItem create_TreeItem(proto_tree* tree, proto_item* item)
     return tree_item;
 }
 
-CLEAR_OUTSTANDING(TreeItem, expired, TRUE)
+CLEAR_OUTSTANDING_POOLED(TreeItem, expired, TRUE)
 
 WSLUA_CLASS_DEFINE(TreeItem,FAIL_ON_NULL_OR_EXPIRED("TreeItem"));
 /* <<lua_class_TreeItem,`TreeItem`>>s represent information in the https://www.wireshark.org/docs/wsug_html_chunked/ChUsePacketDetailsPaneSection.html[packet details] pane of Wireshark, and the packet details view of TShark.
@@ -443,6 +443,70 @@ WSLUA_METHOD TreeItem_add_packet_field(lua_State *L) {
     WSLUA_RETURN(3); /* The new child <<lua_class_TreeItem,`TreeItem`>>, the field's extracted value or nil, and offset or nil. */
 }
 
+WSLUA_METHOD TreeItem_add_hfid(lua_State *L) {
+    /*
+     Adds a field to this tree item, given the number of a registered field from
+     <<lua_class_ProtoField,`ProtoField:hfid()`>> and a <<lua_class_Tvb,`Tvb`>> rather
+     than a <<lua_class_TvbRange,`TvbRange`>>. Unlike `TreeItem:add_packet_field()`,
+     no <<lua_class_TreeItem,`TreeItem`>> is returned, so no Lua objects are
+     created; use it for fields that don't need a subtree or appended text.
+
+     [source,lua]
+     ----
+     local hf_len = f_len:hfid()  -- once the protocol has been registered
+     tree:add_hfid(hf_len, tvb, offset, 2, ENC_BIG_ENDIAN)
+     ----
+
+     @since 4.3.0
+    */
+#define WSLUA_ARG_TreeItem_add_hfid_HFID 2 /* The field number. */
+#define WSLUA_ARG_TreeItem_add_hfid_TVB 3 /* The <<lua_class_Tvb,`Tvb`>> holding the field. */
+#define WSLUA_ARG_TreeItem_add_hfid_OFFSET 4 /* The offset (in octets) of the field in the <<lua_class_Tvb,`Tvb`>>. */
+#define WSLUA_ARG_TreeItem_add_hfid_LENGTH 5 /* The length (in octets) of the field, or -1 for the rest of the <<lua_class_Tvb,`Tvb`>>. */
+#define WSLUA_OPTARG_TreeItem_add_hfid_ENCODING 6 /* The field's encoding. Defaults to `ENC_BIG_ENDIAN`. */
+    TreeItem tree_item = checkTreeItem(L,1);
+    int hfid = (int) luaL_checkinteger(L,WSLUA_ARG_TreeItem_add_hfid_HFID);
+    Tvb tvb = checkTvb(L,WSLUA_ARG_TreeItem_add_hfid_TVB);
+    int offset = (int) luaL_checkinteger(L,WSLUA_ARG_TreeItem_add_hfid_OFFSET);
+    int len = (int) luaL_checkinteger(L,WSLUA_ARG_TreeItem_add_hfid_LENGTH);
+    guint encoding = (guint) luaL_optinteger(L,WSLUA_OPTARG_TreeItem_add_hfid_ENCODING,ENC_BIG_ENDIAN);
+    const char *volatile error = NULL;
+
+    if (tvb->expired) {
+        luaL_error(L,"expired tvb");
+        return 0;
+    }
+
+    if (hfid < 0 || proto_registrar_get_nth(hfid) == NULL) {
+        WSLUA_ARG_ERROR(TreeItem_add_hfid,HFID,"not a registered field");
+        return 0;
+    }
+
+    TRY {
+        proto_tree_add_item(tree_item->tree, hfid, tvb->ws_tvb, offset, len, encoding);
+    } CATCH_ALL {
+        show_exception(tvb->ws_tvb, lua_pinfo, tree_item->tree, EXCEPT_CODE, GET_MESSAGE);
+        error = "Lua programming error";
+    } ENDTRY;
+
+    if (error) { WSLUA_ERROR(TreeItem_add_hfid,error); }
+
+    return 0;
+}
+
+WSLUA_METHOD TreeItem_handle(lua_State *L) {
+    /* Obtain a light userdata pointing to the C `proto_tree` of this tree item,
+       to be passed to libwireshark functions called through LuaJIT's FFI. It is
+       NULL when no tree is being built, and only valid while the dissector runs.
+
+       @since 4.3.0
+     */
+    TreeItem tree_item = checkTreeItem(L,1);
+
+    lua_pushlightuserdata(L, tree_item->tree);
+    WSLUA_RETURN(1); /* A light userdata pointing to the `proto_tree`. */
+}
+
 static int TreeItem_add_item_any(lua_State *L, gboolean little_endian) {
     TvbRange tvbr;
     Proto proto;
@@ -1127,7 +1191,7 @@ static int TreeItem__gc(lua_State* L) {
     if (!ti->expired)
         ti->expired = TRUE;
     else
-        g_free(ti);
+        wslua_pool_free(&TreeItem_pool, ti);
     return 0;
 }
 
@@ -1144,6 +1208,8 @@ WSLUA_METHODS TreeItem_methods[] = {
     WSLUA_CLASS_FNREG(TreeItem,add_packet_field),
     WSLUA_CLASS_FNREG(TreeItem,add),
     WSLUA_CLASS_FNREG(TreeItem,add_le),
+    WSLUA_CLASS_FNREG(TreeItem,add_hfid),
+    WSLUA_CLASS_FNREG(TreeItem,handle),
     WSLUA_CLASS_FNREG(TreeItem,set_text),
     WSLUA_CLASS_FNREG(TreeItem,append_text),
     WSLUA_CLASS_FNREG(TreeItem,prepend_text),
@@ -83,20 +83,20 @@ static void free_Tvb(Tvb tvb) {
     } else {
         if (tvb->need_free)
             tvb_free(tvb->ws_tvb);
-        g_free(tvb);
+        wslua_pool_free(&Tvb_pool, tvb);
     }
 }
 
 void clear_outstanding_Tvb(void) {
     while (outstanding_Tvb->len) {
-        Tvb tvb = (Tvb)g_ptr_array_remove_index_fast(outstanding_Tvb,0);
+        Tvb tvb = (Tvb)g_ptr_array_remove_index_fast(outstanding_Tvb,outstanding_Tvb->len-1);
         free_Tvb(tvb);
     }
 }
 
 /* this is used to push Tvbs that just point to pre-existing C-code Tvbs */
 Tvb* push_Tvb(lua_State* L, tvbuff_t* ws_tvb) {
-    Tvb tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    Tvb tvb = (Tvb)wslua_pool_alloc(&Tvb_pool);
     tvb->ws_tvb = ws_tvb;
     tvb->expired = FALSE;
     tvb->need_free = FALSE;
@@ -273,6 +273,112 @@ WSLUA_METHOD Tvb_raw(lua_State* L) {
     WSLUA_RETURN(1); /* A Lua string of the binary bytes in the <<lua_class_Tvb,`Tvb`>>. */
 }
 
+static int Tvb_uint_any(lua_State* L, gboolean little_endian) {
+    Tvb tvb = checkTvb(L,1);
+    int offset = (int) luaL_checkinteger(L,2);
+    int len = (int) luaL_checkinteger(L,3);
+
+    if (tvb->expired) {
+        luaL_error(L,"expired tvb");
+        return 0;
+    }
+
+    if (len < 1 || len > 4) {
+        luaL_error(L,"length must be between 1 and 4");
+        return 0;
+    }
+
+    if (offset < 0 || (guint)(len + offset) > tvb_captured_length(tvb->ws_tvb)) {
+        luaL_error(L,"Range is out of bounds");
+        return 0;
+    }
+
+    switch (len) {
+        case 1:
+            lua_pushnumber(L,tvb_get_guint8(tvb->ws_tvb,offset));
+            break;
+        case 2:
+            lua_pushnumber(L,little_endian ? tvb_get_letohs(tvb->ws_tvb,offset) : tvb_get_ntohs(tvb->ws_tvb,offset));
+            break;
+        case 3:
+            lua_pushnumber(L,little_endian ? tvb_get_letoh24(tvb->ws_tvb,offset) : tvb_get_ntoh24(tvb->ws_tvb,offset));
+            break;
+        default:
+            lua_pushnumber(L,little_endian ? tvb_get_letohl(tvb->ws_tvb,offset) : tvb_get_ntohl(tvb->ws_tvb,offset));
+            break;
+    }
+    return 1;
+}
+
+WSLUA_METHOD Tvb_uint(lua_State* L) {
+    /* Get a big-endian unsigned integer of 1 to 4 octets from a <<lua_class_Tvb,`Tvb`>>.
+       Same as `tvb:range(offset, length):uint()`, but without creating a
+       <<lua_class_TvbRange,`TvbRange`>>, which matters in loops over many fields.
+
+       @since 4.3.0
+     */
+#define WSLUA_ARG_Tvb_uint_OFFSET 2 /* The offset (in octets) from the beginning of the <<lua_class_Tvb,`Tvb`>>. */
+#define WSLUA_ARG_Tvb_uint_LENGTH 3 /* The length (in octets) of the integer. */
+    return Tvb_uint_any(L, FALSE);
+    /* WSLUA_RETURN(1); The unsigned integer value. */
+}
+
+WSLUA_METHOD Tvb_le_uint(lua_State* L) {
+    /* Get a little-endian unsigned integer of 1 to 4 octets from a <<lua_class_Tvb,`Tvb`>>.
+       Same as `tvb:range(offset, length):le_uint()`, but without creating a
+       <<lua_class_TvbRange,`TvbRange`>>.
+
+       @since 4.3.0
+     */
+#define WSLUA_ARG_Tvb_le_uint_OFFSET 2 /* The offset (in octets) from the beginning of the <<lua_class_Tvb,`Tvb`>>. */
+#define WSLUA_ARG_Tvb_le_uint_LENGTH 3 /* The length (in octets) of the integer. */
+    return Tvb_uint_any(L, TRUE);
+    /* WSLUA_RETURN(1); The unsigned integer value. */
+}
+
+WSLUA_METHOD Tvb_pointer(lua_State* L) {
+    /* Obtain a light userdata pointing to the captured bytes of a <<lua_class_Tvb,`Tvb`>>, and their number.
+       This is meant for LuaJIT's FFI, which can read the bytes directly after
+       `local p = ffi.cast("const uint8_t *", ptr)`. The pointer must not be used
+       after the dissector the <<lua_class_Tvb,`Tvb`>> was passed to returns, and
+       nothing stops reads beyond the length.
+
+       @since 4.3.0
+     */
+    Tvb tvb = checkTvb(L,1);
+    guint len;
+
+    if (tvb->expired) {
+        luaL_error(L,"expired tvb");
+        return 0;
+    }
+
+    len = tvb_captured_length(tvb->ws_tvb);
+    lua_pushlightuserdata(L, (void *)tvb_get_ptr(tvb->ws_tvb, 0, len));
+    lua_pushnumber(L, len);
+
+    WSLUA_RETURN(2); /* A light userdata pointing to the bytes, and the captured length of the <<lua_class_Tvb,`Tvb`>>. */
+}
+
+WSLUA_METHOD Tvb_handle(lua_State* L) {
+    /* Obtain a light userdata pointing to the C `tvbuff_t` of a <<lua_class_Tvb,`Tvb`>>,
+       to be passed to libwireshark functions such as `proto_tree_add_item()`
+       called through LuaJIT's FFI. It is only valid while the dissector
+       the <<lua_class_Tvb,`Tvb`>> was passed to runs.
+
+       @since 4.3.0
+     */
+    Tvb tvb = checkTvb(L,1);
+
+    if (tvb->expired) {
+        luaL_error(L,"expired tvb");
+        return 0;
+    }
+
+    lua_pushlightuserdata(L, tvb->ws_tvb);
+    WSLUA_RETURN(1); /* A light userdata pointing to the `tvbuff_t`. */
+}
+
 WSLUA_METAMETHOD Tvb__eq(lua_State* L) {
     /* Checks whether contents of two <<lua_class_Tvb,`Tvb`>>s are equal.
 
@@ -314,6 +420,10 @@ WSLUA_METHODS Tvb_methods[] = {
     WSLUA_CLASS_FNREG(Tvb,captured_len),
     WSLUA_CLASS_FNREG(Tvb,len),
     WSLUA_CLASS_FNREG(Tvb,raw),
+    WSLUA_CLASS_FNREG(Tvb,uint),
+    WSLUA_CLASS_FNREG(Tvb,le_uint),
+    WSLUA_CLASS_FNREG(Tvb,pointer),
+    WSLUA_CLASS_FNREG(Tvb,handle),
     { NULL, NULL }
 };
 
@@ -349,13 +459,13 @@ static void free_TvbRange(TvbRange tvbr) {
         tvbr->tvb->expired = TRUE;
     } else {
         free_Tvb(tvbr->tvb);
-        g_free(tvbr);
+        wslua_pool_free(&TvbRange_pool, tvbr);
     }
 }
 
 void clear_outstanding_TvbRange(void) {
     while (outstanding_TvbRange->len) {
-        TvbRange tvbr = (TvbRange)g_ptr_array_remove_index_fast(outstanding_TvbRange,0);
+        TvbRange tvbr = (TvbRange)g_ptr_array_remove_index_fast(outstanding_TvbRange,outstanding_TvbRange->len-1);
         free_TvbRange(tvbr);
     }
 }
@@ -383,8 +493,8 @@ gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
         return FALSE;
     }
 
-    tvbr = (TvbRange)g_malloc(sizeof(struct _wslua_tvbrange));
-    tvbr->tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    tvbr = (TvbRange)wslua_pool_alloc(&TvbRange_pool);
+    tvbr->tvb = (Tvb)wslua_pool_alloc(&Tvb_pool);
     tvbr->tvb->ws_tvb = ws_tvb;
     tvbr->tvb->expired = FALSE;
     tvbr->tvb->need_free = FALSE;
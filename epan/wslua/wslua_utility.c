@@ -28,6 +28,31 @@ WSLUA_FUNCTION wslua_get_version(lua_State* L) { /* Gets the Wireshark version a
 }
 
 
+WSLUA_FUNCTION wslua_get_gc_stats(lua_State* L) {
+    /* Gets memory statistics of the Lua state shared by all plugins, to help
+       find scripts that create a lot of garbage per packet.
+
+       The returned table has a `memory` field with the number of bytes in use
+       by Lua, and one field per class (`Tvb`, `TvbRange`, `Pinfo`, `TreeItem`)
+       whose `allocated`, `reused` and `pooled` fields count the objects that
+       needed new memory, those that recycled the memory of an object of an
+       earlier packet, and those currently waiting to be recycled.
+
+       [source,lua]
+       ----
+       local stats = get_gc_stats()
+       print(stats.memory, stats.TvbRange.allocated, stats.TvbRange.reused)
+       ----
+
+       @since 4.3.0
+     */
+    wslua_push_pool_stats(L);
+    lua_pushnumber(L, (lua_Number)lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0));
+    lua_setfield(L, -2, "memory");
+    WSLUA_RETURN(1); /* A table of statistics. */
+}
+
+
 static gchar *current_plugin_version = NULL;
 static gchar *current_plugin_description = NULL;
 static gchar *current_plugin_repository = NULL;
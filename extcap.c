@@ -70,6 +70,13 @@ static GHashTable * _loaded_interfaces = NULL;
  */
 static GHashTable * _tool_for_ifname = NULL;
 
+/* Internal container, which maps each ifname to the output of its --extcap-dlts
+ * call, so that the capabilities are only queried once until
+ * extcap_clear_interfaces() is called. The key and string value are owned by
+ * this table.
+ */
+static GHashTable * _dlts_for_ifname = NULL;
+
 /* internal container, for all the extcap executables that have been found
  * and that provides a toolbar with controls to be added to a Interface Toolbar
  */
@@ -179,6 +186,10 @@ extcap_clear_interfaces(void)
     if ( _tool_for_ifname )
         g_hash_table_destroy(_tool_for_ifname);
     _tool_for_ifname = NULL;
+
+    if ( _dlts_for_ifname )
+        g_hash_table_destroy(_dlts_for_ifname);
+    _dlts_for_ifname = NULL;
 }
 
 static gint
@@ -616,13 +627,44 @@ extcap_get_if_dlts(const gchar *ifname, char **err_str)
     extcap_interface *interface = extcap_find_interface_for_ifname(ifname);
     if (interface)
     {
-        arguments = g_list_append(arguments, g_strdup(EXTCAP_ARGUMENT_LIST_DLTS));
-        arguments = g_list_append(arguments, g_strdup(EXTCAP_ARGUMENT_INTERFACE));
-        arguments = g_list_append(arguments, g_strdup(ifname));
+        const char *dirname = get_extcap_dir();
+        gchar **args;
+        int cnt;
+        gchar *command_output = NULL;
 
-        extcap_run_one(interface, arguments, cb_dlt, &caps, err_str);
+        if (_dlts_for_ifname)
+            command_output = (gchar *)g_hash_table_lookup(_dlts_for_ifname, ifname);
 
-        g_list_free_full(arguments, g_free);
+        if (!command_output)
+        {
+            arguments = g_list_append(arguments, g_strdup(EXTCAP_ARGUMENT_LIST_DLTS));
+            arguments = g_list_append(arguments, g_strdup(EXTCAP_ARGUMENT_INTERFACE));
+            arguments = g_list_append(arguments, g_strdup(ifname));
+            args = extcap_convert_arguments_to_array(arguments);
+            cnt = g_list_length(arguments);
+
+            if (ws_pipe_spawn_sync(dirname, interface->extcap_path, cnt, args, &command_output))
+            {
+                if (!_dlts_for_ifname)
+                    _dlts_for_ifname = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+                g_hash_table_insert(_dlts_for_ifname, g_strdup(ifname), command_output);
+            }
+
+            extcap_free_array(args, cnt);
+            g_list_free_full(arguments, g_free);
+        }
+
+        if (command_output)
+        {
+            extcap_callback_info_t cb_info = {
+                .ifname = interface->call,
+                .extcap = interface->extcap_path,
+                .output = command_output,
+                .data = &caps,
+                .err_str = err_str,
+            };
+            cb_dlt(cb_info);
+        }
     }
 
     return caps;
@@ -2049,6 +2091,86 @@ extcap_process_config_cb(thread_pool_t *pool _U_, void *data, char *output)
     iface_info->output = output;
 }
 
+void
+extcap_prefetch_if_dlts(GList *ifnames)
+{
+    GPtrArray *tasks;
+    extcap_iface_info_t *iface_infos;
+    thread_pool_t pool;
+    guint i;
+
+    extcap_ensure_all_interfaces_loaded();
+
+    /* Find the extcap interfaces whose DLTs haven't been queried yet. */
+    tasks = g_ptr_array_new();
+    for (GList *walker = ifnames; walker; walker = g_list_next(walker)) {
+        const char *ifname = (const char *)walker->data;
+        extcap_interface *interface = extcap_find_interface_for_ifname(ifname);
+
+        if (!interface || (_dlts_for_ifname && g_hash_table_contains(_dlts_for_ifname, ifname))) {
+            continue;
+        }
+
+        const char *argv[] = {
+            EXTCAP_ARGUMENT_LIST_DLTS,
+            EXTCAP_ARGUMENT_INTERFACE,
+            ifname,
+            NULL
+        };
+        extcap_run_task_t *task = g_new0(extcap_run_task_t, 1);
+
+        task->extcap_path = interface->extcap_path;
+        task->argv = g_strdupv((char **)argv);
+        task->output_cb = extcap_process_config_cb;
+        g_ptr_array_add(tasks, task);
+    }
+
+    /* A single query isn't worth a thread pool. */
+    if (tasks->len < 2) {
+        for (i = 0; i < tasks->len; i++) {
+            extcap_run_task_t *task = (extcap_run_task_t *)g_ptr_array_index(tasks, i);
+            g_strfreev(task->argv);
+            g_free(task);
+        }
+        g_ptr_array_free(tasks, TRUE);
+        return;
+    }
+
+    iface_infos = g_new0(extcap_iface_info_t, tasks->len);
+    pool.pool = g_thread_pool_new(extcap_thread_callback, &pool, (int)g_get_num_processors(), FALSE, NULL);
+    pool.count = 0;
+    g_cond_init(&pool.cond);
+    g_mutex_init(&pool.data_mutex);
+
+    for (i = 0; i < tasks->len; i++) {
+        extcap_run_task_t *task = (extcap_run_task_t *)g_ptr_array_index(tasks, i);
+
+        /* The task, including argv, is freed once it has run. */
+        iface_infos[i].ifname = g_strdup(task->argv[2]);
+        task->data = &iface_infos[i];
+        thread_pool_push(&pool, task, NULL);
+    }
+
+    thread_pool_wait(&pool);
+
+    g_mutex_clear(&pool.data_mutex);
+    g_cond_clear(&pool.cond);
+    g_thread_pool_free(pool.pool, FALSE, TRUE);
+
+    if (!_dlts_for_ifname)
+        _dlts_for_ifname = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    for (i = 0; i < tasks->len; i++) {
+        if (iface_infos[i].output) {
+            /* The table takes ownership of both strings. */
+            g_hash_table_insert(_dlts_for_ifname, iface_infos[i].ifname, iface_infos[i].output);
+        } else {
+            g_free(iface_infos[i].ifname);
+        }
+    }
+    g_free(iface_infos);
+    g_ptr_array_free(tasks, TRUE);
+}
+
 /**
  * Thread callback to process discovered interfaces, scheduling more tasks to
  * retrieve the configuration for each interface. Called once for every extcap
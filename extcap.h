@@ -89,6 +89,16 @@ extcap_register_preferences(void);
 if_capabilities_t *
 extcap_get_if_dlts(const gchar * ifname, char ** err_str);
 
+/**
+ * Queries the capabilities of the named extcap interfaces in parallel, so
+ * that later extcap_get_if_dlts() calls for them don't have to run the
+ * extcap programs one after the other. Names of other interfaces are
+ * ignored. The results are kept until extcap_clear_interfaces() is called.
+ * @param ifnames A list of interface names.
+ */
+void
+extcap_prefetch_if_dlts(GList *ifnames);
+
 /**
  * Append a list of all extcap capture interfaces to the specified list.
  * Initializes the extcap interface list if that hasn't already been done.
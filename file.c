@@ -25,6 +25,7 @@
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/version_info.h>
+#include <wsutil/ws_trace.h>
 
 #include <wiretap/merge.h>
 
@@ -137,6 +138,15 @@ static void cf_rename_failure_alert_box(const char *filename, int err);
 /* Show the progress bar after this many seconds. */
 #define PROGBAR_SHOW_DELAY 0.5
 
+/* Don't keep a frame index for files with fewer records than this. */
+#define FRAME_INDEX_MIN_RECORDS 100000
+
+/* Number of frames ahead of a search for which to prefetch file data. */
+#define FIND_PREFETCH_FRAMES 256
+
+/* Don't hint more than this many bytes at a time. */
+#define PREFETCH_MAX_BYTES (8 * 1024 * 1024)
+
 /*
  * Maximum number of records we support in a file.
  *
@@ -275,6 +285,17 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
     /* Indicate whether it's a permanent or temporary file. */
     cf->is_tempfile = is_tempfile;
 
+    /* If this is a compressed file we've read before, we may have
+       saved its seek points; if so, use them, so that random access
+       doesn't require decompressing from the beginning. */
+    if (!is_tempfile) {
+        gchar *index_path = g_strconcat(fname, WTAP_FAST_SEEK_INDEX_SUFFIX, NULL);
+        int index_err;
+
+        wtap_load_fast_seek_index(wth, index_path, &index_err);
+        g_free(index_path);
+    }
+
     /* No user changes yet. */
     cf->unsaved_changes = FALSE;
 
@@ -296,6 +317,11 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
     /* Allocate a frame_data_sequence for the frames in this file */
     cf->provider.frames = new_frame_data_sequence();
 
+    /* Keep the fields of syscall and log records as they're read, so
+       that they can be filtered and sorted without dissecting them. */
+    event_store_free(cf->event_store);
+    cf->event_store = event_store_new();
+
     nstime_set_zero(&cf->elapsed_time);
     cf->provider.ref = NULL;
     cf->provider.prev_dis = NULL;
@@ -393,6 +419,10 @@ cf_close(capture_file *cf)
         g_tree_destroy(cf->provider.frames_modified_blocks);
         cf->provider.frames_modified_blocks = NULL;
     }
+    field_cache_free(cf->field_cache);
+    cf->field_cache = NULL;
+    event_store_free(cf->event_store);
+    cf->event_store = NULL;
     cf_unselect_packet(cf);   /* nothing to select */
     cf->first_displayed = 0;
     cf->last_displayed = 0;
@@ -495,6 +525,7 @@ cf_read(capture_file *cf, gboolean reloading)
     guint                tap_flags;
     gboolean             compiled _U_;
     volatile gboolean    is_read_aborted = FALSE;
+    volatile gboolean    list_shown = FALSE;
 
     /* The update_progress_dlg call below might end up accepting a user request to
      * trigger redissection/rescans which can modify/destroy the dissection
@@ -520,6 +551,12 @@ cf_read(capture_file *cf, gboolean reloading)
     /* Get the union of the flags for all tap listeners. */
     tap_flags = union_of_tap_listener_flags();
 
+    /* Keep the values of the commonly filtered fields, so that changing
+       to a filter that uses only those doesn't need the frames to be
+       dissected again. */
+    field_cache_free(cf->field_cache);
+    cf->field_cache = field_cache_new();
+
     /*
      * Determine whether we need to create a protocol tree.
      * We do if:
@@ -531,11 +568,14 @@ cf_read(capture_file *cf, gboolean reloading)
      *    one of the tap listeners requires a protocol tree;
      *
      *    a postdissector wants field values or protocols on
-     *    the first pass.
+     *    the first pass;
+     *
+     *    we're caching field values.
      */
     create_proto_tree =
         (dfcode != NULL || have_filtering_tap_listeners() ||
-         (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+         (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+         cf->field_cache != NULL);
 
     reset_tap_listeners();
 
@@ -550,7 +590,8 @@ cf_read(capture_file *cf, gboolean reloading)
        XXX - do we know this at open time? */
     cf->compression_type = wtap_get_compression_type(cf->provider.wth);
 
-    /* The packet list window will be empty until the file is completely loaded */
+    /* The packet list window will be empty until the file is completely
+       loaded, or until loading it turns out to be slow; see below. */
     packet_list_freeze();
 
     cf->stop_flag = FALSE;
@@ -576,6 +617,20 @@ cf_read(capture_file *cf, gboolean reloading)
         cksum = g_checksum_new(G_CHECKSUM_SHA256);
     }
 
+    /* Write a frame index as we read the file, so that other tools can
+       get at its records' offsets, lengths and time stamps without
+       reading it; see below. */
+    wtap_frame_index_writer *volatile frame_index = NULL;
+    volatile guint64 frame_index_records = 0;
+
+    if (!cf->is_tempfile) {
+        gchar *index_path = g_strconcat(cf->filename, WTAP_FRAME_INDEX_SUFFIX, NULL);
+        int index_err;
+
+        frame_index = wtap_frame_index_writer_open(cf->provider.wth, index_path, &index_err);
+        g_free(index_path);
+    }
+
     g_timer_start(prog_timer);
 
     wtap_rec_init(&rec);
@@ -620,7 +675,21 @@ cf_read(capture_file *cf, gboolean reloading)
                     /* update the packet bar content on the first run or frequently on very large files */
                     update_progress_dlg(progbar, progbar_val, status_str);
                     compute_elapsed(cf, start_time);
-                    packets_bar_update();
+                    /*
+                     * If it's slow enough to need a progress bar, show
+                     * the packets read so far, and have the rest added
+                     * as they're read, as during a live capture, rather
+                     * than keeping the list empty until the end.  The
+                     * read lock keeps the list from being sorted and
+                     * rescans are queued until the read is done, and
+                     * the progress bar can stop it at any time.
+                     */
+                    if (!list_shown) {
+                        packet_list_thaw();
+                        list_shown = TRUE;
+                    } else {
+                        packets_bar_update();
+                    }
                     g_timer_start(prog_timer);
                 }
                 /*
@@ -647,6 +716,10 @@ cf_read(capture_file *cf, gboolean reloading)
                    hours even on fast machines) just to see that it was the wrong file. */
                 break;
             }
+            if (frame_index != NULL) {
+                wtap_frame_index_writer_add(frame_index, data_offset, &rec);
+                frame_index_records++;
+            }
             read_record(cf, &rec, &buf, dfcode, &edt, cinfo, data_offset, &frame_dup_cache, cksum);
             wtap_rec_reset(&rec);
         }
@@ -700,6 +773,7 @@ cf_read(capture_file *cf, gboolean reloading)
 
     /* compute the time it took to load the file */
     compute_elapsed(cf, start_time);
+    ws_trace_add("file", "cf_read", start_time, g_get_monotonic_time() - start_time);
 
     /* Set the file encapsulation type now; we don't know what it is until
        we've looked at all the packets, as we don't know until then whether
@@ -707,6 +781,30 @@ cf_read(capture_file *cf, gboolean reloading)
        WTAP_ENCAP_PER_PACKET). */
     cf->lnk_t = wtap_file_encap(cf->provider.wth);
 
+    /* Keep the frame index if we read all of the file and it's big
+       enough for the index to be worth having.  Failing to write it
+       isn't an error. */
+    if (frame_index != NULL) {
+        int index_err;
+
+        wtap_frame_index_writer_close(frame_index,
+                err == 0 && !cf->stop_flag && !too_many_records && !is_read_aborted &&
+                frame_index_records >= FRAME_INDEX_MIN_RECORDS,
+                &index_err);
+    }
+
+    /* If we read all of a compressed file, save its seek points, so
+       that we have them the next time it's opened.  Failing to do so
+       (e.g., because the directory isn't writable) isn't an error. */
+    if (err == 0 && !cf->stop_flag && !too_many_records && !is_read_aborted &&
+        !cf->is_tempfile && cf->compression_type != WTAP_UNCOMPRESSED) {
+        gchar *index_path = g_strconcat(cf->filename, WTAP_FAST_SEEK_INDEX_SUFFIX, NULL);
+        int index_err;
+
+        wtap_save_fast_seek_index(cf->provider.wth, index_path, &index_err);
+        g_free(index_path);
+    }
+
     cf->current_frame = frame_data_sequence_find(cf->provider.frames, cf->first_displayed);
 
     packet_list_thaw();
@@ -1190,11 +1288,41 @@ cf_set_rfcode(capture_file *cf, dfilter_t *rfcode)
     cf->rfcode = rfcode;
 }
 
+static void
+count_displayed_frame(frame_data *fdata, capture_file *cf)
+{
+    if (fdata->passed_dfilter || fdata->ref_time)
+    {
+        cf->displayed_count++;
+
+        frame_data_set_after_dissect(fdata, &cf->cum_bytes);
+        /* The only way we use prev_dis is to get the time stamp of
+         * the previous displayed frame, so ignore it if it doesn't
+         * have a time stamp, because we're presumably interested in
+         * the timestamp of the previously displayed frame with a
+         * time. XXX: What if in the future we want to use the previously
+         * displayed frame for something else, too?
+         */
+        if (fdata->has_ts) {
+            cf->provider.prev_dis = fdata;
+        }
+
+        /* If we haven't yet seen the first frame, this is it. */
+        if (cf->first_displayed == 0)
+            cf->first_displayed = fdata->num;
+
+        /* This is the last frame we've seen so far. */
+        cf->last_displayed = fdata->num;
+    }
+}
+
 static void
 add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
         epan_dissect_t *edt, dfilter_t *dfcode, column_info *cinfo,
         wtap_rec *rec, Buffer *buf, gboolean add_to_packet_list)
 {
+    gboolean first_pass = !fdata->visited;
+
     frame_data_set_before_dissect(fdata, &cf->elapsed_time,
             &cf->provider.ref, cf->provider.prev_dis);
     cf->provider.prev_cap = fdata;
@@ -1202,20 +1330,21 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     if (dfcode != NULL) {
         epan_dissect_prime_with_dfilter(edt, dfcode);
     }
-#if 0
-    /* Prepare coloring rules, this ensures that display filter rules containing
-     * frame.color_rule references are still processed.
-     * TODO: actually detect that situation or maybe apply other optimizations? */
-    if (edt->tree && color_filters_used()) {
+    /* Packets are colorized as the packet list shows them, not here.
+     * The exception is a display filter that tests frame.coloring_rule,
+     * which needs the rules to have been applied before it runs. */
+    if (edt->tree && color_filters_dfilter_uses_rule(dfcode)) {
         color_filters_prime_edt(edt);
         fdata->need_colorize = 1;
     }
-#endif
 
     if (!fdata->visited) {
         /* This is the first pass, so prime the epan_dissect_t with the
            hfids postdissectors want on the first pass. */
         prime_epan_dissect_with_postdissector_wanted_hfids(edt);
+
+        if (cf->field_cache != NULL)
+            field_cache_prime_edt(cf->field_cache, edt);
     }
 
     /* Intitialize passed_dfilter here so that dissectors can hide packets. */
@@ -1227,49 +1356,68 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
             frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
             fdata, cinfo);
 
+    if (first_pass && cf->field_cache != NULL)
+        field_cache_add_frame(cf->field_cache, fdata->num, edt);
+
     if (fdata->passed_dfilter && dfcode != NULL) {
         fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
 
-        if (fdata->passed_dfilter && edt->pi.fd->dependent_frames) {
+        if (fdata->passed_dfilter) {
             /* This frame passed the display filter but it may depend on other
              * (potentially not displayed) frames.  Find those frames and mark them
              * as depended upon.
              */
-            g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+            frame_data_sequence_mark_depended_upon(cf->provider.frames, edt->pi.fd);
         }
     }
 
-    if (fdata->passed_dfilter || fdata->ref_time)
-        cf->displayed_count++;
-
     if (add_to_packet_list) {
         /* We fill the needed columns from new_packet_list */
         packet_list_append(cinfo, fdata);
     }
 
-    if (fdata->passed_dfilter || fdata->ref_time)
-    {
-        frame_data_set_after_dissect(fdata, &cf->cum_bytes);
-        /* The only way we use prev_dis is to get the time stamp of
-         * the previous displayed frame, so ignore it if it doesn't
-         * have a time stamp, because we're presumably interested in
-         * the timestamp of the previously displayed frame with a
-         * time. XXX: What if in the future we want to use the previously
-         * displayed frame for something else, too?
-         */
-        if (fdata->has_ts) {
-            cf->provider.prev_dis = fdata;
-        }
+    count_displayed_frame(fdata, cf);
 
-        /* If we haven't yet seen the first frame, this is it. */
-        if (cf->first_displayed == 0)
-            cf->first_displayed = fdata->num;
+    epan_dissect_reset(edt);
+}
 
-        /* This is the last frame we've seen so far. */
-        cf->last_displayed = fdata->num;
+/*
+ * Apply the display filter to a frame using the values cached when it
+ * was first dissected, rather than reading and dissecting it again.
+ */
+static void
+filter_packet_from_field_cache(frame_data *fdata, capture_file *cf,
+        dfilter_t *dfcode)
+{
+    frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+            &cf->provider.ref, cf->provider.prev_dis);
+    cf->provider.prev_cap = fdata;
+
+    fdata->passed_dfilter = field_cache_apply(cf->field_cache, dfcode, fdata->num) ? 1 : 0;
+
+    if (fdata->passed_dfilter) {
+        /* See add_packet_to_packet_list(). */
+        frame_data_sequence_mark_depended_upon(cf->provider.frames, fdata);
     }
 
-    epan_dissect_reset(edt);
+    count_displayed_frame(fdata, cf);
+}
+
+/*
+ * Filter a frame using the values in the event store, without dissecting
+ * it.
+ */
+static void
+filter_packet_from_event_store(frame_data *fdata, capture_file *cf,
+        dfilter_t *dfcode)
+{
+    frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+            &cf->provider.ref, cf->provider.prev_dis);
+    cf->provider.prev_cap = fdata;
+
+    fdata->passed_dfilter = event_store_apply(cf->event_store, dfcode, fdata->num) ? 1 : 0;
+
+    count_displayed_frame(fdata, cf);
 }
 
 /*
@@ -1326,6 +1474,8 @@ read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
         fdata = frame_data_sequence_add(cf->provider.frames, &fdlocal);
 
         cf->count++;
+        if (cf->event_store != NULL)
+            event_store_add_record(cf->event_store, fdata->num, rec, ws_buffer_start_ptr(buf));
         if (rec->block != NULL)
             cf->packet_comment_count += wtap_block_count_option(rec->block, OPT_COMMENT);
          cf->f_datalen = offset + fdlocal.cap_len;
@@ -1700,6 +1850,8 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     gboolean    compiled _U_;
     guint32     frames_count;
     gboolean    queued_rescan_type = RESCAN_NONE;
+    gboolean    use_field_cache;
+    gboolean    use_event_store;
 
     if (cf->state == FILE_CLOSED || cf->state == FILE_READ_PENDING) {
         return;
@@ -1763,7 +1915,20 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     create_proto_tree =
         (dfcode != NULL || filtering_tap_listeners ||
          (tap_flags & TL_REQUIRES_PROTO_TREE) ||
-         (redissect && postdissectors_want_hfids()));
+         (redissect && (postdissectors_want_hfids() || cf->field_cache != NULL)));
+
+    /*
+     * If we don't have to redissect, and the only thing the dissection
+     * would be needed for is the display filter, and the filter only
+     * uses fields whose values we cached when reading the file, apply
+     * it to those values instead.
+     */
+    use_field_cache = !redissect && cinfo == NULL &&
+        !tap_listeners_require_dissection() &&
+        field_cache_can_apply(cf->field_cache, dfcode, cf->count);
+    use_event_store = !redissect && cinfo == NULL && !use_field_cache &&
+        !tap_listeners_require_dissection() &&
+        event_store_can_apply(cf->event_store, dfcode, cf->count);
 
     reset_tap_listeners();
     /* Which frame, if any, is the currently selected frame?
@@ -1800,6 +1965,12 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
         cf->epan = ws_epan_new(cf);
         cf->cinfo.epan = cf->epan;
 
+        /* The cached field values are redone along with the dissection. */
+        if (cf->field_cache != NULL) {
+            field_cache_free(cf->field_cache);
+            cf->field_cache = field_cache_new();
+        }
+
         /* A new Lua tap listener may be registered in lua_prime_all_fields()
            called via epan_new() / init_dissection() when reloading Lua plugins. */
         if (!create_proto_tree && have_filtering_tap_listeners()) {
@@ -1943,7 +2114,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
         /* Frame dependencies from the previous dissection/filtering are no longer valid. */
         fdata->dependent_of_displayed = 0;
 
-        if (!cf_read_record(cf, fdata, &rec, &buf))
+        if (!use_field_cache && !use_event_store && !cf_read_record(cf, fdata, &rec, &buf))
             break; /* error reading the frame */
 
         /* If the previous frame is displayed, and we haven't yet seen the
@@ -1954,9 +2125,14 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
             preceding_frame = prev_frame;
         }
 
-        add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                cinfo, &rec, &buf,
-                add_to_packet_list);
+        if (use_field_cache)
+            filter_packet_from_field_cache(fdata, cf, dfcode);
+        else if (use_event_store)
+            filter_packet_from_event_store(fdata, cf, dfcode);
+        else
+            add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                    cinfo, &rec, &buf,
+                    add_to_packet_list);
 
         /* If this frame is displayed, and this is the first frame we've
            seen displayed after the selected frame, remember this frame -
@@ -2015,6 +2191,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
 
     /* Compute the time it took to filter the file */
     compute_elapsed(cf, start_time);
+    ws_trace_add("file", "rescan_packets", start_time, g_get_monotonic_time() - start_time);
 
     packet_list_thaw();
 
@@ -2197,15 +2374,25 @@ typedef enum {
     PSP_FAILED
 } psp_return_t;
 
+/*
+ * Process the records in a range, or, if frames isn't NULL, only the
+ * num_frames records with those frame numbers (in increasing order).
+ *
+ * If skip_read isn't NULL, records for which it returns TRUE aren't
+ * read, and are passed to the callback with a null rec and buf.
+ */
 static psp_return_t
-process_specified_records(capture_file *cf, packet_range_t *range,
+process_records(capture_file *cf, packet_range_t *range,
+        const guint32 *frames, guint num_frames,
         const char *string1, const char *string2, gboolean terminate_is_stop,
         gboolean (*callback)(capture_file *, frame_data *,
             wtap_rec *, Buffer *, void *),
+        gboolean (*skip_read)(capture_file *, frame_data *, void *),
         void *callback_args,
         gboolean show_progress_bar)
 {
     guint32          framenum;
+    guint32          total, idx;
     frame_data      *fdata;
     wtap_rec         rec;
     Buffer           buf;
@@ -2238,9 +2425,14 @@ process_specified_records(capture_file *cf, packet_range_t *range,
     if (range != NULL)
         packet_range_process_init(range);
 
+    total = (frames != NULL) ? num_frames : cf->count;
+
     /* Iterate through all the packets, printing the packets that
        were selected by the current display filter.  */
-    for (framenum = 1; framenum <= cf->count; framenum++) {
+    for (idx = 0; idx < total; idx++) {
+        framenum = (frames != NULL) ? frames[idx] : idx + 1;
+        if (framenum == 0 || framenum > cf->count)
+            continue;
         fdata = frame_data_sequence_find(cf->provider.frames, framenum);
 
         /* Create the progress bar if necessary.
@@ -2264,11 +2456,11 @@ process_specified_records(capture_file *cf, packet_range_t *range,
             /* let's not divide by zero. I should never be started
              * with count == 0, so let's assert that
              */
-            ws_assert(cf->count > 0);
-            progbar_val = (gfloat) progbar_count / cf->count;
+            ws_assert(total > 0);
+            progbar_val = (gfloat) progbar_count / total;
 
             snprintf(progbar_status_str, sizeof(progbar_status_str),
-                    "%4u of %u packets", progbar_count, cf->count);
+                    "%4u of %u packets", progbar_count, total);
             update_progress_dlg(progbar, progbar_val, progbar_status_str);
 
             g_timer_start(prog_timer);
@@ -2296,6 +2488,14 @@ process_specified_records(capture_file *cf, packet_range_t *range,
             }
         }
 
+        if (skip_read != NULL && skip_read(cf, fdata, callback_args)) {
+            if (!callback(cf, fdata, NULL, NULL, callback_args)) {
+                ret = PSP_FAILED;
+                break;
+            }
+            continue;
+        }
+
         /* Get the packet */
         if (!cf_read_record(cf, fdata, &rec, &buf)) {
             /* Attempt to get the packet failed. */
@@ -2326,6 +2526,18 @@ process_specified_records(capture_file *cf, packet_range_t *range,
     return ret;
 }
 
+static psp_return_t
+process_specified_records(capture_file *cf, packet_range_t *range,
+        const char *string1, const char *string2, gboolean terminate_is_stop,
+        gboolean (*callback)(capture_file *, frame_data *,
+            wtap_rec *, Buffer *, void *),
+        void *callback_args,
+        gboolean show_progress_bar)
+{
+    return process_records(cf, range, NULL, 0, string1, string2,
+            terminate_is_stop, callback, NULL, callback_args, show_progress_bar);
+}
+
 typedef struct {
     epan_dissect_t edt;
     column_info *cinfo;
@@ -2345,8 +2557,8 @@ retap_packet(capture_file *cf, frame_data *fdata, wtap_rec *rec, Buffer *buf,
     return TRUE;
 }
 
-cf_read_status_t
-cf_retap_packets(capture_file *cf)
+static cf_read_status_t
+retap_packets(capture_file *cf, const guint32 *frames, guint num_frames)
 {
     packet_range_t        range;
     retap_callback_args_t callback_args;
@@ -2354,12 +2566,15 @@ cf_retap_packets(capture_file *cf)
     gboolean              filtering_tap_listeners;
     guint                 tap_flags;
     psp_return_t          ret;
+    gint64                trace_start;
 
     /* Presumably the user closed the capture file. */
     if (cf == NULL) {
         return CF_READ_ABORTED;
     }
 
+    trace_start = ws_trace_begin();
+
     cf_callback_invoke(cf_cb_file_retap_started, cf);
 
     /* Do we have any tap listeners with filters? */
@@ -2399,13 +2614,16 @@ cf_retap_packets(capture_file *cf)
     packet_range_init(&range, cf);
     packet_range_process_init(&range);
 
-    ret = process_specified_records(cf, &range, "Recalculating statistics on",
-            "all packets", TRUE, retap_packet,
-            &callback_args, TRUE);
+    ret = process_records(cf, &range, frames, num_frames,
+            "Recalculating statistics on",
+            (frames != NULL) ? "selected packets" : "all packets", TRUE,
+            retap_packet, NULL, &callback_args, TRUE);
 
     packet_range_cleanup(&range);
     epan_dissect_cleanup(&callback_args.edt);
 
+    ws_trace_end("file", "cf_retap_packets", trace_start);
+
     cf_callback_invoke(cf_cb_file_retap_finished, cf);
 
     switch (ret) {
@@ -2427,6 +2645,25 @@ cf_retap_packets(capture_file *cf)
     return CF_READ_OK;
 }
 
+cf_read_status_t
+cf_retap_packets(capture_file *cf)
+{
+    return retap_packets(cf, NULL, 0);
+}
+
+cf_read_status_t
+cf_retap_packets_for_frames(capture_file *cf, const guint32 *frames, guint num_frames)
+{
+    /*
+     * Every tap listener is reset by a retap, so the others would be
+     * left with only these frames; retap everything for them.
+     */
+    if (frames == NULL || tap_listeners_count() > 1)
+        return retap_packets(cf, NULL, 0);
+
+    return retap_packets(cf, frames, num_frames);
+}
+
 typedef struct {
     print_args_t *print_args;
     gboolean      print_header_line;
@@ -3517,6 +3754,8 @@ typedef struct {
     const guint8 *data;
     size_t        data_len;
     ws_mempbrk_pattern *pattern;
+    const guint8 *wide_data;    /* data interleaved with \0, for ws_memmem */
+    size_t        wide_data_len;
 } cbs_t;    /* "Counted byte string" */
 
 
@@ -3543,9 +3782,28 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
     guint8 needles[3];
     ws_mempbrk_pattern pattern = {0};
     ws_match_function match_function;
+    guint8 *wide_string = NULL;
+    gboolean found;
 
     info.data = string;
     info.data_len = string_size;
+    info.pattern = NULL;
+    info.wide_data = NULL;
+    info.wide_data_len = 0;
+
+    /*
+     * The case sensitive UTF-16 matches are plain byte matches of the
+     * string with \0 after every character but the last, so let them
+     * use ws_memmem instead of comparing one byte at a time.
+     */
+    if (cf->string && !cf->case_type && string_size > 0) {
+        wide_string = (guint8 *)g_malloc0(string_size * 2 - 1);
+        for (size_t i = 0; i < string_size; i++) {
+            wide_string[i * 2] = string[i];
+        }
+        info.wide_data = wide_string;
+        info.wide_data_len = string_size * 2 - 1;
+    }
 
     /* Regex, String or hex search? */
     if (cf->regex) {
@@ -3597,6 +3855,7 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
 
                 default:
                     ws_assert_not_reached();
+                    g_free(wide_string);
                     return FALSE;
             }
         }
@@ -3621,12 +3880,15 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
                 packet_list_select_row_from_data(cf->current_frame);
             }
             cf->search_in_progress = FALSE;
+            g_free(wide_string);
             return TRUE;
         }
     }
     cf->search_pos = 0; /* Reset the position */
     cf->search_len = 0; /* Reset length */
-    return find_packet(cf, match_function, &info, dir);
+    found = find_packet(cf, match_function, &info, dir);
+    g_free(wide_string);
+    return found;
 }
 
 static match_result
@@ -3634,14 +3896,12 @@ match_narrow_and_wide(capture_file *cf, frame_data *fdata,
         wtap_rec *rec, Buffer *buf, void *criterion)
 {
     cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
     size_t        textlen    = info->data_len;
+    size_t        widelen    = info->wide_data_len;
     match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
+    const guint8 *pd, *wide_pd, *buf_start;
+    size_t        offset     = 0;
+    size_t        wide_end;
 
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -3650,57 +3910,39 @@ match_narrow_and_wide(capture_file *cf, frame_data *fdata,
     }
 
     result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
     buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_start;
     if (cf->search_len || cf->search_pos) {
         /* we want to start searching one byte past the previous match start */
-        pd += cf->search_pos + 1;
+        offset = cf->search_pos + 1;
+    }
+    if (offset >= fdata->cap_len) {
+        return result;
     }
-    for (; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
-        if (pd == NULL) break;
-        /* Try narrow match at this start location */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-            } else {
-                break;
-            }
-        }
 
-        /* Now try wide match at the same start location. */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
-        }
+    pd = ws_memmem(buf_start + offset, fdata->cap_len - offset, info->data, textlen);
+
+    /* A wide match wins if it starts before the narrow one. */
+    wide_end = fdata->cap_len;
+    if (pd != NULL) {
+        wide_end = MIN(wide_end, (size_t)(pd - buf_start) + widelen - 1);
+    }
+    wide_pd = NULL;
+    if (wide_end > offset) {
+        wide_pd = ws_memmem(buf_start + offset, wide_end - offset, info->wide_data, widelen);
+    }
+
+    if (wide_pd != NULL) {
+        result = MR_MATCHED;
+        /* Save position and length for highlighting the field. */
+        cf->search_pos = (uint32_t)(wide_pd - buf_start);
+        cf->search_len = (uint32_t)widelen;
+    } else if (pd != NULL) {
+        result = MR_MATCHED;
+        /* Save position and length for highlighting the field. */
+        cf->search_pos = (uint32_t)(pd - buf_start);
+        cf->search_len = (uint32_t)textlen;
     }
 
-done:
     return result;
 }
 
@@ -4068,14 +4310,10 @@ match_wide(capture_file *cf, frame_data *fdata,
         wtap_rec *rec, Buffer *buf, void *criterion)
 {
     cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
+    size_t        widelen    = info->wide_data_len;
     match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
+    const guint8 *pd = NULL, *buf_start;
+    size_t        offset     = 0;
 
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -4084,38 +4322,21 @@ match_wide(capture_file *cf, frame_data *fdata,
     }
 
     result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
     buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_start;
     if (cf->search_len || cf->search_pos) {
         /* we want to start searching one byte past the previous match start */
-        pd += cf->search_pos + 1;
+        offset = cf->search_pos + 1;
     }
-    for (; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
-        if (pd == NULL) break;
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
-        }
+    if (offset < fdata->cap_len) {
+        pd = ws_memmem(buf_start + offset, fdata->cap_len - offset, info->wide_data, widelen);
+    }
+    if (pd != NULL) {
+        result = MR_MATCHED;
+        /* Save position and length for highlighting the field. */
+        cf->search_pos = (uint32_t)(pd - buf_start);
+        cf->search_len = (uint32_t)widelen;
     }
 
-done:
     return result;
 }
 
@@ -4535,6 +4756,45 @@ match_time_reference(capture_file *cf _U_, frame_data *fdata, wtap_rec *rec _U_,
     return fdata->ref_time ? MR_MATCHED : MR_NOTMATCHED;
 }
 
+void
+cf_prefetch_frames(capture_file *cf, guint32 first, guint32 last)
+{
+    frame_data *fdata;
+    gint64      start, end;
+    guint32     framenum;
+
+    if (cf->provider.wth == NULL || cf->provider.frames == NULL)
+        return;
+    if (first < 1)
+        first = 1;
+    if (last > cf->count)
+        last = cf->count;
+    if (first > last)
+        return;
+
+    start = G_MAXINT64;
+    end = 0;
+    for (framenum = first; framenum <= last; framenum++) {
+        fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        if (fdata == NULL)
+            continue;
+        if (fdata->file_off < start)
+            start = fdata->file_off;
+        /*
+         * We don't know how big the record header is; assume that
+         * the next record's data is close enough behind this one's
+         * that a page or so of slack covers it.
+         */
+        if (fdata->file_off + fdata->cap_len + 4096 > end)
+            end = fdata->file_off + fdata->cap_len + 4096;
+    }
+    if (start >= end)
+        return;
+    if (end - start > PREFETCH_MAX_BYTES)
+        end = start + PREFETCH_MAX_BYTES;
+    wtap_prefetch(cf->provider.wth, start, end - start);
+}
+
 static gboolean
 find_packet(capture_file *cf, ws_match_function match_function,
         void *criterion, search_direction dir)
@@ -4649,6 +4909,15 @@ find_packet(capture_file *cf, ws_match_function match_function,
                 framenum++;
         }
 
+        /* Get the OS reading in the frames we're about to look at. */
+        if (count % FIND_PREFETCH_FRAMES == 0) {
+            if (dir == SD_BACKWARD)
+                cf_prefetch_frames(cf, framenum > FIND_PREFETCH_FRAMES ?
+                        framenum - FIND_PREFETCH_FRAMES : 1, framenum);
+            else
+                cf_prefetch_frames(cf, framenum, framenum + FIND_PREFETCH_FRAMES);
+        }
+
         fdata = frame_data_sequence_find(cf->provider.frames, framenum);
         count++;
 
@@ -5095,17 +5364,123 @@ cf_add_ip_name_from_string(capture_file *cf, const char *addr, const char *name)
     return TRUE;
 }
 
+/*
+ * Records copied unchanged are read and written in runs of up to this
+ * many bytes of contiguous records (or one record, if it's bigger).
+ */
+#define SAVE_RAW_MAX_RUN (4 * 1024 * 1024)
+
 typedef struct {
     wtap_dumper *pdh;
     const char  *fname;
     int          file_type;
     gboolean     export;
+    gboolean     copy_raw;      /* copy unchanged records as they are */
+    gint64       raw_start;     /* offset of the run of records to copy */
+    gint64       raw_end;       /* offset just past that run */
+    guint32      raw_framenum;  /* first frame in that run */
+    Buffer       raw_buf;
 } save_callback_args_t;
 
+static void
+save_args_init(save_callback_args_t *args, capture_file *cf,
+        wtap_dumper *pdh, const char *fname, int file_type, gboolean copy_raw)
+{
+    args->pdh = pdh;
+    args->fname = fname;
+    args->file_type = file_type;
+    args->copy_raw = copy_raw && wtap_dump_can_copy_raw(pdh, cf->provider.wth);
+    args->raw_start = 0;
+    args->raw_end = 0;
+    args->raw_framenum = 0;
+    ws_buffer_init(&args->raw_buf, 0);
+}
+
+/*
+ * Write out the pending run of records to copy unchanged, if any.
+ */
+static gboolean
+save_raw_flush(capture_file *cf, save_callback_args_t *args)
+{
+    guint8       *data;
+    unsigned int  len;
+    int           err;
+    gchar        *err_info;
+
+    if (args->raw_end == args->raw_start)
+        return TRUE;
+
+    len = (unsigned int)(args->raw_end - args->raw_start);
+    ws_buffer_clean(&args->raw_buf);
+    ws_buffer_assure_space(&args->raw_buf, len);
+    data = ws_buffer_start_ptr(&args->raw_buf);
+    if (!wtap_read_raw(cf->provider.wth, args->raw_start, data, len,
+                &err, &err_info)) {
+        cfile_read_failure_alert_box(cf->filename, err, err_info);
+        return FALSE;
+    }
+    if (!wtap_dump_raw(args->pdh, data, len, &err, &err_info)) {
+        cfile_write_failure_alert_box(NULL, args->fname, err, err_info,
+                args->raw_framenum, args->file_type);
+        return FALSE;
+    }
+    args->raw_start = args->raw_end;
+    return TRUE;
+}
+
+/*
+ * Can a record be copied as it is, rather than being read and written
+ * out again?  Only if the user hasn't changed anything in it.
+ */
+static gboolean
+save_record_can_copy_raw(capture_file *cf _U_, frame_data *fdata, void *argsp)
+{
+    save_callback_args_t *args = (save_callback_args_t *)argsp;
+    nstime_t      shift_offset;
+
+    if (!args->copy_raw || fdata->has_modified_block)
+        return FALSE;
+    frame_data_get_shift_offset(fdata, &shift_offset);
+    return nstime_is_zero(&shift_offset);
+}
+
+/*
+ * Add a record to the run of records to copy unchanged, writing out
+ * the run first if the record doesn't follow it in the file or the
+ * run is long enough.
+ */
+static gboolean
+save_record_raw(capture_file *cf, frame_data *fdata,
+        save_callback_args_t *args)
+{
+    guint32       len;
+    int           err;
+    gchar        *err_info;
+
+    if (!wtap_raw_record_len(cf->provider.wth, fdata->file_off, &len,
+                &err, &err_info)) {
+        cfile_read_failure_alert_box(cf->filename, err, err_info);
+        return FALSE;
+    }
+    if (fdata->file_off != args->raw_end ||
+            args->raw_end - args->raw_start + len > SAVE_RAW_MAX_RUN) {
+        if (!save_raw_flush(cf, args))
+            return FALSE;
+        args->raw_start = fdata->file_off;
+        args->raw_end = fdata->file_off;
+        args->raw_framenum = fdata->num;
+    }
+    args->raw_end += len;
+    return TRUE;
+}
+
 /*
  * Save a capture to a file, in a particular format, saving either
  * all packets, all currently-displayed packets, or all marked packets.
  *
+ * If rec is NULL, the record wasn't read, because it can be copied
+ * unchanged.
+ *
  * Returns TRUE if it succeeds, FALSE otherwise; if it fails, it pops
  * up a message box for the failure.
  */
@@ -5115,10 +5490,19 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec,
 {
     save_callback_args_t *args = (save_callback_args_t *)argsp;
     wtap_rec      new_rec;
+    nstime_t      shift_offset;
     int           err;
     gchar        *err_info;
     wtap_block_t pkt_block;
 
+    if (rec == NULL)
+        return save_record_raw(cf, fdata, args);
+
+    /* Records must be written in order, so write out any we're copying
+       before this one. */
+    if (!save_raw_flush(cf, args))
+        return FALSE;
+
     /* Copy the record information from what was read in from the file. */
     new_rec = *rec;
 
@@ -5131,9 +5515,10 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec,
     new_rec.block  = pkt_block;
     new_rec.block_was_modified = fdata->has_modified_block ? TRUE : FALSE;
 
-    if (!nstime_is_zero(&fdata->shift_offset)) {
+    frame_data_get_shift_offset(fdata, &shift_offset);
+    if (!nstime_is_zero(&shift_offset)) {
         if (new_rec.presence_flags & WTAP_HAS_TS) {
-            nstime_add(&new_rec.ts, &fdata->shift_offset);
+            nstime_add(&new_rec.ts, &shift_offset);
         }
     }
 
@@ -5156,12 +5541,32 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec,
      * If we're exporting to a different file, then don't do that.
      */
     if (!args->export && new_rec.presence_flags & WTAP_HAS_TS) {
-        nstime_set_zero(&fdata->shift_offset);
+        nstime_set_zero(&shift_offset);
+        frame_data_set_shift_offset(fdata, &shift_offset);
     }
 
     return TRUE;
 }
 
+/*
+ * Save the records in a range, or all records if range is NULL, copying
+ * the ones that haven't been changed unchanged if we can.
+ */
+static psp_return_t
+save_records(capture_file *cf, packet_range_t *range,
+        const char *string1, const char *string2,
+        save_callback_args_t *args)
+{
+    psp_return_t ret;
+
+    ret = process_records(cf, range, NULL, 0, string1, string2, TRUE,
+            save_record, save_record_can_copy_raw, args, TRUE);
+    if (ret == PSP_FINISHED && !save_raw_flush(cf, args))
+        ret = PSP_FAILED;
+    ws_buffer_free(&args->raw_buf);
+    return ret;
+}
+
 /*
  * Can this capture file be written out in any format using Wiretap
  * rather than by copying the raw data?
@@ -5601,12 +6006,12 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
         /* Add address resolution */
         wtap_dump_set_addrinfo_list(pdh, addr_lists);
 
-        /* Iterate through the list of packets, processing all the packets. */
-        callback_args.pdh = pdh;
-        callback_args.fname = fname;
-        callback_args.file_type = save_format;
-        switch (process_specified_records(cf, NULL, "Saving", "packets",
-                    TRUE, save_record, &callback_args, TRUE)) {
+        /* Iterate through the list of packets, processing all the packets.
+           If we're discarding comments, write the records out again, so
+           that the comments in them are discarded as well. */
+        save_args_init(&callback_args, cf, pdh, fname, save_format,
+                !discard_comments);
+        switch (save_records(cf, NULL, "Saving", "packets", &callback_args)) {
 
             case PSP_FINISHED:
                 /* Completed successfully. */
@@ -5863,15 +6268,16 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
     /* Iterate through the list of packets, processing the packets we were
        told to process.
 
+       Records the user hasn't changed are copied as they are if the
+       file is being written in the format it's in.
+
        XXX - we've already called "packet_range_process_init(range)", but
-       "process_specified_records()" will do it again.  Fortunately,
+       "save_records()" will do it again.  Fortunately,
        that's harmless in this case, as we haven't done anything to
        "range" since we initialized it. */
-    callback_args.pdh = pdh;
-    callback_args.fname = fname;
-    callback_args.file_type = save_format;
-    switch (process_specified_records(cf, range, "Writing", "specified records",
-                TRUE, save_record, &callback_args, TRUE)) {
+    save_args_init(&callback_args, cf, pdh, fname, save_format, TRUE);
+    switch (save_records(cf, range, "Writing", "specified records",
+                &callback_args)) {
 
         case PSP_FINISHED:
             /* Completed successfully. */
@@ -5897,7 +6303,7 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
             wtap_dump_close(pdh, NULL, &err, &err_info);
             /*
              * We don't report any error from closing; the error that caused
-             * process_specified_records() to fail has already been reported.
+             * save_records() to fail has already been reported.
              */
             goto fail;
     }
@@ -427,6 +427,19 @@ void cf_redissect_packets(capture_file *cf);
  */
 cf_read_status_t cf_retap_packets(capture_file *cf);
 
+/**
+ * Run taps on only some of the packets, e.g. the frames of one conversation
+ * (see conversation_get_frames()), for a tap listener that is only
+ * interested in them. If other tap listeners are registered, all packets
+ * are retapped, as for cf_retap_packets().
+ *
+ * @param cf the capture file
+ * @param frames the frame numbers, in increasing order
+ * @param num_frames the number of frame numbers
+ * @return one of cf_read_status_t
+ */
+cf_read_status_t cf_retap_packets_for_frames(capture_file *cf, const guint32 *frames, guint num_frames);
+
 /* print_range, enum which frames should be printed */
 typedef enum {
     print_range_selected_only,    /* selected frame(s) only (currently only one) */
@@ -599,6 +612,17 @@ gboolean cf_find_packet_marked(capture_file *cf, search_direction dir);
  */
 gboolean cf_find_packet_time_reference(capture_file *cf, search_direction dir);
 
+/**
+ * Hint that the data for a range of frames will soon be read, so that
+ * it can be read in ahead of time.  This never fails, and does nothing
+ * if the capture file is compressed.
+ *
+ * @param cf the capture file
+ * @param first the number of the first frame
+ * @param last the number of the last frame
+ */
+void cf_prefetch_frames(capture_file *cf, guint32 first, guint32 last);
+
 /**
  * GoTo Packet with the given row.
  *
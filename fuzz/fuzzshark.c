@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <errno.h>
 
 #include <glib.h>
 
@@ -23,9 +24,13 @@
 
 #include <wsutil/cmdarg_err.h>
 #include <ui/failure_message.h>
+#include <wsutil/file_util.h>
 #include <wsutil/filesystem.h>
+#include <wsutil/json_dumper.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
+#include <wsutil/time_util.h>
+#include <wsutil/wmem/wmem.h>
 #include <wsutil/wslog.h>
 #include <wsutil/version_info.h>
 
@@ -52,6 +57,27 @@ static column_info fuzz_cinfo;
 static epan_t *fuzz_epan;
 static epan_dissect_t *fuzz_edt;
 
+/*
+ * Benchmark mode (--bench=N): every input of the corpus is dissected N
+ * times with the selected dissector, and the time and packet pool use
+ * per input are written as JSON in the format of Google Benchmark, so
+ * that runs can be compared with its compare.py and similar tools.
+ */
+#define BENCH_SLOWEST_INPUTS 10
+
+typedef struct {
+	char *name;
+	guint8 *data;
+	size_t len;
+	double real_nsecs;	/* per run */
+	double cpu_nsecs;	/* per run */
+	size_t pool_bytes;	/* packet pool use of one run */
+} bench_input_t;
+
+static int bench_runs;
+static const char *bench_json_path;
+static const char *bench_target;
+
 /*
  * Report an error in command-line arguments.
  */
@@ -210,6 +236,11 @@ fuzz_init(int argc _U_, char **argv)
 "crash. Mode (2) can be used if a dissector (such as 'ospf') is not available\n"
 "through (1).\n"
 "\n"
+"With --bench=N [--bench-json=FILE] the inputs (files or directories of\n"
+"files) are instead each dissected N times, and the time and packet pool\n"
+"bytes per input are written as Google Benchmark JSON:\n"
+"      FUZZSHARK_TARGET=dns %s --bench=100 corpus-dir\n"
+"\n"
 "For best results, build dedicated fuzzshark_* targets with:\n"
 "    cmake -GNinja -DCMAKE_C_COMPILER=clang -DCMAKE_CXX_COMPILER=clang++\\\n"
 "      -DENABLE_FUZZER=1 -DENABLE_ASAN=1 -DENABLE_UBSAN=1\n"
@@ -217,7 +248,7 @@ fuzz_init(int argc _U_, char **argv)
 "These options enable LibFuzzer which makes fuzzing possible as opposed to\n"
 "running dissectors only once with a sample (as is the case with this fuzzshark"
 "binary). These fuzzshark_* targets are also used by oss-fuzz.\n",
-			argv[0], argv[0]);
+			argv[0], argv[0], argv[0]);
 		return 1;
 	}
 #endif
@@ -234,7 +265,10 @@ fuzz_init(int argc _U_, char **argv)
 	g_setenv("XDG_CONFIG_HOME", "/not/existing/directory", 0); /* g_get_user_config_dir() */
 	g_setenv("XDG_DATA_HOME", "/not/existing/directory", 0);   /* g_get_user_data_dir() */
 
-	g_setenv("WIRESHARK_DEBUG_WMEM_OVERRIDE", "simple", 0);
+	/* The benchmark measures the packet pool, which the simple
+	 * allocator doesn't keep statistics for. */
+	if (bench_runs == 0)
+		g_setenv("WIRESHARK_DEBUG_WMEM_OVERRIDE", "simple", 0);
 	g_setenv("G_SLICE", "always-malloc", 0);
 
 	cmdarg_err_init(fuzzshark_cmdarg_err, fuzzshark_cmdarg_err_cont);
@@ -324,18 +358,22 @@ fuzz_init(int argc _U_, char **argv)
 # define FUZZ_EPAN 1
 	fprintf(stderr, "oss-fuzzshark: configured for dissector: %s in table: %s\n", fuzz_target, FUZZ_DISSECTOR_TABLE);
 	fuzz_handle = get_dissector_handle(FUZZ_DISSECTOR_TABLE, fuzz_target);
+	bench_target = FUZZ_DISSECTOR_TABLE "-" FUZZ_DISSECTOR_TARGET;
 
 #elif defined(FUZZ_DISSECTOR_TARGET)
 # define FUZZ_EPAN 2
 	fprintf(stderr, "oss-fuzzshark: configured for dissector: %s\n", fuzz_target);
 	fuzz_handle = get_dissector_handle(NULL, fuzz_target);
+	bench_target = fuzz_target;
 
 #else
 # define FUZZ_EPAN 3
 	if (fuzz_table) {
 		fprintf(stderr, "oss-fuzzshark: requested dissector: %s in table %s\n", fuzz_target, fuzz_table);
+		bench_target = g_strdup_printf("%s-%s", fuzz_table, fuzz_target);
 	} else {
 		fprintf(stderr, "oss-fuzzshark: requested dissector: %s\n", fuzz_target);
+		bench_target = fuzz_target;
 	}
 	fuzz_handle = get_dissector_handle(fuzz_table, fuzz_target);
 #endif
@@ -356,11 +394,16 @@ clean_exit:
 }
 
 #ifdef FUZZ_EPAN
-int
-LLVMFuzzerTestOneInput(const guint8 *buf, size_t real_len)
+/*
+ * Dissect one input, and return the number of bytes it used from the
+ * packet pool.
+ */
+static size_t
+fuzz_dissect_one(const guint8 *buf, size_t real_len)
 {
 	static guint32 framenum = 0;
 	epan_dissect_t *edt = fuzz_edt;
+	wmem_allocator_stats_t stats;
 
 	guint32 len = (guint32) real_len;
 
@@ -382,23 +425,308 @@ LLVMFuzzerTestOneInput(const guint8 *buf, size_t real_len)
 	epan_dissect_run(edt, WTAP_FILE_TYPE_SUBTYPE_UNKNOWN, &rec, tvb_new_real_data(buf, len, len), &fdlocal, NULL /* &fuzz_cinfo */);
 	frame_data_destroy(&fdlocal);
 
+	wmem_get_stats(edt->pi.pool, &stats);
 	epan_dissect_reset(edt);
+	return stats.in_use;
+}
+
+int
+LLVMFuzzerTestOneInput(const guint8 *buf, size_t real_len)
+{
+	fuzz_dissect_one(buf, real_len);
 	return 0;
 }
 
+static void
+bench_input_free(gpointer data)
+{
+	bench_input_t *input = (bench_input_t *) data;
+
+	g_free(input->name);
+	g_free(input->data);
+	g_free(input);
+}
+
+static gboolean
+bench_add_file(GPtrArray *inputs, const char *path)
+{
+	bench_input_t *input = g_new0(bench_input_t, 1);
+	GError *err = NULL;
+	gchar *contents;
+	gsize len;
+
+	if (!g_file_get_contents(path, &contents, &len, &err)) {
+		fprintf(stderr, "oss-fuzzshark: %s\n", err->message);
+		g_error_free(err);
+		g_free(input);
+		return FALSE;
+	}
+	input->name = g_path_get_basename(path);
+	input->data = (guint8 *) contents;
+	input->len = len;
+	g_ptr_array_add(inputs, input);
+	return TRUE;
+}
+
+/* Add a file, or the files in a directory (as libFuzzer corpora are). */
+static gboolean
+bench_add_path(GPtrArray *inputs, const char *path)
+{
+	GDir *dir;
+	const char *name;
+	gboolean ok = TRUE;
+
+	if (!g_file_test(path, G_FILE_TEST_IS_DIR))
+		return bench_add_file(inputs, path);
+
+	dir = g_dir_open(path, 0, NULL);
+	if (dir == NULL) {
+		fprintf(stderr, "oss-fuzzshark: can't open directory %s\n", path);
+		return FALSE;
+	}
+	while (ok && (name = g_dir_read_name(dir)) != NULL) {
+		char *file = g_build_filename(path, name, NULL);
+
+		if (g_file_test(file, G_FILE_TEST_IS_REGULAR))
+			ok = bench_add_file(inputs, file);
+		g_free(file);
+	}
+	g_dir_close(dir);
+	return ok;
+}
+
+static int
+bench_compare_names(gconstpointer a, gconstpointer b)
+{
+	const bench_input_t *ia = *(const bench_input_t * const *) a;
+	const bench_input_t *ib = *(const bench_input_t * const *) b;
+
+	return strcmp(ia->name, ib->name);
+}
+
+static int
+bench_compare_slowest(gconstpointer a, gconstpointer b)
+{
+	const bench_input_t *ia = *(const bench_input_t * const *) a;
+	const bench_input_t *ib = *(const bench_input_t * const *) b;
+
+	if (ia->real_nsecs != ib->real_nsecs)
+		return ia->real_nsecs < ib->real_nsecs ? 1 : -1;
+	return strcmp(ia->name, ib->name);
+}
+
+static void
+bench_dump_result(json_dumper *dumper, const char *name, int iterations,
+    double real_nsecs, double cpu_nsecs, double bytes, double pool_bytes)
+{
+	json_dumper_begin_object(dumper);
+	json_dumper_set_member_name(dumper, "name");
+	json_dumper_value_string(dumper, name);
+	json_dumper_set_member_name(dumper, "run_name");
+	json_dumper_value_string(dumper, name);
+	json_dumper_set_member_name(dumper, "run_type");
+	json_dumper_value_string(dumper, "iteration");
+	json_dumper_set_member_name(dumper, "repetitions");
+	json_dumper_value_anyf(dumper, "1");
+	json_dumper_set_member_name(dumper, "repetition_index");
+	json_dumper_value_anyf(dumper, "0");
+	json_dumper_set_member_name(dumper, "threads");
+	json_dumper_value_anyf(dumper, "1");
+	json_dumper_set_member_name(dumper, "iterations");
+	json_dumper_value_anyf(dumper, "%d", iterations);
+	json_dumper_set_member_name(dumper, "real_time");
+	json_dumper_value_double(dumper, real_nsecs);
+	json_dumper_set_member_name(dumper, "cpu_time");
+	json_dumper_value_double(dumper, cpu_nsecs);
+	json_dumper_set_member_name(dumper, "time_unit");
+	json_dumper_value_string(dumper, "ns");
+	json_dumper_set_member_name(dumper, "bytes_per_second");
+	json_dumper_value_double(dumper, real_nsecs > 0 ? bytes * 1e9 / real_nsecs : 0);
+	json_dumper_set_member_name(dumper, "input_bytes");
+	json_dumper_value_double(dumper, bytes);
+	json_dumper_set_member_name(dumper, "pool_bytes");
+	json_dumper_value_double(dumper, pool_bytes);
+	json_dumper_end_object(dumper);
+}
+
+/*
+ * Run the benchmark over the inputs named on the command line, write the
+ * results and return the exit status.
+ */
+static int
+bench_run(int argc, char **argv)
+{
+	GPtrArray *inputs = g_ptr_array_new_with_free_func(bench_input_free);
+	json_dumper dumper = { 0 };
+	FILE *output = stdout;
+	double total_real = 0, total_cpu = 0, total_bytes = 0, total_pool = 0;
+	GDateTime *now;
+	char *date;
+	int i;
+	guint j;
+	int ret = EXIT_SUCCESS;
+
+	for (i = 1; i < argc; i++) {
+		/* Skip libFuzzer flags. */
+		if (argv[i][0] == '-')
+			continue;
+		if (!bench_add_path(inputs, argv[i])) {
+			g_ptr_array_free(inputs, TRUE);
+			return EXIT_FAILURE;
+		}
+	}
+	if (inputs->len == 0) {
+		fprintf(stderr, "oss-fuzzshark: no inputs to benchmark\n");
+		g_ptr_array_free(inputs, TRUE);
+		return EXIT_FAILURE;
+	}
+	g_ptr_array_sort(inputs, bench_compare_names);
+
+	for (j = 0; j < inputs->len; j++) {
+		bench_input_t *input = (bench_input_t *) g_ptr_array_index(inputs, j);
+		double user_start, sys_start, user_end, sys_end;
+		gint64 start;
+
+		/* The first dissection of an input sets up state that later
+		 * ones reuse; don't count it. */
+		input->pool_bytes = fuzz_dissect_one(input->data, input->len);
+
+		get_resource_usage(&user_start, &sys_start);
+		start = g_get_monotonic_time();
+		for (i = 0; i < bench_runs; i++)
+			fuzz_dissect_one(input->data, input->len);
+		input->real_nsecs = (g_get_monotonic_time() - start) * 1000.0 / bench_runs;
+		get_resource_usage(&user_end, &sys_end);
+		input->cpu_nsecs = ((user_end - user_start) + (sys_end - sys_start)) * 1e9 / bench_runs;
+
+		total_real += input->real_nsecs;
+		total_cpu += input->cpu_nsecs;
+		total_bytes += (double) input->len;
+		total_pool += (double) input->pool_bytes;
+	}
+
+	if (bench_json_path != NULL) {
+		output = ws_fopen(bench_json_path, "w");
+		if (output == NULL) {
+			fprintf(stderr, "oss-fuzzshark: can't create %s: %s\n", bench_json_path, g_strerror(errno));
+			g_ptr_array_free(inputs, TRUE);
+			return EXIT_FAILURE;
+		}
+	}
+
+	now = g_date_time_new_now_local();
+	date = g_date_time_format(now, "%Y-%m-%dT%H:%M:%S%:z");
+	g_date_time_unref(now);
+
+	dumper.output_file = output;
+	dumper.flags = JSON_DUMPER_FLAGS_PRETTY_PRINT;
+	json_dumper_begin_object(&dumper);
+	json_dumper_set_member_name(&dumper, "context");
+	json_dumper_begin_object(&dumper);
+	json_dumper_set_member_name(&dumper, "date");
+	json_dumper_value_string(&dumper, date);
+	json_dumper_set_member_name(&dumper, "executable");
+	json_dumper_value_string(&dumper, argv[0]);
+	json_dumper_set_member_name(&dumper, "num_cpus");
+	json_dumper_value_anyf(&dumper, "%u", g_get_num_processors());
+	json_dumper_set_member_name(&dumper, "wireshark_version");
+	json_dumper_value_string(&dumper, get_ws_vcs_version_info());
+	json_dumper_set_member_name(&dumper, "target");
+	json_dumper_value_string(&dumper, bench_target);
+	json_dumper_end_object(&dumper);
+	json_dumper_set_member_name(&dumper, "benchmarks");
+	json_dumper_begin_array(&dumper);
+	for (j = 0; j < inputs->len; j++) {
+		const bench_input_t *input = (const bench_input_t *) g_ptr_array_index(inputs, j);
+		char *name = g_strdup_printf("%s/%s", bench_target, input->name);
+
+		bench_dump_result(&dumper, name, bench_runs, input->real_nsecs, input->cpu_nsecs,
+		    (double) input->len, (double) input->pool_bytes);
+		g_free(name);
+	}
+	{
+		/* The mean over all inputs, for comparing whole corpora. */
+		char *name = g_strdup_printf("%s/mean", bench_target);
+
+		bench_dump_result(&dumper, name, bench_runs * (int) inputs->len,
+		    total_real / inputs->len, total_cpu / inputs->len,
+		    total_bytes / inputs->len, total_pool / inputs->len);
+		g_free(name);
+	}
+	json_dumper_end_array(&dumper);
+	json_dumper_end_object(&dumper);
+	if (!json_dumper_finish(&dumper))
+		ret = EXIT_FAILURE;
+	g_free(date);
+
+	if (output != stdout)
+		fclose(output);
+
+	g_ptr_array_sort(inputs, bench_compare_slowest);
+	fprintf(stderr, "oss-fuzzshark: %u inputs, %d runs each, %.0f ns per input on average\n",
+	    inputs->len, bench_runs, total_real / inputs->len);
+	fprintf(stderr, "Slowest inputs:\n");
+	fprintf(stderr, "%12s %10s %12s  %s\n", "ns/run", "bytes", "pool bytes", "input");
+	for (j = 0; j < inputs->len && j < BENCH_SLOWEST_INPUTS; j++) {
+		const bench_input_t *input = (const bench_input_t *) g_ptr_array_index(inputs, j);
+
+		fprintf(stderr, "%12.0f %10zu %12zu  %s\n",
+		    input->real_nsecs, input->len, input->pool_bytes, input->name);
+	}
+
+	g_ptr_array_free(inputs, TRUE);
+	return ret;
+}
+
 #else
 # error "Missing fuzz target."
 #endif
 
+/*
+ * Take the benchmark options out of the command line, so that libFuzzer
+ * (or the standalone main) doesn't see them.
+ */
+static void
+bench_parse_args(int *argc, char **argv)
+{
+	int i, j;
+
+	for (i = 1, j = 1; i < *argc; i++) {
+		if (g_str_has_prefix(argv[i], "--bench=")) {
+			char *end;
+			long runs = strtol(argv[i] + strlen("--bench="), &end, 10);
+
+			if (*end != '\0' || runs < 1 || runs > INT_MAX) {
+				fprintf(stderr, "oss-fuzzshark: invalid --bench value: %s\n", argv[i]);
+				exit(1);
+			}
+			bench_runs = (int) runs;
+		} else if (g_str_has_prefix(argv[i], "--bench-json=")) {
+			bench_json_path = argv[i] + strlen("--bench-json=");
+		} else {
+			argv[j++] = argv[i];
+		}
+	}
+	argv[j] = NULL;
+	*argc = j;
+}
+
 int
 LLVMFuzzerInitialize(int *argc, char ***argv)
 {
 	int ret;
 
+	bench_parse_args(argc, *argv);
+
 	ret = fuzz_init(*argc, *argv);
 	if (ret != 0)
 		exit(ret);
 
+#ifdef FUZZ_EPAN
+	if (bench_runs > 0)
+		exit(bench_run(*argc, *argv));
+#endif
+
 	return 0;
 }
 
@@ -179,6 +179,51 @@ codec_g711a_decode(codec_context_t *ctx _U_,
     return inputBytesSize * 2;
 }
 
+/* The samples of a batch of frames can be looked up in one loop. */
+static size_t
+codec_g711_decode_batch(const gint16 *exp_table, codec_frame_t *frames,
+        size_t framesCount, void *outputSamples, size_t outputSamplesSize)
+{
+    gint16 *dataOut = (gint16 *) outputSamples;
+    size_t  i, j;
+
+    for (i = 0; i < framesCount; i++)
+    {
+        const guint8 *dataIn = (const guint8 *) frames[i].inputBytes;
+        size_t        len = frames[i].inputBytesSize;
+
+        if (len * 2 > outputSamplesSize) {
+            break;
+        }
+        for (j = 0; j < len; j++)
+        {
+            dataOut[j] = exp_table[dataIn[j]];
+        }
+        frames[i].outputBytes = len * 2;
+        dataOut += len;
+        outputSamplesSize -= len * 2;
+    }
+    return i;
+}
+
+static size_t
+codec_g711u_decode_batch(codec_context_t *ctx _U_,
+        codec_frame_t *frames, size_t framesCount,
+        void *outputSamples, size_t outputSamplesSize)
+{
+    return codec_g711_decode_batch(ulaw_exp_table, frames, framesCount,
+            outputSamples, outputSamplesSize);
+}
+
+static size_t
+codec_g711a_decode_batch(codec_context_t *ctx _U_,
+        codec_frame_t *frames, size_t framesCount,
+        void *outputSamples, size_t outputSamplesSize)
+{
+    return codec_g711_decode_batch(alaw_exp_table, frames, framesCount,
+            outputSamples, outputSamplesSize);
+}
+
 void
 codec_register_g711(void)
 {
@@ -186,6 +231,8 @@ codec_register_g711(void)
             codec_g711u_get_channels, codec_g711u_get_frequency, codec_g711u_decode);
     register_codec("g711A", codec_g711a_init, codec_g711a_release,
             codec_g711a_get_channels, codec_g711a_get_frequency, codec_g711a_decode);
+    register_codec_decode_batch("g711U", codec_g711u_decode_batch);
+    register_codec_decode_batch("g711A", codec_g711a_decode_batch);
 }
 
 /*
@@ -34,6 +34,7 @@
 
 #include <epan/exceptions.h>
 #include <epan/packet.h>
+#include <epan/prefs.h>
 #include <epan/proto.h>
 #include <epan/proto_data.h>
 #include <epan/conversation.h>
@@ -107,6 +108,11 @@ guint n_conv_fields = 0;
  */
 sinsp_span_t *sinsp_span = NULL;
 
+/*
+ * Preferences
+ */
+static gboolean pref_cache_fields = FALSE;
+
 /*
  * Fields
  */
@@ -414,6 +420,14 @@ proto_register_falcoplugin(void)
     proto_falco_bridge = proto_register_protocol("Falco Bridge", "Falco Bridge", "falcobridge");
     register_dissector("falcobridge", dissect_falco_bridge, proto_falco_bridge);
 
+    module_t *falco_bridge_module = prefs_register_protocol(proto_falco_bridge, NULL);
+    prefs_register_bool_preference(falco_bridge_module, "cache_fields",
+        "Cache extracted fields",
+        "Keep the fields extracted from each event in memory, so that redissecting doesn't"
+        " need libsinsp or the plugins again. This makes filtering and recoloring faster"
+        " at the cost of memory for every event.",
+        &pref_cache_fields);
+
     // Try to have a 1:1 mapping for as many Sysdig / Falco fields as possible.
     proto_syscalls[SSC_EVENT] = proto_register_protocol("Event Information", "Falco Event", "evt");
     proto_syscalls[SSC_PROCESS] = proto_register_protocol("Process Information", "Falco Process", "process");
@@ -534,6 +548,49 @@ get_bridge_info(guint32 source_id)
     return NULL;
 }
 
+/*
+ * Whether a field has to be extracted for this pass: when it ends up in the tree
+ * or is referenced by a filter or column, or when it affects the Info column,
+ * conversations or addresses.
+ */
+static bool
+is_field_wanted(bridge_info *bi, uint32_t fld_idx, proto_tree *tree)
+{
+    if (bi->field_flags[fld_idx] & (BFF_INFO | BFF_CONVERSATION)) {
+        return true;
+    }
+    if (bi->hf_id_to_addr_id && bi->hf_id_to_addr_id[fld_idx] >= 0) {
+        return true;
+    }
+    return proto_field_is_referenced(tree, bi->hf_ids[fld_idx]);
+}
+
+/*
+ * Fields cached or to be cached. If caching is enabled every field is extracted
+ * during the first pass and kept in file scope, so that redissection only has to
+ * look them up. Returns NULL if they have to be extracted into pinfo->pool.
+ */
+static sinsp_field_extract_t *
+get_cached_fields(packet_info *pinfo, bridge_info *bi, bool *extract)
+{
+    sinsp_field_extract_t *sinsp_fields;
+
+    *extract = true;
+    if (!pref_cache_fields) {
+        return NULL;
+    }
+    if (pinfo->fd->visited) {
+        sinsp_fields = (sinsp_field_extract_t *) p_get_proto_data(wmem_file_scope(), pinfo, proto_falco_bridge, 0);
+        if (sinsp_fields) {
+            *extract = false;
+        }
+        return sinsp_fields;
+    }
+    sinsp_fields = (sinsp_field_extract_t*) wmem_alloc(wmem_file_scope(), sizeof(sinsp_field_extract_t) * bi->visible_fields);
+    p_add_proto_data(wmem_file_scope(), pinfo, proto_falco_bridge, 0, sinsp_fields);
+    return sinsp_fields;
+}
+
 #define FALCO_PPME_PLUGINEVENT_E 322
 static int
 dissect_falco_bridge(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _U_)
@@ -595,12 +652,19 @@ dissect_sinsp_enriched(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void
         }
     }
 
-    sinsp_field_extract_t *sinsp_fields = (sinsp_field_extract_t*) wmem_alloc(pinfo->pool, sizeof(sinsp_field_extract_t) * bi->visible_fields);
-    for (uint32_t fld_idx = 0; fld_idx < bi->visible_fields; fld_idx++) {
+    bool extract;
+    sinsp_field_extract_t *sinsp_fields = get_cached_fields(pinfo, bi, &extract);
+    wmem_allocator_t *fields_pool = sinsp_fields ? wmem_file_scope() : pinfo->pool;
+
+    if (!sinsp_fields) {
+        sinsp_fields = (sinsp_field_extract_t*) wmem_alloc(pinfo->pool, sizeof(sinsp_field_extract_t) * bi->visible_fields);
+    }
+    for (uint32_t fld_idx = 0; extract && fld_idx < bi->visible_fields; fld_idx++) {
         header_field_info* hfinfo = &(bi->hf[fld_idx].hfinfo);
         sinsp_field_extract_t *sfe = &sinsp_fields[fld_idx];
 
         sfe->field_id = bi->field_ids[fld_idx];
+        sfe->is_wanted = pref_cache_fields || is_field_wanted(bi, fld_idx, tree);
         if (sfe->parent_category == SSC_OTHER) {
             sfe->field_name = hfinfo->abbrev + strlen(FALCO_FIELD_NAME_PREFIX);
         } else {
@@ -631,11 +695,14 @@ dissect_sinsp_enriched(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void
     guint8* payload = (guint8*)tvb_get_ptr(tvb, 0, plen);
 
     // If we have a failure, try to dissect what we can first, then bail out with an error.
-    uint64_t ts = pinfo->abs_ts.secs * 1000000000 + pinfo->abs_ts.nsecs;
-    bool rc = extract_syscall_source_fields(bi->ssi, pinfo->rec->rec_header.syscall_header.event_type,
-                                            pinfo->rec->rec_header.syscall_header.nparams,
-                                            ts, pinfo->rec->rec_header.syscall_header.thread_id, pinfo->rec->rec_header.syscall_header.cpu_id,
-                                            payload, plen, pinfo->pool, sinsp_fields, bi->visible_fields);
+    bool rc = true;
+    if (extract) {
+        uint64_t ts = pinfo->abs_ts.secs * 1000000000 + pinfo->abs_ts.nsecs;
+        rc = extract_syscall_source_fields(bi->ssi, pinfo->rec->rec_header.syscall_header.event_type,
+                                           pinfo->rec->rec_header.syscall_header.nparams,
+                                           ts, pinfo->rec->rec_header.syscall_header.thread_id, pinfo->rec->rec_header.syscall_header.cpu_id,
+                                           payload, plen, fields_pool, sinsp_fields, bi->visible_fields);
+    }
 
     if (!rc) {
         REPORT_DISSECTOR_BUG("Falco plugin %s extract error: %s", get_sinsp_source_name(bi->ssi), get_sinsp_source_last_error(bi->ssi));
@@ -763,18 +830,28 @@ dissect_sinsp_plugin(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void*
 
     guint8* payload = (guint8*)tvb_get_ptr(tvb, 0, payload_len);
 
-    sinsp_field_extract_t *sinsp_fields = (sinsp_field_extract_t*) wmem_alloc(pinfo->pool, sizeof(sinsp_field_extract_t) * bi->visible_fields);
-    for (uint32_t fld_idx = 0; fld_idx < bi->visible_fields; fld_idx++) {
+    bool extract;
+    sinsp_field_extract_t *sinsp_fields = get_cached_fields(pinfo, bi, &extract);
+    wmem_allocator_t *fields_pool = sinsp_fields ? wmem_file_scope() : pinfo->pool;
+
+    if (!sinsp_fields) {
+        sinsp_fields = (sinsp_field_extract_t*) wmem_alloc(pinfo->pool, sizeof(sinsp_field_extract_t) * bi->visible_fields);
+    }
+    for (uint32_t fld_idx = 0; extract && fld_idx < bi->visible_fields; fld_idx++) {
         header_field_info* hfinfo = &(bi->hf[fld_idx].hfinfo);
         sinsp_field_extract_t *sfe = &sinsp_fields[fld_idx];
 
         sfe->field_id = bi->field_ids[fld_idx];
         sfe->field_name = hfinfo->abbrev;
         sfe->type = hfinfo->type == FT_STRINGZ ? FT_STRINGZ : FT_UINT64;
+        sfe->is_wanted = pref_cache_fields || is_field_wanted(bi, fld_idx, tree);
     }
 
     // If we have a failure, try to dissect what we can first, then bail out with an error.
-    bool rc = extract_plugin_source_fields(bi->ssi, pinfo->num, payload, payload_len, pinfo->pool, sinsp_fields, bi->visible_fields);
+    bool rc = true;
+    if (extract) {
+        rc = extract_plugin_source_fields(bi->ssi, pinfo->num, payload, payload_len, fields_pool, sinsp_fields, bi->visible_fields);
+    }
 
     if (!rc) {
         REPORT_DISSECTOR_BUG("Falco plugin %s extract error: %s", get_sinsp_source_name(bi->ssi), get_sinsp_source_last_error(bi->ssi));
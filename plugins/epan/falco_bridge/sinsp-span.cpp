@@ -34,13 +34,14 @@ typedef struct ss_plugin_info ss_plugin_info;
 
 #include <sinsp.h>
 
+#include <algorithm>
+
 typedef struct sinsp_source_info_t {
     sinsp_plugin *source;
     std::vector<const filter_check_info *> syscall_filter_checks;
     std::vector<gen_event_filter_check *> syscall_event_filter_checks;
-    std::vector<const filtercheck_field_info *> syscall_filter_fields;
-    std::map<const filtercheck_field_info *, size_t> ffi_to_sf_idx;
-    std::map<size_t, sinsp_syscall_category_e> field_to_category;
+    std::vector<const filtercheck_field_info *> syscall_filter_fields; // indexed like sinsp_field_extract_t arrays
+    std::vector<sinsp_syscall_category_e> field_to_category;
     sinsp_evt *evt;
     uint8_t *evt_storage;
     size_t evt_storage_size;
@@ -114,8 +115,7 @@ void create_sinsp_syscall_source(sinsp_span_t *sinsp_span, sinsp_source_info_t *
                     continue;
                 }
                 gefc->parse_field_name(ffi->m_name, true, false);
-                ssi->ffi_to_sf_idx[ffi] = ssi->syscall_filter_fields.size();
-                ssi->field_to_category[ssi->syscall_filter_fields.size()] = syscall_category;
+                ssi->field_to_category.push_back(syscall_category);
                 ssi->syscall_event_filter_checks.push_back(gefc);
                 ssi->syscall_filter_fields.push_back(ffi);
             }
@@ -352,8 +352,13 @@ bool extract_syscall_source_fields(sinsp_source_info_t *ssi, uint16_t event_type
     }
 
     bool status = false;
-    for (size_t fc_idx = 0; fc_idx < ssi->syscall_event_filter_checks.size(); fc_idx++) {
-        std::vector<extract_value_t> values;
+    std::vector<extract_value_t> values;
+    size_t num_checks = std::min(ssi->syscall_event_filter_checks.size(), (size_t) sinsp_field_len);
+    for (size_t fc_idx = 0; fc_idx < num_checks; fc_idx++) {
+        size_t sf_idx = fc_idx;
+        if (!sinsp_fields[sf_idx].is_wanted) {
+            continue;
+        }
         auto gefc = ssi->syscall_event_filter_checks[fc_idx];
         values.clear();
         if (!gefc->extract(ssi->evt, values, false) || values.size() < 1) {
@@ -361,7 +366,6 @@ bool extract_syscall_source_fields(sinsp_source_info_t *ssi, uint16_t event_type
         }
         auto ffi = ssi->syscall_filter_fields[fc_idx];
         if (ffi->m_flags == filtercheck_field_flags::EPF_NONE && values[0].len > 0) {
-            size_t sf_idx = ssi->ffi_to_sf_idx[ffi];
             // XXX Use memcpy instead of all this casting?
             switch (ffi->m_type) {
             case PT_INT8:
@@ -452,30 +456,45 @@ bool extract_plugin_source_fields(sinsp_source_info_t *ssi, uint32_t event_num,
     ssi->evt->init(ssi->evt_storage, 0);
     ssi->evt->set_num(event_num);
 
-    fields.resize(sinsp_field_len);
-    // We must supply field_id, field, arg, and type.
+    // Request all wanted fields in a single call. sf_idxs maps each request back to its sinsp_fields entry.
+    std::vector<size_t> sf_idxs;
+    fields.reserve(sinsp_field_len);
+    sf_idxs.reserve(sinsp_field_len);
     for (size_t i = 0; i < sinsp_field_len; i++) {
-        fields.at(i).field_id = sinsp_fields[i].field_id;
-        fields.at(i).field = sinsp_fields[i].field_name;
+        sinsp_fields[i].is_present = false;
+        if (!sinsp_fields[i].is_wanted) {
+            continue;
+        }
+        // We must supply field_id, field, arg, and type.
+        ss_plugin_extract_field sfield = {};
+        sfield.field_id = sinsp_fields[i].field_id;
+        sfield.field = sinsp_fields[i].field_name;
         if (sinsp_fields[i].type == FT_STRINGZ) {
-            fields.at(i).ftype = FTYPE_STRING;
+            sfield.ftype = FTYPE_STRING;
         } else {
-            fields.at(i).ftype = FTYPE_UINT64;
+            sfield.ftype = FTYPE_UINT64;
         }
+        fields.push_back(sfield);
+        sf_idxs.push_back(i);
+    }
+
+    if (fields.empty()) {
+        return true;
     }
 
     bool status = true;
-    if (!ssi->source->extract_fields(ssi->evt, sinsp_field_len, fields.data())) {
+    if (!ssi->source->extract_fields(ssi->evt, (uint32_t) fields.size(), fields.data())) {
         status = false;
     }
 
-    for (size_t i = 0; i < sinsp_field_len; i++) {
-        sinsp_fields[i].is_present = fields.at(i).res_len > 0;
-        if (sinsp_fields[i].is_present) {
+    for (size_t i = 0; i < fields.size(); i++) {
+        sinsp_field_extract_t *sfe = &sinsp_fields[sf_idxs[i]];
+        sfe->is_present = fields.at(i).res_len > 0;
+        if (sfe->is_present) {
             if (fields.at(i).ftype == PT_CHARBUF) {
-                sinsp_fields[i].res.str = wmem_strdup(pool, *fields.at(i).res.str);
+                sfe->res.str = wmem_strdup(pool, *fields.at(i).res.str);
             } else if (fields.at(i).ftype == PT_UINT64) {
-                sinsp_fields[i].res.u64 = *fields.at(i).res.u64;
+                sfe->res.u64 = *fields.at(i).res.u64;
             } else {
                 status = false;
             }
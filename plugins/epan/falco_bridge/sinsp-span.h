@@ -66,6 +66,7 @@ typedef struct sinsp_field_extract_t {
     uint32_t field_id;          // in
     const char *field_name;     // in
     enum ftenum type;           // in, out
+    bool is_wanted;             // in, fields that aren't wanted are skipped
     bool is_present;            // out
     union {
         uint8_t *bytes;
@@ -67,9 +67,13 @@ void dbg_print(const gint* which, gint how, FILE* where, const gchar* fmt, ... )
  **/
 
 struct _scs_collection {
-	GHashTable* hash;	/* key: a string value: guint number of subscribers */
+	GHashTable* hash;	/* key: a string value: GUINT_TO_POINTER(number of subscribers - 1) */
 };
 
+/* The strings, AVPs, AVP lists and their nodes of a MATE configuration and
+ * of its runtime data, which are allocated and freed once per PDU field. */
+static wmem_allocator_t* avp_chunks = NULL;
+
 /* ToDo? free any string,ctr entries pointed to by the hash table ??
  *       XXX: AFAIKT destroy_scs_collection() might be called only when reading a
  *         mate config file. Since reading a new config file can apparently currently
@@ -86,6 +90,8 @@ static SCS_collection* scs_init(void) {
 
 	c->hash =  g_hash_table_new(g_str_hash,g_str_equal);
 
+	if (! avp_chunks) avp_chunks = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
 	return c;
 }
 
@@ -104,17 +110,13 @@ static SCS_collection* scs_init(void) {
  **/
 gchar* scs_subscribe(SCS_collection* c, const gchar* s) {
 	gchar* orig = NULL;
-	guint* ip = NULL;
+	gpointer ip = NULL;
 	size_t len = 0;
 
-	g_hash_table_lookup_extended(c->hash,(gconstpointer)s,(gpointer *)&orig,(gpointer *)&ip);
-
-	if (ip) {
-		(*ip)++;
+	if (g_hash_table_lookup_extended(c->hash,(gconstpointer)s,(gpointer *)&orig,&ip)) {
+		/* replaces the count, keeping orig as the key */
+		g_hash_table_insert(c->hash,orig,GUINT_TO_POINTER(GPOINTER_TO_UINT(ip) + 1));
 	} else {
-		ip = g_slice_new(guint);
-		*ip = 0;
-
 		len = strlen(s) + 1;
 
 		if (len <= SCS_SMALL_SIZE) {
@@ -130,10 +132,10 @@ gchar* scs_subscribe(SCS_collection* c, const gchar* s) {
 			ws_warning("mate SCS: string truncated due to huge size");
 		}
 
-		orig = (gchar *)g_slice_alloc(len);
+		orig = (gchar *)wmem_alloc(avp_chunks, len);
 		(void) g_strlcpy(orig,s,len);
 
-		g_hash_table_insert(c->hash,orig,ip);
+		g_hash_table_insert(c->hash,orig,GUINT_TO_POINTER(0));
 	}
 
 	return orig;
@@ -149,38 +151,49 @@ gchar* scs_subscribe(SCS_collection* c, const gchar* s) {
  **/
 void scs_unsubscribe(SCS_collection* c, gchar* s) {
 	gchar* orig = NULL;
-	guint* ip = NULL;
-	size_t len = 0xffff;
-
-	g_hash_table_lookup_extended(c->hash,(gconstpointer)s,(gpointer *)&orig,(gpointer *)&ip);
+	gpointer ip = NULL;
 
-	if (ip) {
-		if (*ip == 0) {
+	if (g_hash_table_lookup_extended(c->hash,(gconstpointer)s,(gpointer *)&orig,&ip)) {
+		if (GPOINTER_TO_UINT(ip) == 0) {
 			g_hash_table_remove(c->hash,orig);
-
-			len = strlen(orig);
-
-			if (len < SCS_SMALL_SIZE) {
-				len = SCS_SMALL_SIZE;
-			} else if (len < SCS_MEDIUM_SIZE) {
-				len = SCS_MEDIUM_SIZE;
-			} else if (len < SCS_LARGE_SIZE) {
-				len = SCS_LARGE_SIZE;
-			} else {
-				len = SCS_HUGE_SIZE;
-			}
-
-			g_slice_free1(len, orig);
-			g_slice_free(guint,ip);
+			wmem_free(avp_chunks, orig);
 		}
 		else {
-			(*ip)--;
+			g_hash_table_insert(c->hash,orig,GUINT_TO_POINTER(GPOINTER_TO_UINT(ip) - 1));
 		}
 	} else {
 		ws_warning("unsubscribe: not subscribed");
 	}
 }
 
+/**
+ * scs_lookup:
+ * @param c the scs hash
+ * @param s a string.
+ *
+ * Finds the stored copy of a string without subscribing to it.
+ *
+ * Return value: the stored copy of the string, or NULL if nobody subscribed it.
+ **/
+static const gchar* scs_lookup(SCS_collection* c, const gchar* s) {
+	gchar* orig = NULL;
+
+	if (g_hash_table_lookup_extended(c->hash,(gconstpointer)s,(gpointer *)&orig,NULL)) {
+		return orig;
+	}
+
+	return NULL;
+}
+
+/**
+ * scs_strcmp:
+ *
+ * strcmp() for subscribed strings: equal strings are the same pointer.
+ **/
+static inline int scs_strcmp(const gchar* a, const gchar* b) {
+	return a == b ? 0 : strcmp(a,b);
+}
+
 /**
  * scs_subscribe_printf:
  * @param fmt a format string ...
@@ -289,7 +302,7 @@ extern void avp_init(void) {
  *
  **/
 extern AVP* new_avp_from_finfo(const gchar* name, field_info* finfo) {
-	AVP*   new_avp_val = (AVP*)g_slice_new(any_avp_type);
+	AVP*   new_avp_val = (AVP*)wmem_new(avp_chunks, any_avp_type);
 	gchar* value;
 	gchar* repr;
 
@@ -334,7 +347,7 @@ extern AVP* new_avp_from_finfo(const gchar* name, field_info* finfo) {
  *
  **/
 extern AVP* new_avp(const gchar* name, const gchar* value, gchar o) {
-	AVP* new_avp_val = (AVP*)g_slice_new(any_avp_type);
+	AVP* new_avp_val = (AVP*)wmem_new(avp_chunks, any_avp_type);
 
 	new_avp_val->n = scs_subscribe(avp_strings, name);
 	new_avp_val->v = scs_subscribe(avp_strings, value);
@@ -361,7 +374,7 @@ extern void delete_avp(AVP* avp) {
 
 	scs_unsubscribe(avp_strings, avp->n);
 	scs_unsubscribe(avp_strings, avp->v);
-	g_slice_free(any_avp_type,(any_avp_type*)avp);
+	wmem_free(avp_chunks, avp);
 }
 
 
@@ -375,7 +388,7 @@ extern void delete_avp(AVP* avp) {
  *
  **/
 extern AVP* avp_copy(AVP* from) {
-	AVP* new_avp_val = (AVP*)g_slice_new(any_avp_type);
+	AVP* new_avp_val = (AVP*)wmem_new(avp_chunks, any_avp_type);
 
 	new_avp_val->n = scs_subscribe(avp_strings, from->n);
 	new_avp_val->v = scs_subscribe(avp_strings, from->v);
@@ -398,7 +411,7 @@ extern AVP* avp_copy(AVP* from) {
  *
  **/
 extern AVPL* new_avpl(const gchar* name) {
-	AVPL* new_avpl_p = (AVPL*)g_slice_new(any_avp_type);
+	AVPL* new_avpl_p = (AVPL*)wmem_new(avp_chunks, any_avp_type);
 
 #ifdef _AVP_DEBUGGING
 	dbg_print(dbg_avpl_op,7,dbg_fp,"new_avpl_p: %p name=%s",new_avpl_p,name);
@@ -430,7 +443,7 @@ extern void rename_avpl(AVPL* avpl, gchar* name) {
  * in the avpl.
  */
 static void insert_avp_before_node(AVPL* avpl, AVPN* next_node, AVP *avp, gboolean copy_avp) {
-	AVPN* new_avp_val = (AVPN*)g_slice_new(any_avp_type);
+	AVPN* new_avp_val = (AVPN*)wmem_new(avp_chunks, any_avp_type);
 
 	new_avp_val->avp = copy_avp ? avp_copy(avp) : avp;
 
@@ -472,10 +485,10 @@ extern gboolean insert_avp(AVPL* avpl, AVP* avp) {
 
 	/* get to the insertion point */
 	for (c=avpl->null.next; c->avp; c = c->next) {
-		int name_diff = strcmp(avp->n, c->avp->n);
+		int name_diff = scs_strcmp(avp->n, c->avp->n);
 
 		if (name_diff == 0) {
-			int value_diff = strcmp(avp->v, c->avp->v);
+			int value_diff = scs_strcmp(avp->v, c->avp->v);
 
 			if (value_diff < 0) {
 				break;
@@ -522,14 +535,17 @@ extern AVP* get_avp_by_name(AVPL* avpl, gchar* name, void** cookie) {
 	dbg_print(dbg_avpl_op,7,dbg_fp,"get_avp_by_name: entering: %p %s %p",avpl,name,*cookie);
 #endif
 
-	name = scs_subscribe(avp_strings, name);
-
 	if (!start) start = avpl->null.next;
 
-	for ( curr = start; curr->avp; curr = curr->next ) {
-		if ( curr->avp->n == name ) {
-			break;
+	/* if nobody holds the name, no avp can have it */
+	if (( name = (gchar *)scs_lookup(avp_strings, name) )) {
+		for ( curr = start; curr->avp; curr = curr->next ) {
+			if ( curr->avp->n == name ) {
+				break;
+			}
 		}
+	} else {
+		curr = &avpl->null;
 	}
 
 	*cookie = curr;
@@ -538,8 +554,6 @@ extern AVP* get_avp_by_name(AVPL* avpl, gchar* name, void** cookie) {
 	dbg_print(dbg_avpl_op,5,dbg_fp,"get_avp_by_name: got avp: %p",curr);
 #endif
 
-	scs_unsubscribe(avp_strings, name);
-
 	return curr->avp;
 }
 
@@ -561,7 +575,7 @@ extern AVP* extract_avp_by_name(AVPL* avpl, gchar* name) {
 	dbg_print(dbg_avpl_op,7,dbg_fp,"extract_avp_by_name: entering: %p %s",avpl,name);
 #endif
 
-	name = scs_subscribe(avp_strings, name);
+	if (! ( name = (gchar *)scs_lookup(avp_strings, name) )) return NULL;
 
 	for ( curr = avpl->null.next; curr->avp; curr = curr->next ) {
 		if ( curr->avp->n == name ) {
@@ -569,8 +583,6 @@ extern AVP* extract_avp_by_name(AVPL* avpl, gchar* name) {
 		}
 	}
 
-	scs_unsubscribe(avp_strings, name);
-
 	if( ! curr->avp ) return NULL;
 
 	curr->next->prev = curr->prev;
@@ -578,7 +590,7 @@ extern AVP* extract_avp_by_name(AVPL* avpl, gchar* name) {
 
 	avp = curr->avp;
 
-	g_slice_free(any_avp_type,(any_avp_type*)curr);
+	wmem_free(avp_chunks, curr);
 
 	(avpl->len)--;
 
@@ -619,7 +631,7 @@ extern AVP* extract_first_avp(AVPL* avpl) {
 	avp = node->avp;
 
 	if (avp) {
-		g_slice_free(any_avp_type,(any_avp_type*)node);
+		wmem_free(avp_chunks, node);
 		(avpl->len)--;
 #ifdef _AVP_DEBUGGING
 		dbg_print(dbg_avpl,4,dbg_fp,"avpl: %p new len: %i",avpl,avpl->len);
@@ -656,7 +668,7 @@ extern AVP* extract_last_avp(AVPL* avpl) {
 	avp = node->avp;
 
 	if (avp) {
-		g_slice_free(any_avp_type,(any_avp_type*)node);
+		wmem_free(avp_chunks, node);
 		(avpl->len)--;
 #ifdef _AVP_DEBUGGING
 		dbg_print(dbg_avpl,4,dbg_fp,"avpl: %p new len: %i",avpl,avpl->len);
@@ -694,7 +706,7 @@ extern void delete_avpl(AVPL* avpl, gboolean avps_too) {
 	}
 
 	scs_unsubscribe(avp_strings,avpl->name);
-	g_slice_free(any_avp_type,(any_avp_type*)avpl);
+	wmem_free(avp_chunks, avpl);
 }
 
 
@@ -743,13 +755,14 @@ extern AVP* get_next_avp(AVPL* avpl, void** cookie) {
 gchar* avpl_to_str(AVPL* avpl) {
 	AVPN* c;
 	GString* s = g_string_new("");
-	gchar* avp_s;
 	gchar* r;
 
 	for(c=avpl->null.next; c->avp; c = c->next) {
-		avp_s = avp_to_str(c->avp);
-		g_string_append_printf(s," %s;",avp_s);
-		g_free(avp_s);
+		g_string_append_c(s,' ');
+		g_string_append(s,c->avp->n);
+		g_string_append_c(s,c->avp->o);
+		g_string_append(s,c->avp->v);
+		g_string_append_c(s,';');
 	}
 
 	r = g_string_free(s,FALSE);
@@ -761,13 +774,14 @@ gchar* avpl_to_str(AVPL* avpl) {
 extern gchar* avpl_to_dotstr(AVPL* avpl) {
 	AVPN* c;
 	GString* s = g_string_new("");
-	gchar* avp_s;
 	gchar* r;
 
 	for(c=avpl->null.next; c->avp; c = c->next) {
-		avp_s = avp_to_str(c->avp);
-		g_string_append_printf(s," .%s;",avp_s);
-		g_free(avp_s);
+		g_string_append(s," .");
+		g_string_append(s,c->avp->n);
+		g_string_append_c(s,c->avp->o);
+		g_string_append(s,c->avp->v);
+		g_string_append_c(s,';');
 	}
 
 	r = g_string_free(s,FALSE);
@@ -798,7 +812,7 @@ extern void merge_avpl(AVPL* dst, AVPL* src, gboolean copy_avps) {
 
 	while (cs->avp && cd->avp) {
 
-		int name_diff = strcmp(cd->avp->n, cs->avp->n);
+		int name_diff = scs_strcmp(cd->avp->n, cs->avp->n);
 
 		if (name_diff < 0) {
 			// dest < source, advance dest to find a better place to insert
@@ -809,7 +823,7 @@ extern void merge_avpl(AVPL* dst, AVPL* src, gboolean copy_avps) {
 			cs = cs->next;
 		} else {
 			// attribute names are equal. Ignore duplicate values but ensure that other values are sorted.
-			int value_diff = strcmp(cd->avp->v, cs->avp->v);
+			int value_diff = scs_strcmp(cd->avp->v, cs->avp->v);
 
 			if (value_diff < 0) {
 				// dest < source, do not insert it yet
@@ -892,8 +906,8 @@ extern AVPL* new_avpl_from_avpl(const gchar* name, AVPL* avpl, gboolean copy_avp
  *
  **/
 extern AVP* match_avp(AVP* src, AVP* op) {
-	gchar** splited;
-	int i;
+	const gchar* alt;
+	const gchar* alt_end;
 	gchar* p;
 	guint ls;
 	guint lo;
@@ -919,15 +933,16 @@ extern AVP* match_avp(AVP* src, AVP* op) {
 		case AVP_OP_STARTS:
 			return strncmp(src->v,op->v,strlen(op->v)) == 0 ? src : NULL;
 		case AVP_OP_ONEOFF:
-			splited = g_strsplit(op->v,"|",0);
-			if (splited) {
-				for (i=0;splited[i];i++) {
-					if(g_str_equal(splited[i],src->v)) {
-						g_strfreev(splited);
-						return src;
-					}
+			/* compare with each '|' separated alternative in place */
+			if (! *op->v) return NULL;
+			ls = (guint) strlen(src->v);
+			for (alt = op->v; ; alt = alt_end + 1) {
+				alt_end = strchr(alt,'|');
+				lo = (guint) (alt_end ? (size_t)(alt_end - alt) : strlen(alt));
+				if (lo == ls && strncmp(alt,src->v,lo) == 0) {
+					return src;
 				}
-				g_strfreev(splited);
+				if (! alt_end) break;
 			}
 			return NULL;
 
@@ -987,7 +1002,7 @@ extern AVPL* new_avpl_loose_match(const gchar* name,
 								  AVPL* op,
 								  gboolean copy_avps) {
 
-	AVPL* newavpl = new_avpl(scs_subscribe(avp_strings, name));
+	AVPL* newavpl = new_avpl(name);
 	AVPN* co = NULL;
 	AVPN* cs = NULL;
 
@@ -999,7 +1014,7 @@ extern AVPL* new_avpl_loose_match(const gchar* name,
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = strcmp(co->avp->n, cs->avp->n);
+		int name_diff = scs_strcmp(co->avp->n, cs->avp->n);
 
 		if (name_diff < 0) {
 			// op < source, op is not matching
@@ -1051,7 +1066,7 @@ extern AVPL* new_avpl_pairs_match(const gchar* name, AVPL* src, AVPL* op, gboole
 	const gchar *last_match = NULL;
 	gboolean matched = TRUE;
 
-	newavpl = new_avpl(scs_subscribe(avp_strings, name));
+	newavpl = new_avpl(name);
 
 #ifdef _AVP_DEBUGGING
 	dbg_print(dbg_avpl_op,3,dbg_fp,"%s: %p src=%p op=%p name='%s'",G_STRFUNC,newavpl,src,op,name);
@@ -1060,7 +1075,7 @@ extern AVPL* new_avpl_pairs_match(const gchar* name, AVPL* src, AVPL* op, gboole
 	cs = src->null.next;
 	co = op->null.next;
 	while (cs->avp && co->avp) {
-		int name_diff = g_strcmp0(co->avp->n, cs->avp->n);
+		int name_diff = scs_strcmp(co->avp->n, cs->avp->n);
 		const gchar *failed_match = NULL;
 
 		if (name_diff < 0) {
@@ -1221,7 +1236,7 @@ extern void avpl_transform(AVPL* src, AVPL_Transf* op) {
 
 							cs->prev->next = cs->next;
 							cs->next->prev = cs->prev;
-							g_slice_free(any_avp_type,(any_avp_type*)cs);
+							wmem_free(avp_chunks, cs);
 
 							cs = n;
 							cm = cm->next;
@@ -1252,7 +1267,7 @@ extern void avpl_transform(AVPL* src, AVPL_Transf* op) {
  * Return value: a pointer to the newly created loal.
  **/
 extern LoAL* new_loal(const gchar* name) {
-	LoAL* new_loal_p = (LoAL*)g_slice_new(any_avp_type);
+	LoAL* new_loal_p = (LoAL*)wmem_new(avp_chunks, any_avp_type);
 
 	if (! name) {
 		name = "anonymous";
@@ -1279,7 +1294,7 @@ extern LoAL* new_loal(const gchar* name) {
  *
  **/
 extern void loal_append(LoAL* loal, AVPL* avpl) {
-	LoALnode* node = (LoALnode*)g_slice_new(any_avp_type);
+	LoALnode* node = (LoALnode*)wmem_new(avp_chunks, any_avp_type);
 
 #ifdef _AVP_DEBUGGING
 	dbg_print(dbg_avpl_op,3,dbg_fp,"new_loal_node: %p",node);
@@ -1322,7 +1337,7 @@ extern AVPL* extract_first_avpl(LoAL* loal) {
 	avpl = node->avpl;
 
 	if ( avpl ) {
-		g_slice_free(any_avp_type,(any_avp_type*)node);
+		wmem_free(avp_chunks, node);
 
 #ifdef _AVP_DEBUGGING
 		dbg_print(dbg_avpl_op,3,dbg_fp,"extract_first_avpl: got %s",avpl->name);
@@ -1356,7 +1371,7 @@ extern AVPL* extract_last_avpl(LoAL* loal){
 	avpl = node->avpl;
 
 	if ( avpl ) {
-		g_slice_free(any_avp_type,(any_avp_type*)node);
+		wmem_free(avp_chunks, node);
 #ifdef _AVP_DEBUGGING
 		dbg_print(dbg_avpl_op,3,dbg_fp,"delete_loal_node: %p",node);
 #endif
@@ -1417,7 +1432,7 @@ extern void delete_loal(LoAL* loal, gboolean avpls_too, gboolean avps_too) {
 	}
 
 	scs_unsubscribe(avp_strings,loal->name);
-	g_slice_free(any_avp_type,(any_avp_type*)loal);
+	wmem_free(avp_chunks, loal);
 }
 
 
@@ -104,9 +104,15 @@ in a message header
 static wmem_map_t *dcerpc_context_zero;
 
 /*
-    The rrpd_list holds information about all of the APDU Request-Response Pairs seen in the trace.
+    The rrpd lists hold information about all of the APDU Request-Response Pairs seen in the trace, one list per
+    TCP or UDP stream so that finding the latest RRPD of a stream only has to look at that stream's RRPDs.
+    The maps are indexed by stream number.
  */
-static wmem_list_t *rrpd_list = NULL;
+static wmem_map_t *tcp_rrpd_lists = NULL;
+static wmem_map_t *udp_rrpd_lists = NULL;
+
+/* In single pass mode only this many RRPDs are kept searchable per stream; older ones are long complete. */
+#define MAX_RRPDS_PER_STREAM_SINGLE_PASS 64
 
 /*
     output_rrpd is a hash of pointers to RRPDs on the rrpd_list.  The index is the frame number.  This hash is
@@ -225,15 +231,35 @@ static void update_output_rrpd(RRPD *in_rrpd)
         wmem_map_insert(output_rrpd, GUINT_TO_POINTER(in_rrpd->rsp_last_frame), in_rrpd);
 }
 
+/* Return the rrpd list for the stream of an RRPD, or NULL if there isn't one and create is FALSE */
+static wmem_list_t *get_rrpd_list(RRPD *in_rrpd, gboolean create)
+{
+    wmem_map_t *lists = (in_rrpd->ip_proto == IP_PROTO_UDP) ? udp_rrpd_lists : tcp_rrpd_lists;
+    wmem_list_t *list = (wmem_list_t*)wmem_map_lookup(lists, GUINT_TO_POINTER(in_rrpd->stream_no));
+
+    if (!list && create)
+    {
+        list = wmem_list_new(wmem_file_scope());
+        wmem_map_insert(lists, GUINT_TO_POINTER(in_rrpd->stream_no), list);
+    }
+
+    return list;
+}
+
 /* Return the index of the RRPD that has been appended */
 static RRPD* append_to_rrpd_list(RRPD *in_rrpd)
 {
     RRPD *next_rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    wmem_list_t *rrpd_list = get_rrpd_list(in_rrpd, TRUE);
 
     update_output_rrpd(next_rrpd);
 
     wmem_list_append(rrpd_list, next_rrpd);
 
+    /* The RRPD itself stays in file scope memory for output_rrpd; it's just no longer searched */
+    if (preferences.single_pass && wmem_list_count(rrpd_list) > MAX_RRPDS_PER_STREAM_SINGLE_PASS)
+        wmem_list_remove_frame(rrpd_list, wmem_list_head(rrpd_list));
+
     return next_rrpd;
 }
 
@@ -241,6 +267,10 @@ static RRPD *find_latest_rrpd_dcerpc(RRPD *in_rrpd)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    wmem_list_t *rrpd_list = get_rrpd_list(in_rrpd, FALSE);
+
+    if (!rrpd_list)
+        return NULL;
 
     for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
     {
@@ -317,6 +347,10 @@ static RRPD *find_latest_rrpd_dns(RRPD *in_rrpd)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    wmem_list_t *rrpd_list = get_rrpd_list(in_rrpd, FALSE);
+
+    if (!rrpd_list)
+        return NULL;
 
     for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
     {
@@ -350,6 +384,10 @@ static RRPD *find_latest_rrpd_gtcp(RRPD *in_rrpd)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    wmem_list_t *rrpd_list = get_rrpd_list(in_rrpd, FALSE);
+
+    if (!rrpd_list)
+        return NULL;
 
     for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
     {
@@ -380,6 +418,10 @@ static RRPD *find_latest_rrpd_gudp(RRPD *in_rrpd)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    wmem_list_t *rrpd_list = get_rrpd_list(in_rrpd, FALSE);
+
+    if (!rrpd_list)
+        return NULL;
 
     for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
     {
@@ -410,6 +452,10 @@ static RRPD *find_latest_rrpd_smb2(RRPD *in_rrpd)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    wmem_list_t *rrpd_list = get_rrpd_list(in_rrpd, FALSE);
+
+    if (!rrpd_list)
+        return NULL;
 
     for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
     {
@@ -486,6 +532,10 @@ static RRPD *find_latest_rrpd_syn(RRPD *in_rrpd)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    wmem_list_t *rrpd_list = get_rrpd_list(in_rrpd, FALSE);
+
+    if (!rrpd_list)
+        return NULL;
 
     for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
     {
@@ -591,7 +641,7 @@ static void update_rrpd_list_entry(RRPD *match, RRPD *in_rrpd)
 /*
     This function processes a sub-packet that is going from client-to-service.
  */
-static void update_rrpd_list_entry_req(RRPD *in_rrpd)
+static RRPD *update_rrpd_list_entry_req(RRPD *in_rrpd)
 {
     RRPD *match;
 
@@ -600,7 +650,9 @@ static void update_rrpd_list_entry_req(RRPD *in_rrpd)
     if (match != NULL)
         update_rrpd_list_entry(match, in_rrpd);
     else
-        append_to_rrpd_list(in_rrpd);
+        match = append_to_rrpd_list(in_rrpd);
+
+    return match;
 }
 
 /*
@@ -645,9 +697,10 @@ static void migrate_temp_rsp_rrpd(RRPD *main_list, RRPD *temp_list)
     wmem_list_remove(temp_rsp_rrpd_list, temp_list);
 }
 
-static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
+/* Returns the rrpd list entry that was updated, or NULL if there isn't one (yet) */
+static RRPD *update_rrpd_list_entry_rsp(RRPD *in_rrpd)
 {
-    RRPD *match, *temp_list;
+    RRPD *match = NULL, *temp_list;
 
     if (in_rrpd->decode_based)
     {
@@ -716,7 +769,7 @@ static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
             update_rrpd_list_entry(match, in_rrpd);
     }
 
-    return;
+    return match;
 }
 
 
@@ -725,13 +778,14 @@ static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
     frame_no values in the input RRPD double up as a mask.  If the frame_no
     is > 0 then the frame_no value and rtime values are updated.  If the
     frame_no is 0 then that particular frame_no and rtime value is not updated.
+    Returns the rrpd_list entry that now holds the data, if any.
  */
-static void update_rrpd_rte_data(RRPD *in_rrpd)
+static RRPD *update_rrpd_rte_data(RRPD *in_rrpd)
 {
     if (in_rrpd->c2s)
-        update_rrpd_list_entry_req(in_rrpd);
+        return update_rrpd_list_entry_req(in_rrpd);
     else
-        update_rrpd_list_entry_rsp(in_rrpd);
+        return update_rrpd_list_entry_rsp(in_rrpd);
 }
 
 gboolean is_dcerpc_context_zero(guint32 pkt_type)
@@ -764,7 +818,8 @@ static void init_globals(void)
     /* Create and initialise some dynamic memory areas */
     tcp_stream_exceptions = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
     detected_tcp_svc = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
-    rrpd_list = wmem_list_new(wmem_file_scope());
+    tcp_rrpd_lists = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    udp_rrpd_lists = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
     temp_rsp_rrpd_list = wmem_list_new(wmem_file_scope());
 
     /* Indicate what fields we're interested in. */
@@ -1113,10 +1168,17 @@ static int dissect_transum(tvbuff_t *buffer, packet_info *pinfo, proto_tree *tre
             /* Loop to process each sub_packet and update the related RTE data */
             for (int i = 0; i < MAX_SUBPKTS_PER_PACKET; i++)
             {
+                RRPD *rrpd;
+
                 if (!sub_packet[i].frame_number)
                     break;
 
-                update_rrpd_rte_data(&(sub_packet[i].rrpd));
+                rrpd = update_rrpd_rte_data(&(sub_packet[i].rrpd));
+
+                /* In single pass mode there won't be a second scan, so each response packet gets the RTE data
+                   of its APDU pair so far; on the last response packet that is the complete result. */
+                if (preferences.single_pass && tree && rrpd && !sub_packet[i].rrpd.c2s && rrpd->rsp_first_frame)
+                    write_rte(rrpd, buffer, pinfo, tree, NULL);
             }
         }
     }
@@ -1249,6 +1311,7 @@ proto_register_transum(void)
     preferences.rte_on_last_rsp = FALSE;
 
     preferences.debug_enabled = FALSE;
+    preferences.single_pass = FALSE;
 
     /* no start registering stuff */
     proto_register_field_array(proto_transum, hf, array_length(hf));
@@ -1327,6 +1390,13 @@ proto_register_transum(void)
         "RTE data will be added to the last response packet",
         &preferences.rte_on_last_rsp);
 
+    prefs_register_bool_preference(transum_module,
+        "single_pass",
+        "Add RTE data to response packets in a single pass",
+        "Set this for live captures and single pass TShark runs, where there is no second scan.\n"
+        "Each response packet then shows the RTE data of its request-response pair so far.",
+        &preferences.single_pass);
+
     prefs_register_bool_preference(transum_module,
         "debug_enabled",
         "Enable debug info",
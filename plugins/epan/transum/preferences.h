@@ -38,4 +38,5 @@ typedef struct _TSUM_PREFERENCES
     gboolean summarise_tds;
     gboolean summarisers_escape_quotes;
     gboolean debug_enabled;
+    gboolean single_pass;
 } TSUM_PREFERENCES;
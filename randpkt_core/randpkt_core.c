@@ -658,6 +658,14 @@ gboolean randpkt_example_close(randpkt_example* example)
 	return ok;
 }
 
+void randpkt_seed(guint32 seed)
+{
+	if (pkt_rand != NULL) {
+		g_rand_free(pkt_rand);
+	}
+	pkt_rand = g_rand_new_with_seed(seed);
+}
+
 int randpkt_example_init(randpkt_example* example, char* produce_filename, int produce_max_bytes, int file_type_subtype)
 {
 	int err;
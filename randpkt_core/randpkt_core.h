@@ -43,6 +43,10 @@ int randpkt_parse_type(char *string);
 /* Find pkt_example record and return pointer to it */
 randpkt_example* randpkt_find_example(int type);
 
+/* Seed the packet generator, so that the following examples produce the
+ * same packets every time. randpkt_example_close() discards the seed. */
+void randpkt_seed(guint32 seed);
+
 /* Init a new example */
 int randpkt_example_init(randpkt_example* example, char* produce_filename, int produce_max_bytes, int file_type_subtype);
 
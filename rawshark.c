@@ -52,6 +52,7 @@
 #include <wsutil/please_report_bug.h>
 #include <wsutil/wslog.h>
 #include <wsutil/clopts_common.h>
+#include <wsutil/pint.h>
 
 #ifdef _WIN32
 #include <wsutil/unicode-utils.h>
@@ -130,8 +131,26 @@ static print_format_e print_format = PR_FMT_TEXT;
 
 static gboolean want_pcap_pkthdr;
 
+/*
+ * Input is read from the pipe in large chunks and records are parsed out
+ * of the buffer, rather than doing two small reads for each record.
+ */
+#define RAW_PIPE_BUFSIZE (256 * 1024)
+static guint8 *pipe_buf;
+static size_t pipe_buf_start;   /* first byte not yet consumed */
+static size_t pipe_buf_end;     /* end of the data read */
+
+/*
+ * Binary output (-b): each packet is written as one length-prefixed
+ * record instead of a line of text; see the OUTPUT section of the man page.
+ */
+static gboolean binary_output;
+static GByteArray *bin_fields;  /* field values of the current packet */
+static guint32 bin_field_count;
+
 cf_status_t raw_cf_open(capture_file *cf, const char *fname);
 static gboolean load_cap_file(capture_file *cf);
+static size_t raw_pipe_read_bytes(void *dst, size_t len, int *err);
 static gboolean process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
                                wtap_rec *rec, Buffer *buf);
 static void show_print_file_io_error(int err);
@@ -207,6 +226,7 @@ print_usage(FILE *output)
 
     fprintf(output, "\n");
     fprintf(output, "Output:\n");
+    fprintf(output, "  -b                       write binary, length-prefixed packet records\n");
     fprintf(output, "  -l                       flush output after each packet\n");
     fprintf(output, "  -S                       format string for fields\n");
     fprintf(output, "                           (%%D - name, %%S - stringval, %%N numval)\n");
@@ -427,7 +447,7 @@ main(int argc, char *argv[])
       {0, 0, 0, 0 }
     };
 
-#define OPTSTRING_INIT OPTSTRING_DISSECT_COMMON OPTSTRING_READ_CAPTURE_COMMON "F:hlm:o:psS:v"
+#define OPTSTRING_INIT OPTSTRING_DISSECT_COMMON OPTSTRING_READ_CAPTURE_COMMON "bF:hlm:o:psS:v"
 
     static const char    optstring[] = OPTSTRING_INIT;
     static const struct report_message_routines rawshark_report_routines = {
@@ -558,6 +578,9 @@ main(int argc, char *argv[])
                     goto clean_exit;
                 }
                 break;
+            case 'b':        /* Binary output records */
+                binary_output = TRUE;
+                break;
             case 'F':        /* Read field to display */
                 g_ptr_array_add(disp_fields, g_strdup(ws_optarg));
                 break;
@@ -701,6 +724,13 @@ main(int argc, char *argv[])
     printf("\n");
     fflush(stdout);
 
+    if (binary_output) {
+#ifdef _WIN32
+        _setmode(1, O_BINARY);
+#endif
+        bin_fields = g_byte_array_new();
+    }
+
     /* If no capture filter or read filter has been specified, and there are
        still command-line arguments, treat them as the tokens of a capture
        filter (if no "-r" flag was specified) or a read filter (if a "-r"
@@ -782,16 +812,13 @@ main(int argc, char *argv[])
 
         /* Do we need to PCAP header and magic? */
         if (skip_pcap_header) {
-            unsigned int bytes_left = (unsigned int) sizeof(struct pcap_hdr) + sizeof(guint32);
             gchar buf[sizeof(struct pcap_hdr) + sizeof(guint32)];
-            while (bytes_left != 0) {
-                ssize_t bytes = ws_read(fd, buf, bytes_left);
-                if (bytes <= 0) {
-                    cmdarg_err("Not enough bytes for pcap header.");
-                    ret =  FORMAT_ERROR;
-                    goto clean_exit;
-                }
-                bytes_left -= (unsigned int)bytes;
+            int err;
+
+            if (raw_pipe_read_bytes(buf, sizeof(buf), &err) != sizeof(buf)) {
+                cmdarg_err("Not enough bytes for pcap header.");
+                ret =  FORMAT_ERROR;
+                goto clean_exit;
             }
         }
 
@@ -809,12 +836,71 @@ main(int argc, char *argv[])
 
 clean_exit:
     g_free(pipe_name);
+    g_free(pipe_buf);
+    if (bin_fields)
+        g_byte_array_free(bin_fields, TRUE);
     epan_free(cfile.epan);
     epan_cleanup();
     wtap_cleanup();
     return ret;
 }
 
+/**
+ * Copy bytes of input from the pipe buffer, refilling it from the pipe
+ * as needed.
+ * @param dst [OUT] Where to put the bytes.
+ * @param len [IN] The number of bytes wanted.
+ * @param err [OUT] Error indicator; errno if a read failed, 0 at EOF.
+ * @return The number of bytes copied, which is less than len only at
+ *         EOF or on error.
+ */
+static size_t
+raw_pipe_read_bytes(void *dst, size_t len, int *err)
+{
+    guint8 *out = (guint8 *)dst;
+    size_t copied = 0;
+    size_t avail;
+    ssize_t bytes_read;
+
+    *err = 0;
+    if (pipe_buf == NULL)
+        pipe_buf = (guint8 *)g_malloc(RAW_PIPE_BUFSIZE);
+
+    while (copied < len) {
+        if (pipe_buf_start == pipe_buf_end) {
+            /*
+             * Newer versions of the VC runtime do parameter validation. If stdin
+             * has been closed, calls to _read, _get_osfhandle, et al will trigger
+             * the invalid parameter handler and crash.
+             * We could alternatively use ReadFile or set an invalid parameter
+             * handler.
+             * We could also tell callers not to close stdin prematurely.
+             */
+#ifdef _WIN32
+            DWORD ghi_flags;
+            if (fd == 0 && GetHandleInformation(GetStdHandle(STD_INPUT_HANDLE), &ghi_flags) == 0) {
+                break;
+            }
+#endif
+            /* A read from a pipe returns whatever is available, so this
+               doesn't wait for the buffer to fill. */
+            bytes_read = ws_read(fd, pipe_buf, RAW_PIPE_BUFSIZE);
+            if (bytes_read <= 0) {
+                if (bytes_read < 0)
+                    *err = errno;
+                break;
+            }
+            pipe_buf_start = 0;
+            pipe_buf_end = (size_t)bytes_read;
+        }
+        avail = MIN(len - copied, pipe_buf_end - pipe_buf_start);
+        memcpy(out + copied, pipe_buf + pipe_buf_start, avail);
+        pipe_buf_start += avail;
+        copied += avail;
+    }
+    return copied;
+}
+
 /**
  * Read data from a raw pipe.  The "raw" data consists of a libpcap
  * packet header followed by the payload.
@@ -829,50 +915,23 @@ static gboolean
 raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *data_offset) {
     struct pcap_pkthdr mem_hdr;
     struct pcaprec_hdr disk_hdr;
-    ssize_t bytes_read = 0;
+    size_t bytes_read;
     unsigned int bytes_needed = (unsigned int) sizeof(disk_hdr);
     guchar *ptr = (guchar*) &disk_hdr;
 
-    *err = 0;
+    *err_info = NULL;
 
     if (want_pcap_pkthdr) {
         bytes_needed = sizeof(mem_hdr);
         ptr = (guchar*) &mem_hdr;
     }
 
-    /*
-     * Newer versions of the VC runtime do parameter validation. If stdin
-     * has been closed, calls to _read, _get_osfhandle, et al will trigger
-     * the invalid parameter handler and crash.
-     * We could alternatively use ReadFile or set an invalid parameter
-     * handler.
-     * We could also tell callers not to close stdin prematurely.
-     */
-#ifdef _WIN32
-    DWORD ghi_flags;
-    if (fd == 0 && GetHandleInformation(GetStdHandle(STD_INPUT_HANDLE), &ghi_flags) == 0) {
-        *err = 0;
-        *err_info = NULL;
+    /* A partial header at the end of the input is treated as EOF */
+    bytes_read = raw_pipe_read_bytes(ptr, bytes_needed, err);
+    *data_offset += bytes_read;
+    if (bytes_read < bytes_needed) {
         return FALSE;
     }
-#endif
-
-    /* Copied from capture_loop.c */
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
-            *err = 0;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
-    }
 
     rec->rec_type = REC_TYPE_PACKET;
     rec->presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
@@ -906,21 +965,12 @@ raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *da
     }
 
     ws_buffer_assure_space(buf, bytes_needed);
-    ptr = ws_buffer_start_ptr(buf);
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
+    bytes_read = raw_pipe_read_bytes(ws_buffer_start_ptr(buf), bytes_needed, err);
+    *data_offset += bytes_read;
+    if (bytes_read < bytes_needed) {
+        if (*err == 0)
             *err = WTAP_ERR_SHORT_READ;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
+        return FALSE;
     }
     return TRUE;
 }
@@ -958,12 +1008,56 @@ load_cap_file(capture_file *cf)
     return TRUE;
 }
 
+/*
+ * Write a binary output record: the field values collected in bin_fields,
+ * preceded by the record length, packet number and read filter results.
+ */
+static void
+write_binary_record(guint32 packet_number, const guint8 *filter_results,
+                    int num_filter_results)
+{
+    guint8 hdr[14];
+    size_t fields_len = packet_number != 0 ? bin_fields->len : 0;
+
+    phton32(hdr, (guint32)(sizeof(hdr) - 4 + num_filter_results + fields_len));
+    phton32(hdr + 4, packet_number);
+    phton16(hdr + 8, (guint16)num_filter_results);
+    phton32(hdr + 10, packet_number != 0 ? bin_field_count : 0);
+    fwrite(hdr, 1, sizeof(hdr), stdout);
+    if (num_filter_results > 0)
+        fwrite(filter_results, 1, num_filter_results, stdout);
+    if (fields_len > 0)
+        fwrite(bin_fields->data, 1, fields_len, stdout);
+}
+
+/*
+ * Output one value of a field; value is NULL if the field has none.
+ */
+static void
+output_field_value(int cmd_line_index, const char *value)
+{
+    if (binary_output) {
+        guint8 hdr[6];
+        size_t len = value ? strlen(value) : 0;
+
+        phton16(hdr, (guint16)cmd_line_index);
+        phton32(hdr + 2, (guint32)len);
+        g_byte_array_append(bin_fields, hdr, sizeof(hdr));
+        if (len > 0)
+            g_byte_array_append(bin_fields, (const guint8 *)value, (guint)len);
+        bin_field_count++;
+    } else {
+        printf(" %d=\"%s\"", cmd_line_index, value ? value : "n.a.");
+    }
+}
+
 static gboolean
 process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
                wtap_rec *rec, Buffer *buf)
 {
     frame_data fdata;
     gboolean passed;
+    guint8 filter_results[G_N_ELEMENTS(rfcodes)];
     int i;
 
     if(rec->rec_header.packet_header.len == 0)
@@ -971,8 +1065,12 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         /* The user sends an empty packet when he wants to get output from us even if we don't currently have
            packets to process. We spit out a line with the timestamp and the text "void"
         */
-        printf("%lu %" PRIu64 " %d void -\n", (unsigned long int)cf->count,
-               (guint64)rec->ts.secs, rec->ts.nsecs);
+        if (binary_output) {
+            write_binary_record(0, NULL, 0);
+        } else {
+            printf("%lu %" PRIu64 " %d void -\n", (unsigned long int)cf->count,
+                   (guint64)rec->ts.secs, rec->ts.nsecs);
+        }
 
         fflush(stdout);
 
@@ -997,7 +1095,12 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         }
     }
 
-    printf("%lu", (unsigned long int) cf->count);
+    if (binary_output) {
+        g_byte_array_set_size(bin_fields, 0);
+        bin_field_count = 0;
+    } else {
+        printf("%lu", (unsigned long int) cf->count);
+    }
 
     frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
                                   &cf->provider.ref, cf->provider.prev_dis);
@@ -1029,10 +1132,16 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             passed = TRUE;
 
         /* Print a one-line summary */
-        printf(" %d", passed ? 1 : 0);
+        if (binary_output)
+            filter_results[i] = passed ? 1 : 0;
+        else
+            printf(" %d", passed ? 1 : 0);
     }
 
-    printf(" -\n");
+    if (binary_output)
+        write_binary_record(cf->count, filter_results, n_rfilters);
+    else
+        printf(" -\n");
 
     /* The ANSI C standard does not appear to *require* that a line-buffered
        stream be flushed to the host environment whenever a newline is
@@ -1053,8 +1162,12 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
        tcpdump or Rawshark is to allow the output of a live capture to
        be piped to a program or script and to have that script see the
        information for the packet as soon as it's printed, rather than
-       having to wait until a standard I/O buffer fills up. */
-    if (line_buffered)
+       having to wait until a standard I/O buffer fills up.
+
+       Packets whose records are already in our input buffer will follow
+       at once, so we only flush when we've used up the buffer and might
+       have to wait for more input. */
+    if (line_buffered && pipe_buf_start == pipe_buf_end)
         fflush(stdout);
 
     if (ferror(stdout)) {
@@ -1227,14 +1340,14 @@ static gboolean print_field_value(field_info *finfo, int cmd_line_index)
                 }
             }
         }
-        printf(" %d=\"%s\"", cmd_line_index, label_s->str);
+        output_field_value(cmd_line_index, label_s->str);
         wmem_free(NULL, fs_buf);
         return TRUE;
     }
 
     if(fs_buf)
     {
-        printf(" %d=\"%s\"", cmd_line_index, fs_ptr);
+        output_field_value(cmd_line_index, fs_ptr);
         wmem_free(NULL, fs_buf);
         return TRUE;
     }
@@ -1244,7 +1357,7 @@ static gboolean print_field_value(field_info *finfo, int cmd_line_index)
      * e.g. http
      * We return n.a.
      */
-    printf(" %d=\"n.a.\"", cmd_line_index);
+    output_field_value(cmd_line_index, NULL);
     return TRUE;
 }
 
@@ -1257,7 +1370,8 @@ protocolinfo_packet(void *prs, packet_info *pinfo _U_, epan_dissect_t *edt, cons
 
     gp=proto_get_finfo_ptr_array(edt->tree, rs->hf_index);
     if(!gp){
-        printf(" n.a.");
+        if (!binary_output)
+            printf(" n.a.");
         return TAP_PACKET_DONT_REDRAW;
     }
 
@@ -21,6 +21,7 @@
 
 #include <wiretap/wtap.h>
 
+#include <wsutil/clopts_common.h>
 #include <wsutil/cmdarg_err.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
@@ -50,6 +51,9 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n                don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -w <frames>       sort in a single pass, holding at most <frames> frames\n");
+    fprintf(output, "                    in memory; frames further out of order than that are\n");
+    fprintf(output, "                    written late and counted.\n");
     fprintf(output, "  -h, --help        display this help and exit.\n");
     fprintf(output, "  -v, --version     print version information and exit.\n");
 }
@@ -115,6 +119,163 @@ frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
     wtap_rec_reset(rec);
 }
 
+/*
+ * Streaming mode: frames are read sequentially into a bounded min-heap
+ * and the earliest one is written out whenever the heap is full. Captures
+ * that are only slightly out of order, such as those merged from several
+ * interfaces with a little clock skew, are sorted without any seeking.
+ */
+typedef struct WindowFrame_t {
+    wtap_rec     rec;
+    Buffer       buf;
+    guint        num;
+    nstime_t     frame_time;
+} WindowFrame_t;
+
+/* Earliest time first; frames with equal times keep their input order */
+static gboolean
+window_frame_before(const WindowFrame_t *a, const WindowFrame_t *b)
+{
+    int cmp = nstime_cmp(&a->frame_time, &b->frame_time);
+
+    return cmp < 0 || (cmp == 0 && a->num < b->num);
+}
+
+static void
+window_push(WindowFrame_t **heap, guint *len, WindowFrame_t *frame)
+{
+    guint i = (*len)++;
+
+    while (i > 0 && window_frame_before(frame, heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = frame;
+}
+
+static WindowFrame_t *
+window_pop(WindowFrame_t **heap, guint *len)
+{
+    WindowFrame_t *top = heap[0];
+    WindowFrame_t *last = heap[--(*len)];
+    guint i = 0;
+
+    for (;;) {
+        guint child = 2 * i + 1;
+
+        if (child >= *len)
+            break;
+        if (child + 1 < *len && window_frame_before(heap[child + 1], heap[child]))
+            child++;
+        if (!window_frame_before(heap[child], last))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+static void
+window_frame_write(WindowFrame_t *frame, wtap *wth, wtap_dumper *pdh,
+                   const char *infile, const char *outfile)
+{
+    int    err;
+    gchar  *err_info;
+
+    DEBUG_PRINT("\nDumping frame (num=%u)\n", frame->num);
+
+    frame->rec.ts = frame->frame_time;
+    if (!wtap_dump(pdh, &frame->rec, ws_buffer_start_ptr(&frame->buf), &err, &err_info)) {
+        cfile_write_failure_message(infile, outfile, err, err_info, frame->num,
+                                    wtap_file_type_subtype(wth));
+        exit(1);
+    }
+    wtap_rec_reset(&frame->rec);
+}
+
+static void
+window_frame_free(WindowFrame_t *frame)
+{
+    wtap_rec_cleanup(&frame->rec);
+    ws_buffer_free(&frame->buf);
+    g_free(frame);
+}
+
+/*
+ * Sort infile into pdh holding at most window frames. Returns the number
+ * of frames that arrived after a later frame had already been written.
+ */
+static guint
+reorder_window(wtap *wth, wtap_dumper *pdh, guint window,
+               const char *infile, const char *outfile)
+{
+    WindowFrame_t **heap = g_new(WindowFrame_t *, (gsize)window + 1);
+    WindowFrame_t *frame = NULL;
+    guint heap_len = 0;
+    guint num = 0;
+    guint wrong_order_count = 0;
+    guint late_count = 0;
+    nstime_t prev_time, written_time;
+    gboolean have_written = FALSE;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+
+    nstime_set_unset(&prev_time);
+    nstime_set_unset(&written_time);
+
+    for (;;) {
+        if (frame == NULL) {
+            frame = g_new(WindowFrame_t, 1);
+            wtap_rec_init(&frame->rec);
+            ws_buffer_init(&frame->buf, 1514);
+        }
+        if (!wtap_read(wth, &frame->rec, &frame->buf, &err, &err_info, &data_offset))
+            break;
+
+        frame->num = ++num;
+        if (frame->rec.presence_flags & WTAP_HAS_TS) {
+            frame->frame_time = frame->rec.ts;
+        } else {
+            nstime_set_unset(&frame->frame_time);
+        }
+        if (num > 1 && nstime_cmp(&frame->frame_time, &prev_time) < 0) {
+            wrong_order_count++;
+        }
+        prev_time = frame->frame_time;
+        if (have_written && nstime_cmp(&frame->frame_time, &written_time) < 0) {
+            late_count++;
+        }
+
+        window_push(heap, &heap_len, frame);
+        frame = NULL;
+        if (heap_len > window) {
+            frame = window_pop(heap, &heap_len);
+            written_time = frame->frame_time;
+            have_written = TRUE;
+            window_frame_write(frame, wth, pdh, infile, outfile);
+        }
+    }
+    if (err != 0) {
+        /* Print a message noting that the read failed somewhere along the line. */
+        cfile_read_failure_message(infile, err, err_info);
+    }
+    if (frame != NULL) {
+        window_frame_free(frame);
+    }
+
+    while (heap_len > 0) {
+        frame = window_pop(heap, &heap_len);
+        window_frame_write(frame, wth, pdh, infile, outfile);
+        window_frame_free(frame);
+    }
+    g_free(heap);
+
+    printf("%u frames, %u out of order\n", num, wrong_order_count);
+    return late_count;
+}
+
 /* Comparing timestamps between 2 frames.
    negative if (t1 < t2)
    zero     if (t1 == t2)
@@ -182,6 +343,7 @@ main(int argc, char *argv[])
     gint64 data_offset;
     guint wrong_order_count = 0;
     gboolean write_output_regardless = TRUE;
+    guint window = 0;
     guint i;
     wtap_dump_params params;
     int                          ret = EXIT_SUCCESS;
@@ -234,11 +396,14 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options first */
-    while ((opt = ws_getopt_long(argc, argv, "hnv", long_options, NULL)) != -1) {
+    while ((opt = ws_getopt_long(argc, argv, "hnvw:", long_options, NULL)) != -1) {
         switch (opt) {
             case 'n':
                 write_output_regardless = FALSE;
                 break;
+            case 'w':
+                window = get_nonzero_guint32(ws_optarg, "reorder window");
+                break;
             case 'h':
                 show_help_header("Reorder timestamps of input file frames into output file.");
                 print_usage(stdout);
@@ -253,6 +418,12 @@ main(int argc, char *argv[])
         }
     }
 
+    if (window > 0 && !write_output_regardless) {
+        cmdarg_err("-n can't be used with -w, as frames are written while the input is read.");
+        ret = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
     /* Remaining args are file names */
     file_count = argc - ws_optind;
     if (file_count == 2) {
@@ -297,6 +468,15 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (window > 0) {
+        guint late_count = reorder_window(wth, pdh, window, infile, outfile);
+        if (late_count > 0) {
+            fprintf(stderr, "reordercap: %u frames were more than %u frames out of order and were written late;\n"
+                    "rerun with a larger -w value, or without -w, to sort them.\n", late_count, window);
+        }
+        goto close_output;
+    }
+
     /* Allocate the array of frame pointers. */
     frames = g_ptr_array_new();
 
@@ -359,6 +539,7 @@ main(int argc, char *argv[])
     /* Free the whole array */
     g_ptr_array_free(frames, TRUE);
 
+close_output:
     /* Close outfile */
     if (!wtap_dump_close(pdh, NULL, &err, &err_info)) {
         cfile_close_failure_message(outfile, err, err_info);
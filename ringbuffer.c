@@ -58,6 +58,46 @@
 #include <zlib.h>
 #endif
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#if defined(HAVE_LZ4) && defined(HAVE_LZ4FRAME_H)
+#include <lz4.h>
+#if LZ4_VERSION_NUMBER >= 10703
+#define USE_LZ4
+#include <lz4frame.h>
+#endif
+#endif
+
+#if defined(HAVE_ZSTD) || defined(USE_LZ4)
+/*
+ * We can compress ringbuffer files as we write them, rather than
+ * after they're closed: dumpcap writes to a pipe, and a thread reads
+ * from the other end of the pipe, compresses what it reads, and
+ * writes the result to the file.
+ */
+#define STREAM_COMPRESS
+
+typedef enum {
+    STREAM_COMPRESS_NONE,
+    STREAM_COMPRESS_ZSTD,
+    STREAM_COMPRESS_LZ4
+} stream_compress_type;
+
+/* Stream compressor for the current ringbuffer file */
+typedef struct _rb_compressor {
+    stream_compress_type type;
+    int           in_fd;               /**< Read end of the pipe */
+    int           out_fd;              /**< The ringbuffer file */
+    int           err;                 /**< errno value if compressing or writing failed */
+    GThread      *thread;
+} rb_compressor;
+
+/* Amount of uncompressed data to read from the pipe at a time */
+#define STREAM_COMPRESS_READ_SIZE (1024 * 1024)
+#endif
+
 /* Ringbuffer file structure */
 typedef struct _rb_file {
     gchar         *name;
@@ -81,6 +121,11 @@ typedef struct _ringbuf_data {
     gboolean      group_read_access;   /**< TRUE if files need to be opened with group read access */
     FILE         *name_h;              /**< write names of completed files to this handle */
     gchar        *compress_type;       /**< compress type */
+    gint64        prealloc_size;       /**< Size to preallocate for each file, if recycling them; 0 if not */
+#ifdef STREAM_COMPRESS
+    stream_compress_type stream_compress; /**< compress type for compressing while writing */
+    rb_compressor *compressor;         /**< compressor for the current file, if any */
+#endif
 
     GMutex        mutex;               /**< mutex for oldnames */
     gchar        *oldnames[MAX_FILENAME_QUEUE];       /**< filename list of pending to be deleted */
@@ -207,6 +252,302 @@ ringbuf_start_compress_file(rb_file* rfile)
 }
 #endif
 
+#ifdef STREAM_COMPRESS
+/*
+ * write all of a buffer to a file descriptor
+ */
+static gboolean
+ringbuf_write_all(int fd, const void *buf, size_t len, int *err)
+{
+    const guint8 *p = (const guint8 *)buf;
+    ssize_t nwritten;
+
+    while (len != 0) {
+        nwritten = ws_write(fd, p, (unsigned int)len);
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            *err = errno;
+            return FALSE;
+        }
+        p += nwritten;
+        len -= (size_t)nwritten;
+    }
+    return TRUE;
+}
+
+/*
+ * Read from the pipe until dumpcap closes its end.  If compressing or
+ * writing fails, we keep reading and discarding the data, so that
+ * dumpcap doesn't block on, or get SIGPIPE from, a pipe with no reader;
+ * the error is reported when the file is closed.
+ */
+static void*
+ringbuf_compress_thread(void* arg)
+{
+    rb_compressor *c = (rb_compressor *)arg;
+    guint8  *inbuf;
+    guint8  *outbuf;
+    size_t   outbuf_size;
+    ssize_t  nread;
+#ifdef HAVE_ZSTD
+    ZSTD_CStream *zcs = NULL;
+    ZSTD_inBuffer zin;
+    ZSTD_outBuffer zout;
+    size_t   zret;
+#endif
+#ifdef USE_LZ4
+    LZ4F_cctx *lz4_cctx = NULL;
+    LZ4F_preferences_t lz4_prefs;
+    size_t   lz4_ret;
+#endif
+
+    inbuf = (guint8 *)g_malloc(STREAM_COMPRESS_READ_SIZE);
+    switch (c->type) {
+
+#ifdef HAVE_ZSTD
+    case STREAM_COMPRESS_ZSTD:
+        outbuf_size = ZSTD_CStreamOutSize();
+        zcs = ZSTD_createCStream();
+        if (zcs == NULL || ZSTD_isError(ZSTD_initCStream(zcs, 3)))
+            c->err = ENOMEM;
+        break;
+#endif
+
+#ifdef USE_LZ4
+    case STREAM_COMPRESS_LZ4:
+        memset(&lz4_prefs, 0, sizeof(lz4_prefs));
+        lz4_prefs.frameInfo.blockSizeID = LZ4F_max1MB;
+        lz4_prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+        /* This includes room for the frame header and anything buffered */
+        outbuf_size = LZ4F_compressBound(STREAM_COMPRESS_READ_SIZE, &lz4_prefs);
+        break;
+#endif
+
+    default:
+        outbuf_size = 0;
+        c->err = EINVAL;
+        break;
+    }
+    outbuf = (guint8 *)g_malloc(outbuf_size > 0 ? outbuf_size : 1);
+
+#ifdef USE_LZ4
+    if (c->type == STREAM_COMPRESS_LZ4 && c->err == 0) {
+        if (LZ4F_isError(LZ4F_createCompressionContext(&lz4_cctx, LZ4F_VERSION))) {
+            lz4_cctx = NULL;
+            c->err = ENOMEM;
+        } else {
+            lz4_ret = LZ4F_compressBegin(lz4_cctx, outbuf, outbuf_size, &lz4_prefs);
+            if (LZ4F_isError(lz4_ret))
+                c->err = EIO;
+            else
+                ringbuf_write_all(c->out_fd, outbuf, lz4_ret, &c->err);
+        }
+    }
+#endif
+
+    while ((nread = ws_read(c->in_fd, inbuf, STREAM_COMPRESS_READ_SIZE)) != 0) {
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            if (c->err == 0)
+                c->err = errno;
+            break;
+        }
+        if (c->err != 0)
+            continue;   /* discard it */
+
+        switch (c->type) {
+
+#ifdef HAVE_ZSTD
+        case STREAM_COMPRESS_ZSTD:
+            zin.src = inbuf;
+            zin.size = (size_t)nread;
+            zin.pos = 0;
+            while (zin.pos < zin.size && c->err == 0) {
+                zout.dst = outbuf;
+                zout.size = outbuf_size;
+                zout.pos = 0;
+                zret = ZSTD_compressStream(zcs, &zout, &zin);
+                if (ZSTD_isError(zret))
+                    c->err = EIO;
+                else
+                    ringbuf_write_all(c->out_fd, outbuf, zout.pos, &c->err);
+            }
+            break;
+#endif
+
+#ifdef USE_LZ4
+        case STREAM_COMPRESS_LZ4:
+            lz4_ret = LZ4F_compressUpdate(lz4_cctx, outbuf, outbuf_size,
+                    inbuf, (size_t)nread, NULL);
+            if (LZ4F_isError(lz4_ret))
+                c->err = EIO;
+            else
+                ringbuf_write_all(c->out_fd, outbuf, lz4_ret, &c->err);
+            break;
+#endif
+
+        default:
+            break;
+        }
+    }
+
+    /* Finish the compressed stream */
+    switch (c->type) {
+
+#ifdef HAVE_ZSTD
+    case STREAM_COMPRESS_ZSTD:
+        if (c->err == 0) {
+            do {
+                zout.dst = outbuf;
+                zout.size = outbuf_size;
+                zout.pos = 0;
+                zret = ZSTD_endStream(zcs, &zout);
+                if (ZSTD_isError(zret))
+                    c->err = EIO;
+                else
+                    ringbuf_write_all(c->out_fd, outbuf, zout.pos, &c->err);
+            } while (zret != 0 && c->err == 0);
+        }
+        ZSTD_freeCStream(zcs);
+        break;
+#endif
+
+#ifdef USE_LZ4
+    case STREAM_COMPRESS_LZ4:
+        if (c->err == 0) {
+            lz4_ret = LZ4F_compressEnd(lz4_cctx, outbuf, outbuf_size, NULL);
+            if (LZ4F_isError(lz4_ret))
+                c->err = EIO;
+            else
+                ringbuf_write_all(c->out_fd, outbuf, lz4_ret, &c->err);
+        }
+        if (lz4_cctx != NULL)
+            LZ4F_freeCompressionContext(lz4_cctx);
+        break;
+#endif
+
+    default:
+        break;
+    }
+
+    g_free(inbuf);
+    g_free(outbuf);
+    ws_close(c->in_fd);
+    if (ws_close(c->out_fd) < 0 && c->err == 0)
+        c->err = errno;
+    return NULL;
+}
+
+/*
+ * Start compressing to the file open on out_fd; returns the write end
+ * of a pipe to which to write the uncompressed data, or -1 on error.
+ */
+static int
+ringbuf_start_stream_compress(int out_fd, int *err)
+{
+    rb_compressor *c;
+    int fds[2];
+
+#ifdef _WIN32
+    if (_pipe(fds, STREAM_COMPRESS_READ_SIZE, _O_BINARY) == -1) {
+#else
+    if (pipe(fds) == -1) {
+#endif
+        if (err != NULL)
+            *err = errno;
+        return -1;
+    }
+#ifdef F_SETPIPE_SZ
+    /*
+     * Let dumpcap get well ahead of the compressor before it blocks;
+     * if this fails, we just have a smaller pipe.
+     */
+    (void) fcntl(fds[1], F_SETPIPE_SZ, STREAM_COMPRESS_READ_SIZE);
+#endif
+
+    c = g_new0(rb_compressor, 1);
+    c->type = rb_data.stream_compress;
+    c->in_fd = fds[0];
+    c->out_fd = out_fd;
+    c->thread = g_thread_new("stream_compress", &ringbuf_compress_thread, c);
+    rb_data.compressor = c;
+    return fds[1];
+}
+
+/*
+ * Wait for the compressor for the current file, which must already
+ * have had the write end of its pipe closed, to finish.
+ */
+static gboolean
+ringbuf_finish_stream_compress(int *err)
+{
+    rb_compressor *c = rb_data.compressor;
+    gboolean ret_val = TRUE;
+
+    if (c == NULL)
+        return TRUE;
+    g_thread_join(c->thread);
+    if (c->err != 0) {
+        if (err != NULL)
+            *err = c->err;
+        ret_val = FALSE;
+    }
+    g_free(c);
+    rb_data.compressor = NULL;
+    return ret_val;
+}
+#endif /* STREAM_COMPRESS */
+
+/*
+ * Are we recycling ringbuffer files in place, rather than removing
+ * the oldest file and creating a new one?
+ */
+static gboolean
+ringbuf_recycling_files(void)
+{
+    if (rb_data.prealloc_size == 0 || rb_data.unlimited)
+        return FALSE;
+#ifdef STREAM_COMPRESS
+    /* We don't know how big a compressed file will be. */
+    if (rb_data.stream_compress != STREAM_COMPRESS_NONE)
+        return FALSE;
+#endif
+    return TRUE;
+}
+
+/*
+ * If we're recycling files, a recycled file may contain data from its
+ * previous use past the end of what we've written to it, so cut it off
+ * there before closing it.  The blocks up to that point stay allocated
+ * to the file for its next use.
+ */
+static gboolean
+ringbuf_trim_file(int *err)
+{
+    gint64 valid_len;
+
+    if (!ringbuf_recycling_files() || rb_data.pdh == NULL)
+        return TRUE;
+    if (fflush(rb_data.pdh) == EOF ||
+        (valid_len = ws_lseek64(rb_data.fd, 0, SEEK_CUR)) < 0) {
+        if (err != NULL)
+            *err = errno;
+        return FALSE;
+    }
+#ifdef _WIN32
+    if (_chsize_s(rb_data.fd, valid_len) != 0) {
+#else
+    if (ftruncate(rb_data.fd, (off_t)valid_len) == -1) {
+#endif
+        if (err != NULL)
+            *err = errno;
+        return FALSE;
+    }
+    return TRUE;
+}
+
 /*
  * create the next filename and open a new binary file with that name
  */
@@ -217,9 +558,14 @@ ringbuf_open_file(rb_file *rfile, int *err)
     char    timestr[14+1];
     time_t  current_time;
     struct tm *tm;
+    gchar  *old_name = NULL;
 
     if (rfile->name != NULL) {
-        if (rb_data.unlimited == FALSE) {
+        if (ringbuf_recycling_files()) {
+            /* give the old file the new name below, rather than removing it */
+            old_name = rfile->name;
+            rfile->name = NULL;
+        } else if (rb_data.unlimited == FALSE) {
             /* remove old file (if any, so ignore error) */
             ws_unlink(rfile->name);
         }
@@ -247,20 +593,72 @@ ringbuf_open_file(rb_file *rfile, int *err)
     } else {
         rfile->name = g_strconcat(rb_data.fprefix, "_", filenum, "_", timestr, rb_data.fsuffix, NULL);
     }
+#ifdef STREAM_COMPRESS
+    if (rfile->name != NULL && rb_data.stream_compress != STREAM_COMPRESS_NONE) {
+        gchar *name = rfile->name;
+
+        rfile->name = g_strconcat(name,
+                rb_data.stream_compress == STREAM_COMPRESS_ZSTD ? ".zst" : ".lz4",
+                NULL);
+        g_free(name);
+    }
+#endif
 
     if (rfile->name == NULL) {
+        if (old_name != NULL) {
+            ws_unlink(old_name);
+            g_free(old_name);
+        }
         if (err != NULL)
             *err = ENOMEM;
         return -1;
     }
 
-    rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
-            rb_data.group_read_access ? 0640 : 0600);
+    if (old_name != NULL) {
+        /*
+         * Reuse the old file, and the disk space allocated to it, by
+         * renaming it and writing over it from the beginning; if we
+         * can't rename it, remove it and create a new file as usual.
+         */
+        if (ws_rename(old_name, rfile->name) == 0) {
+            rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_CREAT,
+                    rb_data.group_read_access ? 0640 : 0600);
+        } else {
+            ws_unlink(old_name);
+            rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
+                    rb_data.group_read_access ? 0640 : 0600);
+        }
+        g_free(old_name);
+    } else {
+        rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
+                rb_data.group_read_access ? 0640 : 0600);
+    }
 
     if (rb_data.fd == -1 && err != NULL) {
         *err = errno;
     }
 
+#ifdef HAVE_POSIX_FALLOCATE
+    /*
+     * Allocate the whole file up front, so that the filesystem can
+     * give it contiguous space and doesn't have to allocate blocks
+     * as we write; this is just an optimization, so ignore errors.
+     */
+    if (rb_data.fd != -1 && ringbuf_recycling_files()) {
+        (void) posix_fallocate(rb_data.fd, 0, (off_t)rb_data.prealloc_size);
+    }
+#endif
+
+#ifdef STREAM_COMPRESS
+    if (rb_data.fd != -1 && rb_data.stream_compress != STREAM_COMPRESS_NONE) {
+        int pipe_fd = ringbuf_start_stream_compress(rb_data.fd, err);
+
+        if (pipe_fd == -1)
+            ws_close(rb_data.fd);
+        rb_data.fd = pipe_fd;
+    }
+#endif
+
     return rb_data.fd;
 }
 
@@ -269,7 +667,7 @@ ringbuf_open_file(rb_file *rfile, int *err)
  */
 int
 ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access,
-        gchar *compress_type, gboolean has_nametimenum)
+        gchar *compress_type, gboolean has_nametimenum, gint64 prealloc_size)
 {
     unsigned int i;
     char        *pfx, *last_pathsep;
@@ -287,6 +685,21 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
     rb_data.group_read_access = group_read_access;
     rb_data.name_h = NULL;
     rb_data.compress_type = compress_type;
+    rb_data.prealloc_size = prealloc_size;
+#ifdef STREAM_COMPRESS
+    rb_data.stream_compress = STREAM_COMPRESS_NONE;
+    rb_data.compressor = NULL;
+    if (compress_type != NULL) {
+#ifdef HAVE_ZSTD
+        if (strcmp(compress_type, "zstd") == 0)
+            rb_data.stream_compress = STREAM_COMPRESS_ZSTD;
+#endif
+#ifdef USE_LZ4
+        if (strcmp(compress_type, "lz4") == 0)
+            rb_data.stream_compress = STREAM_COMPRESS_LZ4;
+#endif
+    }
+#endif
     g_mutex_init(&rb_data.mutex);
 
     /* just to be sure ... */
@@ -443,6 +856,15 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
 
     /* close current file */
 
+    if (!ringbuf_trim_file(err)) {
+        fclose(rb_data.pdh);
+        rb_data.pdh = NULL;
+        rb_data.fd = -1;
+        g_free(rb_data.io_buffer);
+        rb_data.io_buffer = NULL;
+        return FALSE;
+    }
+
     if (fclose(rb_data.pdh) == EOF) {
         if (err != NULL) {
             *err = errno;
@@ -452,12 +874,21 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
         rb_data.fd = -1;
         g_free(rb_data.io_buffer);
         rb_data.io_buffer = NULL;
+#ifdef STREAM_COMPRESS
+        ringbuf_finish_stream_compress(NULL);
+#endif
         return FALSE;
     }
 
     rb_data.pdh = NULL;
     rb_data.fd  = -1;
 
+#ifdef STREAM_COMPRESS
+    if (!ringbuf_finish_stream_compress(err)) {
+        return FALSE;
+    }
+#endif
+
     if (rb_data.name_h != NULL) {
         fprintf(rb_data.name_h, "%s\n", ringbuf_current_filename());
         fflush(rb_data.name_h);
@@ -495,8 +926,11 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 
     /* close current file, if it's open */
     if (rb_data.pdh != NULL) {
+        if (!ringbuf_trim_file(err)) {
+            ret_val = FALSE;
+        }
         if (fclose(rb_data.pdh) == EOF) {
-            if (err != NULL) {
+            if (err != NULL && ret_val) {
                 *err = errno;
             }
             ws_close(rb_data.fd);
@@ -507,6 +941,11 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
         g_free(rb_data.io_buffer);
         rb_data.io_buffer = NULL;
 
+#ifdef STREAM_COMPRESS
+        if (!ringbuf_finish_stream_compress(ret_val ? err : NULL)) {
+            ret_val = FALSE;
+        }
+#endif
     }
 
     if (rb_data.name_h != NULL) {
@@ -575,6 +1014,10 @@ ringbuf_error_cleanup(void)
         rb_data.fd = -1;
     }
 
+#ifdef STREAM_COMPRESS
+    ringbuf_finish_stream_compress(NULL);
+#endif
+
     if (rb_data.files != NULL) {
         for (i=0; i < rb_data.num_files; i++) {
             if (rb_data.files[i].name != NULL) {
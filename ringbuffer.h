@@ -25,7 +25,7 @@
 #define RINGBUFFER_WARN_NUM_FILES 65535
 
 int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_access, gchar* compress_type,
-                 gboolean nametimenum);
+                 gboolean nametimenum, gint64 prealloc_size);
 gboolean ringbuf_is_initialized(void);
 const gchar *ringbuf_current_filename(void);
 FILE *ringbuf_init_libpcap_fdopen(int *err);
@@ -73,6 +73,39 @@ capture_file cfile;
 static guint32 cum_bytes;
 static frame_data ref_frame;
 
+/* Set while cfile is the file loaded by the daemon with sharkd_preload_cap_file() */
+static gboolean cfile_preloaded = FALSE;
+
+/* Called now and then from the loops over all frames, see sharkd_set_progress_func() */
+#define SHARKD_PROGRESS_INTERVAL G_USEC_PER_SEC
+static sharkd_progress_func_t progress_func;
+static gint64 progress_next_time;
+
+/*
+ * The most frequent values of the fields given with sharkd_set_index_fields(),
+ * counted during the first pass with the SpaceSaving algorithm: at most
+ * SHARKD_FIELD_INDEX_SIZE values are counted, and a new value takes the
+ * place of the least frequent one, inheriting its count as the error.
+ * The counters are kept in a min-heap on the count.
+ */
+#define SHARKD_FIELD_INDEX_SIZE 1024
+
+struct field_index_counter {
+    char    *value;
+    guint64  count;
+    guint64  error;
+    guint    heap_idx;
+};
+
+struct field_index {
+    header_field_info *hfinfo;
+    GHashTable *counters;       /* value -> struct field_index_counter */
+    GPtrArray  *heap;
+    guint64     total;
+};
+
+static GPtrArray *field_indexes;
+
 static void sharkd_cmdarg_err(const char *msg_format, va_list ap);
 static void sharkd_cmdarg_err_cont(const char *msg_format, va_list ap);
 
@@ -226,6 +259,140 @@ sharkd_epan_new(capture_file *cf)
     return epan_new(&cf->provider, &funcs);
 }
 
+static void
+field_index_free(gpointer data)
+{
+    struct field_index *fi_index = (struct field_index *)data;
+
+    for (guint i = 0; i < fi_index->heap->len; i++) {
+        struct field_index_counter *counter = (struct field_index_counter *)g_ptr_array_index(fi_index->heap, i);
+
+        g_free(counter->value);
+        g_free(counter);
+    }
+    g_ptr_array_free(fi_index->heap, TRUE);
+    g_hash_table_destroy(fi_index->counters);
+    g_free(fi_index);
+}
+
+static void
+field_index_swap(struct field_index *fi_index, guint a, guint b)
+{
+    GPtrArray *heap = fi_index->heap;
+    struct field_index_counter *tmp = (struct field_index_counter *)g_ptr_array_index(heap, a);
+
+    heap->pdata[a] = heap->pdata[b];
+    heap->pdata[b] = tmp;
+    ((struct field_index_counter *)heap->pdata[a])->heap_idx = a;
+    ((struct field_index_counter *)heap->pdata[b])->heap_idx = b;
+}
+
+#define FIELD_INDEX_COUNT(fi_index, idx) \
+    (((struct field_index_counter *)g_ptr_array_index((fi_index)->heap, (idx)))->count)
+
+static void
+field_index_sift_up(struct field_index *fi_index, guint idx)
+{
+    while (idx > 0 && FIELD_INDEX_COUNT(fi_index, (idx - 1) / 2) > FIELD_INDEX_COUNT(fi_index, idx)) {
+        field_index_swap(fi_index, idx, (idx - 1) / 2);
+        idx = (idx - 1) / 2;
+    }
+}
+
+static void
+field_index_sift_down(struct field_index *fi_index, guint idx)
+{
+    guint len = fi_index->heap->len;
+
+    for (;;) {
+        guint smallest = idx;
+        guint left = 2 * idx + 1;
+        guint right = left + 1;
+
+        if (left < len && FIELD_INDEX_COUNT(fi_index, left) < FIELD_INDEX_COUNT(fi_index, smallest))
+            smallest = left;
+        if (right < len && FIELD_INDEX_COUNT(fi_index, right) < FIELD_INDEX_COUNT(fi_index, smallest))
+            smallest = right;
+        if (smallest == idx)
+            break;
+        field_index_swap(fi_index, idx, smallest);
+        idx = smallest;
+    }
+}
+
+static void
+field_index_add(struct field_index *fi_index, const char *value)
+{
+    struct field_index_counter *counter;
+
+    fi_index->total++;
+
+    counter = (struct field_index_counter *)g_hash_table_lookup(fi_index->counters, value);
+    if (counter) {
+        counter->count++;
+        field_index_sift_down(fi_index, counter->heap_idx);
+        return;
+    }
+
+    if (fi_index->heap->len < SHARKD_FIELD_INDEX_SIZE) {
+        counter = g_new0(struct field_index_counter, 1);
+        counter->value = g_strdup(value);
+        counter->count = 1;
+        counter->heap_idx = fi_index->heap->len;
+        g_ptr_array_add(fi_index->heap, counter);
+        g_hash_table_insert(fi_index->counters, counter->value, counter);
+        field_index_sift_up(fi_index, counter->heap_idx);
+        return;
+    }
+
+    /* Replace the least frequent value. */
+    counter = (struct field_index_counter *)g_ptr_array_index(fi_index->heap, 0);
+    g_hash_table_remove(fi_index->counters, counter->value);
+    g_free(counter->value);
+    counter->value = g_strdup(value);
+    counter->error = counter->count;
+    counter->count++;
+    g_hash_table_insert(fi_index->counters, counter->value, counter);
+    field_index_sift_down(fi_index, 0);
+}
+
+static void
+field_indexes_prime(epan_dissect_t *edt)
+{
+    for (guint i = 0; i < field_indexes->len; i++) {
+        const struct field_index *fi_index = (const struct field_index *)g_ptr_array_index(field_indexes, i);
+
+        /* Fields with the same name are counted together. */
+        for (header_field_info *hfinfo = fi_index->hfinfo; hfinfo; hfinfo = hfinfo->same_name_next)
+            epan_dissect_prime_with_hfid(edt, hfinfo->id);
+    }
+}
+
+static void
+field_indexes_update(epan_dissect_t *edt)
+{
+    for (guint i = 0; i < field_indexes->len; i++) {
+        struct field_index *fi_index = (struct field_index *)g_ptr_array_index(field_indexes, i);
+
+        for (header_field_info *hfinfo = fi_index->hfinfo; hfinfo; hfinfo = hfinfo->same_name_next) {
+            GPtrArray *finfos = proto_get_finfo_ptr_array(edt->tree, hfinfo->id);
+
+            if (finfos == NULL)
+                continue;
+
+            for (guint j = 0; j < finfos->len; j++) {
+                field_info *finfo = (field_info *)g_ptr_array_index(finfos, j);
+                char *value = fvalue_to_string_repr(NULL, finfo->value, FTREPR_DFILTER, finfo->hfinfo->display);
+
+                if (value) {
+                    field_index_add(fi_index, value);
+                    wmem_free(NULL, value);
+                }
+            }
+        }
+    }
+}
+
 static gboolean
 process_packet(capture_file *cf, epan_dissect_t *edt,
         gint64 offset, wtap_rec *rec, Buffer *buf)
@@ -263,6 +430,9 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
            with the hfids postdissectors want on the first pass. */
         prime_epan_dissect_with_postdissector_wanted_hfids(edt);
 
+        if (field_indexes)
+            field_indexes_prime(edt);
+
         frame_data_set_before_dissect(&fdlocal, &cf->elapsed_time,
                 &cf->provider.ref, cf->provider.prev_dis);
         if (cf->provider.ref == &fdlocal) {
@@ -277,6 +447,9 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
         /* Run the read filter if we have one. */
         if (cf->rfcode)
             passed = dfilter_apply_edt(cf->rfcode, edt);
+
+        if (passed && field_indexes)
+            field_indexes_update(edt);
     }
 
     if (passed) {
@@ -290,8 +463,8 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
          * if a display filter was given and it matches this packet.
          */
         if (edt && cf->dfcode) {
-            if (dfilter_apply_edt(cf->dfcode, edt) && edt->pi.fd->dependent_frames) {
-                g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+            if (dfilter_apply_edt(cf->dfcode, edt)) {
+                frame_data_sequence_mark_depended_upon(cf->provider.frames, edt->pi.fd);
             }
         }
 
@@ -335,10 +508,13 @@ load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
              *    we're going to apply a display filter;
              *
              *    a postdissector wants field values or protocols
-             *    on the first pass.
+             *    on the first pass;
+             *
+             *    we're going to index the values of some fields.
              */
             create_proto_tree =
-                (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids());
+                (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() ||
+                 field_indexes != NULL);
 
             /* We're not going to display the protocol tree on this pass,
                so it's not going to be "visible". */
@@ -467,6 +643,7 @@ sharkd_cmdarg_err_cont(const char *msg_format, va_list ap)
 cf_status_t
 sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err)
 {
+    cfile_preloaded = FALSE;
     return cf_open(&cfile, fname, type, is_tempfile, err);
 }
 
@@ -476,6 +653,125 @@ sharkd_load_cap_file(void)
     return load_cap_file(&cfile, 0, 0);
 }
 
+int
+sharkd_preload_cap_file(const char *fname)
+{
+    int err = 0;
+
+    if (sharkd_cf_open(fname, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+        return err != 0 ? err : -1;
+
+    err = sharkd_load_cap_file();
+    if (err == 0)
+        cfile_preloaded = TRUE;
+    return err;
+}
+
+int
+sharkd_attach_preloaded_cap_file(void)
+{
+    int err = 0;
+
+    /*
+     * The file descriptor, and so the file offset, is shared with the
+     * other sessions; get one of our own for the random reads.
+     */
+    if (!wtap_fdreopen(cfile.provider.wth, cfile.filename, &err)) {
+        cfile_open_failure_message(cfile.filename, err, NULL);
+        return err;
+    }
+    return 0;
+}
+
+gboolean
+sharkd_cap_file_is_preloaded(const char *fname)
+{
+    return cfile_preloaded && cfile.filename != NULL && strcmp(cfile.filename, fname) == 0;
+}
+
+int
+sharkd_set_index_fields(const char *fields, char **bad_field)
+{
+    gchar **names;
+
+    if (field_indexes) {
+        g_ptr_array_free(field_indexes, TRUE);
+        field_indexes = NULL;
+    }
+
+    if (fields == NULL || *fields == '\0')
+        return 0;
+
+    field_indexes = g_ptr_array_new_with_free_func(field_index_free);
+    names = g_strsplit(fields, ",", -1);
+    for (guint i = 0; names[i] != NULL; i++) {
+        header_field_info *hfinfo;
+        struct field_index *fi_index;
+
+        g_strstrip(names[i]);
+        hfinfo = proto_registrar_get_byname(names[i]);
+        if (hfinfo == NULL) {
+            *bad_field = g_strdup(names[i]);
+            g_strfreev(names);
+            g_ptr_array_free(field_indexes, TRUE);
+            field_indexes = NULL;
+            return -1;
+        }
+
+        fi_index = g_new0(struct field_index, 1);
+        fi_index->hfinfo = hfinfo;
+        fi_index->counters = g_hash_table_new(g_str_hash, g_str_equal);
+        fi_index->heap = g_ptr_array_new();
+        g_ptr_array_add(field_indexes, fi_index);
+    }
+    g_strfreev(names);
+
+    return 0;
+}
+
+static gint
+field_value_compare(gconstpointer a, gconstpointer b)
+{
+    const sharkd_field_value_t *value_a = (const sharkd_field_value_t *)a;
+    const sharkd_field_value_t *value_b = (const sharkd_field_value_t *)b;
+
+    /* Most frequent first */
+    if (value_a->count != value_b->count)
+        return value_a->count < value_b->count ? 1 : -1;
+    return strcmp(value_a->value, value_b->value);
+}
+
+GArray *
+sharkd_get_top_values(const char *field, guint64 *total)
+{
+    GArray *values;
+
+    if (field_indexes == NULL)
+        return NULL;
+
+    for (guint i = 0; i < field_indexes->len; i++) {
+        const struct field_index *fi_index = (const struct field_index *)g_ptr_array_index(field_indexes, i);
+
+        if (strcmp(fi_index->hfinfo->abbrev, field) != 0)
+            continue;
+
+        values = g_array_sized_new(FALSE, FALSE, sizeof(sharkd_field_value_t), fi_index->heap->len);
+        for (guint j = 0; j < fi_index->heap->len; j++) {
+            const struct field_index_counter *counter = (const struct field_index_counter *)g_ptr_array_index(fi_index->heap, j);
+            sharkd_field_value_t value;
+
+            value.value = counter->value;
+            value.count = counter->count;
+            value.error = counter->error;
+            g_array_append_val(values, value);
+        }
+        g_array_sort(values, field_value_compare);
+        *total = fi_index->total;
+        return values;
+    }
+    return NULL;
+}
+
 frame_data *
 sharkd_get_frame(guint32 framenum)
 {
@@ -485,7 +781,7 @@ sharkd_get_frame(guint32 framenum)
 enum dissect_request_status
 sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
         guint32 prev_dis_num, wtap_rec *rec, Buffer *buf,
-        column_info *cinfo, guint32 dissect_flags,
+        column_info *cinfo, guint32 dissect_flags, const GArray *tree_fields,
         sharkd_dissect_func_t cb, void *data,
         int *err, gchar **err_info)
 {
@@ -506,7 +802,17 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
     create_proto_tree = ((dissect_flags & SHARKD_DISSECT_FLAG_PROTO_TREE) ||
             ((dissect_flags & SHARKD_DISSECT_FLAG_COLOR) && color_filters_used()) ||
             (cinfo && have_custom_cols(cinfo)));
-    epan_dissect_init(&edt, cfile.epan, create_proto_tree, (dissect_flags & SHARKD_DISSECT_FLAG_PROTO_TREE));
+    /*
+     * If only some fields of the tree are wanted, don't make it visible,
+     * so that only those fields (and whatever else is primed) are added.
+     */
+    epan_dissect_init(&edt, cfile.epan, create_proto_tree,
+            (dissect_flags & SHARKD_DISSECT_FLAG_PROTO_TREE) && tree_fields == NULL);
+
+    if (tree_fields) {
+        for (guint i = 0; i < tree_fields->len; i++)
+            epan_dissect_prime_with_hfid(&edt, g_array_index(tree_fields, int, i));
+    }
 
     if (dissect_flags & SHARKD_DISSECT_FLAG_COLOR) {
         color_filters_prime_edt(&edt);
@@ -541,6 +847,28 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
     return DISSECT_REQUEST_SUCCESS;
 }
 
+void
+sharkd_set_progress_func(sharkd_progress_func_t func)
+{
+    progress_func = func;
+}
+
+static void
+sharkd_progress(guint32 framenum, guint32 frames_count)
+{
+    gint64 now;
+
+    /* Don't look at the clock for every frame. */
+    if (progress_func == NULL || (framenum & 0x3ff) != 0)
+        return;
+
+    now = g_get_monotonic_time();
+    if (now < progress_next_time)
+        return;
+    progress_next_time = now + SHARKD_PROGRESS_INTERVAL;
+    progress_func(framenum, frames_count);
+}
+
 int
 sharkd_retap(void)
 {
@@ -579,7 +907,9 @@ sharkd_retap(void)
 
     reset_tap_listeners();
 
+    progress_next_time = g_get_monotonic_time() + SHARKD_PROGRESS_INTERVAL;
     for (framenum = 1; framenum <= cfile.count; framenum++) {
+        sharkd_progress(framenum, cfile.count);
         fdata = sharkd_get_frame(framenum);
 
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
@@ -640,9 +970,12 @@ sharkd_filter(const char *dftext, guint8 **result)
     passed_bits = 0;
     result_bits = (guint8 *) g_malloc(2 + (frames_count / 8));
 
+    progress_next_time = g_get_monotonic_time() + SHARKD_PROGRESS_INTERVAL;
     for (framenum = 1; framenum <= frames_count; framenum++) {
         frame_data *fdata = sharkd_get_frame(framenum);
 
+        sharkd_progress(framenum, frames_count);
+
         if ((framenum & 7) == 0) {
             result_bits[(framenum / 8) - 1] = passed_bits;
             passed_bits = 0;
@@ -26,13 +26,26 @@
 #define SHARKD_MODE_GOLD_CONSOLE       3
 #define SHARKD_MODE_GOLD_DAEMON        4
 
+typedef struct {
+  const char *value;  /* in display filter syntax */
+  guint64 count;      /* may be too high by up to error */
+  guint64 error;
+} sharkd_field_value_t;
+
+typedef void (*sharkd_progress_func_t)(guint32 framenum, guint32 frames_count);
 typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, struct epan_column_info *cinfo, const GSList *data_src, void *data);
 
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 int sharkd_load_cap_file(void);
+int sharkd_preload_cap_file(const char *fname);
+int sharkd_attach_preloaded_cap_file(void);
+gboolean sharkd_cap_file_is_preloaded(const char *fname);
+void sharkd_set_progress_func(sharkd_progress_func_t func);
 int sharkd_retap(void);
 int sharkd_filter(const char *dftext, guint8 **result);
+int sharkd_set_index_fields(const char *fields, char **bad_field);
+GArray *sharkd_get_top_values(const char *field, guint64 *total);
 frame_data *sharkd_get_frame(guint32 framenum);
 enum dissect_request_status {
   DISSECT_REQUEST_SUCCESS,
@@ -43,6 +56,7 @@ enum dissect_request_status
 sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
                        guint32 prev_dis_num, wtap_rec *rec, Buffer *buf,
                        column_info *cinfo, guint32 dissect_flags,
+                       const GArray *tree_fields,
                        sharkd_dissect_func_t cb, void *data,
                        int *err, gchar **err_info);
 wtap_block_t sharkd_get_modified_block(const frame_data *fd);
@@ -56,6 +70,7 @@ int sharkd_loop(int argc _U_, char* argv[] _U_);
 
 /* sharkd_session.c */
 int sharkd_session_main(int mode_setting);
+void sharkd_session_set_cache_budget(gsize bytes);
 
 #endif /* __SHARKD_H */
 
@@ -34,7 +34,9 @@
 
 #ifndef _WIN32
 #include <sys/un.h>
+#include <sys/wait.h>
 #include <netinet/tcp.h>
+#include <unistd.h>
 #endif
 
 #include <wsutil/strtoi.h>
@@ -52,6 +54,10 @@
 
 static int mode = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+/* Capture file loaded once, before the session processes are forked, or NULL */
+static const char *preload_file = NULL;
+/* Number of session processes forked ahead of the connections, 0 to fork on accept() */
+static guint32 pool_size = 0;
 
 static socket_handle_t
 socket_init(char *path)
@@ -183,6 +189,16 @@ print_usage(FILE* output)
     fprintf(output, "  -v, --version            show version information\n");
     fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
     fprintf(output, "                           start with specified configuration profile\n");
+    fprintf(output, "  -M <MiB>, --memory-budget <MiB>\n");
+    fprintf(output, "                           keep at most this much in the caches of a session\n");
+#ifndef _WIN32
+    fprintf(output, "  -p <file>, --preload <file>\n");
+    fprintf(output, "                           with -a, load this capture file once and share it\n");
+    fprintf(output, "                           with every session\n");
+    fprintf(output, "  -w <count>, --workers <count>\n");
+    fprintf(output, "                           with -a, keep this many session processes waiting\n");
+    fprintf(output, "                           for connections\n");
+#endif
 
     fprintf(output, "\n");
     fprintf(output, "  Examples:\n");
@@ -217,16 +233,18 @@ sharkd_init(int argc, char **argv)
      * platform-dependent.
      */
 
-#define OPTSTRING "+" "a:hmvC:"
+#define OPTSTRING "+" "a:hmp:vw:C:M:"
 
     static const char    optstring[] = OPTSTRING;
 
-    // right now we don't have any long options
     static const struct ws_option long_options[] = {
         {"api", ws_required_argument, NULL, 'a'},
         {"help", ws_no_argument, NULL, 'h'},
         {"version", ws_no_argument, NULL, 'v'},
         {"config-profile", ws_required_argument, NULL, 'C'},
+        {"preload", ws_required_argument, NULL, 'p'},
+        {"workers", ws_required_argument, NULL, 'w'},
+        {"memory-budget", ws_required_argument, NULL, 'M'},
         {0, 0, 0, 0 }
     };
 
@@ -322,6 +340,40 @@ sharkd_init(int argc, char **argv)
                     mode = SHARKD_MODE_GOLD_CONSOLE;
                     break;
 
+                case 'p':
+#ifdef _WIN32
+                    // The session processes aren't forked, so they couldn't share the file
+                    fprintf(stderr, "--preload isn't supported on Windows\n");
+                    return -1;
+#else
+                    preload_file = ws_optarg;
+                    break;
+#endif
+
+                case 'w':
+#ifdef _WIN32
+                    fprintf(stderr, "--workers isn't supported on Windows\n");
+                    return -1;
+#else
+                    if (!ws_strtou32(ws_optarg, NULL, &pool_size) || pool_size == 0) {
+                        fprintf(stderr, "Invalid number of workers \"%s\"\n", ws_optarg);
+                        return -1;
+                    }
+                    break;
+#endif
+
+                case 'M':
+                {
+                    guint32 budget_mib;
+
+                    if (!ws_strtou32(ws_optarg, NULL, &budget_mib) || budget_mib == 0) {
+                        fprintf(stderr, "Invalid memory budget \"%s\"\n", ws_optarg);
+                        return -1;
+                    }
+                    sharkd_session_set_cache_budget((gsize) budget_mib * 1024 * 1024);
+                    break;
+                }
+
                 case 'v':         /* Show version and exit */
                     show_version();
                     exit(0);
@@ -337,6 +389,18 @@ sharkd_init(int argc, char **argv)
         } while (opt != -1);
     }
 
+    if (preload_file != NULL && mode != SHARKD_MODE_GOLD_DAEMON)
+    {
+        fprintf(stderr, "--preload requires -a\n");
+        return -1;
+    }
+
+    if (pool_size != 0 && mode != SHARKD_MODE_GOLD_DAEMON)
+    {
+        fprintf(stderr, "--workers requires -a\n");
+        return -1;
+    }
+
     if (mode == SHARKD_MODE_CLASSIC_DAEMON || mode == SHARKD_MODE_GOLD_DAEMON)
     {
         /* all good - try to daemonize */
@@ -356,6 +420,95 @@ sharkd_init(int argc, char **argv)
     return 0;
 }
 
+#ifndef _WIN32
+/*
+ * Fork a session process which waits for a connection itself, so that
+ * everything up to accept() is done before a client connects.
+ */
+static pid_t
+sharkd_pool_spawn(void)
+{
+    pid_t pid;
+
+    pid = fork();
+    if (pid == 0)
+    {
+        socket_handle_t fd;
+
+        if (preload_file != NULL && sharkd_attach_preloaded_cap_file() != 0)
+            exit(1);
+
+        do
+            fd = accept(_server_fd, NULL, NULL);
+        while (fd == INVALID_SOCKET && errno == EINTR);
+
+        if (fd == INVALID_SOCKET)
+        {
+            fprintf(stderr, "cannot accept(): %s\n", g_strerror(errno));
+            exit(1);
+        }
+
+        closesocket(_server_fd);
+        /* redirect stdin, stdout to socket */
+        dup2(fd, 0);
+        dup2(fd, 1);
+        close(fd);
+
+        exit(sharkd_session_main(mode));
+    }
+
+    if (pid == -1)
+        fprintf(stderr, "cannot fork(): %s\n", g_strerror(errno));
+
+    return pid;
+}
+
+/*
+ * Keep pool_size session processes waiting for connections.  A process
+ * serves one session only and a fresh one is forked when it ends, so no
+ * state of a session (loaded file, preferences set with "setconf", ...)
+ * can leak into the next one.
+ */
+static int
+sharkd_pool_loop(void)
+{
+    guint32 running = 0;
+
+    while (1)
+    {
+        int status;
+        pid_t pid;
+
+        while (running < pool_size)
+        {
+            if (sharkd_pool_spawn() == -1)
+            {
+                /* Try again later */
+                sleep(1);
+                break;
+            }
+            running++;
+        }
+
+        pid = waitpid(-1, &status, 0);
+        if (pid == -1)
+        {
+            if (errno == ECHILD)
+                running = 0;
+            else if (errno != EINTR)
+                sleep(1);
+            continue;
+        }
+        running--;
+
+        /* Don't fork again and again if the processes can't get ready. */
+        if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+            sleep(1);
+    }
+    return 0;
+}
+#endif
+
 int
 #ifndef _WIN32
 sharkd_loop(int argc _U_, char* argv[] _U_)
@@ -368,6 +521,24 @@ sharkd_loop(int argc _U_, char* argv[])
         return sharkd_session_main(mode);
     }
 
+    if (preload_file != NULL)
+    {
+        /*
+         * Do the first pass over the file here, so that the session
+         * processes forked below start with the frames, the frame index and
+         * the dissectors' first-pass state already there, sharing the pages
+         * they don't write to instead of each reading the file again.
+         */
+        fprintf(stderr, "Preloading %s\n", preload_file);
+        if (sharkd_preload_cap_file(preload_file) != 0)
+            return -1;
+    }
+
+#ifndef _WIN32
+    if (pool_size != 0)
+        return sharkd_pool_loop();
+#endif
+
     while (1)
     {
 #ifndef _WIN32
@@ -400,6 +571,9 @@ sharkd_loop(int argc _U_, char* argv[])
             dup2(fd, 1);
             close(fd);
 
+            if (preload_file != NULL && sharkd_attach_preloaded_cap_file() != 0)
+                exit(1);
+
             exit(sharkd_session_main(mode));
         }
 
@@ -21,9 +21,21 @@
 
 #include <glib.h>
 
+#ifndef _WIN32
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include <wsutil/wsjson.h>
 #include <wsutil/json_dumper.h>
 #include <wsutil/ws_assert.h>
+#include <wsutil/ws_trace.h>
 #include <wsutil/wsgcrypt.h>
 
 #include <file.h>
@@ -51,6 +63,8 @@
 #include <epan/rtd_table.h>
 #include <epan/srt_table.h>
 #include <epan/to_str.h>
+#include <epan/wmem_scopes.h>
+#include <epan/app_mem_usage.h>
 
 #include <epan/dissectors/packet-h225.h>
 #include <epan/rtp_pt.h>
@@ -82,15 +96,117 @@
 struct sharkd_filter_item
 {
     guint8 *filtered; /* can be NULL if all frames are matching for given filter. */
+    gsize size;       /* bytes counted in filter_bytes */
+    GList *lru_link;  /* in filter_lru */
+
+    /* Where the last "frames" request with this filter stopped, so the next page can start there. */
+    guint32 cursor_skip;      /* number of matching frames before cursor_framenum */
+    guint32 cursor_framenum;
+    guint32 cursor_prev_dis_num;
 };
 
+/*
+ * The results of the most recently used filters, keyed by filter text,
+ * with the most recently used first in filter_lru.
+ */
+#define SHARKD_FILTER_CACHE_MAX 32
+
 static GHashTable *filter_table = NULL;
+static GQueue filter_lru = G_QUEUE_INIT;
+static gsize filter_bytes = 0;
+
+/*
+ * The "frames" output of the most recently served frames with the
+ * default columns, keyed by frame number, with the most recently served
+ * first in row_lru.  The columns depend on the reference and previous
+ * displayed frames, so a row is only used again with the same ones.
+ */
+#define SHARKD_ROW_CACHE_MAX    10000
+
+struct sharkd_row_item
+{
+    guint32 framenum;
+    guint32 ref_frame;
+    guint32 prev_dis_num;
+    char *json;
+    gsize size;       /* bytes counted in row_bytes */
+    GList *lru_link;  /* in row_lru */
+};
+
+static GHashTable *row_table = NULL;
+static GQueue row_lru = G_QUEUE_INIT;
+static gsize row_bytes = 0;
+
+/*
+ * The "taps" output of the most recent "tap" requests, keyed by the
+ * filter, interval and taps of the request, with the most recently used
+ * first in tap_lru.
+ */
+#define SHARKD_TAP_CACHE_MAX    16
+
+struct sharkd_tap_item
+{
+    char *json;
+    gsize size;       /* bytes counted in tap_bytes */
+    GList *lru_link;  /* in tap_lru */
+};
+
+static GHashTable *tap_table = NULL;
+static GQueue tap_lru = G_QUEUE_INIT;
+static gsize tap_bytes = 0;
+
+/*
+ * The most the filter, row and tap caches together may keep, 0 for no
+ * limit.  It is checked after each request, when nothing points into the
+ * caches any more; the least recently used entries of the largest cache
+ * are dropped first.  A dropped entry is just computed again when needed.
+ */
+static gsize cache_budget = 0;
+
+/*
+ * The number of frames and bytes of the whole file per time bucket, at a
+ * few fixed intervals, built on first use.  An "intervals" or "iograph"
+ * request for packets, bytes or bits without a filter is answered from
+ * the coarsest level whose interval divides the requested one, without
+ * looking at each frame.  Only non-empty buckets are stored.  The levels
+ * are left NULL if the frames aren't in time order.
+ */
+static const guint32 pyramid_intervals[] = { 1, 10, 100, 1000, 10000, 60000, 600000, 3600000 };
+
+struct sharkd_time_bucket
+{
+    gint64 idx;
+    guint32 frames;
+    guint64 bytes;
+};
+
+static GArray *pyramid_levels[G_N_ELEMENTS(pyramid_intervals)];
+static gboolean pyramid_built = FALSE;
 
 static int mode;
 static guint32 rpcid;
 
 static json_dumper dumper = {0};
 
+/*
+ * How responses are sent, see sharkd_session_process_framing().  With
+ * anything but plain JSON, each response is built in framing_buf and
+ * sent as a frame of its own:
+ *
+ *   4 bytes  payload length, big-endian
+ *   1 byte   flags, SHARKD_FRAME_FLAG_*
+ *   payload  the JSON text or its CBOR encoding, compressed with zstd
+ *            if the flag is set
+ */
+#define SHARKD_FRAME_FLAG_CBOR  0x01
+#define SHARKD_FRAME_FLAG_ZSTD  0x02
+
+#define SHARKD_FRAME_ZSTD_LEVEL 3
+
+static gboolean framing_cbor = FALSE;
+static gboolean framing_zstd = FALSE;
+static GString *framing_buf = NULL;
+
 
 static const char *
 json_find_attr(const char *buf, const jsmntok_t *tokens, int count, const char *attr)
@@ -187,6 +303,196 @@ sharkd_json_object_close(void)
     json_dumper_end_object(&dumper);
 }
 
+static void
+cbor_append_head(GByteArray *out, guint8 major, guint64 value)
+{
+    guint8 head[9];
+    guint head_len;
+
+    head[0] = major << 5;
+    if (value < 24)
+    {
+        head[0] |= (guint8) value;
+        head_len = 1;
+    }
+    else if (value <= G_MAXUINT8)
+    {
+        head[0] |= 24;
+        head[1] = (guint8) value;
+        head_len = 2;
+    }
+    else if (value <= G_MAXUINT16)
+    {
+        head[0] |= 25;
+        phton16(head + 1, (guint16) value);
+        head_len = 3;
+    }
+    else if (value <= G_MAXUINT32)
+    {
+        head[0] |= 26;
+        phton32(head + 1, (guint32) value);
+        head_len = 5;
+    }
+    else
+    {
+        head[0] |= 27;
+        phton64(head + 1, value);
+        head_len = 9;
+    }
+    g_byte_array_append(out, head, head_len);
+}
+
+/* Encode a JSON value as CBOR, returns the index of the token after it. */
+static int
+cbor_append_json(GByteArray *out, const char *json, const jsmntok_t *tokens, int idx)
+{
+    const jsmntok_t *tok = &tokens[idx];
+    const char *text = json + tok->start;
+    int len = tok->end - tok->start;
+
+    switch (tok->type)
+    {
+        case JSMN_OBJECT:
+            cbor_append_head(out, 5, tok->size);
+            idx++;
+            for (int i = 0; i < tok->size; i++)
+            {
+                idx = cbor_append_json(out, json, tokens, idx);  /* key */
+                idx = cbor_append_json(out, json, tokens, idx);  /* value */
+            }
+            return idx;
+
+        case JSMN_ARRAY:
+            cbor_append_head(out, 4, tok->size);
+            idx++;
+            for (int i = 0; i < tok->size; i++)
+                idx = cbor_append_json(out, json, tokens, idx);
+            return idx;
+
+        case JSMN_STRING:
+        {
+            char *str = g_strndup(text, len);
+
+            json_decode_string_inplace(str);
+            cbor_append_head(out, 3, strlen(str));
+            g_byte_array_append(out, (const guint8 *) str, (guint) strlen(str));
+            g_free(str);
+            return idx + 1;
+        }
+
+        default:
+        {
+            char *str = g_strndup(text, len);
+            guint64 value;
+            gint64 svalue;
+
+            if (!strcmp(str, "true"))
+                g_byte_array_append(out, (const guint8 *) "\xf5", 1);
+            else if (!strcmp(str, "false"))
+                g_byte_array_append(out, (const guint8 *) "\xf4", 1);
+            else if (ws_strtou64(str, NULL, &value))
+                cbor_append_head(out, 0, value);
+            else if (ws_strtoi64(str, NULL, &svalue) && svalue < 0)
+                cbor_append_head(out, 1, (guint64) (-1 - svalue));
+            else if (str[0] == '-' || g_ascii_isdigit(str[0]))
+            {
+                union { gdouble d; guint64 u; } dbl;
+                guint8 buf[9];
+
+                dbl.d = g_ascii_strtod(str, NULL);
+                buf[0] = 0xfb;
+                phton64(buf + 1, dbl.u);
+                g_byte_array_append(out, buf, sizeof(buf));
+            }
+            else
+                g_byte_array_append(out, (const guint8 *) "\xf6", 1);  /* null */
+            g_free(str);
+            return idx + 1;
+        }
+    }
+}
+
+/* Send one response or notification, given as JSON text, without the newline. */
+static void
+sharkd_session_write_message(const char *json, gsize len)
+{
+    GByteArray *payload;
+    guint8 header[5];
+    guint8 flags = 0;
+
+    if (!framing_cbor && !framing_zstd)
+    {
+        fwrite(json, 1, len, stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+        return;
+    }
+
+    payload = g_byte_array_new();
+    if (framing_cbor)
+    {
+        char *text = g_strndup(json, len);
+        jsmntok_t *tokens = NULL;
+        unsigned int tokens_max = 0;
+
+        if (json_parse_alloc(text, len, &tokens, &tokens_max) > 0)
+        {
+            cbor_append_json(payload, text, tokens, 0);
+            flags |= SHARKD_FRAME_FLAG_CBOR;
+        }
+        g_free(tokens);
+        g_free(text);
+    }
+    if (!(flags & SHARKD_FRAME_FLAG_CBOR))
+        g_byte_array_append(payload, (const guint8 *) json, (guint) len);
+
+#ifdef HAVE_ZSTD
+    if (framing_zstd)
+    {
+        size_t bound = ZSTD_compressBound(payload->len);
+        guint8 *compressed = (guint8 *) g_malloc(bound);
+        size_t compressed_len = ZSTD_compress(compressed, bound, payload->data, payload->len, SHARKD_FRAME_ZSTD_LEVEL);
+
+        /* If it fails the payload is just sent uncompressed. */
+        if (!ZSTD_isError(compressed_len))
+        {
+            g_byte_array_set_size(payload, 0);
+            g_byte_array_append(payload, compressed, (guint) compressed_len);
+            flags |= SHARKD_FRAME_FLAG_ZSTD;
+        }
+        g_free(compressed);
+    }
+#endif
+
+    phton32(header, payload->len);
+    header[4] = flags;
+    fwrite(header, 1, sizeof(header), stdout);
+    fwrite(payload->data, 1, payload->len, stdout);
+    fflush(stdout);
+
+    g_byte_array_free(payload, TRUE);
+}
+
+static void
+sharkd_session_set_framing(gboolean cbor, gboolean zstd)
+{
+    framing_cbor = cbor;
+    framing_zstd = zstd;
+
+    if (framing_cbor || framing_zstd)
+    {
+        if (!framing_buf)
+            framing_buf = g_string_new(NULL);
+        dumper.output_file = NULL;
+        dumper.output_string = framing_buf;
+    }
+    else
+    {
+        dumper.output_file = stdout;
+        dumper.output_string = NULL;
+    }
+}
+
 static void
 sharkd_json_response_open(guint32 id)
 {
@@ -202,6 +508,14 @@ sharkd_json_response_close(void)
 
     json_dumper_finish(&dumper);
 
+    if (dumper.output_string == framing_buf && framing_buf)
+    {
+        /* Without the newline json_dumper_finish() added. */
+        sharkd_session_write_message(framing_buf->str, framing_buf->len - 1);
+        g_string_truncate(framing_buf, 0);
+        return;
+    }
+
     /*
      * We do an explicit fflush after every line, because
      * we want output to be written to the socket as soon
@@ -374,11 +688,13 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         // Valid methods
         {"method",     "analyse",    1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "bye",        1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "cancel",     1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "check",      1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "complete",   1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "download",   1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "dumpconf",   1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "follow",     1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "framing",    1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "frame",      1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "frames",     1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "info",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
@@ -389,14 +705,17 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"method",     "setconf",    1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "status",     1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "tap",        1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "topvalues",  1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
 
         // Parameters and their method context
+        {"cancel",     "request",    2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
         {"check",      "field",      2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"check",      "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"complete",   "field",      2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"complete",   "pref",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"download",   "token",      2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"dumpconf",   "pref",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"follow",     "async",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"follow",     "follow",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"frame",      "frame",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
@@ -407,13 +726,20 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"frame",      "color",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"frame",      "bytes",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"frame",      "hidden",     2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
+        {"frame",      "depth",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+        {"frame",      "path",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"frame",      "fields",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"framing",    "format",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"framing",    "compress",   2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"frames",     "column*",    2, JSMN_UNDEFINED,    SHARKD_JSON_ANY,      SHARKD_OPTIONAL},
         {"frames",     "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"frames",     "skip",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "limit",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "refs",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"intervals",  "async",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"intervals",  "interval",   2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"intervals",  "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"iograph",    "async",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"iograph",    "interval",   2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"iograph",    "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"iograph",    "graph0",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
@@ -437,10 +763,12 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"iograph",    "filter8",    2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"iograph",    "filter9",    2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"load",       "file",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
+        {"load",       "index",      2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"setcomment", "frame",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
         {"setcomment", "comment",    2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"setconf",    "name",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"setconf",    "value",      2, JSMN_UNDEFINED,    SHARKD_JSON_ANY,      SHARKD_MANDATORY},
+        {"tap",        "async",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"tap",        "tap0",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"tap",        "tap1",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"tap",        "tap2",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
@@ -458,6 +786,10 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"tap",        "tap14",      2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"tap",        "tap15",      2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"tap",        "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"tap",        "interval",   2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+
+        {"topvalues",  "field",      2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
+        {"topvalues",  "limit",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
 
         // End of the name_array
         {NULL,         NULL,         0, JSMN_STRING,       SHARKD_ARRAY_END,   SHARKD_OPTIONAL},
@@ -724,11 +1056,13 @@ sharkd_session_filter_free(gpointer data)
 {
     struct sharkd_filter_item *l = (struct sharkd_filter_item *) data;
 
+    g_queue_delete_link(&filter_lru, l->lru_link);
+    filter_bytes -= l->size;
     g_free(l->filtered);
     g_free(l);
 }
 
-static const struct sharkd_filter_item *
+static struct sharkd_filter_item *
 sharkd_session_filter_data(const char *filter)
 {
     struct sharkd_filter_item *l;
@@ -737,21 +1071,274 @@ sharkd_session_filter_data(const char *filter)
     if (!l)
     {
         guint8 *filtered = NULL;
+        char *key;
 
         int ret = sharkd_filter(filter, &filtered);
 
         if (ret == -1)
             return NULL;
 
-        l = g_new(struct sharkd_filter_item, 1);
+        if (g_hash_table_size(filter_table) >= SHARKD_FILTER_CACHE_MAX)
+            g_hash_table_remove(filter_table, g_queue_peek_tail(&filter_lru));
+
+        key = g_strdup(filter);
+        l = g_new0(struct sharkd_filter_item, 1);
         l->filtered = filtered;
+        l->size = sizeof(*l) + strlen(key) + 1;
+        if (filtered)
+            l->size += 2 + (cfile.count / 8);
+        filter_bytes += l->size;
+        l->cursor_framenum = 1;
+        g_queue_push_head(&filter_lru, key);
+        l->lru_link = g_queue_peek_head_link(&filter_lru);
 
-        g_hash_table_insert(filter_table, g_strdup(filter), l);
+        g_hash_table_insert(filter_table, key, l);
+    }
+    else if (l->lru_link != g_queue_peek_head_link(&filter_lru))
+    {
+        g_queue_unlink(&filter_lru, l->lru_link);
+        g_queue_push_head_link(&filter_lru, l->lru_link);
     }
 
     return l;
 }
 
+static void
+sharkd_session_row_free(gpointer data)
+{
+    struct sharkd_row_item *row = (struct sharkd_row_item *) data;
+
+    g_queue_delete_link(&row_lru, row->lru_link);
+    row_bytes -= row->size;
+    g_free(row->json);
+    g_free(row);
+}
+
+static const char *
+sharkd_session_row_lookup(guint32 framenum, guint32 ref_frame, guint32 prev_dis_num)
+{
+    struct sharkd_row_item *row;
+
+    row = (struct sharkd_row_item *) g_hash_table_lookup(row_table, GUINT_TO_POINTER(framenum));
+    if (!row || row->ref_frame != ref_frame || row->prev_dis_num != prev_dis_num)
+        return NULL;
+
+    if (row->lru_link != g_queue_peek_head_link(&row_lru))
+    {
+        g_queue_unlink(&row_lru, row->lru_link);
+        g_queue_push_head_link(&row_lru, row->lru_link);
+    }
+    return row->json;
+}
+
+static void
+sharkd_session_row_add(guint32 framenum, guint32 ref_frame, guint32 prev_dis_num, char *json)
+{
+    struct sharkd_row_item *row;
+
+    /* Replaces any row for this frame with other reference frames. */
+    g_hash_table_remove(row_table, GUINT_TO_POINTER(framenum));
+    if (g_hash_table_size(row_table) >= SHARKD_ROW_CACHE_MAX)
+        g_hash_table_remove(row_table, g_queue_peek_tail(&row_lru));
+
+    row = g_new(struct sharkd_row_item, 1);
+    row->framenum = framenum;
+    row->ref_frame = ref_frame;
+    row->prev_dis_num = prev_dis_num;
+    row->json = json;
+    row->size = sizeof(*row) + strlen(json) + 1;
+    row_bytes += row->size;
+    g_queue_push_head(&row_lru, GUINT_TO_POINTER(framenum));
+    row->lru_link = g_queue_peek_head_link(&row_lru);
+
+    g_hash_table_insert(row_table, GUINT_TO_POINTER(framenum), row);
+}
+
+static void
+sharkd_session_tap_free(gpointer data)
+{
+    struct sharkd_tap_item *item = (struct sharkd_tap_item *) data;
+
+    g_queue_delete_link(&tap_lru, item->lru_link);
+    tap_bytes -= item->size;
+    g_free(item->json);
+    g_free(item);
+}
+
+static const char *
+sharkd_session_tap_lookup(const char *key)
+{
+    struct sharkd_tap_item *item;
+
+    item = (struct sharkd_tap_item *) g_hash_table_lookup(tap_table, key);
+    if (!item)
+        return NULL;
+
+    if (item->lru_link != g_queue_peek_head_link(&tap_lru))
+    {
+        g_queue_unlink(&tap_lru, item->lru_link);
+        g_queue_push_head_link(&tap_lru, item->lru_link);
+    }
+    return item->json;
+}
+
+static void
+sharkd_session_tap_add(const char *key, char *json)
+{
+    struct sharkd_tap_item *item;
+    char *key_copy;
+
+    if (g_hash_table_size(tap_table) >= SHARKD_TAP_CACHE_MAX)
+        g_hash_table_remove(tap_table, g_queue_peek_tail(&tap_lru));
+
+    key_copy = g_strdup(key);
+    item = g_new(struct sharkd_tap_item, 1);
+    item->json = json;
+    item->size = sizeof(*item) + strlen(key_copy) + 1 + strlen(json) + 1;
+    tap_bytes += item->size;
+    g_queue_push_head(&tap_lru, key_copy);
+    item->lru_link = g_queue_peek_head_link(&tap_lru);
+
+    g_hash_table_insert(tap_table, key_copy, item);
+}
+
+/* The time of a frame in ms since the first frame, as get_io_graph_index() counts it. */
+static gint64
+sharkd_frame_rel_msec(const frame_data *fdata, const nstime_t *start_ts)
+{
+    nstime_t delta;
+
+    nstime_delta(&delta, &fdata->abs_ts, start_ts);
+    if (delta.nsecs < 0)
+    {
+        delta.secs--;
+        delta.nsecs += 1000000000;
+    }
+    return delta.secs * (gint64) 1000 + delta.nsecs / 1000000;
+}
+
+static void
+sharkd_session_pyramid_free(void)
+{
+    for (gsize i = 0; i < G_N_ELEMENTS(pyramid_levels); i++)
+    {
+        if (pyramid_levels[i])
+            g_array_free(pyramid_levels[i], TRUE);
+        pyramid_levels[i] = NULL;
+    }
+    pyramid_built = FALSE;
+}
+
+static void
+sharkd_session_pyramid_build(void)
+{
+    const nstime_t *start_ts;
+    gint64 prev_msec = 0;
+
+    pyramid_built = TRUE;
+    if (cfile.count == 0)
+        return;
+
+    for (gsize i = 0; i < G_N_ELEMENTS(pyramid_levels); i++)
+        pyramid_levels[i] = g_array_new(FALSE, FALSE, sizeof(struct sharkd_time_bucket));
+
+    start_ts = &(sharkd_get_frame(1)->abs_ts);
+    for (guint32 framenum = 1; framenum <= cfile.count; framenum++)
+    {
+        const frame_data *fdata = sharkd_get_frame(framenum);
+        gint64 msec = sharkd_frame_rel_msec(fdata, start_ts);
+
+        if (msec < prev_msec)
+        {
+            /* Out of order, buckets would have to be merged. */
+            sharkd_session_pyramid_free();
+            pyramid_built = TRUE;
+            return;
+        }
+        prev_msec = msec;
+
+        for (gsize i = 0; i < G_N_ELEMENTS(pyramid_levels); i++)
+        {
+            GArray *level = pyramid_levels[i];
+            gint64 idx = msec / pyramid_intervals[i];
+            struct sharkd_time_bucket *bucket = NULL;
+
+            if (level->len > 0)
+                bucket = &g_array_index(level, struct sharkd_time_bucket, level->len - 1);
+            if (bucket == NULL || bucket->idx != idx)
+            {
+                struct sharkd_time_bucket new_bucket = { idx, 0, 0 };
+
+                g_array_append_val(level, new_bucket);
+                bucket = &g_array_index(level, struct sharkd_time_bucket, level->len - 1);
+            }
+            bucket->frames++;
+            bucket->bytes += fdata->pkt_len;
+        }
+    }
+}
+
+/* Get the pyramid level to answer a request for interval_ms, NULL if there's none. */
+static const GArray *
+sharkd_session_pyramid_level(guint32 interval_ms, guint32 *level_interval)
+{
+    if (!pyramid_built)
+        sharkd_session_pyramid_build();
+
+    for (gsize i = G_N_ELEMENTS(pyramid_levels); i > 0; i--)
+    {
+        if (pyramid_levels[i - 1] && interval_ms % pyramid_intervals[i - 1] == 0)
+        {
+            *level_interval = pyramid_intervals[i - 1];
+            return pyramid_levels[i - 1];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Forget the cached filter results, rows, tap results and time buckets,
+ * when the file, its comments or the preferences they depend on change.
+ */
+static void
+sharkd_session_caches_clear(void)
+{
+    g_hash_table_remove_all(filter_table);
+    g_hash_table_remove_all(row_table);
+    g_hash_table_remove_all(tap_table);
+    sharkd_session_pyramid_free();
+}
+
+/* Drop the least recently used cache entries until the caches fit in cache_budget. */
+static void
+sharkd_session_caches_trim(void)
+{
+    if (cache_budget == 0)
+        return;
+
+    while (filter_bytes + row_bytes + tap_bytes > cache_budget)
+    {
+        if (row_bytes >= filter_bytes && row_bytes >= tap_bytes && !g_queue_is_empty(&row_lru))
+            g_hash_table_remove(row_table, g_queue_peek_tail(&row_lru));
+        else if (filter_bytes >= tap_bytes && !g_queue_is_empty(&filter_lru))
+            g_hash_table_remove(filter_table, g_queue_peek_tail(&filter_lru));
+        else if (!g_queue_is_empty(&tap_lru))
+            g_hash_table_remove(tap_table, g_queue_peek_tail(&tap_lru));
+        else if (!g_queue_is_empty(&row_lru))
+            g_hash_table_remove(row_table, g_queue_peek_tail(&row_lru));
+        else if (!g_queue_is_empty(&filter_lru))
+            g_hash_table_remove(filter_table, g_queue_peek_tail(&filter_lru));
+        else
+            break;
+    }
+}
+
+void
+sharkd_session_set_cache_budget(gsize bytes)
+{
+    cache_budget = bytes;
+}
+
 static gboolean
 sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
 {
@@ -1160,7 +1747,10 @@ sharkd_session_process_info(void)
  * Process load request
  *
  * Input:
- *   (m) file - file to be loaded
+ *   (m) file  - file to be loaded
+ *   (o) index - comma separated list of fields whose most frequent values
+ *               are counted while loading, see sharkd_session_process_topvalues().
+ *               Ignored for the file preloaded by the daemon.
  *
  * Output object with attributes:
  *   (m) err - error code
@@ -1169,6 +1759,8 @@ static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 {
     const char *tok_file = json_find_attr(buf, tokens, count, "file");
+    const char *tok_index = json_find_attr(buf, tokens, count, "index");
+    char *bad_field = NULL;
     int err = 0;
 
     if (!tok_file)
@@ -1176,6 +1768,25 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
     fprintf(stderr, "load: filename=%s\n", tok_file);
 
+    sharkd_session_caches_clear();
+
+    /* The daemon has already loaded it for us. */
+    if (sharkd_cap_file_is_preloaded(tok_file))
+    {
+        sharkd_json_simple_ok(rpcid);
+        return;
+    }
+
+    if (sharkd_set_index_fields(tok_index, &bad_field) != 0)
+    {
+        sharkd_json_error(
+                rpcid, -2002, NULL,
+                "Unknown index field %s", bad_field
+                );
+        g_free(bad_field);
+        return;
+    }
+
     if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
     {
         sharkd_json_error(
@@ -1214,6 +1825,66 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 }
 
+/**
+ * sharkd_session_process_topvalues()
+ *
+ * Process topvalues request
+ *
+ * Input:
+ *   (m) field - field given in the "index" of the load request
+ *   (o) limit - number of values, if not specified: 10
+ *
+ * Output object with attributes:
+ *   (m) total  - number of occurrences of the field
+ *   (m) values - array of the most frequent values, most frequent first, with attributes:
+ *                  (m) value  - value in display filter syntax
+ *                  (m) filter - display filter matching the value
+ *                  (m) count  - number of occurrences
+ *                  (m) error  - count can be too high by up to this, when
+ *                               more than 1024 different values were seen
+ */
+static void
+sharkd_session_process_topvalues(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_field = json_find_attr(buf, tokens, count, "field");
+    const char *tok_limit = json_find_attr(buf, tokens, count, "limit");
+    guint32 limit = 10;
+    guint64 total = 0;
+    GArray *values;
+
+    if (tok_limit)
+        ws_strtou32(tok_limit, NULL, &limit);
+
+    values = sharkd_get_top_values(tok_field, &total);
+    if (!values)
+    {
+        sharkd_json_error(
+                rpcid, -16001, NULL,
+                "Field %s is not indexed", tok_field
+                );
+        return;
+    }
+
+    sharkd_json_result_prologue(rpcid);
+    sharkd_json_value_anyf("total", "%" PRIu64, total);
+    sharkd_json_array_open("values");
+    for (guint i = 0; i < values->len && i < limit; i++)
+    {
+        const sharkd_field_value_t *value = &g_array_index(values, sharkd_field_value_t, i);
+
+        json_dumper_begin_object(&dumper);
+        sharkd_json_value_string("value", value->value);
+        sharkd_json_value_stringf("filter", "%s == %s", tok_field, value->value);
+        sharkd_json_value_anyf("count", "%" PRIu64, value->count);
+        sharkd_json_value_anyf("error", "%" PRIu64, value->error);
+        json_dumper_end_object(&dumper);
+    }
+    sharkd_json_array_close();
+    sharkd_json_result_epilogue();
+
+    g_array_free(values, TRUE);
+}
+
 /**
  * sharkd_session_process_status()
  *
@@ -1225,10 +1896,21 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *   (o) filename - capture filename
  *   (o) filesize - capture filesize
  *   (o) columns  - array of column titles
+ *   (m) memory   - object with attributes:
+ *                  (m) filters   - bytes kept by the filter cache
+ *                  (m) rows      - bytes kept by the frames row cache
+ *                  (m) taps      - bytes kept by the tap results cache
+ *                  (o) budget    - the most the caches may keep together
+ *                  (m) filescope - bytes kept by the file scope allocator
+ *                  (o) rss       - resident size of the process, if known
  */
 static void
 sharkd_session_process_status(void)
 {
+    wmem_allocator_stats_t file_stats;
+    const char *mem_name;
+    gsize mem_value;
+
     sharkd_json_result_prologue(rpcid);
 
     sharkd_json_value_anyf("frames", "%u", cfile.count);
@@ -1260,6 +1942,21 @@ sharkd_session_process_status(void)
         sharkd_json_array_close();
     }
 
+    sharkd_json_object_open("memory");
+    sharkd_json_value_anyf("filters", "%zu", filter_bytes);
+    sharkd_json_value_anyf("rows", "%zu", row_bytes);
+    sharkd_json_value_anyf("taps", "%zu", tap_bytes);
+    if (cache_budget)
+        sharkd_json_value_anyf("budget", "%zu", cache_budget);
+    wmem_get_stats(wmem_file_scope(), &file_stats);
+    sharkd_json_value_anyf("filescope", "%zu", file_stats.retained);
+    for (guint i = 0; (mem_name = memory_usage_get(i, &mem_value)) != NULL; i++)
+    {
+        if (!strcmp(mem_name, "RSS"))
+            sharkd_json_value_anyf("rss", "%zu", mem_value);
+    }
+    sharkd_json_object_close();
+
     sharkd_json_result_epilogue();
 }
 
@@ -1341,7 +2038,7 @@ sharkd_session_process_analyse(void)
 
         status = sharkd_dissect_request(framenum,
                 (framenum != 1) ? 1 : 0, framenum - 1,
-                &rec, &rec_buf, NULL, SHARKD_DISSECT_FLAG_NULL,
+                &rec, &rec_buf, NULL, SHARKD_DISSECT_FLAG_NULL, NULL,
                 &sharkd_session_process_analyse_cb, &analyser,
                 &err, &err_info);
         switch (status) {
@@ -1501,6 +2198,20 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     json_dumper_end_object(&dumper);
 }
 
+/* Write a "frames" row to a string (data) instead of the output, so that it can be cached. */
+static void
+sharkd_session_process_frames_string_cb(epan_dissect_t *edt, proto_tree *tree,
+        struct epan_column_info *cinfo, const GSList *data_src, void *data)
+{
+    json_dumper saved_dumper = dumper;
+
+    memset(&dumper, 0, sizeof(dumper));
+    dumper.output_string = (GString *) data;
+    sharkd_session_process_frames_cb(edt, tree, cinfo, data_src, NULL);
+    /* Not json_dumper_finish(), that would end the line. */
+    dumper = saved_dumper;
+}
+
 /**
  * sharkd_session_process_frames()
  *
@@ -1514,6 +2225,11 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
  *   (o) limit=N  - show only N frames
  *   (o) refs  - list (comma separated) with sorted time reference frame numbers.
  *
+ * Paging through the frames with increasing skip values, with the same
+ * filter, carries on from where the last page ended instead of counting
+ * the frames to skip again, and rows already served with the default
+ * columns and the same reference frames aren't dissected again.
+ *
  * Output array of frames with attributes:
  *   (m) c   - array of column data
  *   (m) num - frame number
@@ -1533,11 +2249,17 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
 
     const guint8 *filter_data = NULL;
+    struct sharkd_filter_item *filter_item = NULL;
 
     guint32 prev_dis_num = 0;
     guint32 current_ref_frame = 0, next_ref_frame = G_MAXUINT32;
     guint32 skip;
+    guint32 requested_skip;
     guint32 limit;
+    guint32 start_framenum = 1;
+    guint32 served = 0;
+    guint32 last_framenum = 0;
+    GString *row_string = NULL;
 
     wtap_rec rec; /* Record metadata */
     Buffer rec_buf;   /* Record data */
@@ -1560,8 +2282,6 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
     if (tok_filter)
     {
-        const struct sharkd_filter_item *filter_item;
-
         filter_item = sharkd_session_filter_data(tok_filter);
         if (!filter_item)
         {
@@ -1595,16 +2315,39 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
             return;
     }
 
+    requested_skip = skip;
+
+    /*
+     * Start at the first frame to show, or as close to it as we know.
+     * The time references before it are picked up at the first frame we
+     * show.
+     */
+    if (!filter_data)
+    {
+        start_framenum = skip + 1;
+        prev_dis_num = skip;
+        skip = 0;
+    }
+    else if (skip >= filter_item->cursor_skip)
+    {
+        start_framenum = filter_item->cursor_framenum;
+        prev_dis_num = filter_item->cursor_prev_dis_num;
+        skip -= filter_item->cursor_skip;
+    }
+    if (cinfo == &cfile.cinfo)
+        row_string = g_string_new(NULL);
+
     sharkd_json_result_array_prologue(rpcid);
 
     wtap_rec_init(&rec);
     ws_buffer_init(&rec_buf, 1514);
 
-    for (guint32 framenum = 1; framenum <= cfile.count; framenum++)
+    for (guint32 framenum = start_framenum; framenum <= cfile.count; framenum++)
     {
         frame_data *fdata;
         guint32 ref_frame = (framenum != 1) ? 1 : 0;
         enum dissect_request_status status;
+        const char *row;
         int err;
         gchar *err_info;
 
@@ -1648,14 +2391,32 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
             if (current_ref_frame)
                 ref_frame = current_ref_frame;
         }
-
-        fdata = sharkd_get_frame(framenum);
-        status = sharkd_dissect_request(framenum,
-                ref_frame, prev_dis_num,
-                &rec, &rec_buf, cinfo,
-                (fdata->color_filter == NULL) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
-                &sharkd_session_process_frames_cb, NULL,
-                &err, &err_info);
+
+        row = row_string ? sharkd_session_row_lookup(framenum, ref_frame, prev_dis_num) : NULL;
+        if (row)
+        {
+            json_dumper_value_anyf(&dumper, "%s", row);
+            status = DISSECT_REQUEST_SUCCESS;
+        }
+        else
+        {
+            fdata = sharkd_get_frame(framenum);
+            if (row_string)
+                g_string_truncate(row_string, 0);
+            status = sharkd_dissect_request(framenum,
+                    ref_frame, prev_dis_num,
+                    &rec, &rec_buf, cinfo,
+                    (fdata->color_filter == NULL) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
+                    NULL,
+                    row_string ? &sharkd_session_process_frames_string_cb : &sharkd_session_process_frames_cb,
+                    row_string,
+                    &err, &err_info);
+            if (status == DISSECT_REQUEST_SUCCESS && row_string)
+            {
+                json_dumper_value_anyf(&dumper, "%s", row_string->str);
+                sharkd_session_row_add(framenum, ref_frame, prev_dis_num, g_strdup(row_string->str));
+            }
+        }
         switch (status) {
 
             case DISSECT_REQUEST_SUCCESS:
@@ -1675,12 +2436,25 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
         }
 
         prev_dis_num = framenum;
+        last_framenum = framenum;
+        served++;
 
         if (limit && --limit == 0)
             break;
     }
     sharkd_json_result_array_epilogue();
 
+    /* The next page, if any, starts after this one. */
+    if (filter_data && served != 0)
+    {
+        filter_item->cursor_skip = requested_skip + served;
+        filter_item->cursor_framenum = last_framenum + 1;
+        filter_item->cursor_prev_dis_num = last_framenum;
+    }
+
+    if (row_string)
+        g_string_free(row_string, TRUE);
+
     if (cinfo != &cfile.cinfo)
         col_cleanup(cinfo);
 
@@ -2696,6 +3470,7 @@ sharkd_session_process_tap_srt_cb(void *arg)
         {
             /* SRT row */
             srt_procedure_t *proc = &rst->procedures[j];
+            nstime_t quantile;
 
             if (proc->stats.num == 0)
                 continue;
@@ -2713,6 +3488,13 @@ sharkd_session_process_tap_srt_cb(void *arg)
             sharkd_json_value_anyf("max", "%.9f", nstime_to_sec(&proc->stats.max));
             sharkd_json_value_anyf("tot", "%.9f", nstime_to_sec(&proc->stats.tot));
 
+            get_srt_procedure_quantile(proc, 0.5, &quantile);
+            sharkd_json_value_anyf("p50", "%.9f", nstime_to_sec(&quantile));
+            get_srt_procedure_quantile(proc, 0.99, &quantile);
+            sharkd_json_value_anyf("p99", "%.9f", nstime_to_sec(&quantile));
+            get_srt_procedure_quantile(proc, 0.999, &quantile);
+            sharkd_json_value_anyf("p999", "%.9f", nstime_to_sec(&quantile));
+
             json_dumper_end_object(&dumper);
         }
         sharkd_json_array_close();
@@ -3374,6 +4156,205 @@ sharkd_session_eo_register_tap_listener(register_eo_t *eo, const char *tap_type,
     return register_tap_listener(get_eo_tap_listener_name(eo), eo_object, tap_filter, 0, NULL, get_eo_packet_func(eo), tap_draw, NULL);
 }
 
+#define SHARKD_IOGRAPH_MAX_ITEMS 250000 /* 250k limit of items is taken from wireshark-qt, on x86_64 sizeof(io_graph_item_t) is 152, so single graph can take max 36 MB */
+
+struct sharkd_iograph
+{
+    /* config */
+    int hf_index;
+    io_graph_item_unit_t calc_type;
+    guint32 interval;
+
+    /* result */
+    int space_items;
+    int num_items;
+    io_graph_item_t *items;
+    GString *error;
+
+    const char *tap_name; /* for "iograph:" taps of the "tap" request */
+    gboolean precomputed; /* items filled from the time buckets, no tap listener */
+};
+
+static tap_packet_status
+sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
+{
+    struct sharkd_iograph *graph = (struct sharkd_iograph *) g;
+    int idx;
+    gboolean update_succeeded;
+
+    idx = get_io_graph_index(pinfo, graph->interval);
+    if (idx < 0 || idx >= SHARKD_IOGRAPH_MAX_ITEMS)
+        return TAP_PACKET_DONT_REDRAW;
+
+    if (idx + 1 > graph->num_items)
+    {
+        if (idx + 1 > graph->space_items)
+        {
+            int new_size = idx + 1024;
+
+            graph->items = (io_graph_item_t *) g_realloc(graph->items, sizeof(io_graph_item_t) * new_size);
+            reset_io_graph_items(&graph->items[graph->space_items], new_size - graph->space_items);
+
+            graph->space_items = new_size;
+        }
+        else if (graph->items == NULL)
+        {
+            graph->items = g_new(io_graph_item_t, graph->space_items);
+            reset_io_graph_items(graph->items, graph->space_items);
+        }
+
+        graph->num_items = idx + 1;
+    }
+
+    update_succeeded = update_io_graph_item(graph->items, idx, pinfo, edt, graph->hf_index, graph->calc_type, graph->interval);
+    /* XXX - TAP_PACKET_FAILED if the item couldn't be updated, with an error message? */
+    return update_succeeded ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
+}
+
+/* Set up a graph for one of the graph requests, returns FALSE if it isn't known. */
+static gboolean
+sharkd_iograph_init(struct sharkd_iograph *graph, const char *tok_graph, guint32 interval_ms)
+{
+    const char *field_name;
+
+    if (!strcmp(tok_graph, "packets"))
+        graph->calc_type = IOG_ITEM_UNIT_PACKETS;
+    else if (!strcmp(tok_graph, "bytes"))
+        graph->calc_type = IOG_ITEM_UNIT_BYTES;
+    else if (!strcmp(tok_graph, "bits"))
+        graph->calc_type = IOG_ITEM_UNIT_BITS;
+    else if (g_str_has_prefix(tok_graph, "sum:"))
+        graph->calc_type = IOG_ITEM_UNIT_CALC_SUM;
+    else if (g_str_has_prefix(tok_graph, "frames:"))
+        graph->calc_type = IOG_ITEM_UNIT_CALC_FRAMES;
+    else if (g_str_has_prefix(tok_graph, "fields:"))
+        graph->calc_type = IOG_ITEM_UNIT_CALC_FIELDS;
+    else if (g_str_has_prefix(tok_graph, "max:"))
+        graph->calc_type = IOG_ITEM_UNIT_CALC_MAX;
+    else if (g_str_has_prefix(tok_graph, "min:"))
+        graph->calc_type = IOG_ITEM_UNIT_CALC_MIN;
+    else if (g_str_has_prefix(tok_graph, "avg:"))
+        graph->calc_type = IOG_ITEM_UNIT_CALC_AVERAGE;
+    else if (g_str_has_prefix(tok_graph, "load:"))
+        graph->calc_type = IOG_ITEM_UNIT_CALC_LOAD;
+    else
+        return FALSE;
+
+    field_name = strchr(tok_graph, ':');
+    if (field_name)
+        field_name = field_name + 1;
+
+    graph->interval = interval_ms;
+
+    graph->hf_index = -1;
+    graph->error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
+
+    graph->space_items = 0; /* TODO, can avoid realloc()s in sharkd_iograph_packet() by calculating: capture_time / interval */
+    graph->num_items = 0;
+    graph->items = NULL;
+
+    return TRUE;
+}
+
+/* Fill the items of a packets, bytes or bits graph without a filter from the time buckets. */
+static gboolean
+sharkd_iograph_fill_precomputed(struct sharkd_iograph *graph)
+{
+    const GArray *level;
+    guint32 level_interval, ratio;
+    gint64 last_idx;
+    int num_items;
+
+    if (graph->calc_type != IOG_ITEM_UNIT_PACKETS &&
+            graph->calc_type != IOG_ITEM_UNIT_BYTES &&
+            graph->calc_type != IOG_ITEM_UNIT_BITS)
+        return FALSE;
+
+    level = sharkd_session_pyramid_level(graph->interval, &level_interval);
+    if (!level)
+        return FALSE;
+
+    graph->precomputed = TRUE;
+    if (level->len == 0)
+        return TRUE;
+
+    ratio = graph->interval / level_interval;
+    last_idx = g_array_index(level, struct sharkd_time_bucket, level->len - 1).idx / ratio;
+    num_items = (int) MIN(last_idx + 1, SHARKD_IOGRAPH_MAX_ITEMS);
+
+    graph->items = g_new(io_graph_item_t, num_items);
+    reset_io_graph_items(graph->items, num_items);
+    graph->space_items = graph->num_items = num_items;
+
+    for (guint i = 0; i < level->len; i++)
+    {
+        const struct sharkd_time_bucket *bucket = &g_array_index(level, struct sharkd_time_bucket, i);
+        gint64 idx = bucket->idx / ratio;
+
+        if (idx >= num_items)
+            break;
+        graph->items[idx].frames += bucket->frames;
+        graph->items[idx].bytes += bucket->bytes;
+    }
+    return TRUE;
+}
+
+static void
+sharkd_iograph_dump_items(struct sharkd_iograph *graph)
+{
+    int idx;
+    int next_idx = 0;
+
+    sharkd_json_array_open("items");
+    for (idx = 0; idx < graph->num_items; idx++)
+    {
+        double val;
+
+        val = get_io_graph_item(graph->items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, graph->num_items);
+
+        /* if it's zero, don't display */
+        if (val == 0.0)
+            continue;
+
+        /* cause zeros are not printed, need to output index */
+        if (next_idx != idx)
+            sharkd_json_value_stringf(NULL, "%x", idx);
+
+        sharkd_json_value_anyf(NULL, "%f", val);
+        next_idx = idx + 1;
+    }
+    sharkd_json_array_close();
+}
+
+/**
+ * sharkd_session_process_tap_iograph_cb()
+ *
+ * Output iograph tap:
+ *   (m) tap          - tap name
+ *   (m) type:iograph - tap output type
+ *   (m) items        - graph values, as for the iograph request
+ */
+static void
+sharkd_session_process_tap_iograph_cb(void *tapdata)
+{
+    struct sharkd_iograph *graph = (struct sharkd_iograph *) tapdata;
+
+    json_dumper_begin_object(&dumper);
+    sharkd_json_value_string("tap", graph->tap_name);
+    sharkd_json_value_string("type", "iograph");
+    sharkd_iograph_dump_items(graph);
+    json_dumper_end_object(&dumper);
+}
+
+static void
+sharkd_session_free_tap_iograph_cb(void *tapdata)
+{
+    struct sharkd_iograph *graph = (struct sharkd_iograph *) tapdata;
+
+    g_free(graph->items);
+    g_free(graph);
+}
+
 /**
  * sharkd_session_process_tap()
  *
@@ -3382,6 +4363,13 @@ sharkd_session_eo_register_tap_listener(register_eo_t *eo, const char *tap_type,
  * Input:
  *   (m) tap0         - First tap request
  *   (o) tap1...tap15 - Other tap requests
+ *   (o) filter       - filter for all the taps
+ *   (o) interval     - interval time in ms for "iograph:<graph>" taps, if not specified: 1000ms
+ *
+ * All the taps are computed in one pass over the frames. The output is
+ * cached until the file, its comments or the preferences change, so a
+ * request repeated with the same taps and filter is answered without a
+ * pass at all.
  *
  * Output object with attributes:
  *   (m) taps  - array of object with attributes:
@@ -3399,6 +4387,7 @@ sharkd_session_eo_register_tap_listener(register_eo_t *eo, const char *tap_type,
  *                  for type:rtd see sharkd_session_process_tap_rtd_cb()
  *                  for type:srt see sharkd_session_process_tap_srt_cb()
  *                  for type:flow see sharkd_session_process_tap_flow_cb()
+ *                  for type:iograph see sharkd_session_process_tap_iograph_cb()
  *
  *   (m) err   - error code
  */
@@ -3410,10 +4399,51 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
     int taps_count = 0;
     int i;
     const char *tap_filter = json_find_attr(buf, tokens, count, "filter");
+    const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
+    guint32 interval_ms = 1000; /* default: one per second */
+    GString *cache_key;
+    gboolean cacheable = TRUE;
+    json_dumper saved_dumper;
+    GString *taps_json;
 
     rtpstream_tapinfo_t rtp_tapinfo =
     { NULL, NULL, NULL, NULL, 0, NULL, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE, FALSE};
 
+    if (tok_interval)
+        ws_strtou32(tok_interval, NULL, &interval_ms);
+
+    cache_key = g_string_new(NULL);
+    g_string_append_printf(cache_key, "%s\n%u\n", tap_filter ? tap_filter : "", interval_ms);
+    for (i = 0; i < 16; i++)
+    {
+        char tapbuf[32];
+        const char *tok_tap;
+
+        snprintf(tapbuf, sizeof(tapbuf), "tap%d", i);
+        tok_tap = json_find_attr(buf, tokens, count, tapbuf);
+        if (!tok_tap)
+            break;
+
+        /* The objects are kept for "download", and the next eo tap of the same type replaces them. */
+        if (!strncmp(tok_tap, "eo:", 3))
+            cacheable = FALSE;
+        g_string_append_printf(cache_key, "%s\n", tok_tap);
+    }
+
+    if (cacheable)
+    {
+        const char *cached = sharkd_session_tap_lookup(cache_key->str);
+
+        if (cached)
+        {
+            sharkd_json_result_prologue(rpcid);
+            sharkd_json_value_anyf("taps", "%s", cached);
+            sharkd_json_result_epilogue();
+            g_string_free(cache_key, TRUE);
+            return;
+        }
+    }
+
     for (i = 0; i < 16; i++)
     {
         char tapbuf[32];
@@ -3836,6 +4866,29 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
             tap_data = hosts_req;
             tap_free = sharkd_session_free_tap_hosts_cb;
         }
+        else if (!strncmp(tok_tap, "iograph:", 8))
+        {
+            struct sharkd_iograph *graph = g_new0(struct sharkd_iograph, 1);
+
+            if (!sharkd_iograph_init(graph, tok_tap + 8, interval_ms))
+            {
+                g_free(graph);
+                sharkd_json_error(
+                        rpcid, -11016, NULL,
+                        "sharkd_session_process_tap() iograph=%s not recognized", tok_tap
+                        );
+                g_string_free(cache_key, TRUE);
+                return;
+            }
+            graph->tap_name = tok_tap;
+
+            tap_error = graph->error;
+            if (!tap_error)
+                tap_error = register_tap_listener("frame", graph, tap_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, sharkd_session_process_tap_iograph_cb, NULL);
+
+            tap_data = graph;
+            tap_free = sharkd_session_free_tap_iograph_cb;
+        }
         else
         {
             sharkd_json_error(
@@ -3869,15 +4922,31 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
         sharkd_json_array_open("taps");
         sharkd_json_array_close();
         sharkd_json_result_epilogue();
+        g_string_free(cache_key, TRUE);
         return;
     }
 
-    sharkd_json_result_prologue(rpcid);
-    sharkd_json_array_open("taps");
+    /* The taps write their output to a string, which is kept in the cache. */
+    taps_json = g_string_new(NULL);
+    saved_dumper = dumper;
+    memset(&dumper, 0, sizeof(dumper));
+    dumper.output_string = taps_json;
+    json_dumper_begin_array(&dumper);
     sharkd_retap();
-    sharkd_json_array_close();
+    json_dumper_end_array(&dumper);
+    /* Not json_dumper_finish(), that would end the line. */
+    dumper = saved_dumper;
+
+    sharkd_json_result_prologue(rpcid);
+    sharkd_json_value_anyf("taps", "%s", taps_json->str);
     sharkd_json_result_epilogue();
 
+    if (cacheable)
+        sharkd_session_tap_add(cache_key->str, g_string_free(taps_json, FALSE));
+    else
+        g_string_free(taps_json, TRUE);
+    g_string_free(cache_key, TRUE);
+
     for (i = 0; i < taps_count; i++)
     {
         if (taps_data[i])
@@ -4003,8 +5072,49 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
     follow_info_free(follow_info);
 }
 
+/* Skip the nodes which aren't output, returns the first that is, or NULL. */
+static proto_node *
+sharkd_session_frame_tree_next(proto_node *node, gboolean display_hidden)
+{
+    for (; node; node = node->next)
+    {
+        field_info *finfo = PNODE_FINFO(node);
+
+        if (!finfo)
+            continue;
+
+        if (!display_hidden && FI_GET_FLAG(finfo, FI_HIDDEN))
+            continue;
+
+        return node;
+    }
+    return NULL;
+}
+
+/* Find the node at a path of dot separated indexes, e.g. "1.0.4", as numbered in the output. */
+static proto_tree *
+sharkd_session_frame_tree_find(proto_tree *tree, const char *path, gboolean display_hidden)
+{
+    while (tree && *path)
+    {
+        guint32 idx;
+        proto_node *node;
+
+        if (!ws_strtou32(path, &path, &idx) || (*path != '.' && *path != '\0'))
+            return NULL;
+        if (*path == '.')
+            path++;
+
+        node = sharkd_session_frame_tree_next(tree->first_child, display_hidden);
+        while (node && idx-- > 0)
+            node = sharkd_session_frame_tree_next(node->next, display_hidden);
+        tree = (proto_tree *) node;
+    }
+    return tree;
+}
+
 static void
-sharkd_session_process_frame_cb_tree(const char *key, epan_dissect_t *edt, proto_tree *tree, tvbuff_t **tvbs, gboolean display_hidden)
+sharkd_session_process_frame_cb_tree(const char *key, epan_dissect_t *edt, proto_tree *tree, tvbuff_t **tvbs, gboolean display_hidden, guint32 depth)
 {
     proto_node *node;
 
@@ -4108,7 +5218,10 @@ sharkd_session_process_frame_cb_tree(const char *key, epan_dissect_t *edt, proto
             if (finfo->tree_type != -1)
                 sharkd_json_value_anyf("e", "%d", finfo->tree_type);
 
-            sharkd_session_process_frame_cb_tree("n", edt, (proto_tree *) node, tvbs, display_hidden);
+            if (depth == 1)
+                sharkd_json_value_anyf("x", "true");
+            else
+                sharkd_session_process_frame_cb_tree("n", edt, (proto_tree *) node, tvbs, display_hidden, depth != 0 ? depth - 1 : 0);
         }
 
         json_dumper_end_object(&dumper);
@@ -4148,6 +5261,8 @@ sharkd_follower_visit_layers_cb(const void *key _U_, void *value, void *user_dat
 struct sharkd_frame_request_data
 {
     gboolean display_hidden;
+    guint32 depth;      /* levels of the tree to output, 0 for all */
+    const char *path;   /* output the subtree of this node, or NULL */
 };
 
 static void
@@ -4159,6 +5274,7 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
 
     const struct sharkd_frame_request_data * const req_data = (const struct sharkd_frame_request_data * const) data;
     const gboolean display_hidden = (req_data) ? req_data->display_hidden : FALSE;
+    const guint32 depth = (req_data) ? req_data->depth : 0;
 
     sharkd_json_result_prologue(rpcid);
 
@@ -4206,7 +5322,18 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
             tvbs[count] = NULL;
         }
 
-        sharkd_session_process_frame_cb_tree("tree", edt, tree, tvbs, display_hidden);
+        if (req_data && req_data->path)
+            tree = sharkd_session_frame_tree_find(tree, req_data->path, display_hidden);
+
+        if (tree)
+        {
+            sharkd_session_process_frame_cb_tree("tree", edt, tree, tvbs, display_hidden, depth);
+        }
+        else
+        {
+            sharkd_json_array_open("tree");
+            sharkd_json_array_close();
+        }
 
         g_free(tvbs);
     }
@@ -4310,58 +5437,6 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
     sharkd_json_result_epilogue();
 }
 
-#define SHARKD_IOGRAPH_MAX_ITEMS 250000 /* 250k limit of items is taken from wireshark-qt, on x86_64 sizeof(io_graph_item_t) is 152, so single graph can take max 36 MB */
-
-struct sharkd_iograph
-{
-    /* config */
-    int hf_index;
-    io_graph_item_unit_t calc_type;
-    guint32 interval;
-
-    /* result */
-    int space_items;
-    int num_items;
-    io_graph_item_t *items;
-    GString *error;
-};
-
-static tap_packet_status
-sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
-{
-    struct sharkd_iograph *graph = (struct sharkd_iograph *) g;
-    int idx;
-    gboolean update_succeeded;
-
-    idx = get_io_graph_index(pinfo, graph->interval);
-    if (idx < 0 || idx >= SHARKD_IOGRAPH_MAX_ITEMS)
-        return TAP_PACKET_DONT_REDRAW;
-
-    if (idx + 1 > graph->num_items)
-    {
-        if (idx + 1 > graph->space_items)
-        {
-            int new_size = idx + 1024;
-
-            graph->items = (io_graph_item_t *) g_realloc(graph->items, sizeof(io_graph_item_t) * new_size);
-            reset_io_graph_items(&graph->items[graph->space_items], new_size - graph->space_items);
-
-            graph->space_items = new_size;
-        }
-        else if (graph->items == NULL)
-        {
-            graph->items = g_new(io_graph_item_t, graph->space_items);
-            reset_io_graph_items(graph->items, graph->space_items);
-        }
-
-        graph->num_items = idx + 1;
-    }
-
-    update_succeeded = update_io_graph_item(graph->items, idx, pinfo, edt, graph->hf_index, graph->calc_type, graph->interval);
-    /* XXX - TAP_PACKET_FAILED if the item couldn't be updated, with an error message? */
-    return update_succeeded ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
-}
-
 /**
  * sharkd_session_process_iograph()
  *
@@ -4403,7 +5478,6 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         const char *tok_graph;
         const char *tok_filter;
         char tok_format_buf[32];
-        const char *field_name;
 
         snprintf(tok_format_buf, sizeof(tok_format_buf), "graph%d", i);
         tok_graph = json_find_attr(buf, tokens, count, tok_format_buf);
@@ -4413,41 +5487,15 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         snprintf(tok_format_buf, sizeof(tok_format_buf), "filter%d", i);
         tok_filter = json_find_attr(buf, tokens, count, tok_format_buf);
 
-        if (!strcmp(tok_graph, "packets"))
-            graph->calc_type = IOG_ITEM_UNIT_PACKETS;
-        else if (!strcmp(tok_graph, "bytes"))
-            graph->calc_type = IOG_ITEM_UNIT_BYTES;
-        else if (!strcmp(tok_graph, "bits"))
-            graph->calc_type = IOG_ITEM_UNIT_BITS;
-        else if (g_str_has_prefix(tok_graph, "sum:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_SUM;
-        else if (g_str_has_prefix(tok_graph, "frames:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_FRAMES;
-        else if (g_str_has_prefix(tok_graph, "fields:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_FIELDS;
-        else if (g_str_has_prefix(tok_graph, "max:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_MAX;
-        else if (g_str_has_prefix(tok_graph, "min:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_MIN;
-        else if (g_str_has_prefix(tok_graph, "avg:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_AVERAGE;
-        else if (g_str_has_prefix(tok_graph, "load:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_LOAD;
-        else
+        if (!sharkd_iograph_init(graph, tok_graph, interval_ms))
             break;
+        graph->precomputed = FALSE;
 
-        field_name = strchr(tok_graph, ':');
-        if (field_name)
-            field_name = field_name + 1;
-
-        graph->interval = interval_ms;
-
-        graph->hf_index = -1;
-        graph->error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
-
-        graph->space_items = 0; /* TODO, can avoid realloc()s in sharkd_iograph_packet() by calculating: capture_time / interval */
-        graph->num_items = 0;
-        graph->items = NULL;
+        if (!graph->error && !tok_filter && sharkd_iograph_fill_precomputed(graph))
+        {
+            graph_count++;
+            continue;
+        }
 
         if (!graph->error)
             graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
@@ -4489,32 +5537,12 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         }
         else
         {
-            int idx;
-            int next_idx = 0;
-
-            sharkd_json_array_open("items");
-            for (idx = 0; idx < graph->num_items; idx++)
-            {
-                double val;
-
-                val = get_io_graph_item(graph->items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, graph->num_items);
-
-                /* if it's zero, don't display */
-                if (val == 0.0)
-                    continue;
-
-                /* cause zeros are not printed, need to output index */
-                if (next_idx != idx)
-                    sharkd_json_value_stringf(NULL, "%x", idx);
-
-                sharkd_json_value_anyf(NULL, "%f", val);
-                next_idx = idx + 1;
-            }
-            sharkd_json_array_close();
+            sharkd_iograph_dump_items(graph);
         }
         json_dumper_end_object(&dumper);
 
-        remove_tap_listener(graph);
+        if (!graph->precomputed)
+            remove_tap_listener(graph);
         g_free(graph->items);
     }
     sharkd_json_array_close();
@@ -4550,6 +5578,9 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
     const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
 
     const guint8 *filter_data = NULL;
+    const GArray *level = NULL;
+    guint32 level_interval = 0;
+    guint32 n;
 
     struct
     {
@@ -4596,19 +5627,39 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
 
     start_ts = (cfile.count >= 1) ? &(sharkd_get_frame(1)->abs_ts) : NULL;
 
-    for (guint32 framenum = 1; framenum <= cfile.count; framenum++)
+    /* Without a filter, go through the time buckets instead of the frames. */
+    if (!filter_data)
+        level = sharkd_session_pyramid_level(interval_ms, &level_interval);
+    n = level ? level->len : cfile.count;
+
+    for (guint32 i = 0; i < n; i++)
     {
-        frame_data *fdata;
-        gint64 msec_rel;
+        unsigned int frames;
+        guint64 bytes;
         gint64 new_idx;
 
-        if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
-            continue;
+        if (level)
+        {
+            const struct sharkd_time_bucket *bucket = &g_array_index(level, struct sharkd_time_bucket, i);
+
+            new_idx = bucket->idx / (interval_ms / level_interval);
+            frames = bucket->frames;
+            bytes = bucket->bytes;
+        }
+        else
+        {
+            guint32 framenum = i + 1;
+            frame_data *fdata;
+
+            if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
+                continue;
 
-        fdata = sharkd_get_frame(framenum);
+            fdata = sharkd_get_frame(framenum);
 
-        msec_rel = (fdata->abs_ts.secs - start_ts->secs) * (gint64) 1000 + (fdata->abs_ts.nsecs - start_ts->nsecs) / 1000000;
-        new_idx  = msec_rel / interval_ms;
+            new_idx = sharkd_frame_rel_msec(fdata, start_ts) / interval_ms;
+            frames = 1;
+            bytes = fdata->pkt_len;
+        }
 
         if (idx != new_idx)
         {
@@ -4625,11 +5676,11 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
             st.bytes  = 0;
         }
 
-        st.frames += 1;
-        st.bytes  += fdata->pkt_len;
+        st.frames += frames;
+        st.bytes  += bytes;
 
-        st_total.frames += 1;
-        st_total.bytes  += fdata->pkt_len;
+        st_total.frames += frames;
+        st_total.bytes  += bytes;
     }
 
     if (st.frames != 0)
@@ -4659,6 +5710,11 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
  *   (o) color - set if output color-filter bg/fg
  *   (o) bytes - set if output frame bytes
  *   (o) hidden - set if output hidden tree fields
+ *   (o) depth - with proto, output only this many levels of the tree
+ *   (o) path - with proto, output only the subtree of the node at this path of dot separated
+ *              node indexes (e.g. "2.0"), as numbered in the output; the levels of depth start below it
+ *   (o) fields - with proto, comma separated list of fields: the tree is built with only those
+ *                fields, which saves dissection time and output for big frames
  *
  * Output object with attributes:
  *   (m) err   - 0 if succeed
@@ -4678,6 +5734,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
  *                  fnum - only for t:'framenum', frame number
  *                  g - if field is generated by Wireshark
  *                  v - if field is hidden
+ *                  x - if the node has subtree nodes, not output because of depth
  *
  *   (o) col   - array of column data
  *   (o) bytes - base64 of frame bytes
@@ -4697,7 +5754,10 @@ sharkd_session_process_frame(char *buf, const jsmntok_t *tokens, int count)
     const char *tok_frame = json_find_attr(buf, tokens, count, "frame");
     const char *tok_ref_frame = json_find_attr(buf, tokens, count, "ref_frame");
     const char *tok_prev_frame = json_find_attr(buf, tokens, count, "prev_frame");
+    const char *tok_depth = json_find_attr(buf, tokens, count, "depth");
+    const char *tok_fields = json_find_attr(buf, tokens, count, "fields");
     column_info *cinfo = NULL;
+    GArray *tree_fields = NULL;
 
     guint32 framenum, ref_frame_num, prev_dis_num;
     guint32 dissect_flags = SHARKD_DISSECT_FLAG_NULL;
@@ -4750,12 +5810,43 @@ sharkd_session_process_frame(char *buf, const jsmntok_t *tokens, int count)
         dissect_flags |= SHARKD_DISSECT_FLAG_COLOR;
 
     req_data.display_hidden = (json_find_attr(buf, tokens, count, "v") != NULL);
+    req_data.depth = 0;
+    if (tok_depth)
+        ws_strtou32(tok_depth, NULL, &req_data.depth);
+    req_data.path = json_find_attr(buf, tokens, count, "path");
+
+    if (tok_fields)
+    {
+        gchar **names = g_strsplit(tok_fields, ",", -1);
+
+        tree_fields = g_array_new(FALSE, FALSE, sizeof(int));
+        for (guint i = 0; names[i] != NULL; i++)
+        {
+            header_field_info *hfinfo;
+
+            g_strstrip(names[i]);
+            hfinfo = proto_registrar_get_byname(names[i]);
+            if (!hfinfo)
+            {
+                sharkd_json_error(
+                        rpcid, -8004, NULL,
+                        "Invalid fields - The field %s doesn't exist", names[i]
+                        );
+                g_strfreev(names);
+                g_array_free(tree_fields, TRUE);
+                return;
+            }
+            for (; hfinfo; hfinfo = hfinfo->same_name_next)
+                g_array_append_val(tree_fields, hfinfo->id);
+        }
+        g_strfreev(names);
+    }
 
     wtap_rec_init(&rec);
     ws_buffer_init(&rec_buf, 1514);
 
     status = sharkd_dissect_request(framenum, ref_frame_num, prev_dis_num,
-            &rec, &rec_buf, cinfo, dissect_flags,
+            &rec, &rec_buf, cinfo, dissect_flags, tree_fields,
             &sharkd_session_process_frame_cb, &req_data, &err, &err_info);
     switch (status) {
 
@@ -4780,6 +5871,8 @@ sharkd_session_process_frame(char *buf, const jsmntok_t *tokens, int count)
             break;
     }
 
+    if (tree_fields)
+        g_array_free(tree_fields, TRUE);
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&rec_buf);
 }
@@ -4894,6 +5987,41 @@ sharkd_session_process_complete_pref_option_cb(pref_t *pref, gpointer d)
     return 0; /* continue */
 }
 
+static gboolean
+sharkd_session_process_complete_field_cb(header_field_info *hfinfo, void *d)
+{
+    const int filter_with_dot = *(const int *) d;
+    protocol_t *protocol;
+
+    /* Protocols are always offered, their fields only once a dot has been typed */
+    if (hfinfo->parent != -1 && !filter_with_dot)
+        return TRUE;
+
+    protocol = find_protocol_by_id(hfinfo->parent == -1 ? hfinfo->id : hfinfo->parent);
+    if (!proto_is_protocol_enabled(protocol))
+        return TRUE;
+
+    json_dumper_begin_object(&dumper);
+    {
+        sharkd_json_value_string("f", hfinfo->abbrev);
+
+        if (hfinfo->parent == -1)
+        {
+            sharkd_json_value_anyf("t", "%d", FT_PROTOCOL);
+            sharkd_json_value_string("n", proto_get_protocol_long_name(protocol));
+        }
+        /* XXX, skip displaying name, if there are multiple (to not confuse user) */
+        else if (hfinfo->same_name_next == NULL)
+        {
+            sharkd_json_value_anyf("t", "%d", hfinfo->type);
+            sharkd_json_value_string("n", hfinfo->name);
+        }
+    }
+    json_dumper_end_object(&dumper);
+
+    return TRUE;
+}
+
 /**
  * sharkd_session_process_complete()
  *
@@ -4923,64 +6051,11 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 
     if (tok_field != NULL && tok_field[0])
     {
-        const size_t filter_length = strlen(tok_field);
-        const int filter_with_dot = !!strchr(tok_field, '.');
-
-        void *proto_cookie;
-        void *field_cookie;
-        int proto_id;
+        int filter_with_dot = !!strchr(tok_field, '.');
 
         sharkd_json_array_open("field");
 
-        for (proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie))
-        {
-            protocol_t *protocol = find_protocol_by_id(proto_id);
-            const char *protocol_filter;
-            const char *protocol_name;
-            header_field_info *hfinfo;
-
-            if (!proto_is_protocol_enabled(protocol))
-                continue;
-
-            protocol_name   = proto_get_protocol_long_name(protocol);
-            protocol_filter = proto_get_protocol_filter_name(proto_id);
-
-            if (strlen(protocol_filter) >= filter_length && !g_ascii_strncasecmp(tok_field, protocol_filter, filter_length))
-            {
-                json_dumper_begin_object(&dumper);
-                {
-                    sharkd_json_value_string("f", protocol_filter);
-                    sharkd_json_value_anyf("t", "%d", FT_PROTOCOL);
-                    sharkd_json_value_string("n", protocol_name);
-                }
-                json_dumper_end_object(&dumper);
-            }
-
-            if (!filter_with_dot)
-                continue;
-
-            for (hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo != NULL; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie))
-            {
-                if (hfinfo->same_name_prev_id != -1) /* ignore duplicate names */
-                    continue;
-
-                if (strlen(hfinfo->abbrev) >= filter_length && !g_ascii_strncasecmp(tok_field, hfinfo->abbrev, filter_length))
-                {
-                    json_dumper_begin_object(&dumper);
-                    {
-                        sharkd_json_value_string("f", hfinfo->abbrev);
-
-                        /* XXX, skip displaying name, if there are multiple (to not confuse user) */
-                        if (hfinfo->same_name_next == NULL)
-                        {
-                            sharkd_json_value_anyf("t", "%d", hfinfo->type);
-                            sharkd_json_value_string("n", hfinfo->name);
-                        }
-                    }
-                    json_dumper_end_object(&dumper);
-                }
-            }
-        }
+        proto_registrar_foreach_prefix(tok_field, sharkd_session_process_complete_field_cb, &filter_with_dot);
 
         sharkd_json_array_close();
     }
@@ -5078,6 +6153,7 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
     else
     {
         sharkd_set_modified_block(fdata, pkt_block);
+        sharkd_session_caches_clear();
         sharkd_json_simple_ok(rpcid);
     }
 }
@@ -5129,6 +6205,7 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
     switch (ret)
     {
         case PREFS_SET_OK:
+            sharkd_session_caches_clear();
             sharkd_json_simple_ok(rpcid);
             break;
 
@@ -5770,9 +6847,343 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
     }
 }
 
+#ifndef _WIN32
+/*
+ * Requests with "async":true run in a forked child, so that the session
+ * can go on with other requests meanwhile.  The child writes its response,
+ * and "progress" notifications, into a pipe, as JSON lines; the session
+ * sends them on a line at a time when it is waiting for the next request.
+ */
+struct sharkd_async_request {
+    guint32   id;
+    pid_t     pid;
+    int       fd;
+    GString  *pending;      /* Output of the child after the last complete line */
+    gboolean  cancelled;
+};
+
+static GPtrArray *async_requests;
+
+/* Set in the child running an asynchronous request. */
+static gboolean in_async_request;
+
+enum async_start_status {
+    ASYNC_START_FAILED,
+    ASYNC_START_PARENT,
+    ASYNC_START_CHILD
+};
+
+static void
+sharkd_session_async_progress(guint32 framenum, guint32 frames_count)
+{
+    json_dumper progress_dumper = { 0 };
+
+    /* Don't interleave a notification with a response being written out. */
+    if (dumper.output_file != NULL && dumper.current_depth != 0)
+        return;
+
+    progress_dumper.output_string = g_string_new(NULL);
+    json_dumper_begin_object(&progress_dumper);
+    json_dumper_set_member_name(&progress_dumper, "jsonrpc");
+    json_dumper_value_string(&progress_dumper, "2.0");
+    json_dumper_set_member_name(&progress_dumper, "method");
+    json_dumper_value_string(&progress_dumper, "progress");
+    json_dumper_set_member_name(&progress_dumper, "params");
+    json_dumper_begin_object(&progress_dumper);
+    json_dumper_set_member_name(&progress_dumper, "id");
+    json_dumper_value_anyf(&progress_dumper, "%u", rpcid);
+    json_dumper_set_member_name(&progress_dumper, "frames");
+    json_dumper_value_anyf(&progress_dumper, "%u", framenum);
+    json_dumper_set_member_name(&progress_dumper, "total");
+    json_dumper_value_anyf(&progress_dumper, "%u", frames_count);
+    json_dumper_end_object(&progress_dumper);
+    json_dumper_end_object(&progress_dumper);
+    sharkd_session_write_message(progress_dumper.output_string->str, progress_dumper.output_string->len);
+    g_string_free(progress_dumper.output_string, TRUE);
+}
+
+static enum async_start_status
+sharkd_session_async_start(void)
+{
+    struct sharkd_async_request *req;
+    int fds[2];
+    pid_t pid;
+
+    if (pipe(fds) == -1)
+        return ASYNC_START_FAILED;
+
+    /* Don't let the child write out anything still buffered. */
+    fflush(stdout);
+
+    pid = fork();
+    if (pid == -1)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return ASYNC_START_FAILED;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        for (guint i = 0; i < async_requests->len; i++)
+            close(((struct sharkd_async_request *) g_ptr_array_index(async_requests, i))->fd);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+
+        in_async_request = TRUE;
+        /* The session splits the output at newlines, and frames it itself. */
+        sharkd_session_set_framing(FALSE, FALSE);
+        sharkd_set_progress_func(sharkd_session_async_progress);
+        return ASYNC_START_CHILD;
+    }
+
+    close(fds[1]);
+
+    req = g_new0(struct sharkd_async_request, 1);
+    req->id = rpcid;
+    req->pid = pid;
+    req->fd = fds[0];
+    req->pending = g_string_new(NULL);
+    g_ptr_array_add(async_requests, req);
+
+    return ASYNC_START_PARENT;
+}
+
+static void
+sharkd_session_async_finish(struct sharkd_async_request *req)
+{
+    gboolean completed;
+    int status;
+
+    close(req->fd);
+
+    if (waitpid(req->pid, &status, 0) == req->pid)
+        completed = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    else
+        /* Already reaped, the daemon may ignore SIGCHLD. */
+        completed = !req->cancelled;
+
+    if (!completed)
+    {
+        if (req->cancelled)
+            sharkd_json_error(req->id, -32800, NULL, "Request cancelled");
+        else
+            sharkd_json_error(req->id, -32603, NULL, "Request failed");
+    }
+
+    g_string_free(req->pending, TRUE);
+    g_free(req);
+}
+
+/* Copy what a child has written so far, returns FALSE once it is done. */
+static gboolean
+sharkd_session_async_forward(struct sharkd_async_request *req)
+{
+    char buf[4096];
+    ssize_t len;
+    const char *line, *end;
+
+    len = read(req->fd, buf, sizeof(buf));
+    if (len < 0)
+        return errno == EINTR || errno == EAGAIN;
+    if (len == 0)
+        return FALSE;
+
+    g_string_append_len(req->pending, buf, len);
+    line = req->pending->str;
+    while ((end = strchr(line, '\n')) != NULL)
+    {
+        sharkd_session_write_message(line, end - line);
+        line = end + 1;
+    }
+    g_string_erase(req->pending, 0, line - req->pending->str);
+    return TRUE;
+}
+
+static void
+sharkd_session_async_cleanup(void)
+{
+    while (async_requests->len > 0)
+    {
+        struct sharkd_async_request *req = (struct sharkd_async_request *) g_ptr_array_index(async_requests, 0);
+
+        g_ptr_array_remove_index(async_requests, 0);
+
+        kill(req->pid, SIGTERM);
+        close(req->fd);
+        waitpid(req->pid, NULL, 0);
+        g_string_free(req->pending, TRUE);
+        g_free(req);
+    }
+}
+#endif
+
+/*
+ * Wait until there's a request to read, in the meantime passing on the
+ * output of the asynchronous requests.  Returns FALSE on error.
+ */
+static gboolean
+sharkd_session_wait_for_request(void)
+{
+#ifndef _WIN32
+    while (async_requests->len > 0)
+    {
+        struct pollfd *fds;
+        guint nfds = async_requests->len + 1;
+        int ret;
+
+        fds = g_new0(struct pollfd, nfds);
+        fds[0].fd = STDIN_FILENO;
+        fds[0].events = POLLIN;
+        for (guint i = 1; i < nfds; i++)
+        {
+            fds[i].fd = ((struct sharkd_async_request *) g_ptr_array_index(async_requests, i - 1))->fd;
+            fds[i].events = POLLIN;
+        }
+
+        ret = poll(fds, nfds, -1);
+        if (ret < 0)
+        {
+            g_free(fds);
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+
+        /* Backwards, so that finished requests can be removed. */
+        for (guint i = nfds - 1; i > 0; i--)
+        {
+            struct sharkd_async_request *req = (struct sharkd_async_request *) g_ptr_array_index(async_requests, i - 1);
+
+            if (fds[i].revents == 0)
+                continue;
+            if (!sharkd_session_async_forward(req))
+            {
+                g_ptr_array_remove_index(async_requests, i - 1);
+                sharkd_session_async_finish(req);
+            }
+        }
+
+        if (fds[0].revents != 0)
+        {
+            g_free(fds);
+            return TRUE;
+        }
+        g_free(fds);
+    }
+#endif
+    return TRUE;
+}
+
+/**
+ * sharkd_session_process_framing()
+ *
+ * Process framing request - choose how the following responses are sent.
+ *
+ * Input:
+ *   (o) format   - "json" (default) or "cbor"
+ *   (o) compress - "none" (default) or "zstd"
+ *
+ * Output object with attributes:
+ *   (m) status - "OK", sent the old way
+ *
+ * With anything but "json" and "none", each response after this one is
+ * sent as a frame: a 4 byte big-endian length of the payload, a byte of
+ * flags (1: CBOR, 2: zstd compressed), and the payload.  Requests are
+ * still JSON lines.
+ */
+static void
+sharkd_session_process_framing(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_format = json_find_attr(buf, tokens, count, "format");
+    const char *tok_compress = json_find_attr(buf, tokens, count, "compress");
+    gboolean cbor = FALSE;
+    gboolean zstd = FALSE;
+
+    if (tok_format && !strcmp(tok_format, "cbor"))
+        cbor = TRUE;
+    else if (tok_format && strcmp(tok_format, "json"))
+    {
+        sharkd_json_error(
+                rpcid, -15001, NULL,
+                "Unknown format %s", tok_format
+                );
+        return;
+    }
+
+    if (tok_compress && !strcmp(tok_compress, "zstd"))
+    {
+#ifdef HAVE_ZSTD
+        zstd = TRUE;
+#else
+        sharkd_json_error(
+                rpcid, -15002, NULL,
+                "zstd compression is not supported"
+                );
+        return;
+#endif
+    }
+    else if (tok_compress && strcmp(tok_compress, "none"))
+    {
+        sharkd_json_error(
+                rpcid, -15003, NULL,
+                "Unknown compression %s", tok_compress
+                );
+        return;
+    }
+
+    sharkd_json_simple_ok(rpcid);
+    sharkd_session_set_framing(cbor, zstd);
+}
+
+/**
+ * sharkd_session_process_cancel()
+ *
+ * Process cancel request
+ *
+ * Input:
+ *   (m) request - id of the asynchronous request to cancel
+ *
+ * Output object with attributes:
+ *   (m) status - "OK"
+ *
+ * The cancelled request gets an error response (-32800).
+ */
+static void
+sharkd_session_process_cancel(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_request = json_find_attr(buf, tokens, count, "request");
+    guint32 id = 0;
+
+    ws_strtou32(tok_request, NULL, &id);
+
+#ifndef _WIN32
+    for (guint i = 0; i < async_requests->len; i++)
+    {
+        struct sharkd_async_request *req = (struct sharkd_async_request *) g_ptr_array_index(async_requests, i);
+
+        if (req->id == id && !req->cancelled)
+        {
+            kill(req->pid, SIGTERM);
+            req->cancelled = TRUE;
+            sharkd_json_simple_ok(rpcid);
+            return;
+        }
+    }
+#endif
+
+    sharkd_json_error(
+            rpcid, -14001, NULL,
+            "No request with id %u is running", id
+            );
+}
+
 static void
 sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 {
+    int64_t trace_start = ws_trace_begin();
+
     if (json_prep(buf, tokens, count))
     {
         /* don't need [0] token */
@@ -5787,6 +7198,16 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
                     "No method found");
             return;
         }
+
+#ifndef _WIN32
+        const char *tok_async = json_find_attr(buf, tokens, count, "async");
+
+        /* If the child can't be started, the request is just run here. */
+        if (tok_async && !strcmp(tok_async, "true") && !in_async_request &&
+                sharkd_session_async_start() == ASYNC_START_PARENT)
+            return;
+#endif
+
         if (!strcmp(tok_method, "load"))
             sharkd_session_process_load(buf, tokens, count);
         else if (!strcmp(tok_method, "status"))
@@ -5819,9 +7240,20 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
             sharkd_session_process_dumpconf(buf, tokens, count);
         else if (!strcmp(tok_method, "download"))
             sharkd_session_process_download(buf, tokens, count);
+        else if (!strcmp(tok_method, "cancel"))
+            sharkd_session_process_cancel(buf, tokens, count);
+        else if (!strcmp(tok_method, "framing"))
+            sharkd_session_process_framing(buf, tokens, count);
+        else if (!strcmp(tok_method, "topvalues"))
+            sharkd_session_process_topvalues(buf, tokens, count);
         else if (!strcmp(tok_method, "bye"))
         {
             sharkd_json_simple_ok(rpcid);
+#ifndef _WIN32
+            sharkd_session_async_cleanup();
+#endif
+            /* exit() skips epan_cleanup(), which would write the trace. */
+            ws_trace_finish();
             exit(0);
         }
         else
@@ -5831,6 +7263,17 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
                     "The method \"%s\" is unknown", tok_method
                     );
         }
+
+        /* The method name is in the request buffer, which is reused. */
+        ws_trace_end("sharkd", "sharkd_session_process", trace_start);
+
+#ifndef _WIN32
+        if (in_async_request)
+        {
+            fflush(stdout);
+            _exit(0);
+        }
+#endif
     }
 }
 
@@ -5839,7 +7282,7 @@ sharkd_session_main(int mode_setting)
 {
     char buf[2 * 1024];
     jsmntok_t *tokens = NULL;
-    int tokens_max = -1;
+    unsigned int tokens_max = 0;
 
     mode = mode_setting;
 
@@ -5848,6 +7291,8 @@ sharkd_session_main(int mode_setting)
     dumper.output_file = stdout;
 
     filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+    row_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, sharkd_session_row_free);
+    tap_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_tap_free);
 
 #ifdef HAVE_MAXMINDDB
     /* mmdbresolve was stopped before fork(), force starting it */
@@ -5856,38 +7301,23 @@ sharkd_session_main(int mode_setting)
 
     set_resolution_synchrony(TRUE);
 
-    while (fgets(buf, sizeof(buf), stdin))
+#ifndef _WIN32
+    async_requests = g_ptr_array_new();
+    /* Requests are read from stdin after poll() says there's something to read. */
+    setvbuf(stdin, NULL, _IONBF, 0);
+#endif
+
+    while (sharkd_session_wait_for_request() && fgets(buf, sizeof(buf), stdin))
     {
         /* every command is line separated JSON */
         int ret;
 
-        ret = json_parse(buf, NULL, 0);
-        if (ret <= 0)
-        {
-            sharkd_json_error(
-                    rpcid, -32600, NULL,
-                    "Invalid JSON(1)"
-                    );
-            continue;
-        }
-
-        /* fprintf(stderr, "JSON: %d tokens\n", ret); */
-        ret += 1;
-
-        if (tokens == NULL || tokens_max < ret)
-        {
-            tokens_max = ret;
-            tokens = (jsmntok_t *) g_realloc(tokens, sizeof(jsmntok_t) * tokens_max);
-        }
-
-        memset(tokens, 0, ret * sizeof(jsmntok_t));
-
-        ret = json_parse(buf, tokens, ret);
+        ret = json_parse_alloc(buf, strlen(buf), &tokens, &tokens_max);
         if (ret <= 0)
         {
             sharkd_json_error(
                     rpcid, -32600, NULL,
-                    "Invalid JSON(2)"
+                    "Invalid JSON"
                     );
             continue;
         }
@@ -5895,9 +7325,20 @@ sharkd_session_main(int mode_setting)
         host_name_lookup_process();
 
         sharkd_session_process(buf, tokens, ret);
+        sharkd_session_caches_trim();
     }
 
+#ifndef _WIN32
+    sharkd_session_async_cleanup();
+    g_ptr_array_free(async_requests, TRUE);
+#endif
+
     g_hash_table_destroy(filter_table);
+    g_hash_table_destroy(row_table);
+    g_hash_table_destroy(tap_table);
+    sharkd_session_pyramid_free();
+    if (framing_buf)
+        g_string_free(framing_buf, TRUE);
     g_free(tokens);
 
     return 0;
@@ -28,6 +28,15 @@ def pytest_addoption(parser):
     parser.addoption('--enable-release', action='store_true',
         help='Enable release tests'
     )
+    parser.addoption('--enable-performance', action='store_true',
+        help='Enable performance tests'
+    )
+    parser.addoption('--performance-baselines',
+        help='File with the performance baselines to compare against.'
+    )
+    parser.addoption('--update-performance-baselines', action='store_true',
+        help='Record the performance test results as the new baselines'
+    )
 
 from fixtures_ws import *
 
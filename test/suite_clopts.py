@@ -128,6 +128,48 @@ class TestTsharkOptions:
         assert obj.get('ip.proto', 'NOT FOUND') == ['6']
         assert obj.get('http.host', 'NOT FOUND') == 'NOT FOUND'
 
+    def test_tshark_flow_partition(self, cmd_tshark, capture_file, test_env):
+        '''--flow-partition splits the frames between the partitions'''
+        def frames(*extra_args):
+            process = subprocesstest.run((cmd_tshark, "-r", capture_file("dns+icmp.pcapng.gz"),
+                        "-Tfields", "-eframe.number", "-eframe.time_relative",
+                        ) + extra_args, capture_output=True, env=test_env)
+            assert process.returncode == ExitCodes.OK
+            return process.stdout.splitlines()
+        all_frames = frames()
+        partitions = [frames("--flow-partition", "{}/3".format(n)) for n in (1, 2, 3)]
+        # Each frame is in exactly one partition, with the same number and time.
+        assert sorted(sum(partitions, []), key=lambda line: int(line.split()[0])) == all_frames
+        assert sum(1 for part in partitions if part) > 1
+
+    def test_tshark_only_wanted_protocols(self, cmd_tshark, capture_file, test_env):
+        '''--only-wanted-protocols stops after the protocols of the fields'''
+        process = subprocesstest.run((cmd_tshark, "-r", capture_file("http.pcap"),
+                    "--only-wanted-protocols",
+                    "-Tfields", "-eframe.protocols", "-eip.src",
+                    ), capture_output=True, env=test_env)
+        assert process.returncode == ExitCodes.OK
+        protocols, ip_src = process.stdout.splitlines()[0].split('\t')
+        assert protocols == 'eth:ethertype:ip'
+        assert ip_src == '10.0.0.5'
+
+    def test_tshark_column_fields(self, cmd_tshark, capture_file, test_env):
+        '''Columns used by fields and filters are filled in without the others'''
+        process = subprocesstest.run((cmd_tshark, "-r", capture_file("http.pcap"),
+                    "-Y", '_ws.col.protocol == "HTTP"',
+                    "-Tfields", "-e_ws.col.protocol",
+                    ), capture_output=True, env=test_env)
+        assert process.returncode == ExitCodes.OK
+        lines = process.stdout.splitlines()
+        assert lines
+        assert all(line == 'HTTP' for line in lines)
+
+    def test_tshark_flow_partition_invalid(self, cmd_tshark, capture_file, test_env):
+        '''--flow-partition with an out-of-range partition'''
+        process = subprocesstest.run((cmd_tshark, "-r", capture_file("dns+icmp.pcapng.gz"),
+                    "--flow-partition", "4/3"), env=test_env)
+        assert process.returncode == ExitCodes.COMMAND_LINE
+
 
 class TestTsharkCaptureClopts:
     def test_tshark_invalid_capfilter(self, cmd_tshark, capture_interface, result_file, test_env):
@@ -155,6 +155,26 @@ class TestDfilterInteger:
         dfilter = "ntp.precision <= -10"
         checkDFilterCount(dfilter, 1)
 
+    def test_u_reversed_1(self, checkDFilterCount):
+        dfilter = "4 == ip.version"
+        checkDFilterCount(dfilter, 1)
+
+    def test_u_reversed_2(self, checkDFilterCount):
+        dfilter = "5 > ip.version"
+        checkDFilterCount(dfilter, 1)
+
+    def test_u_reversed_3(self, checkDFilterCount):
+        dfilter = "4 > ip.version"
+        checkDFilterCount(dfilter, 0)
+
+    def test_s_reversed_1(self, checkDFilterCount):
+        dfilter = "-12 < ntp.precision"
+        checkDFilterCount(dfilter, 1)
+
+    def test_s_reversed_2(self, checkDFilterCount):
+        dfilter = "-11 < ntp.precision"
+        checkDFilterCount(dfilter, 0)
+
     def test_bool_eq_1(self, checkDFilterCount):
         dfilter = "ip.flags.df == 0"
         checkDFilterCount(dfilter, 1)
@@ -86,6 +86,18 @@ class TestDfilterMembership:
         dfilter = 'ip.addr in { 10.0.0.5 .. 10.0.0.9 , 10.0.0.1..10.0.0.1 }'
         checkDFilterCount(dfilter, 1)
 
+    def test_membership_8_ip_hosts(self, checkDFilterCount):
+        dfilter = 'ip.addr in { 192.168.0.1, 10.0.0.1, 172.16.0.1 }'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_8_ip_subnet(self, checkDFilterCount):
+        dfilter = 'ip.addr in { 192.168.0.1, 10.0.0.0/24 }'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_8_ip_no_match(self, checkDFilterCount):
+        dfilter = 'ip.addr in { 192.168.0.1, 10.0.1.0/24 }'
+        checkDFilterCount(dfilter, 0)
+
     def test_membership_9_range_invalid_float(self, checkDFilterFail):
         # expression should be parsed as "0.1 .. .7"
         # .7 is the identifier (protocol) named "7"
@@ -106,6 +106,21 @@ class TestMergecapPcap:
         ), capture_output=True, encoding='utf-8', env=test_env)
         check_mergecap(mergecap_proc, 'pcap', 'Ethernet', 62, 1, 62, cmd_capinfos, testout_file, test_env)
 
+    def test_mergecap_basic_5_chronological_pcap_pcap(self, cmd_mergecap, capture_file, result_file, cmd_capinfos, test_env):
+        '''Merge five pcap files to pcap, checking the output is in time order'''
+        testout_file = result_file(testout_pcap)
+        mergecap_proc = subprocess.run((cmd_mergecap,
+            '-V',
+            '-F', 'pcap',
+            '-w', testout_file,
+            capture_file('rsasnakeoil2.pcap'), capture_file('dhcp.pcap'),
+            capture_file('empty.pcap'), capture_file('dhcp-nanosecond.pcap'),
+            capture_file('dhcp.pcap'),
+        ), capture_output=True, encoding='utf-8', env=test_env)
+        check_mergecap(mergecap_proc, 'pcap', 'Ethernet', 70, 1, 70, cmd_capinfos, testout_file, test_env)
+        capinfos_stdout = subprocess.check_output([cmd_capinfos, '-o', testout_file], encoding='utf-8', env=test_env)
+        assert re.search(r'Strict time order:\s+True', capinfos_stdout)
+
 
 class TestMergecapPcapng:
     def test_mergecap_basic_1_pcap_pcapng(self, cmd_mergecap, capture_file, result_file, cmd_capinfos, test_env):
@@ -0,0 +1,269 @@
+#
+# Wireshark tests
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Performance tests
+
+These measure how fast tshark, dftest and sharkd are on a fixed set of
+captures and compare the results against baselines recorded earlier on
+the same machine. They are skipped unless --enable-performance is passed
+on the command line, and should be run without parallelism (-n0), since
+other tests running at the same time distort the timings.
+
+Record baselines with --update-performance-baselines. They're stored in
+the file given by --performance-baselines, the "performance.json" file in
+the baseline directory by default.
+'''
+
+import hashlib
+import json
+import os
+import statistics
+import subprocess
+import sys
+import time
+import pytest
+
+
+# The captures the tests read, concatenated PERFORMANCE_REPEAT times.
+# Baselines record a digest of these, so that changing them doesn't
+# silently shift the numbers.
+PERFORMANCE_CAPTURES = (
+    'dhcp.pcap',
+    'dns+icmp.pcapng.gz',
+    'http.pcap',
+    'netperfmeter.pcapng.gz',
+    'nfs.pcap',
+    'segmented_fpm.pcap',
+    'sip-rtp.pcapng',
+    'tftp.pcap',
+)
+PERFORMANCE_REPEAT = 200
+
+# Each measurement is repeated and the best result is used, which is the
+# least sensitive to other load on the machine.
+PERFORMANCE_RUNS = 3
+
+PERFORMANCE_DFILTERS = (
+    'tcp.port == 80 && http.request.method == "GET"',
+    'ip.addr in {10.0.0.0/8 172.16.0.0/12 192.168.0.0/16} and not dns',
+    'lower(http.host) contains "example" || sip.Method matches "^(INVITE|BYE)$"',
+    'frame.len > 100 or udp.length < 50 or tcp.flags.syn == 1',
+    'any ip.addr == 10.0.0.1 && !(udp.port in {53 5353})',
+)
+
+HIGHER_IS_BETTER = 'higher'
+LOWER_IS_BETTER = 'lower'
+
+# Metric name: (direction, default tolerance as a fraction of the baseline).
+PERFORMANCE_METRICS = {
+    'tshark_packets_per_second': (HIGHER_IS_BETTER, 0.15),
+    'tshark_two_pass_peak_rss_kib': (LOWER_IS_BETTER, 0.10),
+    'dfilter_compile_us': (LOWER_IS_BETTER, 0.25),
+    'sharkd_file_open_ms': (LOWER_IS_BETTER, 0.20),
+    'sharkd_request_latency_ms': (LOWER_IS_BETTER, 0.25),
+}
+
+
+class PerformanceBaselines:
+    '''Compares metrics against the recorded baselines, or records them.'''
+
+    def __init__(self, path, update, inputs_digest):
+        self.path = path
+        self.update = update
+        self.inputs_digest = inputs_digest
+        self.recorded = {}
+        try:
+            with open(path) as f:
+                self.data = json.load(f)
+        except FileNotFoundError:
+            self.data = {}
+
+    def check(self, name, value):
+        direction, tolerance = PERFORMANCE_METRICS[name]
+        print('%s: %g' % (name, value))
+        if self.update:
+            self.recorded[name] = value
+            return
+        if self.data.get('inputs_digest') != self.inputs_digest:
+            pytest.skip('The performance inputs changed since the baselines'
+                        ' were recorded; record them again with'
+                        ' --update-performance-baselines')
+        baseline = self.data.get('metrics', {}).get(name)
+        if baseline is None:
+            pytest.skip('No baseline for %s; record one with'
+                        ' --update-performance-baselines' % (name,))
+        tolerance = baseline.get('tolerance', tolerance)
+        if direction == HIGHER_IS_BETTER:
+            limit = baseline['value'] * (1 - tolerance)
+            assert value >= limit, '%s regressed: %g, baseline %g' % (name, value, baseline['value'])
+        else:
+            limit = baseline['value'] * (1 + tolerance)
+            assert value <= limit, '%s regressed: %g, baseline %g' % (name, value, baseline['value'])
+
+    def save(self):
+        if not self.update or not self.recorded:
+            return
+        if self.data.get('inputs_digest') != self.inputs_digest:
+            self.data = {'inputs_digest': self.inputs_digest, 'metrics': {}}
+        metrics = self.data.setdefault('metrics', {})
+        for name, value in self.recorded.items():
+            # Keep tolerances that were adjusted by hand.
+            metrics.setdefault(name, {})['value'] = value
+        with open(self.path, 'w') as f:
+            json.dump(self.data, f, indent=4, sort_keys=True)
+            f.write('\n')
+
+
+def run_timed(cmd, env):
+    '''
+    Runs a program to completion, returning its standard output, the wall
+    clock time it took in seconds and its peak resident set size in KiB
+    (None where that isn't available).
+    '''
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, encoding='utf-8', env=env)
+    if hasattr(os, 'wait4'):
+        stdout = proc.stdout.read()
+        proc.stdout.close()
+        _, status, rusage = os.wait4(proc.pid, 0)
+        elapsed = time.perf_counter() - start
+        if os.WIFEXITED(status):
+            proc.returncode = os.WEXITSTATUS(status)
+        else:
+            proc.returncode = -os.WTERMSIG(status)
+        peak_rss = rusage.ru_maxrss
+        if sys.platform == 'darwin':
+            # Bytes, not KiB.
+            peak_rss //= 1024
+    else:
+        stdout, _ = proc.communicate()
+        elapsed = time.perf_counter() - start
+        peak_rss = None
+    assert proc.returncode == 0, '%s failed' % (cmd[0],)
+    return stdout, elapsed, peak_rss
+
+
+@pytest.fixture(scope='session')
+def performance_enabled(request):
+    if not request.config.getoption('--enable-performance', default=False):
+        pytest.skip('Performance tests are not enabled via --enable-performance')
+
+
+@pytest.fixture(scope='session')
+def performance_capture(performance_enabled, cmd_mergecap, capture_file, make_env, tmp_path_factory):
+    '''Returns the path to the concatenated captures and their digest.'''
+    digest = hashlib.sha256()
+    for name in PERFORMANCE_CAPTURES:
+        with open(capture_file(name), 'rb') as f:
+            digest.update(name.encode('utf-8') + b'\0' + f.read())
+    digest.update(str(PERFORMANCE_REPEAT).encode('utf-8'))
+    path = str(tmp_path_factory.mktemp('performance') / 'performance.pcapng')
+    sources = [capture_file(name) for name in PERFORMANCE_CAPTURES] * PERFORMANCE_REPEAT
+    subprocess.check_call((cmd_mergecap, '-a', '-F', 'pcapng', '-w', path) + tuple(sources),
+                          env=make_env())
+    return path, digest.hexdigest()
+
+
+@pytest.fixture(scope='session')
+def performance_baselines(request, performance_capture, dirs):
+    path = request.config.getoption('--performance-baselines', default=None)
+    if not path:
+        path = os.path.join(dirs.baseline_dir, 'performance.json')
+    update = request.config.getoption('--update-performance-baselines', default=False)
+    baselines = PerformanceBaselines(path, update, performance_capture[1])
+    yield baselines
+    baselines.save()
+
+
+@pytest.fixture(scope='session')
+def cmd_sharkd(program):
+    return program('sharkd')
+
+
+@pytest.fixture(scope='session')
+def cmd_dftest(program):
+    return program('dftest')
+
+
+class TestPerformanceTshark:
+    def test_tshark_throughput(self, cmd_tshark, performance_capture, performance_baselines, make_env):
+        '''Packets per second for a single pass with the summary output.'''
+        path, _ = performance_capture
+        best = None
+        for _ in range(PERFORMANCE_RUNS):
+            stdout, elapsed, _ = run_timed((cmd_tshark, '-n', '-r', path), make_env())
+            best = elapsed if best is None else min(best, elapsed)
+        packets = len(stdout.splitlines())
+        assert packets > 0
+        performance_baselines.check('tshark_packets_per_second', packets / best)
+
+    def test_tshark_two_pass_peak_rss(self, cmd_tshark, performance_capture, performance_baselines, make_env):
+        '''Peak memory use of a two-pass run, which keeps every frame's state.'''
+        if not hasattr(os, 'wait4'):
+            pytest.skip('Peak RSS is not available on this platform')
+        path, _ = performance_capture
+        _, _, peak_rss = run_timed((cmd_tshark, '-n', '-2', '-r', path), make_env())
+        performance_baselines.check('tshark_two_pass_peak_rss_kib', peak_rss)
+
+
+class TestPerformanceDfilter:
+    def test_dfilter_compile_time(self, cmd_dftest, performance_baselines, make_env):
+        '''Total time dftest reports for compiling a few typical filters.'''
+        total = 0
+        for dfilter in PERFORMANCE_DFILTERS:
+            best = None
+            for _ in range(PERFORMANCE_RUNS):
+                stdout, _, _ = run_timed((cmd_dftest, '-t', '--', dfilter), make_env())
+                elapsed = [line for line in stdout.splitlines() if line.startswith('Elapsed:')]
+                assert elapsed, 'No elapsed time for %r' % (dfilter,)
+                micros = int(elapsed[-1].split()[1])
+                best = micros if best is None else min(best, micros)
+            total += best
+        performance_baselines.check('dfilter_compile_us', total)
+
+
+class TestPerformanceSharkd:
+    def test_sharkd_latency(self, cmd_sharkd, performance_capture, performance_baselines, make_env):
+        '''The time sharkd takes to load the file and to answer requests.'''
+        path, _ = performance_capture
+        requests = (
+            {"method": "status"},
+            {"method": "frames", "params": {"skip": 1000, "limit": 100}},
+            {"method": "frames", "params": {"filter": "udp", "limit": 100}},
+            {"method": "check", "params": {"filter": PERFORMANCE_DFILTERS[1]}},
+            {"method": "intervals", "params": {"interval": 1000}},
+            {"method": "frame", "params": {"frame": 1234, "proto": True}},
+        )
+        proc = subprocess.Popen((cmd_sharkd, '-'), stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                stderr=subprocess.DEVNULL, encoding='utf-8', env=make_env())
+        next_id = 1
+
+        def request(method, params=None):
+            nonlocal next_id
+            req = {"jsonrpc": "2.0", "id": next_id, "method": method}
+            if params:
+                req["params"] = params
+            next_id += 1
+            start = time.perf_counter()
+            proc.stdin.write(json.dumps(req) + '\n')
+            proc.stdin.flush()
+            response = json.loads(proc.stdout.readline())
+            elapsed = time.perf_counter() - start
+            assert 'error' not in response, response
+            return elapsed
+
+        try:
+            # Each load closes the previous file and reads the file again.
+            open_times = [request("load", {"file": path}) for _ in range(PERFORMANCE_RUNS)]
+            latencies = []
+            for req in requests:
+                latencies.append(min(request(req["method"], req.get("params"))
+                                     for _ in range(PERFORMANCE_RUNS)))
+        finally:
+            proc.stdin.close()
+            proc.wait()
+        performance_baselines.check('sharkd_file_open_ms', min(open_times) * 1000)
+        performance_baselines.check('sharkd_request_latency_ms', statistics.median(latencies) * 1000)
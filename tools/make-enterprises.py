@@ -111,7 +111,7 @@ class CFile:
         self.f.write('} global_enterprises_table_t;\n\n')
 
         # Write static table
-        self.f.write('static global_enterprises_table_t table =\n')
+        self.f.write('static const global_enterprises_table_t table =\n')
         self.f.write('{\n')
         # Largest index
         self.f.write('    ' + str(self.highest_num) + ',\n')
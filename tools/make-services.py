@@ -259,27 +259,27 @@ def main(argv):
             return e[0]
         return max_port
 
-    out.write("static ws_services_entry_t global_tcp_udp_services_table[] = {\n")
+    out.write("static const ws_services_entry_t global_tcp_udp_services_table[] = {\n")
     for e in tcp_udp:
         max_port = write_entry(out, e, max_port)
     out.write("};\n\n")
 
-    out.write("static ws_services_entry_t global_tcp_services_table[] = {\n")
+    out.write("static const ws_services_entry_t global_tcp_services_table[] = {\n")
     for e in tcp:
         max_port = write_entry(out, e, max_port)
     out.write("};\n\n")
 
-    out.write("static ws_services_entry_t global_udp_services_table[] = {\n")
+    out.write("static const ws_services_entry_t global_udp_services_table[] = {\n")
     for e in udp:
         max_port = write_entry(out, e, max_port)
     out.write("};\n\n")
 
-    out.write("static ws_services_entry_t global_sctp_services_table[] = {\n")
+    out.write("static const ws_services_entry_t global_sctp_services_table[] = {\n")
     for e in sctp:
         max_port = write_entry(out, e, max_port)
     out.write("};\n\n")
 
-    out.write("static ws_services_entry_t global_dccp_services_table[] = {\n")
+    out.write("static const ws_services_entry_t global_dccp_services_table[] = {\n")
     for e in dccp:
         max_port = write_entry(out, e, max_port)
     out.write("};\n\n")
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+#
+# Run TShark over a large capture file in several processes at once.
+#
+# The capture is split into consecutive shards with editcap. Each shard
+# after the first is prefixed with the last packets of the shard before
+# it, so that the worker sees the start of conversations that were
+# already running (TCP sequence analysis, reassembly, conversation
+# lookups). Rows for the warm-up packets are dropped with a display
+# filter, and the outputs are written in shard order.
+#
+# This only makes sense for output that doesn't depend on state across
+# the whole file, e.g. "-T fields" or "-T ek". Frame numbers, relative
+# times and stream indexes are relative to the shard, and statistics
+# (-z) are printed once per shard.
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Run TShark over shards of a capture file in parallel.'''
+
+import argparse
+import multiprocessing
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+
+def find_tool(name, tool_dir):
+    if tool_dir:
+        path = os.path.join(tool_dir, name)
+        if os.path.exists(path):
+            return path
+    path = shutil.which(name)
+    if path is None:
+        sys.stderr.write('Unable to find {}.\n'.format(name))
+        sys.exit(1)
+    return path
+
+
+def packet_count(capinfos, cap_file):
+    # -M: exact numbers, -r: no header, -T: tab separated, -c: packets only
+    out = subprocess.check_output([capinfos, '-M', '-r', '-T', '-c', cap_file],
+                                  universal_newlines=True)
+    m = re.search(r'\t(\d+)\s*$', out)
+    if not m:
+        sys.stderr.write('Unable to get the number of packets in {}.\n'.format(cap_file))
+        sys.exit(1)
+    return int(m.group(1))
+
+
+def make_shards(args, num_packets, work_dir):
+    '''Returns a list of (shard file, number of warm-up packets).'''
+    per_shard = max(1, -(-num_packets // args.jobs))
+    chunk_base = os.path.join(work_dir, 'chunk.pcapng')
+    subprocess.check_call([args.editcap, '-F', 'pcapng', '-c', str(per_shard),
+                           args.read_file, chunk_base])
+    # editcap names the chunks chunk_00000_<timestamp>.pcapng, ...
+    chunks = sorted(f for f in os.listdir(work_dir) if f.startswith('chunk_'))
+    chunks = [os.path.join(work_dir, f) for f in chunks]
+
+    shards = [(chunks[0], 0)] if chunks else []
+    for idx in range(1, len(chunks)):
+        prev_len = min(per_shard, num_packets - (idx - 1) * per_shard)
+        warmup = min(args.warmup, prev_len)
+        if warmup == 0:
+            shards.append((chunks[idx], 0))
+            continue
+        prefix = os.path.join(work_dir, 'warmup_{:05d}.pcapng'.format(idx))
+        shard = os.path.join(work_dir, 'shard_{:05d}.pcapng'.format(idx))
+        # Keep (-r) the last "warmup" packets of the previous chunk.
+        subprocess.check_call([args.editcap, '-F', 'pcapng', '-r', chunks[idx - 1],
+                               prefix, '{}-{}'.format(prev_len - warmup + 1, prev_len)])
+        subprocess.check_call([args.mergecap, '-F', 'pcapng', '-a', '-w', shard,
+                               prefix, chunks[idx]])
+        os.remove(prefix)
+        shards.append((shard, warmup))
+    return shards
+
+
+def run_worker(tshark, shard, warmup, display_filter, tshark_args, out_file):
+    dfilter = display_filter
+    if warmup > 0:
+        dfilter = 'frame.number > {}'.format(warmup)
+        if display_filter:
+            dfilter += ' && ({})'.format(display_filter)
+    cmd = [tshark, '-r', shard]
+    if dfilter:
+        # The warm-up packets are still dissected, they just aren't printed.
+        cmd += ['-Y', dfilter]
+    cmd += tshark_args
+    with open(out_file, 'wb') as out:
+        proc = subprocess.run(cmd, stdout=out, stderr=subprocess.PIPE)
+    return (proc.returncode, proc.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Split a capture file into shards and run TShark on each of them in parallel.',
+        epilog='Arguments after "--" are passed to each TShark process.')
+    parser.add_argument('-r', '--read-file', required=True, help='Capture file to read')
+    parser.add_argument('-j', '--jobs', type=int, default=multiprocessing.cpu_count(),
+                        help='Number of shards and worker processes (default: number of CPUs)')
+    parser.add_argument('-W', '--warmup', type=int, default=10000,
+                        help='Packets of the previous shard each worker dissects first without output (default: 10000)')
+    parser.add_argument('-Y', '--display-filter', default='', help='Display filter for the output')
+    parser.add_argument('--tool-dir', help='Directory containing tshark, editcap, mergecap and capinfos')
+    parser.add_argument('-w', '--work-dir', help='Directory for the shards (default: a temporary directory)')
+    parser.add_argument('tshark_args', nargs=argparse.REMAINDER, help='TShark arguments')
+    args = parser.parse_args()
+
+    tshark_args = args.tshark_args
+    if tshark_args and tshark_args[0] == '--':
+        tshark_args = tshark_args[1:]
+    for opt in ('-r', '-w', '-Y', '-2', '-R'):
+        if opt in tshark_args:
+            parser.error('{} cannot be passed to TShark here'.format(opt))
+    if args.jobs < 1 or args.warmup < 0:
+        parser.error('--jobs must be positive and --warmup must not be negative')
+
+    tshark = find_tool('tshark', args.tool_dir)
+    args.editcap = find_tool('editcap', args.tool_dir)
+    args.mergecap = find_tool('mergecap', args.tool_dir)
+    capinfos = find_tool('capinfos', args.tool_dir)
+
+    num_packets = packet_count(capinfos, args.read_file)
+    if num_packets == 0:
+        return 0
+
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix='tshark-sharded-')
+    exit_status = 0
+    try:
+        shards = make_shards(args, num_packets, work_dir)
+        pool = multiprocessing.Pool(min(args.jobs, len(shards)))
+        results = []
+        for idx, (shard, warmup) in enumerate(shards):
+            out_file = os.path.join(work_dir, 'out_{:05d}'.format(idx))
+            results.append((out_file, pool.apply_async(run_worker,
+                [tshark, shard, warmup, args.display_filter, tshark_args, out_file])))
+        pool.close()
+
+        # Write the outputs in order as soon as each one is done.
+        stdout = sys.stdout.buffer
+        for out_file, result in results:
+            returncode, stderr = result.get()
+            if stderr:
+                sys.stderr.buffer.write(stderr)
+            if returncode != 0:
+                exit_status = returncode
+            with open(out_file, 'rb') as out:
+                shutil.copyfileobj(out, stdout)
+            os.remove(out_file)
+        stdout.flush()
+        pool.join()
+    except KeyboardInterrupt:
+        sys.stderr.write('Interrupted.\n')
+        exit_status = 1
+    finally:
+        if not args.work_dir:
+            shutil.rmtree(work_dir, ignore_errors=True)
+    return exit_status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
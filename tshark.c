@@ -30,6 +30,9 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
 #endif
 
 #include <glib.h>
@@ -85,11 +88,13 @@
 #include "ui/dissect_opts.h"
 #include "ui/ssl_key_export.h"
 #include "ui/failure_message.h"
+#include "ui/flow_partition.h"
 #if defined(HAVE_LIBSMI)
 #include "epan/oids.h"
 #endif
 #include "epan/maxmind_db.h"
 #include <epan/epan_dissect.h>
+#include <epan/wmem_scopes.h>
 #include <epan/tap.h>
 #include <epan/stat_tap_ui.h>
 #include <epan/conversation_table.h>
@@ -143,6 +148,18 @@
 #define LONGOPT_HEXDUMP                 LONGOPT_BASE_APPLICATION+7
 #define LONGOPT_SELECTED_FRAME          LONGOPT_BASE_APPLICATION+8
 #define LONGOPT_PRINT_TIMERS            LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_FLOW_PARTITION          LONGOPT_BASE_APPLICATION+10
+#define LONGOPT_ONLY_WANTED_PROTOCOLS   LONGOPT_BASE_APPLICATION+11
+#define LONGOPT_IDLE_TIMEOUT            LONGOPT_BASE_APPLICATION+12
+#define LONGOPT_TWO_PASS_WINDOW         LONGOPT_BASE_APPLICATION+13
+#define LONGOPT_SESSION_MEMORY_LIMIT    LONGOPT_BASE_APPLICATION+14
+#define LONGOPT_OUTPUT_SOCKET           LONGOPT_BASE_APPLICATION+15
+#define LONGOPT_OUTPUT_FILE             LONGOPT_BASE_APPLICATION+16
+#define LONGOPT_OUTPUT_FILE_SIZE        LONGOPT_BASE_APPLICATION+17
+#define LONGOPT_OUTPUT_THREAD           LONGOPT_BASE_APPLICATION+18
+#define LONGOPT_FOLLOW_FILESET          LONGOPT_BASE_APPLICATION+19
+#define LONGOPT_PERF_REPORT             LONGOPT_BASE_APPLICATION+20
+#define LONGOPT_ALLOC_REPORT            LONGOPT_BASE_APPLICATION+21
 
 capture_file cfile;
 
@@ -154,9 +171,34 @@ static frame_data prev_cap_frame;
 static gboolean perform_two_pass_analysis;
 static guint32 epan_auto_reset_count = 0;
 static gboolean epan_auto_reset = FALSE;
+/* Also reset the session once file scope memory reaches this many MiB, if non-zero */
+static guint session_memory_limit = 0;
 
 static guint32 selected_frame_number = 0;
 
+/*
+ * If flow_partition_count is non-zero, we only dissect the frames whose
+ * flow hashes to partition flow_partition_index (0-based) of that many.
+ */
+static guint32 flow_partition_index = 0;
+static guint32 flow_partition_count = 0;
+
+/* Stop dissecting each packet once we've seen the protocols we print or filter on */
+static gboolean only_wanted_protocols = FALSE;
+
+/* Discard conversations and reassemblies idle for this many seconds, if non-zero */
+static guint idle_timeout = 0;
+
+/* With -2, run the second pass this many frames behind the first one, if non-zero */
+static guint two_pass_window = 0;
+
+/*
+ * Go on to the next files of the set the -r file belongs to, as a ring
+ * buffer creates them, keeping the same session.
+ */
+static gboolean follow_fileset = FALSE;
+#define FOLLOW_FILESET_POLL_INTERVAL    G_USEC_PER_SEC  /* How often to look for a new file */
+
 /*
  * The way the packet decode is to be written.
  */
@@ -177,6 +219,7 @@ static gboolean print_packet_info; /* TRUE if we're to print packet information
 static gboolean print_summary;     /* TRUE if we're to print packet summary information */
 static gboolean print_details;     /* TRUE if we're to print packet details information */
 static gboolean print_hex;         /* TRUE if we're to print hex/ascii information */
+static gboolean print_tree_visible; /* TRUE if the protocol tree must be visible to print it */
 static gboolean line_buffered;
 static gboolean quiet = FALSE;
 static gboolean really_quiet = FALSE;
@@ -190,6 +233,32 @@ static print_stream_t *print_stream = NULL;
 
 static char *output_file_name;
 
+/*
+ * Where the packet information goes instead of the standard output
+ * (--output-socket or --output-file), and the size at which to start
+ * a new output file, in MiB, if non-zero.
+ */
+static char *output_socket_path = NULL;
+static char *output_sink_file = NULL;
+static guint output_sink_file_size = 0;
+static guint output_sink_file_num = 0;
+
+/* Size of the standard output buffer when it's going to one of those */
+#define OUTPUT_SINK_BUFFER_SIZE (1024 * 1024)
+
+#ifndef _WIN32
+/*
+ * With --output-thread, the standard output is a pipe, and a thread
+ * copies what's written to it to where the standard output really goes,
+ * so that waiting for slow writes overlaps with dissection.
+ */
+static gboolean output_thread_requested = FALSE;
+static GThread *output_thread = NULL;
+static int output_thread_fd = -1;       /* Where the output really goes */
+static int output_thread_pipe = -1;     /* Read end of the pipe */
+static gint output_thread_err = 0;      /* errno of a failed write, if any */
+#endif
+
 static output_fields_t* output_fields  = NULL;
 
 static gboolean no_duplicate_keys = FALSE;
@@ -253,7 +322,10 @@ typedef enum {
     PROCESS_FILE_INTERRUPTED
 } process_file_status_t;
 static process_file_status_t process_cap_file(capture_file *, char *, int, gboolean, int, gint64, int);
+static gboolean fileset_name_split(const char *, size_t *, const char **);
 
+static gboolean frame_in_flow_partition(const wtap_rec *rec, Buffer *buf);
+static void skip_packet_single_pass(capture_file *cf, gint64 offset, wtap_rec *rec);
 static gboolean process_packet_single_pass(capture_file *cf,
         epan_dissect_t *edt, gint64 offset, wtap_rec *rec, Buffer *buf,
         guint tap_flags);
@@ -261,6 +333,11 @@ static void show_print_file_io_error(void);
 static gboolean write_preamble(capture_file *cf);
 static gboolean print_packet(capture_file *cf, epan_dissect_t *edt);
 static gboolean write_finale(void);
+static gboolean open_output_sink(void);
+static gboolean next_output_sink_file(capture_file *cf);
+#ifndef _WIN32
+static gboolean start_output_thread(void);
+#endif
 
 static void tshark_cmdarg_err(const char *msg_format, va_list ap);
 static void tshark_cmdarg_err_cont(const char *msg_format, va_list ap);
@@ -268,10 +345,15 @@ static void tshark_cmdarg_err_cont(const char *msg_format, va_list ap);
 static GHashTable *output_only_tables = NULL;
 
 static gboolean opt_print_timers = FALSE;
+static gboolean opt_perf_report = FALSE;
+static gboolean opt_alloc_report = FALSE;
 struct elapsed_pass_s {
+    gint64 read;
     gint64 dissect;
     gint64 dfilter_read;
     gint64 dfilter_filter;
+    gint64 print;
+    guint64 printed;
 };
 static struct {
     gint64                 dfilter_expand;
@@ -338,6 +420,198 @@ print_elapsed_json(const char *cf_name, const char *dfilter)
     json_dumper_finish(&dumper);
 }
 
+#define PERF_MS(val)    ((double)(val) / 1000.0)
+
+typedef struct {
+    int     proto_id;
+    guint64 calls;
+    gint64  total_time;
+    gint64  self_time;
+} perf_proto_t;
+
+static void
+perf_report_collect_proto(int proto_id, guint64 calls, gint64 total_time,
+        gint64 self_time, gpointer user_data)
+{
+    perf_proto_t proto = { proto_id, calls, total_time, self_time };
+
+    g_array_append_val((GArray *)user_data, proto);
+}
+
+static gint
+perf_report_compare_protos(gconstpointer a, gconstpointer b)
+{
+    const perf_proto_t *proto_a = (const perf_proto_t *)a;
+    const perf_proto_t *proto_b = (const perf_proto_t *)b;
+
+    /* Most time spent first */
+    if (proto_a->self_time != proto_b->self_time)
+        return proto_a->self_time < proto_b->self_time ? 1 : -1;
+    return proto_a->proto_id - proto_b->proto_id;
+}
+
+static void
+perf_report_print_scope(const char *name, gboolean valid, const wmem_allocator_stats_t *stats)
+{
+    if (!valid) {
+        fprintf(stderr, "%-32s %12s %12s %12s\n", name, "-", "-", "-");
+        return;
+    }
+    fprintf(stderr, "%-32s %12zu %12zu %12zu\n", name,
+            stats->in_use, stats->peak, stats->retained);
+}
+
+/*
+ * Print the time spent in each stage of processing, and in the dissectors
+ * of each protocol, and the memory used by each wmem scope, to the
+ * standard error.
+ */
+static void
+print_perf_report(capture_file *cf)
+{
+    const struct elapsed_pass_s *first = &tshark_elapsed.first_pass;
+    const struct elapsed_pass_s *second = &tshark_elapsed.second_pass;
+    gint64 elapsed = tshark_elapsed.elapsed_first_pass + tshark_elapsed.elapsed_second_pass;
+    gint64 dissect = first->dissect + second->dissect;
+    gint64 taps = tap_get_elapsed_time();
+    gint64 accounted;
+    GArray *protos;
+    wmem_allocator_stats_t stats;
+
+    accounted = first->read + second->read + dissect +
+        first->dfilter_read + second->dfilter_read +
+        first->dfilter_filter + second->dfilter_filter +
+        first->print + second->print;
+
+    fprintf(stderr, "\n");
+    fprintf(stderr, "===================================================================\n");
+    fprintf(stderr, "Performance Report\n");
+    fprintf(stderr, "Frames read: %u, printed: %" PRIu64 "\n", cf->count,
+            first->printed + second->printed);
+    fprintf(stderr, "%-45s %20s\n", "Stage", "Time (ms)");
+    fprintf(stderr, "-------------------------------------------------------------------\n");
+    fprintf(stderr, "%-45s %20.3f\n", "Reading (with decompression)", PERF_MS(first->read + second->read));
+    fprintf(stderr, "%-45s %20.3f\n", "Dissection (with taps)", PERF_MS(dissect));
+    fprintf(stderr, "%-45s %20.3f\n", "  Taps", PERF_MS(taps));
+    fprintf(stderr, "%-45s %20.3f\n", "Read filter", PERF_MS(first->dfilter_read + second->dfilter_read));
+    fprintf(stderr, "%-45s %20.3f\n", "Display filter", PERF_MS(first->dfilter_filter + second->dfilter_filter));
+    fprintf(stderr, "%-45s %20.3f\n", "Output formatting", PERF_MS(first->print + second->print));
+    fprintf(stderr, "%-45s %20.3f\n", "Other", PERF_MS(MAX(elapsed - accounted, 0)));
+    fprintf(stderr, "%-45s %20.3f\n", "Total", PERF_MS(elapsed));
+
+    protos = g_array_new(FALSE, FALSE, sizeof(perf_proto_t));
+    dissector_timing_foreach(perf_report_collect_proto, protos);
+    g_array_sort(protos, perf_report_compare_protos);
+    fprintf(stderr, "-------------------------------------------------------------------\n");
+    fprintf(stderr, "%-32s %12s %10s %10s\n", "Protocol", "Calls", "Total (ms)", "Self (ms)");
+    for (guint i = 0; i < protos->len; i++) {
+        const perf_proto_t *proto = &g_array_index(protos, perf_proto_t, i);
+
+        fprintf(stderr, "%-32s %12" PRIu64 " %10.3f %10.3f\n",
+                proto->proto_id != -1 ? proto_get_protocol_filter_name(proto->proto_id) : "(no protocol)",
+                proto->calls, PERF_MS(proto->total_time), PERF_MS(proto->self_time));
+    }
+    g_array_free(protos, TRUE);
+
+    fprintf(stderr, "-------------------------------------------------------------------\n");
+    fprintf(stderr, "%-32s %12s %12s %12s\n", "Memory scope (bytes)", "In use", "Peak", "Retained");
+    wmem_get_stats(wmem_epan_scope(), &stats);
+    perf_report_print_scope("epan", TRUE, &stats);
+    wmem_get_stats(wmem_file_scope(), &stats);
+    perf_report_print_scope("file", TRUE, &stats);
+    wmem_get_stats(wmem_packet_scope(), &stats);
+    perf_report_print_scope("packet", TRUE, &stats);
+    perf_report_print_scope("pinfo->pool", epan_get_packet_pool_stats(&stats), &stats);
+    fprintf(stderr, "===================================================================\n");
+}
+
+#define ALLOC_REPORT_LINES 30
+
+typedef struct {
+    const char *scope;
+    const char *context;
+    guint64     bytes;
+    guint64     count;
+} alloc_report_total_t;
+
+static gint
+alloc_report_compare_totals(gconstpointer a, gconstpointer b)
+{
+    const alloc_report_total_t *total_a = (const alloc_report_total_t *)a;
+    const alloc_report_total_t *total_b = (const alloc_report_total_t *)b;
+
+    if (total_a->bytes != total_b->bytes)
+        return total_a->bytes < total_b->bytes ? 1 : -1;
+    return 0;
+}
+
+/*
+ * Print the estimated wmem allocations of each scope and protocol, and of
+ * the biggest callsites, to the standard error.
+ */
+static void
+print_alloc_report(void)
+{
+    GArray *entries = wmem_profile_get_entries();
+    GArray *totals = g_array_new(FALSE, FALSE, sizeof(alloc_report_total_t));
+    guint i, j;
+
+    /* Add up the callsites of each scope and protocol */
+    for (i = 0; i < entries->len; i++) {
+        const wmem_profile_entry_t *entry = &g_array_index(entries, wmem_profile_entry_t, i);
+        alloc_report_total_t *total = NULL;
+
+        for (j = 0; j < totals->len; j++) {
+            total = &g_array_index(totals, alloc_report_total_t, j);
+            if (g_strcmp0(total->scope, entry->scope) == 0 &&
+                    g_strcmp0(total->context, entry->context) == 0)
+                break;
+        }
+        if (j == totals->len) {
+            alloc_report_total_t new_total = { entry->scope, entry->context, 0, 0 };
+            g_array_append_val(totals, new_total);
+            total = &g_array_index(totals, alloc_report_total_t, j);
+        }
+        total->bytes += entry->bytes;
+        total->count += entry->count;
+    }
+    g_array_sort(totals, alloc_report_compare_totals);
+
+    fprintf(stderr, "\n");
+    fprintf(stderr, "===================================================================\n");
+    fprintf(stderr, "Allocation Report (sampled, estimated total %" PRIu64 " bytes)\n",
+            wmem_profile_get_total());
+    fprintf(stderr, "%-12s %-24s %14s %14s\n", "Scope", "Protocol", "Bytes", "Allocations");
+    fprintf(stderr, "-------------------------------------------------------------------\n");
+    for (i = 0; i < totals->len && i < ALLOC_REPORT_LINES; i++) {
+        const alloc_report_total_t *total = &g_array_index(totals, alloc_report_total_t, i);
+
+        fprintf(stderr, "%-12s %-24s %14" PRIu64 " %14" PRIu64 "\n",
+                total->scope ? total->scope : "(unnamed)",
+                total->context ? total->context : "(none)",
+                total->bytes, total->count);
+    }
+    fprintf(stderr, "-------------------------------------------------------------------\n");
+    fprintf(stderr, "%-12s %-24s %14s %14s\n", "Scope", "Protocol", "Bytes", "Allocations");
+    fprintf(stderr, "  Callsite\n");
+    fprintf(stderr, "-------------------------------------------------------------------\n");
+    for (i = 0; i < entries->len && i < ALLOC_REPORT_LINES; i++) {
+        const wmem_profile_entry_t *entry = &g_array_index(entries, wmem_profile_entry_t, i);
+        char *callsite = wmem_profile_callsite_name(entry->callsite);
+
+        fprintf(stderr, "%-12s %-24s %14" PRIu64 " %14" PRIu64 "\n",
+                entry->scope ? entry->scope : "(unnamed)",
+                entry->context ? entry->context : "(none)",
+                entry->bytes, entry->count);
+        fprintf(stderr, "  %s\n", callsite);
+        g_free(callsite);
+    }
+    fprintf(stderr, "===================================================================\n");
+
+    g_array_free(totals, TRUE);
+    g_array_free(entries, TRUE);
+}
+
 static void
 list_capture_types(void)
 {
@@ -473,11 +747,30 @@ print_usage(FILE *output)
     fprintf(output, "Input file:\n");
     fprintf(output, "  -r <infile>, --read-file <infile>\n");
     fprintf(output, "                           set the filename to read from (or '-' for stdin)\n");
+    fprintf(output, "  --follow-fileset         go on to the later files of the -r file's set as\n");
+    fprintf(output, "                           they are closed, in one session\n");
 
     fprintf(output, "\n");
     fprintf(output, "Processing:\n");
     fprintf(output, "  -2                       perform a two-pass analysis\n");
+    fprintf(output, "  --two-pass-window <frames>\n");
+    fprintf(output, "                           perform a two-pass analysis, printing each frame\n");
+    fprintf(output, "                           once that many later frames have been read\n");
     fprintf(output, "  -M <packet count>        perform session auto reset\n");
+    fprintf(output, "  --session-memory-limit <MiB>\n");
+    fprintf(output, "                           reset the session when it holds that much memory\n");
+    fprintf(output, "  --idle-timeout <seconds> discard conversations and reassemblies that have\n");
+    fprintf(output, "                           been idle for that long\n");
+    fprintf(output, "  --flow-partition <n>/<count>\n");
+    fprintf(output, "                           only dissect the flows in partition n of count, so\n");
+    fprintf(output, "                           that count processes can share a capture file\n");
+    fprintf(output, "  --only-wanted-protocols  with -T fields, don't dissect protocols above those\n");
+    fprintf(output, "                           of the -e, -Y and -R fields\n");
+    fprintf(output, "  --perf-report            report the time spent in each stage and protocol,\n");
+    fprintf(output, "                           and the memory used, to the standard error\n");
+    fprintf(output, "  --alloc-report[=<bytes>] sample wmem allocations (one per <bytes> allocated,\n");
+    fprintf(output, "                           default %u) and report them by scope, protocol and\n", WMEM_PROFILE_DEFAULT_INTERVAL);
+    fprintf(output, "                           callsite to the standard error\n");
     fprintf(output, "  -R <read filter>, --read-filter <read filter>\n");
     fprintf(output, "                           packet Read filter in Wireshark display filter syntax\n");
     fprintf(output, "                           (requires -2)\n");
@@ -518,6 +811,15 @@ print_usage(FILE *output)
     fprintf(output, "  -V                       add output of packet tree        (Packet Details)\n");
     fprintf(output, "  -O <protocols>           Only show packet details of these protocols, comma\n");
     fprintf(output, "                           separated\n");
+    fprintf(output, "  --output-socket <path>   write packet information and statistics to a UNIX\n");
+    fprintf(output, "                           domain socket instead of the standard output\n");
+    fprintf(output, "  --output-file <path>     write packet information and statistics to a file\n");
+    fprintf(output, "                           instead of the standard output\n");
+    fprintf(output, "  --output-file-size <MiB> with --output-file, start a new, numbered file when\n");
+    fprintf(output, "                           one reaches that size\n");
+#ifndef _WIN32
+    fprintf(output, "  --output-thread          write the output from a separate thread\n");
+#endif
     fprintf(output, "  -P, --print              print packet summary even when writing to a file\n");
     fprintf(output, "  -S <separator>           the line separator to print between packets\n");
     fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
@@ -857,6 +1159,59 @@ about_folders(void)
 
 }
 
+/*
+ * Tell libwireshark which protocols have fields we're going to print or
+ * filter on, so that it can stop dissecting once it has seen all of them.
+ */
+static void
+set_wanted_protocols_from_fields(dfilter_t *rfcode, dfilter_t *dfcode)
+{
+    GArray *proto_ids = g_array_new(FALSE, FALSE, sizeof (int));
+    void   *cookie;
+    int     proto_id;
+
+    for (proto_id = proto_get_first_protocol(&cookie); proto_id != -1;
+         proto_id = proto_get_next_protocol(&cookie)) {
+        if (output_fields_interested_in_proto(output_fields, proto_id) ||
+            (rfcode != NULL && dfilter_interested_in_proto(rfcode, proto_id)) ||
+            (dfcode != NULL && dfilter_interested_in_proto(dfcode, proto_id))) {
+            g_array_append_val(proto_ids, proto_id);
+        }
+    }
+    set_wanted_protocols((const int *)(void *)proto_ids->data, proto_ids->len);
+    g_array_free(proto_ids, TRUE);
+}
+
+/*
+ * If the columns are only built because fields or filters refer to some
+ * of them, tell libwireshark not to format the others.
+ */
+static void
+set_wanted_columns(dfilter_t *rfcode, dfilter_t *dfcode)
+{
+    column_info *cinfo = &cfile.cinfo;
+    int          proto_cols;
+    int          i;
+
+    if (tap_listeners_require_columns() || (print_packet_info && print_summary))
+        return;
+
+    proto_cols = proto_get_id_by_filter_name("_ws.col");
+    if (output_fields_interested_in_field(output_fields, proto_cols) ||
+        (rfcode != NULL && dfilter_interested_in_field(rfcode, proto_cols)) ||
+        (dfcode != NULL && dfilter_interested_in_field(dfcode, proto_cols)))
+        return;
+
+    for (i = 0; i < cinfo->num_cols; i++) {
+        int hf_id = cinfo->columns[i].hf_id;
+
+        col_set_wanted(cinfo, i, hf_id != -1 &&
+                (output_fields_interested_in_field(output_fields, hf_id) ||
+                 (rfcode != NULL && dfilter_interested_in_field(rfcode, hf_id)) ||
+                 (dfcode != NULL && dfilter_interested_in_field(dfcode, hf_id))));
+    }
+}
+
 static gboolean
 must_do_dissection(dfilter_t *rfcode, dfilter_t *dfcode,
         gchar *volatile pdu_export_arg)
@@ -957,6 +1312,18 @@ main(int argc, char *argv[])
         {"hexdump", ws_required_argument, NULL, LONGOPT_HEXDUMP},
         {"selected-frame", ws_required_argument, NULL, LONGOPT_SELECTED_FRAME},
         {"print-timers", ws_no_argument, NULL, LONGOPT_PRINT_TIMERS},
+        {"flow-partition", ws_required_argument, NULL, LONGOPT_FLOW_PARTITION},
+        {"only-wanted-protocols", ws_no_argument, NULL, LONGOPT_ONLY_WANTED_PROTOCOLS},
+        {"idle-timeout", ws_required_argument, NULL, LONGOPT_IDLE_TIMEOUT},
+        {"two-pass-window", ws_required_argument, NULL, LONGOPT_TWO_PASS_WINDOW},
+        {"session-memory-limit", ws_required_argument, NULL, LONGOPT_SESSION_MEMORY_LIMIT},
+        {"output-socket", ws_required_argument, NULL, LONGOPT_OUTPUT_SOCKET},
+        {"output-file", ws_required_argument, NULL, LONGOPT_OUTPUT_FILE},
+        {"output-file-size", ws_required_argument, NULL, LONGOPT_OUTPUT_FILE_SIZE},
+        {"output-thread", ws_no_argument, NULL, LONGOPT_OUTPUT_THREAD},
+        {"follow-fileset", ws_no_argument, NULL, LONGOPT_FOLLOW_FILESET},
+        {"perf-report", ws_no_argument, NULL, LONGOPT_PERF_REPORT},
+        {"alloc-report", ws_optional_argument, NULL, LONGOPT_ALLOC_REPORT},
         {0, 0, 0, 0}
     };
     gboolean             arg_error = FALSE;
@@ -1864,6 +2231,73 @@ main(int argc, char *argv[])
             case LONGOPT_PRINT_TIMERS:
                 opt_print_timers = TRUE;
                 break;
+            case LONGOPT_FLOW_PARTITION:
+            {
+                const char *end;
+
+                if (!ws_strtou32(ws_optarg, &end, &flow_partition_index) || *end != '/' ||
+                    !ws_strtou32(end + 1, NULL, &flow_partition_count) ||
+                    flow_partition_index < 1 || flow_partition_index > flow_partition_count) {
+                    cmdarg_err("\"%s\" isn't a valid flow partition; it must be <n>/<count>, with n from 1 to count",
+                               ws_optarg);
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                /* We count from 0 internally */
+                flow_partition_index--;
+                break;
+            }
+            case LONGOPT_ONLY_WANTED_PROTOCOLS:
+                only_wanted_protocols = TRUE;
+                break;
+            case LONGOPT_IDLE_TIMEOUT:
+                idle_timeout = get_positive_int(ws_optarg, "idle timeout");
+                break;
+            case LONGOPT_TWO_PASS_WINDOW:
+                if (epan_auto_reset) {
+                    cmdarg_err("--two-pass-window does not support auto session reset.");
+                    arg_error = TRUE;
+                }
+                two_pass_window = get_positive_int(ws_optarg, "two-pass window");
+                perform_two_pass_analysis = TRUE;
+                break;
+            case LONGOPT_SESSION_MEMORY_LIMIT:
+                session_memory_limit = get_positive_int(ws_optarg, "session memory limit");
+                break;
+            case LONGOPT_OUTPUT_SOCKET:
+#ifdef _WIN32
+                cmdarg_err("--output-socket isn't supported on Windows.");
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+#else
+                output_socket_path = ws_optarg;
+                break;
+#endif
+            case LONGOPT_OUTPUT_FILE:
+                output_sink_file = ws_optarg;
+                break;
+            case LONGOPT_OUTPUT_FILE_SIZE:
+                output_sink_file_size = get_positive_int(ws_optarg, "output file size");
+                break;
+            case LONGOPT_OUTPUT_THREAD:
+#ifdef _WIN32
+                cmdarg_err("--output-thread isn't supported on Windows.");
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+#else
+                output_thread_requested = TRUE;
+                break;
+#endif
+            case LONGOPT_FOLLOW_FILESET:
+                follow_fileset = TRUE;
+                break;
+            case LONGOPT_PERF_REPORT:
+                opt_perf_report = TRUE;
+                break;
+            case LONGOPT_ALLOC_REPORT:
+                opt_alloc_report = TRUE;
+                wmem_profile_start(ws_optarg ? get_positive_int(ws_optarg, "allocation sample interval") : 0);
+                break;
             default:
             case '?':        /* Bad flag - print usage message */
                 switch(ws_optopt) {
@@ -1916,6 +2350,14 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (only_wanted_protocols &&
+        (WRITE_FIELDS != output_action || output_fields_has_cols(output_fields) || dissect_color)) {
+        cmdarg_err("--only-wanted-protocols can only be used with \"-T fields\", "
+                "without column fields or --color.");
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
     if (dissect_color) {
         if (!color_filters_init(&err_msg, NULL)) {
             fprintf(stderr, "%s\n", err_msg);
@@ -2029,6 +2471,100 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (flow_partition_count != 0) {
+        /*
+         * Two-pass analysis would need the skipped frames' dissections
+         * on the second pass, and a live capture can't be shared.
+         */
+        if (perform_two_pass_analysis) {
+            cmdarg_err("--flow-partition can't be used with -2.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (cf_name == NULL) {
+            cmdarg_err("--flow-partition requires a capture file to be read with -r.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+
+    if (idle_timeout != 0) {
+        /* The second pass would need everything we discarded. */
+        if (perform_two_pass_analysis) {
+            cmdarg_err("--idle-timeout can't be used with -2.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        epan_set_idle_timeout(idle_timeout);
+    }
+
+    if (output_socket_path != NULL && output_sink_file != NULL) {
+        cmdarg_err("--output-socket and --output-file can't both be given.");
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+    if (output_sink_file_size != 0 && output_sink_file == NULL) {
+        cmdarg_err("--output-file-size requires --output-file.");
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+    if (!open_output_sink()) {
+        exit_status = WS_EXIT_INVALID_FILE;
+        goto clean_exit;
+    }
+#ifndef _WIN32
+    if (output_thread_requested) {
+        /* Starting a new file would replace the pipe. */
+        if (output_sink_file_size != 0) {
+            cmdarg_err("--output-thread can't be used with --output-file-size.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (!start_output_thread()) {
+            exit_status = WS_EXIT_INVALID_FILE;
+            goto clean_exit;
+        }
+    }
+#endif
+
+    if (session_memory_limit != 0 && perform_two_pass_analysis) {
+        /* As with -M, the second pass would need what we threw away. */
+        cmdarg_err("--session-memory-limit can't be used with -2.");
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
+    if (opt_perf_report) {
+        set_dissector_timing(TRUE);
+        tap_set_timing(TRUE);
+    }
+
+    if (follow_fileset) {
+        if (cf_name == NULL || strcmp(cf_name, "-") == 0) {
+            cmdarg_err("--follow-fileset requires a capture file to be read with -r.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (!fileset_name_split(get_basename(cf_name), NULL, NULL)) {
+            cmdarg_err("\"%s\" isn't named like a file of a file set "
+                    "(prefix_NNNNN_YYYYmmddHHMMSS.ext).", cf_name);
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        /* The whole set is never there to be read twice. */
+        if (perform_two_pass_analysis) {
+            cmdarg_err("--follow-fileset can't be used with -2.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        /* Each file has its own interfaces. */
+        if (output_file_name != NULL) {
+            cmdarg_err("--follow-fileset can't be used with -w.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+
 #ifdef HAVE_LIBPCAP
     if (caps_queries) {
         /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -2274,6 +2810,14 @@ main(int argc, char *argv[])
         }
     }
 
+    /*
+     * We print the details from a visible protocol tree, except for
+     * "-T fields", which can get the values of most fields from a tree
+     * with only those fields in it, which is much cheaper to build.
+     */
+    print_tree_visible = print_packet_info && print_details &&
+        (output_action != WRITE_FIELDS || output_fields_need_visible_tree(output_fields));
+
     if (ex_opt_count("read_format") > 0) {
         const gchar* name = ex_opt_get_next("read_format");
         in_file_type = open_info_name_to_type(name);
@@ -2448,6 +2992,18 @@ main(int argc, char *argv[])
            starting the statistics taps. */
         do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
         ws_debug("tshark: do_dissection = %s", do_dissection ? "TRUE" : "FALSE");
+        set_wanted_columns(rfcode, dfcode);
+
+        if (only_wanted_protocols) {
+            /* Taps and postdissectors may need any protocol. */
+            if (tap_listeners_require_dissection() || postdissectors_want_hfids()) {
+                cmdarg_err("--only-wanted-protocols can't be used with statistics, "
+                        "exports or postdissectors that need fields.");
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+            }
+            set_wanted_protocols_from_fields(rfcode, dfcode);
+        }
 
         /* Process the packets in the file */
         ws_debug("tshark: invoking process_cap_file() to process the packets");
@@ -2620,6 +3176,18 @@ main(int argc, char *argv[])
            starting the statistics taps. */
         do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
         ws_debug("tshark: do_dissection = %s", do_dissection ? "TRUE" : "FALSE");
+        set_wanted_columns(rfcode, dfcode);
+
+        if (only_wanted_protocols) {
+            /* Taps and postdissectors may need any protocol. */
+            if (tap_listeners_require_dissection() || postdissectors_want_hfids()) {
+                cmdarg_err("--only-wanted-protocols can't be used with statistics, "
+                        "exports or postdissectors that need fields.");
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+            }
+            set_wanted_protocols_from_fields(rfcode, dfcode);
+        }
 
         /* We're doing live capture; if the capture child is writing to a pipe,
            we can't do dissection, because that would mean two readers for
@@ -2726,6 +3294,18 @@ main(int argc, char *argv[])
             print_elapsed_json(cf_name, dfilter);
         }
     }
+    if (opt_perf_report) {
+        if (cf_name == NULL) {
+            ws_message("Ignoring option --perf-report because we are doing a live capture");
+        }
+        else {
+            print_perf_report(&cfile);
+        }
+    }
+    if (opt_alloc_report) {
+        wmem_profile_stop();
+        print_alloc_report();
+    }
 
     /* Memory cleanup */
     reset_tap_listeners();
@@ -3044,8 +3624,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
         /* The protocol tree will be "visible", i.e., printed, only if we're
            printing packet details, which is true if we're printing stuff
            ("print_packet_info" is true) and we're in verbose mode
-           ("packet_details" is true). */
-        edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+           ("packet_details" is true), and not only printing fields. */
+        edt = epan_dissect_new(cf->epan, create_proto_tree, print_tree_visible);
 
         wtap_rec_init(&rec);
         ws_buffer_init(&buf, 1514);
@@ -3053,7 +3633,7 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
         while (to_read-- && cf->provider.wth) {
             wtap_cleareof(cf->provider.wth);
             ret = wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info, &data_offset);
-            reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+            reset_epan_mem(cf, edt, create_proto_tree, print_tree_visible);
             if (ret == FALSE) {
                 /* read from file failed, tell the capture child to stop */
                 sync_pipe_stop(cap_session);
@@ -3224,7 +3804,7 @@ capture_cleanup(int signum _U_)
 
 static gboolean
 process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
-        gint64 offset, wtap_rec *rec, Buffer *buf)
+        gint64 offset, wtap_rec *rec, const guint8 *pd)
 {
     frame_data     fdlocal;
     guint32        framenum;
@@ -3276,7 +3856,7 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
 
         elapsed_start = g_get_monotonic_time();
         epan_dissect_run(edt, cf->cd_t, rec,
-                frame_tvbuff_new_buffer(&cf->provider, &fdlocal, buf),
+                frame_tvbuff_new(&cf->provider, &fdlocal, pd),
                 &fdlocal, cinfo);
         tshark_elapsed.first_pass.dissect += g_get_monotonic_time() - elapsed_start;
 
@@ -3300,8 +3880,8 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
          */
         if (edt && cf->dfcode) {
             elapsed_start = g_get_monotonic_time();
-            if (dfilter_apply_edt(cf->dfcode, edt) && edt->pi.fd->dependent_frames) {
-                g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+            if (dfilter_apply_edt(cf->dfcode, edt)) {
+                frame_data_sequence_mark_depended_upon(cf->provider.frames, edt->pi.fd);
             }
 
             if (selected_frame_number != 0 && selected_frame_number == cf->count + 1) {
@@ -3378,73 +3958,117 @@ typedef enum {
     PASS_INTERRUPTED
 } pass_status_t;
 
+/* Number of records read at a time on the first pass. */
+#define FIRST_PASS_BATCH_SIZE   256
+
+static epan_dissect_t *
+first_pass_edt_new(capture_file *cf)
+{
+    gboolean create_proto_tree;
+
+    if (!do_dissection)
+        return NULL;
+
+    /*
+     * Determine whether we need to create a protocol tree.
+     * We do if:
+     *
+     *    we're going to apply a read filter;
+     *
+     *    we're going to apply a display filter;
+     *
+     *    a postdissector wants field values or protocols
+     *    on the first pass.
+     */
+    create_proto_tree =
+        (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() || dissect_color);
+
+    ws_debug("tshark: create_proto_tree = %s", create_proto_tree ? "TRUE" : "FALSE");
+
+    /* We're not going to display the protocol tree on this pass,
+       so it's not going to be "visible". */
+    return epan_dissect_new(cf->epan, create_proto_tree, FALSE);
+}
+
+static gboolean
+read_batch_first_pass(wtap *wth, wtap_rec_batch *batch, int *err, gchar **err_info)
+{
+    gint64   elapsed_start = g_get_monotonic_time();
+    gboolean ret;
+
+    ret = wtap_read_batch(wth, batch, err, err_info);
+    tshark_elapsed.first_pass.read += g_get_monotonic_time() - elapsed_start;
+    return ret;
+}
+
+/* Read a record sequentially, for one of the passes that don't read in batches */
+static gboolean
+read_record_timed(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+        gchar **err_info, gint64 *data_offset)
+{
+    gint64   elapsed_start = g_get_monotonic_time();
+    gboolean ret;
+
+    ret = wtap_read(wth, rec, buf, err, err_info, data_offset);
+    tshark_elapsed.first_pass.read += g_get_monotonic_time() - elapsed_start;
+    return ret;
+}
+
 static pass_status_t
 process_cap_file_first_pass(capture_file *cf, int max_packet_count,
         gint64 max_byte_count, int *err, gchar **err_info)
 {
-    wtap_rec        rec;
-    Buffer          buf;
+    wtap_rec_batch  batch;
+    guint           i;
     epan_dissect_t *edt = NULL;
     gint64          data_offset;
     pass_status_t   status = PASS_SUCCEEDED;
     int             framenum = 0;
+    gboolean        stop = FALSE;
 
-    wtap_rec_init(&rec);
-    ws_buffer_init(&buf, 1514);
+    /*
+     * Records are read in batches, so that the file type's reader
+     * can parse many records in a row without returning to us.
+     */
+    wtap_rec_batch_init(&batch, FIRST_PASS_BATCH_SIZE);
 
     /* Allocate a frame_data_sequence for all the frames. */
     cf->provider.frames = new_frame_data_sequence();
 
-    if (do_dissection) {
-        gboolean create_proto_tree;
-
-        /*
-         * Determine whether we need to create a protocol tree.
-         * We do if:
-         *
-         *    we're going to apply a read filter;
-         *
-         *    we're going to apply a display filter;
-         *
-         *    a postdissector wants field values or protocols
-         *    on the first pass.
-         */
-        create_proto_tree =
-            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() || dissect_color);
-
-        ws_debug("tshark: create_proto_tree = %s", create_proto_tree ? "TRUE" : "FALSE");
-
-        /* We're not going to display the protocol tree on this pass,
-           so it's not going to be "visible". */
-        edt = epan_dissect_new(cf->epan, create_proto_tree, FALSE);
-    }
+    edt = first_pass_edt_new(cf);
 
     ws_debug("tshark: reading records for first pass");
     *err = 0;
-    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
-        if (read_interrupted) {
-            status = PASS_INTERRUPTED;
-            break;
-        }
-        framenum++;
-
-        if (process_packet_first_pass(cf, edt, data_offset, &rec, &buf)) {
-            /* Stop reading if we hit a stop condition */
-            if (max_packet_count > 0 && framenum >= max_packet_count) {
-                ws_debug("tshark: max_packet_count (%d) reached", max_packet_count);
-                *err = 0; /* This is not an error */
+    while (!stop && status == PASS_SUCCEEDED &&
+           read_batch_first_pass(cf->provider.wth, &batch, err, err_info)) {
+        for (i = 0; i < batch.count; i++) {
+            if (read_interrupted) {
+                status = PASS_INTERRUPTED;
                 break;
             }
-            if (max_byte_count != 0 && data_offset >= max_byte_count) {
-                ws_debug("tshark: max_byte_count (%" PRId64 "/%" PRId64 ") reached",
-                        data_offset, max_byte_count);
-                *err = 0; /* This is not an error */
-                break;
+            framenum++;
+            data_offset = batch.offsets[i];
+
+            if (process_packet_first_pass(cf, edt, data_offset, &batch.recs[i],
+                                          wtap_rec_batch_data(&batch, i))) {
+                /* Stop reading if we hit a stop condition */
+                if (max_packet_count > 0 && framenum >= max_packet_count) {
+                    ws_debug("tshark: max_packet_count (%d) reached", max_packet_count);
+                    stop = TRUE;
+                    break;
+                }
+                if (max_byte_count != 0 && data_offset >= max_byte_count) {
+                    ws_debug("tshark: max_byte_count (%" PRId64 "/%" PRId64 ") reached",
+                            data_offset, max_byte_count);
+                    stop = TRUE;
+                    break;
+                }
             }
         }
-        wtap_rec_reset(&rec);
     }
-    if (*err != 0)
+    if (stop)
+        *err = 0; /* This is not an error */
+    else if (*err != 0)
         status = PASS_READ_ERROR;
 
     if (edt)
@@ -3460,12 +4084,26 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
     cf->provider.prev_dis = NULL;
     cf->provider.prev_cap = NULL;
 
-    ws_buffer_free(&buf);
-    wtap_rec_cleanup(&rec);
+    wtap_rec_batch_cleanup(&batch);
 
     return status;
 }
 
+/*
+ * With --color, a packet has to be colorized while it's dissected only if
+ * something reads its frame.coloring_rule fields: the printed protocol
+ * tree or fields, or a filter.  Otherwise print_packet() colorizes only the
+ * packets that pass the filters, from the tree they were dissected into.
+ */
+static gboolean
+colorize_while_dissecting(capture_file *cf)
+{
+    return print_details || output_fields_num_fields(output_fields) != 0 ||
+        have_filtering_tap_listeners() ||
+        color_filters_dfilter_uses_rule(cf->rfcode) ||
+        color_filters_dfilter_uses_rule(cf->dfcode);
+}
+
 static gboolean
 process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
         frame_data *fdata, wtap_rec *rec,
@@ -3494,6 +4132,10 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
 
         col_custom_prime_edt(edt, &cf->cinfo);
 
+        /* If the tree we print isn't visible, it needs the printed fields. */
+        if (print_packet_info && print_details && !print_tree_visible)
+            output_fields_prime_edt(output_fields, edt);
+
         /* We only need the columns if either
            1) some tap or filter needs the columns
            or
@@ -3516,7 +4158,8 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
 
         if (dissect_color) {
             color_filters_prime_edt(edt);
-            fdata->need_colorize = 1;
+            if (colorize_while_dissecting(cf))
+                fdata->need_colorize = 1;
         }
 
         /* epan_dissect_run (and epan_dissect_reset) unref the block.
@@ -3542,7 +4185,10 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
         if (print_packet_info) {
             /* We're printing packet information; print the information for
                this packet. */
+            elapsed_start = g_get_monotonic_time();
             print_packet(cf, edt);
+            tshark_elapsed.second_pass.print += g_get_monotonic_time() - elapsed_start;
+            tshark_elapsed.second_pass.printed++;
 
             /* If we're doing "line-buffering", flush the standard output
                after every packet.  See the comment above, for the "-l"
@@ -3550,7 +4196,7 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
             if (line_buffered)
                 fflush(stdout);
 
-            if (ferror(stdout)) {
+            if (ferror(stdout) || !next_output_sink_file(cf)) {
                 show_print_file_io_error();
                 exit(2);
             }
@@ -3589,6 +4235,82 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, gchar **err_info)
     return TRUE;
 }
 
+static epan_dissect_t *
+second_pass_edt_new(capture_file *cf)
+{
+    gboolean create_proto_tree;
+
+    if (!do_dissection)
+        return NULL;
+
+    /*
+     * Determine whether we need to create a protocol tree.
+     * We do if:
+     *
+     *    we're going to apply a display filter;
+     *
+     *    we're going to print the protocol tree;
+     *
+     *    one of the tap listeners requires a protocol tree;
+     *
+     *    we have custom columns (which require field values, which
+     *    currently requires that we build a protocol tree).
+     */
+    create_proto_tree =
+        (cf->dfcode || print_details || have_filtering_tap_listeners() ||
+         (union_of_tap_listener_flags() & TL_REQUIRES_PROTO_TREE) ||
+         have_custom_cols(&cf->cinfo) || dissect_color);
+
+    ws_debug("tshark: create_proto_tree = %s", create_proto_tree ? "TRUE" : "FALSE");
+
+    /* The protocol tree will be "visible", i.e., printed, only if we're
+       printing packet details, which is true if we're printing stuff
+       ("print_packet_info" is true) and we're in verbose mode
+       ("packet_details" is true), and not only printing fields. */
+    return epan_dissect_new(cf->epan, create_proto_tree, print_tree_visible);
+}
+
+/*
+ * Read a frame from the first pass again, dissect it for the second
+ * pass and, if it passes the filters, write it out.
+ */
+static pass_status_t
+process_frame_second_pass(capture_file *cf, epan_dissect_t *edt,
+        wtap_dumper *pdh, guint32 framenum, wtap_rec *rec, Buffer *buf,
+        guint tap_flags, int *write_framenum,
+        int *err, gchar **err_info, volatile guint32 *err_framenum)
+{
+    frame_data *fdata;
+    gint64      elapsed_start;
+
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    elapsed_start = g_get_monotonic_time();
+    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, err,
+                err_info)) {
+        /* Error reading from the input file. */
+        return PASS_READ_ERROR;
+    }
+    tshark_elapsed.second_pass.read += g_get_monotonic_time() - elapsed_start;
+    ws_debug("tshark: invoking process_packet_second_pass() for frame #%u", framenum);
+    if (process_packet_second_pass(cf, edt, fdata, rec, buf, tap_flags)) {
+        /* Either there's no read filtering or this packet passed the
+           filter, so, if we're writing to a capture file, write
+           this packet out. */
+        (*write_framenum)++;
+        if (pdh != NULL) {
+            ws_debug("tshark: writing packet #%u to outfile packet #%d", framenum, *write_framenum);
+            if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(buf), err, err_info)) {
+                /* Error writing to the output file. */
+                ws_debug("tshark: error writing to a capture file (%d)", *err);
+                *err_framenum = framenum;
+                return PASS_WRITE_ERROR;
+            }
+        }
+    }
+    wtap_rec_reset(rec);
+    return PASS_SUCCEEDED;
+}
+
 static pass_status_t
 process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
         int *err, gchar **err_info,
@@ -3597,12 +4319,10 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
 {
     wtap_rec        rec;
     Buffer          buf;
-    int             framenum = 0;
+    guint32         framenum;
     int             write_framenum = 0;
-    frame_data     *fdata;
-    gboolean        filtering_tap_listeners;
     guint           tap_flags;
-    epan_dissect_t *edt = NULL;
+    epan_dissect_t *edt;
     pass_status_t   status = PASS_SUCCEEDED;
 
     /*
@@ -3618,40 +4338,10 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
 
-    /* Do we have any tap listeners with filters? */
-    filtering_tap_listeners = have_filtering_tap_listeners();
-
     /* Get the union of the flags for all tap listeners. */
     tap_flags = union_of_tap_listener_flags();
 
-    if (do_dissection) {
-        gboolean create_proto_tree;
-
-        /*
-         * Determine whether we need to create a protocol tree.
-         * We do if:
-         *
-         *    we're going to apply a display filter;
-         *
-         *    we're going to print the protocol tree;
-         *
-         *    one of the tap listeners requires a protocol tree;
-         *
-         *    we have custom columns (which require field values, which
-         *    currently requires that we build a protocol tree).
-         */
-        create_proto_tree =
-            (cf->dfcode || print_details || filtering_tap_listeners ||
-             (tap_flags & TL_REQUIRES_PROTO_TREE) || have_custom_cols(&cf->cinfo) || dissect_color);
-
-        ws_debug("tshark: create_proto_tree = %s", create_proto_tree ? "TRUE" : "FALSE");
-
-        /* The protocol tree will be "visible", i.e., printed, only if we're
-           printing packet details, which is true if we're printing stuff
-           ("print_packet_info" is true) and we're in verbose mode
-           ("packet_details" is true). */
-        edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
-    }
+    edt = second_pass_edt_new(cf);
 
     /*
      * Force synchronous resolution of IP addresses; in this pass, we
@@ -3659,53 +4349,367 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
      */
     set_resolution_synchrony(TRUE);
 
-    for (framenum = 1; framenum <= (int)cf->count; framenum++) {
+    for (framenum = 1; framenum <= cf->count; framenum++) {
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
         }
-        fdata = frame_data_sequence_find(cf->provider.frames, framenum);
-        if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, err,
-                    err_info)) {
-            /* Error reading from the input file. */
-            status = PASS_READ_ERROR;
+        status = process_frame_second_pass(cf, edt, pdh, framenum, &rec, &buf,
+                tap_flags, &write_framenum, err, err_info, err_framenum);
+        if (status != PASS_SUCCEEDED)
+            break;
+        /* Stop reading if we hit a stop condition */
+        if (pdh != NULL && max_write_packet_count > 0 && write_framenum >= max_write_packet_count) {
+            ws_debug("tshark: max_write_packet_count (%d) reached", max_write_packet_count);
+            *err = 0; /* This is not an error */
             break;
         }
-        ws_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
-        if (process_packet_second_pass(cf, edt, fdata, &rec, &buf, tap_flags)) {
-            /* Either there's no read filtering or this packet passed the
-               filter, so, if we're writing to a capture file, write
-               this packet out. */
-            write_framenum++;
-            if (pdh != NULL) {
-                ws_debug("tshark: writing packet #%d to outfile packet #%d", framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
-                    /* Error writing to the output file. */
-                    ws_debug("tshark: error writing to a capture file (%d)", *err);
-                    *err_framenum = framenum;
-                    status = PASS_WRITE_ERROR;
-                    break;
-                }
-                /* Stop reading if we hit a stop condition */
-                if (max_write_packet_count > 0 && write_framenum >= max_write_packet_count) {
-                    ws_debug("tshark: max_write_packet_count (%d) reached", max_write_packet_count);
-                    *err = 0; /* This is not an error */
-                    break;
-                }
+    }
+
+    if (edt)
+        epan_dissect_free(edt);
+
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+
+    return status;
+}
+
+/*
+ * The frame before the next one to dissect, and the cumulative byte
+ * count, for one of the passes when both are run at once.
+ */
+typedef struct {
+    frame_data *prev_dis;
+    frame_data *prev_cap;
+    guint32     cum_bytes;
+} pass_state_t;
+
+static void
+swap_pass_state(capture_file *cf, pass_state_t *state)
+{
+    pass_state_t saved = *state;
+
+    state->prev_dis = cf->provider.prev_dis;
+    state->prev_cap = cf->provider.prev_cap;
+    state->cum_bytes = cum_bytes;
+    cf->provider.prev_dis = saved.prev_dis;
+    cf->provider.prev_cap = saved.prev_cap;
+    cum_bytes = saved.cum_bytes;
+}
+
+/*
+ * Run the second pass two_pass_window frames behind the first one, so a
+ * frame is printed once the frames just after it, which are the ones
+ * most likely to refer back to it (responses, the rest of a reassembled
+ * PDU), have been through the first pass.  Every frame is still dissected
+ * twice, but it's read again while it's in the OS's cache rather than
+ * after the whole file has been read, and output starts straight away.
+ * References further ahead than the window are missed.
+ */
+static pass_status_t
+process_cap_file_windowed_passes(capture_file *cf, wtap_dumper *pdh,
+        int max_packet_count, gint64 max_byte_count,
+        int max_write_packet_count,
+        int *err, gchar **err_info,
+        volatile guint32 *err_framenum)
+{
+    wtap_rec        rec, second_rec;
+    Buffer          buf, second_buf;
+    guint           tap_flags;
+    epan_dissect_t *first_edt, *second_edt;
+    pass_state_t    second_state = { NULL, NULL, 0 };
+    gint64          data_offset;
+    int             framenum = 0;
+    guint32         second_framenum = 0;
+    int             write_framenum = 0;
+    int             read_err;
+    gchar          *read_err_info;
+    gboolean        stop = FALSE;
+    pass_status_t   status = PASS_SUCCEEDED;
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    wtap_rec_init(&second_rec);
+    ws_buffer_init(&second_buf, 1514);
+
+    /* Allocate a frame_data_sequence for all the frames. */
+    cf->provider.frames = new_frame_data_sequence();
+
+    /* Get the union of the flags for all tap listeners. */
+    tap_flags = union_of_tap_listener_flags();
+
+    first_edt = first_pass_edt_new(cf);
+    second_edt = second_pass_edt_new(cf);
+
+    /*
+     * Force synchronous resolution of IP addresses; the second pass
+     * can't do it in the background and fix up past dissections.
+     */
+    set_resolution_synchrony(TRUE);
+
+    ws_debug("tshark: reading records, second pass %u frames behind", two_pass_window);
+    *err = 0;
+    while (!stop && read_record_timed(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+        if (read_interrupted) {
+            status = PASS_INTERRUPTED;
+            break;
+        }
+        framenum++;
+
+        if (process_packet_first_pass(cf, first_edt, data_offset, &rec,
+                                      ws_buffer_start_ptr(&buf))) {
+            /* Stop reading if we hit a stop condition */
+            if (max_packet_count > 0 && framenum >= max_packet_count) {
+                ws_debug("tshark: max_packet_count (%d) reached", max_packet_count);
+                stop = TRUE;
+            }
+            if (max_byte_count != 0 && data_offset >= max_byte_count) {
+                ws_debug("tshark: max_byte_count (%" PRId64 "/%" PRId64 ") reached",
+                        data_offset, max_byte_count);
+                stop = TRUE;
             }
         }
         wtap_rec_reset(&rec);
+
+        while (cf->count - second_framenum > two_pass_window) {
+            if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
+                *err_framenum = second_framenum + 1;
+                status = PASS_WRITE_ERROR;
+                break;
+            }
+            second_framenum++;
+            swap_pass_state(cf, &second_state);
+            status = process_frame_second_pass(cf, second_edt, pdh, second_framenum,
+                    &second_rec, &second_buf, tap_flags, &write_framenum,
+                    err, err_info, err_framenum);
+            swap_pass_state(cf, &second_state);
+            if (status != PASS_SUCCEEDED)
+                break;
+            if (pdh != NULL && max_write_packet_count > 0 && write_framenum >= max_write_packet_count) {
+                ws_debug("tshark: max_write_packet_count (%d) reached", max_write_packet_count);
+                stop = TRUE;
+                break;
+            }
+        }
+        if (status != PASS_SUCCEEDED)
+            break;
     }
+    if (status != PASS_SUCCEEDED)
+        goto done;
 
-    if (edt)
-        epan_dissect_free(edt);
+    /*
+     * As with -2, if we got a read error we still finish the second pass
+     * for the frames we read, and report the error afterwards.
+     */
+    read_err = stop ? 0 : *err;
+    read_err_info = stop ? NULL : *err_info;
+    *err = 0;
+    *err_info = NULL;
+
+    /* Close the sequential I/O side, to free up memory it requires. */
+    wtap_sequential_close(cf->provider.wth);
+
+    /* Allow the protocol dissectors to free up memory that they
+     * don't need after the sequential run-through of the packets. */
+    postseq_cleanup_all_protocols();
+
+    if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
+        *err_framenum = second_framenum + 1;
+        status = PASS_WRITE_ERROR;
+    }
+
+    swap_pass_state(cf, &second_state);
+    while (status == PASS_SUCCEEDED && second_framenum < cf->count &&
+           !(pdh != NULL && max_write_packet_count > 0 && write_framenum >= max_write_packet_count)) {
+        if (read_interrupted) {
+            status = PASS_INTERRUPTED;
+            break;
+        }
+        second_framenum++;
+        status = process_frame_second_pass(cf, second_edt, pdh, second_framenum,
+                &second_rec, &second_buf, tap_flags, &write_framenum,
+                err, err_info, err_framenum);
+    }
 
+    if (status == PASS_SUCCEEDED && read_err != 0) {
+        *err = read_err;
+        *err_info = read_err_info;
+        status = PASS_READ_ERROR;
+    } else {
+        g_free(read_err_info);
+    }
+
+done:
+    if (first_edt)
+        epan_dissect_free(first_edt);
+    if (second_edt)
+        epan_dissect_free(second_edt);
+
+    ws_buffer_free(&second_buf);
+    wtap_rec_cleanup(&second_rec);
     ws_buffer_free(&buf);
     wtap_rec_cleanup(&rec);
 
     return status;
 }
 
+/*
+ * Check whether a file name is that of a file of a file set, as written by
+ * "dumpcap -b" and "tshark -b", i.e. prefix_NNNNN_YYYYmmddHHMMSS.ext with
+ * an optional extension, and if so, return the length of the prefix and
+ * the extension (including the '.', or an empty string).  The files of a
+ * set have the same prefix and extension and sort in the order they were
+ * written.
+ */
+static gboolean
+fileset_name_split(const char *name, size_t *prefix_len, const char **suffix)
+{
+    const size_t pattern_len = strlen("_00001_20050418010750");
+    const char *ext;
+    size_t base_len;
+
+    ext = strrchr(name, '.');
+    if (ext == NULL)
+        ext = name + strlen(name);
+    base_len = ext - name;
+    if (base_len < pattern_len)
+        return FALSE;
+
+    for (size_t i = 0; i < pattern_len; i++) {
+        char c = name[base_len - pattern_len + i];
+
+        if (i == 0 || i == 6) {
+            if (c != '_')
+                return FALSE;
+        } else if (!g_ascii_isdigit(c)) {
+            return FALSE;
+        }
+    }
+
+    if (prefix_len != NULL)
+        *prefix_len = base_len - pattern_len;
+    if (suffix != NULL)
+        *suffix = ext;
+    return TRUE;
+}
+
+/*
+ * Find the file that comes after fname in its file set, or NULL if there
+ * isn't one yet.  The ring buffer may have removed files in between, so
+ * this is the first file of the set that sorts after fname.
+ */
+static char *
+fileset_find_next(const char *fname)
+{
+    const char *basename = get_basename(fname);
+    size_t      prefix_len;
+    const char *suffix;
+    char       *dirname, *fname_dup;
+    WS_DIR     *dir;
+    WS_DIRENT  *file;
+    char       *next_name = NULL, *next_path = NULL;
+
+    if (!fileset_name_split(basename, &prefix_len, &suffix))
+        return NULL;
+
+    fname_dup = g_strdup(fname);
+    dirname = get_dirname(fname_dup);
+    dirname = g_strdup(dirname != NULL ? dirname : ".");
+    g_free(fname_dup);
+
+    if ((dir = ws_dir_open(dirname, 0, NULL)) != NULL) {
+        while ((file = ws_dir_read_name(dir)) != NULL) {
+            const char *name = ws_dir_get_name(file);
+            size_t      name_prefix_len;
+            const char *name_suffix;
+
+            if (!fileset_name_split(name, &name_prefix_len, &name_suffix) ||
+                    name_prefix_len != prefix_len ||
+                    strncmp(name, basename, prefix_len) != 0 ||
+                    strcmp(name_suffix, suffix) != 0)
+                continue;
+            if (strcmp(name, basename) > 0 &&
+                    (next_name == NULL || strcmp(name, next_name) < 0)) {
+                g_free(next_name);
+                next_name = g_strdup(name);
+            }
+        }
+        ws_dir_close(dir);
+    }
+
+    if (next_name != NULL) {
+        next_path = g_build_filename(dirname, next_name, NULL);
+        g_free(next_name);
+    }
+    g_free(dirname);
+    return next_path;
+}
+
+/*
+ * Wait until the file after fname in its file set has been created, which
+ * means that fname has been closed.  Returns the name of the next file, or
+ * NULL if we were interrupted.
+ */
+static char *
+fileset_wait_for_next(const char *fname)
+{
+    char *next_path;
+
+    while ((next_path = fileset_find_next(fname)) == NULL) {
+        if (read_interrupted)
+            return NULL;
+        g_usleep(FOLLOW_FILESET_POLL_INTERVAL);
+    }
+    return next_path;
+}
+
+/*
+ * Read the next record, going on to the next file of the set at the end
+ * of each file if we're following a file set.  The session, and the frame
+ * numbers, carry on from one file to the next.
+ */
+static gboolean
+read_record_single_pass(capture_file *cf, char **next_file, wtap_rec *rec,
+        Buffer *buf, int *err, gchar **err_info, gint64 *data_offset)
+{
+    wtap *wth;
+
+    while (!read_record_timed(cf->provider.wth, rec, buf, err, err_info, data_offset)) {
+        if (!follow_fileset || *err != 0 || *next_file == NULL)
+            return FALSE;
+
+        ws_debug("tshark: going on to %s", *next_file);
+        wth = wtap_open_offline(*next_file, cf->open_type, err, err_info, FALSE);
+        if (wth == NULL) {
+            /* The ring buffer may already have removed it. */
+            if (*err == ENOENT) {
+                char *later_file = fileset_wait_for_next(*next_file);
+
+                g_free(*next_file);
+                *next_file = later_file;
+                continue;
+            }
+            cfile_open_failure_message(*next_file, *err, *err_info);
+            *err = 0;
+            return FALSE;
+        }
+        wtap_close(cf->provider.wth);
+        cf->provider.wth = wth;
+        g_free(cf->filename);
+        cf->filename = *next_file;
+        cf->cd_t = wtap_file_type_subtype(wth);
+        cf->snap = wtap_snapshot_length(wth);
+        wtap_set_cb_new_ipv4(wth, add_ipv4_name);
+        wtap_set_cb_new_ipv6(wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+        wtap_set_cb_new_secrets(wth, secrets_wtap_callback);
+
+        /* Don't read it until the ring buffer has finished writing it. */
+        *next_file = fileset_wait_for_next(cf->filename);
+    }
+    return TRUE;
+}
+
 static pass_status_t
 process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         int max_packet_count, gint64 max_byte_count,
@@ -3722,6 +4726,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     int             write_framenum = 0;
     epan_dissect_t *edt = NULL;
     gint64          data_offset;
+    char           *next_file = NULL;
     pass_status_t   status = PASS_SUCCEEDED;
 
     wtap_rec_init(&rec);
@@ -3764,8 +4769,8 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         /* The protocol tree will be "visible", i.e., printed, only if we're
            printing packet details, which is true if we're printing stuff
            ("print_packet_info" is true) and we're in verbose mode
-           ("packet_details" is true). */
-        edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+           ("packet_details" is true), and not only printing fields. */
+        edt = epan_dissect_new(cf->epan, create_proto_tree, print_tree_visible);
     }
 
     /*
@@ -3775,8 +4780,13 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
      */
     set_resolution_synchrony(TRUE);
 
+    if (follow_fileset) {
+        /* Wait for the ring buffer to finish writing the first file, too. */
+        next_file = fileset_wait_for_next(cf->filename);
+    }
+
     *err = 0;
-    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+    while (read_record_single_pass(cf, &next_file, &rec, &buf, err, err_info, &data_offset)) {
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
@@ -3792,24 +4802,29 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             break;
         }
 
-        ws_debug("tshark: processing packet #%d", framenum);
-
-        reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
-
-        if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
-            /* Either there's no read filtering or this packet passed the
-               filter, so, if we're writing to a capture file, write
-               this packet out. */
-            write_framenum++;
-            if (pdh != NULL) {
-                ws_debug("tshark: writing packet #%d to outfile as #%d",
-                        framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
-                    /* Error writing to the output file. */
-                    ws_debug("tshark: error writing to a capture file (%d)", *err);
-                    *err_framenum = framenum;
-                    status = PASS_WRITE_ERROR;
-                    break;
+        if (flow_partition_count != 0 && !frame_in_flow_partition(&rec, &buf)) {
+            ws_debug("tshark: skipping packet #%d, in another flow partition", framenum);
+            skip_packet_single_pass(cf, data_offset, &rec);
+        } else {
+            ws_debug("tshark: processing packet #%d", framenum);
+
+            reset_epan_mem(cf, edt, create_proto_tree, print_tree_visible);
+
+            if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
+                /* Either there's no read filtering or this packet passed the
+                   filter, so, if we're writing to a capture file, write
+                   this packet out. */
+                write_framenum++;
+                if (pdh != NULL) {
+                    ws_debug("tshark: writing packet #%d to outfile as #%d",
+                            framenum, write_framenum);
+                    if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+                        /* Error writing to the output file. */
+                        ws_debug("tshark: error writing to a capture file (%d)", *err);
+                        *err_framenum = framenum;
+                        status = PASS_WRITE_ERROR;
+                        break;
+                    }
                 }
             }
         }
@@ -3850,6 +4865,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     if (edt)
         epan_dissect_free(edt);
 
+    g_free(next_file);
     ws_buffer_free(&buf);
     wtap_rec_cleanup(&rec);
 
@@ -3947,7 +4963,23 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
         sigaction(SIGHUP, &action, NULL);
 #endif /* _WIN32 */
 
-    if (perform_two_pass_analysis) {
+    if (perform_two_pass_analysis && two_pass_window != 0) {
+        ws_debug("tshark: perform windowed two pass analysis, do_dissection=%s", do_dissection ? "TRUE" : "FALSE");
+
+        first_pass_status = PASS_SUCCEEDED; /* It's run along with the second pass */
+
+        elapsed_start = g_get_monotonic_time();
+        second_pass_status = process_cap_file_windowed_passes(cf, pdh,
+                max_packet_count,
+                max_byte_count,
+                max_write_packet_count,
+                &err, &err_info,
+                &err_framenum);
+        tshark_elapsed.elapsed_first_pass = g_get_monotonic_time() - elapsed_start;
+
+        ws_debug("tshark: done with windowed two passes");
+    }
+    else if (perform_two_pass_analysis) {
         ws_debug("tshark: perform_two_pass_analysis, do_dissection=%s", do_dissection ? "TRUE" : "FALSE");
 
         elapsed_start = g_get_monotonic_time();
@@ -3959,6 +4991,13 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
 
         ws_debug("tshark: done with first pass");
 
+        /*
+         * Resolve the addresses looked up in the first pass now, many
+         * at a time, so the second pass finds them in the cache instead
+         * of resolving them one by one.
+         */
+        host_name_lookup_wait();
+
         if (first_pass_status == PASS_INTERRUPTED) {
             /* The first pass was interrupted; skip the second pass.
                It won't be run, so it won't get an error. */
@@ -4141,6 +5180,45 @@ out:
     return status;
 }
 
+/*
+ * Is this frame in the flow partition we're dissecting?  Records other
+ * than packets, and packets we can't classify, go in the first partition.
+ */
+static gboolean
+frame_in_flow_partition(const wtap_rec *rec, Buffer *buf)
+{
+    guint32 hash = 0;
+
+    if (rec->rec_type == REC_TYPE_PACKET)
+        hash = flow_partition_hash(rec->rec_header.packet_header.pkt_encap,
+                                   ws_buffer_start_ptr(buf), rec->rec_header.packet_header.caplen);
+    return hash % flow_partition_count == flow_partition_index;
+}
+
+/*
+ * Count a frame that's in another flow partition, without dissecting
+ * it, but keep track of it as the reference and previous captured frame,
+ * so that frame numbers and relative and delta times match those we'd
+ * show if we dissected everything.
+ */
+static void
+skip_packet_single_pass(capture_file *cf, gint64 offset, wtap_rec *rec)
+{
+    frame_data      fdata;
+
+    cf->count++;
+    frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
+    frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+            &cf->provider.ref, cf->provider.prev_dis);
+    if (cf->provider.ref == &fdata) {
+        ref_frame = fdata;
+        cf->provider.ref = &ref_frame;
+    }
+    prev_cap_frame = fdata;
+    cf->provider.prev_cap = &prev_cap_frame;
+    frame_data_destroy(&fdata);
+}
+
 static gboolean
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         wtap_rec *rec, Buffer *buf, guint tap_flags _U_)
@@ -4178,6 +5256,10 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
         col_custom_prime_edt(edt, &cf->cinfo);
 
+        /* If the tree we print isn't visible, it needs the printed fields. */
+        if (print_packet_info && print_details && !print_tree_visible)
+            output_fields_prime_edt(output_fields, edt);
+
         /* We only need the columns if either
            1) some tap or filter needs the columns
            or
@@ -4199,7 +5281,8 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
         if (dissect_color) {
             color_filters_prime_edt(edt);
-            fdata.need_colorize = 1;
+            if (colorize_while_dissecting(cf))
+                fdata.need_colorize = 1;
         }
 
         /* epan_dissect_run (and epan_dissect_reset) unref the block.
@@ -4227,7 +5310,10 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             /* We're printing packet information; print the information for
                this packet. */
             ws_assert(edt);
+            elapsed_start = g_get_monotonic_time();
             print_packet(cf, edt);
+            tshark_elapsed.first_pass.print += g_get_monotonic_time() - elapsed_start;
+            tshark_elapsed.first_pass.printed++;
 
             /* If we're doing "line-buffering", flush the standard output
                after every packet.  See the comment above, for the "-l"
@@ -4235,7 +5321,7 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             if (line_buffered)
                 fflush(stdout);
 
-            if (ferror(stdout)) {
+            if (ferror(stdout) || !next_output_sink_file(cf)) {
                 show_print_file_io_error();
                 exit(2);
             }
@@ -4585,6 +5671,9 @@ print_columns(capture_file *cf, const epan_dissect_t *edt)
 static gboolean
 print_packet(capture_file *cf, epan_dissect_t *edt)
 {
+    if (dissect_color && !colorize_while_dissecting(cf))
+        edt->pi.fd->color_filter = color_filters_colorize_packet(edt);
+
     if (print_summary || output_fields_has_cols(output_fields))
         /* Just fill in the columns. */
         epan_dissect_fill_in_columns(edt, FALSE, TRUE);
@@ -4705,6 +5794,183 @@ write_finale(void)
     }
 }
 
+/*
+ * Name of the n'th output file with --output-file-size: "out.json"
+ * becomes "out_00001.json", "out_00002.json", and so on.
+ */
+static char *
+output_sink_file_name(guint num)
+{
+    const char *dot = strrchr(output_sink_file, '.');
+    const char *sep = strrchr(output_sink_file, G_DIR_SEPARATOR);
+
+    if (dot == NULL || dot == output_sink_file || (sep != NULL && dot <= sep + 1))
+        return ws_strdup_printf("%s_%05u", output_sink_file, num);
+    return ws_strdup_printf("%.*s_%05u%s", (int)(dot - output_sink_file),
+            output_sink_file, num, dot);
+}
+
+static gboolean
+open_output_sink_file(void)
+{
+    char *name;
+
+    if (output_sink_file_size != 0)
+        name = output_sink_file_name(++output_sink_file_num);
+    else
+        name = g_strdup(output_sink_file);
+    if (ws_freopen(name, "w", stdout) == NULL) {
+        cmdarg_err("The output file \"%s\" could not be created: %s.",
+                name, g_strerror(errno));
+        g_free(name);
+        return FALSE;
+    }
+    g_free(name);
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_SINK_BUFFER_SIZE);
+    return TRUE;
+}
+
+/*
+ * Send what would go to the standard output to the socket or file given
+ * with --output-socket or --output-file.  Output is written a large
+ * buffer at a time, and a reader that can't keep up makes us wait.
+ */
+static gboolean
+open_output_sink(void)
+{
+#ifndef _WIN32
+    if (output_socket_path != NULL) {
+        struct sockaddr_un sa;
+        int fd, err;
+
+        memset(&sa, 0, sizeof sa);
+        sa.sun_family = AF_UNIX;
+        if (g_strlcpy(sa.sun_path, output_socket_path, sizeof sa.sun_path) >= sizeof sa.sun_path) {
+            cmdarg_err("The output socket path \"%s\" is too long.", output_socket_path);
+            return FALSE;
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1 || connect(fd, (struct sockaddr *)&sa, sizeof sa) == -1 ||
+                dup2(fd, ws_fileno(stdout)) == -1) {
+            err = errno;
+            cmdarg_err("Couldn't connect to the output socket \"%s\": %s.",
+                    output_socket_path, g_strerror(err));
+            if (fd != -1)
+                ws_close(fd);
+            return FALSE;
+        }
+        ws_close(fd);
+        setvbuf(stdout, NULL, _IOFBF, OUTPUT_SINK_BUFFER_SIZE);
+        return TRUE;
+    }
+#endif
+    if (output_sink_file != NULL)
+        return open_output_sink_file();
+    return TRUE;
+}
+
+/*
+ * With --output-file-size, once the output file has reached that size,
+ * finish it and start the next one, so that each file is complete in
+ * itself.
+ */
+static gboolean
+next_output_sink_file(capture_file *cf)
+{
+    gint64 size;
+
+    if (output_sink_file_size == 0)
+        return TRUE;
+
+    size = ws_ftell64(stdout);
+    if (size < 0 || (guint64)size < (guint64)output_sink_file_size * 1024 * 1024)
+        return TRUE;
+
+    if (!write_finale())
+        return FALSE;
+    if (!open_output_sink_file())
+        exit(2);
+    return write_preamble(cf);
+}
+
+#ifndef _WIN32
+static gpointer
+output_thread_main(gpointer data _U_)
+{
+    char    *buf = (char *)g_malloc(OUTPUT_SINK_BUFFER_SIZE);
+    ssize_t  nread, nwritten, offset;
+
+    for (;;) {
+        nread = ws_read(output_thread_pipe, buf, OUTPUT_SINK_BUFFER_SIZE);
+        if (nread == 0)
+            break;      /* The main thread is done (finish_output_thread()) */
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            g_atomic_int_set(&output_thread_err, errno);
+            break;
+        }
+        for (offset = 0; offset < nread; offset += nwritten) {
+            nwritten = ws_write(output_thread_fd, buf + offset, nread - offset);
+            if (nwritten < 0) {
+                if (errno == EINTR) {
+                    nwritten = 0;
+                    continue;
+                }
+                g_atomic_int_set(&output_thread_err, errno);
+                goto done;
+            }
+        }
+    }
+done:
+    /* After an error, this makes the main thread's writes fail too. */
+    ws_close(output_thread_pipe);
+    g_free(buf);
+    return NULL;
+}
+
+static void
+finish_output_thread(void)
+{
+    fflush(stdout);
+    /* Closing the write end of the pipe lets the thread finish. */
+    ws_close(ws_fileno(stdout));
+    g_thread_join(output_thread);
+    dup2(output_thread_fd, ws_fileno(stdout));
+    ws_close(output_thread_fd);
+}
+
+static gboolean
+start_output_thread(void)
+{
+    int fds[2];
+
+    fflush(stdout);
+    if (pipe(fds) == -1) {
+        cmdarg_err("Couldn't create the output pipe: %s.", g_strerror(errno));
+        return FALSE;
+    }
+    output_thread_fd = ws_dup(ws_fileno(stdout));
+    if (output_thread_fd == -1 || dup2(fds[1], ws_fileno(stdout)) == -1) {
+        cmdarg_err("Couldn't redirect the standard output: %s.", g_strerror(errno));
+        ws_close(fds[0]);
+        ws_close(fds[1]);
+        return FALSE;
+    }
+    ws_close(fds[1]);
+    output_thread_pipe = fds[0];
+#ifdef F_SETPIPE_SZ
+    /* A larger pipe lets dissection get further ahead of the writes. */
+    (void)fcntl(ws_fileno(stdout), F_SETPIPE_SZ, OUTPUT_SINK_BUFFER_SIZE);
+#endif
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_SINK_BUFFER_SIZE);
+
+    output_thread = g_thread_new("tshark output", output_thread_main, NULL);
+    atexit(finish_output_thread);
+    return TRUE;
+}
+#endif /* _WIN32 */
+
 void
 cf_close(capture_file *cf)
 {
@@ -4785,6 +6051,12 @@ fail:
 static void
 show_print_file_io_error(void)
 {
+#ifndef _WIN32
+    /* If the output thread couldn't write, we just see the pipe close. */
+    if (errno == EPIPE && g_atomic_int_get(&output_thread_err) != 0)
+        errno = g_atomic_int_get(&output_thread_err);
+#endif
+
     switch (errno) {
 
         case ENOSPC:
@@ -4880,10 +6152,20 @@ tshark_cmdarg_err_cont(const char *msg_format, va_list ap)
 static void
 reset_epan_mem(capture_file *cf,epan_dissect_t *edt, gboolean tree, gboolean visual)
 {
-    if (!epan_auto_reset || (cf->count < epan_auto_reset_count))
+    wmem_allocator_stats_t stats;
+
+    if (epan_auto_reset && cf->count >= epan_auto_reset_count) {
+        fprintf(stderr, "resetting session.\n");
+    } else if (session_memory_limit != 0) {
+        /* Most of what dissectors keep about a capture is in file scope. */
+        wmem_get_stats(wmem_file_scope(), &stats);
+        if (stats.retained < (size_t)session_memory_limit * 1024 * 1024)
+            return;
+        fprintf(stderr, "resetting session after %u packets, at %zu MiB.\n",
+                cf->count, stats.retained / (1024 * 1024));
+    } else {
         return;
-
-    fprintf(stderr, "resetting session.\n");
+    }
 
     epan_dissect_cleanup(edt);
     epan_free(cf->epan);
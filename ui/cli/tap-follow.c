@@ -20,7 +20,9 @@
 
 #include <glib.h>
 #include <epan/addr_resolv.h>
+#include <wsutil/file_util.h>
 #include <wsutil/str_util.h>
+#include <wsutil/tempfile.h>
 #include <wsutil/unicode-utils.h>
 #include <epan/follow.h>
 #include <epan/stat_tap_ui.h>
@@ -57,6 +59,12 @@ typedef struct _cli_follow_info {
     guint32           addrBuf_v4;
     ws_in6_addr addrBuf_v6;
   }             addrBuf[2];
+
+  /* output */
+  FILE         *out_fp;          /* records printed so far, if not kept in memory */
+  char         *out_filename;
+  guint32       chunk;           /* records seen so far */
+  guint32       global_pos[2];   /* bytes seen so far, for each peer */
 } cli_follow_info_t;
 
 
@@ -100,6 +108,12 @@ follow_free(follow_info_t *follow_info)
 {
   cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)follow_info->gui_data;
 
+  if (cli_follow_info->out_fp != NULL)
+  {
+    fclose(cli_follow_info->out_fp);
+    ws_unlink(cli_follow_info->out_filename);
+  }
+  g_free(cli_follow_info->out_filename);
   g_free(cli_follow_info);
   follow_info_free(follow_info);
 }
@@ -117,7 +131,7 @@ follow_free(follow_info_t *follow_info)
 static const char       bin2hex[] = {'0', '1', '2', '3', '4', '5', '6', '7',
                                      '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
-static void follow_print_hex(const char *prefixp, guint32 offset, void *datap, int len)
+static void follow_print_hex(FILE *fp, const char *prefixp, guint32 offset, void *datap, int len)
 {
   int           ii;
   int           jj;
@@ -164,12 +178,158 @@ static void follow_print_hex(const char *prefixp, guint32 offset, void *datap, i
         kk--;
       }
       line[kk] = 0;
-      printf("%s%s\n", prefixp, line);
+      fprintf(fp, "%s%s\n", prefixp, line);
       offset += BYTES_PER_LINE;
     }
   }
 }
 
+static void follow_print_record(FILE *fp, cli_follow_info_t *cli_follow_info, follow_record_t *follow_record)
+{
+  guint32 *global_pos;
+  guint32           ii, jj;
+  char              *buffer;
+  wmem_strbuf_t     *strbuf;
+  gchar             *b64encoded;
+  const guint32     base64_raw_len = 57; /* Encodes to 76 bytes, common in RFCs */
+
+  cli_follow_info->chunk++;
+  global_pos = &cli_follow_info->global_pos[follow_record->is_server ? 1 : 0];
+
+  /* ignore chunks not in range */
+  if ((cli_follow_info->chunk < cli_follow_info->chunkMin) || (cli_follow_info->chunk > cli_follow_info->chunkMax)) {
+    (*global_pos) += follow_record->data->len;
+    return;
+  }
+
+  /* Print start of line */
+  switch (cli_follow_info->show_type)
+  {
+  case SHOW_HEXDUMP:
+  case SHOW_YAML:
+  case SHOW_CODEC: /* The transformation to UTF-8 can change the length */
+    break;
+
+  case SHOW_ASCII:
+  case SHOW_EBCDIC:
+    fprintf(fp, "%s%u\n", follow_record->is_server ? "\t" : "", follow_record->data->len);
+    break;
+
+  case SHOW_RAW:
+    if (follow_record->is_server)
+    {
+      putc('\t', fp);
+    }
+    break;
+
+  default:
+    ws_assert_not_reached();
+  }
+
+  /* Print data */
+  switch (cli_follow_info->show_type)
+  {
+  case SHOW_HEXDUMP:
+    follow_print_hex(fp, follow_record->is_server ? "\t" : "", *global_pos, follow_record->data->data, follow_record->data->len);
+    (*global_pos) += follow_record->data->len;
+    break;
+
+  case SHOW_ASCII:
+  case SHOW_EBCDIC:
+    buffer = (char *)g_malloc(follow_record->data->len+2);
+
+    for (ii = 0; ii < follow_record->data->len; ii++)
+    {
+      switch (follow_record->data->data[ii])
+      {
+      // XXX: qt/follow_stream_dialog.c sanitize_buffer() also passes
+      // tabs ('\t') through. Should we do that here too?
+      // The Qt code has automatic universal new line handling for reading
+      // so, e.g., \r\n in HTML becomes just \n, but we don't do that here.
+      // (The Qt version doesn't write the file as Text, so all files use
+      // Unix line endings, including on Windows.)
+      case '\r':
+      case '\n':
+        buffer[ii] = follow_record->data->data[ii];
+        break;
+      default:
+        buffer[ii] = g_ascii_isprint(follow_record->data->data[ii]) ? follow_record->data->data[ii] : '.';
+        break;
+      }
+    }
+
+    buffer[ii++] = '\n';
+    buffer[ii] = 0;
+    if (cli_follow_info->show_type == SHOW_EBCDIC) {
+      EBCDIC_to_ASCII(buffer, ii);
+    }
+    fprintf(fp, "%s", buffer);
+    g_free(buffer);
+    break;
+
+  case SHOW_CODEC:
+    // This does the same as the Show As UTF-8 code in the Qt version
+    // (passing through all legal UTF-8, including control codes and
+    // internal NULs, substituting illegal UTF-8 sequences with
+    // REPLACEMENT CHARACTER, and not handling valid UTF-8 sequences
+    // which are split between unreassembled frames), except for the
+    // end of line terminator issue as above.
+    strbuf = ws_utf8_make_valid_strbuf(NULL, follow_record->data->data, follow_record->data->len);
+    fprintf(fp, "%s%zu\n", follow_record->is_server ? "\t" : "", wmem_strbuf_get_len(strbuf));
+    fwrite(wmem_strbuf_get_str(strbuf), 1, wmem_strbuf_get_len(strbuf), fp);
+    wmem_strbuf_destroy(strbuf);
+    putc('\n', fp);
+    break;
+
+  case SHOW_RAW:
+    buffer = (char *)g_malloc((follow_record->data->len*2)+2);
+
+    for (ii = 0, jj = 0; ii < follow_record->data->len; ii++)
+    {
+      buffer[jj++] = bin2hex[follow_record->data->data[ii] >> 4];
+      buffer[jj++] = bin2hex[follow_record->data->data[ii] & 0xf];
+    }
+
+    buffer[jj++] = '\n';
+    buffer[jj] = 0;
+    fprintf(fp, "%s", buffer);
+    g_free(buffer);
+    break;
+
+  case SHOW_YAML:
+    fprintf(fp, "  - packet: %d\n", follow_record->packet_num);
+    fprintf(fp, "    peer: %d\n", follow_record->is_server ? 1 : 0);
+    fprintf(fp, "    timestamp: %.9f\n", nstime_to_sec(&follow_record->abs_ts));
+    fprintf(fp, "    data: !!binary |\n");
+    ii = 0;
+    while (ii < follow_record->data->len) {
+        guint32 len = ii + base64_raw_len < follow_record->data->len
+              ? base64_raw_len
+              : follow_record->data->len - ii;
+        b64encoded = g_base64_encode(&follow_record->data->data[ii], len);
+        fprintf(fp, "      %s\n", b64encoded);
+        g_free(b64encoded);
+        ii += len;
+    }
+    break;
+
+  default:
+    ws_assert_not_reached();
+  }
+}
+
+/*
+ * Print each record to the output file as it is tapped, so that a long
+ * stream isn't kept in memory until the end.
+ */
+static gboolean follow_write_record(follow_info_t *follow_info, follow_record_t *follow_record)
+{
+  cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)follow_info->gui_data;
+
+  follow_print_record(cli_follow_info->out_fp, cli_follow_info, follow_record);
+  return TRUE;
+}
+
 static void follow_draw(void *contextp)
 {
   static const char     separator[] =
@@ -178,16 +338,9 @@ static void follow_draw(void *contextp)
   follow_info_t *follow_info = (follow_info_t*)contextp;
   cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)follow_info->gui_data;
   gchar             buf[WS_INET6_ADDRSTRLEN];
-  guint32 global_client_pos = 0, global_server_pos = 0;
-  guint32 *global_pos;
-  guint32           ii, jj;
-  char              *buffer;
-  wmem_strbuf_t     *strbuf;
   GList             *cur;
-  follow_record_t   *follow_record;
-  guint             chunk;
-  gchar             *b64encoded;
-  const guint32     base64_raw_len = 57; /* Encodes to 76 bytes, common in RFCs */
+  char              copy_buf[65536];
+  size_t            nread;
 
   /* Print header */
   switch (cli_follow_info->show_type)
@@ -224,136 +377,23 @@ static void follow_draw(void *contextp)
       break;
   }
 
-  for (cur = g_list_last(follow_info->payload), chunk = 1;
-       cur != NULL;
-       cur = g_list_previous(cur), chunk++)
+  if (cli_follow_info->out_fp != NULL)
   {
-    follow_record = (follow_record_t *)cur->data;
-    if (!follow_record->is_server) {
-      global_pos = &global_client_pos;
-    } else {
-      global_pos = &global_server_pos;
-    }
-
-    /* ignore chunks not in range */
-    if ((chunk < cli_follow_info->chunkMin) || (chunk > cli_follow_info->chunkMax)) {
-      (*global_pos) += follow_record->data->len;
-      continue;
-    }
-
-    /* Print start of line */
-    switch (cli_follow_info->show_type)
+    /* The records have already been printed; copy them out. */
+    fflush(stdout);
+    rewind(cli_follow_info->out_fp);
+    while ((nread = fread(copy_buf, 1, sizeof copy_buf, cli_follow_info->out_fp)) > 0)
     {
-    case SHOW_HEXDUMP:
-    case SHOW_YAML:
-    case SHOW_CODEC: /* The transformation to UTF-8 can change the length */
-      break;
-
-    case SHOW_ASCII:
-    case SHOW_EBCDIC:
-      printf("%s%u\n", follow_record->is_server ? "\t" : "", follow_record->data->len);
-      break;
-
-    case SHOW_RAW:
-      if (follow_record->is_server)
-      {
-        putchar('\t');
-      }
-      break;
-
-    default:
-      ws_assert_not_reached();
+      fwrite(copy_buf, 1, nread, stdout);
     }
-
-    /* Print data */
-    switch (cli_follow_info->show_type)
+  }
+  else
+  {
+    cli_follow_info->chunk = 0;
+    cli_follow_info->global_pos[0] = cli_follow_info->global_pos[1] = 0;
+    for (cur = g_list_last(follow_info->payload); cur != NULL; cur = g_list_previous(cur))
     {
-    case SHOW_HEXDUMP:
-      follow_print_hex(follow_record->is_server ? "\t" : "", *global_pos, follow_record->data->data, follow_record->data->len);
-      (*global_pos) += follow_record->data->len;
-      break;
-
-    case SHOW_ASCII:
-    case SHOW_EBCDIC:
-      buffer = (char *)g_malloc(follow_record->data->len+2);
-
-      for (ii = 0; ii < follow_record->data->len; ii++)
-      {
-        switch (follow_record->data->data[ii])
-        {
-        // XXX: qt/follow_stream_dialog.c sanitize_buffer() also passes
-        // tabs ('\t') through. Should we do that here too?
-        // The Qt code has automatic universal new line handling for reading
-        // so, e.g., \r\n in HTML becomes just \n, but we don't do that here.
-        // (The Qt version doesn't write the file as Text, so all files use
-        // Unix line endings, including on Windows.)
-        case '\r':
-        case '\n':
-          buffer[ii] = follow_record->data->data[ii];
-          break;
-        default:
-          buffer[ii] = g_ascii_isprint(follow_record->data->data[ii]) ? follow_record->data->data[ii] : '.';
-          break;
-        }
-      }
-
-      buffer[ii++] = '\n';
-      buffer[ii] = 0;
-      if (cli_follow_info->show_type == SHOW_EBCDIC) {
-        EBCDIC_to_ASCII(buffer, ii);
-      }
-      printf("%s", buffer);
-      g_free(buffer);
-      break;
-
-    case SHOW_CODEC:
-      // This does the same as the Show As UTF-8 code in the Qt version
-      // (passing through all legal UTF-8, including control codes and
-      // internal NULs, substituting illegal UTF-8 sequences with
-      // REPLACEMENT CHARACTER, and not handling valid UTF-8 sequences
-      // which are split between unreassembled frames), except for the
-      // end of line terminator issue as above.
-      strbuf = ws_utf8_make_valid_strbuf(NULL, follow_record->data->data, follow_record->data->len);
-      printf("%s%zu\n", follow_record->is_server ? "\t" : "", wmem_strbuf_get_len(strbuf));
-      fwrite(wmem_strbuf_get_str(strbuf), 1, wmem_strbuf_get_len(strbuf), stdout);
-      wmem_strbuf_destroy(strbuf);
-      putchar('\n');
-      break;
-
-    case SHOW_RAW:
-      buffer = (char *)g_malloc((follow_record->data->len*2)+2);
-
-      for (ii = 0, jj = 0; ii < follow_record->data->len; ii++)
-      {
-        buffer[jj++] = bin2hex[follow_record->data->data[ii] >> 4];
-        buffer[jj++] = bin2hex[follow_record->data->data[ii] & 0xf];
-      }
-
-      buffer[jj++] = '\n';
-      buffer[jj] = 0;
-      printf("%s", buffer);
-      g_free(buffer);
-      break;
-
-    case SHOW_YAML:
-      printf("  - packet: %d\n", follow_record->packet_num);
-      printf("    peer: %d\n", follow_record->is_server ? 1 : 0);
-      printf("    timestamp: %.9f\n", nstime_to_sec(&follow_record->abs_ts));
-      printf("    data: !!binary |\n");
-      ii = 0;
-      while (ii < follow_record->data->len) {
-          guint32 len = ii + base64_raw_len < follow_record->data->len
-                ? base64_raw_len
-                : follow_record->data->len - ii;
-          b64encoded = g_base64_encode(&follow_record->data->data[ii], len);
-          printf("      %s\n", b64encoded);
-          g_free(b64encoded);
-          ii += len;
-      }
-      break;
-
-    default:
-      ws_assert_not_reached();
+      follow_print_record(stdout, cli_follow_info, (follow_record_t *)cur->data);
     }
   }
 
@@ -547,6 +587,7 @@ static void follow_stream(const char *opt_argp, void *userdata)
   follow_address_filter_func address_filter;
   int proto_id = get_follow_proto_id(follower);
   const char* proto_filter_name = proto_get_protocol_filter_name(proto_id);
+  int fd;
 
   opt_argp += strlen(STR_FOLLOW);
   opt_argp += strlen(proto_filter_name);
@@ -589,6 +630,23 @@ static void follow_stream(const char *opt_argp, void *userdata)
     }
   }
 
+  /* Print the records to a temporary file as they come in, rather than
+   * keeping the whole stream in memory. If we can't, keep them. */
+  fd = create_tempfile(NULL, &cli_follow_info->out_filename, "wireshark_follow", NULL, NULL);
+  if (fd != -1)
+  {
+    cli_follow_info->out_fp = ws_fdopen(fd, "w+b");
+    if (cli_follow_info->out_fp != NULL)
+    {
+      follow_info->record_func = follow_write_record;
+    }
+    else
+    {
+      ws_close(fd);
+      ws_unlink(cli_follow_info->out_filename);
+    }
+  }
+
   errp = register_tap_listener(get_follow_tap_string(follower), follow_info, follow_info->filter_out_filter, 0,
                                NULL, get_follow_tap_handler(follower), follow_draw, (tap_finish_cb)follow_free);
 
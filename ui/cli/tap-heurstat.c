@@ -0,0 +1,178 @@
+/* tap-heurstat.c
+ * Count how often each heuristic dissector is tried and how often it
+ * accepts a packet.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_heurstat(void);
+
+#define TAP_NAME "heur,stat"
+
+static void
+heurstat_reset_entry(const gchar *table_name _U_, heur_dtbl_entry_t *entry, gpointer user_data _U_)
+{
+	entry->tries = 0;
+	entry->accepts = 0;
+}
+
+static void
+heurstat_reset_table(const char *table_name, struct heur_dissector_list *table _U_, gpointer user_data _U_)
+{
+	heur_dissector_table_foreach(table_name, heurstat_reset_entry, NULL);
+}
+
+static void
+heurstat_reset(void *tapdata _U_)
+{
+	dissector_all_heur_tables_foreach_table(heurstat_reset_table, NULL, NULL);
+}
+
+static void
+heurstat_collect_entry(const gchar *table_name _U_, heur_dtbl_entry_t *entry, gpointer user_data)
+{
+	if (entry->tries > 0)
+		g_ptr_array_add((GPtrArray *)user_data, entry);
+}
+
+static gint
+heurstat_compare_entries(gconstpointer a, gconstpointer b)
+{
+	const heur_dtbl_entry_t *entry_a = *(const heur_dtbl_entry_t * const *)a;
+	const heur_dtbl_entry_t *entry_b = *(const heur_dtbl_entry_t * const *)b;
+
+	/* Most tried first */
+	if (entry_a->tries != entry_b->tries)
+		return entry_a->tries < entry_b->tries ? 1 : -1;
+	return strcmp(entry_a->short_name, entry_b->short_name);
+}
+
+static void
+heurstat_draw_table(const char *table_name)
+{
+	GPtrArray *entries = g_ptr_array_new();
+	guint64 tries = 0, accepts = 0;
+
+	heur_dissector_table_foreach(table_name, heurstat_collect_entry, entries);
+	if (entries->len == 0) {
+		g_ptr_array_free(entries, TRUE);
+		return;
+	}
+	g_ptr_array_sort(entries, heurstat_compare_entries);
+
+	for (guint i = 0; i < entries->len; i++) {
+		const heur_dtbl_entry_t *entry = (const heur_dtbl_entry_t *)g_ptr_array_index(entries, i);
+
+		tries += entry->tries;
+		accepts += entry->accepts;
+	}
+
+	printf("%-32s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
+	    table_name, tries, accepts, tries - accepts);
+	for (guint i = 0; i < entries->len; i++) {
+		const heur_dtbl_entry_t *entry = (const heur_dtbl_entry_t *)g_ptr_array_index(entries, i);
+
+		printf("  %-30s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
+		    entry->short_name, entry->tries, entry->accepts,
+		    entry->tries - entry->accepts);
+	}
+	g_ptr_array_free(entries, TRUE);
+}
+
+static void
+heurstat_collect_table(const char *table_name, struct heur_dissector_list *table _U_, gpointer user_data)
+{
+	g_ptr_array_add((GPtrArray *)user_data, (gpointer)table_name);
+}
+
+static gint
+heurstat_compare_names(gconstpointer a, gconstpointer b)
+{
+	return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+static void
+heurstat_draw(void *tapdata _U_)
+{
+	GPtrArray *tables = g_ptr_array_new();
+
+	dissector_all_heur_tables_foreach_table(heurstat_collect_table, tables, NULL);
+	g_ptr_array_sort(tables, heurstat_compare_names);
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Heuristic Dissector Statistics\n");
+	printf("%-32s %12s %12s %12s\n", "List / Heuristic", "Tried", "Accepted", "Rejected");
+	printf("-------------------------------------------------------------------\n");
+	for (guint i = 0; i < tables->len; i++) {
+		heurstat_draw_table((const char *)g_ptr_array_index(tables, i));
+	}
+	printf("===================================================================\n");
+	g_ptr_array_free(tables, TRUE);
+}
+
+static void
+heurstat_init(const char *opt_arg, void *userdata _U_)
+{
+	GString *error_string;
+
+	if (strcmp(TAP_NAME, opt_arg) != 0) {
+		cmdarg_err("invalid \"-z " TAP_NAME "\" argument");
+		exit(1);
+	}
+
+	error_string = register_tap_listener("frame", NULL, NULL, 0,
+					   heurstat_reset, NULL, heurstat_draw, NULL);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		cmdarg_err("Couldn't register " TAP_NAME " tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui heurstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	TAP_NAME,
+	heurstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_heurstat(void)
+{
+	register_stat_tap_ui(&heurstat_ui, NULL);
+}
+
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
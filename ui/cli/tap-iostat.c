@@ -49,50 +49,276 @@ static calc_type_ent_t calc_type_table[] = {
     { NULL, 0 }
 };
 
+/* How the values of a field are accumulated */
+typedef enum {
+    VALUE_KIND_UNSIGNED,  /* Unsigned integers and relative times (ns) */
+    VALUE_KIND_SIGNED,
+    VALUE_KIND_DOUBLE     /* Floats and doubles */
+} value_kind_t;
+
+typedef union {
+    guint64 u;
+    gint64 s;
+    gdouble d;
+} io_stat_value_t;
+
+/*
+ * The values of a field in the current frame. They're extracted once per
+ * frame and shared by all columns that calculate something from the field.
+ */
+typedef struct _io_stat_field_t {
+    int hf_index;
+    enum ftenum ftype;
+    value_kind_t kind;
+    guint32 framenum;     /* The frame the values are from, 0 if none */
+    GArray *values;       /* io_stat_value_t */
+} io_stat_field_t;
+
 typedef struct _io_stat_t {
     guint64 interval;     /* The user-specified time interval (us) */
     guint invl_prec;      /* Decimal precision of the time interval (1=10s, 2=100s etc) */
+    gboolean csv;         /* Print comma-separated values instead of a table */
     unsigned int num_cols;         /* The number of columns of stats in the table */
-    struct _io_stat_item_t *items;  /* Each item is a single cell in the table */
+    struct _io_stat_item_t *items;  /* Each item is a column in the table */
+    GPtrArray *fields;    /* io_stat_field_t, one per field used by any column */
     time_t start_time;    /* Time of first frame matching the filter */
     const char **filters; /* 'io,stat' cmd strings (e.g., "AVG(smb.time)smb.time") */
     guint64 *max_vals;    /* The max value sans the decimal or nsecs portion in each stat column */
     guint32 *max_frame;   /* The max frame number displayed in each stat column */
 } io_stat_t;
 
+/*
+ * The statistic of a column over one interval. Only intervals in which the
+ * column has seen frames have one, so that small intervals over a long
+ * capture don't need memory for all the empty ones.
+ */
+typedef struct {
+    guint64 interval;     /* Index of the interval, counted from the start of capture */
+    guint32 frames;
+    guint32 num;          /* The number of field values seen */
+    guint64 counter;      /* Bytes, COUNT, or the LOAD of response times ending in this interval (us) */
+    io_stat_value_t value; /* The SUM, MIN, MAX or AVG sum of the field values */
+    guint32 load_ends;    /* The number of responses ending here that span earlier intervals */
+} io_stat_cell_t;
+
 typedef struct _io_stat_item_t {
     io_stat_t *parent;
-    struct _io_stat_item_t *next;
-    struct _io_stat_item_t *prev;
-    guint64 start_time;   /* Time since start of capture (us)*/
     int calc_type;        /* The statistic type */
     int colnum;           /* Column number of this stat (0 to n) */
     int hf_index;
-    guint32 frames;
-    guint32 num;          /* The sample size of a given statistic (only needed for AVG) */
-    guint64 counter;      /* The accumulated data for the calculation of that statistic */
-    gfloat float_counter;
-    gdouble double_counter;
+    io_stat_field_t *field; /* The field values for SUM, MIN, MAX, AVG and LOAD */
+    GArray *cells;        /* io_stat_cell_t in increasing order of interval */
+    GArray *load_starts;  /* For LOAD, the first interval each spanning response covers in full */
 } io_stat_item_t;
 
 #define NANOSECS_PER_SEC G_GUINT64_CONSTANT(1000000000)
 
 static guint64 last_relative_time;
 
+static io_stat_field_t *
+iostat_get_field(io_stat_t *io, header_field_info *hfi)
+{
+    io_stat_field_t *field;
+    guint i;
+
+    for (i = 0; i < io->fields->len; i++) {
+        field = (io_stat_field_t *)g_ptr_array_index(io->fields, i);
+        if (field->hf_index == hfi->id)
+            return field;
+    }
+
+    field = g_new(io_stat_field_t, 1);
+    field->hf_index = hfi->id;
+    field->ftype = hfi->type;
+    switch (hfi->type) {
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        field->kind = VALUE_KIND_SIGNED;
+        break;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        field->kind = VALUE_KIND_DOUBLE;
+        break;
+    default:
+        field->kind = VALUE_KIND_UNSIGNED;
+        break;
+    }
+    field->framenum = 0;
+    field->values = g_array_new(FALSE, FALSE, sizeof(io_stat_value_t));
+    g_ptr_array_add(io->fields, field);
+    return field;
+}
+
+static void
+iostat_free_field(gpointer data)
+{
+    io_stat_field_t *field = (io_stat_field_t *)data;
+
+    g_array_free(field->values, TRUE);
+    g_free(field);
+}
+
+/* Get the values of a field in this frame, reading them from the tree unless
+ * another column already has. */
+static GArray *
+iostat_field_values(io_stat_field_t *field, packet_info *pinfo, epan_dissect_t *edt)
+{
+    GPtrArray *gp;
+    fvalue_t *fv;
+    const nstime_t *new_time;
+    io_stat_value_t val;
+    guint i;
+
+    if (field->framenum == pinfo->num)
+        return field->values;
+
+    field->framenum = pinfo->num;
+    g_array_set_size(field->values, 0);
+    gp = proto_get_finfo_ptr_array(edt->tree, field->hf_index);
+    if (!gp)
+        return field->values;
+
+    for (i=0; i<gp->len; i++) {
+        fv = ((field_info *)gp->pdata[i])->value;
+        switch (field->ftype) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+            val.u = fvalue_get_uinteger(fv);
+            break;
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+            val.u = fvalue_get_uinteger64(fv);
+            break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+            val.s = fvalue_get_sinteger(fv);
+            break;
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            val.s = fvalue_get_sinteger64(fv);
+            break;
+        case FT_FLOAT:
+        case FT_DOUBLE:
+            val.d = fvalue_get_floating(fv);
+            break;
+        case FT_RELATIVE_TIME:
+            new_time = fvalue_get_time(fv);
+            val.u = ((guint64)new_time->secs * NANOSECS_PER_SEC) + (guint64)new_time->nsecs;
+            break;
+        default:
+            /*
+             * "Can't happen"; see the checks
+             * in register_io_tap().
+             */
+            ws_assert_not_reached();
+            break;
+        }
+        g_array_append_val(field->values, val);
+    }
+    return field->values;
+}
+
+/* Get the cell of the interval a frame falls in. Frames that are earlier
+ * than the last frame seen by the column are counted in its last interval. */
+static io_stat_cell_t *
+iostat_get_cell(io_stat_item_t *item, guint64 interval)
+{
+    io_stat_cell_t *cell;
+
+    if (item->cells->len > 0) {
+        cell = &g_array_index(item->cells, io_stat_cell_t, item->cells->len - 1);
+        if (interval <= cell->interval)
+            return cell;
+    }
+    g_array_set_size(item->cells, item->cells->len + 1);
+    cell = &g_array_index(item->cells, io_stat_cell_t, item->cells->len - 1);
+    cell->interval = interval;
+    return cell;
+}
+
+static void
+iostat_add_value(io_stat_cell_t *cell, int calc_type, value_kind_t kind, const io_stat_value_t *val)
+{
+    gboolean first = (cell->num == 0);
+
+    cell->num++;
+    switch (calc_type) {
+    case CALC_TYPE_SUM:
+    case CALC_TYPE_AVG:
+        switch (kind) {
+        case VALUE_KIND_UNSIGNED:
+            cell->value.u += val->u;
+            break;
+        case VALUE_KIND_SIGNED:
+            cell->value.s += val->s;
+            break;
+        case VALUE_KIND_DOUBLE:
+            cell->value.d += val->d;
+            break;
+        }
+        break;
+    case CALC_TYPE_MIN:
+        switch (kind) {
+        case VALUE_KIND_UNSIGNED:
+            if (first || val->u < cell->value.u)
+                cell->value.u = val->u;
+            break;
+        case VALUE_KIND_SIGNED:
+            if (first || val->s < cell->value.s)
+                cell->value.s = val->s;
+            break;
+        case VALUE_KIND_DOUBLE:
+            if (first || val->d < cell->value.d)
+                cell->value.d = val->d;
+            break;
+        }
+        break;
+    case CALC_TYPE_MAX:
+        switch (kind) {
+        case VALUE_KIND_UNSIGNED:
+            if (first || val->u > cell->value.u)
+                cell->value.u = val->u;
+            break;
+        case VALUE_KIND_SIGNED:
+            if (first || val->s > cell->value.s)
+                cell->value.s = val->s;
+            break;
+        case VALUE_KIND_DOUBLE:
+            if (first || val->d > cell->value.d)
+                cell->value.d = val->d;
+            break;
+        }
+        break;
+    }
+}
+
 static tap_packet_status
 iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
 {
     io_stat_t *parent;
-    io_stat_item_t *mit;
-    io_stat_item_t *it;
-    guint64 relative_time, rt;
-    const nstime_t *new_time;
+    io_stat_item_t *item;
+    io_stat_cell_t *cell;
+    guint64 relative_time, interval, val, tival, spanned;
     GPtrArray *gp;
+    GArray *values;
     guint i;
-    int ftype;
 
-    mit = (io_stat_item_t *) arg;
-    parent = mit->parent;
+    item = (io_stat_item_t *) arg;
+    parent = item->parent;
 
     /* If this frame's relative time is negative, set its relative time to last_relative_time
        rather than disincluding it from the calculations. */
@@ -104,410 +330,172 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         relative_time = last_relative_time;
     }
 
-    if (mit->parent->start_time == 0) {
-        mit->parent->start_time = pinfo->abs_ts.secs - pinfo->rel_ts.secs;
+    if (parent->start_time == 0) {
+        parent->start_time = pinfo->abs_ts.secs - pinfo->rel_ts.secs;
     }
 
-    /* The prev item is always the last interval in which we saw packets. */
-    it = mit->prev;
-
-    /* If we have moved into a new interval (row), create a new io_stat_item_t struct for every interval
-    *  between the last struct and this one. If an item was not found in a previous interval, an empty
-    *  struct will be created for it. */
-    rt = relative_time;
-    while (rt >= it->start_time + parent->interval) {
-        it->next = g_new(io_stat_item_t, 1);
-        it->next->prev = it;
-        it->next->next = NULL;
-        it = it->next;
-        mit->prev = it;
-
-        it->start_time = it->prev->start_time + parent->interval;
-        it->frames = 0;
-        it->counter = 0;
-        it->float_counter = 0;
-        it->double_counter = 0;
-        it->num = 0;
-        it->calc_type = it->prev->calc_type;
-        it->hf_index = it->prev->hf_index;
-        it->colnum = it->prev->colnum;
-    }
+    cell = iostat_get_cell(item, relative_time / parent->interval);
+    interval = cell->interval;
 
-    /* Store info in the current structure */
-    it->frames++;
+    /* Store info in the current interval */
+    cell->frames++;
 
-    switch (it->calc_type) {
+    switch (item->calc_type) {
     case CALC_TYPE_FRAMES:
     case CALC_TYPE_BYTES:
     case CALC_TYPE_FRAMES_AND_BYTES:
-        it->counter += pinfo->fd->pkt_len;
+        cell->counter += pinfo->fd->pkt_len;
         break;
     case CALC_TYPE_COUNT:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, item->hf_index);
         if (gp) {
-            it->counter += gp->len;
+            cell->counter += gp->len;
         }
         break;
     case CALC_TYPE_SUM:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
-        if (gp) {
-            guint64 val;
-
-            for (i=0; i<gp->len; i++) {
-                switch (proto_registrar_get_ftype(it->hf_index)) {
-                case FT_UINT8:
-                case FT_UINT16:
-                case FT_UINT24:
-                case FT_UINT32:
-                    it->counter += fvalue_get_uinteger(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_UINT40:
-                case FT_UINT48:
-                case FT_UINT56:
-                case FT_UINT64:
-                    it->counter += fvalue_get_uinteger64(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_INT8:
-                case FT_INT16:
-                case FT_INT24:
-                case FT_INT32:
-                    it->counter += fvalue_get_sinteger(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_INT40:
-                case FT_INT48:
-                case FT_INT56:
-                case FT_INT64:
-                    it->counter += (gint64)fvalue_get_sinteger64(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_FLOAT:
-                    it->float_counter +=
-                        (gfloat)fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_DOUBLE:
-                    it->double_counter += fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_RELATIVE_TIME:
-                    new_time = fvalue_get_time(((field_info *)gp->pdata[i])->value);
-                    val = ((guint64)new_time->secs * NANOSECS_PER_SEC) + (guint64)new_time->nsecs;
-                    it->counter  +=  val;
-                    break;
-                default:
-                    /*
-                     * "Can't happen"; see the checks
-                     * in register_io_tap().
-                     */
-                    ws_assert_not_reached();
-                    break;
-                }
-            }
-        }
-        break;
     case CALC_TYPE_MIN:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
-        if (gp) {
-            guint64 val;
-            gfloat float_val;
-            gdouble double_val;
-
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            for (i=0; i<gp->len; i++) {
-                switch (ftype) {
-                case FT_UINT8:
-                case FT_UINT16:
-                case FT_UINT24:
-                case FT_UINT32:
-                    val = fvalue_get_uinteger(((field_info *)gp->pdata[i])->value);
-                    if ((it->frames == 1 && i == 0) || (val < it->counter)) {
-                        it->counter = val;
-                    }
-                    break;
-                case FT_UINT40:
-                case FT_UINT48:
-                case FT_UINT56:
-                case FT_UINT64:
-                    val = fvalue_get_uinteger64(((field_info *)gp->pdata[i])->value);
-                    if ((it->frames == 1 && i == 0) || (val < it->counter)) {
-                        it->counter = val;
-                    }
-                    break;
-                case FT_INT8:
-                case FT_INT16:
-                case FT_INT24:
-                case FT_INT32:
-                    val = fvalue_get_sinteger(((field_info *)gp->pdata[i])->value);
-                    if ((it->frames == 1 && i == 0) || ((gint32)val < (gint32)it->counter)) {
-                        it->counter = val;
-                    }
-                    break;
-                case FT_INT40:
-                case FT_INT48:
-                case FT_INT56:
-                case FT_INT64:
-                    val = fvalue_get_sinteger64(((field_info *)gp->pdata[i])->value);
-                    if ((it->frames == 1 && i == 0) || ((gint64)val < (gint64)it->counter)) {
-                        it->counter = val;
-                    }
-                    break;
-                case FT_FLOAT:
-                    float_val = (gfloat)fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    if ((it->frames == 1 && i == 0) || (float_val < it->float_counter)) {
-                        it->float_counter = float_val;
-                    }
-                    break;
-                case FT_DOUBLE:
-                    double_val = fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    if ((it->frames == 1 && i == 0) || (double_val < it->double_counter)) {
-                        it->double_counter = double_val;
-                    }
-                    break;
-                case FT_RELATIVE_TIME:
-                    new_time = fvalue_get_time(((field_info *)gp->pdata[i])->value);
-                    val = ((guint64)new_time->secs * NANOSECS_PER_SEC) + (guint64)new_time->nsecs;
-                    if ((it->frames == 1 && i == 0) || (val < it->counter)) {
-                        it->counter = val;
-                    }
-                    break;
-                default:
-                    /*
-                     * "Can't happen"; see the checks
-                     * in register_io_tap().
-                     */
-                    ws_assert_not_reached();
-                    break;
-                }
-            }
-        }
-        break;
     case CALC_TYPE_MAX:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
-        if (gp) {
-            guint64 val;
-            gfloat float_val;
-            gdouble double_val;
-
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            for (i=0; i<gp->len; i++) {
-                switch (ftype) {
-                case FT_UINT8:
-                case FT_UINT16:
-                case FT_UINT24:
-                case FT_UINT32:
-                    val = fvalue_get_uinteger(((field_info *)gp->pdata[i])->value);
-                    if (val > it->counter)
-                        it->counter = val;
-                    break;
-                case FT_UINT40:
-                case FT_UINT48:
-                case FT_UINT56:
-                case FT_UINT64:
-                    val = fvalue_get_uinteger64(((field_info *)gp->pdata[i])->value);
-                    if (val > it->counter)
-                        it->counter = val;
-                    break;
-                case FT_INT8:
-                case FT_INT16:
-                case FT_INT24:
-                case FT_INT32:
-                    val = fvalue_get_sinteger(((field_info *)gp->pdata[i])->value);
-                    if ((gint32)val > (gint32)it->counter)
-                        it->counter = val;
-                    break;
-                case FT_INT40:
-                case FT_INT48:
-                case FT_INT56:
-                case FT_INT64:
-                    val = fvalue_get_sinteger64(((field_info *)gp->pdata[i])->value);
-                    if ((gint64)val > (gint64)it->counter)
-                        it->counter = val;
-                    break;
-                case FT_FLOAT:
-                    float_val = (gfloat)fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    if (float_val > it->float_counter)
-                        it->float_counter = float_val;
-                    break;
-                case FT_DOUBLE:
-                    double_val = fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    if (double_val > it->double_counter)
-                        it->double_counter = double_val;
-                    break;
-                case FT_RELATIVE_TIME:
-                    new_time = fvalue_get_time(((field_info *)gp->pdata[i])->value);
-                    val = ((guint64)new_time->secs * NANOSECS_PER_SEC) + (guint64)new_time->nsecs;
-                    if (val > it->counter)
-                        it->counter = val;
-                    break;
-                default:
-                    /*
-                     * "Can't happen"; see the checks
-                     * in register_io_tap().
-                     */
-                    ws_assert_not_reached();
-                    break;
-                }
-            }
-        }
-        break;
     case CALC_TYPE_AVG:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
-        if (gp) {
-            guint64 val;
-
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            for (i=0; i<gp->len; i++) {
-                it->num++;
-                switch (ftype) {
-                case FT_UINT8:
-                case FT_UINT16:
-                case FT_UINT24:
-                case FT_UINT32:
-                    val = fvalue_get_uinteger(((field_info *)gp->pdata[i])->value);
-                    it->counter += val;
-                    break;
-                case FT_UINT40:
-                case FT_UINT48:
-                case FT_UINT56:
-                case FT_UINT64:
-                    val = fvalue_get_uinteger64(((field_info *)gp->pdata[i])->value);
-                    it->counter += val;
-                    break;
-                case FT_INT8:
-                case FT_INT16:
-                case FT_INT24:
-                case FT_INT32:
-                    val = fvalue_get_sinteger(((field_info *)gp->pdata[i])->value);
-                    it->counter += val;
-                    break;
-                case FT_INT40:
-                case FT_INT48:
-                case FT_INT56:
-                case FT_INT64:
-                    val = fvalue_get_sinteger64(((field_info *)gp->pdata[i])->value);
-                    it->counter += val;
-                    break;
-                case FT_FLOAT:
-                    it->float_counter += (gfloat)fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_DOUBLE:
-                    it->double_counter += fvalue_get_floating(((field_info *)gp->pdata[i])->value);
-                    break;
-                case FT_RELATIVE_TIME:
-                    new_time = fvalue_get_time(((field_info *)gp->pdata[i])->value);
-                    val = ((guint64)new_time->secs * NANOSECS_PER_SEC) + (guint64)new_time->nsecs;
-                    it->counter += val;
-                    break;
-                default:
-                    /*
-                     * "Can't happen"; see the checks
-                     * in register_io_tap().
-                     */
-                    ws_assert_not_reached();
-                    break;
-                }
-            }
+        values = iostat_field_values(item->field, pinfo, edt);
+        for (i=0; i<values->len; i++) {
+            iostat_add_value(cell, item->calc_type, item->field->kind,
+                             &g_array_index(values, io_stat_value_t, i));
         }
         break;
     case CALC_TYPE_LOAD:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
-        if (gp) {
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            if (ftype != FT_RELATIVE_TIME) {
-                fprintf(stderr,
-                    "\ntshark: LOAD() is only supported for relative-time fields such as smb.time\n");
-                exit(10);
-            }
-            for (i=0; i<gp->len; i++) {
-                guint64 val;
-                int tival;
-                io_stat_item_t *pit;
-
-                new_time = fvalue_get_time(((field_info *)gp->pdata[i])->value);
-                val = ((guint64)new_time->secs*G_GUINT64_CONSTANT(1000000)) + (guint64)(new_time->nsecs/1000);
-                tival = (int)(val % parent->interval);
-                it->counter += tival;
-                val -= tival;
-                pit = it->prev;
-                while (val > 0) {
-                    if (val < (guint64)parent->interval) {
-                        pit->counter += val;
-                        break;
-                    }
-                    pit->counter += parent->interval;
-                    val -= parent->interval;
-                    pit = pit->prev;
-                }
+        /* A response time contributes its part in this interval here, and
+         * a whole interval to each of the earlier ones it spans. Those are
+         * recorded as a span of intervals and added up when drawing. */
+        values = iostat_field_values(item->field, pinfo, edt);
+        for (i=0; i<values->len; i++) {
+            val = g_array_index(values, io_stat_value_t, i).u / 1000;
+            tival = val % parent->interval;
+            cell->counter += tival;
+            spanned = (val - tival) / parent->interval;
+            if (spanned > 0) {
+                val = spanned < interval ? interval - spanned : 0;
+                g_array_append_val(item->load_starts, val);
+                cell->load_ends++;
             }
         }
         break;
     }
-    /* Store the highest value for this item in order to determine the width of each stat column.
-    *  For real numbers we only need to know its magnitude (the value to the left of the decimal point
-    *  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
-    *  calc the average, round it to the next second and store the seconds. For all other calc types
-    *  of RELATIVE_TIME fields, store the counters without modification.
-    *  fields. */
-    switch (it->calc_type) {
+    return TAP_PACKET_REDRAW;
+}
+
+/*
+ * Walks the intervals of a column in increasing order, filling in the
+ * intervals without frames and the LOAD of intervals spanned by responses.
+ */
+typedef struct {
+    guint next_cell;
+    guint next_start;
+    guint64 active;       /* The number of responses spanning the current interval */
+} column_cursor;
+
+/* Get the statistic of a column for an interval; intervals must be asked for
+ * in increasing order. */
+static void
+column_cursor_get(const io_stat_item_t *item, column_cursor *cur, guint64 interval, io_stat_cell_t *cell)
+{
+    const io_stat_cell_t *c;
+
+    while (cur->next_start < item->load_starts->len &&
+           g_array_index(item->load_starts, guint64, cur->next_start) <= interval) {
+        cur->active++;
+        cur->next_start++;
+    }
+
+    memset(cell, 0, sizeof(*cell));
+    cell->interval = interval;
+    while (cur->next_cell < item->cells->len) {
+        c = &g_array_index(item->cells, io_stat_cell_t, cur->next_cell);
+        if (c->interval > interval)
+            break;
+        cur->active -= c->load_ends;
+        cur->next_cell++;
+        if (c->interval == interval)
+            *cell = *c;
+    }
+
+    if (cur->active > 0)
+        cell->counter += cur->active * item->parent->interval;
+}
+
+/* Get the first interval from "interval" on that may have a statistic,
+ * or G_MAXUINT64 if there are no more. */
+static guint64
+column_cursor_next(const io_stat_item_t *item, const column_cursor *cur, guint64 interval)
+{
+    guint64 next = G_MAXUINT64;
+
+    if (cur->active > 0)
+        return interval;
+    if (cur->next_cell < item->cells->len)
+        next = g_array_index(item->cells, io_stat_cell_t, cur->next_cell).interval;
+    if (cur->next_start < item->load_starts->len)
+        next = MIN(next, g_array_index(item->load_starts, guint64, cur->next_start));
+    return MAX(next, interval);
+}
+
+static gint
+compare_guint64(gconstpointer a, gconstpointer b)
+{
+    guint64 ua = *(const guint64 *)a;
+    guint64 ub = *(const guint64 *)b;
+
+    return ua < ub ? -1 : (ua > ub ? 1 : 0);
+}
+
+/* Store the highest value of a column in order to determine its width.
+*  For real numbers we only need to know its magnitude (the value to the left of the decimal point
+*  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
+*  calc the average, round it to the next second and store the seconds. For all other calc types
+*  of RELATIVE_TIME fields, store the counters without modification.
+*  fields. */
+static void
+iostat_update_max(io_stat_t *iot, const io_stat_item_t *item, const io_stat_cell_t *cell)
+{
+    guint64 val;
+
+    switch (item->calc_type) {
         case CALC_TYPE_FRAMES:
         case CALC_TYPE_FRAMES_AND_BYTES:
-            parent->max_frame[it->colnum] =
-                MAX(parent->max_frame[it->colnum], it->frames);
-            if (it->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
-                parent->max_vals[it->colnum] =
-                    MAX(parent->max_vals[it->colnum], it->counter);
-            break;
+            iot->max_frame[item->colnum] =
+                MAX(iot->max_frame[item->colnum], cell->frames);
+            if (item->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
+                iot->max_vals[item->colnum] =
+                    MAX(iot->max_vals[item->colnum], cell->counter);
+            return;
         case CALC_TYPE_BYTES:
         case CALC_TYPE_COUNT:
         case CALC_TYPE_LOAD:
-            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
+            iot->max_vals[item->colnum] = MAX(iot->max_vals[item->colnum], cell->counter);
+            return;
+    }
+
+    if (cell->num == 0)
+        return;
+
+    switch (item->field->kind) {
+        case VALUE_KIND_DOUBLE:
+            if (item->calc_type == CALC_TYPE_AVG)
+                val = (guint64)(cell->value.d/cell->num);
+            else
+                val = (guint64)(cell->value.d+0.5);
             break;
-        case CALC_TYPE_SUM:
-        case CALC_TYPE_MIN:
-        case CALC_TYPE_MAX:
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->float_counter+0.5));
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->double_counter+0.5));
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
+        default:
+            /* UINT8-64, INT8-64 and RELATIVE_TIME */
+            val = cell->value.u;
+            if (item->calc_type == CALC_TYPE_AVG) {
+                if (item->field->ftype == FT_RELATIVE_TIME)
+                    val = ((val/(guint64)cell->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC;
+                else
+                    val /= cell->num;
             }
             break;
-        case CALC_TYPE_AVG:
-            if (it->num == 0) /* avoid division by zero */
-               break;
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->float_counter/it->num);
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->double_counter/it->num);
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], ((it->counter/(guint64)it->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
-                    break;
-            }
     }
-    return TAP_PACKET_REDRAW;
+    iot->max_vals[item->colnum] = MAX(iot->max_vals[item->colnum], val);
 }
 
 static unsigned int
@@ -550,6 +538,124 @@ typedef struct {
     int val; /* Width of this non-FRAMES column sans padding and border chars */
 } column_width;
 
+/* Print a relative time in us as seconds */
+static void
+print_csv_time(guint64 us)
+{
+    printf("%" PRIu64 ".%06u", us / G_GUINT64_CONSTANT(1000000), (unsigned)(us % G_GUINT64_CONSTANT(1000000)));
+}
+
+static void
+print_csv_cell(const io_stat_item_t *item, const io_stat_cell_t *cell, guint64 invl_len)
+{
+    guint64 val;
+
+    switch (item->calc_type) {
+    case CALC_TYPE_FRAMES:
+        printf(",%u", cell->frames);
+        return;
+    case CALC_TYPE_BYTES:
+    case CALC_TYPE_COUNT:
+        printf(",%" PRIu64, cell->counter);
+        return;
+    case CALC_TYPE_FRAMES_AND_BYTES:
+        printf(",%u,%" PRIu64, cell->frames, cell->counter);
+        return;
+    case CALC_TYPE_LOAD:
+        printf(",%u.%06u", (unsigned)(cell->counter/invl_len),
+               (unsigned)((cell->counter%invl_len)*G_GUINT64_CONSTANT(1000000) / invl_len));
+        return;
+    }
+
+    /* Leave MIN, MAX and AVG empty for intervals without values */
+    printf(",");
+    if (cell->num == 0 && item->calc_type != CALC_TYPE_SUM)
+        return;
+
+    switch (item->field->kind) {
+    case VALUE_KIND_DOUBLE:
+        printf("%f", item->calc_type == CALC_TYPE_AVG ? cell->value.d/cell->num : cell->value.d);
+        break;
+    case VALUE_KIND_SIGNED:
+        printf("%" PRId64, item->calc_type == CALC_TYPE_AVG ? cell->value.s/(gint64)cell->num : cell->value.s);
+        break;
+    case VALUE_KIND_UNSIGNED:
+        val = item->calc_type == CALC_TYPE_AVG ? cell->value.u/cell->num : cell->value.u;
+        if (item->field->ftype == FT_RELATIVE_TIME)
+            print_csv_time((val + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000));
+        else
+            printf("%" PRIu64, val);
+        break;
+    }
+}
+
+/* Print a header line and one line for each interval in which any column
+ * has something to report, with times relative to the start of capture. */
+static void
+iostat_draw_csv(io_stat_t *iot, guint64 duration)
+{
+    column_cursor *cursors;
+    io_stat_cell_t cell;
+    io_stat_item_t *item;
+    guint64 invl, next, start, end;
+    unsigned int j;
+
+    printf("Interval start,Interval end");
+    for (j=0; j<iot->num_cols; j++) {
+        item = &iot->items[j];
+        if (item->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
+            printf(",%u Frames,%u Bytes", j+1, j+1);
+        else
+            printf(",%u %s", j+1, calc_type_table[item->calc_type].func_name);
+    }
+    printf("\n");
+
+    cursors = g_new0(column_cursor, iot->num_cols);
+    invl = 0;
+    for (;;) {
+        next = G_MAXUINT64;
+        for (j=0; j<iot->num_cols; j++)
+            next = MIN(next, column_cursor_next(&iot->items[j], &cursors[j], invl));
+        if (next == G_MAXUINT64)
+            break;
+        invl = next;
+
+        if (iot->interval == G_MAXUINT64) {
+            start = 0;
+            end = duration;
+        } else {
+            start = invl * iot->interval;
+            end = MAX(start, MIN(start + iot->interval, duration));
+        }
+        print_csv_time(start);
+        printf(",");
+        print_csv_time(end);
+        for (j=0; j<iot->num_cols; j++) {
+            column_cursor_get(&iot->items[j], &cursors[j], invl, &cell);
+            print_csv_cell(&iot->items[j], &cell, end > start ? end - start : 1);
+        }
+        printf("\n");
+        invl++;
+    }
+    g_free(cursors);
+}
+
+static void
+iostat_free(io_stat_t *iot)
+{
+    unsigned int j;
+
+    for (j=0; j<iot->num_cols; j++) {
+        g_array_free(iot->items[j].cells, TRUE);
+        g_array_free(iot->items[j].load_starts, TRUE);
+    }
+    g_ptr_array_free(iot->fields, TRUE);
+    g_free(iot->items);
+    g_free(iot->max_vals);
+    g_free(iot->max_frame);
+    g_free(iot);
+}
+
 static void
 iostat_draw(void *arg)
 {
@@ -563,7 +669,10 @@ iostat_draw(void *arg)
     char *spaces, *spaces_s, *filler_s = NULL, **fmts, *fmt = NULL;
     const char *filter;
     static gchar dur_mag_s[3], invl_prec_s[3], fr_mag_s[3], val_mag_s[3], *invl_fmt, *full_fmt;
-    io_stat_item_t *mit, **stat_cols, *item, **item_in_column;
+    io_stat_item_t *mit, **stat_cols, *item;
+    column_cursor *cursors;
+    io_stat_cell_t cell;
+    guint64 invl;
     gboolean last_row = FALSE;
     io_stat_t *iot;
     column_width *col_w;
@@ -592,6 +701,26 @@ iostat_draw(void *arg)
         interval = iot->interval;
     }
 
+    if (iot->csv) {
+        iostat_draw_csv(iot, duration);
+        iostat_free(iot);
+        g_free(col_w);
+        g_free(fmts);
+        g_free(stat_cols);
+        return;
+    }
+
+    /* Find the highest value in each column */
+    for (j=0; j<num_cols; j++) {
+        column_cursor cur = { 0, 0, 0 };
+
+        item = stat_cols[j];
+        for (invl = column_cursor_next(item, &cur, 0); invl != G_MAXUINT64; invl = column_cursor_next(item, &cur, invl + 1)) {
+            column_cursor_get(item, &cur, invl, &cell);
+            iostat_update_max(iot, item, &cell);
+        }
+    }
+
     /* Calc the capture duration's magnitude (dur_mag) */
     dur_secs  = (unsigned int)(duration/G_GUINT64_CONSTANT(1000000));
     dur_secs_orig = dur_secs;
@@ -973,11 +1102,7 @@ iostat_draw(void *arg)
         num_rows = (unsigned int)(duration/interval) + ((unsigned int)(duration%interval) > 0 ? 1 : 0);
     }
 
-    /* Load item_in_column with the first item in each column */
-    item_in_column = (io_stat_item_t **)g_malloc(sizeof(io_stat_item_t *) * num_cols);
-    for (j=0; j<num_cols; j++) {
-        item_in_column[j] = stat_cols[j];
-    }
+    cursors = g_new0(column_cursor, num_cols);
 
     /* Display the table values
     *
@@ -1110,93 +1235,80 @@ iostat_draw(void *arg)
         /* Display stat values in each column for this row */
         for (j=0; j<num_cols; j++) {
             fmt = fmts[j];
-            item = item_in_column[j];
+            item = stat_cols[j];
+            column_cursor_get(item, &cursors[j], i, &cell);
+
+            switch (item->calc_type) {
+            case CALC_TYPE_FRAMES:
+                printf(fmt, cell.frames);
+                break;
+            case CALC_TYPE_BYTES:
+            case CALC_TYPE_COUNT:
+                printf(fmt, cell.counter);
+                break;
+            case CALC_TYPE_FRAMES_AND_BYTES:
+                printf(fmt, cell.frames, cell.counter);
+                break;
 
-            if (item) {
-                switch (item->calc_type) {
-                case CALC_TYPE_FRAMES:
-                    printf(fmt, item->frames);
+            case CALC_TYPE_SUM:
+            case CALC_TYPE_MIN:
+            case CALC_TYPE_MAX:
+                switch (item->field->ftype) {
+                case FT_FLOAT:
+                case FT_DOUBLE:
+                    printf(fmt, cell.value.d);
                     break;
-                case CALC_TYPE_BYTES:
-                case CALC_TYPE_COUNT:
-                    printf(fmt, item->counter);
+                case FT_RELATIVE_TIME:
+                    cell.value.u = (cell.value.u + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
+                    printf(fmt,
+                           (int)(cell.value.u/G_GUINT64_CONSTANT(1000000)),
+                           (int)(cell.value.u%G_GUINT64_CONSTANT(1000000)));
                     break;
-                case CALC_TYPE_FRAMES_AND_BYTES:
-                    printf(fmt, item->frames, item->counter);
+                default:
+                    printf(fmt, cell.value.u);
                     break;
+                }
+                break;
 
-                case CALC_TYPE_SUM:
-                case CALC_TYPE_MIN:
-                case CALC_TYPE_MAX:
-                    ftype = proto_registrar_get_ftype(stat_cols[j]->hf_index);
-                    switch (ftype) {
-                    case FT_FLOAT:
-                        printf(fmt, item->float_counter);
-                        break;
-                    case FT_DOUBLE:
-                        printf(fmt, item->double_counter);
-                        break;
-                    case FT_RELATIVE_TIME:
-                        item->counter = (item->counter + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
-                        printf(fmt,
-                               (int)(item->counter/G_GUINT64_CONSTANT(1000000)),
-                               (int)(item->counter%G_GUINT64_CONSTANT(1000000)));
-                        break;
-                    default:
-                        printf(fmt, item->counter);
-                        break;
-                    }
+            case CALC_TYPE_AVG:
+                num = cell.num;
+                if (num == 0)
+                    num = 1;
+                switch (item->field->ftype) {
+                case FT_FLOAT:
+                case FT_DOUBLE:
+                    printf(fmt, cell.value.d/num);
                     break;
-
-                case CALC_TYPE_AVG:
-                    num = item->num;
-                    if (num == 0)
-                        num = 1;
-                    ftype = proto_registrar_get_ftype(stat_cols[j]->hf_index);
-                    switch (ftype) {
-                    case FT_FLOAT:
-                        printf(fmt, item->float_counter/num);
-                        break;
-                    case FT_DOUBLE:
-                        printf(fmt, item->double_counter/num);
-                        break;
-                    case FT_RELATIVE_TIME:
-                        item->counter = ((item->counter / (guint64)num) + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
-                        printf(fmt,
-                               (int)(item->counter/G_GUINT64_CONSTANT(1000000)),
-                               (int)(item->counter%G_GUINT64_CONSTANT(1000000)));
-                        break;
-                    default:
-                        printf(fmt, item->counter / (guint64)num);
-                        break;
-                    }
+                case FT_RELATIVE_TIME:
+                    cell.value.u = ((cell.value.u / (guint64)num) + G_GUINT64_CONSTANT(500)) / G_GUINT64_CONSTANT(1000);
+                    printf(fmt,
+                           (int)(cell.value.u/G_GUINT64_CONSTANT(1000000)),
+                           (int)(cell.value.u%G_GUINT64_CONSTANT(1000000)));
                     break;
-
-                case CALC_TYPE_LOAD:
-                    ftype = proto_registrar_get_ftype(stat_cols[j]->hf_index);
-                    switch (ftype) {
-                    case FT_RELATIVE_TIME:
-                        if (!last_row) {
-                            printf(fmt,
-                                (int) (item->counter/interval),
-                                   (int)((item->counter%interval)*G_GUINT64_CONSTANT(1000000) / interval));
-                        } else {
-                            printf(fmt,
-                                   (int) (item->counter/(invl_end-t)),
-                                   (int)((item->counter%(invl_end-t))*G_GUINT64_CONSTANT(1000000) / (invl_end-t)));
-                        }
-                        break;
-                    }
+                case FT_INT8:
+                case FT_INT16:
+                case FT_INT24:
+                case FT_INT32:
+                case FT_INT64:
+                    printf(fmt, cell.value.s / (gint64)num);
+                    break;
+                default:
+                    printf(fmt, cell.value.u / (guint64)num);
                     break;
                 }
+                break;
 
-                if (last_row) {
-                    g_free(fmt);
+            case CALC_TYPE_LOAD:
+                if (!last_row) {
+                    printf(fmt,
+                           (int) (cell.counter/interval),
+                           (int)((cell.counter%interval)*G_GUINT64_CONSTANT(1000000) / interval));
                 } else {
-                    item_in_column[j] = item_in_column[j]->next;
+                    printf(fmt,
+                           (int) (cell.counter/(invl_end-t)),
+                           (int)((cell.counter%(invl_end-t))*G_GUINT64_CONSTANT(1000000) / (invl_end-t)));
                 }
-            } else {
-                printf(fmt, (guint64)0, (guint64)0);
+                break;
             }
         }
         if (filler_s)
@@ -1209,17 +1321,16 @@ iostat_draw(void *arg)
         printf("=");
     }
     printf("\n");
-    g_free(iot->items);
-    g_free(iot->max_vals);
-    g_free(iot->max_frame);
-    g_free(iot);
+    for (j=0; j<num_cols; j++)
+        g_free(fmts[j]);
+    iostat_free(iot);
     g_free(col_w);
     g_free(invl_fmt);
     g_free(full_fmt);
     g_free(fmts);
     g_free(spaces);
     g_free(stat_cols);
-    g_free(item_in_column);
+    g_free(cursors);
 }
 
 
@@ -1234,14 +1345,13 @@ register_io_tap(io_stat_t *io, unsigned int i, const char *filter)
     char *field;
     header_field_info *hfi;
 
-    io->items[i].prev       = &io->items[i];
-    io->items[i].next       = NULL;
-    io->items[i].parent     = io;
-    io->items[i].start_time = 0;
-    io->items[i].calc_type  = CALC_TYPE_FRAMES_AND_BYTES;
-    io->items[i].frames     = 0;
-    io->items[i].counter    = 0;
-    io->items[i].num        = 0;
+    io->items[i].parent      = io;
+    io->items[i].calc_type   = CALC_TYPE_FRAMES_AND_BYTES;
+    io->items[i].colnum      = i;
+    io->items[i].hf_index    = -1;
+    io->items[i].field       = NULL;
+    io->items[i].cells       = g_array_new(FALSE, TRUE, sizeof(io_stat_cell_t));
+    io->items[i].load_starts = g_array_new(FALSE, FALSE, sizeof(guint64));
 
     io->filters[i] = filter;
     flt = filter;
@@ -1316,7 +1426,12 @@ register_io_tap(io_stat_t *io, unsigned int i, const char *filter)
         case FT_INT24:
         case FT_INT32:
         case FT_INT64:
-            /* these types support all calculations */
+            /* these types support all calculations but LOAD */
+            if (io->items[i].calc_type == CALC_TYPE_LOAD) {
+                fprintf(stderr,
+                    "\ntshark: LOAD() is only supported for relative-time fields such as smb.time\n");
+                exit(10);
+            }
             break;
         case FT_FLOAT:
         case FT_DOUBLE:
@@ -1370,6 +1485,8 @@ register_io_tap(io_stat_t *io, unsigned int i, const char *filter)
             break;
         }
     }
+    if (hfi && io->items[i].calc_type != CALC_TYPE_COUNT)
+        io->items[i].field = iostat_get_field(io, hfi);
     g_free(field);
 
     error_string = register_tap_listener("frame", &io->items[i], flt, TL_REQUIRES_PROTO_TREE, NULL,
@@ -1385,8 +1502,11 @@ register_io_tap(io_stat_t *io, unsigned int i, const char *filter)
 }
 
 static void
-iostat_init(const char *opt_arg, void *userdata _U_)
+iostat_init(const char *opt_arg, void *userdata)
 {
+    gboolean csv = GPOINTER_TO_INT(userdata);
+    const char *prefix = csv ? "io,stat,csv," : "io,stat,";
+    size_t prefix_len = strlen(prefix);
     gdouble interval_float;
     guint32 idx = 0;
     unsigned int i;
@@ -1394,20 +1514,21 @@ iostat_init(const char *opt_arg, void *userdata _U_)
     const gchar *filters, *str, *pos;
 
     if ((*(opt_arg+(strlen(opt_arg)-1)) == ',') ||
-        (sscanf(opt_arg, "io,stat,%lf%n", &interval_float, (int *)&idx) != 1) ||
-        (idx < 8)) {
-        fprintf(stderr, "\ntshark: invalid \"-z io,stat,<interval>[,<filter>][,<filter>]...\" argument\n");
+        (strncmp(opt_arg, prefix, prefix_len) != 0) ||
+        (sscanf(opt_arg+prefix_len, "%lf%n", &interval_float, (int *)&idx) != 1) ||
+        (idx < 1)) {
+        fprintf(stderr, "\ntshark: invalid \"-z %s<interval>[,<filter>][,<filter>]...\" argument\n", prefix);
         exit(1);
     }
 
-    filters = opt_arg+idx;
+    filters = opt_arg+prefix_len+idx;
     if (*filters) {
         if (*filters != ',') {
             /* For locale's that use ',' instead of '.', the comma might
              * have been consumed during the floating point conversion. */
             --filters;
             if (*filters != ',') {
-                fprintf(stderr, "\ntshark: invalid \"-z io,stat,<interval>[,<filter>][,<filter>]...\" argument\n");
+                fprintf(stderr, "\ntshark: invalid \"-z %s<interval>[,<filter>][,<filter>]...\" argument\n", prefix);
                 exit(1);
             }
         }
@@ -1425,6 +1546,8 @@ iostat_init(const char *opt_arg, void *userdata _U_)
     }
 
     io = g_new(io_stat_t, 1);
+    io->csv = csv;
+    io->fields = g_ptr_array_new_with_free_func(iostat_free_field);
 
     /* If interval is 0, calculate statistics over the whole file by setting the interval to
     *  G_MAXUINT64 */
@@ -1450,7 +1573,7 @@ iostat_init(const char *opt_arg, void *userdata _U_)
                interval of 1 and the last interval becomes "9 <> 9". If the interval is instead set to
                1.1, the last interval becomes
                last interval is rounded up to value that is greater than the duration. */
-            const gchar *invl_start = opt_arg+8;
+            const gchar *invl_start = opt_arg+prefix_len;
             gchar *intv_end;
             int invl_len;
 
@@ -1534,8 +1657,18 @@ static stat_tap_ui iostat_ui = {
     NULL
 };
 
+static stat_tap_ui iostat_csv_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "io,stat,csv",
+    iostat_init,
+    0,
+    NULL
+};
+
 void
 register_tap_listener_iostat(void)
 {
-    register_stat_tap_ui(&iostat_ui, NULL);
+    register_stat_tap_ui(&iostat_ui, GINT_TO_POINTER(FALSE));
+    register_stat_tap_ui(&iostat_csv_ui, GINT_TO_POINTER(TRUE));
 }
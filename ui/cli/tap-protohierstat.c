@@ -69,6 +69,44 @@ free_phs(phs_t *rs)
 	g_free(rs);
 }
 
+/* Add the counts of the partial hierarchy to those of the
+ * hierarchy at the same level, adding any protocols it
+ * doesn't have yet to the end of the siblings. */
+void
+merge_phs(phs_t *rs, const phs_t *partial)
+{
+	phs_t *tmprs;
+
+	for (; partial && partial->protocol != -1; partial = partial->sibling) {
+		for (tmprs=rs; tmprs; tmprs=tmprs->sibling) {
+			if (tmprs->protocol == partial->protocol) {
+				break;
+			}
+		}
+
+		if (!tmprs) {
+			if (rs->protocol == -1) {
+				tmprs = rs;
+			} else {
+				for (tmprs=rs; tmprs->sibling; tmprs=tmprs->sibling)
+					;
+				tmprs->sibling = new_phs_t(rs->parent, NULL);
+				tmprs = tmprs->sibling;
+			}
+			tmprs->protocol = partial->protocol;
+			tmprs->proto_name = partial->proto_name;
+		}
+
+		tmprs->frames += partial->frames;
+		tmprs->bytes += partial->bytes;
+
+		if (!tmprs->child) {
+			tmprs->child = new_phs_t(tmprs, NULL);
+		}
+		merge_phs(tmprs->child, partial->child);
+	}
+}
+
 tap_packet_status
 protohierstat_packet(void *prs, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
 {
@@ -179,6 +217,20 @@ protohierstat_draw(void *prs)
 	printf("===================================================================\n");
 }
 
+static void *
+protohierstat_partial_new(void *prs)
+{
+	phs_t *rs = (phs_t *)prs;
+
+	return new_phs_t(NULL, rs->filter);
+}
+
+static void
+protohierstat_merge(void *prs, void *partial)
+{
+	merge_phs((phs_t *)prs, (phs_t *)partial);
+	free_phs((phs_t *)partial);
+}
 
 static void
 protohierstat_init(const char *opt_arg, void *userdata _U_)
@@ -213,6 +265,7 @@ protohierstat_init(const char *opt_arg, void *userdata _U_)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_mergeable(rs, protohierstat_partial_new, protohierstat_merge);
 }
 
 static stat_tap_ui protohierstat_ui = {
@@ -29,6 +29,7 @@ typedef struct _phs_t {
 
 extern phs_t * new_phs_t(phs_t *parent, const char *filter);
 extern void free_phs(phs_t *rs);
+extern void merge_phs(phs_t *rs, const phs_t *partial);
 extern tap_packet_status protohierstat_packet(void *prs, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_);
 
 #ifdef __cplusplus
@@ -34,6 +34,7 @@ draw_srt_table_data(srt_stat_table *rst, gboolean draw_footer, const char *subfi
 	int i;
 	guint64 td;
 	guint64 sum;
+	nstime_t p50, p99, p999;
 
 	if (rst->num_procs > 0) {
 		if (rst->filter_string != NULL && subfilter != NULL) {
@@ -44,7 +45,7 @@ draw_srt_table_data(srt_stat_table *rst, gboolean draw_footer, const char *subfi
 		} else {
 			printf("Filter: %s\n", rst->filter_string ? rst->filter_string : "");
 		}
-		printf("Index  %-22s Calls    Min SRT    Max SRT    Avg SRT    Sum SRT\n", (rst->proc_column_name != NULL) ? rst->proc_column_name : "Procedure");
+		printf("Index  %-22s Calls    Min SRT    Max SRT    Avg SRT    Sum SRT    p50 SRT    p99 SRT  p99.9 SRT\n", (rst->proc_column_name != NULL) ? rst->proc_column_name : "Procedure");
 	}
 	for(i=0;i<rst->num_procs;i++){
 		/* ignore procedures with no calls (they don't have rows) */
@@ -60,13 +61,20 @@ draw_srt_table_data(srt_stat_table *rst, gboolean draw_footer, const char *subfi
 		sum = (td + 500) / 1000;
 		td = ((td / rst->procedures[i].stats.num) + 500) / 1000;
 
-		printf("%5d  %-22s %6u %3d.%06d %3d.%06d %3d.%06d %3d.%06d\n",
+		get_srt_procedure_quantile(&rst->procedures[i], 0.5, &p50);
+		get_srt_procedure_quantile(&rst->procedures[i], 0.99, &p99);
+		get_srt_procedure_quantile(&rst->procedures[i], 0.999, &p999);
+
+		printf("%5d  %-22s %6u %3d.%06d %3d.%06d %3d.%06d %3d.%06d %3d.%06d %3d.%06d %3d.%06d\n",
 		       i, rst->procedures[i].procedure,
 		       rst->procedures[i].stats.num,
 		       (int)rst->procedures[i].stats.min.secs, (rst->procedures[i].stats.min.nsecs+500)/1000,
 		       (int)rst->procedures[i].stats.max.secs, (rst->procedures[i].stats.max.nsecs+500)/1000,
 		       (int)(td/1000000), (int)(td%1000000),
-		       (int)(sum/1000000), (int)(sum%1000000)
+		       (int)(sum/1000000), (int)(sum%1000000),
+		       (int)p50.secs, (p50.nsecs+500)/1000,
+		       (int)p99.secs, (p99.nsecs+500)/1000,
+		       (int)p999.secs, (p999.nsecs+500)/1000
 		);
 	}
 
@@ -0,0 +1,251 @@
+/* tap-talkers.c
+ * Approximate top talkers and distinct address counts in fixed memory
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Unlike "-z endpoints", which keeps an exact record per address, this
+ * keeps a Space-Saving summary and two HyperLogLog estimators whose size
+ * depends only on the number of talkers requested, so it can run on
+ * captures of any length.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <epan/addr_resolv.h>
+#include <epan/dissectors/packet-ip.h>
+
+#include <wsutil/cmdarg_err.h>
+#include <wsutil/sketch.h>
+
+void register_tap_listener_talkers(void);
+
+#define TALKERS_DEFAULT_COUNT	20
+#define TALKERS_MAX_COUNT	10000
+/* Counters per talker shown; more counters give tighter estimates */
+#define TALKERS_COUNTERS_PER_ITEM	8
+#define TALKERS_HLL_PRECISION	14
+
+typedef struct _talkers_type_t {
+	const char *tap_name;
+	const char *cli_string;
+	const char *title;
+	address_type addr_type;
+	int addr_len;
+} talkers_type_t;
+
+static const talkers_type_t talkers_ipv4 = { "ip", "talkers,ip", "IPv4", AT_IPv4, 4 };
+static const talkers_type_t talkers_ipv6 = { "ipv6", "talkers,ipv6", "IPv6", AT_IPv6, 16 };
+
+typedef struct _talkers_t {
+	const talkers_type_t *type;
+	char *filter;
+	unsigned count;
+	uint64_t packets;
+	uint64_t bytes;
+	ws_topk_t *topk;
+	ws_hll_t *sources;
+	ws_hll_t *destinations;
+} talkers_t;
+
+static void
+talkers_reset(void *arg)
+{
+	talkers_t *tk = (talkers_t *)arg;
+
+	tk->packets = 0;
+	tk->bytes = 0;
+	ws_topk_reset(tk->topk);
+	ws_hll_reset(tk->sources);
+	ws_hll_reset(tk->destinations);
+}
+
+static tap_packet_status
+talkers_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data, tap_flags_t flags _U_)
+{
+	talkers_t *tk = (talkers_t *)arg;
+	const talkers_type_t *type = tk->type;
+	const address *src, *dst;
+
+	if (type->addr_type == AT_IPv4) {
+		const ws_ip4 *iph = WS_IP4_PTR(data);
+		if (!iph)
+			return TAP_PACKET_DONT_REDRAW;
+		src = &iph->ip_src;
+		dst = &iph->ip_dst;
+	} else {
+		const ws_ip6 *iph = WS_IP6_PTR(data);
+		if (!iph)
+			return TAP_PACKET_DONT_REDRAW;
+		src = &iph->ip6_src;
+		dst = &iph->ip6_dst;
+	}
+	if (src->len != type->addr_len || dst->len != type->addr_len) {
+		return TAP_PACKET_DONT_REDRAW;
+	}
+
+	tk->packets++;
+	tk->bytes += pinfo->fd->pkt_len;
+
+	/* Each packet counts towards both of its endpoints */
+	ws_topk_add(tk->topk, src->data, pinfo->fd->pkt_len);
+	ws_topk_add(tk->topk, dst->data, pinfo->fd->pkt_len);
+	ws_hll_add(tk->sources, src->data, type->addr_len);
+	ws_hll_add(tk->destinations, dst->data, type->addr_len);
+
+	return TAP_PACKET_REDRAW;
+}
+
+static void
+talkers_draw(void *arg)
+{
+	talkers_t *tk = (talkers_t *)arg;
+	ws_topk_item_t *items;
+	unsigned num_items, i;
+
+	items = g_new(ws_topk_item_t, tk->count * TALKERS_COUNTERS_PER_ITEM);
+	num_items = ws_topk_items(tk->topk, items);
+	if (num_items > tk->count) {
+		num_items = tk->count;
+	}
+
+	printf("================================================================================\n");
+	printf("%s Top Talkers (approximate)\n", tk->type->title);
+	printf("Filter:%s\n", tk->filter ? tk->filter : "<No Filter>");
+	printf("Packets: %" PRIu64 "   Bytes: %" PRIu64 "\n", tk->packets, tk->bytes);
+	printf("Distinct sources: ~%" PRIu64 "   Distinct destinations: ~%" PRIu64 "\n",
+	       ws_hll_count(tk->sources), ws_hll_count(tk->destinations));
+	printf("%-50s %16s %12s  %7s\n", "Address", "Bytes", "+/- Bytes", "Share");
+
+	for (i = 0; i < num_items; i++) {
+		address addr;
+		char *addr_str;
+
+		set_address(&addr, tk->type->addr_type, tk->type->addr_len, items[i].key);
+		addr_str = address_to_display(NULL, &addr);
+		printf("%-50s %16" PRIu64 " %12" PRIu64 "  %6.2f%%\n",
+		       addr_str, items[i].weight, items[i].error,
+		       tk->bytes ? 100.0 * (double)items[i].weight / (double)tk->bytes : 0.0);
+		wmem_free(NULL, addr_str);
+	}
+	printf("================================================================================\n");
+
+	g_free(items);
+}
+
+static void
+talkers_finish(void *arg)
+{
+	talkers_t *tk = (talkers_t *)arg;
+
+	ws_topk_free(tk->topk);
+	ws_hll_free(tk->sources);
+	ws_hll_free(tk->destinations);
+	g_free(tk->filter);
+	g_free(tk);
+}
+
+static void
+talkers_init(const char *opt_arg, void *userdata)
+{
+	const talkers_type_t *type = (const talkers_type_t *)userdata;
+	talkers_t *tk;
+	const char *args;
+	const char *filter = NULL;
+	unsigned count = TALKERS_DEFAULT_COUNT;
+	GString *error_string;
+
+	/* -z talkers,<type>[,<count>][,<filter>] */
+	args = opt_arg + strlen(type->cli_string);
+	if (*args == ',') {
+		args++;
+		if (g_ascii_isdigit(*args)) {
+			char *end;
+			unsigned long val = strtoul(args, &end, 10);
+			if ((*end != '\0' && *end != ',') || val == 0 || val > TALKERS_MAX_COUNT) {
+				cmdarg_err("invalid \"-z %s[,<count>][,<filter>]\" argument: count must be between 1 and %d",
+				    type->cli_string, TALKERS_MAX_COUNT);
+				exit(1);
+			}
+			count = (unsigned)val;
+			args = end;
+			if (*args == ',') {
+				args++;
+			}
+		}
+		if (*args != '\0') {
+			filter = args;
+		}
+	} else if (*args != '\0') {
+		cmdarg_err("invalid \"-z %s[,<count>][,<filter>]\" argument", type->cli_string);
+		exit(1);
+	}
+
+	tk = g_new0(talkers_t, 1);
+	tk->type = type;
+	tk->filter = g_strdup(filter);
+	tk->count = count;
+	tk->topk = ws_topk_new(count * TALKERS_COUNTERS_PER_ITEM, type->addr_len);
+	tk->sources = ws_hll_new(TALKERS_HLL_PRECISION);
+	tk->destinations = ws_hll_new(TALKERS_HLL_PRECISION);
+
+	error_string = register_tap_listener(type->tap_name, tk, tk->filter, TL_REQUIRES_NOTHING,
+	    talkers_reset, talkers_packet, talkers_draw, talkers_finish);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		cmdarg_err("Couldn't register %s tap: %s", type->cli_string, error_string->str);
+		g_string_free(error_string, TRUE);
+		talkers_finish(tk);
+		exit(1);
+	}
+}
+
+static stat_tap_ui talkers_ipv4_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"talkers,ip",
+	talkers_init,
+	0,
+	NULL
+};
+
+static stat_tap_ui talkers_ipv6_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"talkers,ipv6",
+	talkers_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_talkers(void)
+{
+	register_stat_tap_ui(&talkers_ipv4_ui, (void *)&talkers_ipv4);
+	register_stat_tap_ui(&talkers_ipv6_ui, (void *)&talkers_ipv6);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
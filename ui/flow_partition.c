@@ -0,0 +1,221 @@
+/* flow_partition.c
+ * Cheap classification of packets into flows, for splitting a capture
+ * between several processes
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <wiretap/wtap.h>
+#include <wsutil/pint.h>
+#include <epan/etypes.h>
+#include <epan/ipproto.h>
+
+#include "ui/flow_partition.h"
+
+/* Maximum number of VLAN tags we'll skip */
+#define MAX_VLAN_TAGS 4
+
+/* Maximum number of IPv6 extension headers we'll skip */
+#define MAX_IPV6_EXT_HDRS 8
+
+/* 32-bit FNV-1a */
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME        16777619U
+
+static guint32
+fnv1a(guint32 hash, const guint8 *data, size_t len)
+{
+    while (len--) {
+        hash ^= *data++;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/*
+ * Hash a pair of endpoints, each an address of addr_len bytes followed by
+ * a port of port_len bytes, in an order that doesn't depend on which is
+ * the source and which is the destination.
+ */
+static guint32
+hash_endpoints(guint8 proto, const guint8 *src_addr, const guint8 *dst_addr, size_t addr_len,
+               const guint8 *src_port, const guint8 *dst_port, size_t port_len)
+{
+    int      cmp;
+    guint32  hash;
+
+    cmp = memcmp(src_addr, dst_addr, addr_len);
+    if (cmp == 0 && port_len != 0)
+        cmp = memcmp(src_port, dst_port, port_len);
+    if (cmp > 0) {
+        const guint8 *tmp;
+
+        tmp = src_addr; src_addr = dst_addr; dst_addr = tmp;
+        tmp = src_port; src_port = dst_port; dst_port = tmp;
+    }
+    hash = fnv1a(FNV_OFFSET_BASIS, &proto, 1);
+    hash = fnv1a(hash, src_addr, addr_len);
+    hash = fnv1a(hash, dst_addr, addr_len);
+    if (port_len != 0) {
+        hash = fnv1a(hash, src_port, port_len);
+        hash = fnv1a(hash, dst_port, port_len);
+    }
+    return hash;
+}
+
+static gboolean
+proto_has_ports(guint8 proto)
+{
+    switch (proto) {
+
+    case IP_PROTO_TCP:
+    case IP_PROTO_UDP:
+    case IP_PROTO_UDPLITE:
+    case IP_PROTO_SCTP:
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
+static guint32
+hash_ipv4(const guint8 *pd, guint32 len)
+{
+    guint   hdr_len;
+    guint8  proto;
+
+    if (len < 20)
+        return 0;
+    hdr_len = (pd[0] & 0x0F) * 4;
+    proto = pd[9];
+    /*
+     * Only use the ports if this isn't part of a fragmented datagram;
+     * all of its fragments, including the first, must hash the same.
+     */
+    if ((pntoh16(pd + 6) & 0x3FFF) == 0 && proto_has_ports(proto) &&
+        hdr_len >= 20 && len >= hdr_len + 4)
+        return hash_endpoints(proto, pd + 12, pd + 16, 4, pd + hdr_len, pd + hdr_len + 2, 2);
+    return hash_endpoints(proto, pd + 12, pd + 16, 4, NULL, NULL, 0);
+}
+
+static guint32
+hash_ipv6(const guint8 *pd, guint32 len)
+{
+    guint   offset = 40;
+    guint8  proto;
+    int     i;
+
+    if (len < 40)
+        return 0;
+    proto = pd[6];
+    for (i = 0; i < MAX_IPV6_EXT_HDRS; i++) {
+        if (proto != IP_PROTO_HOPOPTS && proto != IP_PROTO_ROUTING && proto != IP_PROTO_DSTOPTS)
+            break;
+        if (len < offset + 2)
+            return hash_endpoints(proto, pd + 8, pd + 24, 16, NULL, NULL, 0);
+        proto = pd[offset];
+        offset += (pd[offset + 1] + 1) * 8;
+    }
+    /* Fragments, including the first, are hashed on the addresses. */
+    if (proto_has_ports(proto) && len >= offset + 4)
+        return hash_endpoints(proto, pd + 8, pd + 24, 16, pd + offset, pd + offset + 2, 2);
+    return hash_endpoints(proto, pd + 8, pd + 24, 16, NULL, NULL, 0);
+}
+
+static guint32
+hash_ethertype(guint16 etype, const guint8 *pd, guint32 len)
+{
+    switch (etype) {
+
+    case ETHERTYPE_IP:
+        return hash_ipv4(pd, len);
+
+    case ETHERTYPE_IPv6:
+        return hash_ipv6(pd, len);
+
+    default:
+        return 0;
+    }
+}
+
+static guint32
+hash_ethernet(const guint8 *pd, guint32 len)
+{
+    guint    offset = 12;
+    guint16  etype;
+    int      i;
+
+    if (len < 14)
+        return 0;
+    etype = pntoh16(pd + offset);
+    for (i = 0; i < MAX_VLAN_TAGS; i++) {
+        if (etype != ETHERTYPE_VLAN && etype != ETHERTYPE_IEEE_802_1AD && etype != ETHERTYPE_QINQ_OLD)
+            break;
+        offset += 4;
+        if (len < offset + 2)
+            return 0;
+        etype = pntoh16(pd + offset);
+    }
+    offset += 2;
+    if (etype == ETHERTYPE_IP || etype == ETHERTYPE_IPv6)
+        return hash_ethertype(etype, pd + offset, len - offset);
+    /* Not IP; use the MAC addresses. */
+    return hash_endpoints(0, pd + 6, pd, 6, NULL, NULL, 0);
+}
+
+static guint32
+hash_raw_ip(const guint8 *pd, guint32 len)
+{
+    if (len < 1)
+        return 0;
+    switch (pd[0] >> 4) {
+
+    case 4:
+        return hash_ipv4(pd, len);
+
+    case 6:
+        return hash_ipv6(pd, len);
+
+    default:
+        return 0;
+    }
+}
+
+guint32
+flow_partition_hash(int encap, const guint8 *pd, guint32 caplen)
+{
+    switch (encap) {
+
+    case WTAP_ENCAP_ETHERNET:
+        return hash_ethernet(pd, caplen);
+
+    case WTAP_ENCAP_RAW_IP:
+    case WTAP_ENCAP_RAW_IP4:
+    case WTAP_ENCAP_RAW_IP6:
+        return hash_raw_ip(pd, caplen);
+
+    case WTAP_ENCAP_SLL:
+        /* 16-byte header, protocol type at the end */
+        if (caplen < 16)
+            return 0;
+        return hash_ethertype(pntoh16(pd + 14), pd + 16, caplen - 16);
+
+    case WTAP_ENCAP_SLL2:
+        /* 20-byte header, protocol type at the beginning */
+        if (caplen < 20)
+            return 0;
+        return hash_ethertype(pntoh16(pd), pd + 20, caplen - 20);
+
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,47 @@
+/** @file
+ *
+ * Cheap classification of packets into flows, for splitting a capture
+ * between several processes
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FLOW_PARTITION_H__
+#define __FLOW_PARTITION_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Compute a hash of the flow to which a packet belongs, without
+ * dissecting it.
+ *
+ * For IPv4 and IPv6 packets the flow is the protocol and the addresses
+ * and, for unfragmented TCP, UDP, UDP-Lite and SCTP packets, the ports;
+ * fragments are hashed on the protocol and addresses alone, so that all
+ * of a datagram's fragments land in the same flow.  Other Ethernet
+ * packets are hashed on their MAC addresses.  The hash doesn't depend on
+ * the direction of the packet.
+ *
+ * Only Ethernet (with or without VLAN tags), raw IP and Linux cooked
+ * captures are understood; anything else hashes to 0.
+ *
+ * @param encap the WTAP_ENCAP_ value for the packet
+ * @param pd the packet data
+ * @param caplen the number of bytes of packet data
+ * @return the hash
+ */
+extern guint32 flow_partition_hash(int encap, const guint8 *pd, guint32 caplen);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FLOW_PARTITION_H__ */
@@ -23,19 +23,72 @@
 
 #include <wsutil/ws_assert.h>
 
+static gboolean
+frame_set_contains(const packet_range_frame_set_t *set, guint32 framenum)
+{
+    return framenum < set->num_frames &&
+        (set->bits[framenum / 64] & (G_GUINT64_CONSTANT(1) << (framenum % 64))) != 0;
+}
+
+/* Add a frame to a set, returning FALSE if it was already there. */
+static gboolean
+frame_set_add(packet_range_frame_set_t *set, guint32 num_frames, guint32 framenum)
+{
+    guint64 bit = G_GUINT64_CONSTANT(1) << (framenum % 64);
+
+    if (set->bits == NULL) {
+        set->num_frames = num_frames + 1;
+        set->bits = g_new0(guint64, set->num_frames / 64 + 1);
+    }
+    if (framenum >= set->num_frames || (set->bits[framenum / 64] & bit)) {
+        return FALSE;
+    }
+    set->bits[framenum / 64] |= bit;
+    set->count++;
+    return TRUE;
+}
+
+static void
+frame_set_clear(packet_range_frame_set_t *set)
+{
+    g_free(set->bits);
+    set->bits = NULL;
+    set->num_frames = 0;
+    set->count = 0;
+}
+
+/* Add a frame and everything it depends on, directly or indirectly. */
 static void
-depended_frames_add(GHashTable* depended_table, frame_data_sequence *frames, frame_data *frame)
+depended_frames_add(packet_range_frame_set_t *set, capture_file *cf, frame_data *frame)
 {
-    if (g_hash_table_add(depended_table, GUINT_TO_POINTER(frame->num)) && frame->dependent_frames) {
-        GHashTableIter iter;
-        gpointer key;
-        frame_data *depended_fd;
-        g_hash_table_iter_init(&iter, frame->dependent_frames);
-        while (g_hash_table_iter_next(&iter, &key, NULL)) {
-            depended_fd = frame_data_sequence_find(frames, GPOINTER_TO_UINT(key));
-            depended_frames_add(depended_table, frames, depended_fd);
+    GArray *stack;
+    const guint32 *depended;
+    guint32 count, framenum;
+    frame_data *depended_fd;
+
+    if (!frame_set_add(set, cf->count, frame->num)) {
+        return;
+    }
+    depended = frame_data_get_dependent_frames(frame, &count);
+    if (count == 0) {
+        return;
+    }
+
+    stack = g_array_sized_new(FALSE, FALSE, sizeof(guint32), count);
+    g_array_append_vals(stack, depended, count);
+    while (stack->len > 0) {
+        framenum = g_array_index(stack, guint32, stack->len - 1);
+        g_array_set_size(stack, stack->len - 1);
+        if (!frame_set_add(set, cf->count, framenum)) {
+            continue;
+        }
+        depended_fd = frame_data_sequence_find(cf->provider.frames, framenum);
+        depended = frame_data_get_dependent_frames(depended_fd, &count);
+        if (count > 0) {
+            g_array_append_vals(stack, depended, count);
         }
     }
+    g_array_free(stack, TRUE);
 }
 
 /* (re-)calculate the packet counts (except the user specified range) */
@@ -123,7 +176,7 @@ static void packet_range_calc(packet_range_t *range) {
                     if (framenum > displayed_mark_high) {
                        displayed_mark_high = framenum;
                     }
-                    depended_frames_add(range->displayed_marked_plus_depends, range->cf->provider.frames, packet);
+                    depended_frames_add(&range->displayed_marked_plus_depends, range->cf, packet);
                 }
 
                 if (mark_low == 0) {
@@ -132,7 +185,7 @@ static void packet_range_calc(packet_range_t *range) {
                 if (framenum > mark_high) {
                    mark_high = framenum;
                 }
-                depended_frames_add(range->marked_plus_depends, range->cf->provider.frames, packet);
+                depended_frames_add(&range->marked_plus_depends, range->cf, packet);
             }
             if (packet->ignored) {
                 range->ignored_cnt++;
@@ -152,7 +205,7 @@ static void packet_range_calc(packet_range_t *range) {
                 if (packet->ignored) {
                     range->ignored_mark_range_cnt++;
                 }
-                depended_frames_add(range->mark_range_plus_depends, range->cf->provider.frames, packet);
+                depended_frames_add(&range->mark_range_plus_depends, range->cf, packet);
             }
 
             if (framenum >= displayed_mark_low &&
@@ -164,13 +217,13 @@ static void packet_range_calc(packet_range_t *range) {
                         range->displayed_ignored_mark_range_cnt++;
                     }
                 }
-                depended_frames_add(range->displayed_mark_range_plus_depends, range->cf->provider.frames, packet);
+                depended_frames_add(&range->displayed_mark_range_plus_depends, range->cf, packet);
             }
         }
-        range->marked_plus_depends_cnt = g_hash_table_size(range->marked_plus_depends);
-        range->displayed_marked_plus_depends_cnt = g_hash_table_size(range->displayed_marked_plus_depends);
-        range->mark_range_plus_depends_cnt = g_hash_table_size(range->mark_range_plus_depends);
-        range->displayed_mark_range_plus_depends_cnt = g_hash_table_size(range->displayed_mark_range_plus_depends);
+        range->marked_plus_depends_cnt = range->marked_plus_depends.count;
+        range->displayed_marked_plus_depends_cnt = range->displayed_marked_plus_depends.count;
+        range->mark_range_plus_depends_cnt = range->mark_range_plus_depends.count;
+        range->displayed_mark_range_plus_depends_cnt = range->displayed_mark_range_plus_depends.count;
     }
 }
 
@@ -216,18 +269,18 @@ static void packet_range_calc_user(packet_range_t *range) {
                 if (packet->ignored) {
                     range->ignored_user_range_cnt++;
                 }
-                depended_frames_add(range->user_range_plus_depends, range->cf->provider.frames, packet);
+                depended_frames_add(&range->user_range_plus_depends, range->cf, packet);
                 if (packet->passed_dfilter) {
                     range->displayed_user_range_cnt++;
                     if (packet->ignored) {
                         range->displayed_ignored_user_range_cnt++;
                     }
-                    depended_frames_add(range->displayed_user_range_plus_depends, range->cf->provider.frames, packet);
+                    depended_frames_add(&range->displayed_user_range_plus_depends, range->cf, packet);
                 }
             }
         }
-        range->user_range_plus_depends_cnt = g_hash_table_size(range->user_range_plus_depends);
-        range->displayed_user_range_plus_depends_cnt = g_hash_table_size(range->displayed_user_range_plus_depends);
+        range->user_range_plus_depends_cnt = range->user_range_plus_depends.count;
+        range->displayed_user_range_plus_depends_cnt = range->displayed_user_range_plus_depends.count;
     }
 }
 
@@ -251,18 +304,18 @@ static void packet_range_calc_selection(packet_range_t *range) {
                 if (packet->ignored) {
                     range->ignored_selection_range_cnt++;
                 }
-                depended_frames_add(range->selected_plus_depends, range->cf->provider.frames, packet);
+                depended_frames_add(&range->selected_plus_depends, range->cf, packet);
                 if (packet->passed_dfilter) {
                     range->displayed_selection_range_cnt++;
                     if (packet->ignored) {
                         range->displayed_ignored_selection_range_cnt++;
                     }
-                    depended_frames_add(range->displayed_selected_plus_depends, range->cf->provider.frames, packet);
+                    depended_frames_add(&range->displayed_selected_plus_depends, range->cf, packet);
                 }
             }
         }
-        range->selected_plus_depends_cnt = g_hash_table_size(range->selected_plus_depends);
-        range->displayed_selected_plus_depends_cnt = g_hash_table_size(range->displayed_selected_plus_depends);
+        range->selected_plus_depends_cnt = range->selected_plus_depends.count;
+        range->displayed_selected_plus_depends_cnt = range->displayed_selected_plus_depends.count;
     }
 }
 
@@ -275,14 +328,6 @@ void packet_range_init(packet_range_t *range, capture_file *cf) {
     range->user_range = NULL;
     range->selection_range = NULL;
     range->cf         = cf;
-    range->marked_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
-    range->displayed_marked_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
-    range->mark_range_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
-    range->displayed_mark_range_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
-    range->user_range_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
-    range->displayed_user_range_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
-    range->selected_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
-    range->displayed_selected_plus_depends = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     /* calculate all packet range counters */
     packet_range_calc(range);
@@ -293,14 +338,14 @@ void packet_range_init(packet_range_t *range, capture_file *cf) {
 void packet_range_cleanup(packet_range_t *range) {
     wmem_free(NULL, range->user_range);
     wmem_free(NULL, range->selection_range);
-    g_hash_table_destroy(range->marked_plus_depends);
-    g_hash_table_destroy(range->displayed_marked_plus_depends);
-    g_hash_table_destroy(range->mark_range_plus_depends);
-    g_hash_table_destroy(range->displayed_mark_range_plus_depends);
-    g_hash_table_destroy(range->user_range_plus_depends);
-    g_hash_table_destroy(range->displayed_user_range_plus_depends);
-    g_hash_table_destroy(range->selected_plus_depends);
-    g_hash_table_destroy(range->displayed_selected_plus_depends);
+    frame_set_clear(&range->marked_plus_depends);
+    frame_set_clear(&range->displayed_marked_plus_depends);
+    frame_set_clear(&range->mark_range_plus_depends);
+    frame_set_clear(&range->displayed_mark_range_plus_depends);
+    frame_set_clear(&range->user_range_plus_depends);
+    frame_set_clear(&range->displayed_user_range_plus_depends);
+    frame_set_clear(&range->selected_plus_depends);
+    frame_set_clear(&range->displayed_selected_plus_depends);
 }
 
 /* check whether the packet range is OK */
@@ -350,44 +395,44 @@ packet_range_process_packet_include_depends(packet_range_t *range, frame_data *f
         break;
     case(range_process_selected):
         if (range->process_filtered) {
-            if (!g_hash_table_contains(range->displayed_selected_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->displayed_selected_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         } else {
-            if (!g_hash_table_contains(range->selected_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->selected_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         }
         break;
     case(range_process_marked):
         if (range->process_filtered) {
-            if (!g_hash_table_contains(range->displayed_marked_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->displayed_marked_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         } else {
-            if (!g_hash_table_contains(range->marked_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->marked_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         }
         break;
     case(range_process_marked_range):
         if (range->process_filtered) {
-            if (!g_hash_table_contains(range->displayed_mark_range_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->displayed_mark_range_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         } else {
-            if (!g_hash_table_contains(range->mark_range_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->mark_range_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         }
         break;
     case(range_process_user_range):
         if (range->process_filtered) {
-            if (!g_hash_table_contains(range->displayed_user_range_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->displayed_user_range_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         } else {
-            if (!g_hash_table_contains(range->user_range_plus_depends, GUINT_TO_POINTER(fdata->num))) {
+            if (!frame_set_contains(&range->user_range_plus_depends, fdata->num)) {
                 return range_process_next;
             }
         }
@@ -500,8 +545,8 @@ void packet_range_convert_str(packet_range_t *range, const gchar *es)
         return;
     }
     range->user_range = new_range;
-    g_hash_table_remove_all(range->user_range_plus_depends);
-    g_hash_table_remove_all(range->displayed_user_range_plus_depends);
+    frame_set_clear(&range->user_range_plus_depends);
+    frame_set_clear(&range->displayed_user_range_plus_depends);
 
     /* calculate new user specified packet range counts */
     packet_range_calc_user(range);
@@ -531,8 +576,8 @@ void packet_range_convert_selection_str(packet_range_t *range, const char *es)
         return;
     }
     range->selection_range = new_range;
-    g_hash_table_remove_all(range->selected_plus_depends);
-    g_hash_table_remove_all(range->displayed_selected_plus_depends);
+    frame_set_clear(&range->selected_plus_depends);
+    frame_set_clear(&range->displayed_selected_plus_depends);
 
     /* calculate new user specified packet range counts */
     packet_range_calc_selection(range);
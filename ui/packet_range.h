@@ -36,6 +36,14 @@ typedef enum {
     range_process_user_range
 } packet_range_e;
 
+/* A set of frame numbers, as a bitmap allocated when the first frame is
+ * added. */
+typedef struct {
+    guint64        *bits;
+    guint32         num_frames;     /* frame numbers the bitmap has room for */
+    guint32         count;          /* frames in the set */
+} packet_range_frame_set_t;
+
 typedef struct packet_range_tag {
     /* values coming from the UI */
     packet_range_e  process;            /* which range to process */
@@ -84,14 +92,14 @@ typedef struct packet_range_tag {
     guint32  displayed_ignored_selection_range_cnt;
 
     /* Sets of the chosen frames plus any they depend on for each case */
-    GHashTable *marked_plus_depends;
-    GHashTable *displayed_marked_plus_depends;
-    GHashTable *mark_range_plus_depends;
-    GHashTable *displayed_mark_range_plus_depends;
-    GHashTable *user_range_plus_depends;
-    GHashTable *displayed_user_range_plus_depends;
-    GHashTable *selected_plus_depends;
-    GHashTable *displayed_selected_plus_depends;
+    packet_range_frame_set_t marked_plus_depends;
+    packet_range_frame_set_t displayed_marked_plus_depends;
+    packet_range_frame_set_t mark_range_plus_depends;
+    packet_range_frame_set_t displayed_mark_range_plus_depends;
+    packet_range_frame_set_t user_range_plus_depends;
+    packet_range_frame_set_t displayed_user_range_plus_depends;
+    packet_range_frame_set_t selected_plus_depends;
+    packet_range_frame_set_t displayed_selected_plus_depends;
 
     /* "enumeration" values */
     gboolean marked_range_active;   /* marked range is currently processed */
@@ -159,9 +159,8 @@ process_tree(proto_tree *protocol_tree, ph_stats_t* ps)
 
     static gboolean
 process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
-               wtap_rec *rec, Buffer *buf, ph_stats_t* ps)
+               wtap_rec *rec, Buffer *buf, epan_dissect_t *edt, ph_stats_t* ps)
 {
-    epan_dissect_t	edt;
     double		cur_time;
 
     /* Load the record from the capture file */
@@ -169,15 +168,12 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
         return FALSE;	/* failure */
 
     /* Dissect the record   tree  not visible */
-    epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
-    /* Don't fake protocols. We need them for the protocol hierarchy */
-    epan_dissect_fake_protocols(&edt, FALSE);
-    epan_dissect_run(&edt, cf->cd_t, rec,
+    epan_dissect_run(edt, cf->cd_t, rec,
                      frame_tvbuff_new_buffer(&cf->provider, frame, buf),
                      frame, cinfo);
 
     /* Get stats from this protocol tree */
-    process_tree(edt.tree, ps);
+    process_tree(edt->tree, ps);
 
     if (frame->has_ts) {
         /* Update times */
@@ -189,7 +185,8 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
     }
 
     /* Free our memory. */
-    epan_dissect_cleanup(&edt);
+    epan_dissect_reset(edt);
+    wtap_rec_reset(rec);
 
     return TRUE;	/* success */
 }
@@ -204,6 +201,7 @@ ph_stats_new(capture_file *cf)
     int		count;
     wtap_rec	rec;
     Buffer	buf;
+    epan_dissect_t	edt;
     float	progbar_val;
     gchar	status_str[100];
     int		progbar_nextstep;
@@ -242,6 +240,12 @@ ph_stats_new(capture_file *cf)
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
 
+    /* One dissection context for the whole pass, reset after each
+       record, rather than setting up and tearing down a tree per frame. */
+    epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
+    /* Don't fake protocols. We need them for the protocol hierarchy */
+    epan_dissect_fake_protocols(&edt, FALSE);
+
     for (framenum = 1; framenum <= cf->count; framenum++) {
         frame = frame_data_sequence_find(cf->provider.frames, framenum);
 
@@ -309,7 +313,7 @@ ph_stats_new(capture_file *cf)
             ps->tot_packets++;
 
             /* we don't care about colinfo */
-            if (!process_record(cf, frame, NULL, &rec, &buf, ps)) {
+            if (!process_record(cf, frame, NULL, &rec, &buf, &edt, ps)) {
                 /*
                  * Give up, and set "stop_flag" so we
                  * just abort rather than popping up
@@ -325,6 +329,7 @@ ph_stats_new(capture_file *cf)
         count++;
     }
 
+    epan_dissect_cleanup(&edt);
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
 
@@ -22,8 +22,13 @@ capture_file cfile;
 
 #include "epan/epan_dissect.h"
 
+#include "epan/tap.h"
+
 #include "ui/capture.h"
 
+#include "main_application.h"
+
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QTimer>
 #include <QDebug>
@@ -82,8 +87,15 @@ QString CaptureFile::no_capture_file_ = QObject::tr("[no capture file]");
 CaptureFile::CaptureFile(QObject *parent, capture_file *cap_file) :
     QObject(parent),
     cap_file_(cap_file),
-    file_state_(QString())
+    file_state_(QString()),
+    retap_timer_(new QTimer(this)),
+    retapping_(false),
+    retap_pending_(false)
 {
+    retap_timer_->setSingleShot(true);
+    retap_timer_->setInterval(0);
+    connect(retap_timer_, SIGNAL(timeout()), this, SLOT(retapPackets()));
+
 #ifdef HAVE_LIBPCAP
     capture_callback_add(captureCallback, (gpointer) this);
 #endif
@@ -205,14 +217,40 @@ int CaptureFile::timestampPrecision()
 
 void CaptureFile::retapPackets()
 {
-    if (cap_file_) {
-        cf_retap_packets(cap_file_);
+    if (!cap_file_) return;
+
+    // The progress dialog processes events, so another dialog can ask for
+    // a retap while we're in one. Run it once the current pass is done.
+    if (retapping_) {
+        retap_pending_ = true;
+        return;
     }
+
+    // This pass feeds the listeners that asked for a delayed retap too.
+    retap_timer_->stop();
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    retapping_ = true;
+    do {
+        retap_pending_ = false;
+        cf_retap_packets(cap_file_);
+    } while (retap_pending_ && cap_file_);
+    retapping_ = false;
+
+    guint listeners = tap_listeners_count();
+    mainApp->pushStatus(MainApplication::TemporaryStatus,
+                        tr("Recalculated statistics for %Ln tap listener(s) in %1 ms", "", listeners)
+                        .arg(elapsed.elapsed()));
 }
 
 void CaptureFile::delayedRetapPackets()
 {
-    QTimer::singleShot(0, this, SLOT(retapPackets()));
+    if (retapping_) {
+        retap_pending_ = true;
+        return;
+    }
+    retap_timer_->start();
 }
 
 void CaptureFile::reload()
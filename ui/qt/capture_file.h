@@ -19,6 +19,8 @@
 #include "cfile.h"
 #include "capture_event.h"
 
+class QTimer;
+
 class CaptureFile : public QObject
 {
     Q_OBJECT
@@ -125,13 +127,17 @@ signals:
 public slots:
     /** Retap the capture file. Convenience wrapper for cf_retap_packets.
      * Application events are processed periodically via update_progress_dlg.
+     * A retap feeds every tap listener, so a request made while one is
+     * running is deferred until it finishes and any pending delayed retap
+     * is dropped.
      */
     void retapPackets();
 
     /** Retap the capture file after the current batch of application events
      * is processed. If you call this instead of retapPackets or
      * cf_retap_packets in a dialog's constructor it will be displayed before
-     * tapping starts.
+     * tapping starts. Requests made by several dialogs in the same batch
+     * share a single pass.
      */
     void delayedRetapPackets();
 
@@ -159,6 +165,9 @@ private:
 
     capture_file *cap_file_;
     QString file_state_;
+    QTimer *retap_timer_;
+    bool retapping_;
+    bool retap_pending_;
 };
 
 #endif // CAPTURE_FILE_H
@@ -16,6 +16,8 @@
 
 #include <epan/conversation.h>
 #include <epan/conversation_debug.h>
+#include <epan/dissectors/packet-tcp.h>
+#include <wsutil/str_util.h>
 
 #include <ui/qt/utils/qt_ui_utils.h>
 #include "main_application.h"
@@ -138,6 +140,18 @@ ConversationHashTablesDialog::ConversationHashTablesDialog(QWidget *parent) :
         html += "</table>\n";
     }
     wmem_destroy_list(table_names);
+
+    mptcp_mapping_stats_t mptcp_stats;
+    get_mptcp_mapping_stats(&mptcp_stats);
+    html += "<h2>MPTCP DSS Mappings</h2>\n";
+    html += "<table>\n";
+    html += QString("<tr><td>SSN to DSN mappings</td><td>%1</td></tr>\n").arg(mptcp_stats.mappings);
+    html += QString("<tr><td>Coalesced mappings</td><td>%1</td></tr>\n").arg(mptcp_stats.coalesced);
+    html += QString("<tr><td>DSN to packet entries</td><td>%1</td></tr>\n").arg(mptcp_stats.dsn2packet);
+    html += QString("<tr><td>Dropped (subflow limit)</td><td>%1</td></tr>\n").arg(mptcp_stats.dropped);
+    html += QString("<tr><td>Memory</td><td>%1</td></tr>\n").arg(gchar_free_to_qstring(format_size((gint64)mptcp_stats.bytes, FORMAT_SIZE_UNIT_BYTES, FORMAT_SIZE_PREFIX_IEC)));
+    html += "</table>\n";
+
     ui->conversationTextEdit->setHtml(html);
 }
 
@@ -199,8 +199,10 @@ void DecodeAsDialog::on_clearToolButton_clicked()
 
 void DecodeAsDialog::applyChanges()
 {
-    model_->applyChanges();
-    mainApp->queueAppSignal(MainApplication::PacketDissectionChanged);
+    // Pressing OK without changing anything shouldn't redissect the file.
+    if (model_->applyChanges()) {
+        mainApp->queueAppSignal(MainApplication::PacketDissectionChanged);
+    }
 }
 
 void DecodeAsDialog::on_buttonBox_clicked(QAbstractButton *button)
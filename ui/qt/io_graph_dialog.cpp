@@ -1286,17 +1286,16 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
     if (uat_model_ != NULL) {
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
-            if (iog) {
-                iog->setInterval(interval);
-                if (iog->visible()) {
-                    need_retap = true;
-                }
+            if (iog && !iog->setInterval(interval) && iog->visible()) {
+                need_retap = true;
             }
         }
     }
 
     if (need_retap) {
         scheduleRetap(true);
+    } else {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1704,7 +1703,9 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
-    cur_idx_(-1)
+    interval_(0),
+    cur_idx_(-1),
+    msec_buckets_valid_(false)
 {
     Q_ASSERT(parent_ != NULL);
     graph_ = parent_->addGraph(parent_->xAxis, parent_->yAxis);
@@ -2022,6 +2023,8 @@ int IOGraph::packetFromTime(double ts)
 
 void IOGraph::clearAllData()
 {
+    msec_buckets_.clear();
+    msec_buckets_valid_ = false;
     cur_idx_ = -1;
     reset_io_graph_items(items_, max_io_items_);
     if (graph_) {
@@ -2264,9 +2267,64 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+bool IOGraph::setInterval(int interval)
 {
+    bool changed = interval != interval_;
+
     interval_ = interval;
+
+    // Every interval is a whole number of milliseconds.
+    if (!msec_buckets_valid_ || interval_ <= 0) {
+        return false;
+    }
+    if (changed) {
+        regroupMsecBuckets();
+    }
+    return true;
+}
+
+void IOGraph::addToMsecBuckets(const packet_info *pinfo)
+{
+    gint64 msec = get_io_graph_index(const_cast<packet_info *>(pinfo), 1);
+
+    if (msec_buckets_.isEmpty() || msec_buckets_.last().msec != msec) {
+        MsecBucket bucket = { msec, 0, 0, pinfo->num, pinfo->num };
+        msec_buckets_ << bucket;
+    }
+
+    MsecBucket &bucket = msec_buckets_.last();
+    bucket.frames++;
+    bucket.bytes += pinfo->fd->pkt_len;
+    bucket.last_frame = pinfo->num;
+}
+
+// Rebuild the items for interval_ from msec_buckets_, as tapPacket would.
+void IOGraph::regroupMsecBuckets()
+{
+    cur_idx_ = -1;
+    reset_io_graph_items(items_, max_io_items_);
+
+    foreach (const MsecBucket &bucket, msec_buckets_) {
+        gint64 idx = bucket.msec / interval_;
+
+        if (idx >= max_io_items_) {
+            cur_idx_ = max_io_items_ - 1;
+            continue;
+        }
+        if (idx > cur_idx_) {
+            cur_idx_ = (int) idx;
+        }
+
+        io_graph_item_t *item = &items_[idx];
+        if (item->first_frame_in_invl == 0 || bucket.first_frame < item->first_frame_in_invl) {
+            item->first_frame_in_invl = bucket.first_frame;
+        }
+        if (bucket.last_frame > item->last_frame_in_invl) {
+            item->last_frame_in_invl = bucket.last_frame;
+        }
+        item->frames += bucket.frames;
+        item->bytes += bucket.bytes;
+    }
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -2285,6 +2343,7 @@ void IOGraph::tapReset(void *iog_ptr)
 
 //    qDebug() << "=tapReset" << iog->name_;
     iog->clearAllData();
+    iog->msec_buckets_valid_ = iog->val_units_ < IOG_ITEM_UNIT_CALC_SUM;
 }
 
 // "tap_packet" callback for register_tap_listener
@@ -2298,6 +2357,10 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
     int idx = get_io_graph_index(pinfo, iog->interval_);
     bool recalc = false;
 
+    if (iog->msec_buckets_valid_ && idx >= 0) {
+        iog->addToMsecBuckets(pinfo);
+    }
+
     /* some sanity checks */
     if ((idx < 0) || (idx >= max_io_items_)) {
         iog->cur_idx_ = max_io_items_ - 1;
@@ -28,6 +28,7 @@
 #include <QIcon>
 #include <QMenu>
 #include <QTextStream>
+#include <QVector>
 
 class QRubberBand;
 class QTimer;
@@ -67,7 +68,8 @@ public:
     const QString valueUnitField() { return vu_field_; }
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() { return moving_avg_period_; }
-    void setInterval(int interval);
+    // Returns true if the items could be regrouped without a retap.
+    bool setInterval(int interval);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() { return graph_; }
@@ -123,6 +125,21 @@ private:
     // much as is feasible.
     io_graph_item_t items_[max_io_items_];
     int cur_idx_;
+
+    // The frames and bytes of each millisecond with packets, in tap order,
+    // kept for the units that don't need field values, so that the items
+    // can be regrouped for another interval without a retap.
+    struct MsecBucket {
+        gint64 msec;
+        guint32 frames;
+        guint64 bytes;
+        guint32 first_frame;
+        guint32 last_frame;
+    };
+    QVector<MsecBucket> msec_buckets_;
+    bool msec_buckets_valid_;
+    void addToMsecBuckets(const packet_info *pinfo);
+    void regroupMsecBuckets();
 };
 
 namespace Ui {
@@ -40,9 +40,12 @@ ATapDataModel::ATapDataModel(dataModelType type, int protoId, QString filter, QO
 {
     hash_.conv_array = nullptr;
     hash_.hashtable = nullptr;
+    hash_.fixed_table = nullptr;
+    hash_.addr_strings = nullptr;
     hash_.user_data = this;
 
     storage_ = nullptr;
+    storage_rows_ = 0;
     _resolveNames = false;
     _absoluteTime = false;
     _nanoseconds = false;
@@ -139,7 +142,7 @@ void ATapDataModel::disableTap()
 
 int ATapDataModel::rowCount(const QModelIndex &parent) const
 {
-    return (storage_ && !parent.isValid()) ? (int) storage_->len : 0;
+    return (storage_ && !parent.isValid()) ? storage_rows_ : 0;
 }
 
 void ATapDataModel::tapReset(void *tapdata) {
@@ -168,6 +171,12 @@ conv_hash_t * ATapDataModel::hash()
     return &hash_;
 }
 
+QString ATapDataModel::addressString(const address *addr) const
+{
+    /* Interning only adds to the cache; it doesn't change the data. */
+    return QString(get_conversation_address_str(const_cast<conv_hash_t *>(&hash_), addr, _resolveNames));
+}
+
 register_ct_t * ATapDataModel::registerTable() const
 {
     if (_protoId > -1)
@@ -196,6 +205,7 @@ void ATapDataModel::resetData()
 
     beginResetModel();
     storage_ = nullptr;
+    storage_rows_ = 0;
     if (_type == ATapDataModel::DATAMODEL_ENDPOINT)
         reset_endpoint_table_data(&hash_);
     else if (_type == ATapDataModel::DATAMODEL_CONVERSATION)
@@ -212,9 +222,27 @@ void ATapDataModel::updateData(GArray * newData)
     if (_disableTap)
         return;
 
-    beginResetModel();
-    storage_ = newData;
-    endResetModel();
+    int newRows = newData ? (int) newData->len : 0;
+
+    if (storage_ && newData == storage_ && newRows >= storage_rows_) {
+        /* Between resets the tap only updates its items in place and
+         * appends new ones, so only tell the views what changed instead
+         * of resetting the model, which would sort and lay out every row
+         * again and lose the selection. */
+        if (storage_rows_ > 0) {
+            emit dataChanged(index(0, 0), index(storage_rows_ - 1, columnCount() - 1));
+        }
+        if (newRows > storage_rows_) {
+            beginInsertRows(QModelIndex(), storage_rows_, newRows - 1);
+            storage_rows_ = newRows;
+            endInsertRows();
+        }
+    } else {
+        beginResetModel();
+        storage_ = newData;
+        storage_rows_ = newRows;
+        endResetModel();
+    }
 
     if (_type == ATapDataModel::DATAMODEL_CONVERSATION)
         ((ConversationDataModel *)(this))->doDataUpdate();
@@ -417,12 +445,8 @@ QVariant EndpointDataModel::data(const QModelIndex &idx, int role) const
 
     if (role == Qt::DisplayRole || role == ATapDataModel::UNFORMATTED_DISPLAYDATA) {
         switch (idx.column()) {
-        case ENDP_COLUMN_ADDR: {
-            char* addr_str = get_conversation_address(NULL, &item->myaddress, _resolveNames);
-            QString q_addr_str(addr_str);
-            wmem_free(NULL, addr_str);
-            return q_addr_str;
-        }
+        case ENDP_COLUMN_ADDR:
+            return addressString(&item->myaddress);
         case ENDP_COLUMN_PORT:
             if (_resolveNames) {
                 char* port_str = get_endpoint_port(NULL, item, _resolveNames);
@@ -661,12 +685,7 @@ QVariant ConversationDataModel::data(const QModelIndex &idx, int role) const
     if (role == Qt::DisplayRole || role == ATapDataModel::UNFORMATTED_DISPLAYDATA) {
         switch(idx.column()) {
         case CONV_COLUMN_SRC_ADDR:
-            {
-            char* addr_str = get_conversation_address(NULL, &conv_item->src_address, _resolveNames);
-            QString q_addr_str(addr_str);
-            wmem_free(NULL, addr_str);
-            return q_addr_str;
-            }
+            return addressString(&conv_item->src_address);
         case CONV_COLUMN_SRC_PORT:
             if (_resolveNames) {
                 char* port_str = get_conversation_port(NULL, conv_item->src_port, conv_item->ctype, _resolveNames);
@@ -677,12 +696,7 @@ QVariant ConversationDataModel::data(const QModelIndex &idx, int role) const
                 return quint32(conv_item->src_port);
             }
         case CONV_COLUMN_DST_ADDR:
-            {
-            char* addr_str = get_conversation_address(NULL, &conv_item->dst_address, _resolveNames);
-            QString q_addr_str(addr_str);
-            wmem_free(NULL, addr_str);
-            return q_addr_str;
-            }
+            return addressString(&conv_item->dst_address);
         case CONV_COLUMN_DST_PORT:
             if (_resolveNames) {
                 char* port_str = get_conversation_port(NULL, conv_item->dst_port, conv_item->ctype, _resolveNames);
@@ -840,7 +854,7 @@ conv_item_t * ConversationDataModel::itemForRow(int row)
 
 bool ConversationDataModel::showConversationId(int row) const
 {
-    if (!storage_ || row < 0 || row >= (int) storage_->len)
+    if (!storage_ || row < 0 || row >= storage_rows_)
         return false;
 
     conv_item_t *conv_item = (conv_item_t *)&g_array_index(storage_, conv_item_t, row);
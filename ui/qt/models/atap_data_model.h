@@ -226,6 +226,9 @@ protected:
 
     dataModelType _type;
     GArray * storage_;
+    /* The rows of storage_ the views know about. The tap appends to
+     * storage_ between draws, so it can be longer. */
+    int storage_rows_;
     QString _filter;
 
     bool _absoluteTime;
@@ -238,6 +241,10 @@ protected:
 
     register_ct_t* registerTable() const;
 
+    /* The string for an address, interned in the table so that it is
+     * only formatted once however often the views ask for it. */
+    QString addressString(const address *addr) const;
+
 private:
     int _protoId;
 
@@ -725,12 +725,43 @@ void DecodeAsModel::gatherChangedEntries(const gchar *table_name,
     }
 }
 
-void DecodeAsModel::applyChanges()
+void DecodeAsModel::gatherActiveEntry(const gchar *table_name, ftenum_t,
+        gpointer key, gpointer value, gpointer user_data)
+{
+    QStringList *entries = static_cast<QStringList *>(user_data);
+    dissector_handle_t handle = dtbl_entry_get_handle((dtbl_entry_t *)value);
+
+    *entries << QString("%1 %2 %3").arg(table_name)
+                                   .arg(entryString(table_name, key))
+                                   .arg(reinterpret_cast<quintptr>(handle));
+}
+
+void DecodeAsModel::gatherActiveDceRpcEntry(gpointer data, gpointer user_data)
+{
+    QStringList *entries = static_cast<QStringList *>(user_data);
+
+    // Bindings are compared by identity, so re-added ones count as changed.
+    *entries << QString("%1 %2").arg(DCERPC_TABLE_NAME).arg(reinterpret_cast<quintptr>(data));
+}
+
+// Describe the Decode As entries in effect, in a canonical order.
+QStringList DecodeAsModel::activeEntries()
+{
+    QStringList entries;
+
+    dissector_all_tables_foreach_changed(gatherActiveEntry, &entries);
+    decode_dcerpc_add_show_list(gatherActiveDceRpcEntry, &entries);
+    entries.sort();
+    return entries;
+}
+
+bool DecodeAsModel::applyChanges()
 {
     dissector_table_t sub_dissectors;
     module_t *module;
     pref_t* pref_value;
     dissector_handle_t handle;
+    QStringList entries_before = activeEntries();
     // Reset all dissector tables, then apply all rules from model.
 
     // We can't call g_hash_table_removed from g_hash_table_foreach, which
@@ -846,4 +877,6 @@ void DecodeAsModel::applyChanges()
         }
     }
     prefs_apply_all();
+
+    return activeEntries() != entries_before;
 }
@@ -17,6 +17,7 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QStringList>
 
 #include "cfile.h"
 
@@ -99,7 +100,8 @@ public:
 
     static QString entryString(const gchar *table_name, gconstpointer value);
 
-    void applyChanges();
+    // Returns true if any entry ended up different from what was in effect.
+    bool applyChanges();
 
 protected:
     static void buildChangedList(const gchar *table_name, ftenum_t selector_type,
@@ -107,6 +109,10 @@ protected:
     static void buildDceRpcChangedList(gpointer data, gpointer user_data);
     static void gatherChangedEntries(const gchar *table_name, ftenum_t selector_type,
                           gpointer key, gpointer value, gpointer user_data);
+    static void gatherActiveEntry(const gchar *table_name, ftenum_t selector_type,
+                          gpointer key, gpointer value, gpointer user_data);
+    static void gatherActiveDceRpcEntry(gpointer data, gpointer user_data);
+    static QStringList activeEntries();
     static prefs_set_pref_e readDecodeAsEntry(gchar *key, const gchar *value,
                           void *user_data, gboolean return_range_errors);
 
@@ -18,6 +18,7 @@ ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info
     group_(expert_info.group),
     severity_(expert_info.severity),
     hf_id_(expert_info.hf_index),
+    row_(0),
     protocol_(expert_info.protocol),
     summary_(expert_info.summary),
     parentItem_(parent)
@@ -27,6 +28,19 @@ ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info
     }
 }
 
+ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, const QByteArray &protocol, const QByteArray &summary, const QByteArray &info, ExpertPacketItem* parent) :
+    packet_num_(expert_info.packet_num),
+    group_(expert_info.group),
+    severity_(expert_info.severity),
+    hf_id_(expert_info.hf_index),
+    row_(0),
+    protocol_(protocol),
+    summary_(summary),
+    info_(info),
+    parentItem_(parent)
+{
+}
+
 ExpertPacketItem::~ExpertPacketItem()
 {
     for (int row = 0; row < childItems_.count(); row++)
@@ -55,6 +69,7 @@ QString ExpertPacketItem::groupKey(bool group_by_summary) {
 
 void ExpertPacketItem::appendChild(ExpertPacketItem* child, QString hash)
 {
+    child->row_ = static_cast<int>(childItems_.count());
     childItems_.append(child);
     hashChild_[hash] = child;
 }
@@ -76,10 +91,7 @@ int ExpertPacketItem::childCount() const
 
 int ExpertPacketItem::row() const
 {
-    if (parentItem_)
-        return static_cast<int>(parentItem_->childItems_.indexOf(const_cast<ExpertPacketItem*>(this)));
-
-    return 0;
+    return row_;
 }
 
 ExpertPacketItem* ExpertPacketItem::parentItem()
@@ -108,6 +120,7 @@ void ExpertInfoModel::clear()
     beginResetModel();
 
     eventCounts_.clear();
+    strings_.clear();
     delete root_;
     root_ = createRootItem();
 
@@ -367,7 +380,11 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
         expert_root = new_item;
     }
 
-    ExpertPacketItem *expert = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_root);
+    QByteArray protocol = internString(expert_info.protocol);
+    QByteArray summary = internString(expert_info.summary);
+    QByteArray info = col_get_text(&(capture_file_.capFile()->cinfo), COL_INFO);
+
+    ExpertPacketItem *expert = new ExpertPacketItem(expert_info, protocol, summary, info, expert_root);
     expert_root->appendChild(expert, groupKey);
 
     //add the summary children off of the first child of the root children
@@ -382,10 +399,22 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
         expert_summary_root = new_summary;
     }
 
-    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_summary_root);
+    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, protocol, summary, info, expert_summary_root);
     expert_summary_root->appendChild(expert_summary, summaryKey);
 }
 
+QByteArray ExpertInfoModel::internString(const char *str)
+{
+    QByteArray bytes(str);
+    QSet<QByteArray>::const_iterator it = strings_.constFind(bytes);
+
+    if (it != strings_.constEnd()) {
+        return *it;
+    }
+    strings_.insert(bytes);
+    return bytes;
+}
+
 void ExpertInfoModel::tapReset(void *eid_ptr)
 {
     ExpertInfoModel *model = static_cast<ExpertInfoModel*>(eid_ptr);
@@ -17,6 +17,7 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include <QMap>
+#include <QSet>
 
 #include <ui/qt/capture_file.h>
 
@@ -28,6 +29,8 @@ class ExpertPacketItem
 {
 public:
     ExpertPacketItem(const expert_info_t& expert_info, column_info *cinfo, ExpertPacketItem* parent);
+    // For the items of each expert info, which share their strings.
+    ExpertPacketItem(const expert_info_t& expert_info, const QByteArray &protocol, const QByteArray &summary, const QByteArray &info, ExpertPacketItem* parent);
     virtual ~ExpertPacketItem();
 
     unsigned int packetNum() const { return packet_num_; }
@@ -53,8 +56,9 @@ private:
     int group_;
     int severity_;
     int hf_id_;
-    // Half-hearted attempt at conserving memory. If this isn't sufficient,
-    // PacketListRecord interns column strings in a GStringChunk.
+    int row_;
+    // The protocol and summary are interned by ExpertInfoModel, and the
+    // two items of each expert info share theirs.
     QByteArray protocol_;
     QByteArray summary_;
     QByteArray info_;
@@ -124,5 +128,10 @@ private:
     ExpertPacketItem* root_;
 
     QHash<enum ExpertSeverity, int> eventCounts_;
+
+    // Protocol names and summaries seen so far. Most are the same for
+    // many items, which then share one copy.
+    QSet<QByteArray> strings_;
+    QByteArray internString(const char *str);
 };
 #endif // EXPERT_INFO_MODEL_H
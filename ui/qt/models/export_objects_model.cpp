@@ -16,6 +16,11 @@
 #include <epan/prefs.h>
 
 #include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+// Payload bytes kept in memory before older ones are spooled to disk.
+static const size_t max_resident_bytes_ = 64 * 1024 * 1024;
 
 extern "C" {
 
@@ -44,7 +49,9 @@ object_list_get_entry(void *gui_data, int row) {
 
 ExportObjectModel::ExportObjectModel(register_eo_t* eo, QObject *parent) :
     QAbstractTableModel(parent),
-    eo_(eo)
+    eo_(eo),
+    spool_file_(NULL),
+    resident_bytes_(0)
 {
     eo_gui_data_.model = this;
 
@@ -54,10 +61,21 @@ ExportObjectModel::ExportObjectModel(register_eo_t* eo, QObject *parent) :
 }
 
 ExportObjectModel::~ExportObjectModel()
+{
+    freeObjects();
+}
+
+void ExportObjectModel::freeObjects()
 {
     foreach (QVariant v, objects_) {
         eo_free_entry(VariantPointer<export_object_entry_t>::asPtr(v));
     }
+    objects_.clear();
+    spool_offsets_.clear();
+    resident_rows_.clear();
+    resident_bytes_ = 0;
+    delete spool_file_;
+    spool_file_ = NULL;
 }
 
 QVariant ExportObjectModel::data(const QModelIndex &index, int role) const
@@ -138,12 +156,105 @@ void ExportObjectModel::addObjectEntry(export_object_entry_t *entry)
     int count = static_cast<int>(objects_.count());
     beginInsertRows(QModelIndex(), count, count);
     objects_.append(VariantPointer<export_object_entry_t>::asQVariant(entry));
+    spool_offsets_.append(-1);
     endInsertRows();
+
+    resident_rows_.enqueue(count);
+    resident_bytes_ += entry->payload_len;
+    spoolPayloads();
 }
 
+// Dissectors such as FTP and SMB look up entries they've added in
+// order to append to them, so hand back the payload in memory.
 export_object_entry_t* ExportObjectModel::objectEntry(int row)
 {
-    return VariantPointer<export_object_entry_t>::asPtr(objects_.value(row));
+    export_object_entry_t *entry = VariantPointer<export_object_entry_t>::asPtr(objects_.value(row));
+    if (entry && spool_offsets_.value(row, -1) >= 0) {
+        if (loadPayload(row)) {
+            resident_rows_.enqueue(row);
+            resident_bytes_ += entry->payload_len;
+        }
+    }
+    return entry;
+}
+
+void ExportObjectModel::spoolPayloads()
+{
+    while (resident_bytes_ > max_resident_bytes_ && !resident_rows_.isEmpty()) {
+        int row = resident_rows_.dequeue();
+        export_object_entry_t *entry = VariantPointer<export_object_entry_t>::asPtr(objects_.value(row));
+        // Rows are queued again when they're loaded back in.
+        if (!entry || spool_offsets_[row] >= 0) continue;
+
+        resident_bytes_ -= qMin(resident_bytes_, entry->payload_len);
+        if (!entry->payload_data || entry->payload_len < 1) continue;
+
+        if (!spool_file_) {
+            spool_file_ = new QTemporaryFile(QDir::temp().filePath("wireshark_eo_XXXXXX"));
+            if (!spool_file_->open()) {
+                // Keep everything in memory, as before.
+                delete spool_file_;
+                spool_file_ = NULL;
+                resident_rows_.clear();
+                return;
+            }
+        }
+
+        // Loaded entries are appended again rather than rewritten in place,
+        // since they might have grown.
+        qint64 offset = spool_file_->size();
+        if (!spool_file_->seek(offset) ||
+                spool_file_->write((const char *)entry->payload_data, entry->payload_len) != (qint64)entry->payload_len) {
+            continue;
+        }
+        g_free(entry->payload_data);
+        entry->payload_data = NULL;
+        spool_offsets_[row] = offset;
+    }
+}
+
+bool ExportObjectModel::loadPayload(int row)
+{
+    export_object_entry_t *entry = VariantPointer<export_object_entry_t>::asPtr(objects_.value(row));
+    qint64 offset = spool_offsets_.value(row, -1);
+    if (!entry || offset < 0 || !spool_file_) return false;
+
+    guint8 *payload = (guint8 *)g_malloc(entry->payload_len);
+    if (!spool_file_->seek(offset) ||
+            spool_file_->read((char *)payload, entry->payload_len) != (qint64)entry->payload_len) {
+        g_free(payload);
+        return false;
+    }
+    entry->payload_data = payload;
+    spool_offsets_[row] = -1;
+    return true;
+}
+
+// Write an entry's payload, copying it from the spool file if it's there.
+bool ExportObjectModel::writeEntry(int row, const QString &filename)
+{
+    export_object_entry_t *entry = VariantPointer<export_object_entry_t>::asPtr(objects_.value(row));
+    if (entry == NULL)
+        return false;
+
+    qint64 offset = spool_offsets_.value(row, -1);
+    if (offset < 0 || !spool_file_) {
+        return write_file_binary_mode(qUtf8Printable(filename), entry->payload_data, entry->payload_len);
+    }
+
+    QFile out_file(filename);
+    if (!out_file.open(QIODevice::WriteOnly) || !spool_file_->seek(offset))
+        return false;
+
+    char buf[64 * 1024];
+    qint64 remaining = (qint64)entry->payload_len;
+    while (remaining > 0) {
+        qint64 chunk = spool_file_->read(buf, qMin(remaining, (qint64)sizeof(buf)));
+        if (chunk <= 0 || out_file.write(buf, chunk) != chunk)
+            return false;
+        remaining -= chunk;
+    }
+    return true;
 }
 
 bool ExportObjectModel::saveEntry(QModelIndex &index, QString filename)
@@ -156,7 +267,7 @@ bool ExportObjectModel::saveEntry(QModelIndex &index, QString filename)
         return false;
 
     if (filename.length() > 0) {
-        write_file_binary_mode(qUtf8Printable(filename), entry->payload_data, entry->payload_len);
+        writeEntry(index.row(), filename);
     }
 
     return true;
@@ -170,9 +281,9 @@ void ExportObjectModel::saveAllEntries(QString path)
     QDir save_dir(path);
     export_object_entry_t *entry;
 
-    for (QList<QVariant>::iterator it = objects_.begin(); it != objects_.end(); ++it)
+    for (int row = 0; row < static_cast<int>(objects_.count()); row++)
     {
-        entry = VariantPointer<export_object_entry_t>::asPtr(*it);
+        entry = VariantPointer<export_object_entry_t>::asPtr(objects_.at(row));
         if (entry == NULL)
             continue;
 
@@ -198,8 +309,7 @@ void ExportObjectModel::saveAllEntries(QString path)
             filename = QString::fromUtf8(safe_filename->str);
             g_string_free(safe_filename, TRUE);
         } while (save_dir.exists(filename) && ++count < prefs.gui_max_export_objects);
-        write_file_binary_mode(qUtf8Printable(save_dir.filePath(filename)),
-                               entry->payload_data, entry->payload_len);
+        writeEntry(row, save_dir.filePath(filename));
     }
 }
 
@@ -208,7 +318,7 @@ void ExportObjectModel::resetObjects()
     export_object_gui_reset_cb reset_cb = get_eo_reset_func(eo_);
 
     beginResetModel();
-    objects_.clear();
+    freeObjects();
     endResetModel();
 
     if (reset_cb)
@@ -20,6 +20,10 @@
 #include <QAbstractTableModel>
 #include <QSortFilterProxyModel>
 #include <QList>
+#include <QQueue>
+#include <QVector>
+
+class QTemporaryFile;
 
 typedef struct export_object_list_gui_t {
     class ExportObjectModel *model;
@@ -64,6 +68,20 @@ public:
 private:
     QList<QVariant> objects_;
 
+    // Payloads past the first few megabytes are moved to a temporary
+    // file, oldest first, so that a capture with thousands of objects
+    // doesn't keep them all in memory. payload_len stays valid and
+    // payload_data is NULL while an entry's payload is in the file.
+    QTemporaryFile *spool_file_;
+    QVector<qint64> spool_offsets_;
+    QQueue<int> resident_rows_;
+    size_t resident_bytes_;
+
+    void spoolPayloads();
+    bool loadPayload(int row);
+    bool writeEntry(int row, const QString &filename);
+    void freeObjects();
+
     export_object_list_t export_object_list_;
     export_object_list_gui_t eo_gui_data_;
     register_eo_t* eo_;
@@ -8,6 +8,7 @@
  */
 
 #include <algorithm>
+#include <vector>
 #include <glib.h>
 #include <cmath>
 #include <stdexcept>
@@ -37,6 +38,8 @@
 #include <QColor>
 #include <QElapsedTimer>
 #include <QFontMetrics>
+#include <QHash>
+#include <QMap>
 #include <QModelIndex>
 #include <QElapsedTimer>
 
@@ -76,16 +79,24 @@ packet_list_recreate_visible_rows(void)
 
 PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     QAbstractItemModel(parent),
+    physical_count_(0),
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
-    idle_dissection_row_(0)
+    idle_dissection_row_(0),
+    viewport_first_row_(0),
+    viewport_last_row_(-1),
+    ahead_first_row_(0),
+    ahead_last_row_(-1),
+    ahead_done_(0),
+    ahead_scheduled_(false),
+    flush_interval_(0),
+    flush_scheduled_(false)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
     glbl_plist_model = this;
     setCaptureFile(cf);
 
-    physical_rows_.reserve(reserved_packets_);
     visible_rows_.reserve(reserved_packets_);
     new_visible_rows_.reserve(1000);
     number_to_row_.reserve(reserved_packets_);
@@ -107,11 +118,13 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
             this, &PacketListModel::emitItemHeightChanged,
             Qt::QueuedConnection);
     idle_dissection_timer_ = new QElapsedTimer();
+    flush_timer_ = new QElapsedTimer();
 }
 
 PacketListModel::~PacketListModel()
 {
     delete idle_dissection_timer_;
+    delete flush_timer_;
 }
 
 void PacketListModel::setCaptureFile(capture_file *cf)
@@ -125,9 +138,7 @@ QModelIndex PacketListModel::index(int row, int column, const QModelIndex &) con
     if (row >= visible_rows_.count() || row < 0 || !cap_file_ || column >= prefs.num_cols)
         return QModelIndex();
 
-    PacketListRecord *record = visible_rows_[row];
-
-    return createIndex(row, column, record);
+    return createIndex(row, column, static_cast<quintptr>(visible_rows_[row]));
 }
 
 // Everything is under the root.
@@ -150,11 +161,11 @@ guint PacketListModel::recreateVisibleRows()
     number_to_row_.fill(0);
     endResetModel();
 
-    foreach (PacketListRecord *record, physical_rows_) {
-        frame_data *fdata = record->frameData();
+    for (guint32 num = 1; num <= physical_count_; num++) {
+        frame_data *fdata = frameData(num);
 
-        if (fdata->passed_dfilter || fdata->ref_time) {
-            visible_rows_ << record;
+        if (fdata && (fdata->passed_dfilter || fdata->ref_time)) {
+            visible_rows_ << num;
             if (static_cast<guint32>(number_to_row_.size()) <= fdata->num) {
                 number_to_row_.resize(fdata->num + 10000);
             }
@@ -171,9 +182,8 @@ guint PacketListModel::recreateVisibleRows()
 
 void PacketListModel::clear() {
     beginResetModel();
-    qDeleteAll(physical_rows_);
-    PacketListRecord::invalidateAllRecords();
-    physical_rows_.resize(0);
+    records_.clear();
+    physical_count_ = 0;
     visible_rows_.resize(0);
     new_visible_rows_.resize(0);
     number_to_row_.resize(0);
@@ -182,11 +192,15 @@ void PacketListModel::clear() {
     max_line_count_ = 1;
     idle_dissection_timer_->invalidate();
     idle_dissection_row_ = 0;
+    viewport_first_row_ = 0;
+    viewport_last_row_ = -1;
+    ahead_first_row_ = 0;
+    ahead_last_row_ = -1;
 }
 
 void PacketListModel::invalidateAllColumnStrings()
 {
-    PacketListRecord::invalidateAllRecords();
+    PacketListRecords::invalidateAllRecords();
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
             QVector<int>() << Qt::DisplayRole);
 }
@@ -194,7 +208,7 @@ void PacketListModel::invalidateAllColumnStrings()
 void PacketListModel::resetColumns()
 {
     if (cap_file_) {
-        PacketListRecord::resetColumns(&cap_file_->cinfo);
+        PacketListRecords::resetColumns(&cap_file_->cinfo);
     }
 
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
@@ -203,7 +217,7 @@ void PacketListModel::resetColumns()
 
 void PacketListModel::resetColorized()
 {
-    PacketListRecord::resetColorization();
+    records_.resetColorization();
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
             QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole);
 }
@@ -219,11 +233,7 @@ void PacketListModel::toggleFrameMark(const QModelIndexList &indeces)
         if (! index.isValid())
             continue;
 
-        PacketListRecord *record = static_cast<PacketListRecord*>(index.internalPointer());
-        if (!record)
-            continue;
-
-        frame_data *fdata = record->frameData();
+        frame_data *fdata = getRowFdata(index.row());
         if (!fdata)
             continue;
 
@@ -239,11 +249,12 @@ void PacketListModel::toggleFrameMark(const QModelIndexList &indeces)
 
 void PacketListModel::setDisplayedFrameMark(gboolean set)
 {
-    foreach (PacketListRecord *record, visible_rows_) {
+    foreach (guint32 num, visible_rows_) {
+        frame_data *fdata = frameData(num);
         if (set) {
-            cf_mark_frame(cap_file_, record->frameData());
+            cf_mark_frame(cap_file_, fdata);
         } else {
-            cf_unmark_frame(cap_file_, record->frameData());
+            cf_unmark_frame(cap_file_, fdata);
         }
     }
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
@@ -261,11 +272,7 @@ void PacketListModel::toggleFrameIgnore(const QModelIndexList &indeces)
         if (! index.isValid())
             continue;
 
-        PacketListRecord *record = static_cast<PacketListRecord*>(index.internalPointer());
-        if (!record)
-            continue;
-
-        frame_data *fdata = record->frameData();
+        frame_data *fdata = getRowFdata(index.row());
         if (!fdata)
             continue;
 
@@ -281,11 +288,12 @@ void PacketListModel::toggleFrameIgnore(const QModelIndexList &indeces)
 
 void PacketListModel::setDisplayedFrameIgnore(gboolean set)
 {
-    foreach (PacketListRecord *record, visible_rows_) {
+    foreach (guint32 num, visible_rows_) {
+        frame_data *fdata = frameData(num);
         if (set) {
-            cf_ignore_frame(cap_file_, record->frameData());
+            cf_ignore_frame(cap_file_, fdata);
         } else {
-            cf_unignore_frame(cap_file_, record->frameData());
+            cf_unignore_frame(cap_file_, fdata);
         }
     }
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
@@ -296,10 +304,7 @@ void PacketListModel::toggleFrameRefTime(const QModelIndex &rt_index)
 {
     if (!cap_file_ || !rt_index.isValid()) return;
 
-    PacketListRecord *record = static_cast<PacketListRecord*>(rt_index.internalPointer());
-    if (!record) return;
-
-    frame_data *fdata = record->frameData();
+    frame_data *fdata = getRowFdata(rt_index.row());
     if (!fdata) return;
 
     if (fdata->ref_time) {
@@ -313,7 +318,7 @@ void PacketListModel::toggleFrameRefTime(const QModelIndex &rt_index)
     if (!fdata->ref_time && !fdata->passed_dfilter) {
         cap_file_->displayed_count--;
     }
-    record->resetColumns(&cap_file_->cinfo);
+    PacketListRecords::resetColumns(&cap_file_->cinfo);
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
 }
 
@@ -323,15 +328,15 @@ void PacketListModel::unsetAllFrameRefTime()
 
     /* XXX: we might need a progressbar here */
 
-    foreach (PacketListRecord *record, physical_rows_) {
-        frame_data *fdata = record->frameData();
-        if (fdata->ref_time) {
+    for (guint32 num = 1; num <= physical_count_; num++) {
+        frame_data *fdata = frameData(num);
+        if (fdata && fdata->ref_time) {
             fdata->ref_time = 0;
         }
     }
     cap_file_->ref_time_count = 0;
     cf_reftime_packets(cap_file_);
-    PacketListRecord::resetColumns(&cap_file_->cinfo);
+    PacketListRecords::resetColumns(&cap_file_->cinfo);
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
 }
 
@@ -344,10 +349,9 @@ void PacketListModel::addFrameComment(const QModelIndexList &indices, const QByt
     for (const auto &index : indices) {
         if (!index.isValid()) continue;
 
-        PacketListRecord *record = static_cast<PacketListRecord*>(index.internalPointer());
-        if (!record) continue;
+        fdata = getRowFdata(index.row());
+        if (!fdata) continue;
 
-        fdata = record->frameData();
         wtap_block_t pkt_block = cf_get_packet_block(cap_file_, fdata);
         wtap_block_add_string_option(pkt_block, OPT_COMMENT, comment.data(), comment.size());
 
@@ -371,8 +375,8 @@ void PacketListModel::addFrameComment(const QModelIndexList &indices, const QByt
         // and time shifts ("frame.time_relative", "frame.offset_shift", etc.)
         // If there were, then we'd need to reset data for all frames instead
         // of just the frames changed.
-        record->invalidateColorized();
-        record->invalidateRecord();
+        records_.invalidateColorized(fdata->num);
+        PacketListRecords::invalidateRecord(fdata->num);
         emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), sectionMax),
                 QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole << Qt::DisplayRole);
     }
@@ -386,10 +390,8 @@ void PacketListModel::setFrameComment(const QModelIndex &index, const QByteArray
 
     if (!index.isValid()) return;
 
-    PacketListRecord *record = static_cast<PacketListRecord*>(index.internalPointer());
-    if (!record) return;
-
-    fdata = record->frameData();
+    fdata = getRowFdata(index.row());
+    if (!fdata) return;
 
     wtap_block_t pkt_block = cf_get_packet_block(cap_file_, fdata);
     if (comment.isEmpty()) {
@@ -403,8 +405,8 @@ void PacketListModel::setFrameComment(const QModelIndex &index, const QByteArray
         cf_set_modified_block(cap_file_, fdata, pkt_block);
     }
 
-    record->invalidateColorized();
-    record->invalidateRecord();
+    records_.invalidateColorized(fdata->num);
+    PacketListRecords::invalidateRecord(fdata->num);
     emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), sectionMax),
             QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole << Qt::DisplayRole);
 }
@@ -418,10 +420,9 @@ void PacketListModel::deleteFrameComments(const QModelIndexList &indices)
     for (const auto &index : indices) {
         if (!index.isValid()) continue;
 
-        PacketListRecord *record = static_cast<PacketListRecord*>(index.internalPointer());
-        if (!record) continue;
+        fdata = getRowFdata(index.row());
+        if (!fdata) continue;
 
-        fdata = record->frameData();
         wtap_block_t pkt_block = cf_get_packet_block(cap_file_, fdata);
         guint n_comments = wtap_block_count_option(pkt_block, OPT_COMMENT);
 
@@ -434,8 +435,8 @@ void PacketListModel::deleteFrameComments(const QModelIndexList &indices)
                 expert_update_comment_count(cap_file_->packet_comment_count);
             }
 
-            record->invalidateColorized();
-            record->invalidateRecord();
+            records_.invalidateColorized(fdata->num);
+            PacketListRecords::invalidateRecord(fdata->num);
             emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), sectionMax),
                     QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole << Qt::DisplayRole);
         }
@@ -450,8 +451,10 @@ void PacketListModel::deleteAllFrameComments()
 
     /* XXX: we might need a progressbar here */
 
-    foreach (PacketListRecord *record, physical_rows_) {
-        frame_data *fdata = record->frameData();
+    for (guint32 num = 1; num <= physical_count_; num++) {
+        frame_data *fdata = frameData(num);
+        if (!fdata)
+            continue;
         wtap_block_t pkt_block = cf_get_packet_block(cap_file_, fdata);
         guint n_comments = wtap_block_count_option(pkt_block, OPT_COMMENT);
 
@@ -461,8 +464,8 @@ void PacketListModel::deleteAllFrameComments()
             }
             cf_set_modified_block(cap_file_, fdata, pkt_block);
 
-            record->invalidateColorized();
-            record->invalidateRecord();
+            records_.invalidateColorized(num);
+            PacketListRecords::invalidateRecord(num);
             row = packetNumberToRow(fdata->num);
             if (row > -1) {
                 emit dataChanged(index(row, 0), index(row, sectionMax),
@@ -500,37 +503,16 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     if (!cap_file_ || visible_rows_.count() < 1) return;
     if (column < 0) return;
 
-    if (physical_rows_.count() < 1)
+    if (physical_count_ < 1)
         return;
 
     sort_column_ = column;
-    text_sort_column_ = PacketListRecord::textColumn(column);
+    text_sort_column_ = PacketListRecords::textColumn(column);
     sort_order_ = order;
     sort_cap_file_ = cap_file_;
 
     QString col_title = get_column_title(column);
 
-    if (text_sort_column_ >= 0 && (guint)visible_rows_.count() > prefs.gui_packet_list_cached_rows_max) {
-        /* Column not based on frame data but by column text that requires
-         * dissection, so to sort in a reasonable amount of time the column
-         * text needs to be cached.
-         */
-        /* If the sort is being triggered because the columns were already
-         * sorted and the filter is being cleared (or changed to something
-         * else with more rows than fit in the cache), then the temporary
-         * message will be immediately overwritten with the standard capture
-         * statistics by the packets_bar_update() call after thawing the rows.
-         * It will still blink yellow, and the user will get the message if
-         * they then click on the header file (wondering why it didn't sort.)
-         */
-        if (col_title.isEmpty()) {
-            col_title = tr("Column");
-        }
-        QString temp_msg = tr("%1 can only be sorted with %2 or fewer visible rows; increase cache size in Layout preferences").arg(col_title).arg(prefs.gui_packet_list_cached_rows_max);
-        mainApp->pushStatus(MainApplication::TemporaryStatus, temp_msg);
-        return;
-    }
-
     /* If we are currently in the middle of reading the capture file, don't
      * sort. PacketList::captureFileReadFinished invalidates all the cached
      * column strings and then tries to sort again.
@@ -562,6 +544,10 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
      * overestimate?
      */
     exp_comps_ = log2(visible_rows_.count()) * visible_rows_.count();
+    if (text_sort_column_ >= 0) {
+        // Getting the column text of each row first.
+        exp_comps_ += visible_rows_.count();
+    }
     progress_frame_ = nullptr;
     if (qobject_cast<MainWindow *>(mainApp->mainWindow())) {
         MainWindow *mw = qobject_cast<MainWindow *>(mainApp->mainWindow());
@@ -575,18 +561,25 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     busy_timer_.start();
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    QVector<PacketListRecord *> sorted_visible_rows_ = visible_rows_;
+    QVector<guint32> sorted_visible_rows_ = visible_rows_;
     try {
-        std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+        int es_column = text_sort_column_ >= 0 ? eventStoreColumn(sort_column_) : -1;
+        if (es_column >= 0) {
+            sortByEventStore(sorted_visible_rows_, es_column);
+        } else if (text_sort_column_ >= 0) {
+            sortByColumnText(sorted_visible_rows_);
+        } else {
+            std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+        }
 
         beginResetModel();
         visible_rows_.resize(0);
         number_to_row_.fill(0);
-        foreach (PacketListRecord *record, sorted_visible_rows_) {
-            frame_data *fdata = record->frameData();
+        foreach (guint32 num, sorted_visible_rows_) {
+            frame_data *fdata = frameData(num);
 
             if (fdata->passed_dfilter || fdata->ref_time) {
-                visible_rows_ << record;
+                visible_rows_ << num;
                 if (number_to_row_.size() <= (int)fdata->num) {
                     number_to_row_.resize(fdata->num + 10000);
                 }
@@ -680,15 +673,10 @@ bool PacketListModel::isNumericColumn(int column)
     return true;
 }
 
-bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
+void PacketListModel::sortBusyCheck()
 {
-    int cmp_val = 0;
     comps_++;
 
-    // Wherein we try to cram the logic of packet_list_compare_records,
-    // _packet_list_compare_records, and packet_list_compare_custom from
-    // gtk/packet_list_store.c into one function
-
     if (busy_timer_.elapsed() > busy_timeout_) {
         if (progress_frame_) {
             progress_frame_->setValue(static_cast<int>(comps_/exp_comps_ * 100));
@@ -701,46 +689,197 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
         }
         busy_timer_.restart();
     }
-    if (sort_column_ < 0) {
-        // No column.
-        cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-    } else if (text_sort_column_ < 0) {
-        // Column comes directly from frame data
-        cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
-    } else  {
-        QString r1String = r1->columnString(sort_cap_file_, sort_column_);
-        QString r2String = r2->columnString(sort_cap_file_, sort_column_);
-        // XXX: The naive string comparison compares Unicode code points.
-        // Proper collation is more expensive
-        cmp_val = r1String.compare(r2String);
-        if (cmp_val != 0 && sort_column_is_numeric_) {
-            // Custom column with numeric data (or something like a port number).
-            // Attempt to convert to numbers.
-            // XXX This is slow. Can we avoid doing this? Perhaps the actual
-            // values used for sorting should be cached too as QVariant[List].
-            // If so, we could consider using QCollatorSortKeys or similar
-            // for strings as well.
-            bool ok_r1, ok_r2;
-            double num_r1 = parseNumericColumn(r1String, &ok_r1);
-            double num_r2 = parseNumericColumn(r2String, &ok_r2);
-
-            if (!ok_r1 && !ok_r2) {
-                cmp_val = 0;
-            } else if (!ok_r1 || (ok_r2 && num_r1 < num_r2)) {
-                // either r1 is invalid (and sort it before others) or both
-                // r1 and r2 are valid (sort normally)
-                cmp_val = -1;
-            } else if (!ok_r2 || (num_r1 > num_r2)) {
-                cmp_val = 1;
+}
+
+// Sort by a column that needs dissecting. Each row is dissected once to
+// get its text (and numeric value) for the sort key, and the keys are
+// sorted without looking at the frames again.
+void PacketListModel::sortByColumnText(QVector<guint32> &rows)
+{
+    std::vector<SortKey> keys;
+
+    keys.reserve(rows.count());
+    foreach (guint32 num, rows) {
+        SortKey key;
+
+        sortBusyCheck();
+        key.num = num;
+        key.text = records_.columnString(cap_file_, frameData(num), sort_column_);
+        key.numeric_ok = false;
+        key.numeric = 0;
+        if (sort_column_is_numeric_) {
+            key.numeric = parseNumericColumn(key.text, &key.numeric_ok);
+        }
+        keys.push_back(key);
+    }
+
+    std::sort(keys.begin(), keys.end(), sortKeyLessThan);
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        rows[static_cast<int>(i)] = keys[i].num;
+    }
+}
+
+bool PacketListModel::sortKeyLessThan(const SortKey &k1, const SortKey &k2)
+{
+    sortBusyCheck();
+
+    // XXX: The naive string comparison compares Unicode code points.
+    // Proper collation is more expensive
+    int cmp_val = k1.text.compare(k2.text);
+    if (cmp_val != 0 && sort_column_is_numeric_) {
+        // Custom column with numeric data (or something like a port number).
+        if (!k1.numeric_ok && !k2.numeric_ok) {
+            cmp_val = 0;
+        } else if (!k1.numeric_ok || (k2.numeric_ok && k1.numeric < k2.numeric)) {
+            // either k1 is invalid (and sort it before others) or both
+            // k1 and k2 are valid (sort normally)
+            cmp_val = -1;
+        } else if (!k2.numeric_ok || (k1.numeric > k2.numeric)) {
+            cmp_val = 1;
+        }
+    }
+
+    if (cmp_val == 0) {
+        // All else being equal, compare frame numbers.
+        cmp_val = k1.num < k2.num ? -1 : (k1.num > k2.num ? 1 : 0);
+    }
+
+    if (sort_order_ == Qt::AscendingOrder) {
+        return cmp_val < 0;
+    } else {
+        return cmp_val > 0;
+    }
+}
+
+// The event store column holding the values of a custom column, if it
+// holds all of the frames and sorting by the stored values gives the same
+// order as sorting by the column text.
+int PacketListModel::eventStoreColumn(int column)
+{
+    const col_item_t *col_item = &sort_cap_file_->cinfo.columns[column];
+
+    if (col_item->col_fmt != COL_CUSTOM || g_slist_length(col_item->col_custom_fields_ids) != 1) {
+        return -1;
+    }
+
+    guint *field_idx = (guint *) g_slist_nth_data(col_item->col_custom_fields_ids, 0);
+    header_field_info *hfi = proto_registrar_get_nth(*field_idx);
+    if (!hfi || g_strcmp0(col_item->col_custom_fields, hfi->abbrev) != 0) {
+        return -1;
+    }
+    // Plain value_strings are sorted by their labels below; anything else
+    // is formatted in ways we don't try to follow.
+    if (hfi->strings != NULL &&
+            (hfi->display & (BASE_RANGE_STRING | BASE_EXT_STRING | BASE_VAL64_STRING | BASE_UNIT_STRING | BASE_SPECIAL_VALS) ||
+             FIELD_DISPLAY(hfi->display) == BASE_CUSTOM)) {
+        return -1;
+    }
+
+    return event_store_find_column(sort_cap_file_->event_store, hfi->id, sort_cap_file_->count);
+}
+
+// Sort by a column whose values are in the event store. Nothing is
+// dissected; string values are compared by their rank among the stored
+// strings, and value_string labels by their rank among the labels of the
+// values that are present.
+void PacketListModel::sortByEventStore(QVector<guint32> &rows, int es_column)
+{
+    std::vector<EventSortKey> keys;
+    guint *field_idx = (guint *) g_slist_nth_data(sort_cap_file_->cinfo.columns[sort_column_].col_custom_fields_ids, 0);
+    header_field_info *hfi = proto_registrar_get_nth(*field_idx);
+
+    keys.reserve(rows.count());
+    foreach (guint32 num, rows) {
+        EventSortKey key;
+
+        key.num = num;
+        key.key = 0;
+        key.present = event_store_get_sort_key(sort_cap_file_->event_store, es_column, num, &key.key);
+        keys.push_back(key);
+    }
+
+    if (hfi->strings != NULL) {
+        const value_string *vals = (const value_string *) hfi->strings;
+        QMap<guint64, QString> labels;
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i].present && !labels.contains(keys[i].key)) {
+                const char *label = try_val_to_str((guint32) keys[i].key, vals);
+                labels[keys[i].key] = label ? QString(label) : QString::number(keys[i].key);
             }
         }
 
-        if (cmp_val == 0) {
-            // All else being equal, compare column numbers.
-            cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
+        QList<guint64> by_label = labels.keys();
+        std::sort(by_label.begin(), by_label.end(), [&labels](guint64 v1, guint64 v2) {
+            int cmp_val = labels[v1].compare(labels[v2]);
+            return cmp_val != 0 ? cmp_val < 0 : v1 < v2;
+        });
+        QHash<guint64, guint64> rank;
+        for (int i = 0; i < by_label.count(); i++) {
+            rank[by_label[i]] = static_cast<guint64>(i);
+        }
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i].present) {
+                keys[i].key = rank[keys[i].key];
+            }
         }
     }
 
+    std::sort(keys.begin(), keys.end(), eventSortKeyLessThan);
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        rows[static_cast<int>(i)] = keys[i].num;
+    }
+}
+
+bool PacketListModel::eventSortKeyLessThan(const EventSortKey &k1, const EventSortKey &k2)
+{
+    sortBusyCheck();
+
+    // Rows without a value sort first, as empty text does.
+    int cmp_val = 0;
+    if (k1.present != k2.present) {
+        cmp_val = k1.present ? 1 : -1;
+    } else if (k1.present && k1.key != k2.key) {
+        cmp_val = k1.key < k2.key ? -1 : 1;
+    }
+
+    if (cmp_val == 0) {
+        // All else being equal, compare frame numbers.
+        cmp_val = k1.num < k2.num ? -1 : (k1.num > k2.num ? 1 : 0);
+    }
+
+    if (sort_order_ == Qt::AscendingOrder) {
+        return cmp_val < 0;
+    } else {
+        return cmp_val > 0;
+    }
+}
+
+bool PacketListModel::recordLessThan(guint32 num1, guint32 num2)
+{
+    int cmp_val = 0;
+
+    // Wherein we try to cram the logic of packet_list_compare_records,
+    // _packet_list_compare_records, and packet_list_compare_custom from
+    // gtk/packet_list_store.c into one function
+
+    sortBusyCheck();
+    frame_data *fdata1 = frame_data_sequence_find(sort_cap_file_->provider.frames, num1);
+    frame_data *fdata2 = frame_data_sequence_find(sort_cap_file_->provider.frames, num2);
+
+    if (sort_column_ < 0) {
+        // No column.
+        cmp_val = frame_data_compare(sort_cap_file_->epan, fdata1, fdata2, COL_NUMBER);
+    } else if (text_sort_column_ < 0) {
+        // Column comes directly from frame data
+        cmp_val = frame_data_compare(sort_cap_file_->epan, fdata1, fdata2, sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
+    } else {
+        // Columns that need dissecting are sorted by sortKeyLessThan.
+        cmp_val = frame_data_compare(sort_cap_file_->epan, fdata1, fdata2, COL_NUMBER);
+    }
+
     if (sort_order_ == Qt::AscendingOrder) {
         return cmp_val < 0;
     } else {
@@ -766,11 +905,11 @@ void PacketListModel::emitItemHeightChanged(const QModelIndex &ih_index)
 {
     if (!ih_index.isValid()) return;
 
-    PacketListRecord *record = static_cast<PacketListRecord*>(ih_index.internalPointer());
-    if (!record) return;
+    guint32 num = static_cast<guint32>(ih_index.internalId());
+    if (num == 0) return;
 
-    if (record->lineCount() > max_line_count_) {
-        max_line_count_ = record->lineCount();
+    if (records_.lineCount(num) > max_line_count_) {
+        max_line_count_ = records_.lineCount(num);
         emit itemHeightChanged(ih_index);
     }
 }
@@ -790,10 +929,7 @@ QVariant PacketListModel::data(const QModelIndex &d_index, int role) const
     if (!d_index.isValid())
         return QVariant();
 
-    PacketListRecord *record = static_cast<PacketListRecord*>(d_index.internalPointer());
-    if (!record)
-        return QVariant();
-    const frame_data *fdata = record->frameData();
+    frame_data *fdata = frameData(static_cast<guint32>(d_index.internalId()));
     if (!fdata)
         return QVariant();
 
@@ -846,12 +982,12 @@ QVariant PacketListModel::data(const QModelIndex &d_index, int role) const
     case Qt::DisplayRole:
     {
         int column = d_index.column();
-        QString column_string = record->columnString(cap_file_, column, true);
+        QString column_string = records_.columnString(cap_file_, fdata, column, true);
         // We don't know an item's sizeHint until we fetch its text here.
         // Assume each line count is 1. If the line count changes, emit
         // itemHeightChanged which triggers another redraw (including a
         // fetch of SizeHintRole and DisplayRole) in the next event loop.
-        if (column == 0 && record->lineCountChanged() && record->lineCount() > max_line_count_) {
+        if (column == 0 && records_.lineCountChanged(fdata->num) && records_.lineCount(fdata->num) > max_line_count_) {
             emit maxLineCountChanged(d_index);
         }
         return column_string;
@@ -892,29 +1028,38 @@ QVariant PacketListModel::headerData(int section, Qt::Orientation orientation,
     return QVariant();
 }
 
+// Batches are at most a second apart, however long the view takes.
+static const int max_flush_interval_ = 1000; // ms
 void PacketListModel::flushVisibleRows()
 {
     int pos = static_cast<int>(visible_rows_.count());
 
+    flush_scheduled_ = false;
     if (new_visible_rows_.count() > 0) {
+        QElapsedTimer flush_cost;
+        flush_cost.start();
         beginInsertRows(QModelIndex(), pos, pos + static_cast<int>(new_visible_rows_.count()));
-        foreach (PacketListRecord *record, new_visible_rows_) {
-            frame_data *fdata = record->frameData();
-
-            visible_rows_ << record;
-            if (static_cast<unsigned int>(number_to_row_.size()) <= fdata->num) {
-                number_to_row_.resize(fdata->num + 10000);
+        foreach (guint32 num, new_visible_rows_) {
+            visible_rows_ << num;
+            if (static_cast<unsigned int>(number_to_row_.size()) <= num) {
+                number_to_row_.resize(num + 10000);
             }
-            number_to_row_[fdata->num] = static_cast<int>(visible_rows_.count());
+            number_to_row_[num] = static_cast<int>(visible_rows_.count());
         }
         endInsertRows();
         new_visible_rows_.resize(0);
+
+        // endInsertRows has the view lay out, and possibly scroll to, the
+        // new rows, which is most of the cost.
+        flush_interval_ = qMin(static_cast<int>(flush_cost.elapsed()) * 4, max_flush_interval_);
+        flush_timer_->start();
     }
 }
 
 // Fill our column string and colorization cache while the application is
 // idle. Try to be as conservative with the CPU and disk as possible.
 static const int idle_dissection_interval_ = 5; // ms
+static const int idle_prefetch_rows_ = 1024;
 void PacketListModel::dissectIdle(bool reset)
 {
     if (reset) {
@@ -927,14 +1072,20 @@ void PacketListModel::dissectIdle(bool reset)
     idle_dissection_timer_->restart();
 
     int first = idle_dissection_row_;
+    int physical_rows = static_cast<int>(physical_count_);
+    if (cap_file_ && first < physical_rows) {
+        // Have the OS start reading in the frames we're likely to get to.
+        int last = qMin(physical_rows, first + idle_prefetch_rows_) - 1;
+        cf_prefetch_frames(cap_file_, first + 1, last + 1);
+    }
     while (idle_dissection_timer_->elapsed() < idle_dissection_interval_
-           && idle_dissection_row_ < physical_rows_.count()) {
+           && idle_dissection_row_ < physical_rows) {
         ensureRowColorized(idle_dissection_row_);
         idle_dissection_row_++;
 //        if (idle_dissection_row_ % 1000 == 0) qDebug() << "=di row" << idle_dissection_row_;
     }
 
-    if (idle_dissection_row_ < physical_rows_.count()) {
+    if (idle_dissection_row_ < physical_rows) {
         QTimer::singleShot(0, this, [=]() { dissectIdle(); });
     } else {
         idle_dissection_timer_->invalidate();
@@ -944,11 +1095,71 @@ void PacketListModel::dissectIdle(bool reset)
     emit bgColorizationProgress(first+1, idle_dissection_row_+1);
 }
 
+// Fill in the column strings of the rows a couple of pages around the
+// visible ones while the application is idle, so that scrolling finds them
+// cached instead of dissecting them on the spot. Dissection has to stay on
+// this thread, so it's done in slices of idle_dissection_interval_. At
+// most half of the column string cache is used, so the visible rows
+// aren't evicted.
+static const int ahead_pages_ = 2;
+void PacketListModel::dissectAhead(int first_row, int last_row)
+{
+    if (!cap_file_ || first_row < 0 || last_row < first_row) {
+        return;
+    }
+    if (first_row == viewport_first_row_ && last_row == viewport_last_row_) {
+        return;
+    }
+
+    int page = last_row - first_row + 1;
+    int budget = qMax(0, PacketListRecords::maxCache() / 2 - page);
+    int below = qMin(ahead_pages_ * page, budget);
+    int above = qMin(page, budget - below);
+
+    viewport_first_row_ = first_row;
+    viewport_last_row_ = last_row;
+    ahead_first_row_ = qMax(0, first_row - above);
+    ahead_last_row_ = qMin(static_cast<int>(visible_rows_.count()) - 1, last_row + below);
+    ahead_done_ = 0;
+    if (!ahead_scheduled_) {
+        ahead_scheduled_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::dissectAheadSlice);
+    }
+}
+
+void PacketListModel::dissectAheadSlice()
+{
+    QElapsedTimer slice_timer;
+    int below = qMax(0, ahead_last_row_ - viewport_last_row_);
+    int above = qMax(0, viewport_first_row_ - ahead_first_row_);
+
+    ahead_scheduled_ = false;
+    slice_timer.start();
+    while (ahead_done_ < below + above) {
+        if (slice_timer.elapsed() >= idle_dissection_interval_) {
+            ahead_scheduled_ = true;
+            QTimer::singleShot(0, this, &PacketListModel::dissectAheadSlice);
+            return;
+        }
+
+        int row;
+        if (ahead_done_ < below) {
+            row = viewport_last_row_ + 1 + ahead_done_;
+        } else {
+            row = viewport_first_row_ - 1 - (ahead_done_ - below);
+        }
+        frame_data *fdata = getRowFdata(row);
+        if (fdata) {
+            records_.ensureColumnStrings(cap_file_, fdata);
+        }
+        ahead_done_++;
+    }
+}
+
 // XXX Pass in cinfo from packet_list_append so that we can fill in
 // line counts?
 gint PacketListModel::appendPacket(frame_data *fdata)
 {
-    PacketListRecord *record = new PacketListRecord(fdata);
     qsizetype pos = -1;
 
 #ifdef DEBUG_PACKET_LIST_MODEL
@@ -957,14 +1168,22 @@ gint PacketListModel::appendPacket(frame_data *fdata)
     }
 #endif
 
-    physical_rows_ << record;
+    // Frames are always appended in order, starting with frame 1.
+    Q_ASSERT(fdata->num == physical_count_ + 1);
+    records_.append(fdata);
+    physical_count_ = fdata->num;
 
     if (fdata->passed_dfilter || fdata->ref_time) {
-        new_visible_rows_ << record;
-        if (new_visible_rows_.count() < 2) {
+        new_visible_rows_ << fdata->num;
+        if (!flush_scheduled_) {
             // This is the first queued packet. Schedule an insertion for
-            // the next UI update.
-            QTimer::singleShot(0, this, &PacketListModel::flushVisibleRows);
+            // the next UI update, or once the last batch has settled.
+            int delay = 0;
+            if (flush_timer_->isValid()) {
+                delay = qMax(0, flush_interval_ - static_cast<int>(flush_timer_->elapsed()));
+            }
+            flush_scheduled_ = true;
+            QTimer::singleShot(delay, this, &PacketListModel::flushVisibleRows);
         }
         pos = static_cast<int>( visible_rows_.count() + new_visible_rows_.count() ) - 1;
     }
@@ -972,39 +1191,41 @@ gint PacketListModel::appendPacket(frame_data *fdata)
     return static_cast<gint>(pos);
 }
 
-frame_data *PacketListModel::getRowFdata(QModelIndex idx)
+frame_data *PacketListModel::getRowFdata(QModelIndex idx) const
 {
     if (!idx.isValid())
         return Q_NULLPTR;
     return getRowFdata(idx.row());
 }
 
-frame_data *PacketListModel::getRowFdata(int row) {
+frame_data *PacketListModel::getRowFdata(int row) const {
     if (row < 0 || row >= visible_rows_.count())
         return NULL;
-    PacketListRecord *record = visible_rows_[row];
-    if (!record)
-        return NULL;
-    return record->frameData();
+    return frameData(visible_rows_[row]);
 }
 
-void PacketListModel::ensureRowColorized(int row)
+unsigned int PacketListModel::getRowConversation(int row) const
 {
     if (row < 0 || row >= visible_rows_.count())
+        return 0;
+    return records_.conversation(visible_rows_[row]);
+}
+
+void PacketListModel::ensureRowColorized(int row)
+{
+    frame_data *fdata = getRowFdata(row);
+    if (!fdata)
         return;
-    PacketListRecord *record = visible_rows_[row];
-    if (!record)
-        return;
-    if (!record->colorized()) {
-        record->ensureColorized(cap_file_);
+    if (!records_.colorized(fdata->num)) {
+        records_.ensureColorized(cap_file_, fdata);
     }
 }
 
 int PacketListModel::visibleIndexOf(frame_data *fdata) const
 {
     int row = 0;
-    foreach (PacketListRecord *record, visible_rows_) {
-        if (record->frameData() == fdata) {
+    foreach (guint32 num, visible_rows_) {
+        if (num == fdata->num) {
             return row;
         }
         row++;
@@ -1012,3 +1233,10 @@ int PacketListModel::visibleIndexOf(frame_data *fdata) const
 
     return -1;
 }
+
+frame_data *PacketListModel::frameData(guint32 num) const
+{
+    if (!cap_file_ || !cap_file_->provider.frames || num == 0 || num > physical_count_)
+        return NULL;
+    return frame_data_sequence_find(cap_file_->provider.frames, num);
+}
@@ -55,8 +55,9 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
 
     gint appendPacket(frame_data *fdata);
-    frame_data *getRowFdata(QModelIndex idx);
-    frame_data *getRowFdata(int row);
+    frame_data *getRowFdata(QModelIndex idx) const;
+    frame_data *getRowFdata(int row) const;
+    unsigned int getRowConversation(int row) const;
     void ensureRowColorized(int row);
     int visibleIndexOf(frame_data *fdata) const;
     /**
@@ -93,13 +94,17 @@ public slots:
     void stopSorting();
     void flushVisibleRows();
     void dissectIdle(bool reset = false);
+    void dissectAhead(int first_row, int last_row);
 
 private:
     capture_file *cap_file_;
     QList<QString> col_names_;
-    QVector<PacketListRecord *> physical_rows_;
-    QVector<PacketListRecord *> visible_rows_;
-    QVector<PacketListRecord *> new_visible_rows_;
+    // Rows hold frame numbers. The physical rows are always frames 1
+    // to physical_count_ of cap_file_->provider.frames.
+    mutable PacketListRecords records_;
+    guint32 physical_count_;
+    QVector<guint32> visible_rows_;
+    QVector<guint32> new_visible_rows_;
     QVector<int> number_to_row_;
 
     int max_row_height_; // px
@@ -110,7 +115,28 @@ private:
     static int text_sort_column_;
     static Qt::SortOrder sort_order_;
     static capture_file *sort_cap_file_;
-    static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
+    // The text of the sort column of a row, and its value if it's numeric,
+    // taken once before sorting.
+    struct SortKey {
+        guint32 num;
+        bool numeric_ok;
+        double numeric;
+        QString text;
+    };
+    // The value of the sort column of a row, taken from the capture
+    // file's event store.
+    struct EventSortKey {
+        guint32 num;
+        bool present;
+        guint64 key;
+    };
+    static void sortBusyCheck();
+    static bool recordLessThan(guint32 num1, guint32 num2);
+    static bool sortKeyLessThan(const SortKey &k1, const SortKey &k2);
+    static bool eventSortKeyLessThan(const EventSortKey &k1, const EventSortKey &k2);
+    void sortByColumnText(QVector<guint32> &rows);
+    int eventStoreColumn(int column);
+    void sortByEventStore(QVector<guint32> &rows, int es_column);
     static double parseNumericColumn(const QString &val, bool *ok);
 
     static gboolean stop_flag_;
@@ -121,7 +147,26 @@ private:
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
+    // New rows are inserted in batches. After a batch, the next one waits
+    // for a few times as long as the view took to insert this one, so that
+    // a fast capture can't keep the event loop busy with row insertions.
+    QElapsedTimer *flush_timer_;
+    int flush_interval_;
+    bool flush_scheduled_;
+
+    // The rows around the viewport whose column strings are filled in
+    // while the application is idle: first those below the viewport, up
+    // to ahead_last_row_, then those above it, from ahead_first_row_.
+    int viewport_first_row_;
+    int viewport_last_row_;
+    int ahead_first_row_;
+    int ahead_last_row_;
+    int ahead_done_;
+    bool ahead_scheduled_;
+    void dissectAheadSlice();
+
     bool isNumericColumn(int column);
+    frame_data *frameData(guint32 num) const;
 
 private slots:
     void emitItemHeightChanged(const QModelIndex &ih_index);
@@ -24,48 +24,78 @@
 
 #include <QStringList>
 
-QCache<guint32, QStringList> PacketListRecord::col_text_cache_(500);
-QMap<int, int> PacketListRecord::cinfo_column_;
-unsigned PacketListRecord::rows_color_ver_ = 1;
-
-PacketListRecord::PacketListRecord(frame_data *frameData) :
-    fdata_(frameData),
-    lines_(1),
-    line_count_changed_(false),
-    color_ver_(0),
-    colorized_(false),
-    conv_index_(0),
-    read_failed_(false)
+QCache<guint32, QStringList> PacketListRecords::col_text_cache_(500);
+QMap<int, int> PacketListRecords::cinfo_column_;
+
+// Grow the arrays in steps, like PacketListModel::number_to_row_.
+static const int records_grow_ = 10000;
+
+PacketListRecords::PacketListRecords()
+{
+}
+
+void PacketListRecords::append(frame_data *fdata)
 {
+    int size = static_cast<int>(fdata->num) + 1;
+
+    if (colorized_.size() < size) {
+        size += records_grow_;
+        colorized_.resize(size);
+        read_failed_.resize(size);
+        multi_line_.resize(size);
+        conv_index_.resize(size);
+    }
 }
 
-PacketListRecord::~PacketListRecord()
+void PacketListRecords::clear()
 {
+    invalidateAllRecords();
+    colorized_.clear();
+    read_failed_.clear();
+    multi_line_.clear();
+    line_counts_.clear();
+    conv_index_.clear();
 }
 
-void PacketListRecord::ensureColorized(capture_file *cap_file)
+void PacketListRecords::ensureColorized(capture_file *cap_file, frame_data *fdata)
 {
     // packet_list_store.c:packet_list_get_value
-    Q_ASSERT(fdata_);
+    Q_ASSERT(fdata);
 
     if (!cap_file) {
         return;
     }
 
-    bool dissect_color = !colorized_ || ( color_ver_ != rows_color_ver_ );
+    bool dissect_color = !colorized(fdata->num);
     if (dissect_color) {
         /* Dissect columns only if it won't evict anything from cache */
         bool dissect_columns = col_text_cache_.totalCost() < col_text_cache_.maxCost();
-        dissect(cap_file, dissect_columns, dissect_color);
+        dissect(cap_file, fdata, dissect_columns, dissect_color);
+    }
+}
+
+void PacketListRecords::ensureColumnStrings(capture_file *cap_file, frame_data *fdata)
+{
+    Q_ASSERT(fdata);
+
+    if (!cap_file || col_text_cache_.contains(fdata->num)) {
+        return;
     }
+
+    dissect(cap_file, fdata, true, !colorized(fdata->num));
+}
+
+int PacketListRecords::maxCache()
+{
+    return static_cast<int>(col_text_cache_.maxCost());
 }
 
 // We might want to return a const char * instead. This would keep us from
 // creating excessive QByteArrays, e.g. in PacketListModel::recordLessThan.
-const QString PacketListRecord::columnString(capture_file *cap_file, int column, bool colorized)
+const QString PacketListRecords::columnString(capture_file *cap_file, frame_data *fdata, int column, bool colorized)
 {
     // packet_list_store.c:packet_list_get_value
-    Q_ASSERT(fdata_);
+    Q_ASSERT(fdata);
 
     if (!cap_file || column < 0 || column >= cap_file->cinfo.num_cols) {
         return QString();
@@ -76,20 +106,20 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     // have the ensureColorized() method to ensure that the record is
     // properly colorized?
     //
-    bool dissect_color = ( colorized && !colorized_ ) || ( color_ver_ != rows_color_ver_ );
+    bool dissect_color = colorized && !this->colorized(fdata->num);
     QStringList *col_text = nullptr;
     if (!dissect_color) {
-        col_text = col_text_cache_.object(fdata_->num);
+        col_text = col_text_cache_.object(fdata->num);
     }
     if (col_text == nullptr || column >= col_text->count() || col_text->at(column).isNull()) {
-        dissect(cap_file, true, dissect_color);
-        col_text = col_text_cache_.object(fdata_->num);
+        dissect(cap_file, fdata, true, dissect_color);
+        col_text = col_text_cache_.object(fdata->num);
     }
 
     return col_text ? col_text->at(column) : QString();
 }
 
-void PacketListRecord::resetColumns(column_info *cinfo)
+void PacketListRecords::resetColumns(column_info *cinfo)
 {
     invalidateAllRecords();
 
@@ -107,7 +137,7 @@ void PacketListRecord::resetColumns(column_info *cinfo)
     }
 }
 
-void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color)
+void PacketListRecords::dissect(capture_file *cap_file, frame_data *fdata, bool dissect_columns, bool dissect_color)
 {
     // packet_list_store.c:packet_list_dissect_and_cache_record
     epan_dissect_t edt;
@@ -126,13 +156,15 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, boo
 
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
-    if (read_failed_) {
-        read_failed_ = !cf_read_record_no_alert(cap_file, fdata_, &rec, &buf);
+    bool read_failed;
+    if (read_failed_.testBit(fdata->num)) {
+        read_failed = !cf_read_record_no_alert(cap_file, fdata, &rec, &buf);
     } else {
-        read_failed_ = !cf_read_record(cap_file, fdata_, &rec, &buf);
+        read_failed = !cf_read_record(cap_file, fdata, &rec, &buf);
     }
+    read_failed_.setBit(fdata->num, read_failed);
 
-    if (read_failed_) {
+    if (read_failed) {
         /*
          * Error reading the record.
          *
@@ -144,13 +176,13 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, boo
          * error message.
          */
         if (dissect_columns) {
-            col_fill_in_error(cinfo, fdata_, FALSE, FALSE /* fill_fd_columns */);
+            col_fill_in_error(cinfo, fdata, FALSE, FALSE /* fill_fd_columns */);
 
-            cacheColumnStrings(cinfo);
+            cacheColumnStrings(cinfo, fdata);
         }
         if (dissect_color) {
-            fdata_->color_filter = NULL;
-            colorized_ = true;
+            fdata->color_filter = NULL;
+            colorized_.setBit(fdata->num);
         }
         ws_buffer_free(&buf);
         wtap_rec_cleanup(&rec);
@@ -180,7 +212,7 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, boo
     /* Re-color when the coloring rules are changed via the UI. */
     if (dissect_color) {
         color_filters_prime_edt(&edt);
-        fdata_->need_colorize = 1;
+        fdata->need_colorize = 1;
     }
     if (dissect_columns)
         col_custom_prime_edt(&edt, cinfo);
@@ -190,29 +222,28 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, boo
      * attempt to recover from it.
      */
     epan_dissect_run(&edt, cap_file->cd_t, &rec,
-                     frame_tvbuff_new_buffer(&cap_file->provider, fdata_, &buf),
-                     fdata_, cinfo);
+                     frame_tvbuff_new_buffer(&cap_file->provider, fdata, &buf),
+                     fdata, cinfo);
 
     if (dissect_columns) {
         /* "Stringify" non frame_data vals */
         epan_dissect_fill_in_columns(&edt, FALSE, FALSE /* fill_fd_columns */);
-        cacheColumnStrings(cinfo);
+        cacheColumnStrings(cinfo, fdata);
     }
 
     if (dissect_color) {
-        colorized_ = true;
-        color_ver_ = rows_color_ver_;
+        colorized_.setBit(fdata->num);
     }
 
     struct conversation * conv = find_conversation_pinfo(&edt.pi, 0);
-    conv_index_ = ! conv ? 0 : conv->conv_index;
+    conv_index_[fdata->num] = ! conv ? 0 : conv->conv_index;
 
     epan_dissect_cleanup(&edt);
     ws_buffer_free(&buf);
     wtap_rec_cleanup(&rec);
 }
 
-void PacketListRecord::cacheColumnStrings(column_info *cinfo)
+void PacketListRecords::cacheColumnStrings(column_info *cinfo, frame_data *fdata)
 {
     // packet_list_store.c:packet_list_change_record(PacketList *packet_list, PacketListRecord *record, gint col, column_info *cinfo)
     if (!cinfo) {
@@ -221,8 +252,8 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
 
     QStringList *col_text = new QStringList();
 
-    lines_ = 1;
-    line_count_changed_ = false;
+    int lines = 1;
+    bool line_count_changed = false;
 
     for (int column = 0; column < cinfo->num_cols; ++column) {
         int col_lines = 1;
@@ -230,17 +261,24 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         QString col_str;
         int text_col = cinfo_column_.value(column, -1);
         if (text_col < 0) {
-            col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
+            col_fill_in_frame_data(fdata, cinfo, column, FALSE);
         }
 
         col_str = QString(get_column_text(cinfo, column));
         *col_text << col_str;
         col_lines = static_cast<int>(col_str.count('\n'));
-        if (col_lines > lines_) {
-            lines_ = col_lines;
-            line_count_changed_ = true;
+        if (col_lines > lines) {
+            lines = col_lines;
+            line_count_changed = true;
         }
     }
 
-    col_text_cache_.insert(fdata_->num, col_text);
+    multi_line_.setBit(fdata->num, line_count_changed);
+    if (line_count_changed) {
+        line_counts_.insert(fdata->num, lines);
+    } else {
+        line_counts_.remove(fdata->num);
+    }
+
+    col_text_cache_.insert(fdata->num, col_text);
 }
@@ -19,66 +19,73 @@
 #include <epan/column.h>
 #include <epan/packet.h>
 
+#include <QBitArray>
 #include <QByteArray>
 #include <QCache>
+#include <QHash>
 #include <QList>
 #include <QVariant>
+#include <QVector>
 
 struct conversation;
 struct _GStringChunk;
 
-class PacketListRecord
+/*
+ * The packet list state of every frame, kept in arrays indexed by frame
+ * number instead of in an object per frame. Frames which need more than
+ * one line are rare, so their line counts are kept in a hash.
+ */
+class PacketListRecords
 {
 public:
-    PacketListRecord(frame_data *frameData);
-    virtual ~PacketListRecord();
+    PacketListRecords();
+
+    // Make room for the state of fdata.
+    void append(frame_data *fdata);
+    void clear();
 
     // Ensure that the record is colorized.
-    void ensureColorized(capture_file *cap_file);
+    void ensureColorized(capture_file *cap_file, frame_data *fdata);
+    // Ensure that the column strings are cached.
+    void ensureColumnStrings(capture_file *cap_file, frame_data *fdata);
     // Return the string value for a column. Data is cached if possible.
-    const QString columnString(capture_file *cap_file, int column, bool colorized = false);
-    frame_data *frameData() const { return fdata_; }
+    const QString columnString(capture_file *cap_file, frame_data *fdata, int column, bool colorized = false);
     // packet_list->col_to_text in gtk/packet_list_store.c
     static int textColumn(int column) { return cinfo_column_.value(column, -1); }
-    bool colorized() { return colorized_ && (color_ver_ == rows_color_ver_); }
-    unsigned int conversation() { return conv_index_; }
-
-    int columnTextSize(const char *str);
+    bool colorized(guint32 num) const { return num < static_cast<guint32>(colorized_.size()) && colorized_.testBit(num); }
+    unsigned int conversation(guint32 num) const { return conv_index_.value(num); }
 
-    void invalidateColorized() { colorized_ = false; }
-    void invalidateRecord() { col_text_cache_.remove(fdata_->num); }
+    void invalidateColorized(guint32 num) { if (num < static_cast<guint32>(colorized_.size())) colorized_.clearBit(num); }
+    static void invalidateRecord(guint32 num) { col_text_cache_.remove(num); }
     static void invalidateAllRecords() { col_text_cache_.clear(); }
     /* In Qt 6, QCache maxCost is a qsizetype, but the QAbstractItemModel
      * number of rows is still an int, so we're limited to INT_MAX anyway.
      */
     static void setMaxCache(int cost) { col_text_cache_.setMaxCost(cost); }
+    static int maxCache();
     static void resetColumns(column_info *cinfo);
-    static void resetColorization() { rows_color_ver_++; }
+    void resetColorization() { colorized_.fill(false); }
 
-    inline int lineCount() { return lines_; }
-    inline int lineCountChanged() { return line_count_changed_; }
+    inline int lineCount(guint32 num) const { return lineCountChanged(num) ? line_counts_.value(num, 1) : 1; }
+    inline bool lineCountChanged(guint32 num) const { return num < static_cast<guint32>(multi_line_.size()) && multi_line_.testBit(num); }
 
 private:
     /** The column text for some columns */
     static QCache<guint32, QStringList> col_text_cache_;
-
-    frame_data *fdata_;
-    int lines_;
-    bool line_count_changed_;
     static QMap<int, int> cinfo_column_;
 
     /** Has this record been colorized? */
-    static unsigned int rows_color_ver_;
-    unsigned int color_ver_;
-    bool colorized_;
+    QBitArray colorized_;
+    QBitArray read_failed_;
+    /** Does this record need more than one line? */
+    QBitArray multi_line_;
+    QHash<guint32, int> line_counts_;
 
     /** Conversation. Used by RelatedPacketDelegate */
-    unsigned int conv_index_;
-
-    bool read_failed_;
+    QVector<unsigned int> conv_index_;
 
-    void dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color = false);
-    void cacheColumnStrings(column_info *cinfo);
+    void dissect(capture_file *cap_file, frame_data *fdata, bool dissect_columns, bool dissect_color = false);
+    void cacheColumnStrings(column_info *cinfo, frame_data *fdata);
 };
 
 #endif // PACKET_LIST_RECORD_H
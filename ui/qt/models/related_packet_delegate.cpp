@@ -8,7 +8,7 @@
  */
 
 #include <ui/qt/models/related_packet_delegate.h>
-#include "packet_list_record.h"
+#include "packet_list_model.h"
 
 #include <ui/qt/main_application.h>
 
@@ -80,8 +80,8 @@ void RelatedPacketDelegate::paint(QPainter *painter, const QStyleOptionViewItem
     }
 
     const frame_data *fd;
-    PacketListRecord *record = static_cast<PacketListRecord*>(index.internalPointer());
-    if (!record || (fd = record->frameData()) == NULL) {
+    const PacketListModel *model = qobject_cast<const PacketListModel *>(index.model());
+    if (!model || (fd = model->getRowFdata(index.row())) == NULL) {
         return;
     }
 
@@ -94,7 +94,7 @@ void RelatedPacketDelegate::paint(QPainter *painter, const QStyleOptionViewItem
             conversation_trace_type = CT_STARTING;
         } else if (fd->num > setup_frame && fd->num < last_frame) {
             conversation_trace_type =
-                conv_->conv_index == record->conversation() ?  CT_CONTINUING : CT_BYPASSING;
+                conv_->conv_index == model->getRowConversation(index.row()) ?  CT_CONTINUING : CT_BYPASSING;
         } else if (fd->num == last_frame) {
             conversation_trace_type = CT_ENDING;
         }
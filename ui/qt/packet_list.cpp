@@ -278,7 +278,7 @@ PacketList::PacketList(QWidget *parent) :
          * are ints, not unsigned ints, so we're limited to INT_MAX
          * rows anyway.
          */
-        PacketListRecord::setMaxCache(prefs.gui_packet_list_cached_rows_max > INT_MAX ? INT_MAX : prefs.gui_packet_list_cached_rows_max);
+        PacketListRecords::setMaxCache(prefs.gui_packet_list_cached_rows_max > INT_MAX ? INT_MAX : prefs.gui_packet_list_cached_rows_max);
         if ((bool) (prefs.gui_packet_list_sortable) != isSortingEnabled()) {
             setSortingEnabled(prefs.gui_packet_list_sortable);
         }
@@ -813,6 +813,16 @@ void PacketList::paintEvent(QPaintEvent *event)
     // resizing, etc.
     create_near_overlay_ = true;
     QTreeView::paintEvent(event);
+
+    // Get the rows around the ones just painted ready.
+    if (packet_list_model_) {
+        QModelIndex first_idx = indexAt(viewport()->rect().topLeft());
+        QModelIndex last_idx = indexAt(viewport()->rect().bottomLeft());
+        if (first_idx.isValid()) {
+            int last_row = last_idx.isValid() ? last_idx.row() : packet_list_model_->rowCount() - 1;
+            packet_list_model_->dissectAhead(first_idx.row(), last_row);
+        }
+    }
 }
 
 void PacketList::mousePressEvent (QMouseEvent *event)
@@ -481,16 +481,20 @@ void ProtoTree::foreachTreeNode(proto_node *node, gpointer proto_tree_ptr)
 void ProtoTree::foreachExpand(const QModelIndex &index = QModelIndex()) {
 
     // Restore expanded state. (Note QModelIndex() refers to the root node)
+    // Only descend into items that end up expanded; the rest of the tree
+    // is restored by syncExpanded when its parent is expanded, so large
+    // collapsed subtrees are never walked.
     int children = proto_tree_model_->rowCount(index);
     QModelIndex childIndex;
     for (int child = 0; child < children; child++) {
         childIndex = proto_tree_model_->index(child, 0, index);
-        if (childIndex.isValid()) {
+        if (childIndex.isValid() && !isExpanded(childIndex)) {
             ProtoNode *node = proto_tree_model_->protoNodeFromIndex(childIndex);
-            if (node && node->isValid() && tree_expanded(node->protoNode()->finfo->tree_type)) {
+            if (node && node->isValid() && node->childrenCount() > 0 &&
+                    tree_expanded(node->protoNode()->finfo->tree_type)) {
                 expand(childIndex);
+                foreachExpand(childIndex);
             }
-            foreachExpand(childIndex);
         }
     }
 }
@@ -573,6 +577,9 @@ void ProtoTree::syncExpanded(const QModelIndex &index) {
     if (finfo.treeType() != -1) {
         tree_expanded_set(finfo.treeType(), TRUE);
     }
+
+    // Subtrees below a collapsed item are skipped by setRootNode.
+    foreachExpand(index);
 }
 
 void ProtoTree::syncCollapsed(const QModelIndex &index) {
@@ -9,6 +9,8 @@
 
 #include "rtp_audio_stream.h"
 
+#include <vector>
+
 #ifdef QT_MULTIMEDIA_LIB
 
 #include <speex/speex_resampler.h>
@@ -250,6 +252,9 @@ quint32 RtpAudioStream::calculateAudioOutRate(QAudioDeviceInfo out_device, unsig
     return out_rate;
 }
 
+// A batch of 20 ms G.711 packets at 8 kHz fits in the initial buffer.
+#define DECODE_BATCH_PACKETS (64)
+#define DECODE_BATCH_BUFF_BYTES (0x10000)
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
 void RtpAudioStream::decodeAudio(QAudioDevice out_device)
 #else
@@ -278,11 +283,36 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
     unsigned int audio_resampler_input_rate = 0;
     struct SpeexResamplerState_ *audio_resampler = NULL;
 
+    // Packets are decoded in batches into one buffer, which is reused,
+    // rather than one allocation and codec call each.
+    gint32 batch_buff_bytes = DECODE_BATCH_BUFF_BYTES;
+    SAMPLE *batch_buff = (SAMPLE *) g_malloc(batch_buff_bytes);
+    std::vector<size_t> batch_decoded_bytes(DECODE_BATCH_PACKETS);
+    int batch_start = 0;
+    int batch_end = 0;
+    size_t batch_offset = 0;
+
     for (int cur_packet = 0; cur_packet < rtp_packets_.size(); cur_packet++) {
-        SAMPLE *decode_buff = NULL;
         // TODO: Update a progress bar here.
         rtp_packet_t *rtp_packet = rtp_packets_[cur_packet];
 
+        if (cur_packet >= batch_end) {
+            size_t count = qMin<size_t>(DECODE_BATCH_PACKETS, rtp_packets_.size() - cur_packet);
+            size_t handled;
+
+            while ((handled = decode_rtp_packets(rtp_packets_.data() + cur_packet, count,
+                                                 batch_buff, batch_buff_bytes, batch_decoded_bytes.data(),
+                                                 decoders_hash_, &channels, &sample_rate)) == 0) {
+                batch_buff = resizeBufferIfNeeded(batch_buff, &batch_buff_bytes, batch_decoded_bytes[0]);
+            }
+            batch_start = cur_packet;
+            batch_end = cur_packet + static_cast<int>(handled);
+            batch_offset = 0;
+        }
+        SAMPLE *decode_buff = (SAMPLE *) ((char *) batch_buff + batch_offset);
+        size_t decoded_bytes = batch_decoded_bytes[cur_packet - batch_start];
+        batch_offset += decoded_bytes;
+
         stop_rel_time_ = start_rel_time_ + rtp_packet->arrive_offset;
 
         QString payload_name;
@@ -302,7 +332,6 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
             last_sequence = rtp_packet->info->info_extended_seq_num - 1;
         }
 
-        size_t decoded_bytes = decode_rtp_packet(rtp_packet, &decode_buff, decoders_hash_, &channels, &sample_rate);
         // XXX: We don't actually *do* anything with channels, and just treat
         // everything as if it were mono
 
@@ -323,7 +352,6 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
             // We didn't decode anything. Clean up and prep for
             // the next packet.
             last_sequence = rtp_packet->info->info_extended_seq_num;
-            g_free(decode_buff);
             continue;
         }
 
@@ -458,9 +486,8 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
             audio_file_->frameWriteSamples(rtp_packet->frame_num, write_buff, write_bytes);
             last_sequence_w = last_sequence;
         }
-
-        g_free(decode_buff);
     }
+    g_free(batch_buff);
     g_free(resample_buff);
 
     if (audio_resampler) speex_resampler_destroy(audio_resampler);
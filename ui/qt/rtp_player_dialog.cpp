@@ -23,6 +23,7 @@
 #ifdef QT_MULTIMEDIA_LIB
 
 #include <epan/dissectors/packet-rtp.h>
+#include <epan/rtp_pt.h>
 #include <epan/to_str.h>
 
 #include <wsutil/report_message.h>
@@ -59,6 +60,7 @@
 #endif // QT_MULTIMEDIA_LIB
 
 #include <QPushButton>
+#include <QtConcurrent>
 #include <QToolButton>
 
 #include <ui/qt/utils/stock_icon.h>
@@ -488,6 +490,8 @@ void RtpPlayerDialog::rescanPackets(bool rescale_axes)
 #endif
     int row_count = ui->streamTreeWidget->topLevelItemCount();
 
+    QList<RtpAudioStream *> decode_streams;
+
     // Reset stream values
     for (int row = 0; row < row_count; row++) {
         QTreeWidgetItem *ti = ui->streamTreeWidget->topLevelItem(row);
@@ -510,10 +514,24 @@ void RtpPlayerDialog::rescanPackets(bool rescale_axes)
         }
         audio_stream->setTimingMode(timing_mode);
 
-	       //if (!cur_out_device.isNull()) {
-            audio_stream->decode(cur_out_device);
-        //}
+        decode_streams << audio_stream;
+    }
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    // Each stream has its own decoders, resamplers and audio file, so
+    // they can be decoded in parallel. (Qt 5's QAudioDeviceInfo, used to
+    // pick the output rate, queries the backend and isn't safe to use
+    // off the GUI thread.)
+    // The payload type name lookup initializes its table on first use.
+    try_val_to_str_ext(PT_PCMU, &rtp_payload_type_short_vals_ext);
+    QtConcurrent::blockingMap(decode_streams, [cur_out_device](RtpAudioStream *audio_stream) {
+        audio_stream->decode(cur_out_device);
+    });
+#else
+    foreach (RtpAudioStream *audio_stream, decode_streams) {
+        audio_stream->decode(cur_out_device);
     }
+#endif
 
     for (int col = 0; col < ui->streamTreeWidget->columnCount() - 1; col++) {
         ui->streamTreeWidget->resizeColumnToContents(col);
@@ -27,29 +27,15 @@ const int max_comment_em_width_ = 20;
 // UML-like network node sequence diagrams.
 // https://developer.ibm.com/articles/the-sequence-diagram/
 
-WSCPSeqData::WSCPSeqData() :
-  key(0),
-  value(NULL)
-{
-}
-
-WSCPSeqData::WSCPSeqData(double key, struct _seq_analysis_item *value) :
-  key(key),
-  value(value)
-{
-}
-
 SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *commentAxis) :
     QCPAbstractPlottable(keyAxis, valueAxis),
     key_axis_(keyAxis),
     value_axis_(valueAxis),
     comment_axis_(commentAxis),
-    data_(NULL),
     sainfo_(NULL),
     selected_packet_(0),
     selected_key_(-1.0)
 {
-    data_ = new WSCPSeqDataMap();
     // xaxis (value): Address
     // yaxis (key): Time
     // yaxis2 (comment): Extra info ("Comment" in GTK+)
@@ -87,51 +73,42 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
 
 //    setTickVectorLabels
     //    valueAxis->setTickLabelRotation(30);
+
+    connect(key_axis_, SIGNAL(rangeChanged(QCPRange)), this, SLOT(updateKeyTicks()));
 }
 
 SequenceDiagram::~SequenceDiagram()
 {
-    delete data_;
 }
 
 int SequenceDiagram::adjacentPacket(bool next)
 {
     int adjacent_packet = -1;
-    WSCPSeqDataMap::const_iterator it;
+    int count = static_cast<int>(items_.size());
 
-    if (data_->size() < 1) return adjacent_packet;
+    if (count < 1) return adjacent_packet;
 
     if (selected_packet_ < 1) {
-        if (next) {
-            it = data_->constBegin();
-        } else {
-            it = data_->constEnd();
-            --it;
-        }
-        selected_key_ = it.value().key;
-        return it.value().value->frame_number;
+        int key = next ? 0 : count - 1;
+        selected_key_ = key;
+        return items_[key]->frame_number;
     }
 
     if (next) {
-        for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-            if (it.value().value->frame_number == selected_packet_) {
-                ++it;
-                if (it != data_->constEnd()) {
-                    adjacent_packet = it.value().value->frame_number;
-                    selected_key_ = it.value().key;
+        for (int key = 0; key < count; key++) {
+            if (items_[key]->frame_number == selected_packet_) {
+                if (key + 1 < count) {
+                    adjacent_packet = items_[key + 1]->frame_number;
+                    selected_key_ = key + 1;
                 }
                 break;
             }
         }
     } else {
-        it = data_->constEnd();
-        --it;
-        while (it != data_->constBegin()) {
-            guint32 prev_frame = it.value().value->frame_number;
-            --it;
-            if (prev_frame == selected_packet_) {
-                adjacent_packet = it.value().value->frame_number;
-                selected_key_ = it.value().key;
+        for (int key = count - 1; key > 0; key--) {
+            if (items_[key]->frame_number == selected_packet_) {
+                adjacent_packet = items_[key - 1]->frame_number;
+                selected_key_ = key - 1;
                 break;
             }
         }
@@ -142,34 +119,22 @@ int SequenceDiagram::adjacentPacket(bool next)
 
 void SequenceDiagram::setData(_seq_analysis_info *sainfo)
 {
-    data_->clear();
+    items_.clear();
     sainfo_ = sainfo;
     if (!sainfo) return;
 
-    double cur_key = 0.0;
-    QVector<double> key_ticks, val_ticks;
-    QVector<QString> key_labels, val_labels, com_labels;
-    QFontMetrics com_fm(comment_axis_->tickLabelFont());
-    int elide_w = com_fm.height() * max_comment_em_width_;
+    QVector<double> val_ticks;
+    QVector<QString> val_labels;
     char* addr_str;
 
+    items_.reserve(g_queue_get_length(sainfo->items));
     for (GList *cur = g_queue_peek_nth_link(sainfo->items, 0); cur; cur = gxx_list_next(cur)) {
         seq_analysis_item_t *sai = gxx_list_data(seq_analysis_item_t *, cur);
         if (sai->display) {
-            WSCPSeqData new_data;
-
-            new_data.key = cur_key;
-            new_data.value = sai;
-            data_->insert(new_data.key, new_data);
-
-            key_ticks.append(cur_key);
-            key_labels.append(sai->time_str);
-
-            com_labels.append(com_fm.elidedText(sai->comment, Qt::ElideRight, elide_w));
-
-            cur_key++;
+            items_.append(sai);
         }
     }
+    items_.squeeze();
 
     for (unsigned int i = 0; i < sainfo_->num_nodes; i++) {
         val_ticks.append(i);
@@ -182,10 +147,34 @@ void SequenceDiagram::setData(_seq_analysis_info *sainfo)
         wmem_free(Q_NULLPTR, addr_str);
     }
 
-    QSharedPointer<QCPAxisTickerText> key_ticker = qSharedPointerCast<QCPAxisTickerText>(keyAxis()->ticker());
-    key_ticker->setTicks(key_ticks, key_labels);
     QSharedPointer<QCPAxisTickerText> value_ticker = qSharedPointerCast<QCPAxisTickerText>(valueAxis()->ticker());
     value_ticker->setTicks(val_ticks, val_labels);
+    updateKeyTicks();
+}
+
+// Time and comment labels are only made for the items in view (plus a
+// screenful on either side), so that a flow with millions of items
+// doesn't need a label, and an elided comment, for each of them.
+void SequenceDiagram::updateKeyTicks()
+{
+    QVector<double> key_ticks;
+    QVector<QString> key_labels, com_labels;
+    QFontMetrics com_fm(comment_axis_->tickLabelFont());
+    int elide_w = com_fm.height() * max_comment_em_width_;
+    QCPRange range = key_axis_->range();
+    int count = static_cast<int>(items_.size());
+
+    int first = qMax(0, static_cast<int>(range.lower - range.size()));
+    int last = qMin(count - 1, static_cast<int>(range.upper + range.size()) + 1);
+    for (int key = first; key <= last; key++) {
+        seq_analysis_item_t *sai = items_[key];
+        key_ticks.append(key);
+        key_labels.append(sai->time_str);
+        com_labels.append(com_fm.elidedText(sai->comment, Qt::ElideRight, elide_w));
+    }
+
+    QSharedPointer<QCPAxisTickerText> key_ticker = qSharedPointerCast<QCPAxisTickerText>(keyAxis()->ticker());
+    key_ticker->setTicks(key_ticks, key_labels);
     QSharedPointer<QCPAxisTickerText> comment_ticker = qSharedPointerCast<QCPAxisTickerText>(comment_axis_->ticker());
     comment_ticker->setTicks(key_ticks, com_labels);
 }
@@ -195,6 +184,12 @@ void SequenceDiagram::setSelectedPacket(int selected_packet)
     selected_key_ = -1;
     if (selected_packet > 0) {
         selected_packet_ = selected_packet;
+        for (int key = 0; key < items_.size(); key++) {
+            if (items_[key]->frame_number == selected_packet_) {
+                selected_key_ = key;
+                break;
+            }
+        }
     } else {
         selected_packet_ = 0;
     }
@@ -205,8 +200,8 @@ _seq_analysis_item *SequenceDiagram::itemForPosY(int ypos)
 {
     double key_pos = qRound(key_axis_->pixelToCoord(ypos));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
-        return data_->value(key_pos).value;
+    if (key_pos >= 0 && key_pos < items_.size()) {
+        return items_[static_cast<int>(key_pos)];
     }
     return NULL;
 }
@@ -215,7 +210,7 @@ double SequenceDiagram::selectTest(const QPointF &pos, bool, QVariant *) const
 {
     double key_pos = qRound(key_axis_->pixelToCoord(pos.y()));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
+    if (key_pos >= 0 && key_pos < items_.size()) {
         return 1.0;
     }
 
@@ -243,10 +238,13 @@ void SequenceDiagram::draw(QCPPainter *painter)
     painter->restore();
     fg_pen = pen();
 
-    WSCPSeqDataMap::const_iterator it;
-    for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-        double cur_key = it.key();
-        seq_analysis_item_t *sai = it.value().value;
+    // Only the items that can be seen, including the ones whose
+    // background is partly in view.
+    int first_key = qMax(0, static_cast<int>(key_axis_->range().lower));
+    int last_key = qMin(static_cast<int>(items_.size()) - 1, static_cast<int>(key_axis_->range().upper) + 1);
+    for (int key = first_key; key <= last_key; key++) {
+        double cur_key = key;
+        seq_analysis_item_t *sai = items_[key];
         QColor bg_color;
 
         if (sai->frame_number == selected_packet_) {
@@ -359,22 +357,12 @@ void SequenceDiagram::drawLegendIcon(QCPPainter *, const QRectF &) const
 QCPRange SequenceDiagram::getKeyRange(bool &validRange, QCP::SignDomain) const
 {
     QCPRange range;
-    bool valid = false;
 
-    WSCPSeqDataMap::const_iterator it = data_->constBegin();
-    while (it != data_->constEnd()) {
-        double cur_key = it.key();
-        if (!valid) {
-            range.lower = range.upper = cur_key;
-            valid = true;
-        } else if (cur_key < range.lower) {
-            range.lower = cur_key;
-        } else if (cur_key > range.upper) {
-            range.upper = cur_key;
-        }
-        ++it;
+    validRange = !items_.isEmpty();
+    if (validRange) {
+        range.lower = 0;
+        range.upper = items_.size() - 1;
     }
-    validRange = valid;
     return range;
 }
 
@@ -385,7 +373,7 @@ QCPRange SequenceDiagram::getValueRange(bool &validRange, QCP::SignDomain, const
 
     if (sainfo_) {
         range.lower = 0;
-        range.upper = data_->size();
+        range.upper = items_.size();
         valid = true;
     }
     validRange = valid;
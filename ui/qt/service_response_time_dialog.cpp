@@ -92,6 +92,9 @@ public:
         setText(SRT_COLUMN_MAX, QString::number(nstime_to_sec(&procedure_->stats.max), 'f', 6));
         setText(SRT_COLUMN_AVG, QString::number(get_average(&procedure_->stats.tot, procedure_->stats.num) / 1000.0, 'f', 6));
         setText(SRT_COLUMN_SUM, QString::number(nstime_to_sec(&procedure_->stats.tot), 'f', 6));
+        setText(SRT_COLUMN_P50, QString::number(quantile(0.5), 'f', 6));
+        setText(SRT_COLUMN_P99, QString::number(quantile(0.99), 'f', 6));
+        setText(SRT_COLUMN_P999, QString::number(quantile(0.999), 'f', 6));
 
         for (int col = 0; col < columnCount(); col++) {
             if (col == SRT_COLUMN_PROCEDURE) continue;
@@ -123,6 +126,12 @@ public:
         }
         case SRT_COLUMN_SUM:
             return nstime_cmp(&procedure_->stats.tot, &other_row->procedure_->stats.tot) < 0;
+        case SRT_COLUMN_P50:
+            return quantile(0.5) < other_row->quantile(0.5);
+        case SRT_COLUMN_P99:
+            return quantile(0.99) < other_row->quantile(0.99);
+        case SRT_COLUMN_P999:
+            return quantile(0.999) < other_row->quantile(0.999);
         default:
             break;
         }
@@ -133,10 +142,17 @@ public:
         return QList<QVariant>() << QString(procedure_->procedure) << procedure_->proc_index << procedure_->stats.num
                                  << nstime_to_sec(&procedure_->stats.min) << nstime_to_sec(&procedure_->stats.max)
                                  << get_average(&procedure_->stats.tot, procedure_->stats.num) / 1000.0
-                                 << nstime_to_sec(&procedure_->stats.tot);
+                                 << nstime_to_sec(&procedure_->stats.tot)
+                                 << quantile(0.5) << quantile(0.99) << quantile(0.999);
     }
 private:
     const srt_procedure_t *procedure_;
+
+    double quantile(double q) const {
+        nstime_t result;
+        get_srt_procedure_quantile(procedure_, q, &result);
+        return nstime_to_sec(&result);
+    }
 };
 
 class SrtTableTreeWidgetItem : public QTreeWidgetItem
@@ -26,6 +26,7 @@
 #include "main_application.h"
 #include "ui/qt/widgets/wireshark_file_dialog.h"
 
+#include <QBitArray>
 #include <QCursor>
 #include <QDir>
 #include <QIcon>
@@ -353,6 +354,7 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, capture_file *cf, tcp_graph_ty
     connect(sp, SIGNAL(axisClick(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)),
             this, SLOT(axisClicked(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)));
     connect(sp->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(transformYRange(QCPRange)));
+    connect(sp, SIGNAL(beforeReplot()), this, SLOT(decimateSegmentBars()));
     this->setResult(QDialog::Accepted);
 }
 
@@ -751,6 +753,11 @@ void TCPStreamDialog::resetAxes()
     y_axis_xfrm_.reset();
     double pixel_pad = 10.0; // per side
 
+    // Rescale to every segment, not just the ones in the old view.
+    restoreSegmentBars(seg_graph_, seg_eb_, seg_bars_);
+    restoreSegmentBars(sack_graph_, sack_eb_, sack_bars_);
+    restoreSegmentBars(sack2_graph_, sack2_eb_, sack2_bars_);
+
     sp->rescaleAxes(true);
 //    tput_graph_->rescaleValueAxis(false, true);
 //    base_graph_->rescaleAxes(false, true);
@@ -898,12 +905,13 @@ void TCPStreamDialog::fillTcptrace()
     }
     base_graph_->setData(pkt_time, pkt_seqnums, true);
     ack_graph_->setData(ackrwin_time, ack, true);
-    seg_graph_->setData(sb_time, sb_center, true);
-    seg_eb_->setData(sb_span);
-    sack_graph_->setData(sack_time, sack_center, true);
-    sack_eb_->setData(sack_span);
-    sack2_graph_->setData(sack2_time, sack2_center, true);
-    sack2_eb_->setData(sack2_span);
+    seg_bars_ = { sb_time, sb_center, sb_span, true };
+    restoreSegmentBars(seg_graph_, seg_eb_, seg_bars_);
+    sack_bars_ = { sack_time, sack_center, sack_span, true };
+    restoreSegmentBars(sack_graph_, sack_eb_, sack_bars_);
+    sack2_bars_ = { sack2_time, sack2_center, sack2_span, true };
+    restoreSegmentBars(sack2_graph_, sack2_eb_, sack2_bars_);
+    lod_range_ = QRectF();
     rwin_graph_->setData(ackrwin_time, rwin, true);
     dup_ack_graph_->setData(dup_ack_time, dup_ack, true);
     zero_win_graph_->setData(zero_win_time, zero_win, true);
@@ -1842,6 +1850,100 @@ void TCPStreamDialog::transformYRange(const QCPRange &y_range1)
     sp->yAxis2->setRangeLower(yp2.y1());
 }
 
+// Each segment and SACK block is an error bar, and QCPErrorBars draws
+// every bar in view. Unlike QCPGraph it has no adaptive sampling, so
+// a long stream seen whole draws millions of overlapping lines. Draw the
+// bars from a copy reduced to the pixels they cover instead, and go back
+// to the real segments once few enough of them are in view.
+void TCPStreamDialog::decimateSegmentBars()
+{
+    QCustomPlot *sp = ui->streamPlot;
+
+    if (!seg_eb_->visible()) return;
+
+    QCPRange x_range = sp->xAxis->range();
+    QCPRange y_range = sp->yAxis->range();
+    QRectF range(x_range.lower, y_range.lower, x_range.size(), y_range.size());
+    QSize size = sp->xAxis->axisRect()->size();
+    if (range == lod_range_ && size == lod_size_) return;
+    lod_range_ = range;
+    lod_size_ = size;
+
+    setSegmentBars(seg_graph_, seg_eb_, seg_bars_);
+    setSegmentBars(sack_graph_, sack_eb_, sack_bars_);
+    setSegmentBars(sack2_graph_, sack2_eb_, sack2_bars_);
+}
+
+void TCPStreamDialog::restoreSegmentBars(QCPGraph *graph, QCPErrorBars *error_bars, SegmentBars &bars)
+{
+    if (!bars.decimated) return;
+
+    graph->setData(bars.time, bars.center, true);
+    error_bars->setData(bars.span);
+    bars.decimated = false;
+}
+
+void TCPStreamDialog::setSegmentBars(QCPGraph *graph, QCPErrorBars *error_bars, SegmentBars &bars)
+{
+    int width = lod_size_.width();
+    int height = lod_size_.height();
+    double x_lower = lod_range_.left();
+    double x_size = lod_range_.width();
+    double y_lower = lod_range_.top();
+    double y_size = lod_range_.height();
+
+    if (width < 1 || height < 1 || x_size <= 0.0 || y_size <= 0.0) {
+        restoreSegmentBars(graph, error_bars, bars);
+        return;
+    }
+
+    // Mark the pixels covered by each bar in view, column by column.
+    QBitArray pixels(width * height);
+    int in_view = 0;
+    for (int i = 0; i < bars.time.size(); i++) {
+        double x = (bars.time[i] - x_lower) / x_size;
+        double y_lo = (bars.center[i] - bars.span[i] - y_lower) / y_size;
+        double y_hi = (bars.center[i] + bars.span[i] - y_lower) / y_size;
+        if (x < 0.0 || x > 1.0 || y_hi < 0.0 || y_lo > 1.0) continue;
+
+        int col = qMin(static_cast<int>(x * width), width - 1);
+        int row_lo = qBound(0, static_cast<int>(y_lo * height), height - 1);
+        int row_hi = qBound(0, static_cast<int>(y_hi * height), height - 1);
+        pixels.fill(true, col * height + row_lo, col * height + row_hi + 1);
+        in_view++;
+    }
+
+    // Few enough to draw one by one.
+    if (in_view <= width) {
+        restoreSegmentBars(graph, error_bars, bars);
+        return;
+    }
+
+    // One bar for each run of marked pixels in a column.
+    QVector<double> time, center, span;
+    double x_pixel = x_size / width;
+    double y_pixel = y_size / height;
+    for (int col = 0; col < width; col++) {
+        int base = col * height;
+        for (int row = 0; row < height; row++) {
+            if (!pixels.testBit(base + row)) continue;
+            int run_lo = row;
+            while (row + 1 < height && pixels.testBit(base + row + 1)) {
+                row++;
+            }
+            double lo = y_lower + run_lo * y_pixel;
+            double hi = y_lower + (row + 1) * y_pixel;
+            time.append(x_lower + (col + 0.5) * x_pixel);
+            center.append((lo + hi) / 2.0);
+            span.append((hi - lo) / 2.0);
+        }
+    }
+
+    graph->setData(time, center, true);
+    error_bars->setData(span);
+    bars.decimated = true;
+}
+
 // XXX - We have similar code in io_graph_dialog and packet_diagram. Should this be a common routine?
 void TCPStreamDialog::on_buttonBox_accepted()
 {
@@ -90,6 +90,20 @@ private:
     QCPGraph *dup_ack_graph_;
     QCPGraph *zero_win_graph_;
     QCPItemTracer *tracer_;
+
+    // Segment and SACK spans for the tcptrace graph. Large streams are
+    // drawn from a copy reduced to at most one bar per run of pixels.
+    struct SegmentBars {
+        QVector<double> time;
+        QVector<double> center;
+        QVector<double> span;
+        bool decimated = false;
+    };
+    SegmentBars seg_bars_;
+    SegmentBars sack_bars_;
+    SegmentBars sack2_bars_;
+    QRectF lod_range_;
+    QSize lod_size_;
     QRectF axis_bounds_;
     guint32 packet_num_;
     QTransform y_axis_xfrm_;
@@ -139,6 +153,8 @@ private:
     bool compareHeaders(struct segment *seg);
     void toggleTracerStyle(bool force_default = false);
     QRectF getZoomRanges(QRect zoom_rect);
+    void setSegmentBars(QCPGraph *graph, QCPErrorBars *error_bars, SegmentBars &bars);
+    void restoreSegmentBars(QCPGraph *graph, QCPErrorBars *error_bars, SegmentBars &bars);
 
 private slots:
     void graphClicked(QMouseEvent *event);
@@ -146,6 +162,7 @@ private slots:
     void mouseMoved(QMouseEvent *event);
     void mouseReleased(QMouseEvent *event);
     void transformYRange(const QCPRange &y_range1);
+    void decimateSegmentBars();
     void on_buttonBox_accepted();
     void on_graphTypeComboBox_currentIndexChanged(int index);
     void on_resetButton_clicked();
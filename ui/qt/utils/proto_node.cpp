@@ -12,26 +12,9 @@
 
 #include <epan/prefs.h>
 
-ProtoNode::ProtoNode(proto_node *node, ProtoNode *parent) :
-    node_(node), parent_(parent)
+ProtoNode::ProtoNode(proto_node *node, ProtoNode *parent, int row) :
+    node_(node), children_count_(-1), children_valid_(false), parent_(parent), row_(row)
 {
-    if (node_) {
-
-        int num_children = 0;
-        for (proto_node *child = node_->first_child; child; child = child->next) {
-            if (!isHidden(child)) {
-                num_children++;
-            }
-        }
-
-        m_children.reserve(num_children);
-
-        for (proto_node *child = node_->first_child; child; child = child->next) {
-            if (!isHidden(child)) {
-                m_children.append(new ProtoNode(child, this));
-            }
-        }
-    }
 }
 
 ProtoNode::~ProtoNode()
@@ -91,7 +74,15 @@ int ProtoNode::childrenCount() const
 {
     if (!node_) return 0;
 
-    return (int)m_children.count();
+    if (children_count_ < 0) {
+        children_count_ = 0;
+        for (proto_node *child = node_->first_child; child; child = child->next) {
+            if (!isHidden(child)) {
+                children_count_++;
+            }
+        }
+    }
+    return children_count_;
 }
 
 int ProtoNode::row()
@@ -100,7 +91,7 @@ int ProtoNode::row()
         return -1;
     }
 
-    return (int)parent_->m_children.indexOf(const_cast<ProtoNode*>(this));
+    return row_;
 }
 
 bool ProtoNode::isExpanded() const
@@ -118,11 +109,28 @@ proto_node * ProtoNode::protoNode() const
 
 ProtoNode* ProtoNode::child(int row)
 {
+    if (!children_valid_) {
+        buildChildren();
+    }
     if (row < 0 || row >= m_children.size())
         return nullptr;
     return m_children.at(row);
 }
 
+void ProtoNode::buildChildren()
+{
+    children_valid_ = true;
+    if (!node_) return;
+
+    m_children.reserve(childrenCount());
+
+    for (proto_node *child = node_->first_child; child; child = child->next) {
+        if (!isHidden(child)) {
+            m_children.append(new ProtoNode(child, this, static_cast<int>(m_children.size())));
+        }
+    }
+}
+
 ProtoNode::ChildIterator ProtoNode::children() const
 {
     /* XXX: Iterate over m_children instead?
@@ -35,7 +35,7 @@ public:
         NodePtr node;
     };
 
-    explicit ProtoNode(proto_node * node = NULL, ProtoNode *parent = nullptr);
+    explicit ProtoNode(proto_node * node = NULL, ProtoNode *parent = nullptr, int row = -1);
     ~ProtoNode();
 
     bool isValid() const;
@@ -54,8 +54,14 @@ public:
 
 private:
     proto_node * node_;
+    // Children are wrapped the first time they're asked for, so that
+    // a huge tree costs nothing until its subtrees are expanded.
     QVector<ProtoNode*>m_children;
+    mutable int children_count_;
+    bool children_valid_;
     ProtoNode *parent_;
+    int row_;
+    void buildChildren();
     static bool isHidden(proto_node * node);
 };
 
@@ -47,7 +47,7 @@ Q_DECLARE_METATYPE(DataPrinter::DumpType)
 
 ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWidget *parent) :
     QAbstractScrollArea(parent),
-    layout_(new QTextLayout()),
+    line_layouts_(256),
     data_(data),
     encoding_(encoding),
     hovered_byte_offset_(-1),
@@ -66,8 +66,6 @@ ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWi
     line_height_(0),
     allow_hover_selection_(false)
 {
-    layout_->setCacheEnabled(true);
-
     offset_normal_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.35);
     offset_field_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.65);
 
@@ -86,7 +84,6 @@ ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWi
 ByteViewText::~ByteViewText()
 {
     ctx_menu_.clear();
-    delete(layout_);
 }
 
 void ByteViewText::createContextMenu()
@@ -238,7 +235,7 @@ void ByteViewText::setMonospaceFont(const QFont &mono_font)
 
     setFont(int_font);
     viewport()->setFont(int_font);
-    layout_->setFont(int_font);
+    line_layouts_.clear();
 
     updateLayoutMetrics();
 
@@ -258,6 +255,7 @@ void ByteViewText::updateByteViewSettings()
 void ByteViewText::detachData()
 {
     data_.detach();
+    line_layouts_.clear();
 }
 
 void ByteViewText::paintEvent(QPaintEvent *)
@@ -579,16 +577,21 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
     // XXX Fields won't be highlighted if neither hex nor ascii are enabled.
     addFormatRange(fmt_list, 0, offsetChars(), offset_mode);
 
-    layout_->clearLayout();
-    layout_->clearFormats();
-    layout_->setText(line);
-    layout_->setFormats(fmt_list.toVector());
-    layout_->beginLayout();
-    QTextLine tl = layout_->createLine();
-    tl.setLineWidth(totalPixels());
-    tl.setLeadingIncluded(true);
-    layout_->endLayout();
-    layout_->draw(painter, QPointF(0.0, row_y));
+    QTextLayout *layout = line_layouts_.object(offset);
+    QVector<QTextLayout::FormatRange> formats = fmt_list.toVector();
+    if (!layout || layout->text() != line || layout->formats() != formats
+            || layout->lineAt(0).width() != totalPixels()) {
+        layout = new QTextLayout(line, viewport()->font());
+        layout->setCacheEnabled(true);
+        layout->setFormats(formats);
+        layout->beginLayout();
+        QTextLine tl = layout->createLine();
+        tl.setLineWidth(totalPixels());
+        tl.setLeadingIncluded(true);
+        layout->endLayout();
+        line_layouts_.insert(offset, layout);
+    }
+    layout->draw(painter, QPointF(0.0, row_y));
 }
 
 bool ByteViewText::addFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int start, int length, HighlightMode mode)
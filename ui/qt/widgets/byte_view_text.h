@@ -15,6 +15,7 @@
 #include "ui/recent.h"
 
 #include <QAbstractScrollArea>
+#include <QCache>
 #include <QFont>
 #include <QVector>
 #include <QMenu>
@@ -76,7 +77,9 @@ private:
         ModeNonPrintable
     } HighlightMode;
 
-    QTextLayout *layout_;
+    // Laid out lines, by offset. Hovering and scrolling back and forth
+    // redraw the same lines, which then don't have to be shaped again.
+    QCache<int, QTextLayout> line_layouts_;
     QByteArray data_;
 
     void updateLayoutMetrics();
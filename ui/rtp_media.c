@@ -35,14 +35,11 @@ typedef struct _rtp_decoder_t {
  * Return the number of decoded bytes
  */
 
-size_t
-decode_rtp_packet_payload(guint8 payload_type, const gchar *payload_type_str, int payload_rate, int payload_channels, wmem_map_t *payload_fmtp_map, guint8 *payload_data, size_t payload_len, SAMPLE **out_buff, GHashTable *decoders_hash, guint *channels_ptr, guint *sample_rate_ptr)
+static rtp_decoder_t *
+get_rtp_decoder(guint8 payload_type, const gchar *payload_type_str, int payload_rate, int payload_channels, wmem_map_t *payload_fmtp_map, GHashTable *decoders_hash)
 {
     const gchar *p;
     rtp_decoder_t *decoder;
-    SAMPLE *tmp_buff = NULL;
-    size_t tmp_buff_len;
-    size_t decoded_bytes = 0;
 
     /* Look for registered codecs */
     decoder = (rtp_decoder_t *)g_hash_table_lookup(decoders_hash, GUINT_TO_POINTER(payload_type));
@@ -68,6 +65,18 @@ decode_rtp_packet_payload(guint8 payload_type, const gchar *payload_type_str, in
         }
         g_hash_table_insert(decoders_hash, GUINT_TO_POINTER(payload_type), decoder);
     }
+    return decoder;
+}
+
+size_t
+decode_rtp_packet_payload(guint8 payload_type, const gchar *payload_type_str, int payload_rate, int payload_channels, wmem_map_t *payload_fmtp_map, guint8 *payload_data, size_t payload_len, SAMPLE **out_buff, GHashTable *decoders_hash, guint *channels_ptr, guint *sample_rate_ptr)
+{
+    rtp_decoder_t *decoder;
+    SAMPLE *tmp_buff = NULL;
+    size_t tmp_buff_len;
+    size_t decoded_bytes = 0;
+
+    decoder = get_rtp_decoder(payload_type, payload_type_str, payload_rate, payload_channels, payload_fmtp_map, decoders_hash);
     if (decoder->handle) {  /* Decode with registered codec */
         /* if output == NULL and outputSizeBytes == NULL => ask for expected size of the buffer */
         tmp_buff_len = codec_decode(decoder->handle, decoder->context, payload_data, payload_len, NULL, NULL);
@@ -109,6 +118,85 @@ decode_rtp_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash
     return decode_rtp_packet_payload(payload_type, rp->info->info_payload_type_str, rp->info->info_payload_rate, rp->info->info_payload_channels, rp->info->info_payload_fmtp_map, rp->payload_data, rp->info->info_payload_len, out_buff, decoders_hash, channels_ptr, sample_rate_ptr);
 }
 
+/****************************************************************************/
+#define RTP_DECODE_BATCH_MAX 256
+
+static gboolean
+rtp_packet_has_payload(const rtp_packet_t *rp)
+{
+    return rp->payload_data != NULL && rp->info->info_payload_len != 0;
+}
+
+size_t
+decode_rtp_packets(rtp_packet_t **packets, size_t packet_count, SAMPLE *out_buff, size_t out_buff_size, size_t *decoded_bytes, GHashTable *decoders_hash, guint *channels_ptr, guint *sample_rate_ptr)
+{
+    codec_frame_t frames[RTP_DECODE_BATCH_MAX];
+    rtp_packet_t *first;
+    rtp_decoder_t *decoder;
+    size_t count, decoded, i;
+
+    if (packet_count == 0) {
+        return 0;
+    }
+
+    first = packets[0];
+    if (!rtp_packet_has_payload(first)) {
+        decoded_bytes[0] = 0;
+        return 1;
+    }
+
+    decoder = get_rtp_decoder(first->info->info_payload_type, first->info->info_payload_type_str, first->info->info_payload_rate, first->info->info_payload_channels, first->info->info_payload_fmtp_map, decoders_hash);
+    if (!decoder->handle) {
+        decoded_bytes[0] = 0;
+        return 1;
+    }
+
+    /* The packets that follow with the same payload type go to the
+     * same decoder. */
+    if (packet_count > RTP_DECODE_BATCH_MAX) {
+        packet_count = RTP_DECODE_BATCH_MAX;
+    }
+    for (count = 0; count < packet_count; count++) {
+        rtp_packet_t *rp = packets[count];
+
+        if (!rtp_packet_has_payload(rp) ||
+            rp->info->info_payload_type != first->info->info_payload_type) {
+            break;
+        }
+        frames[count].inputBytes = rp->payload_data;
+        frames[count].inputBytesSize = rp->info->info_payload_len;
+        frames[count].outputBytes = 0;
+    }
+
+    decoded = codec_decode_batch(decoder->handle, decoder->context, frames, count, out_buff, out_buff_size);
+    if (decoded == 0) {
+        /* Either the first frame doesn't fit, and we tell the caller how
+         * much room it needs, or the codec can't decode it at all. */
+        size_t needed = codec_decode(decoder->handle, decoder->context, frames[0].inputBytes, frames[0].inputBytesSize, NULL, NULL);
+
+        if (needed > out_buff_size) {
+            decoded_bytes[0] = needed;
+            return 0;
+        }
+        decoded_bytes[0] = 0;
+        return 1;
+    }
+
+    for (i = 0; i < decoded; i++) {
+        decoded_bytes[i] = frames[i].outputBytes;
+    }
+
+    if (channels_ptr) {
+        *channels_ptr = codec_get_channels(decoder->handle, decoder->context);
+    }
+
+    if (sample_rate_ptr) {
+        *sample_rate_ptr = codec_get_frequency(decoder->handle, decoder->context);
+    }
+
+    return decoded;
+}
+
 /****************************************************************************/
 static void
 rtp_decoder_value_destroy(gpointer dec_arg)
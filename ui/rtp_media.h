@@ -83,6 +83,26 @@ size_t decode_rtp_packet_payload(guint8 payload_type, const gchar *payload_type_
  */
 size_t decode_rtp_packet(rtp_packet_t *rp, SAMPLE **out_buff, GHashTable *decoders_hash, guint *channels_ptr, guint *sample_rate_ptr);
 
+/** Decode several RTP packets into a caller provided buffer
+ * Starting with the first packet, the packets that have the same payload
+ * type are decoded with one call to the codec, into consecutive parts of
+ * out_buff. A packet without payload or without a codec is returned on its
+ * own, with nothing decoded.
+ *
+ * @param packets Packets to decode.
+ * @param packet_count Count of packets.
+ * @param out_buff Output audio samples.
+ * @param out_buff_size Size of out_buff in bytes.
+ * @param decoded_bytes Receives the number of bytes decoded for each packet
+ *        handled. If nothing fits in out_buff, the first entry receives the
+ *        number of bytes the first packet needs.
+ * @param decoders_hash Hash table created with rtp_decoder_hash_table_new.
+ * @param channels_ptr If non-NULL, receives the number of channels in the sample.
+ * @param sample_rate_ptr If non-NULL, receives the sample rate.
+ * @return The number of packets handled, or 0 if out_buff is too small.
+ */
+size_t decode_rtp_packets(rtp_packet_t **packets, size_t packet_count, SAMPLE *out_buff, size_t out_buff_size, size_t *decoded_bytes, GHashTable *decoders_hash, guint *channels_ptr, guint *sample_rate_ptr);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -34,6 +34,9 @@ enum
     SRT_COLUMN_MAX,
     SRT_COLUMN_AVG,
     SRT_COLUMN_SUM,
+    SRT_COLUMN_P50,
+    SRT_COLUMN_P99,
+    SRT_COLUMN_P999,
     NUM_SRT_COLUMNS
 };
 
@@ -104,6 +104,8 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
 {
     GString    *error_string;
     tcp_scan_t  ts;
+    const guint32 *frames;
+    guint       num_frames;
 
     if (!cf || !tg) {
         return;
@@ -123,7 +125,13 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
         g_string_free(error_string, TRUE);
         exit(1);   /* XXX: fix this */
     }
-    cf_retap_packets(cf);
+    /* Only the frames of the stream are of interest. */
+    frames = get_tcp_stream_frames(tg->stream, &num_frames);
+    if (frames != NULL) {
+        cf_retap_packets_for_frames(cf, frames, num_frames);
+    } else {
+        cf_retap_packets(cf);
+    }
     remove_tap_listener(&ts);
 }
 
@@ -1544,6 +1544,227 @@ parse_token(token_t token, char *str)
     return IMPORT_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+ * Fast path for hex dumps in the common "offset byte byte ... [text]"
+ * layout, as written by "od -Ax -tx1", "tshark -x" or "hexdump -C".
+ *
+ * Lines in that layout are decoded here directly, giving the state
+ * machine the same tokens the scanner would have produced for them, but
+ * without a token per byte. All other lines are collected and handed to
+ * the scanner. This is only used with hexadecimal offsets and without
+ * ASCII identification, as those paths depend on the scanner's tokens.
+ */
+#define HEXDUMP_READ_SIZE       (1024 * 1024)
+#define FAST_MAX_OFFSET_LEN     8   /* longer offsets may not fit in 32 bits */
+
+#define IS_BLANK(c) ((c) == ' ' || (c) == '\t')
+
+static gint8 hex_nibble[256];
+
+static void
+init_hex_nibbles(void)
+{
+    int i;
+
+    memset(hex_nibble, -1, sizeof hex_nibble);
+    for (i = 0; i < 10; i++)
+        hex_nibble['0' + i] = i;
+    for (i = 0; i < 6; i++) {
+        hex_nibble['a' + i] = 10 + i;
+        hex_nibble['A' + i] = 10 + i;
+    }
+}
+
+#define IS_HEX(c) (hex_nibble[(guint8)(c)] >= 0)
+
+/*
+ * Return the length of the offset at the start of the line, or 0 if the
+ * line doesn't start with one that the scanner would see as an offset.
+ * Two hex digits would be a byte, not an offset. A blank line has an
+ * offset length of 0 too, but sets *blank.
+ */
+static size_t
+fast_line_offset(const char *line, const char *end, const char **offset_start, gboolean *blank)
+{
+    const char *p = line;
+    const char *q;
+
+    while (p < end && IS_BLANK(*p))
+        p++;
+    *blank = (p == end);
+    *offset_start = p;
+
+    for (q = p; q < end && IS_HEX(*q); q++)
+        ;
+    if (q - p <= 2 || q - p > FAST_MAX_OFFSET_LEN)
+        return 0;
+    if (q < end && *q != ':' && !IS_BLANK(*q))
+        return 0;
+    return q - p;
+}
+
+/*
+ * Process one line, without its "\n", and with the end of the line
+ * writable. Returns FALSE, having done nothing, if the line has to go
+ * through the scanner.
+ */
+static gboolean
+parse_fast_line(char *line, char *end, import_status_t *status)
+{
+    const char *offset;
+    char offset_str[FAST_MAX_OFFSET_LEN + 1];
+    size_t offset_len, i;
+    gboolean blank;
+    guint32 num = 0;
+    char *p;
+
+    *status = IMPORT_SUCCESS;
+
+    offset_len = fast_line_offset(line, end, &offset, &blank);
+    if (blank) {
+        *status = parse_token(T_EOL, NULL);
+        return TRUE;
+    }
+    if (offset_len == 0)
+        return FALSE;
+
+    for (i = 0; i < offset_len; i++)
+        num = (num << 4) | hex_nibble[(guint8)offset[i]];
+
+    /*
+     * Only take lines that continue the current packet or start a new
+     * one; the state machine's other cases are left to the scanner.
+     */
+    if (num == 0) {
+        if (state != INIT && state != START_OF_LINE)
+            return FALSE;
+    } else if (state != START_OF_LINE || num - packet_start != curr_offset) {
+        return FALSE;
+    }
+
+    memcpy(offset_str, offset, offset_len);
+    offset_str[offset_len] = '\0';
+    *status = parse_token(T_OFFSET, offset_str);
+    if (*status != IMPORT_SUCCESS)
+        return TRUE;
+
+    p = (char *)offset + offset_len;
+    if (p < end && *p == ':')
+        p++;
+    for (;;) {
+        while (p < end && IS_BLANK(*p))
+            p++;
+        if (p == end)
+            break;
+        /* A byte is two hex digits followed by a blank or the end of the line */
+        if (end - p < 2 || !IS_HEX(p[0]) || !IS_HEX(p[1]) ||
+            (end - p > 2 && !IS_BLANK(p[2]))) {
+            /* Anything else ends the bytes of this line */
+            *end = '\0';
+            *status = parse_token(T_TEXT, p);
+            if (*status != IMPORT_SUCCESS)
+                return TRUE;
+            break;
+        }
+        packet_buf[curr_offset] = (guint8)((hex_nibble[(guint8)p[0]] << 4) | hex_nibble[(guint8)p[1]]);
+        curr_offset++;
+        state = READ_BYTE;
+        if (curr_offset >= info_p->max_frame_length) { /* packet full */
+            *status = start_new_packet(TRUE);
+            if (*status != IMPORT_SUCCESS)
+                return TRUE;
+        }
+        p += 2;
+    }
+
+    *status = parse_token(T_EOL, NULL);
+    return TRUE;
+}
+
+static import_status_t
+scan_slow_lines(GByteArray *lines)
+{
+    import_status_t status = IMPORT_SUCCESS;
+
+    if (lines->len > 0) {
+        status = text_import_scan_bytes((const char *)lines->data, lines->len);
+        g_byte_array_set_size(lines, 0);
+    }
+    return status;
+}
+
+static import_status_t
+text_import_scan_fast(FILE *input_file)
+{
+    size_t buf_size = HEXDUMP_READ_SIZE;
+    char *buf = (char *)g_malloc(buf_size);
+    size_t start = 0, end = 0, nread;
+    GByteArray *slow_lines = g_byte_array_new();
+    import_status_t status = IMPORT_SUCCESS;
+    gboolean at_eof = FALSE;
+    char *line, *line_end, *nl;
+    const char *offset;
+    gboolean blank;
+
+    init_hex_nibbles();
+
+    while (status == IMPORT_SUCCESS) {
+        nl = (char *)memchr(buf + start, '\n', end - start);
+        if (nl == NULL) {
+            if (at_eof) {
+                /* A last line without a newline goes to the scanner */
+                g_byte_array_append(slow_lines, (const guint8 *)buf + start, (guint)(end - start));
+                break;
+            }
+            /* Move the partial line to the front, growing the buffer for very long lines */
+            memmove(buf, buf + start, end - start);
+            end -= start;
+            start = 0;
+            if (end == buf_size) {
+                buf_size *= 2;
+                buf = (char *)g_realloc(buf, buf_size);
+            }
+            nread = fread(buf + end, 1, buf_size - end, input_file);
+            if (nread == 0) {
+                if (ferror(input_file)) {
+                    report_failure("Error reading input: %s", g_strerror(errno));
+                    status = IMPORT_FAILURE;
+                }
+                at_eof = TRUE;
+            }
+            end += nread;
+            continue;
+        }
+
+        line = buf + start;
+        line_end = nl;
+        start = nl + 1 - buf;
+        if (line_end > line && line_end[-1] == '\r')
+            line_end--;
+
+        if (fast_line_offset(line, line_end, &offset, &blank) != 0 || blank) {
+            /* The state machine must have seen the preceding lines */
+            status = scan_slow_lines(slow_lines);
+            if (status != IMPORT_SUCCESS)
+                break;
+            if (parse_fast_line(line, line_end, &status))
+                continue;
+        }
+        g_byte_array_append(slow_lines, (const guint8 *)line, (guint)(nl + 1 - line));
+        if (slow_lines->len >= HEXDUMP_READ_SIZE)
+            status = scan_slow_lines(slow_lines);
+    }
+
+    if (status == IMPORT_SUCCESS)
+        status = scan_slow_lines(slow_lines);
+    if (status == IMPORT_SUCCESS)
+        status = parse_token(T_EOF, NULL);
+
+    g_byte_array_free(slow_lines, TRUE);
+    g_free(buf);
+    return status;
+}
+
 /*----------------------------------------------------------------------
  * Import a text file.
  */
@@ -1727,7 +1948,10 @@ text_import(text_import_info_t * const info)
     }
 
     if (info->mode == TEXT_IMPORT_HEXDUMP) {
-        status = text_import_scan(info->hexdump.import_text_FILE);
+        if (offset_base == 16 && !info->hexdump.identify_ascii)
+            status = text_import_scan_fast(info->hexdump.import_text_FILE);
+        else
+            status = text_import_scan(info->hexdump.import_text_FILE);
         switch(status) {
         case (IMPORT_SUCCESS):
             ret = 0;
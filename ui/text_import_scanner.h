@@ -42,6 +42,10 @@ extern FILE *text_importin;
 
 import_status_t text_import_scan(FILE *input_file);
 
+/* Scan a block of complete lines that is only part of the input, so the
+ * end of the block is not reported as the end of the input. */
+import_status_t text_import_scan_bytes(const char *bytes, size_t len);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -187,6 +187,7 @@ typedef struct _voip_calls_tapinfo {
     epan_t               *session; /**< epan session */
     int                   nrtpstreams; /**< number of rtp streams */
     GList*                rtpstream_list; /**< list of rtpstream_info_t */
+    GHashTable*           rtpstream_hash; /**< active streams in rtpstream_list, by setup frame and SSRC */
     guint32               rtp_evt_frame_num;
     guint8                rtp_evt;
     gboolean              rtp_evt_end;
@@ -71,12 +71,22 @@ typedef struct blf_log_container {
     unsigned char  *real_data;        /* cache for decompressed data */
 } blf_log_container_t;
 
+/*
+ * Number of log containers whose decompressed data we keep in memory.
+ * Containers are typically 128 KiB or less once decompressed, so this
+ * is enough for objects spanning containers and for going back and forth
+ * between nearby packets, without holding the whole decompressed file.
+ */
+#define BLF_CONTAINER_CACHE_SIZE 8
+
 typedef struct blf_data {
     gint64      start_of_last_obj;
     gint64      current_real_seek_pos;
     guint64     start_offset_ns;
 
     GArray     *log_containers;
+    guint       cached_containers[BLF_CONTAINER_CACHE_SIZE]; /* indices of the containers with real_data, most recently used first */
+    guint       num_cached_containers;
 
     GHashTable *channel_to_iface_ht;
     GHashTable *channel_to_name_ht;
@@ -638,6 +648,37 @@ blf_logcontainers_search(gconstpointer a, gconstpointer b) {
     }
 }
 
+/** Marks a log container whose data is in memory as the most recently used one
+ *
+ * If it wasn't in the cache yet and the cache is full, the data of the
+ * least recently used container is freed.
+ */
+static void
+blf_touch_logcontainer(blf_t *blf, guint container_index) {
+    guint i;
+
+    for (i = 0; i < blf->num_cached_containers; i++) {
+        if (blf->cached_containers[i] == container_index) {
+            break;
+        }
+    }
+    if (i == blf->num_cached_containers) {
+        if (i == BLF_CONTAINER_CACHE_SIZE) {
+            blf_log_container_t* victim;
+
+            i--;
+            victim = &g_array_index(blf->log_containers, blf_log_container_t, blf->cached_containers[i]);
+            g_free(victim->real_data);
+            victim->real_data = NULL;
+        }
+        else {
+            blf->num_cached_containers++;
+        }
+    }
+    memmove(&blf->cached_containers[1], &blf->cached_containers[0], i * sizeof(guint));
+    blf->cached_containers[0] = container_index;
+}
+
 /** Ensures the given log container is in memory
  *
  * If the log container already is not already in memory,
@@ -647,15 +688,18 @@ blf_logcontainers_search(gconstpointer a, gconstpointer b) {
  * data (container->infile_data_start) before calling this function.
  */
 static gboolean
-blf_pull_logcontainer_into_memory(blf_params_t *params, blf_log_container_t *container, int *err, gchar **err_info) {
+blf_pull_logcontainer_into_memory(blf_params_t *params, guint container_index, int *err, gchar **err_info) {
+    blf_log_container_t *container;
 
-    if (container == NULL) {
+    if (container_index >= params->blf_data->log_containers->len) {
         *err = WTAP_ERR_INTERNAL;
-        *err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory called with NULL container");
+        *err_info = ws_strdup_printf("blf_pull_logcontainer_into_memory called with invalid container index %u", container_index);
         return FALSE;
     }
+    container = &g_array_index(params->blf_data->log_containers, blf_log_container_t, container_index);
 
     if (container->real_data != NULL) {
+        blf_touch_logcontainer(params->blf_data, container_index);
         return TRUE;
     }
 
@@ -733,6 +777,7 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, blf_log_container_t *con
             return FALSE;
         }
         container->real_data = buf;
+        blf_touch_logcontainer(params->blf_data, container_index);
         return TRUE;
 
     }
@@ -879,6 +924,7 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, blf_log_container_t *con
 
         g_free(compressed_data);
         container->real_data = buf;
+        blf_touch_logcontainer(params->blf_data, container_index);
         return TRUE;
 #else
         (void) params;
@@ -1027,12 +1073,46 @@ blf_find_next_logcontainer(blf_params_t* params, int* err, gchar** err_info) {
 
 static gboolean
 blf_pull_next_logcontainer(blf_params_t* params, int* err, gchar** err_info) {
-    blf_log_container_t* container;
     if (!blf_find_next_logcontainer(params, err, err_info)) {
         return FALSE;
     }
-    container = &g_array_index(params->blf_data->log_containers, blf_log_container_t, params->blf_data->log_containers->len - 1);
-    if (!blf_pull_logcontainer_into_memory(params, container, err, err_info)) {
+    if (!blf_pull_logcontainer_into_memory(params, params->blf_data->log_containers->len - 1, err, err_info)) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/** Ensures a log container we already found is in memory
+ *
+ * Seeks to the container's data if it has to be read (again).  During
+ * the linear pass that only happens if we had to go back further than
+ * the cache holds; the read position is restored afterwards.
+ */
+static gboolean
+blf_load_logcontainer(blf_params_t *params, guint container_index, int *err, gchar **err_info) {
+    blf_log_container_t* container = &g_array_index(params->blf_data->log_containers, blf_log_container_t, container_index);
+    gint64 saved_pos = -1;
+
+    if (container->real_data != NULL) {
+        blf_touch_logcontainer(params->blf_data, container_index);
+        return TRUE;
+    }
+
+    if (!params->random) {
+        if (params->pipe) {
+            *err = WTAP_ERR_INTERNAL;
+            *err_info = ws_strdup("blf_load_logcontainer: cannot go back to an earlier log container when reading from a pipe");
+            return FALSE;
+        }
+        saved_pos = file_tell(params->fh);
+    }
+    if (file_seek(params->fh, container->infile_data_start, SEEK_SET, err) == -1) {
+        return FALSE;
+    }
+    if (!blf_pull_logcontainer_into_memory(params, container_index, err, err_info)) {
+        return FALSE;
+    }
+    if (saved_pos != -1 && file_seek(params->fh, saved_pos, SEEK_SET, err) == -1) {
         return FALSE;
     }
     return TRUE;
@@ -1112,13 +1192,8 @@ blf_read_bytes_or_eof(blf_params_t *params, guint64 real_pos, void *target_buffe
 
         start_in_buf = real_pos - container->real_start_pos;
 
-        if (params->random) {
-            if (file_seek(params->fh, container->infile_data_start, SEEK_SET, err) == -1) {
-                return FALSE;
-            }
-            if (!blf_pull_logcontainer_into_memory(params, container, err, err_info)) {
-                return FALSE;
-            }
+        if (!blf_load_logcontainer(params, container_index, err, err_info)) {
+            return FALSE;
         }
 
         data_left = container->real_length - start_in_buf;
@@ -3443,6 +3518,7 @@ blf_open(wtap *wth, int *err, gchar **err_info) {
     /* Prepare our private context. */
     blf = g_new(blf_t, 1);
     blf->log_containers = g_array_new(FALSE, FALSE, sizeof(blf_log_container_t));
+    blf->num_cached_containers = 0;
     blf->current_real_seek_pos = 0;
     blf->start_offset_ns = 1000 * 1000 * 1000 * (guint64)mktime(&timestamp);
     blf->start_offset_ns += 1000 * 1000 * header.start_date.ms;
@@ -272,6 +272,8 @@ erf_t *erf_priv_create(void)
   erf_priv = g_new(erf_t, 1);
   erf_priv->anchor_map = g_hash_table_new_full(erf_anchor_mapping_hash, erf_anchor_mapping_equal, erf_anchor_mapping_destroy, NULL);
   erf_priv->if_map = g_hash_table_new_full(erf_if_mapping_hash, erf_if_mapping_equal, erf_if_mapping_destroy, NULL);
+  memset(erf_priv->if_map_cache, 0, sizeof erf_priv->if_map_cache);
+  erf_priv->anchor_mappings_to_update = g_ptr_array_new_with_free_func(erf_anchor_mapping_destroy);
   erf_priv->implicit_host_id = ERF_META_HOST_ID_IMPLICIT;
   erf_priv->capture_gentime = 0;
   erf_priv->host_gentime = 0;
@@ -285,6 +287,7 @@ erf_t* erf_priv_free(erf_t* erf_priv)
   {
     g_hash_table_destroy(erf_priv->anchor_map);
     g_hash_table_destroy(erf_priv->if_map);
+    g_ptr_array_free(erf_priv->anchor_mappings_to_update, TRUE);
     g_free(erf_priv);
   }
 
@@ -576,22 +579,21 @@ static gboolean erf_read(wtap *wth, wtap_rec *rec, Buffer *buf,
 {
   erf_header_t erf_header;
   guint32      packet_size, bytes_read;
-  GPtrArray *anchor_mappings_to_update;
+  GPtrArray *anchor_mappings_to_update = ((erf_t*) wth->priv)->anchor_mappings_to_update;
 
   *data_offset = file_tell(wth->fh);
 
-  anchor_mappings_to_update = g_ptr_array_new_with_free_func(erf_anchor_mapping_destroy);
-
   do {
+    /* Anchor definitions only apply to the record they're found in. */
+    g_ptr_array_set_size(anchor_mappings_to_update, 0);
+
     if (!erf_read_header(wth, wth->fh, rec, &erf_header,
                          err, err_info, &bytes_read, &packet_size,
                          anchor_mappings_to_update)) {
-      g_ptr_array_free(anchor_mappings_to_update, TRUE);
       return FALSE;
     }
 
     if (!wtap_read_packet_bytes(wth->fh, buf, packet_size, err, err_info)) {
-      g_ptr_array_free(anchor_mappings_to_update, TRUE);
       return FALSE;
     }
 
@@ -603,15 +605,12 @@ static gboolean erf_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     if ((erf_header.type & 0x7F) == ERF_TYPE_META && packet_size > 0)
     {
       if (populate_summary_info((erf_t*) wth->priv, wth, &rec->rec_header.packet_header.pseudo_header, buf, packet_size, anchor_mappings_to_update, err, err_info) < 0) {
-        g_ptr_array_free(anchor_mappings_to_update, TRUE);
         return FALSE;
       }
     }
 
   } while ( erf_header.type == ERF_TYPE_PAD );
 
-  g_ptr_array_free(anchor_mappings_to_update, TRUE);
-
   return TRUE;
 }
 
@@ -621,23 +620,20 @@ static gboolean erf_seek_read(wtap *wth, gint64 seek_off,
 {
   erf_header_t erf_header;
   guint32      packet_size;
-  GPtrArray *anchor_mappings_to_update;
+  GPtrArray *anchor_mappings_to_update = ((erf_t*) wth->priv)->anchor_mappings_to_update;
 
   if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
     return FALSE;
 
-  anchor_mappings_to_update = g_ptr_array_new_with_free_func(erf_anchor_mapping_destroy);
-
   do {
+    g_ptr_array_set_size(anchor_mappings_to_update, 0);
+
     if (!erf_read_header(wth, wth->random_fh, rec, &erf_header,
                          err, err_info, NULL, &packet_size, anchor_mappings_to_update)) {
-      g_ptr_array_free(anchor_mappings_to_update, TRUE);
       return FALSE;
     }
   } while ( erf_header.type == ERF_TYPE_PAD );
 
-  g_ptr_array_free(anchor_mappings_to_update, TRUE);
-
   return wtap_read_packet_bytes(wth->random_fh, buf, packet_size,
                                 err, err_info);
 }
@@ -2146,15 +2142,28 @@ int erf_populate_interface_from_header(erf_t *erf_priv, wtap *wth, union wtap_ps
 static struct erf_if_mapping* erf_find_interface_mapping(erf_t *erf_priv, guint64 host_id, guint8 source_id)
 {
   struct erf_if_mapping if_map_lookup;
+  struct erf_if_mapping *if_map;
 
   /* XXX: erf_priv should never be NULL here */
   if (!erf_priv)
     return NULL;
 
+  /*
+   * Mappings are only freed with erf_priv, so a cached one is still valid;
+   * its Host ID may have been changed from the implicit one, though.
+   */
+  if_map = erf_priv->if_map_cache[source_id];
+  if (if_map && if_map->host_id == host_id)
+    return if_map;
+
   if_map_lookup.host_id = host_id;
   if_map_lookup.source_id = source_id;
 
-  return (struct erf_if_mapping*) g_hash_table_lookup(erf_priv->if_map, &if_map_lookup);
+  if_map = (struct erf_if_mapping*) g_hash_table_lookup(erf_priv->if_map, &if_map_lookup);
+  if (if_map)
+    erf_priv->if_map_cache[source_id] = if_map;
+
+  return if_map;
 }
 
 static void erf_set_interface_descr(wtap_block_t block, guint option_id, guint64 host_id, guint8 source_id, guint8 if_num, const gchar *descr)
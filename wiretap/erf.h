@@ -28,7 +28,15 @@
  */
 struct erf_private {
   GHashTable* if_map;
+  /*
+   * Interface mappings by Source ID, looked up before if_map: the records
+   * of a multi-stream capture mostly share a Host ID and differ in the
+   * Source ID, so this nearly always hits.
+   */
+  struct erf_if_mapping* if_map_cache[256];
   GHashTable* anchor_map;
+  /* Anchor definitions found in the current record, reused across records. */
+  GPtrArray* anchor_mappings_to_update;
   guint64 implicit_host_id;
   guint64 capture_gentime;
   guint64 host_gentime;
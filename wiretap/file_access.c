@@ -735,6 +735,73 @@ get_file_extension(const char *pathname)
 	return extensionp;
 }
 
+/*
+ * Leading bytes that some open routines insist on. Before trying the
+ * open routines, wtap_open_offline() reads the start of the file once,
+ * and skips the routines listed here if the file starts with none of
+ * their magic numbers, as they would only read the same bytes again to
+ * reject the file. Routines that aren't listed are always tried.
+ *
+ * Only list a routine if it returns WTAP_OPEN_NOT_MINE for any file
+ * that doesn't start with one of its entries.
+ */
+#define OPEN_MAGIC_MAX_LEN	17
+
+typedef struct {
+	wtap_open_routine_t open_routine;
+	unsigned len;
+	guint8 magic[OPEN_MAGIC_MAX_LEN];
+} open_magic_t;
+
+static const open_magic_t open_magics[] = {
+	/* libpcap_open() accepts each magic number in either byte order */
+	{ libpcap_open,          4, { 0xa1, 0xb2, 0xc3, 0xd4 } },
+	{ libpcap_open,          4, { 0xd4, 0xc3, 0xb2, 0xa1 } },
+	{ libpcap_open,          4, { 0xa1, 0xb2, 0xcd, 0x34 } },
+	{ libpcap_open,          4, { 0x34, 0xcd, 0xb2, 0xa1 } },
+	{ libpcap_open,          4, { 0xa1, 0xb2, 0x3c, 0x4d } },
+	{ libpcap_open,          4, { 0x4d, 0x3c, 0xb2, 0xa1 } },
+	{ libpcap_open,          4, { 0x1c, 0x00, 0x01, 0xac } },
+	{ libpcap_open,          4, { 0xac, 0x01, 0x00, 0x1c } },
+	{ libpcap_open,          4, { 0x1c, 0x00, 0x01, 0xab } },
+	{ libpcap_open,          4, { 0xab, 0x01, 0x00, 0x1c } },
+	/* The block type of a Section Header Block reads the same either way */
+	{ pcapng_open,           4, { 0x0a, 0x0d, 0x0d, 0x0a } },
+	{ ngsniffer_open,       17, { 'T', 'R', 'S', 'N', 'I', 'F', 'F', ' ', 'd', 'a', 't', 'a',
+				      ' ', ' ', ' ', ' ', 0x1a } },
+	{ snoop_open,            8, { 's', 'n', 'o', 'o', 'p', '\0', '\0', '\0' } },
+	{ netmon_open,           4, { 'R', 'T', 'S', 'S' } },
+	{ netmon_open,           4, { 'G', 'M', 'B', 'U' } },
+	{ btsnoop_open,          8, { 'b', 't', 's', 'n', 'o', 'o', 'p', '\0' } },
+	{ blf_open,              4, { 'L', 'O', 'G', 'G' } },
+	/* Heuristic routines with a fixed start; RT_HeaderRegular or
+	 * RT_HeaderCyclic in little-endian order for LANalyzer */
+	{ lanalyzer_open,        2, { 0x01, 0x10 } },
+	{ lanalyzer_open,        2, { 0x07, 0x10 } },
+	{ daintree_sna_open,     8, { '#', 'F', 'o', 'r', 'm', 'a', 't', '=' } },
+};
+
+/*
+ * Can the open routine at index i accept a file starting with the
+ * hdr_len bytes at hdr?
+ */
+static gboolean
+open_routine_may_match(unsigned int i, const guint8 *hdr, unsigned hdr_len)
+{
+	wtap_open_routine_t open_routine = open_routines[i].open_routine;
+	gboolean listed = FALSE;
+
+	for (size_t j = 0; j < G_N_ELEMENTS(open_magics); j++) {
+		if (open_magics[j].open_routine != open_routine)
+			continue;
+		if (hdr_len >= open_magics[j].len &&
+		    memcmp(hdr, open_magics[j].magic, open_magics[j].len) == 0)
+			return TRUE;
+		listed = TRUE;
+	}
+	return !listed;
+}
+
 /*
  * Check if file extension is used in this heuristic
  */
@@ -782,6 +849,8 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 	gboolean use_stdin = FALSE;
 	gchar *extension;
 	wtap_block_t shb;
+	guint8 hdr[OPEN_MAGIC_MAX_LEN];
+	int hdr_len;
 
 	*err = 0;
 	*err_info = NULL;
@@ -961,8 +1030,27 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 		}
 	}
 
+	/*
+	 * Read the start of the file once, so that open routines which
+	 * require a magic number that isn't there don't have to be tried.
+	 */
+	if (file_seek(wth->fh, 0, SEEK_SET, err) == -1) {
+		/* I/O error - give up */
+		wtap_close(wth);
+		return NULL;
+	}
+	hdr_len = file_read(hdr, sizeof hdr, wth->fh);
+	if (hdr_len < 0) {
+		*err = file_error(wth->fh, err_info);
+		wtap_close(wth);
+		return NULL;
+	}
+
 	/* Try all file types that support magic numbers */
 	for (i = 0; i < heuristic_open_routine_idx; i++) {
+		if (!open_routine_may_match(i, hdr, hdr_len))
+			continue;
+
 		/* Seek back to the beginning of the file; the open routine
 		 * for the previous file type may have left the file
 		 * position somewhere other than the beginning, and the
@@ -1007,7 +1095,8 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 		/* Yes - try the heuristic types that use that extension first. */
 		for (i = heuristic_open_routine_idx; i < open_info_arr->len; i++) {
 			/* Does this type use that extension? */
-			if (heuristic_uses_extension(i, extension)) {
+			if (heuristic_uses_extension(i, extension) &&
+			    open_routine_may_match(i, hdr, hdr_len)) {
 				/* Yes. */
 				if (file_seek(wth->fh, 0, SEEK_SET, err) == -1) {
 					/* Error - give up */
@@ -1053,7 +1142,8 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 		 */
 		for (i = heuristic_open_routine_idx; i < open_info_arr->len; i++) {
 			/* Does this type have any extensions? */
-			if (open_routines[i].extensions == NULL) {
+			if (open_routines[i].extensions == NULL &&
+			    open_routine_may_match(i, hdr, hdr_len)) {
 				/* No. */
 				if (file_seek(wth->fh, 0, SEEK_SET, err) == -1) {
 					/* Error - give up */
@@ -1098,7 +1188,8 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 			 * extension one of them?
 			 */
 			if (open_routines[i].extensions != NULL &&
-			    !heuristic_uses_extension(i, extension)) {
+			    !heuristic_uses_extension(i, extension) &&
+			    open_routine_may_match(i, hdr, hdr_len)) {
 				/* Yes and no. */
 				if (file_seek(wth->fh, 0, SEEK_SET, err) == -1) {
 					/* Error - give up */
@@ -1136,6 +1227,8 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 	} else {
 		/* No - try all the heuristics types in order. */
 		for (i = heuristic_open_routine_idx; i < open_info_arr->len; i++) {
+			if (!open_routine_may_match(i, hdr, hdr_len))
+				continue;
 
 			if (file_seek(wth->fh, 0, SEEK_SET, err) == -1) {
 				/* Error - give up */
@@ -2572,6 +2665,40 @@ wtap_dump_open_stdout(int file_type_subtype, wtap_compression_type compression_t
 	return wdh;
 }
 
+/*
+ * Size of the stdio buffer used when writing an uncompressed regular
+ * file.  Writers issue several small writes per record (header, data,
+ * padding, options, trailer), so the standard buffer, typically a few
+ * KB, means a write() every handful of packets; with this, output
+ * reaches the file in large, block-aligned writes.
+ */
+#define WTAP_DUMP_IO_BUF_SIZE	(1024 * 1024)
+
+/*
+ * If we're writing an uncompressed regular file, give the stream a
+ * large buffer.  This must be done before anything is written with
+ * stdio.  Pipes and terminals keep their standard buffering, so that
+ * readers on the other end aren't starved.
+ */
+static void
+wtap_dump_set_io_buffer(wtap_dumper *wdh, int fd)
+{
+	ws_statb64 statb;
+	size_t buffsize = WTAP_DUMP_IO_BUF_SIZE;
+
+	if (ws_fstat64(fd, &statb) != 0 || !S_ISREG(statb.st_mode))
+		return;
+#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
+	if (statb.st_blksize > 0 && buffsize % statb.st_blksize != 0)
+		buffsize += statb.st_blksize - buffsize % statb.st_blksize;
+#endif
+	wdh->io_buffer = (char *)g_malloc(buffsize);
+	if (setvbuf((FILE *)wdh->fh, wdh->io_buffer, _IOFBF, buffsize) != 0) {
+		g_free(wdh->io_buffer);
+		wdh->io_buffer = NULL;
+	}
+}
+
 static gboolean
 wtap_dump_open_finish(wtap_dumper *wdh, int *err, gchar **err_info)
 {
@@ -2591,6 +2718,7 @@ wtap_dump_open_finish(wtap_dumper *wdh, int *err, gchar **err_info)
 			ws_lseek64(fd, 0, SEEK_SET);
 			cant_seek = FALSE;
 		}
+		wtap_dump_set_io_buffer(wdh, fd);
 	}
 
 	/* If this file type requires seeking, and we can't seek, fail. */
@@ -2638,6 +2766,38 @@ wtap_dump(wtap_dumper *wdh, const wtap_rec *rec,
 	return (wdh->subtype_write)(wdh, rec, pd, err, err_info);
 }
 
+gboolean
+wtap_dump_can_copy_raw(wtap_dumper *wdh, wtap *wth)
+{
+	if (wdh->subtype_write_raw == NULL ||
+	    wth->subtype_raw_record_len == NULL ||
+	    wth->random_fh == NULL)
+		return FALSE;
+	if (wdh->file_type_subtype != wth->file_type_subtype ||
+	    wdh->file_encap != wth->file_encap)
+		return FALSE;
+
+	/*
+	 * Records refer to interfaces by their index in their section,
+	 * so they can only be copied if there's one section, and the
+	 * interfaces we've written are the ones the file has.
+	 */
+	if (wth->shb_hdrs == NULL || wth->shb_hdrs->len != 1)
+		return FALSE;
+	if (wdh->interface_data->len != wth->interface_data->len)
+		return FALSE;
+	return TRUE;
+}
+
+gboolean
+wtap_dump_raw(wtap_dumper *wdh, const guint8 *data, size_t len,
+	  int *err, gchar **err_info)
+{
+	*err = 0;
+	*err_info = NULL;
+	return (wdh->subtype_write_raw)(wdh, data, len, err, err_info);
+}
+
 gboolean
 wtap_dump_flush(wtap_dumper *wdh, int *err)
 {
@@ -2853,12 +3013,19 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 static int
 wtap_dump_file_close(wtap_dumper *wdh)
 {
+	int ret;
+
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED)
-		return gzwfile_close((GZWFILE_T)wdh->fh);
+		ret = gzwfile_close((GZWFILE_T)wdh->fh);
 	else
 #endif
-		return fclose((FILE *)wdh->fh);
+		ret = fclose((FILE *)wdh->fh);
+
+	/* fclose() flushes the buffer, so it can't be freed until now. */
+	g_free(wdh->io_buffer);
+	wdh->io_buffer = NULL;
+	return ret;
 }
 
 gint64
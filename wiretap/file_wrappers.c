@@ -23,6 +23,11 @@
 #include "wtap-int.h"
 
 #include <wsutil/file_util.h>
+#include <wsutil/pint.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #ifdef HAVE_ZLIB
 #define ZLIB_CONST
@@ -42,6 +47,14 @@
 #endif
 #endif
 
+/*
+ * zstd and LZ4 frames are independent of one another, so, if a file
+ * has more than one of them, we can decompress several at once.
+ */
+#if defined(HAVE_ZSTD) || defined(USE_LZ4)
+#define PARALLEL_DECOMPRESS
+#endif
+
 /*
  * See RFC 1952:
  *
@@ -195,6 +208,7 @@ struct wtap_reader {
     gboolean dont_check_crc;    /* TRUE if we aren't supposed to check the CRC */
 #endif
     /* fast seeking */
+    gboolean random_access;     /* TRUE if we're doing random access */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
 #ifdef HAVE_ZSTD
@@ -203,6 +217,22 @@ struct wtap_reader {
 #ifdef USE_LZ4
     LZ4F_dctx *lz4_dctx;
 #endif
+#ifdef PARALLEL_DECOMPRESS
+    /* parallel decompression of zstd and LZ4 frames */
+    struct par_state *par;      /* NULL if we haven't tried it yet */
+    gboolean par_active;        /* TRUE if out is fed by par_fill() */
+    gboolean par_disabled;      /* TRUE if we can't do it for this file */
+#endif
+#ifdef HAVE_SYS_MMAN_H
+    /*
+     * Memory mapping of an uncompressed regular file.  If map is
+     * non-null, out.buf points into the mapping rather than at our
+     * own buffer, which is saved in map_out_buf.
+     */
+    guint8 *map;                /* start of the mapping, or NULL */
+    gint64 map_size;            /* size of the mapping */
+    guint8 *map_out_buf;        /* our own output buffer */
+#endif
 };
 
 /* Current read offset within a buffer. */
@@ -364,6 +394,27 @@ fast_seek_header(FILE_T file, gint64 in_pos, gint64 out_pos,
     }
 }
 
+#if defined(HAVE_ZSTD) || defined(USE_LZ4)
+/*
+ * Add a seek point at the beginning of a zstd or LZ4 frame.  Those
+ * frames are independent of one another, so all we need to restart
+ * decompression there is the offset of the frame header; as with
+ * zlib, we don't bother with points closer together than SPAN.
+ */
+static void
+frame_fast_seek_add(FILE_T file, gint64 in_pos, gint64 out_pos,
+                    compression_t compression)
+{
+    struct fast_seek_point *item = NULL;
+
+    if (file->fast_seek->len != 0)
+        item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
+
+    if (!item || item->out + SPAN < out_pos)
+        fast_seek_header(file, in_pos, out_pos, compression);
+}
+#endif
+
 static void
 fast_seek_reset(
 #ifdef HAVE_ZLIB
@@ -694,6 +745,735 @@ DIAG_ON(cast-qual)
 }
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+/*
+ * Don't bother mapping small files; the read buffer already holds
+ * most or all of them.
+ */
+#define MAP_MIN_FILE_SIZE	(1024*1024)
+
+/*
+ * Try to map the file, to whatever size it currently has.  Returns
+ * TRUE if the file is mapped, FALSE if it isn't (because it's not a
+ * regular file, is too small, or the mapping failed); not mapping
+ * the file isn't an error, we just fall back on reading it.
+ */
+static gboolean
+map_file(FILE_T state)
+{
+    ws_statb64 st;
+    void *map;
+
+    if (state->fd == -1 || ws_fstat64(state->fd, &st) == -1)
+        return FALSE;
+    if (!S_ISREG(st.st_mode) || st.st_size < MAP_MIN_FILE_SIZE)
+        return FALSE;
+    if ((guint64)st.st_size > (guint64)G_MAXSIZE)
+        return FALSE;
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, state->fd, 0);
+    if (map == MAP_FAILED)
+        return FALSE;
+
+    /*
+     * If we're going to be doing random access, tell the OS not to
+     * bother with readahead; otherwise, tell it we're reading
+     * sequentially.
+     */
+    (void)posix_madvise(map, (size_t)st.st_size,
+        state->random_access ? POSIX_MADV_RANDOM : POSIX_MADV_SEQUENTIAL);
+
+    if (state->map != NULL) {
+        /*
+         * The file has grown; replace the old mapping.  Nothing in
+         * the output buffer can still point into it.
+         */
+        munmap(state->map, (size_t)state->map_size);
+    } else
+        state->map_out_buf = state->out.buf;
+    state->map = (guint8 *)map;
+    state->map_size = st.st_size;
+    return TRUE;
+}
+
+static void
+map_unmap(FILE_T state)
+{
+    if (state->map != NULL) {
+        munmap(state->map, (size_t)state->map_size);
+        state->map = NULL;
+        state->out.buf = state->map_out_buf;
+        buf_reset(&state->out);
+    }
+}
+
+/*
+ * Make the output buffer a window onto the mapping, starting at the
+ * given offset in the file.  The window can't be bigger than
+ * MAX_READ_BUF_SIZE, as the buffer offsets and sizes are guints.
+ */
+static void
+map_window(FILE_T state, gint64 raw_off)
+{
+    gint64 left;
+
+    if (raw_off < state->map_size) {
+        left = state->map_size - raw_off;
+        state->out.buf = state->map + raw_off;
+    } else {
+        /* Past the end of the mapping; nothing to hand out. */
+        left = 0;
+        state->out.buf = state->map + state->map_size;
+    }
+    state->out.next = state->out.buf;
+    state->out.avail = left > MAX_READ_BUF_SIZE ? MAX_READ_BUF_SIZE : (guint)left;
+    state->raw_pos = raw_off + state->out.avail;
+}
+
+/*
+ * Equivalent of buf_read() for the output buffer of a mapped file.
+ * If we've run off the end of the mapping, the file may have grown
+ * since we mapped it (e.g., we're reading a file that dumpcap is
+ * still writing), so remap it before concluding that we're at the
+ * end of the file.
+ */
+static int
+map_read(FILE_T state)
+{
+    if (state->raw_pos >= state->map_size) {
+        /*
+         * If the file has grown, map_file() replaces the mapping;
+         * if it hasn't, or can't be remapped, the old one remains,
+         * and we've reached the end of the file as we know it.
+         */
+        ws_statb64 st;
+
+        if (state->fd == -1 || ws_fstat64(state->fd, &st) == -1 ||
+            st.st_size <= state->map_size || !map_file(state)) {
+            map_window(state, state->map_size);
+            state->eof = TRUE;
+            return 0;
+        }
+    }
+    map_window(state, state->raw_pos);
+    return 0;
+}
+#endif /* HAVE_SYS_MMAN_H */
+
+#ifdef PARALLEL_DECOMPRESS
+/*
+ * Parallel decompression of zstd and LZ4 frames.
+ *
+ * When reading a regular file sequentially, we read ahead whole
+ * frames on the reader thread and hand them to a pool of worker
+ * threads, each of which decompresses one frame into a buffer of its
+ * own; the output buffer is then pointed at those buffers, in file
+ * order.
+ *
+ * A frame that's too big to hold in memory, or that the workers can't
+ * decompress for any reason, including the file being damaged, is left
+ * to the streaming decoder, which reports errors as it always has; we
+ * seek back to the beginning of the frame and carry on from there.
+ */
+#define PAR_MAX_THREADS         32
+#define PAR_MAX_FRAME_SIZE      (64U*1024U*1024U)    /* compressed */
+#define PAR_MAX_OUTPUT_SIZE     (256U*1024U*1024U)   /* decompressed */
+#define PAR_MAX_INFLIGHT        (256U*1024U*1024U)   /* compressed, all frames */
+
+struct par_state;
+
+struct par_frame {
+    struct par_state *par;
+    compression_t compression;
+    gint64 raw_off;             /* offset of the frame in the file */
+    guint8 *in;                 /* compressed frame */
+    size_t in_len;
+    size_t in_alloc;
+    gboolean content_size_known;
+    guint64 content_size;       /* from the frame header, if known */
+    guint8 *out;                /* decompressed frame */
+    size_t out_len;
+    gboolean done;              /* TRUE once a worker is finished with it */
+    gboolean fallback;          /* TRUE if the streaming decoder must do it */
+};
+
+struct par_state {
+    GThreadPool *pool;
+    GMutex mtx;                 /* protects the done flags of the frames */
+    GCond cond;                 /* signaled when a frame is done */
+    GQueue frames;              /* frames being decompressed, in file order */
+    guint max_frames;           /* maximum number of frames in the queue */
+    size_t inflight;            /* compressed size of the frames in the queue */
+    compression_t compression;  /* type of the frames we're reading */
+    gboolean scan_done;         /* TRUE if there are no more frames to queue */
+    gint64 scan_stop;           /* where the frames we can queue ended */
+    gint64 skip_off;            /* frame to leave to the streaming decoder */
+    guint8 *cur_out;            /* output of the frame being delivered */
+    guint8 *saved_out_buf;      /* our own output buffer */
+};
+
+static void
+par_frame_free(struct par_frame *f)
+{
+    g_free(f->in);
+    g_free(f->out);
+    g_free(f);
+}
+
+/*
+ * Grow a frame's output buffer; returns FALSE if it's already as big
+ * as we allow, or if we're out of memory.
+ */
+static gboolean
+par_grow_out(struct par_frame *f, size_t *alloc)
+{
+    size_t new_alloc;
+    guint8 *new_out;
+
+    if (*alloc >= PAR_MAX_OUTPUT_SIZE)
+        return FALSE;
+    new_alloc = *alloc * 2;
+    if (new_alloc > PAR_MAX_OUTPUT_SIZE)
+        new_alloc = PAR_MAX_OUTPUT_SIZE;
+    new_out = (guint8 *)g_try_realloc(f->out, new_alloc);
+    if (new_out == NULL)
+        return FALSE;
+    f->out = new_out;
+    *alloc = new_alloc;
+    return TRUE;
+}
+
+#ifdef HAVE_ZSTD
+static void
+par_decompress_zstd(struct par_frame *f, size_t alloc)
+{
+    ZSTD_DCtx *dctx;
+    ZSTD_inBuffer input = { f->in, f->in_len, 0 };
+    size_t ret;
+
+    dctx = ZSTD_createDCtx();
+    if (dctx == NULL) {
+        f->fallback = TRUE;
+        return;
+    }
+    for (;;) {
+        ZSTD_outBuffer output = { f->out, alloc, f->out_len };
+
+        ret = ZSTD_decompressStream(dctx, &output, &input);
+        f->out_len = output.pos;
+        if (ZSTD_isError(ret)) {
+            f->fallback = TRUE;
+            break;
+        }
+        if (ret == 0) {
+            /* End of the frame. */
+            break;
+        }
+        if (output.pos == output.size) {
+            if (!par_grow_out(f, &alloc)) {
+                f->fallback = TRUE;
+                break;
+            }
+        } else if (input.pos == input.size) {
+            /* The frame ended prematurely. */
+            f->fallback = TRUE;
+            break;
+        }
+    }
+    ZSTD_freeDCtx(dctx);
+}
+#endif
+
+#ifdef USE_LZ4
+static void
+par_decompress_lz4(struct par_frame *f, size_t alloc)
+{
+    LZ4F_dctx *dctx;
+    size_t in_pos = 0;
+    size_t ret;
+
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION))) {
+        f->fallback = TRUE;
+        return;
+    }
+    for (;;) {
+        size_t out_size = alloc - f->out_len;
+        size_t in_size = f->in_len - in_pos;
+
+        ret = LZ4F_decompress(dctx, f->out + f->out_len, &out_size,
+                              f->in + in_pos, &in_size, NULL);
+        if (LZ4F_isError(ret)) {
+            f->fallback = TRUE;
+            break;
+        }
+        f->out_len += out_size;
+        in_pos += in_size;
+        if (ret == 0) {
+            /* End of the frame. */
+            break;
+        }
+        if (f->out_len == alloc) {
+            if (!par_grow_out(f, &alloc)) {
+                f->fallback = TRUE;
+                break;
+            }
+        } else if (in_pos == f->in_len || (out_size == 0 && in_size == 0)) {
+            /* The frame ended prematurely. */
+            f->fallback = TRUE;
+            break;
+        }
+    }
+    LZ4F_freeDecompressionContext(dctx);
+}
+#endif
+
+/* Worker thread routine. */
+static void
+par_decompress(gpointer data, gpointer user_data _U_)
+{
+    struct par_frame *f = (struct par_frame *)data;
+    struct par_state *par = f->par;
+    size_t alloc;
+
+    if (f->content_size_known)
+        alloc = (size_t)f->content_size;
+    else
+        alloc = f->in_len * 4;
+    if (alloc < GZBUFSIZE)
+        alloc = GZBUFSIZE;
+    f->out = (guint8 *)g_try_malloc(alloc);
+    if (f->out == NULL) {
+        f->fallback = TRUE;
+    } else {
+        switch (f->compression) {
+
+#ifdef HAVE_ZSTD
+        case ZSTD:
+            par_decompress_zstd(f, alloc);
+            break;
+#endif
+
+#ifdef USE_LZ4
+        case LZ4:
+            par_decompress_lz4(f, alloc);
+            break;
+#endif
+
+        default:
+            f->fallback = TRUE;
+            break;
+        }
+    }
+
+    g_mutex_lock(&par->mtx);
+    f->done = TRUE;
+    g_cond_broadcast(&par->cond);
+    g_mutex_unlock(&par->mtx);
+}
+
+/*
+ * Append the next n bytes of input to a frame.  Returns 1 on success,
+ * 0 if the frame would be too big or we hit the end of the file, and
+ * -1 on a read error.
+ */
+static int
+par_copy_in(FILE_T state, struct par_frame *f, size_t n)
+{
+    guint chunk;
+
+    if (f->in_len + n > PAR_MAX_FRAME_SIZE)
+        return 0;
+    if (f->in_len + n > f->in_alloc) {
+        size_t new_alloc = f->in_alloc == 0 ? GZBUFSIZE : f->in_alloc;
+
+        while (new_alloc < f->in_len + n)
+            new_alloc *= 2;
+        f->in = (guint8 *)g_realloc(f->in, new_alloc);
+        f->in_alloc = new_alloc;
+    }
+    while (n != 0) {
+        if (state->in.avail == 0) {
+            if (fill_in_buffer(state) == -1)
+                return -1;
+            if (state->in.avail == 0)
+                return 0;
+        }
+        chunk = state->in.avail > n ? (guint)n : state->in.avail;
+        memcpy(f->in + f->in_len, state->in.next, chunk);
+        f->in_len += chunk;
+        state->in.next += chunk;
+        state->in.avail -= chunk;
+        n -= chunk;
+    }
+    return 1;
+}
+
+#ifdef HAVE_ZSTD
+/*
+ * Read a zstd frame; see RFC 8878 for the format.
+ */
+static int
+par_read_zstd_frame(FILE_T state, struct par_frame *f)
+{
+    static const guint dict_id_sizes[4] = { 0, 1, 2, 4 };
+    guint8 descriptor;
+    gboolean single_segment;
+    guint fcs_size, fcs_off, i;
+    guint32 block_hdr;
+    int ret;
+
+    /* Magic number and frame header descriptor. */
+    if ((ret = par_copy_in(state, f, 5)) != 1)
+        return ret;
+    if (pletoh32(f->in) != 0xFD2FB528)
+        return 0;
+    descriptor = f->in[4];
+    single_segment = (descriptor >> 5) & 1;
+    if (descriptor >> 6)
+        fcs_size = 1U << (descriptor >> 6);
+    else
+        fcs_size = single_segment ? 1 : 0;
+    fcs_off = 5 + (single_segment ? 0 : 1) + dict_id_sizes[descriptor & 3];
+    if ((ret = par_copy_in(state, f, fcs_off - 5 + fcs_size)) != 1)
+        return ret;
+    if (fcs_size != 0) {
+        f->content_size_known = TRUE;
+        f->content_size = 0;
+        for (i = fcs_size; i != 0; i--)
+            f->content_size = (f->content_size << 8) | f->in[fcs_off + i - 1];
+        if (fcs_size == 2)
+            f->content_size += 256;
+        if (f->content_size > PAR_MAX_OUTPUT_SIZE)
+            return 0;
+    }
+
+    /* Blocks. */
+    do {
+        if ((ret = par_copy_in(state, f, 3)) != 1)
+            return ret;
+        block_hdr = f->in[f->in_len - 3] |
+                    (f->in[f->in_len - 2] << 8) |
+                    (f->in[f->in_len - 1] << 16);
+        switch ((block_hdr >> 1) & 3) {
+
+        case 0:     /* Raw_Block */
+        case 2:     /* Compressed_Block */
+            ret = par_copy_in(state, f, block_hdr >> 3);
+            break;
+
+        case 1:     /* RLE_Block */
+            ret = par_copy_in(state, f, 1);
+            break;
+
+        default:    /* Reserved */
+            return 0;
+        }
+        if (ret != 1)
+            return ret;
+    } while (!(block_hdr & 1));
+
+    /* Content checksum. */
+    if (descriptor & 0x04)
+        return par_copy_in(state, f, 4);
+    return 1;
+}
+#endif
+
+#ifdef USE_LZ4
+/*
+ * Read an LZ4 frame; see
+ *
+ *    https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+ *
+ * for the format.
+ */
+static int
+par_read_lz4_frame(FILE_T state, struct par_frame *f)
+{
+    guint8 flg;
+    guint32 block_size;
+    int ret;
+
+    /* Magic number, FLG byte, and BD byte. */
+    if ((ret = par_copy_in(state, f, 6)) != 1)
+        return ret;
+    if (pletoh32(f->in) != 0x184D2204)
+        return 0;
+    flg = f->in[4];
+    if ((flg >> 6) != 1 || (flg & 0x01)) {
+        /* Unknown version, or requires a dictionary. */
+        return 0;
+    }
+    /* Content size, if present, and header checksum. */
+    if ((ret = par_copy_in(state, f, ((flg & 0x08) ? 8 : 0) + 1)) != 1)
+        return ret;
+    if (flg & 0x08) {
+        f->content_size_known = TRUE;
+        f->content_size = pletoh64(&f->in[6]);
+        if (f->content_size > PAR_MAX_OUTPUT_SIZE)
+            return 0;
+    }
+
+    /* Blocks, up to the EndMark. */
+    for (;;) {
+        if ((ret = par_copy_in(state, f, 4)) != 1)
+            return ret;
+        block_size = pletoh32(&f->in[f->in_len - 4]) & 0x7FFFFFFF;
+        if (block_size == 0)
+            break;
+        if ((ret = par_copy_in(state, f, block_size + ((flg & 0x10) ? 4 : 0))) != 1)
+            return ret;
+    }
+
+    /* Content checksum. */
+    if (flg & 0x04)
+        return par_copy_in(state, f, 4);
+    return 1;
+}
+#endif
+
+/*
+ * Read ahead and queue up frames until we have as many as we allow,
+ * or we find something we can't handle.
+ */
+static int
+par_queue_frames(FILE_T state)
+{
+    struct par_state *par = state->par;
+    struct par_frame *f;
+    gint64 raw_off;
+    int ret;
+
+    while (!par->scan_done && par->frames.length < par->max_frames &&
+           par->inflight < PAR_MAX_INFLIGHT) {
+        if (state->in.avail == 0 && fill_in_buffer(state) == -1)
+            return -1;
+        raw_off = state->raw_pos - state->in.avail;
+        if (state->in.avail == 0) {
+            /* End of file. */
+            par->scan_done = TRUE;
+            par->scan_stop = raw_off;
+            break;
+        }
+
+        f = g_new0(struct par_frame, 1);
+        f->par = par;
+        f->compression = par->compression;
+        f->raw_off = raw_off;
+        switch (par->compression) {
+
+#ifdef HAVE_ZSTD
+        case ZSTD:
+            ret = par_read_zstd_frame(state, f);
+            break;
+#endif
+
+#ifdef USE_LZ4
+        case LZ4:
+            ret = par_read_lz4_frame(state, f);
+            break;
+#endif
+
+        default:
+            ret = 0;
+            break;
+        }
+        if (ret != 1) {
+            par_frame_free(f);
+            if (ret == -1)
+                return -1;
+            /*
+             * Not a frame we can handle here; stop, and let gz_head()
+             * and the streaming decoders deal with it.
+             */
+            par->scan_done = TRUE;
+            par->scan_stop = raw_off;
+            break;
+        }
+        par->inflight += f->in_len;
+        g_queue_push_tail(&par->frames, f);
+        g_thread_pool_push(par->pool, f, NULL);
+    }
+    return 0;
+}
+
+static void
+par_wait(struct par_state *par, struct par_frame *f)
+{
+    g_mutex_lock(&par->mtx);
+    while (!f->done)
+        g_cond_wait(&par->cond, &par->mtx);
+    g_mutex_unlock(&par->mtx);
+}
+
+/*
+ * Stop parallel decompression, discarding any frames we've queued up,
+ * and go back to using our own output buffer.
+ */
+static void
+par_stop(FILE_T state)
+{
+    struct par_state *par = state->par;
+    struct par_frame *f;
+
+    if (!state->par_active)
+        return;
+    while ((f = (struct par_frame *)g_queue_pop_head(&par->frames)) != NULL) {
+        par_wait(par, f);
+        par_frame_free(f);
+    }
+    par->inflight = 0;
+    g_free(par->cur_out);
+    par->cur_out = NULL;
+    state->out.buf = par->saved_out_buf;
+    buf_reset(&state->out);
+    state->par_active = FALSE;
+}
+
+/*
+ * Stop parallel decompression, and resume reading the file at the
+ * specified offset, looking for a compression header there.
+ */
+static int
+par_leave(FILE_T state, gint64 off)
+{
+    par_stop(state);
+    if (ws_lseek64(state->fd, off, SEEK_SET) == -1) {
+        state->err = errno;
+        state->err_info = NULL;
+        return -1;
+    }
+    state->raw_pos = off;
+    buf_reset(&state->in);
+    state->eof = FALSE;
+    state->last_compression = state->compression;
+    state->compression = UNKNOWN;
+    return 0;
+}
+
+/*
+ * Start parallel decompression at the frame at the current input
+ * position, if we can; if we can't, the streaming decoder is used.
+ */
+static void
+par_start(FILE_T state, compression_t compression)
+{
+    struct par_state *par = state->par;
+    ws_statb64 st;
+    guint threads;
+
+    /*
+     * Random access is done a record at a time, and the records are
+     * typically scattered over the file; reading ahead would do more
+     * harm than good.
+     */
+    if (state->random_access || state->par_disabled)
+        return;
+
+    if (par == NULL) {
+        /*
+         * We need to be able to seek back to a frame we decided not
+         * to decompress here, so this has to be a regular file, and
+         * it's pointless if we only have one processor.
+         */
+        threads = g_get_num_processors();
+        if (threads > PAR_MAX_THREADS)
+            threads = PAR_MAX_THREADS;
+        if (threads < 2 || ws_fstat64(state->fd, &st) == -1 ||
+            !S_ISREG(st.st_mode)) {
+            state->par_disabled = TRUE;
+            return;
+        }
+        par = g_new0(struct par_state, 1);
+        par->pool = g_thread_pool_new(par_decompress, NULL, (gint)threads,
+                                      FALSE, NULL);
+        if (par->pool == NULL) {
+            g_free(par);
+            state->par_disabled = TRUE;
+            return;
+        }
+        g_mutex_init(&par->mtx);
+        g_cond_init(&par->cond);
+        g_queue_init(&par->frames);
+        par->max_frames = threads * 2;
+        par->skip_off = -1;
+        state->par = par;
+    }
+
+    if (state->raw_pos - state->in.avail == par->skip_off) {
+        /* We already gave up on this frame. */
+        return;
+    }
+    par->compression = compression;
+    par->scan_done = FALSE;
+    par->saved_out_buf = state->out.buf;
+    state->par_active = TRUE;
+}
+
+/*
+ * Equivalent of fill_out_buffer() when decompressing in parallel:
+ * hand out the next decompressed frame.
+ */
+static int
+par_fill(FILE_T state)
+{
+    struct par_state *par = state->par;
+    struct par_frame *f;
+    gint64 off;
+
+    /* We're done with the previous frame. */
+    state->out.buf = par->saved_out_buf;
+    buf_reset(&state->out);
+    g_free(par->cur_out);
+    par->cur_out = NULL;
+
+    if (par_queue_frames(state) == -1)
+        return -1;
+    f = (struct par_frame *)g_queue_pop_head(&par->frames);
+    if (f == NULL) {
+        /* Nothing more for us to do. */
+        return par_leave(state, par->scan_stop);
+    }
+    par_wait(par, f);
+    par->inflight -= f->in_len;
+    if (f->fallback) {
+        /*
+         * Have the streaming decoder start at this frame; it'll
+         * report any errors in the frame.
+         */
+        off = f->raw_off;
+        par_frame_free(f);
+        par->skip_off = off;
+        return par_leave(state, off);
+    }
+
+    if (state->fast_seek)
+        frame_fast_seek_add(state, f->raw_off, state->pos, f->compression);
+    par->cur_out = f->out;
+    f->out = NULL;
+    state->out.buf = par->cur_out;
+    state->out.next = par->cur_out;
+    state->out.avail = (guint)f->out_len;
+    par_frame_free(f);
+    return 0;
+}
+
+static void
+par_free(FILE_T state)
+{
+    struct par_state *par = state->par;
+
+    if (par == NULL)
+        return;
+    par_stop(state);
+    g_thread_pool_free(par->pool, FALSE, TRUE);
+    g_mutex_clear(&par->mtx);
+    g_cond_clear(&par->cond);
+    g_free(par);
+    state->par = NULL;
+}
+#endif /* PARALLEL_DECOMPRESS */
+
 static int
 gz_head(FILE_T state)
 {
@@ -861,9 +1641,14 @@ gz_head(FILE_T state)
     /* FD 37 7A 58 5A 00 */
 #endif
 
+    /*
+     * Check the magic number at the current position in the input
+     * buffer, not at the beginning, as this might be a frame after
+     * the first one.
+     */
     if (state->in.avail >= 4
-        && state->in.buf[0] == 0x28 && state->in.buf[1] == 0xb5
-        && state->in.buf[2] == 0x2f && state->in.buf[3] == 0xfd) {
+        && state->in.next[0] == 0x28 && state->in.next[1] == 0xb5
+        && state->in.next[2] == 0x2f && state->in.next[3] == 0xfd) {
 #ifdef HAVE_ZSTD
         const size_t ret = ZSTD_initDStream(state->zstd_dctx);
         if (ZSTD_isError(ret)) {
@@ -872,8 +1657,12 @@ gz_head(FILE_T state)
             return -1;
         }
 
+        if (state->fast_seek)
+            frame_fast_seek_add(state, state->raw_pos - state->in.avail, state->pos, ZSTD);
+
         state->compression = ZSTD;
         state->is_compressed = TRUE;
+        par_start(state, ZSTD);
         return 0;
 #else
         state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
@@ -883,8 +1672,8 @@ gz_head(FILE_T state)
     }
 
     if (state->in.avail >= 4
-        && state->in.buf[0] == 0x04 && state->in.buf[1] == 0x22
-        && state->in.buf[2] == 0x4d && state->in.buf[3] == 0x18) {
+        && state->in.next[0] == 0x04 && state->in.next[1] == 0x22
+        && state->in.next[2] == 0x4d && state->in.next[3] == 0x18) {
 #ifdef USE_LZ4
 #if LZ4_VERSION_NUMBER >= 10800
         LZ4F_resetDecompressionContext(state->lz4_dctx);
@@ -897,8 +1686,12 @@ gz_head(FILE_T state)
             return -1;
         }
 #endif
+        if (state->fast_seek)
+            frame_fast_seek_add(state, state->raw_pos - state->in.avail, state->pos, LZ4);
+
         state->compression = LZ4;
         state->is_compressed = TRUE;
+        par_start(state, LZ4);
         return 0;
 #else
         state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
@@ -918,6 +1711,21 @@ gz_head(FILE_T state)
     /* not a compressed file -- copy everything we've read into the
        input buffer to the output buffer and fall to raw i/o */
     already_read = bytes_in_buffer(&state->in);
+#ifdef HAVE_SYS_MMAN_H
+    /*
+     * If the file is entirely uncompressed, and is a regular file,
+     * map it and hand out data directly from the mapping, rather
+     * than reading it into the output buffer.  The data we've
+     * already read into the input buffer is at the beginning
+     * of the first window onto the mapping.
+     */
+    if (!state->is_compressed && (state->map != NULL || map_file(state))) {
+        map_window(state, state->raw_pos - already_read);
+        buf_reset(&state->in);
+        state->compression = UNCOMPRESSED;
+        return 0;
+    }
+#endif
     if (already_read != 0) {
         memcpy(state->out.buf, state->in.buf, already_read);
         state->out.avail = already_read;
@@ -938,7 +1746,17 @@ fill_out_buffer(FILE_T state)
         if (state->out.avail != 0)                /* got some data from gz_head() */
             return 0;
     }
+#ifdef PARALLEL_DECOMPRESS
+    if (state->par_active)
+        return par_fill(state);
+#endif
     if (state->compression == UNCOMPRESSED) {           /* straight copy */
+#ifdef HAVE_SYS_MMAN_H
+        if (state->map != NULL) {
+            if (map_read(state) < 0)
+                return -1;
+        } else
+#endif
         if (buf_read(state, &state->out) < 0)
             return -1;
     }
@@ -1049,6 +1867,9 @@ gz_skip(FILE_T state, gint64 len)
 static void
 gz_reset(FILE_T state)
 {
+#ifdef PARALLEL_DECOMPRESS
+    par_stop(state);
+#endif
     buf_reset(&state->out);       /* no output data available */
     state->eof = FALSE;           /* not at end of file */
     state->compression = UNKNOWN; /* look for compression header */
@@ -1103,6 +1924,9 @@ file_fdopen(int fd)
 
     state->fast_seek_cur = NULL;
     state->fast_seek = NULL;
+#ifdef HAVE_SYS_MMAN_H
+    state->map = NULL;
+#endif
 
     /* open the file with the appropriate mode (or just use fd) */
     state->fd = fd;
@@ -1289,8 +2113,9 @@ file_open(const char *path)
 }
 
 void
-file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek)
 {
+    stream->random_access = random_flag;
     stream->fast_seek = seek;
 }
 
@@ -1398,6 +2223,25 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         }
     }
 
+#ifdef HAVE_SYS_MMAN_H
+    /*
+     * We're not seeking within the buffer.  If the file is mapped,
+     * and we're within the raw area, just move the window onto the
+     * mapping; the raw offset of uncompressed data is its offset
+     * relative to where we started reading.
+     */
+    if (file->map != NULL && file->compression == UNCOMPRESSED &&
+        file->pos + offset >= file->raw) {
+        map_window(file, file->start + file->pos + offset);
+        file->eof = FALSE;
+        file->err = 0;
+        file->err_info = NULL;
+        buf_reset(&file->in);
+        file->pos += offset;
+        return file->pos;
+    }
+#endif
+
     /*
      * We're not seeking within the buffer.  Do we have "fast seek" data
      * for the location to which we will be seeking, and is the offset
@@ -1429,11 +2273,17 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             off2 = here->out;
         } else
 #endif
-        {
+        if (here->compression == ZSTD || here->compression == LZ4) {
+            off = here->in;
+            off2 = here->out;
+        } else {
             off2 = (file->pos + offset);
             off = here->in + (off2 - here->out);
         }
 
+#ifdef PARALLEL_DECOMPRESS
+        par_stop(file);
+#endif
         if (ws_lseek64(file->fd, off, SEEK_SET) == -1) {
             *err = errno;
             return -1;
@@ -1481,6 +2331,13 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             file->compression = ZLIB;
         } else
 #endif
+        if (here->compression == ZSTD || here->compression == LZ4) {
+            /*
+             * We're at the beginning of a frame; have gz_head()
+             * look at the frame header and reset the decompressor.
+             */
+            file->compression = UNKNOWN;
+        } else
             file->compression = here->compression;
 
         offset = (file->pos + offset) - off2;
@@ -1593,6 +2450,44 @@ file_tell_raw(FILE_T stream)
     return stream->raw_pos;
 }
 
+/*
+ * Tell the OS that we'll soon be reading len bytes starting at the
+ * given offset, so that it can start reading them in now rather than
+ * when we seek to and read them.  This is only a hint; it's a no-op
+ * for compressed files, as offsets in the uncompressed data don't
+ * correspond to offsets in the file, and on platforms that don't
+ * support it.
+ */
+void
+file_prefetch(FILE_T stream, gint64 offset, gint64 len)
+{
+    if (stream->is_compressed || offset < 0 || len <= 0)
+        return;
+#ifdef HAVE_SYS_MMAN_H
+    if (stream->map != NULL) {
+        gint64 page_size = (gint64)sysconf(_SC_PAGESIZE);
+        gint64 start, end;
+
+        if (offset >= stream->map_size)
+            return;
+        end = offset + len;
+        if (end > stream->map_size)
+            end = stream->map_size;
+        if (page_size <= 0)
+            page_size = 4096;
+        start = offset - (offset % page_size);
+        (void)posix_madvise(stream->map + start, (size_t)(end - start),
+            POSIX_MADV_WILLNEED);
+        return;
+    }
+#endif
+#ifdef HAVE_POSIX_FADVISE
+    if (stream->fd != -1)
+        (void)posix_fadvise(stream->fd, (off_t)offset, (off_t)len,
+            POSIX_FADV_WILLNEED);
+#endif
+}
+
 int
 file_fstat(FILE_T stream, ws_statb64 *statb, int *err)
 {
@@ -1907,6 +2802,12 @@ file_close(FILE_T file)
     int fd = file->fd;
 
     /* free memory and close file */
+#ifdef PARALLEL_DECOMPRESS
+    par_free(file);
+#endif
+#ifdef HAVE_SYS_MMAN_H
+    map_unmap(file);
+#endif
     if (file->size) {
 #ifdef HAVE_ZLIB
         inflateEnd(&(file->strm));
@@ -1933,6 +2834,294 @@ file_close(FILE_T file)
         ws_close(fd);
 }
 
+/*
+ * Fast seek index files.
+ *
+ * The fast seek points we accumulate while reading a compressed file
+ * can be saved to an index file and loaded again the next time the
+ * file is opened, so that random access doesn't require decompressing
+ * everything up to the desired location first.
+ *
+ * The index file begins with a header:
+ *
+ *    8 bytes of magic number;
+ *    4-byte version number;
+ *    4-byte span between seek points;
+ *    8-byte size of the capture file;
+ *    8-byte last modification time of the capture file;
+ *    8-byte count of seek points;
+ *
+ * followed by the seek points, each of which is:
+ *
+ *    8-byte offset in the capture file;
+ *    8-byte offset in the uncompressed data;
+ *    1-byte compression type;
+ *    1-byte number of bits from the previous byte, for zlib;
+ *    2 bytes of padding;
+ *    4-byte Adler-32 checksum so far, for zlib;
+ *    4-byte total output so far, for zlib;
+ *    4-byte length of the compressed zlib window, for zlib;
+ *
+ * followed, for zlib seek points, by the 32K window preceding the
+ * seek point, deflated to the specified length.
+ *
+ * All values are little-endian.  An index whose size or modification
+ * time doesn't match that of the capture file is ignored.
+ */
+static const guint8 fast_seek_index_magic[8] = { 'W', 'S', 'S', 'E', 'E', 'K', 'I', 'X' };
+#define FAST_SEEK_INDEX_VERSION      1
+#define FAST_SEEK_INDEX_HDR_SIZE     40
+#define FAST_SEEK_INDEX_POINT_SIZE   32
+
+gboolean
+file_fast_seek_index_save(const GPtrArray *fast_seek, const ws_statb64 *statb,
+                          const char *path, int *err)
+{
+    guint8 hdr[FAST_SEEK_INDEX_HDR_SIZE];
+    guint8 point_hdr[FAST_SEEK_INDEX_POINT_SIZE];
+#ifdef HAVE_ZLIB
+    unsigned char *window_buf;
+    uLongf window_len;
+#endif
+    FILE *fp;
+    guint i;
+
+    *err = 0;
+
+    /*
+     * Don't bother with an index for an uncompressed file; we can
+     * seek directly to any location in it.
+     */
+    for (i = 0; i < fast_seek->len; i++) {
+        if (((const struct fast_seek_point *)fast_seek->pdata[i])->compression != UNCOMPRESSED)
+            break;
+    }
+    if (i == fast_seek->len)
+        return FALSE;
+
+    fp = ws_fopen(path, "wb");
+    if (fp == NULL) {
+        *err = errno;
+        return FALSE;
+    }
+
+    memcpy(hdr, fast_seek_index_magic, sizeof fast_seek_index_magic);
+    phtole32(&hdr[8], FAST_SEEK_INDEX_VERSION);
+    phtole32(&hdr[12], (guint32)SPAN);
+    phtole64(&hdr[16], (guint64)statb->st_size);
+    phtole64(&hdr[24], (guint64)statb->st_mtime);
+    phtole64(&hdr[32], fast_seek->len);
+    if (fwrite(hdr, sizeof hdr, 1, fp) != 1)
+        goto write_err;
+
+#ifdef HAVE_ZLIB
+    window_buf = (unsigned char *)g_malloc(compressBound(ZLIB_WINSIZE));
+#endif
+    for (i = 0; i < fast_seek->len; i++) {
+        const struct fast_seek_point *point = (const struct fast_seek_point *)fast_seek->pdata[i];
+
+        memset(point_hdr, 0, sizeof point_hdr);
+        phtole64(&point_hdr[0], (guint64)point->in);
+        phtole64(&point_hdr[8], (guint64)point->out);
+        point_hdr[16] = (guint8)point->compression;
+#ifdef HAVE_ZLIB
+        window_len = 0;
+        if (point->compression == ZLIB) {
+#ifdef HAVE_INFLATEPRIME
+            point_hdr[17] = (guint8)point->data.zlib.bits;
+#endif
+            phtole32(&point_hdr[20], point->data.zlib.adler);
+            phtole32(&point_hdr[24], point->data.zlib.total_out);
+            window_len = compressBound(ZLIB_WINSIZE);
+            if (compress2(window_buf, &window_len, point->data.zlib.window,
+                          ZLIB_WINSIZE, Z_BEST_SPEED) != Z_OK) {
+                g_free(window_buf);
+                *err = WTAP_ERR_INTERNAL;
+                fclose(fp);
+                ws_unlink(path);
+                return FALSE;
+            }
+            phtole32(&point_hdr[28], (guint32)window_len);
+        }
+#endif
+        if (fwrite(point_hdr, sizeof point_hdr, 1, fp) != 1) {
+#ifdef HAVE_ZLIB
+            g_free(window_buf);
+#endif
+            goto write_err;
+        }
+#ifdef HAVE_ZLIB
+        if (window_len != 0 && fwrite(window_buf, window_len, 1, fp) != 1) {
+            g_free(window_buf);
+            goto write_err;
+        }
+#endif
+    }
+#ifdef HAVE_ZLIB
+    g_free(window_buf);
+#endif
+
+    if (fclose(fp) == EOF) {
+        *err = errno;
+        ws_unlink(path);
+        return FALSE;
+    }
+    return TRUE;
+
+write_err:
+    *err = errno;
+    fclose(fp);
+    ws_unlink(path);
+    return FALSE;
+}
+
+gboolean
+file_fast_seek_index_load(GPtrArray *fast_seek, const ws_statb64 *statb,
+                          const char *path, int *err)
+{
+    guint8 hdr[FAST_SEEK_INDEX_HDR_SIZE];
+    guint8 point_hdr[FAST_SEEK_INDEX_POINT_SIZE];
+#ifdef HAVE_ZLIB
+    unsigned char *window_buf = NULL;
+    uLongf window_len;
+#endif
+    GPtrArray *points;
+    guint64 count, i;
+    struct fast_seek_point *point;
+    FILE *fp;
+
+    *err = 0;
+    fp = ws_fopen(path, "rb");
+    if (fp == NULL) {
+        /* No index isn't an error. */
+        if (errno != ENOENT)
+            *err = errno;
+        return FALSE;
+    }
+
+    /*
+     * An index that's for a different version of the file, or was
+     * written with a different span, or is for a different version of
+     * the format, is just stale; ignore it.
+     */
+    if (fread(hdr, sizeof hdr, 1, fp) != 1 ||
+        memcmp(hdr, fast_seek_index_magic, sizeof fast_seek_index_magic) != 0 ||
+        pletoh32(&hdr[8]) != FAST_SEEK_INDEX_VERSION ||
+        pletoh32(&hdr[12]) != (guint32)SPAN ||
+        pletoh64(&hdr[16]) != (guint64)statb->st_size ||
+        pletoh64(&hdr[24]) != (guint64)statb->st_mtime) {
+        fclose(fp);
+        return FALSE;
+    }
+    count = pletoh64(&hdr[32]);
+
+    points = g_ptr_array_new();
+    for (i = 0; i < count; i++) {
+        compression_t compression;
+        gint64 in, out;
+
+        if (fread(point_hdr, sizeof point_hdr, 1, fp) != 1)
+            goto bad_index;
+        in = (gint64)pletoh64(&point_hdr[0]);
+        out = (gint64)pletoh64(&point_hdr[8]);
+        compression = (compression_t)point_hdr[16];
+
+        /* The points must be in order, as fast_seek_find() does a binary search. */
+        if (points->len != 0 &&
+            ((struct fast_seek_point *)points->pdata[points->len - 1])->out >= out)
+            goto bad_index;
+
+        switch (compression) {
+
+        case UNCOMPRESSED:
+#ifdef HAVE_ZLIB
+        case GZIP_AFTER_HEADER:
+#endif
+#ifdef HAVE_ZSTD
+        case ZSTD:
+#endif
+#ifdef USE_LZ4
+        case LZ4:
+#endif
+            point = g_new(struct fast_seek_point, 1);
+            break;
+
+#ifdef HAVE_ZLIB
+        case ZLIB:
+            window_len = pletoh32(&point_hdr[28]);
+            if (window_len == 0 || window_len > compressBound(ZLIB_WINSIZE))
+                goto bad_index;
+            if (window_buf == NULL)
+                window_buf = (unsigned char *)g_malloc(compressBound(ZLIB_WINSIZE));
+            if (fread(window_buf, window_len, 1, fp) != 1)
+                goto bad_index;
+#ifndef HAVE_INFLATEPRIME
+            /*
+             * We can't use points that don't start on a byte
+             * boundary; skip them.
+             */
+            if (point_hdr[17] != 0)
+                continue;
+#endif
+            point = g_new(struct fast_seek_point, 1);
+#ifdef HAVE_INFLATEPRIME
+            point->data.zlib.bits = point_hdr[17];
+#endif
+            point->data.zlib.adler = pletoh32(&point_hdr[20]);
+            point->data.zlib.total_out = pletoh32(&point_hdr[24]);
+            {
+                uLongf uncompressed_len = ZLIB_WINSIZE;
+
+                if (uncompress(point->data.zlib.window, &uncompressed_len,
+                               window_buf, window_len) != Z_OK ||
+                    uncompressed_len != ZLIB_WINSIZE) {
+                    g_free(point);
+                    goto bad_index;
+                }
+            }
+            break;
+#endif
+
+        default:
+            /*
+             * A compression type we don't know about or can't
+             * handle; we can't trust anything after this.
+             */
+            goto bad_index;
+        }
+        point->in = in;
+        point->out = out;
+        point->compression = compression;
+        g_ptr_array_add(points, point);
+    }
+#ifdef HAVE_ZLIB
+    g_free(window_buf);
+#endif
+    fclose(fp);
+
+    /*
+     * Replace whatever points we've accumulated so far; they're a
+     * prefix of the ones in the index.
+     */
+    for (i = 0; i < fast_seek->len; i++)
+        g_free(fast_seek->pdata[i]);
+    g_ptr_array_set_size(fast_seek, 0);
+    for (i = 0; i < points->len; i++)
+        g_ptr_array_add(fast_seek, points->pdata[i]);
+    g_ptr_array_free(points, TRUE);
+    return TRUE;
+
+bad_index:
+#ifdef HAVE_ZLIB
+    g_free(window_buf);
+#endif
+    for (i = 0; i < points->len; i++)
+        g_free(points->pdata[i]);
+    g_ptr_array_free(points, TRUE);
+    fclose(fp);
+    return FALSE;
+}
+
 #ifdef HAVE_ZLIB
 /* internal gzip file state data structure for writing */
 struct wtap_writer {
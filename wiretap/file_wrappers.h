@@ -19,6 +19,7 @@ extern void file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArra
 WS_DLL_PUBLIC gint64 file_seek(FILE_T stream, gint64 offset, int whence, int *err);
 WS_DLL_PUBLIC gint64 file_tell(FILE_T stream);
 extern gint64 file_tell_raw(FILE_T stream);
+extern void file_prefetch(FILE_T stream, gint64 offset, gint64 len);
 extern int file_fstat(FILE_T stream, ws_statb64 *statb, int *err);
 WS_DLL_PUBLIC gboolean file_iscompressed(FILE_T stream);
 WS_DLL_PUBLIC int file_read(void *buf, unsigned int count, FILE_T file);
@@ -32,6 +33,8 @@ extern void file_clearerr(FILE_T stream);
 extern void file_fdclose(FILE_T file);
 extern int file_fdreopen(FILE_T file, const char *path);
 extern void file_close(FILE_T file);
+extern gboolean file_fast_seek_index_save(const GPtrArray *fast_seek, const ws_statb64 *statb, const char *path, int *err);
+extern gboolean file_fast_seek_index_load(GPtrArray *fast_seek, const ws_statb64 *statb, const char *path, int *err);
 
 #ifdef HAVE_ZLIB
 typedef struct wtap_writer *GZWFILE_T;
@@ -29,7 +29,9 @@ wtap_open_return_val json_open(wtap *wth, int *err, gchar **err_info)
 
     /* XXX checking the full file contents might be a bit expensive, maybe
      * resort to simpler heuristics like '{' or '[' (with some other chars)? */
-    filebuf = (guint8*)g_malloc0(MAX_FILE_SIZE);
+    /* Only the bytes we read are looked at, so don't bother zeroing the
+     * buffer; that would touch all of it for every file we're asked about. */
+    filebuf = (guint8*)g_malloc(MAX_FILE_SIZE);
     if (!filebuf)
         return WTAP_OPEN_ERROR;
 
@@ -68,10 +68,15 @@ static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info, gint64 *data_offset);
 static gboolean libpcap_seek_read(wtap *wth, gint64 seek_off,
     wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+static gboolean libpcap_raw_record_len(wtap *wth, gint64 seek_off,
+    guint32 *len, int *err, gchar **err_info);
+static void libpcap_read_batch(wtap *wth, wtap_rec_batch *batch,
+    int *err, gchar **err_info);
 static gboolean libpcap_read_packet(wtap *wth, FILE_T fh,
     wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
 static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
     struct pcaprec_ss990915_hdr *hdr);
+static int libpcap_record_header_size(pcap_variant_t variant);
 static void libpcap_close(wtap *wth);
 
 static gboolean libpcap_dump_pcap(wtap_dumper *wdh, const wtap_rec *rec,
@@ -86,6 +91,8 @@ static gboolean libpcap_dump_pcap_ss991029(wtap_dumper *wdh,
     const wtap_rec *rec, const guint8 *pd, int *err, gchar **err_info);
 static gboolean libpcap_dump_pcap_nokia(wtap_dumper *wdh, const wtap_rec *rec,
     const guint8 *pd, int *err, gchar **err_info);
+static gboolean libpcap_dump_raw(wtap_dumper *wdh, const guint8 *data,
+    size_t len, int *err, gchar **err_info);
 
 /*
  * Subfields of the field containing the link-layer header type.
@@ -295,6 +302,7 @@ wtap_open_return_val libpcap_open(wtap *wth, int *err, gchar **err_info)
 	/* This is a libpcap file */
 	wth->subtype_read = libpcap_read;
 	wth->subtype_seek_read = libpcap_seek_read;
+	wth->subtype_read_batch = libpcap_read_batch;
 	wth->subtype_close = libpcap_close;
 	wth->snapshot_length = hdr.snaplen;
 	libpcap = g_new0(libpcap_t, 1);
@@ -341,6 +349,12 @@ wtap_open_return_val libpcap_open(wtap *wth, int *err, gchar **err_info)
 		libpcap->lengths_swapped = NOT_SWAPPED;
 		break;
 	}
+	/*
+	 * Records in our byte order, with the lengths in the order we
+	 * write them, can be copied unchanged to a file we write.
+	 */
+	if (!byte_swapped && libpcap->lengths_swapped == NOT_SWAPPED)
+		wth->subtype_raw_record_len = libpcap_raw_record_len;
 	libpcap->version_major = hdr.version_major;
 	libpcap->version_minor = hdr.version_minor;
 	/*
@@ -902,6 +916,27 @@ static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
 	return libpcap_read_packet(wth, wth->fh, rec, buf, err, err_info);
 }
 
+/*
+ * Read packets into a batch, appending their data to the batch's
+ * buffer, until the batch is full or a read fails.
+ */
+static void
+libpcap_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+    gchar **err_info)
+{
+	wtap_rec *rec;
+
+	while (batch->count < batch->max_records) {
+		rec = &batch->recs[batch->count];
+		wtap_init_rec(wth, rec);
+		batch->offsets[batch->count] = file_tell(wth->fh);
+		if (!libpcap_read_packet(wth, wth->fh, rec, &batch->data,
+		    err, err_info))
+			return;
+		wtap_rec_batch_add(batch);
+	}
+}
+
 static gboolean
 libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info)
@@ -918,6 +953,34 @@ libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
 	return TRUE;
 }
 
+static gboolean
+libpcap_raw_record_len(wtap *wth, gint64 seek_off, guint32 *len,
+    int *err, gchar **err_info)
+{
+	struct pcaprec_ss990915_hdr hdr;
+	libpcap_t *libpcap = (libpcap_t *)wth->priv;
+
+	if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
+		return FALSE;
+
+	if (!libpcap_read_header(wth, wth->random_fh, err, err_info, &hdr)) {
+		if (*err == 0)
+			*err = WTAP_ERR_SHORT_READ;
+		return FALSE;
+	}
+
+	if (hdr.hdr.incl_len > wtap_max_snaplen_for_encap(wth->file_encap)) {
+		*err = WTAP_ERR_BAD_FILE;
+		*err_info = ws_strdup_printf("pcap: File has %u-byte packet, bigger than maximum of %u",
+		    hdr.hdr.incl_len,
+		    wtap_max_snaplen_for_encap(wth->file_encap));
+		return FALSE;
+	}
+
+	*len = libpcap_record_header_size(libpcap->variant) + hdr.hdr.incl_len;
+	return TRUE;
+}
+
 static gboolean
 libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info)
@@ -928,6 +991,7 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	int phdr_len;
 	libpcap_t *libpcap = (libpcap_t *)wth->priv;
 	gboolean is_nokia;
+	gsize data_start;
 
 	if (!libpcap_read_header(wth, fh, err, err_info, &hdr))
 		return FALSE;
@@ -1008,13 +1072,23 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	rec->rec_header.packet_header.len = orig_size;
 
 	/*
-	 * Read the packet data.
+	 * If the caller only wants the record headers, skip over the
+	 * packet data on sequential reads; there's nothing to post-process.
 	 */
+	if (wth->skip_packet_data && fh == wth->fh)
+		return wtap_read_bytes(fh, NULL, packet_size, err, err_info);
+
+	/*
+	 * Read the packet data.  It's appended to the buffer, which,
+	 * if we're reading a batch, holds the preceding packets' data.
+	 */
+	data_start = ws_buffer_length(buf);
 	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
 		return FALSE;	/* failed */
 
 	pcap_read_post_process(is_nokia, wth->file_encap, rec,
-	    ws_buffer_start_ptr(buf), libpcap->byte_swapped, libpcap->fcs_len);
+	    ws_buffer_start_ptr(buf) + data_start, libpcap->byte_swapped,
+	    libpcap->fcs_len);
 	return TRUE;
 }
 
@@ -1028,31 +1102,7 @@ static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
 	guint32 temp;
 	libpcap_t *libpcap = (libpcap_t *)wth->priv;
 
-	switch (libpcap->variant) {
-
-	case PCAP:
-	case PCAP_AIX:
-	case PCAP_NSEC:
-		bytes_to_read = sizeof (struct pcaprec_hdr);
-		break;
-
-	case PCAP_SS990417:
-	case PCAP_SS991029:
-		bytes_to_read = sizeof (struct pcaprec_modified_hdr);
-		break;
-
-	case PCAP_SS990915:
-		bytes_to_read = sizeof (struct pcaprec_ss990915_hdr);
-		break;
-
-	case PCAP_NOKIA:
-		bytes_to_read = sizeof (struct pcaprec_nokia_hdr);
-		break;
-
-	default:
-		bytes_to_read = 0;
-		ws_assert_not_reached();
-	}
+	bytes_to_read = libpcap_record_header_size(libpcap->variant);
 	if (!wtap_read_bytes_or_eof(fh, hdr, bytes_to_read, err, err_info))
 		return FALSE;
 
@@ -1090,6 +1140,32 @@ static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
 	return TRUE;
 }
 
+/* Size of the per-record header for a variant. */
+static int libpcap_record_header_size(pcap_variant_t variant)
+{
+	switch (variant) {
+
+	case PCAP:
+	case PCAP_AIX:
+	case PCAP_NSEC:
+		return (int)sizeof (struct pcaprec_hdr);
+
+	case PCAP_SS990417:
+	case PCAP_SS991029:
+		return (int)sizeof (struct pcaprec_modified_hdr);
+
+	case PCAP_SS990915:
+		return (int)sizeof (struct pcaprec_ss990915_hdr);
+
+	case PCAP_NOKIA:
+		return (int)sizeof (struct pcaprec_nokia_hdr);
+
+	default:
+		ws_assert_not_reached();
+		return 0;
+	}
+}
+
 /* Returns 0 if we could write the specified encapsulation type,
    an error indication otherwise. */
 static int libpcap_dump_can_write_encap(int encap)
@@ -1146,6 +1222,7 @@ libpcap_dump_open_pcap(wtap_dumper *wdh, int *err, gchar **err_info _U_)
 {
 	/* This is a libpcap file */
 	wdh->subtype_write = libpcap_dump_pcap;
+	wdh->subtype_write_raw = libpcap_dump_raw;
 
 	/* Write the file header. */
 	return libpcap_dump_write_file_header(wdh, PCAP_MAGIC, err);
@@ -1159,6 +1236,7 @@ libpcap_dump_open_pcap_nsec(wtap_dumper *wdh, int *err, gchar **err_info _U_)
 {
 	/* This is a nanosecond-resolution libpcap file */
 	wdh->subtype_write = libpcap_dump_pcap_nsec;
+	wdh->subtype_write_raw = libpcap_dump_raw;
 
 	/* Write the file header. */
 	return libpcap_dump_write_file_header(wdh, PCAP_NSEC_MAGIC, err);
@@ -1173,6 +1251,7 @@ libpcap_dump_open_pcap_ss990417(wtap_dumper *wdh, int *err,
 {
 	/* This is a modified-by-patch-SS990417 libpcap file */
 	wdh->subtype_write = libpcap_dump_pcap_ss990417;
+	wdh->subtype_write_raw = libpcap_dump_raw;
 
 	/* Write the file header. */
 	return libpcap_dump_write_file_header(wdh, PCAP_MAGIC, err);
@@ -1187,6 +1266,7 @@ libpcap_dump_open_pcap_ss990915(wtap_dumper *wdh, int *err,
 {
 	/* This is a modified-by-patch-SS990915 libpcap file */
 	wdh->subtype_write = libpcap_dump_pcap_ss990915;
+	wdh->subtype_write_raw = libpcap_dump_raw;
 
 	/* Write the file header. */
 	return libpcap_dump_write_file_header(wdh, PCAP_MODIFIED_MAGIC, err);
@@ -1201,6 +1281,7 @@ libpcap_dump_open_pcap_ss991029(wtap_dumper *wdh, int *err,
 {
 	/* This is a modified-by-patch-SS991029 libpcap file */
 	wdh->subtype_write = libpcap_dump_pcap_ss991029;
+	wdh->subtype_write_raw = libpcap_dump_raw;
 
 	/* Write the file header. */
 	return libpcap_dump_write_file_header(wdh, PCAP_MODIFIED_MAGIC, err);
@@ -1232,6 +1313,7 @@ libpcap_dump_open_pcap_nokia(wtap_dumper *wdh, int *err, gchar **err_info _U_)
 {
 	/* This is a Nokia libpcap file */
 	wdh->subtype_write = libpcap_dump_pcap_nokia;
+	wdh->subtype_write_raw = libpcap_dump_raw;
 
 	/* Write the file header. */
 	return libpcap_dump_write_file_header(wdh, PCAP_MAGIC, err);
@@ -1480,6 +1562,15 @@ libpcap_dump_pcap_nokia(wtap_dumper *wdh, const wtap_rec *rec,
 	    pd, err);
 }
 
+/* Write records copied unchanged from a file of the same type.
+   Returns TRUE on success, FALSE on failure. */
+static gboolean
+libpcap_dump_raw(wtap_dumper *wdh, const guint8 *data, size_t len,
+    int *err, gchar **err_info _U_)
+{
+	return wtap_dump_file_write(wdh, data, len, err);
+}
+
 static const struct supported_block_type pcap_blocks_supported[] = {
 	/*
 	 * We support packet blocks, with no comments or other options.
@@ -305,21 +305,113 @@ merge_select_frame_type(const int file_type, int in_file_count, merge_in_file_t
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * Priority queue of the input files that have a record available,
+ * ordered by the record that should be written first, so that
+ * picking the next record is O(log N) in the number of input files
+ * rather than O(N).
+ */
+typedef struct {
+    guint *files;       /* binary min-heap of indices into in_files */
+    guint  count;       /* number of entries in the heap */
+    gint   refill;      /* index of the file to read from next, or -1 if none */
+    gint   last_read;   /* index of the file the last call read from, or -1 if it read from all of them */
+} merge_heap_t;
+
+/*
+ * Returns TRUE if the record from in_files[l] should be written before
+ * the one from in_files[r].
+ *
+ * Records with no time stamp are treated as earlier than all other
+ * records; among those, the one from the lower-numbered file goes
+ * first.  Yes, this means you won't get a chronological merge of those
+ * records, but you obviously *can't* get that.  Among records with
+ * the same time stamp, the one from the higher-numbered file goes
+ * first, as has always been the case.
  */
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_rec_before(const merge_in_file_t in_files[], guint l, guint r)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
+    const wtap_rec *lrec = &in_files[l].rec;
+    const wtap_rec *rrec = &in_files[r].rec;
+
+    if (!(lrec->presence_flags & WTAP_HAS_TS)) {
+        if (!(rrec->presence_flags & WTAP_HAS_TS))
+            return l < r;
         return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
+    }
+    if (!(rrec->presence_flags & WTAP_HAS_TS))
         return FALSE;
+    if (lrec->ts.secs != rrec->ts.secs)
+        return lrec->ts.secs < rrec->ts.secs;
+    if (lrec->ts.nsecs != rrec->ts.nsecs)
+        return lrec->ts.nsecs < rrec->ts.nsecs;
+    return l > r;
+}
+
+static void
+merge_heap_push(merge_heap_t *heap, const merge_in_file_t in_files[],
+                guint file)
+{
+    guint pos = heap->count++;
+    guint parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (!merge_rec_before(in_files, file, heap->files[parent]))
+            break;
+        heap->files[pos] = heap->files[parent];
+        pos = parent;
+    }
+    heap->files[pos] = file;
+}
+
+static guint
+merge_heap_pop(merge_heap_t *heap, const merge_in_file_t in_files[])
+{
+    guint top = heap->files[0];
+    guint file = heap->files[--heap->count];
+    guint pos = 0;
+    guint child;
+
+    for (;;) {
+        child = 2 * pos + 1;
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count &&
+            merge_rec_before(in_files, heap->files[child + 1], heap->files[child]))
+            child++;
+        if (!merge_rec_before(in_files, heap->files[child], file))
+            break;
+        heap->files[pos] = heap->files[child];
+        pos = child;
+    }
+    if (heap->count != 0)
+        heap->files[pos] = file;
+    return top;
+}
+
+/*
+ * Read the next record from in_files[i], adding the file to the heap
+ * if we got one.  Returns FALSE on a read error.
+ */
+static gboolean
+merge_heap_fill(merge_heap_t *heap, merge_in_file_t in_files[], guint i,
+                int *err, gchar **err_info)
+{
+    gint64 data_offset;
+
+    if (!wtap_read(in_files[i].wth, &in_files[i].rec,
+                   &in_files[i].frame_buffer, err, err_info,
+                   &data_offset)) {
+        if (*err != 0) {
+            in_files[i].state = GOT_ERROR;
+            return FALSE;
+        }
+        in_files[i].state = AT_EOF;
+    } else {
+        in_files[i].state = RECORD_PRESENT;
+        merge_heap_push(heap, in_files, i);
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
     return TRUE;
 }
 
@@ -335,6 +427,10 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
+ * @param heap the queue of files with records available; its files
+ * array must have room for in_file_count entries, and before the first
+ * call it must have a count of 0 and refill set to -1; on return, its
+ * last_read indicates which files were read from
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
  * @param err wiretap error, if failed
@@ -344,70 +440,47 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * all files
  */
 static merge_in_file_t *
-merge_read_packet(int in_file_count, merge_in_file_t in_files[],
-                  int *err, gchar **err_info)
+merge_read_packet(merge_heap_t *heap, int in_file_count,
+                  merge_in_file_t in_files[], int *err, gchar **err_info)
 {
     int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
-
-    /*
-     * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
-     */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
+    guint ei;
 
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
+    if (heap->refill >= 0) {
+        /*
+         * We returned a record from this file last time; get its
+         * next record.
+         */
+        i = heap->refill;
+        heap->refill = -1;
+        heap->last_read = i;
+        if (!merge_heap_fill(heap, in_files, i, err, err_info))
+            return &in_files[i];
+    } else {
+        /*
+         * Make sure we have a record available from each file that's
+         * not at EOF; that's only the case on the first call.
+         */
+        heap->last_read = -1;
+        for (i = 0; i < in_file_count; i++) {
+            if (in_files[i].state == RECORD_NOT_PRESENT) {
+                if (!merge_heap_fill(heap, in_files, i, err, err_info))
                     return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
             }
         }
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    ei = merge_heap_pop(heap, in_files);
+
     /* We'll need to read another packet from this file. */
     in_files[ei].state = RECORD_NOT_PRESENT;
+    heap->refill = ei;
 
     /* Count this packet. */
     in_files[ei].packet_num++;
@@ -1022,6 +1095,12 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
+    merge_heap_t        heap;
+
+    heap.files = g_new(guint, in_file_count);
+    heap.count = 0;
+    heap.refill = -1;
+    heap.last_read = -1;
 
     for (;;) {
         *err = 0;
@@ -1031,7 +1110,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(&heap, in_file_count, in_files, err,
                                         err_info);
         }
 
@@ -1060,7 +1139,17 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
 
         if (wtap_file_type_subtype_supports_block(file_type,
                                                   WTAP_BLOCK_IF_ID_AND_INFO) != BLOCK_NOT_SUPPORTED) {
-            if (!process_new_idbs(pdh, in_files, in_file_count, mode, idb_inf, err, err_info)) {
+            gboolean idbs_ok;
+
+            /*
+             * New IDBs can only have been read from the files we just
+             * read from; when merging, that's usually just one of them.
+             */
+            if (!do_append && heap.last_read >= 0)
+                idbs_ok = process_new_idbs(pdh, &in_files[heap.last_read], 1, mode, idb_inf, err, err_info);
+            else
+                idbs_ok = process_new_idbs(pdh, in_files, in_file_count, mode, idb_inf, err, err_info);
+            if (!idbs_ok) {
                 status = MERGE_ERR_CANT_WRITE_OUTFILE;
                 break;
             }
@@ -1137,6 +1226,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         }
         wtap_rec_reset(rec);
     }
+    g_free(heap.files);
 
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
@@ -20,6 +20,7 @@
 
 #include "wtap-int.h"
 #include <wsutil/buffer.h>
+#include <wsutil/strtoi.h>
 #include "file_wrappers.h"
 #include <stdlib.h>
 #include <string.h>
@@ -37,32 +38,62 @@
    is actually an mpeg2 ts */
 #define SYNC_STEPS   10
 
+/* maximum number of packets we put into one record; keeps records
+   well below WTAP_MAX_PACKET_SIZE_STANDARD */
+#define MAX_PACKETS_PER_RECORD 1024
 
 typedef struct {
     guint32 start_offset;
     guint64 bitrate;
     /* length of trailing data (e.g. FEC) that's appended after each packet */
     guint8  trailer_len;
+    /* number of consecutive packets delivered in one record */
+    guint   packets_per_record;
+    /* error that ended the previous record early, reported by the next read */
+    int     pending_err;
+    gchar  *pending_err_info;
 } mp2t_filetype_t;
 
 static int mp2t_file_type_subtype = -1;
 
 void register_mp2t(void);
 
+/*
+ * Read up to packets_per_record packets into one record.  If reading a
+ * packet after the first one fails, the record ends with the packets
+ * before it, and the error is returned in rest_err and rest_err_info
+ * (0 and NULL at the end of the file).
+ */
 static gboolean
 mp2t_read_packet(mp2t_filetype_t *mp2t, FILE_T fh, gint64 offset,
                  wtap_rec *rec, Buffer *buf, int *err,
-                 gchar **err_info)
+                 gchar **err_info, int *rest_err, gchar **rest_err_info)
 {
     guint64 tmp;
+    guint8 *pd;
+    guint count;
+
+    *rest_err = 0;
+    *rest_err_info = NULL;
 
     /*
-     * MP2T_SIZE will always be less than WTAP_MAX_PACKET_SIZE_STANDARD, so
-     * we don't have to worry about the packet being too big.
+     * MP2T_SIZE * MAX_PACKETS_PER_RECORD will always be less than
+     * WTAP_MAX_PACKET_SIZE_STANDARD, so we don't have to worry about
+     * the record being too big.
      */
-    ws_buffer_assure_space(buf, MP2T_SIZE);
-    if (!wtap_read_bytes_or_eof(fh, ws_buffer_start_ptr(buf), MP2T_SIZE, err, err_info))
+    ws_buffer_assure_space(buf, (gsize)MP2T_SIZE * mp2t->packets_per_record);
+    pd = ws_buffer_start_ptr(buf);
+    if (!wtap_read_bytes_or_eof(fh, pd, MP2T_SIZE, err, err_info))
         return FALSE;
+    for (count = 1; count < mp2t->packets_per_record; count++) {
+        /* skip the trailer of the previous packet */
+        if (mp2t->trailer_len != 0 &&
+            !wtap_read_bytes_or_eof(fh, NULL, mp2t->trailer_len, rest_err, rest_err_info))
+            break;
+        if (!wtap_read_bytes_or_eof(fh, pd + (gsize)MP2T_SIZE * count, MP2T_SIZE,
+                                    rest_err, rest_err_info))
+            break;
+    }
 
     rec->rec_type = REC_TYPE_PACKET;
     rec->block = wtap_block_create(WTAP_BLOCK_PACKET);
@@ -88,8 +119,8 @@ mp2t_read_packet(mp2t_filetype_t *mp2t, FILE_T fh, gint64 offset,
     rec->ts.secs = (time_t)(tmp / mp2t->bitrate);
     rec->ts.nsecs = (int)((tmp % mp2t->bitrate) * 1000000000 / mp2t->bitrate);
 
-    rec->rec_header.packet_header.caplen = MP2T_SIZE;
-    rec->rec_header.packet_header.len = MP2T_SIZE;
+    rec->rec_header.packet_header.caplen = MP2T_SIZE * count;
+    rec->rec_header.packet_header.len = MP2T_SIZE * count;
 
     return TRUE;
 }
@@ -99,16 +130,34 @@ mp2t_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
         gchar **err_info, gint64 *data_offset)
 {
     mp2t_filetype_t *mp2t;
+    int rest_err;
+    gchar *rest_err_info;
 
     mp2t = (mp2t_filetype_t*) wth->priv;
 
+    if (mp2t->pending_err != 0) {
+        *err = mp2t->pending_err;
+        *err_info = mp2t->pending_err_info;
+        mp2t->pending_err = 0;
+        mp2t->pending_err_info = NULL;
+        return FALSE;
+    }
+
     *data_offset = file_tell(wth->fh);
 
     if (!mp2t_read_packet(mp2t, wth->fh, *data_offset, rec, buf, err,
-                          err_info)) {
+                          err_info, &rest_err, &rest_err_info)) {
         return FALSE;
     }
 
+    if (rec->rec_header.packet_header.caplen < MP2T_SIZE * mp2t->packets_per_record) {
+        /* the record ended early, at the end of the file or at an error that
+           we report on the next read; any trailer has already been skipped */
+        mp2t->pending_err = rest_err;
+        mp2t->pending_err_info = rest_err_info;
+        return TRUE;
+    }
+
     /* if there's a trailer, skip it and go to the start of the next packet */
     if (mp2t->trailer_len!=0) {
         if (!wtap_read_bytes(wth->fh, NULL, mp2t->trailer_len, err, err_info)) {
@@ -124,6 +173,8 @@ mp2t_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
         Buffer *buf, int *err, gchar **err_info)
 {
     mp2t_filetype_t *mp2t;
+    int rest_err;
+    gchar *rest_err_info;
 
     if (-1 == file_seek(wth->random_fh, seek_off, SEEK_SET, err)) {
         return FALSE;
@@ -132,14 +183,24 @@ mp2t_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
     mp2t = (mp2t_filetype_t*) wth->priv;
 
     if (!mp2t_read_packet(mp2t, wth->random_fh, seek_off, rec, buf,
-                          err, err_info)) {
+                          err, err_info, &rest_err, &rest_err_info)) {
         if (*err == 0)
             *err = WTAP_ERR_SHORT_READ;
         return FALSE;
     }
+    /* the sequential read ended this record at the same place */
+    g_free(rest_err_info);
     return TRUE;
 }
 
+static void
+mp2t_close(wtap *wth)
+{
+    mp2t_filetype_t *mp2t = (mp2t_filetype_t*) wth->priv;
+
+    g_free(mp2t->pending_err_info);
+}
+
 static guint64
 mp2t_read_pcr(guint8 *buffer)
 {
@@ -302,6 +363,9 @@ mp2t_open(wtap *wth, int *err, gchar **err_info)
     mp2t_filetype_t *mp2t;
     wtap_open_return_val status;
     guint64 bitrate;
+    const char *s;
+    gint32 n;
+    guint packets_per_record = 1;
 
 
     if (!wtap_read_bytes(wth->fh, buffer, MP2T_SIZE, err, err_info)) {
@@ -378,11 +442,19 @@ found:
         return WTAP_OPEN_ERROR;
     }
 
+    /* number of packets to group into one record */
+    if ((s = getenv("MP2T_PACKETS_PER_RECORD")) != NULL) {
+        if (ws_strtoi32(s, NULL, &n) && n >= 1 && n <= MAX_PACKETS_PER_RECORD) {
+            packets_per_record = n;
+        }
+    }
+
     wth->file_type_subtype = mp2t_file_type_subtype;
     wth->file_encap = WTAP_ENCAP_MPEG_2_TS;
     wth->file_tsprec = WTAP_TSPREC_NSEC;
     wth->subtype_read = mp2t_read;
     wth->subtype_seek_read = mp2t_seek_read;
+    wth->subtype_close = mp2t_close;
     wth->snapshot_length = 0;
 
     mp2t = g_new(mp2t_filetype_t, 1);
@@ -391,6 +463,9 @@ found:
     mp2t->start_offset = first;
     mp2t->trailer_len = trailer_len;
     mp2t->bitrate = bitrate;
+    mp2t->packets_per_record = packets_per_record;
+    mp2t->pending_err = 0;
+    mp2t->pending_err_info = NULL;
 
     return WTAP_OPEN_MINE;
 }
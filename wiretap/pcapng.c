@@ -48,6 +48,12 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
                  wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+static gboolean
+pcapng_raw_record_len(wtap *wth, gint64 seek_off, guint32 *len,
+                      int *err, gchar **err_info);
+static void
+pcapng_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+                  gchar **err_info);
 static void
 pcapng_close(wtap *wth);
 
@@ -910,7 +916,8 @@ pcapng_process_nflx_custom_option(wtapng_block_t *wblock,
         if (wblock->type == BLOCK_TYPE_CB_COPY) {
             ws_buffer_assure_space(wblock->frame_buffer, length);
             wblock->rec->rec_header.custom_block_header.length = length + 4;
-            memcpy(ws_buffer_start_ptr(wblock->frame_buffer), value, length);
+            memcpy(ws_buffer_end_ptr(wblock->frame_buffer), value, length);
+            ws_buffer_increase_length(wblock->frame_buffer, length);
             memcpy(&temp, value, sizeof(guint64));
             temp = GUINT64_FROM_LE(temp);
             wblock->rec->ts.secs = section_info->bblog_offset_tv_sec + temp;
@@ -1067,7 +1074,14 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                        pcapng_opt_byte_order_e byte_order,
                        int *err, gchar **err_info)
 {
-    guint8 *option_content; /* Allocate as large as the options block */
+    /*
+     * Most blocks, such as EPBs with just flags and a drop count,
+     * have only a few bytes of options; read those into a buffer on
+     * the stack rather than allocating one for every block.
+     */
+    guint32 option_content_small[32];
+    guint8 *option_content_alloc = NULL;
+    guint8 *option_content; /* As large as the options block */
     guint opt_bytes_remaining;
     const guint8 *option_ptr;
     const pcapng_option_header_t *oh;
@@ -1080,25 +1094,31 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
         return TRUE;
     }
 
-    /* Allocate enough memory to hold all options */
-    option_content = (guint8 *)g_try_malloc(opt_cont_buf_len);
-    if (option_content == NULL) {
-        *err = ENOMEM;  /* we assume we're out of memory */
-        return FALSE;
+    if (opt_cont_buf_len <= sizeof option_content_small) {
+        option_content = (guint8 *)option_content_small;
+    } else {
+        /* Allocate enough memory to hold all options */
+        option_content_alloc = (guint8 *)g_try_malloc(opt_cont_buf_len);
+        if (option_content_alloc == NULL) {
+            *err = ENOMEM;  /* we assume we're out of memory */
+            return FALSE;
+        }
+        option_content = option_content_alloc;
     }
 
     /* Read all the options into the buffer */
     if (!wtap_read_bytes(fh, option_content, opt_cont_buf_len, err, err_info)) {
         ws_debug("failed to read options");
-        g_free(option_content);
+        g_free(option_content_alloc);
         return FALSE;
     }
 
     /*
      * Now process them.
      * option_ptr starts out aligned on at least a 4-byte boundary, as
-     * that's what g_try_malloc() gives us, and each option is padded
-     * to a length that's a multiple of 4 bytes, so it remains aligned.
+     * that's what g_try_malloc() and a guint32 array give us, and each
+     * option is padded to a length that's a multiple of 4 bytes, so it
+     * remains aligned.
      */
     option_ptr = &option_content[0];
     opt_bytes_remaining = opt_cont_buf_len;
@@ -1109,7 +1129,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
         if (sizeof (*oh) > opt_bytes_remaining) {
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data for option header");
-            g_free(option_content);
+            g_free(option_content_alloc);
             return FALSE;
         }
         option_code = oh->option_code;
@@ -1151,7 +1171,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data to handle option of length %u",
                                         option_length);
-            g_free(option_content);
+            g_free(option_content_alloc);
             return FALSE;
         }
 
@@ -1176,7 +1196,7 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                                                   option_ptr,
                                                   byte_order,
                                                   err, err_info)) {
-                    g_free(option_content);
+                    g_free(option_content_alloc);
                     return FALSE;
                 }
                 break;
@@ -1186,14 +1206,14 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                     !(*process_option)(wblock, (const section_info_t *)section_info, option_code,
                                        option_length, option_ptr,
                                        err, err_info)) {
-                    g_free(option_content);
+                    g_free(option_content_alloc);
                     return FALSE;
                 }
         }
         option_ptr += rounded_option_length; /* multiple of 4 bytes, so it remains aligned */
         opt_bytes_remaining -= rounded_option_length;
     }
-    g_free(option_content);
+    g_free(option_content_alloc);
     return TRUE;
 }
 
@@ -2140,6 +2160,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     guint64 ts;
     int pseudo_header_len;
     int fcslen;
+    gsize data_start;
 
     wblock->block = wtap_block_create(WTAP_BLOCK_PACKET);
 
@@ -2313,9 +2334,15 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->ts.secs = (time_t)(wblock->rec->ts.secs + iface_info.tsoffset);
 
     /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                packet.cap_len - pseudo_header_len, err, err_info))
-        return FALSE;
+    data_start = ws_buffer_length(wblock->frame_buffer);
+    if (wblock->skip_data) {
+        if (!wtap_read_bytes(fh, NULL, packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+    } else {
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+    }
     block_read += packet.cap_len - pseudo_header_len;
 
     /* jump over potential padding bytes at end of the packet data */
@@ -2357,9 +2384,11 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
         wtap_block_add_uint64_option(wblock->block, OPT_PKT_DROPCOUNT, (guint64)packet.drops_count);
     }
 
-    pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
-                           section_info->byte_swapped, fcslen);
+    if (!wblock->skip_data) {
+        pcap_read_post_process(FALSE, iface_info.wtap_encap,
+                               wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer) + data_start,
+                               section_info->byte_swapped, fcslen);
+    }
 
     /*
      * We return these to the caller in pcapng_read().
@@ -2390,6 +2419,7 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wtapng_simple_packet_t simple_packet;
     guint32 padding;
     int pseudo_header_len;
+    gsize data_start;
 
     /*
      * Is this block long enough to be an SPB?
@@ -2497,9 +2527,15 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
 
     /* "Simple Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                simple_packet.cap_len, err, err_info))
-        return FALSE;
+    data_start = ws_buffer_length(wblock->frame_buffer);
+    if (wblock->skip_data) {
+        if (!wtap_read_bytes(fh, NULL, simple_packet.cap_len, err, err_info))
+            return FALSE;
+    } else {
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    simple_packet.cap_len, err, err_info))
+            return FALSE;
+    }
 
     /* jump over potential padding bytes at end of the packet data */
     if ((simple_packet.cap_len % 4) != 0) {
@@ -2507,9 +2543,11 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
             return FALSE;
     }
 
-    pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
-                           section_info->byte_swapped, iface_info.fcslen);
+    if (!wblock->skip_data) {
+        pcap_read_post_process(FALSE, iface_info.wtap_encap,
+                               wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer) + data_start,
+                               section_info->byte_swapped, iface_info.fcslen);
+    }
 
     /*
      * We return these to the caller in pcapng_read().
@@ -3276,6 +3314,7 @@ pcapng_read_systemd_journal_export_block(wtap *wth, FILE_T fh, pcapng_block_head
     guint32 entry_length;
     guint64 rt_ts;
     gboolean have_ts = FALSE;
+    gsize data_start;
 
     if (bh->block_total_length < MIN_SYSTEMD_JOURNAL_EXPORT_BLOCK_SIZE) {
         *err = WTAP_ERR_BAD_FILE;
@@ -3287,6 +3326,7 @@ pcapng_read_systemd_journal_export_block(wtap *wth, FILE_T fh, pcapng_block_head
     entry_length = bh->block_total_length - MIN_BLOCK_SIZE;
 
     /* Includes padding bytes. */
+    data_start = ws_buffer_length(wblock->frame_buffer);
     if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
                                 entry_length, err, err_info)) {
         return FALSE;
@@ -3298,7 +3338,7 @@ pcapng_read_systemd_journal_export_block(wtap *wth, FILE_T fh, pcapng_block_head
      */
     ws_buffer_assure_space(wblock->frame_buffer, entry_length+1);
 
-    gchar *buf_ptr = (gchar *) ws_buffer_start_ptr(wblock->frame_buffer);
+    gchar *buf_ptr = (gchar *) ws_buffer_start_ptr(wblock->frame_buffer) + data_start;
     while (entry_length > 0 && buf_ptr[entry_length-1] == '\0') {
         entry_length--;
     }
@@ -3943,6 +3983,7 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
     /* we don't expect any packet blocks yet */
     wblock.frame_buffer = NULL;
     wblock.rec = NULL;
+    wblock.skip_data = FALSE;
 
     switch (pcapng_read_section_header_block(wth->fh, &bh, &first_section,
                                              &wblock, err, err_info)) {
@@ -4027,9 +4068,18 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
 
     wth->subtype_read = pcapng_read;
     wth->subtype_seek_read = pcapng_seek_read;
+    wth->subtype_read_batch = pcapng_read_batch;
     wth->subtype_close = pcapng_close;
     wth->file_type_subtype = pcapng_file_type_subtype;
 
+    /*
+     * Blocks in a section in our byte order can be copied unchanged
+     * to a pcapng file we write, as long as there's only one section;
+     * wtap_dump_can_copy_raw() checks for that.
+     */
+    if (!first_section.byte_swapped)
+        wth->subtype_raw_record_len = pcapng_raw_record_len;
+
     /* Always initialize the lists of Decryption Secret Blocks, Name
      * Resolution Blocks, and Sysdig meta event blocks such that a
      * wtap_dumper can refer to them right after opening the capture
@@ -4128,6 +4178,7 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 
     wblock.frame_buffer  = buf;
     wblock.rec = rec;
+    wblock.skip_data = wth->skip_packet_data;
 
     /* read next block */
     while (1) {
@@ -4176,6 +4227,59 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     return TRUE;
 }
 
+/*
+ * Read records into a batch until it's full or a read fails.
+ * pcapng_read() appends each record's data to the buffer it's
+ * handed, so the data goes straight into the batch's buffer.
+ */
+static void
+pcapng_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+                  gchar **err_info)
+{
+    wtap_rec *rec;
+
+    while (batch->count < batch->max_records) {
+        rec = &batch->recs[batch->count];
+        wtap_init_rec(wth, rec);
+        if (!pcapng_read(wth, rec, &batch->data, err, err_info,
+                         &batch->offsets[batch->count]))
+            return;
+        wtap_rec_batch_add(batch);
+    }
+}
+
+/* Get the total length of the block at a file position */
+static gboolean
+pcapng_raw_record_len(wtap *wth, gint64 seek_off, guint32 *len,
+                      int *err, gchar **err_info)
+{
+    pcapng_block_header_t bh;
+
+    if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) < 0) {
+        return FALSE;   /* Seek error */
+    }
+    if (!wtap_read_bytes(wth->random_fh, &bh, sizeof bh, err, err_info)) {
+        return FALSE;
+    }
+
+    /* The block is in our byte order; see pcapng_open(). */
+    bh.block_total_length = ROUND_TO_4BYTE(bh.block_total_length);
+    if (bh.block_total_length < MIN_BLOCK_SIZE) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("pcapng: total block length %u is too small (< %u)",
+                                    bh.block_total_length, MIN_BLOCK_SIZE);
+        return FALSE;
+    }
+    if (bh.block_total_length > MAX_BLOCK_SIZE) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("pcapng: total block length %u is too large (> %u)",
+                                    bh.block_total_length, MAX_BLOCK_SIZE);
+        return FALSE;
+    }
+    *len = bh.block_total_length;
+    return TRUE;
+}
+
 /* classic wtap: seek to file position and read packet */
 static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
@@ -4226,6 +4330,7 @@ pcapng_seek_read(wtap *wth, gint64 seek_off,
 
     wblock.frame_buffer = buf;
     wblock.rec = rec;
+    wblock.skip_data = FALSE;
 
     /* read the block */
     if (!pcapng_read_block(wth, wth->random_fh, pcapng, section_info,
@@ -5250,9 +5355,11 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
     const union wtap_pseudo_header *pseudo_header = &rec->rec_header.packet_header.pseudo_header;
     pcapng_block_header_t bh;
     pcapng_enhanced_packet_block_t epb;
+    guint8 head[sizeof bh + sizeof epb];
+    guint8 tail[3 + sizeof bh.block_total_length];
+    guint32 tail_len;
     guint32 options_size = 0;
     guint64 ts;
-    const guint32 zero_pad = 0;
     guint32 pad_len;
     guint32 phdr_len;
     guint32 options_total_length = 0;
@@ -5341,14 +5448,18 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
         return FALSE;
     }
 
-    /* write (enhanced) packet block header */
+    /*
+     * The block header and fixed content are written together, as
+     * are the padding and the block trailer if there are no options
+     * between them, so that a typical packet takes three writes
+     * rather than as many as five.
+     */
+
+    /* (enhanced) packet block header */
     bh.block_type = BLOCK_TYPE_EPB;
     bh.block_total_length = (guint32)sizeof(bh) + (guint32)sizeof(epb) + phdr_len + rec->rec_header.packet_header.caplen + pad_len + options_total_length + options_size + 4;
 
-    if (!wtap_dump_file_write(wdh, &bh, sizeof bh, err))
-        return FALSE;
-
-    /* write block fixed content */
+    /* block fixed content */
     /* Calculate the time stamp as a 64-bit integer. */
     ts = ((guint64)rec->ts.secs) * int_data_mand->time_units_per_second +
         (((guint64)rec->ts.nsecs) * int_data_mand->time_units_per_second) / 1000000000;
@@ -5361,7 +5472,9 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
     epb.captured_len        = rec->rec_header.packet_header.caplen + phdr_len;
     epb.packet_len          = rec->rec_header.packet_header.len + phdr_len;
 
-    if (!wtap_dump_file_write(wdh, &epb, sizeof epb, err))
+    memcpy(head, &bh, sizeof bh);
+    memcpy(head + sizeof bh, &epb, sizeof epb);
+    if (!wtap_dump_file_write(wdh, head, sizeof head, err))
         return FALSE;
 
     /* write pseudo header */
@@ -5374,20 +5487,25 @@ pcapng_write_enhanced_packet_block(wtap_dumper *wdh, const wtap_rec *rec,
         return FALSE;
 
     /* write padding (if any) */
-    if (pad_len != 0) {
-        if (!wtap_dump_file_write(wdh, &zero_pad, pad_len, err))
-            return FALSE;
-    }
-
-    /* Write options, if we have any */
+    memset(tail, 0, pad_len);
+    tail_len = pad_len;
     if (options_size != 0) {
+        if (tail_len != 0) {
+            if (!wtap_dump_file_write(wdh, tail, tail_len, err))
+                return FALSE;
+            tail_len = 0;
+        }
+
+        /* Write options */
         if (!write_options(wdh, rec->block, write_wtap_epb_option, err))
             return FALSE;
     }
 
     /* write block footer */
-    if (!wtap_dump_file_write(wdh, &bh.block_total_length,
-                              sizeof bh.block_total_length, err))
+    memcpy(tail + tail_len, &bh.block_total_length,
+           sizeof bh.block_total_length);
+    tail_len += (guint32)sizeof bh.block_total_length;
+    if (!wtap_dump_file_write(wdh, tail, tail_len, err))
         return FALSE;
 
     return TRUE;
@@ -6565,6 +6683,20 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
     return TRUE;
 }
 
+/* Write blocks copied unchanged from a pcapng file.
+   Returns TRUE on success, FALSE on failure. */
+static gboolean pcapng_dump_raw(wtap_dumper *wdh, const guint8 *data,
+                                size_t len, int *err, gchar **err_info _U_)
+{
+    /* As with records we encode, write any blocks collected since the
+     * last write first, so that those blocks precede the ones using them. */
+    if (!pcapng_write_internal_blocks(wdh, err)) {
+        return FALSE;
+    }
+
+    return wtap_dump_file_write(wdh, data, len, err);
+}
+
 /* Finish writing to a dump file.
    Returns TRUE on success, FALSE on failure. */
 static gboolean pcapng_dump_finish(wtap_dumper *wdh, int *err,
@@ -6613,6 +6745,7 @@ pcapng_dump_open(wtap_dumper *wdh, int *err, gchar **err_info _U_)
     /* This is a pcapng file */
     wdh->subtype_add_idb = pcapng_add_idb;
     wdh->subtype_write = pcapng_dump;
+    wdh->subtype_write_raw = pcapng_dump_raw;
     wdh->subtype_finish = pcapng_dump_finish;
 
     /* write the section header block */
@@ -67,7 +67,8 @@ typedef struct wtapng_block_s {
     gboolean     internal;       /* TRUE if this block type shouldn't be returned from pcapng_read() */
     wtap_block_t block;
     wtap_rec     *rec;
-    Buffer       *frame_buffer;
+    Buffer       *frame_buffer;   /* record data is appended to this; it may already hold other records' data */
+    gboolean     skip_data;      /* TRUE if packet data should be skipped rather than read into frame_buffer */
 } wtapng_block_t;
 
 /* Section data in private struct */
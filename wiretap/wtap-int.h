@@ -29,6 +29,10 @@ typedef gboolean (*subtype_read_func)(struct wtap*, wtap_rec *,
                                       Buffer *, int *, char **, gint64 *);
 typedef gboolean (*subtype_seek_read_func)(struct wtap*, gint64, wtap_rec *,
                                            Buffer *, int *, char **);
+typedef void (*subtype_read_batch_func)(struct wtap*, wtap_rec_batch *,
+                                        int *, char **);
+typedef gboolean (*subtype_raw_record_len_func)(struct wtap*, gint64,
+                                                guint32 *, int *, char **);
 
 /**
  * Struct holding data of the currently read file.
@@ -54,6 +58,8 @@ struct wtap {
 
     subtype_read_func           subtype_read;
     subtype_seek_read_func      subtype_seek_read;
+    subtype_read_batch_func     subtype_read_batch;     /**< NULL if reads are done a record at a time */
+    subtype_raw_record_len_func subtype_raw_record_len; /**< NULL if records can't be copied unchanged */
     void                        (*subtype_sequential_close)(struct wtap*);
     void                        (*subtype_close)(struct wtap*);
     int                         file_encap;    /* per-file, for those
@@ -76,6 +82,8 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    guint                       fast_seek_index_len;  /* number of fast_seek points loaded from an index */
+    gboolean                    skip_packet_data;     /* sequential reads needn't return packet bytes */
 };
 
 struct wtap_dumper;
@@ -91,6 +99,9 @@ typedef gboolean (*subtype_add_idb_func)(struct wtap_dumper*, wtap_block_t,
 typedef gboolean (*subtype_write_func)(struct wtap_dumper*,
                                        const wtap_rec *rec,
                                        const guint8*, int*, gchar**);
+typedef gboolean (*subtype_write_raw_func)(struct wtap_dumper*,
+                                           const guint8*, size_t,
+                                           int*, gchar**);
 typedef gboolean (*subtype_finish_func)(struct wtap_dumper*, int*, gchar**);
 
 struct wtap_dumper {
@@ -106,12 +117,14 @@ struct wtap_dumper {
     wtap_compression_type   compression_type;
     gboolean                needs_reload;    /* TRUE if the file requires re-loading after saving with wtap */
     gint64                  bytes_dumped;
+    char                    *io_buffer;      /* our stdio buffer, if we replaced the standard one */
 
     void                    *priv;           /* this one holds per-file state and is free'd automatically by wtap_dump_close() */
     void                    *wslua_data;     /* this one holds wslua state info and is not free'd */
 
     subtype_add_idb_func    subtype_add_idb; /* add an IDB, writing it as necessary */
     subtype_write_func      subtype_write;   /* write out a record */
+    subtype_write_raw_func  subtype_write_raw; /* write out records copied from a file of this type, or NULL */
     subtype_finish_func     subtype_finish;  /* write out information to finish writing file */
 
     addrinfo_lists_t        *addrinfo_lists; /**< Struct containing lists of resolved addresses */
@@ -316,6 +329,23 @@ gboolean
 wtap_read_bytes(FILE_T fh, void *buf, unsigned int count, int *err,
     gchar **err_info);
 
+/*
+ * Initialize a record before reading it.
+ */
+void
+wtap_init_rec(wtap *wth, wtap_rec *rec);
+
+/*
+ * Add a record that was just read into a batch, its data having been
+ * appended to the batch's data.
+ */
+static inline void
+wtap_rec_batch_add(wtap_rec_batch *batch)
+{
+    batch->count++;
+    batch->data_offsets[batch->count] = ws_buffer_length(&batch->data);
+}
+
 /*
  * Read packet data into a Buffer, growing the buffer as necessary.
  *
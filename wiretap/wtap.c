@@ -11,6 +11,7 @@
 #define WS_LOG_DOMAIN LOG_DOMAIN_WIRETAP
 
 #include <string.h>
+#include <errno.h>
 
 #include <sys/types.h>
 
@@ -22,6 +23,7 @@
 #include <wsutil/buffer.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/exported_pdu_tlvs.h>
+#include <wsutil/ws_trace.h>
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
 #endif
@@ -1547,6 +1549,295 @@ g_fast_seek_item_free(gpointer data, gpointer user_data _U_)
 	g_free(data);
 }
 
+gboolean
+wtap_load_fast_seek_index(wtap *wth, const char *path, int *err)
+{
+	ws_statb64 statb;
+
+	*err = 0;
+	if (wth->fast_seek == NULL || wth->random_fh == NULL)
+		return FALSE;
+	if (file_fstat(wth->random_fh, &statb, err) == -1)
+		return FALSE;
+	if (!file_fast_seek_index_load(wth->fast_seek, &statb, path, err))
+		return FALSE;
+	wth->fast_seek_index_len = wth->fast_seek->len;
+	return TRUE;
+}
+
+gboolean
+wtap_save_fast_seek_index(wtap *wth, const char *path, int *err)
+{
+	ws_statb64 statb;
+
+	*err = 0;
+	if (wth->fast_seek == NULL || wth->random_fh == NULL)
+		return FALSE;
+	if (wth->fast_seek->len <= wth->fast_seek_index_len) {
+		/* Nothing new since we loaded the index. */
+		return FALSE;
+	}
+	if (file_fstat(wth->random_fh, &statb, err) == -1)
+		return FALSE;
+	if (!file_fast_seek_index_save(wth->fast_seek, &statb, path, err))
+		return FALSE;
+	wth->fast_seek_index_len = wth->fast_seek->len;
+	return TRUE;
+}
+
+/*
+ * Frame index files.
+ *
+ * The index file begins with a header:
+ *
+ *    8 bytes of magic number;
+ *    4-byte version number;
+ *    4-byte size of each entry;
+ *    8-byte size of the capture file;
+ *    8-byte last modification time of the capture file;
+ *    8-byte count of entries;
+ *
+ * followed by an entry for each record, in order, each of which is:
+ *
+ *    8-byte offset of the record in the capture file;
+ *    8-byte seconds part of the time stamp;
+ *    4-byte nanoseconds part of the time stamp;
+ *    4-byte captured length;
+ *    4-byte original length;
+ *    4-byte encapsulation;
+ *    2-byte record type;
+ *    2-byte flags (0x0001 = the record has a time stamp);
+ *    4 bytes of padding;
+ *
+ * All values are little-endian.  An index whose size or modification
+ * time doesn't match that of the capture file is ignored.
+ */
+static const guint8 frame_index_magic[8] = { 'W', 'S', 'F', 'R', 'M', 'I', 'D', 'X' };
+#define FRAME_INDEX_VERSION	1
+#define FRAME_INDEX_HDR_SIZE	40
+#define FRAME_INDEX_ENTRY_SIZE	40
+#define FRAME_INDEX_HAS_TS	0x0001
+
+struct wtap_frame_index_writer {
+	wtap		*wth;
+	FILE		*fp;
+	char		*path;
+	ws_statb64	statb;		/* of the capture file, when we started */
+	guint64		count;
+	int		err;		/* first write error, if any */
+};
+
+wtap_frame_index_writer *
+wtap_frame_index_writer_open(wtap *wth, const char *path, int *err)
+{
+	wtap_frame_index_writer *writer;
+	guint8 hdr[FRAME_INDEX_HDR_SIZE];
+
+	*err = 0;
+	if (wth->random_fh == NULL) {
+		*err = WTAP_ERR_INTERNAL;
+		return NULL;
+	}
+	writer = g_new0(wtap_frame_index_writer, 1);
+	if (file_fstat(wth->random_fh, &writer->statb, err) == -1) {
+		g_free(writer);
+		return NULL;
+	}
+	writer->fp = ws_fopen(path, "wb");
+	if (writer->fp == NULL) {
+		*err = errno;
+		g_free(writer);
+		return NULL;
+	}
+	writer->wth = wth;
+	writer->path = g_strdup(path);
+
+	/* The count is filled in when we're done. */
+	memset(hdr, 0, sizeof hdr);
+	if (fwrite(hdr, sizeof hdr, 1, writer->fp) != 1)
+		writer->err = errno;
+	return writer;
+}
+
+void
+wtap_frame_index_writer_add(wtap_frame_index_writer *writer, gint64 offset,
+    const wtap_rec *rec)
+{
+	guint8 entry[FRAME_INDEX_ENTRY_SIZE];
+	guint32 cap_len = 0, pkt_len = 0;
+	gint32 pkt_encap = WTAP_ENCAP_UNKNOWN;
+
+	if (writer->err != 0)
+		return;
+
+	if (rec->rec_type == REC_TYPE_PACKET) {
+		cap_len = rec->rec_header.packet_header.caplen;
+		pkt_len = rec->rec_header.packet_header.len;
+		pkt_encap = rec->rec_header.packet_header.pkt_encap;
+	}
+	memset(entry, 0, sizeof entry);
+	phtole64(&entry[0], (guint64)offset);
+	phtole64(&entry[8], (guint64)rec->ts.secs);
+	phtole32(&entry[16], (guint32)rec->ts.nsecs);
+	phtole32(&entry[20], cap_len);
+	phtole32(&entry[24], pkt_len);
+	phtole32(&entry[28], (guint32)pkt_encap);
+	phtole16(&entry[32], (guint16)rec->rec_type);
+	phtole16(&entry[34], (rec->presence_flags & WTAP_HAS_TS) ? FRAME_INDEX_HAS_TS : 0);
+	if (fwrite(entry, sizeof entry, 1, writer->fp) != 1) {
+		writer->err = errno;
+		return;
+	}
+	writer->count++;
+}
+
+gboolean
+wtap_frame_index_writer_close(wtap_frame_index_writer *writer, gboolean keep,
+    int *err)
+{
+	guint8 hdr[FRAME_INDEX_HDR_SIZE];
+	ws_statb64 statb;
+
+	*err = writer->err;
+	if (keep && *err == 0) {
+		/*
+		 * If the capture file changed while we were reading it,
+		 * the index matches neither the old nor the new version.
+		 */
+		if (file_fstat(writer->wth->random_fh, &statb, err) == -1 ||
+		    statb.st_size != writer->statb.st_size ||
+		    statb.st_mtime != writer->statb.st_mtime)
+			keep = FALSE;
+	}
+	if (keep && *err == 0) {
+		memcpy(hdr, frame_index_magic, sizeof frame_index_magic);
+		phtole32(&hdr[8], FRAME_INDEX_VERSION);
+		phtole32(&hdr[12], FRAME_INDEX_ENTRY_SIZE);
+		phtole64(&hdr[16], (guint64)writer->statb.st_size);
+		phtole64(&hdr[24], (guint64)writer->statb.st_mtime);
+		phtole64(&hdr[32], writer->count);
+		if (fseek(writer->fp, 0, SEEK_SET) == -1 ||
+		    fwrite(hdr, sizeof hdr, 1, writer->fp) != 1)
+			*err = errno;
+	}
+	if (fclose(writer->fp) == EOF && *err == 0)
+		*err = errno;
+	if (!keep || *err != 0) {
+		ws_unlink(writer->path);
+		keep = FALSE;
+	}
+	g_free(writer->path);
+	g_free(writer);
+	return keep;
+}
+
+wtap_frame_index_entry *
+wtap_load_frame_index(wtap *wth, const char *path, guint64 *count, int *err)
+{
+	guint8 hdr[FRAME_INDEX_HDR_SIZE];
+	ws_statb64 statb, index_statb;
+	guint8 *raw;
+	wtap_frame_index_entry *entries;
+	guint64 n, i;
+	FILE *fp;
+
+	*err = 0;
+	*count = 0;
+	if (wth->random_fh == NULL)
+		return NULL;
+	if (file_fstat(wth->random_fh, &statb, err) == -1)
+		return NULL;
+	fp = ws_fopen(path, "rb");
+	if (fp == NULL) {
+		/* No index isn't an error. */
+		if (errno != ENOENT)
+			*err = errno;
+		return NULL;
+	}
+
+	/*
+	 * An index for a different version of the capture file, or in
+	 * a different version of the format, or that's been cut short,
+	 * is just stale; ignore it.
+	 */
+	if (fread(hdr, sizeof hdr, 1, fp) != 1 ||
+	    memcmp(hdr, frame_index_magic, sizeof frame_index_magic) != 0 ||
+	    pletoh32(&hdr[8]) != FRAME_INDEX_VERSION ||
+	    pletoh32(&hdr[12]) != FRAME_INDEX_ENTRY_SIZE ||
+	    pletoh64(&hdr[16]) != (guint64)statb.st_size ||
+	    pletoh64(&hdr[24]) != (guint64)statb.st_mtime ||
+	    ws_fstat64(ws_fileno(fp), &index_statb) != 0) {
+		fclose(fp);
+		return NULL;
+	}
+	n = pletoh64(&hdr[32]);
+	if (n == 0 || n > G_MAXSIZE / sizeof (wtap_frame_index_entry) ||
+	    (guint64)index_statb.st_size != FRAME_INDEX_HDR_SIZE + n * FRAME_INDEX_ENTRY_SIZE) {
+		fclose(fp);
+		return NULL;
+	}
+
+	/* Read all the entries at once, then convert them. */
+	raw = (guint8 *)g_try_malloc((gsize)(n * FRAME_INDEX_ENTRY_SIZE));
+	entries = (wtap_frame_index_entry *)g_try_malloc((gsize)(n * sizeof (wtap_frame_index_entry)));
+	if (raw == NULL || entries == NULL) {
+		g_free(raw);
+		g_free(entries);
+		fclose(fp);
+		*err = ENOMEM;
+		return NULL;
+	}
+	if (fread(raw, FRAME_INDEX_ENTRY_SIZE, (size_t)n, fp) != (size_t)n) {
+		*err = ferror(fp) ? errno : 0;
+		g_free(raw);
+		g_free(entries);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+
+	for (i = 0; i < n; i++) {
+		const guint8 *entry = &raw[i * FRAME_INDEX_ENTRY_SIZE];
+
+		entries[i].file_off = (gint64)pletoh64(&entry[0]);
+		entries[i].abs_ts.secs = (time_t)(gint64)pletoh64(&entry[8]);
+		entries[i].abs_ts.nsecs = (int)pletoh32(&entry[16]);
+		entries[i].cap_len = pletoh32(&entry[20]);
+		entries[i].pkt_len = pletoh32(&entry[24]);
+		entries[i].pkt_encap = (gint32)pletoh32(&entry[28]);
+		entries[i].rec_type = pletoh16(&entry[32]);
+		entries[i].has_ts = (pletoh16(&entry[34]) & FRAME_INDEX_HAS_TS) != 0;
+	}
+	g_free(raw);
+	*count = n;
+	return entries;
+}
+
+gboolean
+wtap_frame_index_time_range(const wtap_frame_index_entry *entries,
+    guint64 count, const nstime_t *start, const nstime_t *stop,
+    guint64 *first, guint64 *end)
+{
+	gboolean found = FALSE;
+	guint64 i;
+
+	*first = 0;
+	*end = 0;
+	for (i = 0; i < count; i++) {
+		if (!entries[i].has_ts)
+			continue;
+		if (start != NULL && nstime_cmp(&entries[i].abs_ts, start) < 0)
+			continue;
+		if (stop != NULL && nstime_cmp(&entries[i].abs_ts, stop) >= 0)
+			continue;
+		if (!found) {
+			*first = i;
+			found = TRUE;
+		}
+		*end = i + 1;
+	}
+	return found;
+}
 /*
  * Close the file descriptors for the sequential and random streams, but
  * don't discard any information about those streams.  Used on Windows if
@@ -1624,6 +1915,13 @@ wtapng_process_nrb_ipv6(wtap *wth, wtap_block_t nrb)
 	}
 }
 
+void wtap_set_skip_packet_data(wtap *wth, gboolean skip) {
+	if (!wth)
+		return;
+
+	wth->skip_packet_data = skip;
+}
+
 void wtap_set_cb_new_ipv4(wtap *wth, wtap_new_ipv4_callback_t add_new_ipv4) {
 	if (!wth)
 		return;
@@ -1698,7 +1996,7 @@ wtapng_process_dsb(wtap *wth, wtap_block_t dsb)
 }
 
 /* Perform per-packet initialization */
-static void
+void
 wtap_init_rec(wtap *wth, wtap_rec *rec)
 {
 	/*
@@ -1728,6 +2026,9 @@ gboolean
 wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 	gchar **err_info, gint64 *offset)
 {
+	int64_t trace_start = ws_trace_begin();
+	gboolean ok;
+
 	/*
 	 * Initialize the record to default values.
 	 */
@@ -1736,7 +2037,9 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 
 	*err = 0;
 	*err_info = NULL;
-	if (!wth->subtype_read(wth, rec, buf, err, err_info, offset)) {
+	ok = wth->subtype_read(wth, rec, buf, err, err_info, offset);
+	ws_trace_end("wiretap", "wtap_read", trace_start);
+	if (!ok) {
 		/*
 		 * If we didn't get an error indication, we read
 		 * the last packet.  See if there's any deferred
@@ -1775,6 +2078,99 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 	return TRUE;	/* success */
 }
 
+/*
+ * Fill a batch using the file type's one-record-at-a-time read
+ * routine, copying each record's data into the batch.
+ */
+static void
+wtap_read_batch_by_record(wtap *wth, wtap_rec_batch *batch, int *err,
+	gchar **err_info)
+{
+	wtap_rec *rec;
+
+	while (batch->count < batch->max_records) {
+		rec = &batch->recs[batch->count];
+		wtap_init_rec(wth, rec);
+		ws_buffer_clean(&batch->rec_buf);
+		if (!wth->subtype_read(wth, rec, &batch->rec_buf, err, err_info,
+		    &batch->offsets[batch->count]))
+			return;
+		ws_buffer_append_buffer(&batch->data, &batch->rec_buf);
+		wtap_rec_batch_add(batch);
+	}
+}
+
+gboolean
+wtap_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+	gchar **err_info)
+{
+	wtap_rec *rec;
+	guint i;
+
+	for (i = 0; i < batch->count; i++)
+		wtap_rec_reset(&batch->recs[i]);
+	batch->count = 0;
+	ws_buffer_clean(&batch->data);
+	batch->data_offsets[0] = 0;
+
+	if (batch->pending) {
+		/*
+		 * The previous batch was cut short by an error or EOF;
+		 * report it now.
+		 */
+		batch->pending = FALSE;
+		*err = batch->pending_err;
+		*err_info = batch->pending_err_info;
+		batch->pending_err_info = NULL;
+		return FALSE;
+	}
+
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_read_batch != NULL)
+		wth->subtype_read_batch(wth, batch, err, err_info);
+	else
+		wtap_read_batch_by_record(wth, batch, err, err_info);
+
+	for (i = 0; i < batch->count; i++) {
+		rec = &batch->recs[i];
+		if (rec->rec_type == REC_TYPE_PACKET) {
+			/* See wtap_read(). */
+			ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_PER_PACKET);
+			ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_NONE);
+		}
+	}
+
+	if (batch->count == batch->max_records)
+		return TRUE;	/* full batch */
+
+	/*
+	 * The read of the record after the last one in the batch
+	 * failed; unreference any block created for it, and check
+	 * for a deferred error, as wtap_read() does.
+	 */
+	rec = &batch->recs[batch->count];
+	if (rec->block != NULL) {
+		wtap_block_unref(rec->block);
+		rec->block = NULL;
+	}
+	if (*err == 0)
+		*err = file_error(wth->fh, err_info);
+	if (batch->count == 0)
+		return FALSE;	/* nothing read */
+
+	/*
+	 * Return what we got, and report the error or EOF on the
+	 * next call.
+	 */
+	batch->pending = TRUE;
+	batch->pending_err = *err;
+	batch->pending_err_info = *err_info;
+	*err = 0;
+	*err_info = NULL;
+	return TRUE;
+}
+
 /*
  * Read a given number of bytes from a file into a buffer or, if
  * buf is NULL, just discard them.
@@ -1898,6 +2294,39 @@ wtap_rec_cleanup(wtap_rec *rec)
 	ws_buffer_free(&rec->options_buf);
 }
 
+void
+wtap_rec_batch_init(wtap_rec_batch *batch, guint max_records)
+{
+	guint i;
+
+	ws_assert(max_records != 0);
+	memset(batch, 0, sizeof *batch);
+	batch->max_records = max_records;
+	batch->recs = g_new(wtap_rec, max_records);
+	for (i = 0; i < max_records; i++)
+		wtap_rec_init(&batch->recs[i]);
+	batch->offsets = g_new0(gint64, max_records);
+	batch->data_offsets = g_new0(gsize, max_records + 1);
+	ws_buffer_init(&batch->data, 0);
+	ws_buffer_init(&batch->rec_buf, 0);
+}
+
+void
+wtap_rec_batch_cleanup(wtap_rec_batch *batch)
+{
+	guint i;
+
+	for (i = 0; i < batch->max_records; i++)
+		wtap_rec_cleanup(&batch->recs[i]);
+	g_free(batch->recs);
+	g_free(batch->offsets);
+	g_free(batch->data_offsets);
+	ws_buffer_free(&batch->data);
+	ws_buffer_free(&batch->rec_buf);
+	g_free(batch->pending_err_info);
+	memset(batch, 0, sizeof *batch);
+}
+
 wtap_block_t
 wtap_rec_generate_idb(const wtap_rec *rec)
 {
@@ -1916,6 +2345,9 @@ gboolean
 wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info)
 {
+	int64_t trace_start = ws_trace_begin();
+	gboolean ok;
+
 	/*
 	 * Initialize the record to default values.
 	 */
@@ -1924,7 +2356,9 @@ wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 
 	*err = 0;
 	*err_info = NULL;
-	if (!wth->subtype_seek_read(wth, seek_off, rec, buf, err, err_info)) {
+	ok = wth->subtype_seek_read(wth, seek_off, rec, buf, err, err_info);
+	ws_trace_end("wiretap", "wtap_seek_read", trace_start);
+	if (!ok) {
 		if (rec->block != NULL) {
 			/*
 			 * Unreference any block created for this record.
@@ -1952,6 +2386,43 @@ wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 	return TRUE;
 }
 
+void
+wtap_prefetch(wtap *wth, gint64 seek_off, gint64 len)
+{
+	if (wth->random_fh != NULL)
+		file_prefetch(wth->random_fh, seek_off, len);
+}
+
+gboolean
+wtap_raw_record_len(wtap *wth, gint64 seek_off, guint32 *len,
+    int *err, gchar **err_info)
+{
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_raw_record_len == NULL) {
+		*err = WTAP_ERR_UNSUPPORTED;
+		*err_info = g_strdup("Records of this file can't be copied unchanged");
+		return FALSE;
+	}
+	if (!wth->subtype_raw_record_len(wth, seek_off, len, err, err_info)) {
+		if (*err == 0)
+			*err = WTAP_ERR_SHORT_READ;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+gboolean
+wtap_read_raw(wtap *wth, gint64 seek_off, guint8 *buf, unsigned int len,
+    int *err, gchar **err_info)
+{
+	*err = 0;
+	*err_info = NULL;
+	if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
+		return FALSE;
+	return wtap_read_bytes(wth->random_fh, buf, len, err, err_info);
+}
+
 static gboolean
 wtap_full_file_read_file(wtap *wth, FILE_T fh, wtap_rec *rec, Buffer *buf, int *err, gchar **err_info)
 {
@@ -1418,6 +1418,36 @@ typedef struct wtap_rec {
     Buffer    options_buf;       /* file-type specific data */
 } wtap_rec;
 
+/*
+ * A batch of records, read with wtap_read_batch().
+ *
+ * The data for all of the records is stored contiguously, one record
+ * after another, in a single Buffer, so that reading a batch doesn't
+ * require a Buffer per record; use wtap_rec_batch_data() and
+ * wtap_rec_batch_data_len() to get at the data for a given record.
+ */
+typedef struct {
+    guint     count;            /* number of records in the batch */
+    guint     max_records;      /* maximum number of records in a batch */
+    wtap_rec *recs;             /* the records */
+    gint64   *offsets;          /* offset of each record, for wtap_seek_read() */
+    gsize    *data_offsets;     /* offset of each record's data in data, plus one past the end */
+    Buffer    data;             /* data for all of the records */
+
+    /* Private; used when the file type reads a record at a time. */
+    Buffer    rec_buf;
+
+    /* Private; an error or EOF that ended the previous batch early. */
+    gboolean  pending;
+    int       pending_err;
+    gchar    *pending_err_info;
+} wtap_rec_batch;
+
+#define wtap_rec_batch_data(batch, i) \
+    (ws_buffer_start_ptr(&(batch)->data) + (batch)->data_offsets[(i)])
+#define wtap_rec_batch_data_len(batch, i) \
+    ((batch)->data_offsets[(i) + 1] - (batch)->data_offsets[(i)])
+
 /*
  * Bits in presence_flags, indicating which of the fields we have.
  *
@@ -1830,6 +1860,16 @@ struct wtap* wtap_open_offline(const char *filename, unsigned int type, int *err
 WS_DLL_PUBLIC
 void wtap_cleareof(wtap *wth);
 
+/**
+ * Tell the file's sequential read routine that the caller only wants
+ * record metadata. Readers that support this (currently pcap and pcapng)
+ * skip over the packet bytes instead of reading them into the buffer;
+ * caplen is still set, but no data is appended. Readers that don't
+ * support it, and wtap_seek_read(), behave as usual.
+ */
+WS_DLL_PUBLIC
+void wtap_set_skip_packet_data(wtap *wth, gboolean skip);
+
 /**
  * Set callback functions to add new hostnames. Currently pcapng-only.
  * MUST match add_ipv4_name and add_ipv6_name in addr_resolv.c.
@@ -1869,6 +1909,31 @@ WS_DLL_PUBLIC
 gboolean wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     gchar **err_info, gint64 *offset);
 
+/** Read up to batch->max_records records from the file.
+ *
+ * This is equivalent to calling wtap_read() repeatedly, but file types
+ * that support it read the records without per-record dispatch, and
+ * all of the records' data goes into a single, reused buffer.
+ *
+ * If an error or EOF occurs after at least one record has been read,
+ * the records read so far are returned, and the error or EOF is
+ * reported by the next call.
+ *
+ * @wth a wtap * returned by a call that opened a file for reading.
+ * @batch a pointer to a wtap_rec_batch initialized with
+ * wtap_rec_batch_init(); the records and data from the previous call,
+ * including any blocks they refer to, are discarded, so pointers into
+ * them must not be kept across calls.
+ * @param err a positive "errno" value, or a negative number indicating
+ * the type of error, if the read failed.
+ * @param err_info for some errors, a string giving more details of
+ * the error
+ * @return TRUE if at least one record was read, FALSE on EOF or error.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+    gchar **err_info);
+
 /** Read the record at a specified offset in a capture file, filling in
  * *phdr and *buf.
  *
@@ -1889,6 +1954,56 @@ WS_DLL_PUBLIC
 gboolean wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info);
 
+/** Hint that records in a range of the file will soon be read with
+ * wtap_seek_read(), so that the OS can start reading them in.
+ *
+ * This doesn't read anything itself, and never fails; it does nothing
+ * for compressed files or if the OS doesn't support such hints.
+ *
+ * @wth a wtap * returned by a call that opened a file for reading.
+ * @param seek_off the offset of the first record, as would be passed to
+ * wtap_seek_read().
+ * @param len the number of bytes, starting at seek_off, that will be read.
+ */
+WS_DLL_PUBLIC
+void wtap_prefetch(wtap *wth, gint64 seek_off, gint64 len);
+
+/** Get the number of bytes the record at an offset takes up in the file,
+ * so that it can be copied with wtap_read_raw() and wtap_dump_raw().
+ *
+ * Only valid if wtap_dump_can_copy_raw() returned TRUE for the file.
+ *
+ * @wth a wtap * returned by a call that opened a file for random-access
+ * reading.
+ * @param seek_off the offset of the record, as would be passed to
+ * wtap_seek_read().
+ * @param[out] len set to the number of bytes in the record.
+ * @param[out] err set to an error code on failure.
+ * @param[out] err_info for some errors, set to a string giving more
+ * details of the error.
+ * @return TRUE on success, FALSE on failure.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_raw_record_len(wtap *wth, gint64 seek_off, guint32 *len,
+    int *err, gchar **err_info);
+
+/** Read bytes of a file as they are, e.g. records whose lengths were
+ * found with wtap_raw_record_len().
+ *
+ * @wth a wtap * returned by a call that opened a file for random-access
+ * reading.
+ * @param seek_off the offset of the first byte to read.
+ * @param buf filled in with the bytes read.
+ * @param len the number of bytes to read; reading fewer is an error.
+ * @param[out] err set to an error code on failure.
+ * @param[out] err_info for some errors, set to a string giving more
+ * details of the error.
+ * @return TRUE on success, FALSE on failure.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_read_raw(wtap *wth, gint64 seek_off, guint8 *buf,
+    unsigned int len, int *err, gchar **err_info);
+
 /*** initialize a wtap_rec structure ***/
 WS_DLL_PUBLIC
 void wtap_rec_init(wtap_rec *rec);
@@ -1901,6 +2016,14 @@ void wtap_rec_reset(wtap_rec *rec);
 WS_DLL_PUBLIC
 void wtap_rec_cleanup(wtap_rec *rec);
 
+/*** initialize a wtap_rec_batch structure for batches of up to max_records records */
+WS_DLL_PUBLIC
+void wtap_rec_batch_init(wtap_rec_batch *batch, guint max_records);
+
+/*** clean up a wtap_rec_batch structure, freeing what wtap_rec_batch_init() allocated */
+WS_DLL_PUBLIC
+void wtap_rec_batch_cleanup(wtap_rec_batch *batch);
+
 /*
  * Types of compression for a file, including "none".
  */
@@ -1920,6 +2043,140 @@ const char *wtap_compression_type_extension(wtap_compression_type compression_ty
 WS_DLL_PUBLIC
 GSList *wtap_get_all_compression_type_extensions_list(void);
 
+/** Suffix appended to a capture file's pathname to get the pathname of
+ * its fast seek index file. */
+#define WTAP_FAST_SEEK_INDEX_SUFFIX ".seekidx"
+
+/**
+ * @brief Load saved fast seek points for a compressed file.
+ * @details Random access to a compressed file requires decompressing
+ *          it from the nearest preceding seek point; normally those are
+ *          only known after the file has been read sequentially.  This
+ *          loads seek points saved with wtap_save_fast_seek_index() the
+ *          last time the file was read.
+ *
+ * @param wth The wiretap session, opened for random access.
+ * @param path The pathname of the index file.
+ * @param[out] err Set to 0 if the index doesn't exist or doesn't match
+ *                 the capture file, or to an error code on an I/O error.
+ * @return TRUE if seek points were loaded, FALSE otherwise.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_load_fast_seek_index(wtap *wth, const char *path, int *err);
+
+/**
+ * @brief Save the fast seek points for a compressed file.
+ * @details Writes the seek points accumulated so far, normally after a
+ *          full sequential pass, so that a later open of the same file
+ *          can use them with wtap_load_fast_seek_index().  Nothing is
+ *          written if the file isn't compressed or if no seek points
+ *          have been added since the index was loaded.
+ *
+ * @param wth The wiretap session, opened for random access.
+ * @param path The pathname of the index file.
+ * @param[out] err Set to an error code on failure, 0 otherwise.
+ * @return TRUE if an index was written, FALSE otherwise.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_save_fast_seek_index(wtap *wth, const char *path, int *err);
+
+/** Suffix appended to a capture file's pathname to get the pathname of
+ * its frame index file. */
+#define WTAP_FRAME_INDEX_SUFFIX ".idx"
+
+/** A record's entry in a frame index file. */
+typedef struct {
+    gint64   file_off;      /**< Offset of the record, for wtap_seek_read() */
+    nstime_t abs_ts;        /**< Time stamp, if has_ts is TRUE */
+    guint32  cap_len;       /**< Captured length of the record's data */
+    guint32  pkt_len;       /**< Original length of the record's data */
+    gint32   pkt_encap;     /**< Encapsulation, for packet records */
+    guint16  rec_type;      /**< REC_TYPE_ value */
+    guint16  has_ts;        /**< TRUE if the record has a time stamp */
+} wtap_frame_index_entry;
+
+typedef struct wtap_frame_index_writer wtap_frame_index_writer;
+
+/**
+ * @brief Start writing a frame index for a capture file.
+ * @details A frame index lists the offset, lengths, time stamp and
+ *          encapsulation of each record in the file, in order, so that
+ *          those can be had with wtap_load_frame_index() without reading
+ *          the file.  Add records with wtap_frame_index_writer_add() as
+ *          they're read sequentially, and finish with
+ *          wtap_frame_index_writer_close().
+ *
+ * @param wth The wiretap session, opened for random access.
+ * @param path The pathname of the index file.
+ * @param[out] err Set to an error code on failure.
+ * @return The writer, or NULL on failure.
+ */
+WS_DLL_PUBLIC
+wtap_frame_index_writer *wtap_frame_index_writer_open(wtap *wth,
+    const char *path, int *err);
+
+/**
+ * @brief Add a record to a frame index.
+ *
+ * @param writer The writer.
+ * @param offset The offset of the record, as returned by wtap_read().
+ * @param rec The record.
+ */
+WS_DLL_PUBLIC
+void wtap_frame_index_writer_add(wtap_frame_index_writer *writer,
+    gint64 offset, const wtap_rec *rec);
+
+/**
+ * @brief Finish writing a frame index.
+ * @details If the index isn't to be kept, for example because not all
+ *          of the capture file was read, the index file is removed.  It
+ *          is also removed if the capture file has changed since the
+ *          writer was opened.
+ *
+ * @param writer The writer; it's freed.
+ * @param keep TRUE if every record in the file was added.
+ * @param[out] err Set to an error code on failure, 0 otherwise.
+ * @return TRUE if an index was written, FALSE otherwise.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_frame_index_writer_close(wtap_frame_index_writer *writer,
+    gboolean keep, int *err);
+
+/**
+ * @brief Load the frame index for a capture file.
+ *
+ * @param wth The wiretap session, opened for random access.
+ * @param path The pathname of the index file.
+ * @param[out] count Set to the number of entries.
+ * @param[out] err Set to 0 if the index doesn't exist or doesn't match
+ *                 the capture file, or to an error code on an I/O error.
+ * @return An array of entries, to be freed with g_free(), or NULL if
+ *         there's no usable index.
+ */
+WS_DLL_PUBLIC
+wtap_frame_index_entry *wtap_load_frame_index(wtap *wth, const char *path,
+    guint64 *count, int *err);
+
+/**
+ * @brief Find the records of a frame index in a time range.
+ * @details Finds the first and the last record with a time stamp at or
+ *          after start and before stop.  Time stamps needn't be in order,
+ *          so there can be records between those two that aren't in the
+ *          range, but there are none outside them that are.
+ *
+ * @param entries The index entries.
+ * @param count The number of entries.
+ * @param start The start of the range, or NULL if it's unbounded.
+ * @param stop The end of the range, or NULL if it's unbounded.
+ * @param[out] first Set to the index of the first record in the range.
+ * @param[out] end Set to one past the index of the last record in the range.
+ * @return TRUE if there are records in the range, FALSE if there are none.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_frame_index_time_range(const wtap_frame_index_entry *entries,
+    guint64 count, const nstime_t *start, const nstime_t *stop,
+    guint64 *first, guint64 *end);
+
 /*** get various information snippets about the current file ***/
 
 /** Return an approximation of the amount of data we've read sequentially
@@ -2292,6 +2549,38 @@ gboolean wtap_dump_add_idb(wtap_dumper *wdh, wtap_block_t idb, int *err,
 WS_DLL_PUBLIC
 gboolean wtap_dump(wtap_dumper *, const wtap_rec *, const guint8 *,
      int *err, gchar **err_info);
+
+/**
+ * Return TRUE if records of a file can be copied unchanged, with
+ * wtap_read_raw() and wtap_dump_raw(), to a file we're writing, rather
+ * than being read and then written with wtap_dump().
+ *
+ * That's the case if both files are of the same type and encapsulation,
+ * the input file has a single section with the same interfaces as the
+ * output file, and its records are in the form we write them in.
+ *
+ * @param wdh handle for the file we're writing.
+ * @param wth handle for the file the records are read from.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_dump_can_copy_raw(wtap_dumper *wdh, wtap *wth);
+
+/**
+ * Write records read with wtap_read_raw() from a file for which
+ * wtap_dump_can_copy_raw() returned TRUE.  data must hold only
+ * complete records.
+ *
+ * @param wdh handle for the file we're writing.
+ * @param data the records.
+ * @param len the number of bytes in data.
+ * @param[out] err Will be set to an error code on failure.
+ * @param[out] err_info for some errors, a string giving more details of
+ * the error.
+ * @return TRUE on success, FALSE on failure.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_dump_raw(wtap_dumper *wdh, const guint8 *data, size_t len,
+     int *err, gchar **err_info);
 WS_DLL_PUBLIC
 gboolean wtap_dump_flush(wtap_dumper *, int *);
 WS_DLL_PUBLIC
@@ -95,6 +95,17 @@ struct wtap_block
 /* Keep track of wtap_blocktype_t's via their id number */
 static wtap_blocktype_t* blocktype_list[MAX_WTAP_BLOCK_TYPE_VALUE];
 
+/*
+ * A packet block is created for every packet read and destroyed
+ * once the packet has been processed, so keep a few destroyed ones,
+ * with their option arrays, around for reuse rather than going
+ * through the allocator three or four times per packet.
+ */
+#define MAX_CACHED_PACKET_BLOCKS 64
+static GMutex cached_packet_blocks_mtx;
+static wtap_block_t cached_packet_blocks[MAX_CACHED_PACKET_BLOCKS];
+static guint num_cached_packet_blocks;
+
 static if_filter_opt_t if_filter_dup(if_filter_opt_t* filter_src)
 {
     if_filter_opt_t filter_dest;
@@ -337,9 +348,18 @@ wtap_block_t wtap_block_create(wtap_block_type_t block_type)
     if (block_type >= MAX_WTAP_BLOCK_TYPE_VALUE)
         return NULL;
 
-    block = g_new(struct wtap_block, 1);
-    block->info = blocktype_list[block_type];
-    block->options = g_array_new(FALSE, FALSE, sizeof(wtap_option_t));
+    block = NULL;
+    if (block_type == WTAP_BLOCK_PACKET) {
+        g_mutex_lock(&cached_packet_blocks_mtx);
+        if (num_cached_packet_blocks != 0)
+            block = cached_packet_blocks[--num_cached_packet_blocks];
+        g_mutex_unlock(&cached_packet_blocks_mtx);
+    }
+    if (block == NULL) {
+        block = g_new(struct wtap_block, 1);
+        block->info = blocktype_list[block_type];
+        block->options = g_array_new(FALSE, FALSE, sizeof(wtap_option_t));
+    }
     block->info->create(block);
     block->ref_count = 1;
 #ifdef DEBUG_COUNT_REFS
@@ -441,6 +461,17 @@ void wtap_block_unref(wtap_block_t block)
 
             g_free(block->mandatory_data);
             wtap_block_free_options(block);
+            if (block->info->block_type == WTAP_BLOCK_PACKET) {
+                /* Keep it for reuse by wtap_block_create(), if there's room. */
+                g_mutex_lock(&cached_packet_blocks_mtx);
+                if (num_cached_packet_blocks < MAX_CACHED_PACKET_BLOCKS) {
+                    cached_packet_blocks[num_cached_packet_blocks++] = block;
+                    block = NULL;
+                }
+                g_mutex_unlock(&cached_packet_blocks_mtx);
+                if (block == NULL)
+                    return;
+            }
             g_array_free(block->options, TRUE);
             g_free(block);
         }
@@ -2245,6 +2276,13 @@ void wtap_opttypes_cleanup(void)
     guint8 mask;
 #endif /* DEBUG_COUNT_REFS */
 
+    while (num_cached_packet_blocks != 0) {
+        wtap_block_t block = cached_packet_blocks[--num_cached_packet_blocks];
+
+        g_array_free(block->options, TRUE);
+        g_free(block);
+    }
+
     for (block_type = (guint)WTAP_BLOCK_SECTION;
          block_type < (guint)MAX_WTAP_BLOCK_TYPE_VALUE; block_type++) {
         if (blocktype_list[block_type]) {
@@ -15,6 +15,9 @@
 #include <string.h>
 
 #define BASE 65521 /* largest prime smaller than 65536 */
+/* NMAX is the largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1,
+ * i.e. the most bytes that can be summed before s2 has to be reduced. */
+#define NMAX 5552
 
 /*--- update_adler32 --------------------------------------------------------*/
 uint32_t update_adler32(uint32_t adler, const uint8_t *buf, size_t len)
@@ -23,9 +26,27 @@ uint32_t update_adler32(uint32_t adler, const uint8_t *buf, size_t len)
   uint32_t s2 = (adler >> 16) & 0xffff;
   size_t n;
 
-  for (n = 0; n < len; n++) {
-    s1 = (s1 + buf[n]) % BASE;
-    s2 = (s2 + s1)     % BASE;
+  while (len > 0) {
+    n = len < NMAX ? len : NMAX;
+    len -= n;
+    while (n >= 8) {
+      s1 += buf[0]; s2 += s1;
+      s1 += buf[1]; s2 += s1;
+      s1 += buf[2]; s2 += s1;
+      s1 += buf[3]; s2 += s1;
+      s1 += buf[4]; s2 += s1;
+      s1 += buf[5]; s2 += s1;
+      s1 += buf[6]; s2 += s1;
+      s1 += buf[7]; s2 += s1;
+      buf += 8;
+      n -= 8;
+    }
+    while (n-- > 0) {
+      s1 += *buf++;
+      s2 += s1;
+    }
+    s1 %= BASE;
+    s2 %= BASE;
   }
   return (s2 << 16) + s1;
 }
@@ -78,6 +78,7 @@ struct codec_handle {
     codec_get_channels_fn channels_fn;
     codec_get_frequency_fn frequency_fn;
     codec_decode_fn decode_fn;
+    codec_decode_batch_fn decode_batch_fn;
 };
 
 /*
@@ -130,12 +131,25 @@ register_codec(const char *name, codec_init_fn init_fn, codec_release_fn release
     handle->channels_fn = channels_fn;
     handle->frequency_fn = frequency_fn;
     handle->decode_fn = decode_fn;
+    handle->decode_batch_fn = NULL;
 
     g_hash_table_insert(registered_codecs, (void *)key, (void *) handle);
     return true;
 }
 
 /* Deregister a codec by name. */
+bool
+register_codec_decode_batch(const char *name, codec_decode_batch_fn decode_batch_fn)
+{
+    struct codec_handle *handle = find_codec(name);
+
+    if (handle == NULL)
+        return false;
+
+    handle->decode_batch_fn = decode_batch_fn;
+    return true;
+}
+
 bool
 deregister_codec(const char *name)
 {
@@ -179,6 +193,29 @@ size_t codec_decode(codec_handle_t codec, codec_context_t *context, const void *
     return (codec->decode_fn)(context, input, inputSizeBytes, output, outputSizeBytes);
 }
 
+size_t codec_decode_batch(codec_handle_t codec, codec_context_t *context, codec_frame_t *frames, size_t framesCount, void *output, size_t outputSizeBytes)
+{
+    uint8_t *out = (uint8_t *)output;
+    size_t i;
+
+    if (!codec) return 0;
+    if (codec->decode_batch_fn) {
+        return (codec->decode_batch_fn)(context, frames, framesCount, output, outputSizeBytes);
+    }
+
+    for (i = 0; i < framesCount; i++) {
+        size_t frame_size = (codec->decode_fn)(context, frames[i].inputBytes, frames[i].inputBytesSize, NULL, NULL);
+
+        if (frame_size > outputSizeBytes) {
+            break;
+        }
+        frames[i].outputBytes = (codec->decode_fn)(context, frames[i].inputBytes, frames[i].inputBytesSize, out, &frame_size);
+        out += frames[i].outputBytes;
+        outputSizeBytes -= frames[i].outputBytes;
+    }
+    return i;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -105,6 +105,33 @@ typedef size_t (*codec_decode_fn)(codec_context_t *context,
         const void *inputBytes, size_t inputBytesSize,
         void *outputSamples, size_t *outputSamplesSize);
 
+/** One frame of payload passed to codec_decode_batch_fn (API level 2) */
+typedef struct {
+    const void *inputBytes;     /**< Pointer to input frame */
+    size_t inputBytesSize;      /**< Length of input frame in bytes */
+    size_t outputBytes;         /**< Set by the codec: count of decoded bytes
+                                     (!not samples) written for the frame */
+} codec_frame_t;
+
+/** Decode several frames of payload with one call (API level 2)
+ *  Frames are decoded in order into consecutive parts of outputSamples,
+ *  without being asked for their size first. Decoding stops before the
+ *  first frame whose samples might not fit in the rest of the buffer.
+ *  Implementing this is optional; codecs that don't are called through
+ *  codec_decode_fn for each frame.
+ *
+ * @param context Pointer to codec context
+ * @param frames Frames to decode
+ * @param framesCount Count of frames
+ * @param outputSamples Pointer to output buffer with samples
+ * @param outputSamplesSize Length of output buffer in bytes (not samples!)
+ *
+ * @return Count of frames decoded
+ */
+typedef size_t (*codec_decode_batch_fn)(codec_context_t *context,
+        codec_frame_t *frames, size_t framesCount,
+        void *outputSamples, size_t outputSamplesSize);
+
 /*****************************************************************************/
 /* Codec registering interface */
 /*****************************************************************************/
@@ -113,6 +140,13 @@ WS_DLL_PUBLIC bool register_codec(const char *name, codec_init_fn init_fn,
         codec_release_fn release_fn, codec_get_channels_fn channels_fn,
         codec_get_frequency_fn frequency_fn, codec_decode_fn decode_fn);
 
+/** Add a batch decoder to a codec registered with register_codec() (API level 2)
+ *
+ * @return false if no codec with that name is registered
+ */
+WS_DLL_PUBLIC bool register_codec_decode_batch(const char *name,
+        codec_decode_batch_fn decode_batch_fn);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
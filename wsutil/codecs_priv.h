@@ -36,6 +36,17 @@ WS_DLL_PUBLIC size_t codec_decode(codec_handle_t codec, codec_context_t *context
         const void *inputBytes, size_t inputBytesSize,
         void *outputSamples, size_t *outputSamplesSize);
 
+/**
+ * Decode frames into a caller provided buffer, as codec_decode_batch_fn
+ * does, using the codec's batch decoder if it has one and codec_decode()
+ * for each frame if it doesn't.
+ *
+ * @return Count of frames decoded
+ */
+WS_DLL_PUBLIC size_t codec_decode_batch(codec_handle_t codec, codec_context_t *context,
+        codec_frame_t *frames, size_t framesCount,
+        void *outputSamples, size_t outputSamplesSize);
+
 /**
  * For all built-in codecs and codec plugins, call their register routines.
  */
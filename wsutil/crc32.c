@@ -15,8 +15,21 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <wsutil/crc32.h>
 
+#include "crc32_int.h"
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+/*
+ * The CRC32 instructions are optional in ARMv8.0, so they're only used
+ * if the compiler was told it can assume them.
+ */
+#include <arm_acle.h>
+#define CRC32C_ARMV8 1
+#endif
+
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
 /*****************************************************************/
@@ -364,26 +377,50 @@ crc32_ccitt_table_lookup (unsigned char pos)
 	return crc32_ccitt_table[pos];
 }
 
+#ifdef HAVE_SSE4_2
+/* -1 if not checked yet; checking needs cpuid, which is slow. */
+static int crc32c_use_sse42 = -1;
+#endif
+
 uint32_t
 crc32c_calculate(const void *buf, int len, uint32_t crc)
 {
-	const uint8_t *p = (const uint8_t *)buf;
-	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
-	return CRC32C_SWAP(crc);
+	return CRC32C_SWAP(crc32c_calculate_no_swap(buf, len, CRC32C_SWAP(crc)));
 }
 
 uint32_t
 crc32c_calculate_no_swap(const void *buf, int len, uint32_t crc)
 {
 	const uint8_t *p = (const uint8_t *)buf;
+
+	if (len <= 0)
+		return crc;
+
+#ifdef HAVE_SSE4_2
+	if (crc32c_use_sse42 < 0)
+		crc32c_use_sse42 = crc32c_sse42_available();
+	if (crc32c_use_sse42)
+		return crc32c_sse42_calculate_no_swap(p, (size_t)len, crc);
+#endif
+#ifdef CRC32C_ARMV8
+	while (len >= 8) {
+		uint64_t word;
+
+		memcpy(&word, p, sizeof word);
+		crc = __crc32cd(crc, word);
+		p += 8;
+		len -= 8;
+	}
+	while (len-- > 0)
+		crc = __crc32cb(crc, *p++);
+	return crc;
+#else
 	while (len-- > 0) {
 		CRC32C(crc, *p++);
 	}
 
 	return crc;
+#endif
 }
 
 uint32_t
@@ -392,14 +429,62 @@ crc32_ccitt(const uint8_t *buf, unsigned len)
 	return (crc32_ccitt_seed(buf, len, CRC32_CCITT_SEED));
 }
 
+/*
+ * Tables for computing the CRC-32 of 8 bytes at a time ("slicing by 8");
+ * crc32_ccitt_slice[k][i] is the CRC of byte i followed by k zero bytes.
+ * They're made from crc32_ccitt_table the first time they're needed.
+ */
+static uint32_t crc32_ccitt_slice[8][256];
+static gsize crc32_ccitt_slice_initialized;
+
+static void
+crc32_ccitt_slice_init(void)
+{
+	unsigned i, k;
+
+	for (i = 0; i < 256; i++)
+		crc32_ccitt_slice[0][i] = crc32_ccitt_table[i];
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++) {
+			uint32_t crc = crc32_ccitt_slice[k - 1][i];
+
+			crc32_ccitt_slice[k][i] = (crc >> 8) ^ crc32_ccitt_table[crc & 0xFF];
+		}
+	}
+}
+
 uint32_t
 crc32_ccitt_seed(const uint8_t *buf, unsigned len, uint32_t seed)
 {
-	unsigned i;
 	uint32_t crc32 = seed;
 
-	for (i = 0; i < len; i++)
-		CRC32_ACCUMULATE(crc32, buf[i], crc32_ccitt_table);
+	if (len >= 16) {
+		if (g_once_init_enter(&crc32_ccitt_slice_initialized)) {
+			crc32_ccitt_slice_init();
+			g_once_init_leave(&crc32_ccitt_slice_initialized, 1);
+		}
+
+		while (len >= 8) {
+			uint32_t one = crc32 ^ ((uint32_t)buf[0] | (uint32_t)buf[1] << 8 |
+			    (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 24);
+			uint32_t two = (uint32_t)buf[4] | (uint32_t)buf[5] << 8 |
+			    (uint32_t)buf[6] << 16 | (uint32_t)buf[7] << 24;
+
+			crc32 = crc32_ccitt_slice[7][one & 0xFF] ^
+			    crc32_ccitt_slice[6][(one >> 8) & 0xFF] ^
+			    crc32_ccitt_slice[5][(one >> 16) & 0xFF] ^
+			    crc32_ccitt_slice[4][one >> 24] ^
+			    crc32_ccitt_slice[3][two & 0xFF] ^
+			    crc32_ccitt_slice[2][(two >> 8) & 0xFF] ^
+			    crc32_ccitt_slice[1][(two >> 16) & 0xFF] ^
+			    crc32_ccitt_slice[0][two >> 24];
+			buf += 8;
+			len -= 8;
+		}
+	}
+
+	while (len-- > 0)
+		CRC32_ACCUMULATE(crc32, *buf++, crc32_ccitt_table);
 
 	return ( ~crc32 );
 }
@@ -0,0 +1,76 @@
+/* crc32c_sse42.c
+ * CRC32C with the SSE 4.2 crc32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <nmmintrin.h>
+#include <string.h>
+
+#include "ws_cpuid.h"
+#include "crc32_int.h"
+
+bool
+crc32c_sse42_available(void)
+{
+    return ws_cpuid_sse42() != 0;
+}
+
+/*
+ * The crc32 instruction computes the same reflected CRC32C as the table
+ * in crc32.c, up to eight bytes at a time.
+ */
+uint32_t
+crc32c_sse42_calculate_no_swap(const uint8_t *buf, size_t len, uint32_t crc)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64_t crc64 = crc;
+    uint64_t word64;
+
+    while (len >= 8) {
+        memcpy(&word64, buf, sizeof word64);
+        crc64 = _mm_crc32_u64(crc64, word64);
+        buf += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+#endif
+    {
+        uint32_t word32;
+
+        while (len >= 4) {
+            memcpy(&word32, buf, sizeof word32);
+            crc = _mm_crc32_u32(crc, word32);
+            buf += 4;
+            len -= 4;
+        }
+    }
+    while (len-- > 0) {
+        crc = _mm_crc32_u8(crc, *buf++);
+    }
+
+    return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
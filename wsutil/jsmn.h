@@ -54,6 +54,14 @@ enum jsmnerr {
 	JSMN_ERROR_PART = -3
 };
 
+/*
+ * Give tokens a link to their parent.  Without it, closing an object or
+ * array and moving on to the next member scan back through the earlier
+ * tokens, which makes parsing quadratic in the number of members.  It
+ * changes jsmntok_t, so it's defined here rather than only for jsmn.c.
+ */
+#define JSMN_PARENT_LINKS
+
 /**
  * JSON token description.
  * 	type	type (object, array, string etc.)
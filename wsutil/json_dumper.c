@@ -17,6 +17,7 @@
 #define WS_LOG_DOMAIN LOG_DOMAIN_WSUTIL
 
 #include <math.h>
+#include <string.h>
 
 #include <wsutil/wslog.h>
 
@@ -125,23 +126,43 @@ json_puts_string(const json_dumper *dumper, const char *str, bool dot_to_undersc
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
 
+    /*
+     * Most strings need little or no escaping, so write the runs of
+     * characters between the ones that do in one go, rather than a
+     * character at a time.
+     */
+    const char *run = str;
+    const char *p;
+
     jd_putc(dumper, '"');
-    for (int i = 0; str[i]; i++) {
-        if ((unsigned)str[i] < 0x20) {
-            jd_putc(dumper, '\\');
-            jd_puts(dumper, json_cntrl[(unsigned)str[i]]);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
+    for (p = str; *p; p++) {
+        const char *escape;
+        char escaped[8];
+
+        if ((unsigned char)*p < 0x20) {
+            escaped[0] = '\\';
+            memcpy(&escaped[1], json_cntrl[(unsigned char)*p], sizeof json_cntrl[0]);
+            escape = escaped;
+        } else if (*p == '/' && p > str && p[-1] == '<') {
             // Convert </script> to <\/script> to avoid breaking web pages.
-            jd_puts(dumper, "\\/");
+            escape = "\\/";
+        } else if (*p == '\\') {
+            escape = "\\\\";
+        } else if (*p == '"') {
+            escape = "\\\"";
+        } else if (dot_to_underscore && *p == '.') {
+            escape = "_";
         } else {
-            if (str[i] == '\\' || str[i] == '"') {
-                jd_putc(dumper, '\\');
-            }
-            if (dot_to_underscore && str[i] == '.')
-                jd_putc(dumper, '_');
-            else
-                jd_putc(dumper, str[i]);
+            continue;
+        }
+        if (p > run) {
+            jd_puts_len(dumper, run, p - run);
         }
+        jd_puts(dumper, escape);
+        run = p + 1;
+    }
+    if (p > run) {
+        jd_puts_len(dumper, run, p - run);
     }
     jd_putc(dumper, '"');
 }
@@ -10,13 +10,21 @@
 
 #include "regex.h"
 
+#include <string.h>
+
 #include <wsutil/str_util.h>
+#include <wsutil/wmem/wmem_strutl.h>
 #include <pcre2.h>
 
 
 struct _ws_regex {
     pcre2_code *code;
     char *pattern;
+    /* If the pattern is a plain string without any metacharacters it is
+     * searched for directly, without calling pcre2_match(). */
+    char *literal;
+    size_t literal_len;
+    bool anchored;
 };
 
 #define ERROR_MAXLEN_IN_CODE_UNITS   128
@@ -76,9 +84,35 @@ compile_pcre2(const char *patt, ssize_t size, char **errmsg, unsigned flags)
         return NULL;
     }
 
+    /* Use the JIT compiler if PCRE2 was built with it. If it fails
+     * pcre2_match() just uses the interpreter. */
+    pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+
     return code;
 }
 
+/* Returns true if the pattern only matches itself, i.e. has no
+ * metacharacters. The options that can change that, such as extended
+ * syntax, can only be set in the pattern with "(?". */
+static bool
+pattern_is_literal(const char *patt, size_t length, unsigned flags)
+{
+    if (length == 0 || (flags & WS_REGEX_CASELESS))
+        return false;
+
+    for (size_t i = 0; i < length; i++) {
+        switch (patt[i]) {
+            case '\\': case '^': case '$': case '.': case '[':
+            case '|': case '(': case ')': case '?': case '*':
+            case '+': case '{':
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
 
 ws_regex_t *
 ws_regex_compile_ex(const char *patt, ssize_t size, char **errmsg, unsigned flags)
@@ -92,6 +126,17 @@ ws_regex_compile_ex(const char *patt, ssize_t size, char **errmsg, unsigned flag
     ws_regex_t *re = g_new(ws_regex_t, 1);
     re->code = code;
     re->pattern = ws_escape_string_len(NULL, patt, size, false);
+
+    size_t length = size < 0 ? strlen(patt) : (size_t)size;
+    if (pattern_is_literal(patt, length, flags)) {
+        re->literal = g_memdup2(patt, length);
+        re->literal_len = length;
+    }
+    else {
+        re->literal = NULL;
+        re->literal_len = 0;
+    }
+    re->anchored = (flags & WS_REGEX_ANCHORED) != 0;
     return re;
 }
 
@@ -123,6 +168,17 @@ match_pcre2(pcre2_code *code, const char *subject, ssize_t subj_length,
                     match_data,
                     NULL);
 
+    if (rc == PCRE2_ERROR_JIT_STACKLIMIT) {
+        /* The interpreter uses the heap and has a much larger limit. */
+        rc = pcre2_match(code,
+                        subject,
+                        length,
+                        (PCRE2_SIZE)subj_offset,
+                        PCRE2_NO_JIT,
+                        match_data,
+                        NULL);
+    }
+
     if (rc < 0) {
         /* No match */
         if (rc != PCRE2_ERROR_NOMATCH) {
@@ -140,6 +196,42 @@ match_pcre2(pcre2_code *code, const char *subject, ssize_t subj_length,
 }
 
 
+/* Searches for a literal pattern, like match_pcre2() would. */
+static bool
+match_literal(const ws_regex_t *re, const char *subject, ssize_t subj_length,
+                size_t subj_offset, size_t pos_vect[2])
+{
+    size_t length;
+    const uint8_t *found;
+
+    if (subj_length < 0)
+        length = strlen(subject);
+    else
+        length = (size_t)subj_length;
+
+    if (subj_offset > length || length - subj_offset < re->literal_len)
+        return false;
+
+    if (re->anchored) {
+        if (memcmp(subject + subj_offset, re->literal, re->literal_len) != 0)
+            return false;
+        found = (const uint8_t *)subject + subj_offset;
+    }
+    else {
+        found = ws_memmem(subject + subj_offset, length - subj_offset,
+                        re->literal, re->literal_len);
+        if (found == NULL)
+            return false;
+    }
+
+    if (pos_vect) {
+        pos_vect[0] = found - (const uint8_t *)subject;
+        pos_vect[1] = pos_vect[0] + re->literal_len;
+    }
+    return true;
+}
+
+
 bool
 ws_regex_matches(const ws_regex_t *re, const char *subj)
 {
@@ -157,6 +249,9 @@ ws_regex_matches_length(const ws_regex_t *re,
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
+    if (re->literal)
+        return match_literal(re, subj, subj_length, 0, NULL);
+
     /* We don't use the matched substring but pcre2_match requires
      * at least one pair of offsets. */
     match_data = pcre2_match_data_create(1, NULL);
@@ -177,6 +272,9 @@ ws_regex_matches_pos(const ws_regex_t *re,
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
+    if (re->literal)
+        return match_literal(re, subj, subj_length, subj_offset, pos_vect);
+
     match_data = pcre2_match_data_create(1, NULL);
     matched = match_pcre2(re->code, subj, subj_length, subj_offset, match_data);
     if (matched && pos_vect) {
@@ -194,6 +292,7 @@ ws_regex_free(ws_regex_t *re)
 {
     pcre2_code_free(re->code);
     g_free(re->pattern);
+    g_free(re->literal);
     g_free(re);
 }
 
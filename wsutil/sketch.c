@@ -0,0 +1,475 @@
+/* sketch.c
+ * Fixed memory approximate statistics: HyperLogLog distinct counts,
+ * Space-Saving heavy hitters and value quantiles.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "sketch.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <wsutil/bits_ctz.h>
+
+/*
+ * 64-bit FNV-1a followed by the SplitMix64 finalizer, which spreads the
+ * weakly mixed high bits of FNV over the whole word.
+ */
+static uint64_t
+sketch_hash(const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    uint64_t h = UINT64_C(0xcbf29ce484222325);
+
+    while (len--) {
+        h ^= *p++;
+        h *= UINT64_C(0x100000001b3);
+    }
+
+    h ^= h >> 30;
+    h *= UINT64_C(0xbf58476d1ce4e5b9);
+    h ^= h >> 27;
+    h *= UINT64_C(0x94d049bb133111eb);
+    h ^= h >> 31;
+    return h;
+}
+
+/*
+ * HyperLogLog, as described by Flajolet et al., "HyperLogLog: the analysis
+ * of a near-optimal cardinality estimation algorithm", with the linear
+ * counting correction for small cardinalities. A 64-bit hash makes the
+ * large range correction unnecessary.
+ */
+struct _ws_hll {
+    unsigned precision;
+    uint8_t  *registers;
+};
+
+ws_hll_t *
+ws_hll_new(unsigned precision)
+{
+    ws_hll_t *hll = g_new(ws_hll_t, 1);
+
+    if (precision < WS_HLL_MIN_PRECISION)
+        precision = WS_HLL_MIN_PRECISION;
+    if (precision > WS_HLL_MAX_PRECISION)
+        precision = WS_HLL_MAX_PRECISION;
+
+    hll->precision = precision;
+    hll->registers = g_new0(uint8_t, (size_t)1 << precision);
+    return hll;
+}
+
+void
+ws_hll_free(ws_hll_t *hll)
+{
+    if (hll) {
+        g_free(hll->registers);
+        g_free(hll);
+    }
+}
+
+void
+ws_hll_reset(ws_hll_t *hll)
+{
+    memset(hll->registers, 0, (size_t)1 << hll->precision);
+}
+
+void
+ws_hll_add(ws_hll_t *hll, const void *buf, size_t len)
+{
+    uint64_t hash = sketch_hash(buf, len);
+    uint64_t idx = hash & ((UINT64_C(1) << hll->precision) - 1);
+    uint64_t rest = hash >> hll->precision;
+    uint8_t rank;
+
+    /* Position of the lowest set bit of the remaining hash bits, 1-based */
+    rank = rest ? (uint8_t)(ws_ctz(rest) + 1) : (uint8_t)(64 - hll->precision + 1);
+    if (rank > hll->registers[idx]) {
+        hll->registers[idx] = rank;
+    }
+}
+
+uint64_t
+ws_hll_count(const ws_hll_t *hll)
+{
+    size_t m = (size_t)1 << hll->precision;
+    double alpha, sum = 0.0, estimate;
+    size_t zeros = 0;
+    size_t i;
+
+    switch (m) {
+    case 16:
+        alpha = 0.673;
+        break;
+    case 32:
+        alpha = 0.697;
+        break;
+    case 64:
+        alpha = 0.709;
+        break;
+    default:
+        alpha = 0.7213 / (1.0 + 1.079 / (double)m);
+        break;
+    }
+
+    for (i = 0; i < m; i++) {
+        sum += ldexp(1.0, -(int)hll->registers[i]);
+        if (hll->registers[i] == 0) {
+            zeros++;
+        }
+    }
+
+    estimate = alpha * (double)m * (double)m / sum;
+    if (estimate <= 2.5 * (double)m && zeros != 0) {
+        estimate = (double)m * log((double)m / (double)zeros);
+    }
+
+    return (uint64_t)(estimate + 0.5);
+}
+
+/*
+ * Space-Saving, as described by Metwally et al., "Efficient Computation of
+ * Frequent and Top-k Elements in Data Streams". The counters form a binary
+ * min-heap on weight so the lightest one can be replaced in O(log n), and a
+ * linear probing index maps keys to counters.
+ */
+typedef struct {
+    uint64_t weight;
+    uint64_t error;
+    uint32_t hash;
+    uint32_t slot;      /* position in index */
+    uint32_t heap_pos;  /* position in heap */
+} topk_counter_t;
+
+struct _ws_topk {
+    size_t          key_len;
+    uint32_t        capacity;
+    uint32_t        count;      /* counters in use */
+    uint64_t        total;
+    topk_counter_t  *counters;
+    uint8_t         *keys;      /* key_len bytes per counter */
+    uint32_t        *heap;      /* counter numbers, lightest first */
+    uint32_t        *index;     /* counter number + 1, or 0 if unused */
+    uint32_t        index_mask;
+};
+
+#define TOPK_KEY(topk, c) ((topk)->keys + (size_t)(c) * (topk)->key_len)
+
+ws_topk_t *
+ws_topk_new(unsigned capacity, size_t key_len)
+{
+    ws_topk_t *topk = g_new(ws_topk_t, 1);
+    uint32_t index_size = 1;
+
+    if (capacity == 0)
+        capacity = 1;
+
+    /* Keep the index at most half full */
+    while (index_size < 2 * capacity)
+        index_size <<= 1;
+
+    topk->key_len = key_len;
+    topk->capacity = capacity;
+    topk->count = 0;
+    topk->total = 0;
+    topk->counters = g_new(topk_counter_t, capacity);
+    topk->keys = (uint8_t *)g_malloc0((size_t)capacity * key_len);
+    topk->heap = g_new(uint32_t, capacity);
+    topk->index = g_new0(uint32_t, index_size);
+    topk->index_mask = index_size - 1;
+    return topk;
+}
+
+void
+ws_topk_free(ws_topk_t *topk)
+{
+    if (topk) {
+        g_free(topk->counters);
+        g_free(topk->keys);
+        g_free(topk->heap);
+        g_free(topk->index);
+        g_free(topk);
+    }
+}
+
+void
+ws_topk_reset(ws_topk_t *topk)
+{
+    topk->count = 0;
+    topk->total = 0;
+    memset(topk->index, 0, ((size_t)topk->index_mask + 1) * sizeof(uint32_t));
+}
+
+static void
+topk_heap_swap(ws_topk_t *topk, uint32_t i, uint32_t j)
+{
+    uint32_t c = topk->heap[i];
+
+    topk->heap[i] = topk->heap[j];
+    topk->heap[j] = c;
+    topk->counters[topk->heap[i]].heap_pos = i;
+    topk->counters[topk->heap[j]].heap_pos = j;
+}
+
+/* Restore the heap order after the weight at position i increased. */
+static void
+topk_sift_down(ws_topk_t *topk, uint32_t i)
+{
+    for (;;) {
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        uint32_t lightest = i;
+
+        if (left < topk->count &&
+                topk->counters[topk->heap[left]].weight < topk->counters[topk->heap[lightest]].weight)
+            lightest = left;
+        if (right < topk->count &&
+                topk->counters[topk->heap[right]].weight < topk->counters[topk->heap[lightest]].weight)
+            lightest = right;
+        if (lightest == i)
+            return;
+        topk_heap_swap(topk, i, lightest);
+        i = lightest;
+    }
+}
+
+/* Restore the heap order after appending at position i. */
+static void
+topk_sift_up(ws_topk_t *topk, uint32_t i)
+{
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (topk->counters[topk->heap[parent]].weight <= topk->counters[topk->heap[i]].weight)
+            return;
+        topk_heap_swap(topk, i, parent);
+        i = parent;
+    }
+}
+
+/* Remove counter c from the index, shifting back the entries after it. */
+static void
+topk_index_remove(ws_topk_t *topk, uint32_t c)
+{
+    uint32_t hole = topk->counters[c].slot;
+    uint32_t j = hole;
+
+    topk->index[hole] = 0;
+    for (;;) {
+        uint32_t home, moved;
+
+        j = (j + 1) & topk->index_mask;
+        if (topk->index[j] == 0)
+            return;
+        moved = topk->index[j] - 1;
+        home = topk->counters[moved].hash & topk->index_mask;
+        /* Move the entry into the hole unless its home lies cyclically in (hole, j] */
+        if ((hole <= j) ? (home <= hole || home > j) : (home <= hole && home > j)) {
+            topk->index[hole] = topk->index[j];
+            topk->counters[moved].slot = hole;
+            topk->index[j] = 0;
+            hole = j;
+        }
+    }
+}
+
+void
+ws_topk_add(ws_topk_t *topk, const void *key, uint64_t weight)
+{
+    uint32_t hash = (uint32_t)sketch_hash(key, topk->key_len);
+    uint32_t slot = hash & topk->index_mask;
+    uint32_t c;
+
+    topk->total += weight;
+
+    while (topk->index[slot] != 0) {
+        c = topk->index[slot] - 1;
+        if (topk->counters[c].hash == hash &&
+                memcmp(TOPK_KEY(topk, c), key, topk->key_len) == 0) {
+            topk->counters[c].weight += weight;
+            topk_sift_down(topk, topk->counters[c].heap_pos);
+            return;
+        }
+        slot = (slot + 1) & topk->index_mask;
+    }
+
+    if (topk->count < topk->capacity) {
+        c = topk->count++;
+        topk->counters[c].weight = weight;
+        topk->counters[c].error = 0;
+        topk->counters[c].heap_pos = c;
+        topk->heap[c] = c;
+        topk_sift_up(topk, c);
+    } else {
+        /* Evict the lightest key; the newcomer inherits its weight as error */
+        c = topk->heap[0];
+        topk_index_remove(topk, c);
+        /* The removal may have shifted entries back into the probe sequence */
+        slot = hash & topk->index_mask;
+        while (topk->index[slot] != 0)
+            slot = (slot + 1) & topk->index_mask;
+        topk->counters[c].error = topk->counters[c].weight;
+        topk->counters[c].weight += weight;
+        topk_sift_down(topk, 0);
+    }
+
+    memcpy(TOPK_KEY(topk, c), key, topk->key_len);
+    topk->counters[c].hash = hash;
+    topk->counters[c].slot = slot;
+    topk->index[slot] = c + 1;
+}
+
+uint64_t
+ws_topk_total(const ws_topk_t *topk)
+{
+    return topk->total;
+}
+
+static int
+topk_item_compare(const void *a, const void *b)
+{
+    const ws_topk_item_t *ia = (const ws_topk_item_t *)a;
+    const ws_topk_item_t *ib = (const ws_topk_item_t *)b;
+
+    if (ia->weight != ib->weight)
+        return ia->weight < ib->weight ? 1 : -1;
+    return 0;
+}
+
+unsigned
+ws_topk_items(const ws_topk_t *topk, ws_topk_item_t *items)
+{
+    uint32_t c;
+
+    for (c = 0; c < topk->count; c++) {
+        items[c].key = TOPK_KEY(topk, c);
+        items[c].weight = topk->counters[c].weight;
+        items[c].error = topk->counters[c].error;
+    }
+    qsort(items, topk->count, sizeof(ws_topk_item_t), topk_item_compare);
+    return topk->count;
+}
+
+/*
+ * Log-linear histogram. Values below QUANTILES_SUB_BUCKETS get a bucket
+ * each; above that every power of two is split into QUANTILES_SUB_BUCKETS
+ * equal ranges, keyed by the bits following the most significant one.
+ */
+#define QUANTILES_SUB_BITS      4
+#define QUANTILES_SUB_BUCKETS   (1 << QUANTILES_SUB_BITS)
+#define QUANTILES_NUM_BUCKETS   ((64 - QUANTILES_SUB_BITS + 1) * QUANTILES_SUB_BUCKETS)
+
+struct _ws_quantiles {
+    uint64_t count;
+    uint32_t buckets[QUANTILES_NUM_BUCKETS];
+};
+
+static unsigned
+quantiles_bucket(uint64_t value)
+{
+    int msb;
+
+    if (value < QUANTILES_SUB_BUCKETS)
+        return (unsigned)value;
+    msb = ws_ilog2(value);
+    return (unsigned)((msb - QUANTILES_SUB_BITS + 1) * QUANTILES_SUB_BUCKETS +
+                      ((value >> (msb - QUANTILES_SUB_BITS)) & (QUANTILES_SUB_BUCKETS - 1)));
+}
+
+/* The middle of the range of values counted in bucket. */
+static uint64_t
+quantiles_bucket_value(unsigned bucket)
+{
+    unsigned shift;
+    uint64_t low;
+
+    if (bucket < QUANTILES_SUB_BUCKETS)
+        return bucket;
+    shift = bucket / QUANTILES_SUB_BUCKETS - 1;
+    low = (uint64_t)(QUANTILES_SUB_BUCKETS + bucket % QUANTILES_SUB_BUCKETS) << shift;
+    return low + ((UINT64_C(1) << shift) >> 1);
+}
+
+ws_quantiles_t *
+ws_quantiles_new(void)
+{
+    return g_new0(ws_quantiles_t, 1);
+}
+
+void
+ws_quantiles_free(ws_quantiles_t *qs)
+{
+    g_free(qs);
+}
+
+void
+ws_quantiles_reset(ws_quantiles_t *qs)
+{
+    memset(qs, 0, sizeof(*qs));
+}
+
+void
+ws_quantiles_add(ws_quantiles_t *qs, uint64_t value)
+{
+    uint32_t *bucket = &qs->buckets[quantiles_bucket(value)];
+
+    /* Saturate rather than wrap; the count still tracks every value */
+    if (*bucket < UINT32_MAX)
+        (*bucket)++;
+    qs->count++;
+}
+
+uint64_t
+ws_quantiles_count(const ws_quantiles_t *qs)
+{
+    return qs->count;
+}
+
+uint64_t
+ws_quantiles_get(const ws_quantiles_t *qs, double q)
+{
+    uint64_t rank, seen = 0;
+    unsigned i;
+
+    if (qs->count == 0)
+        return 0;
+    if (q < 0.0)
+        q = 0.0;
+    if (q > 1.0)
+        q = 1.0;
+
+    /* 1-based rank of the value we want */
+    rank = (uint64_t)(q * (double)(qs->count - 1)) + 1;
+    for (i = 0; i < QUANTILES_NUM_BUCKETS; i++) {
+        seen += qs->buckets[i];
+        if (seen >= rank)
+            return quantiles_bucket_value(i);
+    }
+    /* Only reachable if a bucket saturated */
+    for (i = QUANTILES_NUM_BUCKETS; i-- > 0; ) {
+        if (qs->buckets[i])
+            return quantiles_bucket_value(i);
+    }
+    return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,119 @@
+/** @file
+ * Fixed memory approximate statistics: HyperLogLog distinct counts,
+ * Space-Saving heavy hitters and value quantiles.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_SKETCH_H__
+#define __WSUTIL_SKETCH_H__
+
+#include <wireshark.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * HyperLogLog distinct value estimator. Uses 2^precision bytes of
+ * registers; the standard error is about 1.04 / sqrt(2^precision).
+ */
+typedef struct _ws_hll ws_hll_t;
+
+#define WS_HLL_MIN_PRECISION 4
+#define WS_HLL_MAX_PRECISION 18
+
+/** Create an estimator. precision is clamped to
+ * [WS_HLL_MIN_PRECISION, WS_HLL_MAX_PRECISION]. */
+WS_DLL_PUBLIC
+ws_hll_t *ws_hll_new(unsigned precision);
+
+WS_DLL_PUBLIC
+void ws_hll_free(ws_hll_t *hll);
+
+/** Forget all values added so far. */
+WS_DLL_PUBLIC
+void ws_hll_reset(ws_hll_t *hll);
+
+WS_DLL_PUBLIC
+void ws_hll_add(ws_hll_t *hll, const void *buf, size_t len);
+
+/** Estimated number of distinct values added. */
+WS_DLL_PUBLIC
+uint64_t ws_hll_count(const ws_hll_t *hll);
+
+/*
+ * Space-Saving heavy hitter summary over fixed length keys. It tracks at
+ * most "capacity" keys; any key whose weight is more than
+ * total_weight / capacity is guaranteed to be present, and each reported
+ * weight overestimates the true one by at most the item's error.
+ */
+typedef struct _ws_topk ws_topk_t;
+
+typedef struct {
+    const uint8_t *key;     /**< key_len bytes, owned by the summary */
+    uint64_t      weight;   /**< estimated weight */
+    uint64_t      error;    /**< maximum overestimation of weight */
+} ws_topk_item_t;
+
+WS_DLL_PUBLIC
+ws_topk_t *ws_topk_new(unsigned capacity, size_t key_len);
+
+WS_DLL_PUBLIC
+void ws_topk_free(ws_topk_t *topk);
+
+WS_DLL_PUBLIC
+void ws_topk_reset(ws_topk_t *topk);
+
+/** Add weight to key, which must be key_len bytes long. */
+WS_DLL_PUBLIC
+void ws_topk_add(ws_topk_t *topk, const void *key, uint64_t weight);
+
+/** Sum of all weights added. */
+WS_DLL_PUBLIC
+uint64_t ws_topk_total(const ws_topk_t *topk);
+
+/** Fill items (which must have room for the summary's capacity) with the
+ * tracked keys, heaviest first, and return how many there are. The
+ * items are valid until the next call to ws_topk_add or ws_topk_reset. */
+WS_DLL_PUBLIC
+unsigned ws_topk_items(const ws_topk_t *topk, ws_topk_item_t *items);
+
+/*
+ * Quantile estimator for non-negative values such as latencies in
+ * nanoseconds. Values are counted in logarithmic buckets with 16 linear
+ * steps per power of two, so any quantile is reported within about 3%
+ * of a value that was actually added, using a fixed 4 KiB.
+ */
+typedef struct _ws_quantiles ws_quantiles_t;
+
+WS_DLL_PUBLIC
+ws_quantiles_t *ws_quantiles_new(void);
+
+WS_DLL_PUBLIC
+void ws_quantiles_free(ws_quantiles_t *qs);
+
+WS_DLL_PUBLIC
+void ws_quantiles_reset(ws_quantiles_t *qs);
+
+WS_DLL_PUBLIC
+void ws_quantiles_add(ws_quantiles_t *qs, uint64_t value);
+
+/** Number of values added. */
+WS_DLL_PUBLIC
+uint64_t ws_quantiles_count(const ws_quantiles_t *qs);
+
+/** Estimate the q quantile (0.0 <= q <= 1.0) of the values added, or 0
+ * if there are none. */
+WS_DLL_PUBLIC
+uint64_t ws_quantiles_get(const ws_quantiles_t *qs, double q);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WSUTIL_SKETCH_H__ */
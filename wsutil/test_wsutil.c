@@ -663,6 +663,303 @@ void test_nstime_from_iso8601(void)
     g_assert_cmpint(result.nsecs, ==, expect.nsecs);
 }
 
+#include "regex.h"
+
+static void test_regex_literal(void)
+{
+    ws_regex_t *re;
+    char *errmsg = NULL;
+    size_t pos[2];
+    const char subj[] = "GET /admin HTTP/1.1";
+
+    /* Plain strings take a shortcut, which must match like PCRE2. */
+    re = ws_regex_compile("/admin", &errmsg);
+    g_assert_nonnull(re);
+    g_assert_true(ws_regex_matches(re, subj));
+    g_assert_false(ws_regex_matches(re, "GET /index HTTP/1.1"));
+    g_assert_false(ws_regex_matches_length(re, subj, 8));
+    g_assert_true(ws_regex_matches_pos(re, subj, -1, 0, pos));
+    g_assert_cmpuint(pos[0], ==, 4);
+    g_assert_cmpuint(pos[1], ==, 10);
+    g_assert_false(ws_regex_matches_pos(re, subj, -1, 5, pos));
+    ws_regex_free(re);
+
+    re = ws_regex_compile_ex("GET", -1, &errmsg, WS_REGEX_ANCHORED);
+    g_assert_nonnull(re);
+    g_assert_true(ws_regex_matches(re, subj));
+    g_assert_false(ws_regex_matches(re, "A GET"));
+    ws_regex_free(re);
+
+    re = ws_regex_compile_ex("get", -1, &errmsg, WS_REGEX_CASELESS);
+    g_assert_nonnull(re);
+    g_assert_true(ws_regex_matches(re, subj));
+    ws_regex_free(re);
+
+    re = ws_regex_compile("/ad.in", &errmsg);
+    g_assert_nonnull(re);
+    g_assert_true(ws_regex_matches(re, subj));
+    ws_regex_free(re);
+}
+
+#include "json_dumper.h"
+
+static void test_json_dumper_escape(void)
+{
+    json_dumper dumper = {
+        .output_string = g_string_new(NULL),
+        .flags = JSON_DUMPER_DOT_TO_UNDERSCORE,
+    };
+
+    json_dumper_begin_object(&dumper);
+    json_dumper_set_member_name(&dumper, "ip.src");
+    json_dumper_value_string(&dumper, "a\"b\\c\x01</script>\td.e");
+    json_dumper_end_object(&dumper);
+    g_assert_true(json_dumper_finish(&dumper));
+
+    g_assert_cmpstr(dumper.output_string->str, ==,
+        "{\"ip_src\":\"a\\\"b\\\\c\\u0001<\\/script>\\td.e\"}\n");
+    g_string_free(dumper.output_string, TRUE);
+}
+
+#include "wsjson.h"
+
+static void test_json_parse_alloc(void)
+{
+    GString *doc = g_string_new("{\"a\":[");
+    jsmntok_t *tokens = NULL;
+    unsigned int max_tokens = 0;
+    int count;
+    int i;
+
+    /* Enough members to need several larger token arrays */
+    for (i = 0; i < 5000; i++) {
+        g_string_append_printf(doc, "%s{\"n\":%d}", i ? "," : "", i);
+    }
+    g_string_append(doc, "],\"b\":true}");
+
+    count = json_parse_alloc(doc->str, doc->len, &tokens, &max_tokens);
+    /* object, "a", array, 5000 * (object, "n", number), "b", true */
+    g_assert_cmpint(count, ==, 3 + 5000 * 3 + 2);
+    g_assert_cmpuint(max_tokens, >=, (unsigned)count);
+    g_assert_cmpint(tokens[0].type, ==, JSMN_OBJECT);
+    g_assert_cmpint(tokens[0].size, ==, 2);
+    g_assert_cmpint(tokens[2].type, ==, JSMN_ARRAY);
+    g_assert_cmpint(tokens[2].size, ==, 5000);
+    g_assert_cmpint(tokens[count - 1].type, ==, JSMN_PRIMITIVE);
+    g_assert_cmpint(tokens[count - 1].parent, ==, count - 2);
+    g_assert_true(json_validate((const uint8_t *)doc->str, doc->len));
+
+    /* unmatched closing bracket */
+    g_assert_cmpint(json_parse_alloc("[1]]", 4, &tokens, &max_tokens), ==, JSMN_ERROR_INVAL);
+    g_assert_cmpint(json_parse_alloc("{\"a\":1]", 7, &tokens, &max_tokens), ==, JSMN_ERROR_INVAL);
+    /* unterminated */
+    g_assert_cmpint(json_parse_alloc("[1,2", 4, &tokens, &max_tokens), ==, JSMN_ERROR_PART);
+
+    g_free(tokens);
+    g_string_free(doc, TRUE);
+}
+
+#include "sketch.h"
+
+static void test_sketch_hll(void)
+{
+    ws_hll_t *hll = ws_hll_new(14);
+    uint32_t i;
+    uint64_t count;
+
+    for (i = 0; i < 100; i++) {
+        ws_hll_add(hll, &i, sizeof(i));
+        ws_hll_add(hll, &i, sizeof(i));
+    }
+    /* Small counts are nearly exact */
+    count = ws_hll_count(hll);
+    g_assert_cmpuint(count, >=, 98);
+    g_assert_cmpuint(count, <=, 102);
+
+    for (i = 0; i < 1000000; i++) {
+        ws_hll_add(hll, &i, sizeof(i));
+    }
+    /* The standard error at this precision is below 1% */
+    count = ws_hll_count(hll);
+    g_assert_cmpuint(count, >, 970000);
+    g_assert_cmpuint(count, <, 1030000);
+
+    ws_hll_reset(hll);
+    g_assert_cmpuint(ws_hll_count(hll), ==, 0);
+    ws_hll_free(hll);
+}
+
+static void test_sketch_topk(void)
+{
+    ws_topk_t *topk = ws_topk_new(16, sizeof(uint32_t));
+    ws_topk_item_t items[16];
+    unsigned count;
+    uint32_t i, key;
+
+    /* Four heavy keys hidden among many light ones */
+    for (i = 0; i < 100000; i++) {
+        key = (i % 2) ? i % 8 / 2 : 1000 + i;
+        ws_topk_add(topk, &key, 1);
+    }
+    g_assert_cmpuint(ws_topk_total(topk), ==, 100000);
+
+    count = ws_topk_items(topk, items);
+    g_assert_cmpuint(count, ==, 16);
+    for (i = 0; i < 4; i++) {
+        memcpy(&key, items[i].key, sizeof(key));
+        g_assert_cmpuint(key, <, 4);
+        g_assert_cmpuint(items[i].weight - items[i].error, <=, 12500);
+        g_assert_cmpuint(items[i].weight, >=, 12500);
+    }
+    g_assert_cmpuint(items[4].weight, <, 12500);
+
+    ws_topk_reset(topk);
+    g_assert_cmpuint(ws_topk_items(topk, items), ==, 0);
+    ws_topk_free(topk);
+}
+
+static void test_sketch_quantiles(void)
+{
+    ws_quantiles_t *qs = ws_quantiles_new();
+    uint64_t i, value;
+
+    g_assert_cmpuint(ws_quantiles_get(qs, 0.5), ==, 0);
+
+    /* Small values are exact */
+    ws_quantiles_add(qs, 7);
+    g_assert_cmpuint(ws_quantiles_get(qs, 0.5), ==, 7);
+    ws_quantiles_reset(qs);
+
+    /* 1 us .. 1 s in 1 us steps */
+    for (i = 1; i <= 1000000; i++) {
+        ws_quantiles_add(qs, i * 1000);
+    }
+    g_assert_cmpuint(ws_quantiles_count(qs), ==, 1000000);
+
+    /* Within the advertised relative error of the exact quantile */
+    value = ws_quantiles_get(qs, 0.5);
+    g_assert_cmpuint(value, >=, 500000000 / 32 * 31);
+    g_assert_cmpuint(value, <=, 500000000 / 32 * 33);
+    value = ws_quantiles_get(qs, 0.999);
+    g_assert_cmpuint(value, >=, 999000000 / 32 * 31);
+    g_assert_cmpuint(value, <=, 999000000 / 32 * 33);
+    value = ws_quantiles_get(qs, 0.0);
+    g_assert_cmpuint(value, >=, 1000 / 32 * 31);
+    g_assert_cmpuint(value, <=, 1000 / 32 * 33);
+
+    ws_quantiles_free(qs);
+}
+
+#include "crc32.h"
+#include "adler32.h"
+
+/* Bit at a time reference for the reflected CRCs */
+static uint32_t crc32_reflected_ref(const uint8_t *buf, size_t len, uint32_t crc, uint32_t poly)
+{
+    size_t i;
+    int bit;
+
+    for (i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+    }
+    return crc;
+}
+
+static void test_checksum_crc32(void)
+{
+    const uint8_t check[] = "123456789";
+    uint8_t buf[9100];
+    size_t i, len, offset;
+
+    g_assert_cmphex(crc32c_calculate_no_swap(check, 9, CRC32C_PRELOAD) ^ 0xFFFFFFFF, ==, 0xE3069283);
+    g_assert_cmphex(crc32_ccitt(check, 9), ==, 0xCBF43926);
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)(i * 131 + (i >> 7));
+
+    /* Every length and alignment the word at a time loops might get */
+    for (len = 0; len < 64; len++) {
+        for (offset = 0; offset < 8; offset++) {
+            g_assert_cmphex(crc32c_calculate_no_swap(buf + offset, (int)len, 0x12345678), ==,
+                crc32_reflected_ref(buf + offset, len, 0x12345678, 0x82F63B78));
+            g_assert_cmphex(crc32_ccitt_seed(buf + offset, (unsigned)len, CRC32_CCITT_SEED), ==,
+                ~crc32_reflected_ref(buf + offset, len, CRC32_CCITT_SEED, 0xEDB88320));
+        }
+    }
+    /* A jumbo frame */
+    g_assert_cmphex(crc32c_calculate_no_swap(buf + 1, 9000, CRC32C_PRELOAD), ==,
+        crc32_reflected_ref(buf + 1, 9000, CRC32C_PRELOAD, 0x82F63B78));
+    g_assert_cmphex(crc32_ccitt(buf + 1, 9000), ==,
+        ~crc32_reflected_ref(buf + 1, 9000, CRC32_CCITT_SEED, 0xEDB88320));
+}
+
+static void test_checksum_adler32(void)
+{
+    uint8_t buf[20000];
+    uint32_t s1 = 1, s2 = 0;
+    size_t i;
+
+    g_assert_cmphex(adler32_str("Wikipedia"), ==, 0x11E60398);
+
+    /* Long enough, and with big enough bytes, to need the deferred
+     * modulo reductions */
+    memset(buf, 0xFF, sizeof(buf));
+    for (i = 0; i < sizeof(buf); i++) {
+        s1 = (s1 + buf[i]) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    g_assert_cmphex(adler32_bytes(buf, sizeof(buf)), ==, (s2 << 16) | s1);
+}
+
+#include "unicode-utils.h"
+
+static void test_unicode_ascii_prefix(void)
+{
+    uint8_t buf[100];
+    size_t i;
+
+    memset(buf, 'a', sizeof(buf));
+    g_assert_cmpuint(ws_ascii_prefix_len(buf, 0), ==, 0);
+    g_assert_cmpuint(ws_ascii_prefix_len(buf, sizeof(buf)), ==, sizeof(buf));
+    /* A non-ASCII byte at every position, in and after the vector loop */
+    for (i = 0; i < sizeof(buf); i++) {
+        buf[i] = 0xC3;
+        g_assert_cmpuint(ws_ascii_prefix_len(buf, sizeof(buf)), ==, i);
+        g_assert_cmpuint(ws_ascii_prefix_len(buf, i), ==, i);
+        buf[i] = 'a';
+    }
+}
+
+static void test_unicode_utf16_ascii_prefix(void)
+{
+    const uint8_t le[] = "H\0e\0l\0l\0o\0,\0 \0w\0o\0r\0l\0d\0\xe9\0!\0";
+    const uint8_t be[] = "\0H\0e\0l\0l\0o\0,\0 \0w\0o\0r\0l\0d\x01\0\0!";
+    uint8_t out[16];
+
+    g_assert_cmpuint(ws_utf16_ascii_prefix(out, le, 14, true), ==, 12);
+    g_assert_true(memcmp(out, "Hello, world", 12) == 0);
+    g_assert_cmpuint(ws_utf16_ascii_prefix(out, be, 14, false), ==, 12);
+    g_assert_true(memcmp(out, "Hello, world", 12) == 0);
+    /* Read the wrong way round, every code unit is non-ASCII */
+    g_assert_cmpuint(ws_utf16_ascii_prefix(out, le, 14, false), ==, 0);
+    g_assert_cmpuint(ws_utf16_ascii_prefix(out, le, 0, true), ==, 0);
+}
+
+static void test_unicode_utf8_make_valid(void)
+{
+    uint8_t *str;
+
+    str = ws_utf8_make_valid(NULL, (const uint8_t *)"Valid UTF-8 string \xc3\xa9t\xc3\xa9", 25);
+    g_assert_cmpstr((char *)str, ==, "Valid UTF-8 string \xc3\xa9t\xc3\xa9");
+    wmem_free(NULL, str);
+
+    str = ws_utf8_make_valid(NULL, (const uint8_t *)"Invalid UTF-8 string \xc3\xc3t\xe0\x80", 26);
+    g_assert_cmpstr((char *)str, ==, "Invalid UTF-8 string \xef\xbf\xbd\xef\xbf\xbdt\xef\xbf\xbd\xef\xbf\xbd");
+    wmem_free(NULL, str);
+}
+
 #include "ws_getopt.h"
 
 #define ARGV_MAX 31
@@ -881,6 +1178,22 @@ int main(int argc, char **argv)
 
     g_test_add_func("/nstime/from_iso8601", test_nstime_from_iso8601);
 
+    g_test_add_func("/regex/literal", test_regex_literal);
+
+    g_test_add_func("/json_dumper/escape", test_json_dumper_escape);
+    g_test_add_func("/wsjson/parse_alloc", test_json_parse_alloc);
+
+    g_test_add_func("/sketch/hll", test_sketch_hll);
+    g_test_add_func("/sketch/topk", test_sketch_topk);
+    g_test_add_func("/sketch/quantiles", test_sketch_quantiles);
+
+    g_test_add_func("/checksum/crc32", test_checksum_crc32);
+    g_test_add_func("/checksum/adler32", test_checksum_adler32);
+
+    g_test_add_func("/unicode/ascii_prefix", test_unicode_ascii_prefix);
+    g_test_add_func("/unicode/utf16_ascii_prefix", test_unicode_utf16_ascii_prefix);
+    g_test_add_func("/unicode/utf8_make_valid", test_unicode_utf8_make_valid);
+
     g_test_add_func("/ws_getopt/basic1", test_getopt_long_basic1);
     g_test_add_func("/ws_getopt/basic2", test_getopt_long_basic2);
     g_test_add_func("/ws_getopt/optional1", test_getopt_optional_argument1);
@@ -12,6 +12,23 @@
 
 #include "unicode-utils.h"
 
+#include <string.h>
+
+#include "bits_ctz.h"
+#include "pint.h"
+
+/*
+ * SSE2 is part of x86-64 and NEON of AArch64, so the vector loops below
+ * need no run time check.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UNICODE_UTILS_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define UNICODE_UTILS_NEON
+#include <arm_neon.h>
+#endif
+
 int ws_utf8_seqlen[256] = {
     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 0x00...0x0f */
     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 0x10...0x1f */
@@ -31,6 +48,75 @@ int ws_utf8_seqlen[256] = {
     4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,  /* 0xf0...0xff */
 };
 
+size_t
+ws_ascii_prefix_len(const uint8_t *ptr, size_t length)
+{
+    size_t i = 0;
+    uint64_t word;
+
+#if defined(UNICODE_UTILS_SSE2)
+    for (; i + 16 <= length; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(ptr + i)));
+        if (mask != 0)
+            return i + ws_ctz(mask);
+    }
+#elif defined(UNICODE_UTILS_NEON)
+    for (; i + 16 <= length; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(ptr + i)) >= 0x80)
+            break;
+    }
+#endif
+    for (; i + 8 <= length; i += 8) {
+        memcpy(&word, ptr + i, sizeof(word));
+        if (word & UINT64_C(0x8080808080808080))
+            break;
+    }
+    while (i < length && ptr[i] < 0x80)
+        i++;
+    return i;
+}
+
+size_t
+ws_utf16_ascii_prefix(uint8_t *out, const uint8_t *ptr, size_t units, bool little_endian)
+{
+    size_t i = 0;
+    unsigned uchar;
+
+#if defined(UNICODE_UTILS_SSE2)
+    const __m128i high = _mm_set1_epi16((short)0xff80);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 8 <= units; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(ptr + 2 * i));
+
+        if (!little_endian)
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, high), zero)) != 0xffff)
+            break;
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(v, v));
+    }
+#elif defined(UNICODE_UTILS_NEON)
+    for (; i + 8 <= units; i += 8) {
+        uint8x16_t bytes = vld1q_u8(ptr + 2 * i);
+        uint16x8_t v;
+
+        if (!little_endian)
+            bytes = vrev16q_u8(bytes);
+        v = vreinterpretq_u16_u8(bytes);
+        if (vmaxvq_u16(v) >= 0x80)
+            break;
+        vst1_u8(out + i, vmovn_u16(v));
+    }
+#endif
+    for (; i < units; i++) {
+        uchar = little_endian ? pletoh16(ptr + 2 * i) : pntoh16(ptr + 2 * i);
+        if (uchar >= 0x80)
+            break;
+        out[i] = (uint8_t)uchar;
+    }
+    return i;
+}
+
 /* Given a pointer and a length, validates a string of bytes as UTF-8.
  * Returns the number of valid bytes, and a pointer immediately past
  * the checked region.
@@ -54,14 +140,14 @@ utf_8_validate(const uint8_t *start, ssize_t length, const uint8_t **end)
         ch = *ptr;
 
         if (ch < 0x80) {
-            valid_bytes++;
-            ptr++;
-            length--;
+            size_t ascii_len = ws_ascii_prefix_len(ptr, length);
+
+            valid_bytes += ascii_len;
+            ptr += ascii_len;
+            length -= ascii_len;
             continue;
         }
 
-        ch = *ptr;
-
         if (ch < 0xc2 || ch > 0xf4) {
             ptr++;
             length--;
@@ -221,7 +307,19 @@ ws_utf8_make_valid_strbuf(wmem_allocator_t *scope, const uint8_t *ptr, ssize_t l
 uint8_t *
 ws_utf8_make_valid(wmem_allocator_t *scope, const uint8_t *ptr, ssize_t length)
 {
-    wmem_strbuf_t *str = ws_utf8_make_valid_strbuf(scope, ptr, length);
+    wmem_strbuf_t *str;
+    const uint8_t *end;
+    uint8_t *buf;
+
+    /* Already valid, which is the usual case: copy it in one go. */
+    if (length >= 0 && utf_8_validate(ptr, length, &end) == (size_t)length) {
+        buf = (uint8_t *)wmem_alloc(scope, length + 1);
+        memcpy(buf, ptr, length);
+        buf[length] = '\0';
+        return buf;
+    }
+
+    str = ws_utf8_make_valid_strbuf(scope, ptr, length);
     return wmem_strbuf_finalize(str);
 }
 
@@ -59,6 +59,23 @@ int ws_utf8_seqlen[256];
  */
 #define ws_utf8_char_len(ch)  (ws_utf8_seqlen[(ch)])
 
+/**
+ * Return the number of bytes at the start of ptr, up to length, that are
+ * ASCII, i.e. that have the high-order bit clear.
+ */
+WS_DLL_PUBLIC size_t
+ws_ascii_prefix_len(const uint8_t *ptr, size_t length);
+
+/**
+ * Convert the UTF-16 code units at the start of ptr, up to units of
+ * them, that are below 0x80 to ASCII, writing them to out, which must
+ * have room for units bytes.  The result is not NUL terminated.
+ *
+ * @return The number of code units converted.
+ */
+WS_DLL_PUBLIC size_t
+ws_utf16_ascii_prefix(uint8_t *out, const uint8_t *ptr, size_t units, bool little_endian);
+
 /*
  * Given a wmem scope, a pointer, and a length, treat the string of bytes
  * referred to by the pointer and length as a UTF-8 string, and return a
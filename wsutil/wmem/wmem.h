@@ -19,6 +19,7 @@
 #include "wmem_map.h"
 #include "wmem_miscutl.h"
 #include "wmem_multimap.h"
+#include "wmem_profile.h"
 #include "wmem_queue.h"
 #include "wmem_stack.h"
 #include "wmem_strbuf.h"
@@ -16,6 +16,8 @@
 #include <glib.h>
 #include <string.h>
 
+#include "wmem_core.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -34,6 +36,7 @@ struct _wmem_allocator_t {
     void  (*free_all)(void *private_data);
     void  (*gc)(void *private_data);
     void  (*cleanup)(void *private_data);
+    void  (*get_stats)(void *private_data, wmem_allocator_stats_t *stats); /* may be NULL */
 
     /* Callback List */
     struct _wmem_user_cb_container_t *callbacks;
@@ -42,6 +45,7 @@ struct _wmem_allocator_t {
     void                        *private_data;
     enum _wmem_allocator_type_t  type;
     bool                         in_scope;
+    const char                  *name; /* for the allocation profiler */
 };
 
 #ifdef __cplusplus
@@ -199,6 +199,9 @@ typedef struct _wmem_block_allocator_t {
     wmem_block_hdr_t   *block_list;
     wmem_block_chunk_t *master_head;
     wmem_block_chunk_t *recycler_head;
+
+    /* Number of normal-sized blocks, see wmem_get_stats() */
+    size_t              num_blocks;
 } wmem_block_allocator_t;
 
 /* DEBUG AND TEST */
@@ -764,6 +767,7 @@ wmem_block_new_block(wmem_block_allocator_t *allocator)
     /* allocate the new block and add it to the block list */
     block = (wmem_block_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
     wmem_block_add_to_block_list(allocator, block);
+    allocator->num_blocks++;
 
     /* initialize it */
     wmem_block_init_block(allocator, block);
@@ -1068,6 +1072,7 @@ wmem_block_gc(void *private_data)
                 allocator->master_head = free_chunk->next;
             }
             wmem_free(NULL, cur);
+            allocator->num_blocks--;
         }
         else {
             /* part of this block is used, so add it to the new block list */
@@ -1078,6 +1083,19 @@ wmem_block_gc(void *private_data)
     }
 }
 
+static void
+wmem_block_get_stats(void *private_data, wmem_allocator_stats_t *stats)
+{
+    wmem_block_allocator_t *allocator = (wmem_block_allocator_t*) private_data;
+
+    /* We don't know how much of the blocks is in use without walking
+     * them, nor the size of jumbo allocations. */
+    stats->in_use   = 0;
+    stats->peak     = 0;
+    stats->retained = allocator->num_blocks * WMEM_BLOCK_SIZE;
+    stats->resets   = 0;
+}
+
 static void
 wmem_block_allocator_cleanup(void *private_data)
 {
@@ -1104,11 +1122,14 @@ wmem_block_allocator_init(wmem_allocator_t *allocator)
     allocator->gc       = &wmem_block_gc;
     allocator->cleanup  = &wmem_block_allocator_cleanup;
 
+    allocator->get_stats = &wmem_block_get_stats;
+
     allocator->private_data = (void*) block_allocator;
 
     block_allocator->block_list    = NULL;
     block_allocator->master_head   = NULL;
     block_allocator->recycler_head = NULL;
+    block_allocator->num_blocks    = 0;
 }
 
 /*
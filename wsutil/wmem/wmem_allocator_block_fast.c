@@ -63,6 +63,18 @@ typedef struct _wmem_block_fast_jumbo {
 typedef struct {
     wmem_block_fast_hdr_t   *block_list;
     wmem_block_fast_jumbo_t *jumbo_list;
+
+    /* Blocks that were in use before the last free_all, kept so that the
+     * next packet needing as much memory doesn't go back to the system
+     * allocator. Only gc gives them back. */
+    wmem_block_fast_hdr_t   *spare_list;
+
+    /* Statistics, see wmem_get_stats() */
+    size_t                   in_use;
+    size_t                   peak;
+    size_t                   num_blocks;
+    size_t                   jumbo_size;
+    uint64_t                 resets;
 } wmem_block_fast_allocator_t;
 
 /* Creates a new block, and initializes it. */
@@ -71,8 +83,16 @@ wmem_block_fast_new_block(wmem_block_fast_allocator_t *allocator)
 {
     wmem_block_fast_hdr_t *block;
 
-    /* allocate/initialize the new block and add it to the block list */
-    block = (wmem_block_fast_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    /* reuse a spare block if there is one, otherwise allocate a new one,
+     * and add it to the block list */
+    if (allocator->spare_list) {
+        block = allocator->spare_list;
+        allocator->spare_list = block->next;
+    }
+    else {
+        block = (wmem_block_fast_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+        allocator->num_blocks++;
+    }
 
     block->pos  = WMEM_BLOCK_HEADER_SIZE;
     block->next = allocator->block_list;
@@ -106,6 +126,9 @@ wmem_block_fast_alloc(void *private_data, const size_t size)
         chunk = ((wmem_block_fast_chunk_t*)((uint8_t*)(block) + WMEM_JUMBO_HEADER_SIZE));
         chunk->len = JUMBO_MAGIC;
 
+        allocator->in_use += size;
+        allocator->jumbo_size += size;
+
         return WMEM_CHUNK_TO_DATA(chunk);
     }
 
@@ -122,6 +145,7 @@ wmem_block_fast_alloc(void *private_data, const size_t size)
     chunk->len = (uint32_t) size;
 
     allocator->block_list->pos += real_size;
+    allocator->in_use += real_size;
 
     /* and return the user's pointer */
     return WMEM_CHUNK_TO_DATA(chunk);
@@ -180,8 +204,14 @@ wmem_block_fast_free_all(void *private_data)
     wmem_block_fast_hdr_t       *cur, *nxt;
     wmem_block_fast_jumbo_t     *cur_jum, *nxt_jum;
 
-    /* iterate through the blocks, freeing all but the first and reinitializing
-     * that one */
+    if (allocator->in_use > allocator->peak)
+        allocator->peak = allocator->in_use;
+    allocator->in_use = 0;
+    allocator->jumbo_size = 0;
+    allocator->resets++;
+
+    /* iterate through the blocks, reinitializing the first and moving the
+     * others to the spare list */
     cur = allocator->block_list;
 
     if (cur) {
@@ -193,7 +223,8 @@ wmem_block_fast_free_all(void *private_data)
 
     while (cur) {
         nxt  = cur->next;
-        wmem_free(NULL, cur);
+        cur->next = allocator->spare_list;
+        allocator->spare_list = cur;
         cur = nxt;
     }
 
@@ -208,9 +239,31 @@ wmem_block_fast_free_all(void *private_data)
 }
 
 static void
-wmem_block_fast_gc(void *private_data _U_)
+wmem_block_fast_gc(void *private_data)
+{
+    wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
+    wmem_block_fast_hdr_t       *cur, *nxt;
+
+    /* give the spare blocks back */
+    cur = allocator->spare_list;
+    while (cur) {
+        nxt  = cur->next;
+        wmem_free(NULL, cur);
+        allocator->num_blocks--;
+        cur = nxt;
+    }
+    allocator->spare_list = NULL;
+}
+
+static void
+wmem_block_fast_get_stats(void *private_data, wmem_allocator_stats_t *stats)
 {
-    /* No-op */
+    wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
+
+    stats->in_use   = allocator->in_use;
+    stats->peak     = MAX(allocator->peak, allocator->in_use);
+    stats->retained = allocator->num_blocks * WMEM_BLOCK_SIZE + allocator->jumbo_size;
+    stats->resets   = allocator->resets;
 }
 
 static void
@@ -219,8 +272,9 @@ wmem_block_fast_allocator_cleanup(void *private_data)
     wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
 
     /* wmem guarantees that free_all() is called directly before this, so
-     * simply free the first block */
+     * simply free the first block and the spare ones */
     wmem_free(NULL, allocator->block_list);
+    wmem_block_fast_gc(private_data);
 
     /* then just free the allocator structs */
     wmem_free(NULL, private_data);
@@ -241,10 +295,19 @@ wmem_block_fast_allocator_init(wmem_allocator_t *allocator)
     allocator->gc       = &wmem_block_fast_gc;
     allocator->cleanup  = &wmem_block_fast_allocator_cleanup;
 
+    allocator->get_stats = &wmem_block_fast_get_stats;
+
     allocator->private_data = (void*) block_allocator;
 
     block_allocator->block_list = NULL;
     block_allocator->jumbo_list = NULL;
+    block_allocator->spare_list = NULL;
+
+    block_allocator->in_use     = 0;
+    block_allocator->peak       = 0;
+    block_allocator->num_blocks = 0;
+    block_allocator->jumbo_size = 0;
+    block_allocator->resets     = 0;
 }
 
 /*
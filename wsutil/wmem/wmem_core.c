@@ -16,6 +16,7 @@
 #include "wmem-int.h"
 #include "wmem_core.h"
 #include "wmem_map_int.h"
+#include "wmem_profile_int.h"
 #include "wmem_user_cb_int.h"
 #include "wmem_allocator.h"
 #include "wmem_allocator_simple.h"
@@ -41,6 +42,8 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    WMEM_PROFILE_ALLOC(allocator, size);
+
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -49,7 +52,20 @@ wmem_alloc0(wmem_allocator_t *allocator, const size_t size)
 {
     void *buf;
 
-    buf = wmem_alloc(allocator, size);
+    if (allocator == NULL) {
+        return g_malloc0(size);
+    }
+
+    ws_assert(allocator->in_scope);
+
+    if (size == 0) {
+        return NULL;
+    }
+
+    /* Not wmem_alloc(), so that the caller is the profiled callsite */
+    WMEM_PROFILE_ALLOC(allocator, size);
+
+    buf = allocator->walloc(allocator->private_data, size);
 
     if (buf) {
         memset(buf, 0, size);
@@ -82,10 +98,6 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
         return g_realloc(ptr, size);
     }
 
-    if (ptr == NULL) {
-        return wmem_alloc(allocator, size);
-    }
-
     if (size == 0) {
         wmem_free(allocator, ptr);
         return NULL;
@@ -93,6 +105,14 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
 
     ws_assert(allocator->in_scope);
 
+    /* The profiler counts the whole new size, as if it were a new
+     * allocation */
+    WMEM_PROFILE_ALLOC(allocator, size);
+
+    if (ptr == NULL) {
+        return allocator->walloc(allocator->private_data, size);
+    }
+
     return allocator->wrealloc(allocator->private_data, ptr, size);
 }
 
@@ -116,6 +136,20 @@ wmem_gc(wmem_allocator_t *allocator)
     allocator->gc(allocator->private_data);
 }
 
+void
+wmem_get_stats(wmem_allocator_t *allocator, wmem_allocator_stats_t *stats)
+{
+    memset(stats, 0, sizeof *stats);
+    if (allocator->get_stats)
+        allocator->get_stats(allocator->private_data, stats);
+}
+
+void
+wmem_allocator_set_name(wmem_allocator_t *allocator, const char *name)
+{
+    allocator->name = name;
+}
+
 void
 wmem_destroy_allocator(wmem_allocator_t *allocator)
 {
@@ -141,7 +175,9 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator = wmem_new(NULL, wmem_allocator_t);
     allocator->type      = real_type;
     allocator->callbacks = NULL;
+    allocator->get_stats = NULL;
     allocator->in_scope  = true;
+    allocator->name      = NULL;
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
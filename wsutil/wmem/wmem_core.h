@@ -176,7 +176,9 @@ wmem_free_all(wmem_allocator_t *allocator);
 
 /** Triggers a garbage-collection in the allocator. This does not free any
  * memory, but it can return unused blocks to the operating system or perform
- * other optimizations.
+ * other optimizations. WMEM_ALLOCATOR_BLOCK_FAST keeps the blocks it needed
+ * for its largest use across wmem_free_all() calls and only gives them back
+ * here.
  *
  * @param allocator The allocator in which to trigger the garbage collection.
  */
@@ -184,6 +186,39 @@ WS_DLL_PUBLIC
 void
 wmem_gc(wmem_allocator_t *allocator);
 
+/** Give an allocator a name, under which the allocation profiler (see
+ * wmem_profile.h) reports what was allocated from it.
+ *
+ * @param allocator The allocator to name.
+ * @param name A string that lives as long as the allocator.
+ */
+WS_DLL_PUBLIC
+void
+wmem_allocator_set_name(wmem_allocator_t *allocator, const char *name);
+
+/** Memory usage of an allocator, as reported by wmem_get_stats(). */
+typedef struct _wmem_allocator_stats_t {
+    size_t   in_use;   /**< Bytes handed out since the last wmem_free_all() */
+    size_t   peak;     /**< Largest in_use between two calls to
+                            wmem_free_all(), i.e. the high-water mark of a
+                            pool that is reset after each packet */
+    size_t   retained; /**< Bytes obtained from the system and kept by the
+                            allocator, including those in use */
+    uint64_t resets;   /**< Number of calls to wmem_free_all() */
+} wmem_allocator_stats_t;
+
+/** Get the memory usage of an allocator. Only WMEM_ALLOCATOR_BLOCK_FAST
+ * keeps all of these statistics; WMEM_ALLOCATOR_BLOCK only reports the
+ * memory it retains, not counting allocations too big for one of its
+ * blocks, and for the other allocators everything is zero.
+ *
+ * @param allocator The allocator to get the statistics of.
+ * @param stats Filled in with the statistics.
+ */
+WS_DLL_PUBLIC
+void
+wmem_get_stats(wmem_allocator_t *allocator, wmem_allocator_stats_t *stats);
+
 /** Destroy the given allocator, freeing all memory allocated in it. Once this
  * function has been called, no memory allocated with the allocator is valid.
  *
@@ -134,6 +134,27 @@ wmem_itree_insert(wmem_itree_t *tree, const uint64_t low, const uint64_t high, v
     update_max_edge(node);
 }
 
+bool
+wmem_itree_extend(wmem_itree_t *tree, const uint64_t low, const uint64_t high)
+{
+    wmem_tree_node_t *node = tree->root;
+    wmem_range_t *range;
+
+    while (node) {
+        range = (wmem_range_t *)node->key;
+        if (low == range->low) {
+            if (high < range->high) {
+                return false;
+            }
+            range->high = high;
+            update_max_edge(node);
+            return true;
+        }
+        node = (low < range->low) ? node->left : node->right;
+    }
+    return false;
+}
+
 
 static void
 wmem_itree_find_intervals_in_subtree(wmem_tree_node_t *node, wmem_range_t requested, wmem_list_t *results)
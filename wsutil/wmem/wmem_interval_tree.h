@@ -63,6 +63,15 @@ void
 wmem_itree_insert(wmem_itree_t *tree, const uint64_t low, const uint64_t high, void *data);
 
 
+/** Extends the range indexed by "low" so that it ends at "high", in O(log(n)).
+ * Returns false, leaving the tree unchanged, if there is no range starting at
+ * "low" or if it already ends after "high".
+ */
+WS_DLL_PUBLIC
+bool
+wmem_itree_extend(wmem_itree_t *tree, const uint64_t low, const uint64_t high);
+
+
 /*
  * Save results in a wmem_list with the scope passed as a parameter.
  * wmem_list_t is always allocated even if there is no result
@@ -218,6 +218,43 @@ wmem_list_insert_sorted(wmem_list_t *list, void* data, GCompareFunc func)
     new_frame->next->prev = new_frame;
 }
 
+void
+wmem_list_append_sorted(wmem_list_t *list, void* data, GCompareFunc func)
+{
+    wmem_list_frame_t *new_frame;
+    wmem_list_frame_t *cur;
+
+    new_frame = wmem_new(list->allocator, wmem_list_frame_t);
+    new_frame->data = data;
+
+    list->count++;
+
+    /* Walk back from the tail to the last frame that sorts before or
+     * together with the new data; equal items keep their insertion order,
+     * the same as with wmem_list_insert_sorted(). */
+    cur = list->tail;
+    while (cur && func(cur->data, data) > 0) {
+        cur = cur->prev;
+    }
+
+    new_frame->prev = cur;
+    if (cur) {
+        new_frame->next = cur->next;
+        cur->next = new_frame;
+    }
+    else {
+        new_frame->next = list->head;
+        list->head = new_frame;
+    }
+
+    if (new_frame->next) {
+        new_frame->next->prev = new_frame;
+    }
+    else {
+        list->tail = new_frame;
+    }
+}
+
 wmem_list_t *
 wmem_list_new(wmem_allocator_t *allocator)
 {
@@ -91,6 +91,15 @@ WS_DLL_PUBLIC
 void
 wmem_list_insert_sorted(wmem_list_t *list, void* data, GCompareFunc func);
 
+/**
+ * Insert data into a sorted list like wmem_list_insert_sorted(), but
+ * search for its place starting from the tail, which is much faster
+ * when new data usually goes at or near the end of the list.
+ */
+WS_DLL_PUBLIC
+void
+wmem_list_append_sorted(wmem_list_t *list, void* data, GCompareFunc func);
+
 
 WS_DLL_PUBLIC
 wmem_list_t *
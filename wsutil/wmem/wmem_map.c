@@ -10,8 +10,13 @@
  */
 #include "config.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <glib.h>
 
+#include <wsutil/bits_ctz.h>
+
 #include "wmem_core.h"
 #include "wmem_list.h"
 #include "wmem_map.h"
@@ -20,6 +25,11 @@
 
 static uint32_t x; /* Used for universal integer hashing (see the HASH macro) */
 
+/* Used for hashing keys of open maps (see the OPEN_HASH macro); always odd */
+static uint64_t x64 = 1;
+
+static wmem_map_type_t default_type = WMEM_MAP_CHAINED;
+
 /* Used for the wmem_strong_hash() function */
 static uint32_t preseed;
 static uint32_t postseed;
@@ -27,12 +37,29 @@ static uint32_t postseed;
 void
 wmem_init_hashing(void)
 {
+    const char *type_env;
+
     x = g_random_int();
     if (G_UNLIKELY(x == 0))
         x = 1;
 
+    x64 = ((uint64_t)g_random_int() << 32 | g_random_int()) | 1;
+
     preseed  = g_random_int();
     postseed = g_random_int();
+
+    /* Lets the open addressing maps be tried out (or ruled out when
+     * debugging) everywhere without recompiling. */
+    type_env = getenv("WIRESHARK_WMEM_MAP_TYPE");
+    if (type_env != NULL) {
+        if (strcmp(type_env, "open") == 0) {
+            default_type = WMEM_MAP_OPEN;
+        } else if (strcmp(type_env, "chained") == 0) {
+            default_type = WMEM_MAP_CHAINED;
+        } else {
+            g_warning("Unrecognized wmem map type");
+        }
+    }
 }
 
 typedef struct _wmem_map_item_t {
@@ -52,6 +79,14 @@ struct _wmem_map_t {
 
     wmem_map_item_t **table;
 
+    /* WMEM_MAP_OPEN only: the slots and their control bytes (which share
+     * one allocation), and the number of deleted slots */
+    struct _wmem_map_slot_t *slots;
+    uint8_t   *ctrl;
+    unsigned   deleted;
+
+    wmem_map_type_t type;
+
     GHashFunc  hash_func;
     GEqualFunc eql_func;
 
@@ -76,6 +111,259 @@ struct _wmem_map_t {
 #define HASH(MAP, KEY) \
     ((uint32_t)(((MAP)->hash_func(KEY) * x) >> (32 - (MAP)->capacity)))
 
+/*
+ * Open addressing
+ *
+ * Maps created as WMEM_MAP_OPEN keep their items in a single array of
+ * key/value slots, so that a lookup touches no memory other than the
+ * table itself. Each slot has a control byte in a separate array, which
+ * is either EMPTY, DELETED or, for used slots, 7 bits of the key's hash.
+ * The slots are divided into groups of WMEM_MAP_GROUP_WIDTH, and a
+ * lookup compares the control bytes of a whole group at once (with SSE2
+ * where available, or 8 bytes at a time in an integer otherwise) before
+ * calling the equality function on the few slots that match.
+ *
+ * Groups are probed in triangular order (g, g+1, g+3, g+6, ...), which
+ * visits every group of a power-of-two table. A lookup stops at the
+ * first group containing an EMPTY slot, since an insertion would have
+ * used that slot rather than probe further.
+ */
+#define CTRL_EMPTY   ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+#define CTRL_IS_FULL(C) (((C) & 0x80) == 0)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WMEM_MAP_GROUP_SSE2
+#include <emmintrin.h>
+#define WMEM_MAP_GROUP_WIDTH 16
+/* One bit per control byte */
+#define GROUP_BIT_INDEX(MASK) ((size_t)ws_ctz(MASK))
+typedef uint32_t wmem_map_bitmask_t;
+#else
+#define WMEM_MAP_GROUP_WIDTH 8
+/* The high bit of each control byte */
+#define GROUP_BIT_INDEX(MASK) ((size_t)ws_ctz(MASK) >> 3)
+typedef uint64_t wmem_map_bitmask_t;
+#define GROUP_LSBS UINT64_C(0x0101010101010101)
+#define GROUP_MSBS UINT64_C(0x8080808080808080)
+#endif
+
+
+typedef struct _wmem_map_slot_t {
+    const void *key;
+    void *value;
+} wmem_map_slot_t;
+
+/* The group index comes from the high half of the product and the control
+ * byte from the top of the low half, so that the two are independent. */
+#define OPEN_HASH(MAP, KEY) ((uint64_t)(MAP)->hash_func(KEY) * x64)
+#define OPEN_H1(H) ((size_t)((H) >> 32))
+#define OPEN_H2(H) ((uint8_t)(((H) >> 25) & 0x7F))
+
+#define GROUP_MASK(MAP) ((CAPACITY(MAP) / WMEM_MAP_GROUP_WIDTH) - 1)
+
+/* Resize once more than 7/8 of the slots are used or deleted */
+#define MAX_LOAD(MAP) (CAPACITY(MAP) - CAPACITY(MAP) / 8)
+
+#ifdef WMEM_MAP_GROUP_SSE2
+static inline wmem_map_bitmask_t
+group_match(const uint8_t *group, uint8_t h2)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+
+    return (wmem_map_bitmask_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+}
+
+static inline wmem_map_bitmask_t
+group_match_empty(const uint8_t *group)
+{
+    return group_match(group, CTRL_EMPTY);
+}
+
+/* EMPTY or DELETED */
+static inline wmem_map_bitmask_t
+group_match_free(const uint8_t *group)
+{
+    return (wmem_map_bitmask_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+}
+#else
+static inline uint64_t
+group_load(const uint8_t *group)
+{
+    uint64_t word;
+
+    memcpy(&word, group, sizeof word);
+    return GUINT64_FROM_LE(word);
+}
+
+/* May report false positives (in the byte above a real match), so callers
+ * must check the control byte itself. */
+static inline wmem_map_bitmask_t
+group_match(const uint8_t *group, uint8_t h2)
+{
+    uint64_t word = group_load(group) ^ (GROUP_LSBS * h2);
+
+    return (word - GROUP_LSBS) & ~word & GROUP_MSBS;
+}
+
+/* EMPTY is the only control byte with the high bit set and the next one
+ * clear. */
+static inline wmem_map_bitmask_t
+group_match_empty(const uint8_t *group)
+{
+    uint64_t word = group_load(group);
+
+    return word & ~(word << 1) & GROUP_MSBS;
+}
+
+static inline wmem_map_bitmask_t
+group_match_free(const uint8_t *group)
+{
+    return group_load(group) & GROUP_MSBS;
+}
+#endif
+
+static void
+wmem_map_open_alloc(wmem_map_t *map)
+{
+    map->slots = (wmem_map_slot_t *)wmem_alloc(map->data_allocator,
+            CAPACITY(map) * (sizeof(wmem_map_slot_t) + 1));
+    map->ctrl = (uint8_t *)(map->slots + CAPACITY(map));
+    memset(map->ctrl, CTRL_EMPTY, CAPACITY(map));
+    map->deleted = 0;
+}
+
+static inline wmem_map_slot_t *
+wmem_map_open_find(wmem_map_t *map, const void *key, uint64_t hash)
+{
+    size_t mask = GROUP_MASK(map);
+    size_t g = OPEN_H1(hash) & mask;
+    size_t stride = 0;
+    size_t i;
+    uint8_t h2 = OPEN_H2(hash);
+    const uint8_t *group;
+    wmem_map_bitmask_t match;
+
+    for (;;) {
+        group = map->ctrl + g * WMEM_MAP_GROUP_WIDTH;
+        for (match = group_match(group, h2); match; match &= match - 1) {
+            i = g * WMEM_MAP_GROUP_WIDTH + GROUP_BIT_INDEX(match);
+            if (map->ctrl[i] == h2 && map->eql_func(key, map->slots[i].key)) {
+                return &map->slots[i];
+            }
+        }
+        if (group_match_empty(group)) {
+            return NULL;
+        }
+        stride++;
+        g = (g + stride) & mask;
+    }
+}
+
+static inline size_t
+wmem_map_open_find_free(const wmem_map_t *map, uint64_t hash)
+{
+    size_t mask = GROUP_MASK(map);
+    size_t g = OPEN_H1(hash) & mask;
+    size_t stride = 0;
+    wmem_map_bitmask_t match;
+
+    for (;;) {
+        match = group_match_free(map->ctrl + g * WMEM_MAP_GROUP_WIDTH);
+        if (match) {
+            return g * WMEM_MAP_GROUP_WIDTH + GROUP_BIT_INDEX(match);
+        }
+        stride++;
+        g = (g + stride) & mask;
+    }
+}
+
+/* Rebuild the table with 2^capacity slots, dropping deleted entries */
+static void
+wmem_map_open_rehash(wmem_map_t *map, size_t capacity)
+{
+    wmem_map_slot_t *old_slots = map->slots;
+    uint8_t         *old_ctrl  = map->ctrl;
+    size_t           old_cap   = CAPACITY(map);
+    size_t           i, j;
+    uint64_t         hash;
+
+    map->capacity = capacity;
+    wmem_map_open_alloc(map);
+
+    for (i = 0; i < old_cap; i++) {
+        if (CTRL_IS_FULL(old_ctrl[i])) {
+            hash = OPEN_HASH(map, old_slots[i].key);
+            j = wmem_map_open_find_free(map, hash);
+            map->ctrl[j]  = OPEN_H2(hash);
+            map->slots[j] = old_slots[i];
+        }
+    }
+
+    wmem_free(map->data_allocator, old_slots);
+}
+
+static void
+wmem_map_open_erase(wmem_map_t *map, size_t i)
+{
+    /* If the slot's group still has an empty slot no lookup ever probed
+     * past it, so the slot can become empty again rather than deleted. */
+    if (group_match_empty(map->ctrl + (i & ~(size_t)(WMEM_MAP_GROUP_WIDTH - 1)))) {
+        map->ctrl[i] = CTRL_EMPTY;
+    } else {
+        map->ctrl[i] = CTRL_DELETED;
+        map->deleted++;
+    }
+    map->count--;
+}
+
+static void *
+wmem_map_open_insert(wmem_map_t *map, const void *key, void *value)
+{
+    wmem_map_slot_t *slot;
+    uint64_t         hash = OPEN_HASH(map, key);
+    size_t           i;
+    void            *old_val;
+
+    if (map->slots == NULL) {
+        map->capacity = WMEM_MAP_DEFAULT_CAPACITY;
+        wmem_map_open_alloc(map);
+    } else {
+        slot = wmem_map_open_find(map, key, hash);
+        if (slot) {
+            old_val = slot->value;
+            slot->value = value;
+            return old_val;
+        }
+        if (map->count + map->deleted + 1 > MAX_LOAD(map)) {
+            /* Only grow if the live items alone fill the table by half or
+             * more; otherwise clearing out the deleted slots is enough. */
+            wmem_map_open_rehash(map, map->capacity +
+                    (map->count >= CAPACITY(map) / 2 ? 1 : 0));
+        }
+    }
+
+    i = wmem_map_open_find_free(map, hash);
+    if (map->ctrl[i] == CTRL_DELETED) {
+        map->deleted--;
+    }
+    map->ctrl[i]        = OPEN_H2(hash);
+    map->slots[i].key   = key;
+    map->slots[i].value = value;
+    map->count++;
+
+    return NULL;
+}
+
+static inline wmem_map_slot_t *
+wmem_map_open_lookup(wmem_map_t *map, const void *key)
+{
+    if (map->slots == NULL) {
+        return NULL;
+    }
+    return wmem_map_open_find(map, key, OPEN_HASH(map, key));
+}
+
 static void
 wmem_map_init_table(wmem_map_t *map)
 {
@@ -98,6 +386,10 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->data_allocator = allocator;
     map->count = 0;
     map->table = NULL;
+    map->slots = NULL;
+    map->ctrl  = NULL;
+    map->deleted = 0;
+    map->type  = default_type;
 
     return map;
 }
@@ -110,6 +402,9 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
 
     map->count = 0;
     map->table = NULL;
+    map->slots = NULL;
+    map->ctrl  = NULL;
+    map->deleted = 0;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(map->metadata_allocator, map->metadata_scope_cb_id);
@@ -144,6 +439,10 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     map->data_allocator = data_scope;
     map->count = 0;
     map->table = NULL;
+    map->slots = NULL;
+    map->ctrl  = NULL;
+    map->deleted = 0;
+    map->type  = default_type;
 
     map->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_map_destroy_cb, map);
     map->data_scope_cb_id  = wmem_register_callback(data_scope, wmem_map_reset_cb, map);
@@ -151,6 +450,23 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     return map;
 }
 
+void
+wmem_map_set_type(wmem_map_t *map, wmem_map_type_t type)
+{
+    /* Both kinds of table are empty (and NULL) before the first insertion */
+    if (map->table != NULL || map->slots != NULL) {
+        g_warning("wmem_map_set_type called on a map that has been used");
+        return;
+    }
+    map->type = type;
+}
+
+void
+wmem_map_set_default_type(wmem_map_type_t type)
+{
+    default_type = type;
+}
+
 static inline void
 wmem_map_grow(wmem_map_t *map)
 {
@@ -189,6 +505,10 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
     wmem_map_item_t **item;
     void *old_val;
 
+    if (map->type == WMEM_MAP_OPEN) {
+        return wmem_map_open_insert(map, key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
@@ -231,6 +551,10 @@ wmem_map_contains(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map->type == WMEM_MAP_OPEN) {
+        return wmem_map_open_lookup(map, key) != NULL;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return false;
@@ -254,6 +578,12 @@ void *
 wmem_map_lookup(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
+    wmem_map_slot_t *slot;
+
+    if (map->type == WMEM_MAP_OPEN) {
+        slot = wmem_map_open_lookup(map, key);
+        return slot ? slot->value : NULL;
+    }
 
     /* Make sure we have a table */
     if (map->table == NULL) {
@@ -278,6 +608,21 @@ bool
 wmem_map_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key, void **value)
 {
     wmem_map_item_t *item;
+    wmem_map_slot_t *slot;
+
+    if (map->type == WMEM_MAP_OPEN) {
+        slot = wmem_map_open_lookup(map, key);
+        if (slot == NULL) {
+            return false;
+        }
+        if (orig_key) {
+            *orig_key = slot->key;
+        }
+        if (value) {
+            *value = slot->value;
+        }
+        return true;
+    }
 
     /* Make sure we have a table */
     if (map->table == NULL) {
@@ -308,8 +653,19 @@ void *
 wmem_map_remove(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
+    wmem_map_slot_t *slot;
     void *value;
 
+    if (map->type == WMEM_MAP_OPEN) {
+        slot = wmem_map_open_lookup(map, key);
+        if (slot == NULL) {
+            return NULL;
+        }
+        value = slot->value;
+        wmem_map_open_erase(map, (size_t)(slot - map->slots));
+        return value;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -340,6 +696,16 @@ bool
 wmem_map_steal(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
+    wmem_map_slot_t *slot;
+
+    if (map->type == WMEM_MAP_OPEN) {
+        slot = wmem_map_open_lookup(map, key);
+        if (slot == NULL) {
+            return false;
+        }
+        wmem_map_open_erase(map, (size_t)(slot - map->slots));
+        return true;
+    }
 
     /* Make sure we have a table */
     if (map->table == NULL) {
@@ -372,6 +738,16 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
+    if (map->slots != NULL) {
+        capacity = CAPACITY(map);
+
+        for (i=0; i<capacity; i++) {
+            if (CTRL_IS_FULL(map->ctrl[i])) {
+                wmem_list_prepend(list, (void*)map->slots[i].key);
+            }
+        }
+    }
+
     if (map->table != NULL) {
         capacity = CAPACITY(map);
 
@@ -394,6 +770,15 @@ wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, void * user_data)
     wmem_map_item_t *cur;
     unsigned i;
 
+    if (map->slots != NULL) {
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (CTRL_IS_FULL(map->ctrl[i])) {
+                foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data);
+            }
+        }
+        return;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return;
@@ -414,6 +799,17 @@ wmem_map_foreach_remove(wmem_map_t *map, GHRFunc foreach_func, void * user_data)
     wmem_map_item_t **item, *tmp;
     unsigned i, deleted = 0;
 
+    if (map->slots != NULL) {
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (CTRL_IS_FULL(map->ctrl[i]) &&
+                    foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data)) {
+                wmem_map_open_erase(map, i);
+                deleted++;
+            }
+        }
+        return deleted;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return 0;
@@ -37,6 +37,14 @@ extern "C" {
 struct _wmem_map_t;
 typedef struct _wmem_map_t wmem_map_t;
 
+/** The ways a map can store its items. They behave the same apart from the
+ * order in which wmem_map_foreach() and friends visit the items. */
+typedef enum _wmem_map_type_t {
+    WMEM_MAP_CHAINED,   /**< A bucket array with a list of items per bucket */
+    WMEM_MAP_OPEN       /**< Open addressing, with the items in the table
+                             itself; fewer allocations and cache misses */
+} wmem_map_type_t;
+
 /** Creates a map with the given allocator scope. When the scope is emptied,
  * the map is fully destroyed. Items stored in it will not be freed unless they
  * were allocated from the same scope. For details on the GHashFunc and
@@ -77,6 +85,27 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
         GHashFunc hash_func, GEqualFunc eql_func)
 G_GNUC_MALLOC;
 
+/** Changes the way a map stores its items. Maps are created with the
+ * default type (see wmem_map_set_default_type()); this must be called
+ * before anything is inserted.
+ *
+ * @param map The map to change.
+ * @param type The type of table to use.
+ */
+WS_DLL_PUBLIC
+void
+wmem_map_set_type(wmem_map_t *map, wmem_map_type_t type);
+
+/** Sets the type of maps created from now on. It is WMEM_MAP_CHAINED unless
+ * the WIRESHARK_WMEM_MAP_TYPE environment variable is set to "open" when
+ * wmem is initialized.
+ *
+ * @param type The type of table to use.
+ */
+WS_DLL_PUBLIC
+void
+wmem_map_set_default_type(wmem_map_type_t type);
+
 /** Inserts a value into the map.
  *
  * @param map The map to insert into.
@@ -0,0 +1,233 @@
+/* wmem_profile.c
+ * Wireshark Memory Manager allocation profiler
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#define _GNU_SOURCE
+#include "config.h"
+
+#include <glib.h>
+
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+#include "wmem-int.h"
+#include "wmem_allocator.h"
+#include "wmem_profile.h"
+#include "wmem_profile_int.h"
+
+/*
+ * Sampling works as in tcmalloc: every allocation subtracts its size from a
+ * countdown, and the allocation that takes it below zero is sampled. Each
+ * sample stands for the bytes counted down since the previous one (or for
+ * itself, if it is bigger than that), so summing the samples gives unbiased
+ * estimates of the bytes and number of allocations. The interval is varied
+ * randomly around its mean so that allocation patterns with a period don't
+ * keep hitting, or missing, the same callsites.
+ */
+#define COUNTDOWN_STOPPED INT64_MAX
+
+int64_t wmem_profile_countdown = COUNTDOWN_STOPPED;
+
+static size_t profile_interval;
+static const char * const *profile_context;
+
+static GHashTable *profile_table;
+static uint64_t    profile_total;
+static GMutex      profile_mutex;
+
+static unsigned
+profile_entry_hash(gconstpointer key)
+{
+    const wmem_profile_entry_t *entry = (const wmem_profile_entry_t *)key;
+
+    return g_direct_hash(entry->scope) ^ (g_direct_hash(entry->context) * 31) ^
+        (g_direct_hash(entry->callsite) * 961);
+}
+
+static gboolean
+profile_entry_equal(gconstpointer a, gconstpointer b)
+{
+    const wmem_profile_entry_t *entry_a = (const wmem_profile_entry_t *)a;
+    const wmem_profile_entry_t *entry_b = (const wmem_profile_entry_t *)b;
+
+    return entry_a->scope == entry_b->scope &&
+        entry_a->context == entry_b->context &&
+        entry_a->callsite == entry_b->callsite;
+}
+
+static int64_t
+profile_next_interval(void)
+{
+    if (profile_interval <= 1) {
+        return (int64_t)profile_interval;
+    }
+    /* Uniform on [interval / 2, 3 * interval / 2) */
+    return (int64_t)(profile_interval / 2) +
+        (int64_t)g_random_int_range(0, (int32_t)MIN(profile_interval, G_MAXINT32));
+}
+
+void
+wmem_profile_sample(wmem_allocator_t *allocator, size_t size, const void *callsite)
+{
+    wmem_profile_entry_t  key, *entry;
+    uint64_t              bytes = 0, count;
+
+    if (profile_interval == 0) {
+        /* Not running, and exabytes allocated since it stopped */
+        wmem_profile_countdown = COUNTDOWN_STOPPED;
+        return;
+    }
+
+    g_mutex_lock(&profile_mutex);
+
+    /* The bytes counted down since the last sample, including any
+     * intervals this allocation skipped over entirely */
+    while (wmem_profile_countdown < 0) {
+        int64_t next = profile_next_interval();
+        bytes += (uint64_t)next;
+        wmem_profile_countdown += next;
+    }
+    bytes = MAX(bytes, size);
+    count = size ? MAX(bytes / size, 1) : 1;
+
+    key.scope    = allocator->name;
+    key.context  = profile_context ? *profile_context : NULL;
+    key.callsite = callsite;
+
+    entry = (wmem_profile_entry_t *)g_hash_table_lookup(profile_table, &key);
+    if (entry == NULL) {
+        entry = g_new(wmem_profile_entry_t, 1);
+        *entry = key;
+        entry->bytes = 0;
+        entry->count = 0;
+        g_hash_table_add(profile_table, entry);
+    }
+    entry->bytes  += bytes;
+    entry->count  += count;
+    profile_total += bytes;
+
+    g_mutex_unlock(&profile_mutex);
+}
+
+void
+wmem_profile_start(size_t interval)
+{
+    g_mutex_lock(&profile_mutex);
+    if (profile_table == NULL) {
+        profile_table = g_hash_table_new_full(profile_entry_hash, profile_entry_equal, g_free, NULL);
+    }
+    profile_interval = interval ? interval : WMEM_PROFILE_DEFAULT_INTERVAL;
+    wmem_profile_countdown = profile_next_interval();
+    g_mutex_unlock(&profile_mutex);
+}
+
+void
+wmem_profile_stop(void)
+{
+    g_mutex_lock(&profile_mutex);
+    profile_interval = 0;
+    wmem_profile_countdown = COUNTDOWN_STOPPED;
+    g_mutex_unlock(&profile_mutex);
+}
+
+bool
+wmem_profile_is_running(void)
+{
+    return profile_interval != 0;
+}
+
+void
+wmem_profile_reset(void)
+{
+    g_mutex_lock(&profile_mutex);
+    if (profile_table) {
+        g_hash_table_remove_all(profile_table);
+    }
+    profile_total = 0;
+    g_mutex_unlock(&profile_mutex);
+}
+
+void
+wmem_profile_set_context(const char * const *context)
+{
+    profile_context = context;
+}
+
+static int
+profile_compare_entries(gconstpointer a, gconstpointer b)
+{
+    const wmem_profile_entry_t *entry_a = (const wmem_profile_entry_t *)a;
+    const wmem_profile_entry_t *entry_b = (const wmem_profile_entry_t *)b;
+
+    if (entry_a->bytes != entry_b->bytes) {
+        return entry_a->bytes < entry_b->bytes ? 1 : -1;
+    }
+    return 0;
+}
+
+GArray *
+wmem_profile_get_entries(void)
+{
+    GArray         *entries = g_array_new(FALSE, FALSE, sizeof(wmem_profile_entry_t));
+    GHashTableIter  iter;
+    void           *entry;
+
+    g_mutex_lock(&profile_mutex);
+    if (profile_table) {
+        g_hash_table_iter_init(&iter, profile_table);
+        while (g_hash_table_iter_next(&iter, &entry, NULL)) {
+            g_array_append_vals(entries, entry, 1);
+        }
+    }
+    g_mutex_unlock(&profile_mutex);
+
+    g_array_sort(entries, profile_compare_entries);
+    return entries;
+}
+
+uint64_t
+wmem_profile_get_total(void)
+{
+    return profile_total;
+}
+
+char *
+wmem_profile_callsite_name(const void *callsite)
+{
+#ifdef HAVE_DLADDR
+    Dl_info info;
+
+    if (callsite && dladdr(callsite, &info)) {
+        if (info.dli_sname) {
+            return g_strdup_printf("%s+0x%tx", info.dli_sname,
+                    (const char *)callsite - (const char *)info.dli_saddr);
+        }
+        /* Static functions aren't in the dynamic symbol table, but the
+         * offset into the library can be given to addr2line */
+        if (info.dli_fname) {
+            return g_strdup_printf("%s+0x%tx", info.dli_fname,
+                    (const char *)callsite - (const char *)info.dli_fbase);
+        }
+    }
+#endif
+    return g_strdup_printf("%p", callsite);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
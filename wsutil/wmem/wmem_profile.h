@@ -0,0 +1,123 @@
+/** @file
+ * Definitions for the Wireshark Memory Manager allocation profiler
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WMEM_PROFILE_H__
+#define __WMEM_PROFILE_H__
+
+#include "wmem_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @addtogroup wmem
+ *  @{
+ *    @defgroup wmem-profile Allocation Profiler
+ *
+ *    A sampling profiler for allocations made from wmem scopes. When it is
+ *    running, on average one allocation per sample interval bytes is
+ *    recorded, and its weight is attributed to the scope it came from (see
+ *    wmem_allocator_set_name()), the context (in epan, the protocol being
+ *    dissected) and the function that called the wmem allocation function.
+ *    When it isn't running, each allocation costs a single subtraction.
+ *
+ *    @{
+ */
+
+/** The default mean number of bytes between samples. */
+#define WMEM_PROFILE_DEFAULT_INTERVAL (16 * 1024)
+
+/** The estimated allocations from one scope, context and callsite. */
+typedef struct _wmem_profile_entry_t {
+    const char *scope;      /**< name of the scope, or NULL if unnamed */
+    const char *context;    /**< context (e.g. protocol), or NULL if none */
+    const void *callsite;   /**< return address in the calling function */
+    uint64_t    bytes;      /**< estimated bytes allocated */
+    uint64_t    count;      /**< estimated number of allocations */
+} wmem_profile_entry_t;
+
+/** Start sampling allocations.
+ *
+ * @param interval The mean number of bytes between samples; 1 records
+ * every allocation, 0 uses WMEM_PROFILE_DEFAULT_INTERVAL.
+ */
+WS_DLL_PUBLIC
+void
+wmem_profile_start(size_t interval);
+
+/** Stop sampling allocations. The samples taken so far are kept. */
+WS_DLL_PUBLIC
+void
+wmem_profile_stop(void);
+
+WS_DLL_PUBLIC
+bool
+wmem_profile_is_running(void);
+
+/** Discard the samples taken so far. */
+WS_DLL_PUBLIC
+void
+wmem_profile_reset(void);
+
+/** Set the context that allocations are attributed to. The profiler
+ * reads *context whenever it takes a sample, so this can point at a
+ * variable that changes often (e.g. pinfo->current_proto) without any
+ * further calls. The string must outlive the samples, and the variable must
+ * stay valid until the context is set again (NULL for none).
+ */
+WS_DLL_PUBLIC
+void
+wmem_profile_set_context(const char * const *context);
+
+/** Get the estimated allocations for each scope, context and callsite,
+ * largest first.
+ *
+ * @return An array of wmem_profile_entry_t, to be freed with
+ * g_array_free(array, TRUE).
+ */
+WS_DLL_PUBLIC
+GArray *
+wmem_profile_get_entries(void);
+
+/** The estimated total number of bytes allocated while sampling. */
+WS_DLL_PUBLIC
+uint64_t
+wmem_profile_get_total(void);
+
+/** Describe a callsite, with its function name and offset if they can be
+ * found.
+ *
+ * @return A string to be freed with g_free().
+ */
+WS_DLL_PUBLIC
+char *
+wmem_profile_callsite_name(const void *callsite);
+
+/**   @}
+ *  @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_PROFILE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
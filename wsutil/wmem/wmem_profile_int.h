@@ -0,0 +1,62 @@
+/** @file
+ *
+ * Definitions for the Wireshark Memory Manager allocation profiler internals
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WMEM_PROFILE_INT_H__
+#define __WMEM_PROFILE_INT_H__
+
+#include "wmem_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Bytes left until the next sample; huge when the profiler isn't running */
+WS_DLL_LOCAL
+extern int64_t wmem_profile_countdown;
+
+WS_DLL_LOCAL
+void
+wmem_profile_sample(wmem_allocator_t *allocator, size_t size, const void *callsite);
+
+#if defined(__GNUC__)
+#define WMEM_PROFILE_CALLSITE() __builtin_extract_return_addr(__builtin_return_address(0))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define WMEM_PROFILE_CALLSITE() _ReturnAddress()
+#else
+#define WMEM_PROFILE_CALLSITE() NULL
+#endif
+
+/* Count an allocation of size bytes from allocator towards the next sample */
+#define WMEM_PROFILE_ALLOC(ALLOCATOR, SIZE) \
+    do { \
+        if (G_UNLIKELY((wmem_profile_countdown -= (int64_t)(SIZE)) < 0)) \
+            wmem_profile_sample((ALLOCATOR), (SIZE), WMEM_PROFILE_CALLSITE()); \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_PROFILE_INT_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
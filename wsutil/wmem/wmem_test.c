@@ -353,6 +353,86 @@ wmem_test_allocator_block_fast(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK, NULL);
 }
 
+static void
+wmem_test_allocator_block_fast_stats(void)
+{
+    wmem_allocator_t       *allocator;
+    wmem_allocator_stats_t  stats;
+    size_t                  retained;
+    int                     i, pass;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    if (allocator->type != WMEM_ALLOCATOR_BLOCK_FAST) {
+        /* overridden by WIRESHARK_DEBUG_WMEM_OVERRIDE */
+        wmem_destroy_allocator(allocator);
+        return;
+    }
+
+    /* enough for several blocks, twice, as if for two large packets */
+    retained = 0;
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < 128; i++) {
+            wmem_alloc(allocator, 64 * 1024);
+        }
+        wmem_get_stats(allocator, &stats);
+        g_assert_cmpuint(stats.in_use, >=, 128 * 64 * 1024);
+        g_assert_cmpuint(stats.retained, >=, stats.in_use);
+        if (pass == 1) {
+            /* the blocks of the first pass were reused */
+            g_assert_cmpuint(stats.retained, ==, retained);
+        }
+        retained = stats.retained;
+
+        wmem_free_all(allocator);
+        wmem_get_stats(allocator, &stats);
+        g_assert_cmpuint(stats.in_use, ==, 0);
+        g_assert_cmpuint(stats.peak, >=, 128 * 64 * 1024);
+        g_assert_cmpuint(stats.resets, ==, pass + 1);
+        g_assert_cmpuint(stats.retained, ==, retained);
+    }
+
+    /* gc gives back all but the first block */
+    wmem_gc(allocator);
+    wmem_get_stats(allocator, &stats);
+    g_assert_cmpuint(stats.retained, <, retained);
+
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_allocator_block_stats(void)
+{
+    wmem_allocator_t       *allocator;
+    wmem_allocator_stats_t  stats;
+    int                     i;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+    if (allocator->type != WMEM_ALLOCATOR_BLOCK) {
+        /* overridden by WIRESHARK_DEBUG_WMEM_OVERRIDE */
+        wmem_destroy_allocator(allocator);
+        return;
+    }
+
+    wmem_get_stats(allocator, &stats);
+    g_assert_cmpuint(stats.retained, ==, 0);
+
+    for (i = 0; i < 512; i++) {
+        wmem_alloc(allocator, 64 * 1024);
+    }
+    wmem_get_stats(allocator, &stats);
+    g_assert_cmpuint(stats.retained, >=, 512 * 64 * 1024);
+
+    /* the blocks are kept until they are collected */
+    wmem_free_all(allocator);
+    wmem_get_stats(allocator, &stats);
+    g_assert_cmpuint(stats.retained, >=, 512 * 64 * 1024);
+    wmem_gc(allocator);
+    wmem_get_stats(allocator, &stats);
+    g_assert_cmpuint(stats.retained, ==, 0);
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_simple(void)
 {
@@ -889,6 +969,34 @@ wmem_test_list(void)
         str1 = str2;
     }
     wmem_destroy_list(list);
+
+    list = wmem_list_new(NULL);
+    wmem_list_append_sorted(list, GINT_TO_POINTER(5), wmem_compare_int);
+    wmem_list_append_sorted(list, GINT_TO_POINTER(1), wmem_compare_int);
+    wmem_list_append_sorted(list, GINT_TO_POINTER(7), wmem_compare_int);
+    wmem_list_append_sorted(list, GINT_TO_POINTER(3), wmem_compare_int);
+    wmem_list_append_sorted(list, GINT_TO_POINTER(2), wmem_compare_int);
+    wmem_list_append_sorted(list, GINT_TO_POINTER(2), wmem_compare_int);
+    wmem_list_append_sorted(list, GINT_TO_POINTER(9), wmem_compare_int);
+    g_assert_true(wmem_list_count(list) == 7);
+    g_assert_true(GPOINTER_TO_INT(wmem_list_frame_data(wmem_list_head(list))) == 1);
+    g_assert_true(GPOINTER_TO_INT(wmem_list_frame_data(wmem_list_tail(list))) == 9);
+    frame = wmem_list_head(list);
+    int1 = GPOINTER_TO_INT(wmem_list_frame_data(frame));
+    while ((frame = wmem_list_frame_next(frame))) {
+        int2 = GPOINTER_TO_INT(wmem_list_frame_data(frame));
+        g_assert_true(int1 <= int2);
+        g_assert_true(wmem_list_frame_prev(frame) != NULL);
+        int1 = int2;
+    }
+    frame = wmem_list_tail(list);
+    int1 = GPOINTER_TO_INT(wmem_list_frame_data(frame));
+    while ((frame = wmem_list_frame_prev(frame))) {
+        int2 = GPOINTER_TO_INT(wmem_list_frame_data(frame));
+        g_assert_true(int1 >= int2);
+        int1 = int2;
+    }
+    wmem_destroy_list(list);
 }
 
 static void
@@ -904,7 +1012,7 @@ equal_val_map(void * key _U_, void * val, void * user_data)
 }
 
 static void
-wmem_test_map(void)
+wmem_test_map_type(wmem_map_type_t type)
 {
     wmem_allocator_t   *allocator, *extra_allocator;
     wmem_map_t       *map;
@@ -918,6 +1026,8 @@ wmem_test_map(void)
     allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
     extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
 
+    wmem_map_set_default_type(type);
+
     /* insertion, lookup and removal of simple integer keys */
     map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
     g_assert_true(map);
@@ -954,6 +1064,24 @@ wmem_test_map(void)
         ret = wmem_map_remove(map, GINT_TO_POINTER(i));
         g_assert_true(ret == NULL);
     }
+    g_assert_true(wmem_map_size(map) == 0);
+
+    /* reinsertion after removal, interleaved with more removals */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == NULL);
+        if (i % 3 == 0) {
+            g_assert_true(wmem_map_steal(map, GINT_TO_POINTER(i / 3)));
+        }
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_lookup(map, GINT_TO_POINTER(i));
+        if (i <= (CONTAINER_ITERS - 1) / 3) {
+            g_assert_true(ret == NULL);
+        } else {
+            g_assert_true(ret == GINT_TO_POINTER(i));
+        }
+    }
     wmem_free_all(allocator);
 
     /* test auto-reset functionality */
@@ -1015,10 +1143,34 @@ wmem_test_map(void)
     }
     g_assert_true(wmem_map_size(map) == CONTAINER_ITERS/2);
 
+    /* test changing the type of a new map */
+    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    wmem_map_set_type(map, type == WMEM_MAP_OPEN ? WMEM_MAP_CHAINED : WMEM_MAP_OPEN);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i)) == GINT_TO_POINTER(i));
+    }
+
+    wmem_map_set_default_type(WMEM_MAP_CHAINED);
+
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_map(void)
+{
+    wmem_test_map_type(WMEM_MAP_CHAINED);
+}
+
+static void
+wmem_test_map_open(void)
+{
+    wmem_test_map_type(WMEM_MAP_OPEN);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1340,6 +1492,91 @@ wmem_test_tree(void)
     wmem_destroy_allocator(allocator);
 }
 
+static bool
+wmem_test_tree_order_cb(const void *key, void *value _U_, void *user_data)
+{
+    uint32_t *prev = (uint32_t *)user_data;
+
+    g_assert_true(GPOINTER_TO_UINT(key) > *prev);
+    *prev = GPOINTER_TO_UINT(key);
+    return false;
+}
+
+static void
+wmem_test_tree_bplus(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_tree_t        *tree, *rb_tree;
+    wmem_tree_key_t     keys[2];
+    uint32_t            bulk_keys[CONTAINER_ITERS];
+    void               *bulk_values[CONTAINER_ITERS];
+    uint32_t            key32[2], prev;
+    unsigned            i;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* random keys, checked against a red/black tree */
+    tree = wmem_tree_new(allocator);
+    wmem_tree_set_type(tree, WMEM_TREE_BPLUS);
+    rb_tree = wmem_tree_new(allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        uint32_t rand_int = g_test_rand_int_range(1, 8*CONTAINER_ITERS);
+        wmem_tree_insert32(tree, rand_int, GINT_TO_POINTER(i + 1));
+        wmem_tree_insert32(rb_tree, rand_int, GINT_TO_POINTER(i + 1));
+    }
+    for (i=0; i<8*CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i) == wmem_tree_lookup32(rb_tree, i));
+        g_assert_true(wmem_tree_lookup32_le(tree, i) == wmem_tree_lookup32_le(rb_tree, i));
+        g_assert_true(wmem_tree_contains32(tree, i) == wmem_tree_contains32(rb_tree, i));
+    }
+    g_assert_true(wmem_tree_count(tree) == wmem_tree_count(rb_tree));
+    prev = 0;
+    wmem_tree_foreach(tree, wmem_test_tree_order_cb, &prev);
+    wmem_free_all(allocator);
+
+    /* bulk load of increasing keys */
+    tree = wmem_tree_new(allocator);
+    wmem_tree_set_type(tree, WMEM_TREE_BPLUS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        bulk_keys[i] = 2*i + 1;
+        bulk_values[i] = GINT_TO_POINTER(i + 1);
+    }
+    wmem_tree_insert32_bulk(tree, bulk_keys, bulk_values, CONTAINER_ITERS);
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+    g_assert_true(wmem_tree_lookup32_le(tree, 0) == NULL);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, 2*i + 1) == GINT_TO_POINTER(i + 1));
+        g_assert_true(wmem_tree_lookup32(tree, 2*i + 2) == NULL);
+        g_assert_true(wmem_tree_lookup32_le(tree, 2*i + 2) == GINT_TO_POINTER(i + 1));
+    }
+    g_assert_true(wmem_tree_remove32(tree, 1) == GINT_TO_POINTER(1));
+    g_assert_true(wmem_tree_lookup32(tree, 1) == NULL);
+    wmem_free_all(allocator);
+
+    /* array keys */
+    tree = wmem_tree_new(allocator);
+    wmem_tree_set_type(tree, WMEM_TREE_BPLUS);
+    keys[0].length = 2;
+    keys[0].key    = key32;
+    keys[1].length = 0;
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key32[0] = i % 10;
+        key32[1] = 2*i;
+        wmem_tree_insert32_array(tree, keys, GINT_TO_POINTER(i + 1));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key32[0] = i % 10;
+        key32[1] = 2*i;
+        g_assert_true(wmem_tree_lookup32_array(tree, keys) == GINT_TO_POINTER(i + 1));
+        key32[1] = 2*i + 1;
+        g_assert_true(wmem_tree_lookup32_array(tree, keys) == NULL);
+        g_assert_true(wmem_tree_lookup32_array_le(tree, keys) == GINT_TO_POINTER(i + 1));
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+
+    wmem_destroy_allocator(allocator);
+}
+
 
 /* to be used as userdata in the callback wmem_test_itree_check_overlap_cb*/
 typedef struct wmem_test_itree_user_data {
@@ -1438,6 +1675,18 @@ wmem_test_itree(void)
         g_assert_true(wmem_list_count(results) == userData.counter);
     }
 
+    /* Extending a range makes it visible to searches past its old end. */
+    tree = wmem_itree_new(allocator);
+    for (i=0; i<100; i++) {
+        wmem_itree_insert(tree, i * 10, i * 10 + 4, GINT_TO_POINTER(i));
+    }
+    g_assert_cmpuint(wmem_list_count(wmem_itree_find_intervals(tree, allocator, 506, 508)), ==, 0);
+    g_assert_true(wmem_itree_extend(tree, 500, 507));
+    g_assert_cmpuint(wmem_list_count(wmem_itree_find_intervals(tree, allocator, 506, 508)), ==, 1);
+    g_assert_true(!wmem_itree_extend(tree, 500, 502));
+    g_assert_true(!wmem_itree_extend(tree, 501, 510));
+    g_assert_cmpuint(wmem_list_count(wmem_itree_find_intervals(tree, allocator, 506, 508)), ==, 1);
+
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
@@ -1454,6 +1703,8 @@ main(int argc, char **argv)
 
     g_test_add_func("/wmem/allocator/block",     wmem_test_allocator_block);
     g_test_add_func("/wmem/allocator/blk_fast",  wmem_test_allocator_block_fast);
+    g_test_add_func("/wmem/allocator/blk_fast/stats", wmem_test_allocator_block_fast_stats);
+    g_test_add_func("/wmem/allocator/block/stats", wmem_test_allocator_block_stats);
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
@@ -1468,11 +1719,13 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
     g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_func("/wmem/datastruct/map/open", wmem_test_map_open);
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
     g_test_add_func("/wmem/datastruct/strbuf/validate", wmem_test_strbuf_validate);
     g_test_add_func("/wmem/datastruct/tree",   wmem_test_tree);
+    g_test_add_func("/wmem/datastruct/tree/bplus", wmem_test_tree_bplus);
     g_test_add_func("/wmem/datastruct/itree",  wmem_test_itree);
 
     ret = g_test_run();
@@ -49,6 +49,8 @@ struct _wmem_tree_t {
     wmem_allocator_t *metadata_allocator;
     wmem_allocator_t *data_allocator;
     wmem_tree_node_t *root;
+    wmem_tree_type_t  type;
+    struct _wmem_bplus_node_t *bplus_root; /* WMEM_TREE_BPLUS only */
     unsigned          metadata_scope_cb_id;
     unsigned          data_scope_cb_id;
 
@@ -212,6 +212,7 @@ wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     wmem_tree_t *tree = (wmem_tree_t *)user_data;
 
     tree->root = NULL;
+    tree->bplus_root = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
@@ -279,10 +280,19 @@ free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, bool free_ke
     wmem_free(allocator, node);
 }
 
+typedef struct _wmem_bplus_node_t wmem_bplus_node_t;
+
+static void
+bplus_free_node(wmem_allocator_t *allocator, wmem_bplus_node_t *node, bool free_keys,
+        bool free_values);
+
 void
 wmem_tree_destroy(wmem_tree_t *tree, bool free_keys, bool free_values)
 {
     free_tree_node(tree->data_allocator, tree->root, free_keys, free_values);
+    if (tree->bplus_root) {
+        bplus_free_node(tree->data_allocator, tree->bplus_root, free_keys, free_values);
+    }
     if (tree->metadata_allocator) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
     }
@@ -295,7 +305,17 @@ wmem_tree_destroy(wmem_tree_t *tree, bool free_keys, bool free_values)
 bool
 wmem_tree_is_empty(wmem_tree_t *tree)
 {
-    return tree->root == NULL;
+    return tree->root == NULL && tree->bplus_root == NULL;
+}
+
+void
+wmem_tree_set_type(wmem_tree_t *tree, wmem_tree_type_t type)
+{
+    if (!wmem_tree_is_empty(tree)) {
+        g_warning("wmem_tree_set_type called on a tree that has been used");
+        return;
+    }
+    tree->type = type;
 }
 
 static bool
@@ -343,6 +363,337 @@ create_node(wmem_allocator_t *allocator, wmem_tree_node_t *parent, const void *k
 
 #define CREATE_DATA(TRANSFORM, DATA) ((TRANSFORM) ? (TRANSFORM)(DATA) : (DATA))
 
+/*
+ * B+ trees
+ *
+ * Trees of type WMEM_TREE_BPLUS keep their uint32_t keys in nodes of up to
+ * BPLUS_ORDER keys each, so a lookup in a tree of millions of keys visits
+ * four or five nodes instead of following twenty-odd pointers. The values
+ * are only in the leaves, which are linked in key order for wmem_tree_foreach.
+ *
+ * Keys are never taken out (wmem_tree_remove32 only clears the value, as for
+ * the red/black trees), so the separator keys[i] of an inner node is always
+ * the smallest key under children[i + 1]. A leaf reached by a search thus
+ * holds the largest key that is <= the search key unless that key is smaller
+ * than every key in the tree, which is what makes lookup32_le a single
+ * descent. When a key is appended to the last leaf, as happens when the keys
+ * are frame numbers, full nodes are split by starting a new node rather than
+ * into two halves, so those trees end up (almost) completely packed.
+ */
+#define BPLUS_ORDER     32
+#define BPLUS_MAX_DEPTH 16
+
+struct _wmem_bplus_node_t {
+    unsigned  count;
+    bool      is_leaf;
+    uint32_t  keys[BPLUS_ORDER];
+};
+
+typedef struct _wmem_bplus_inner_t {
+    wmem_bplus_node_t  node;
+    wmem_bplus_node_t *children[BPLUS_ORDER + 1];
+} wmem_bplus_inner_t;
+
+typedef struct _wmem_bplus_leaf_t {
+    wmem_bplus_node_t          node;
+    void                      *values[BPLUS_ORDER];
+    bool                       is_subtree[BPLUS_ORDER];
+    struct _wmem_bplus_leaf_t *next;
+} wmem_bplus_leaf_t;
+
+/* Number of keys <= key */
+static inline unsigned
+bplus_upper_bound(const wmem_bplus_node_t *node, uint32_t key)
+{
+    unsigned lo = 0, hi = node->count, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (node->keys[mid] <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static wmem_bplus_leaf_t *
+bplus_find_leaf(const wmem_tree_t *tree, uint32_t key)
+{
+    wmem_bplus_node_t *node = tree->bplus_root;
+
+    while (node && !node->is_leaf) {
+        node = ((wmem_bplus_inner_t *)node)->children[bplus_upper_bound(node, key)];
+    }
+    return (wmem_bplus_leaf_t *)node;
+}
+
+static wmem_bplus_leaf_t *
+bplus_first_leaf(const wmem_tree_t *tree)
+{
+    wmem_bplus_node_t *node = tree->bplus_root;
+
+    while (node && !node->is_leaf) {
+        node = ((wmem_bplus_inner_t *)node)->children[0];
+    }
+    return (wmem_bplus_leaf_t *)node;
+}
+
+static wmem_bplus_leaf_t *
+bplus_new_leaf(wmem_tree_t *tree)
+{
+    wmem_bplus_leaf_t *leaf = wmem_new(tree->data_allocator, wmem_bplus_leaf_t);
+
+    leaf->node.count   = 0;
+    leaf->node.is_leaf = true;
+    leaf->next         = NULL;
+    return leaf;
+}
+
+static void
+bplus_leaf_insert_at(wmem_bplus_leaf_t *leaf, unsigned i, uint32_t key,
+        void *value, bool is_subtree)
+{
+    unsigned n = leaf->node.count - i;
+
+    memmove(&leaf->node.keys[i + 1], &leaf->node.keys[i], n * sizeof(uint32_t));
+    memmove(&leaf->values[i + 1], &leaf->values[i], n * sizeof(void *));
+    memmove(&leaf->is_subtree[i + 1], &leaf->is_subtree[i], n * sizeof(bool));
+    leaf->node.keys[i]   = key;
+    leaf->values[i]      = value;
+    leaf->is_subtree[i]  = is_subtree;
+    leaf->node.count++;
+}
+
+/* Add key and child, which was split off path[depth - 1]->children[slots[depth - 1]],
+ * to the ancestors of the split node, splitting them in turn as needed. */
+static void
+bplus_insert_parent(wmem_tree_t *tree, wmem_bplus_inner_t **path, unsigned *slots,
+        unsigned depth, uint32_t key, wmem_bplus_node_t *child, bool append)
+{
+    uint32_t            keys[BPLUS_ORDER + 1];
+    wmem_bplus_node_t  *children[BPLUS_ORDER + 2];
+    wmem_bplus_inner_t *inner, *right;
+    unsigned            i, n, mid;
+
+    while (depth > 0) {
+        depth--;
+        inner = path[depth];
+        i     = slots[depth];
+        n     = inner->node.count;
+
+        if (n < BPLUS_ORDER) {
+            memmove(&inner->node.keys[i + 1], &inner->node.keys[i], (n - i) * sizeof(uint32_t));
+            memmove(&inner->children[i + 2], &inner->children[i + 1], (n - i) * sizeof(wmem_bplus_node_t *));
+            inner->node.keys[i]   = key;
+            inner->children[i + 1] = child;
+            inner->node.count++;
+            return;
+        }
+
+        /* Full: lay out all the keys and children, then divide them up */
+        memcpy(keys, inner->node.keys, i * sizeof(uint32_t));
+        keys[i] = key;
+        memcpy(&keys[i + 1], &inner->node.keys[i], (n - i) * sizeof(uint32_t));
+        memcpy(children, inner->children, (i + 1) * sizeof(wmem_bplus_node_t *));
+        children[i + 1] = child;
+        memcpy(&children[i + 2], &inner->children[i + 1], (n - i) * sizeof(wmem_bplus_node_t *));
+
+        mid = append ? BPLUS_ORDER : BPLUS_ORDER / 2;
+
+        right = wmem_new(tree->data_allocator, wmem_bplus_inner_t);
+        right->node.is_leaf = false;
+        right->node.count   = BPLUS_ORDER - mid;
+        memcpy(right->node.keys, &keys[mid + 1], right->node.count * sizeof(uint32_t));
+        memcpy(right->children, &children[mid + 1], (right->node.count + 1) * sizeof(wmem_bplus_node_t *));
+
+        inner->node.count = mid;
+        memcpy(inner->node.keys, keys, mid * sizeof(uint32_t));
+        memcpy(inner->children, children, (mid + 1) * sizeof(wmem_bplus_node_t *));
+
+        key   = keys[mid];
+        child = &right->node;
+    }
+
+    /* The root was split */
+    inner = wmem_new(tree->data_allocator, wmem_bplus_inner_t);
+    inner->node.is_leaf  = false;
+    inner->node.count    = 1;
+    inner->node.keys[0]  = key;
+    inner->children[0]   = tree->bplus_root;
+    inner->children[1]   = child;
+    tree->bplus_root = &inner->node;
+}
+
+static void *
+bplus_lookup_or_insert32(wmem_tree_t *tree, uint32_t key,
+        void*(*func)(void*), void* data, bool is_subtree, bool replace)
+{
+    wmem_bplus_inner_t *path[BPLUS_MAX_DEPTH];
+    unsigned            slots[BPLUS_MAX_DEPTH];
+    unsigned            depth = 0, i, split;
+    wmem_bplus_node_t  *node;
+    wmem_bplus_leaf_t  *leaf, *right;
+    void               *value;
+    bool                append;
+
+    if (tree->bplus_root == NULL) {
+        tree->bplus_root = &bplus_new_leaf(tree)->node;
+    }
+
+    node = tree->bplus_root;
+    while (!node->is_leaf) {
+        ws_assert(depth < BPLUS_MAX_DEPTH);
+        i = bplus_upper_bound(node, key);
+        path[depth]  = (wmem_bplus_inner_t *)node;
+        slots[depth] = i;
+        depth++;
+        node = ((wmem_bplus_inner_t *)node)->children[i];
+    }
+    leaf = (wmem_bplus_leaf_t *)node;
+
+    i = bplus_upper_bound(node, key);
+    if (i > 0 && node->keys[i - 1] == key) {
+        if (replace) {
+            leaf->values[i - 1] = CREATE_DATA(func, data);
+        }
+        return leaf->values[i - 1];
+    }
+
+    value = CREATE_DATA(func, data);
+
+    if (node->count < BPLUS_ORDER) {
+        bplus_leaf_insert_at(leaf, i, key, value, is_subtree);
+        return value;
+    }
+
+    append = (leaf->next == NULL && i == BPLUS_ORDER);
+    split  = append ? BPLUS_ORDER : BPLUS_ORDER / 2;
+
+    right = bplus_new_leaf(tree);
+    right->node.count = BPLUS_ORDER - split;
+    memcpy(right->node.keys, &node->keys[split], right->node.count * sizeof(uint32_t));
+    memcpy(right->values, &leaf->values[split], right->node.count * sizeof(void *));
+    memcpy(right->is_subtree, &leaf->is_subtree[split], right->node.count * sizeof(bool));
+    node->count = split;
+    right->next = leaf->next;
+    leaf->next  = right;
+
+    if (i < split) {
+        bplus_leaf_insert_at(leaf, i, key, value, is_subtree);
+    } else {
+        bplus_leaf_insert_at(right, i - split, key, value, is_subtree);
+    }
+
+    bplus_insert_parent(tree, path, slots, depth, right->node.keys[0], &right->node, append);
+
+    return value;
+}
+
+static void **
+bplus_lookup32(const wmem_tree_t *tree, uint32_t key)
+{
+    wmem_bplus_leaf_t *leaf = bplus_find_leaf(tree, key);
+    unsigned           i;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    i = bplus_upper_bound(&leaf->node, key);
+    if (i > 0 && leaf->node.keys[i - 1] == key) {
+        return &leaf->values[i - 1];
+    }
+    return NULL;
+}
+
+static void *
+bplus_lookup32_le(const wmem_tree_t *tree, uint32_t key)
+{
+    wmem_bplus_leaf_t *leaf = bplus_find_leaf(tree, key);
+    unsigned           i;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    /* Only zero in the first leaf, see above */
+    i = bplus_upper_bound(&leaf->node, key);
+    return i > 0 ? leaf->values[i - 1] : NULL;
+}
+
+static bool
+bplus_foreach(wmem_tree_t *tree, wmem_foreach_func callback, void *user_data)
+{
+    wmem_bplus_leaf_t *leaf;
+    unsigned           i;
+
+    for (leaf = bplus_first_leaf(tree); leaf; leaf = leaf->next) {
+        for (i = 0; i < leaf->node.count; i++) {
+            if (leaf->is_subtree[i]) {
+                if (wmem_tree_foreach((wmem_tree_t *)leaf->values[i], callback, user_data)) {
+                    return true;
+                }
+            } else if (callback(GUINT_TO_POINTER(leaf->node.keys[i]), leaf->values[i], user_data)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void
+bplus_free_node(wmem_allocator_t *allocator, wmem_bplus_node_t *node, bool free_keys,
+        bool free_values)
+{
+    wmem_bplus_leaf_t *leaf;
+    unsigned           i;
+
+    if (!node->is_leaf) {
+        for (i = 0; i <= node->count; i++) {
+            bplus_free_node(allocator, ((wmem_bplus_inner_t *)node)->children[i], free_keys, free_values);
+        }
+    } else {
+        /* The keys are integers, so free_keys only matters to subtrees */
+        leaf = (wmem_bplus_leaf_t *)node;
+        for (i = 0; i < node->count; i++) {
+            if (leaf->is_subtree[i]) {
+                wmem_tree_destroy((wmem_tree_t *)leaf->values[i], free_keys, free_values);
+            } else if (free_values) {
+                wmem_free(allocator, leaf->values[i]);
+            }
+        }
+    }
+    wmem_free(allocator, node);
+}
+
+void
+wmem_tree_insert32_bulk(wmem_tree_t *tree, const uint32_t *keys, void * const *values,
+        unsigned count)
+{
+    wmem_bplus_leaf_t *leaf = NULL;
+    unsigned           i;
+
+    for (i = 0; i < count; i++) {
+        /* Appending to the last leaf while it has room needs no search */
+        if (leaf && leaf->node.count < BPLUS_ORDER &&
+                keys[i] > leaf->node.keys[leaf->node.count - 1]) {
+            bplus_leaf_insert_at(leaf, leaf->node.count, keys[i], values[i], false);
+            continue;
+        }
+
+        wmem_tree_insert32(tree, keys[i], values[i]);
+
+        if (tree->type == WMEM_TREE_BPLUS) {
+            leaf = bplus_find_leaf(tree, keys[i]);
+            if (leaf->next != NULL) {
+                leaf = NULL;
+            }
+        }
+    }
+}
+
 
 /**
  * return inserted node
@@ -410,7 +761,13 @@ static void *
 lookup_or_insert32(wmem_tree_t *tree, uint32_t key,
         void*(*func)(void*), void* data, bool is_subtree, bool replace)
 {
-    wmem_tree_node_t *node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
+    wmem_tree_node_t *node;
+
+    if (tree->type == WMEM_TREE_BPLUS) {
+        return bplus_lookup_or_insert32(tree, key, func, data, is_subtree, replace);
+    }
+
+    node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
     return node->data;
 }
 
@@ -505,6 +862,10 @@ bool wmem_tree_contains32(wmem_tree_t *tree, uint32_t key)
         return false;
     }
 
+    if (tree->type == WMEM_TREE_BPLUS) {
+        return bplus_lookup32(tree, key) != NULL;
+    }
+
     wmem_tree_node_t *node = tree->root;
 
     while (node) {
@@ -525,10 +886,17 @@ bool wmem_tree_contains32(wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32(wmem_tree_t *tree, uint32_t key)
 {
+    void **value;
+
     if (!tree) {
         return NULL;
     }
 
+    if (tree->type == WMEM_TREE_BPLUS) {
+        value = bplus_lookup32(tree, key);
+        return value ? *value : NULL;
+    }
+
     wmem_tree_node_t *node = tree->root;
 
     while (node) {
@@ -553,6 +921,10 @@ wmem_tree_lookup32_le(wmem_tree_t *tree, uint32_t key)
         return NULL;
     }
 
+    if (tree->type == WMEM_TREE_BPLUS) {
+        return bplus_lookup32_le(tree, key);
+    }
+
     wmem_tree_node_t *node = tree->root;
 
     while (node) {
@@ -629,6 +1001,9 @@ wmem_tree_insert_string(wmem_tree_t* tree, const char* k, void* v, uint32_t flag
     char *key;
     compare_func cmp;
 
+    /* B+ trees only have integer keys */
+    ws_assert(tree->type == WMEM_TREE_RED_BLACK);
+
     key = wmem_strdup(tree->data_allocator, k);
 
     if (flags & WMEM_TREE_STRING_NOCASE) {
@@ -668,7 +1043,10 @@ wmem_tree_remove_string(wmem_tree_t* tree, const char* k, uint32_t flags)
 static void *
 create_sub_tree(void* d)
 {
-    return wmem_tree_new(((wmem_tree_t *)d)->data_allocator);
+    wmem_tree_t *sub_tree = wmem_tree_new(((wmem_tree_t *)d)->data_allocator);
+
+    sub_tree->type = ((wmem_tree_t *)d)->type;
+    return sub_tree;
 }
 
 void
@@ -784,6 +1162,9 @@ bool
 wmem_tree_foreach(wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data)
 {
+    if (tree->bplus_root && bplus_foreach(tree, callback, user_data))
+        return true;
+
     if(!tree->root)
         return false;
 
@@ -836,6 +1217,36 @@ wmem_tree_print_nodes(const char *prefix, wmem_tree_node_t *node, uint32_t level
 }
 
 
+static void
+wmem_bplus_print_leaves(wmem_tree_t *tree, uint32_t level,
+    wmem_printer_func key_printer, wmem_printer_func data_printer)
+{
+    wmem_bplus_leaf_t *leaf;
+    unsigned i;
+
+    for (leaf = bplus_first_leaf(tree); leaf; leaf = leaf->next) {
+        wmem_print_indent(level);
+        printf("LEAF:%p count:%u next:%p\n", (void *)leaf, leaf->node.count, (void *)leaf->next);
+        for (i = 0; i < leaf->node.count; i++) {
+            wmem_print_indent(level + 1);
+            printf("key:%u %s:%p\n", leaf->node.keys[i],
+                    leaf->is_subtree[i]?"tree":"data", leaf->values[i]);
+            if (key_printer) {
+                wmem_print_indent(level + 1);
+                key_printer(GUINT_TO_POINTER(leaf->node.keys[i]));
+                printf("\n");
+            }
+            if (data_printer && !leaf->is_subtree[i]) {
+                wmem_print_indent(level + 1);
+                data_printer(leaf->values[i]);
+                printf("\n");
+            }
+            if (leaf->is_subtree[i])
+                wmem_print_subtree((wmem_tree_t *)leaf->values[i], level+2, key_printer, data_printer);
+        }
+    }
+}
+
 static void
 wmem_print_subtree(wmem_tree_t *tree, uint32_t level, wmem_printer_func key_printer, wmem_printer_func data_printer)
 {
@@ -848,6 +1259,9 @@ wmem_print_subtree(wmem_tree_t *tree, uint32_t level, wmem_printer_func key_prin
     if (tree->root) {
         wmem_tree_print_nodes("Root-", tree->root, level, key_printer, data_printer);
     }
+    if (tree->bplus_root) {
+        wmem_bplus_print_leaves(tree, level, key_printer, data_printer);
+    }
 }
 
 void
@@ -36,6 +36,13 @@ extern "C" {
 struct _wmem_tree_t;
 typedef struct _wmem_tree_t wmem_tree_t;
 
+/** The ways a tree can store its items. */
+typedef enum _wmem_tree_type_t {
+    WMEM_TREE_RED_BLACK,    /**< One node per key; any kind of key */
+    WMEM_TREE_BPLUS         /**< Many keys per node; uint32_t and
+                                 uint32_t array keys only */
+} wmem_tree_type_t;
+
 /** Creates a tree with the given allocator scope. When the scope is emptied,
  * the tree is fully destroyed. */
 WS_DLL_PUBLIC
@@ -75,6 +82,17 @@ WS_DLL_PUBLIC
 unsigned
 wmem_tree_count(wmem_tree_t* tree);
 
+/** Changes the way a tree stores its items. Trees are red/black trees
+ * unless this is called before anything is inserted. B+ trees hold many
+ * keys per node, so lookups in large trees (such as those indexed by frame
+ * number) take far fewer cache misses; they can't be used with string keys.
+ * Subtrees created by wmem_tree_insert32_array() have the same type as the
+ * tree itself.
+ */
+WS_DLL_PUBLIC
+void
+wmem_tree_set_type(wmem_tree_t *tree, wmem_tree_type_t type);
+
 /** Insert a node indexed by a uint32_t key value.
  *
  * Data is a pointer to the structure you want to be able to retrieve by
@@ -90,6 +108,16 @@ WS_DLL_PUBLIC
 void
 wmem_tree_insert32(wmem_tree_t *tree, uint32_t key, void *data);
 
+/** Insert count values indexed by uint32_t keys, as if by calling
+ * wmem_tree_insert32() for each of them. If the keys are in increasing
+ * order and larger than any key already in a B+ tree, the values are
+ * appended to the tree's leaves without searching it.
+ */
+WS_DLL_PUBLIC
+void
+wmem_tree_insert32_bulk(wmem_tree_t *tree, const uint32_t *keys, void * const *values,
+        unsigned count);
+
 /** Look up a node in the tree indexed by a uint32_t integer value. Return true
  * if present.
  */
@@ -37,6 +37,15 @@ ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const char *needles)
         n++;
     }
 
+    pattern->num_needles = 0;
+    if (n - needles <= WS_MEMPBRK_VEC_MAX_NEEDLES) {
+        for (n = needles; *n; n++)
+            pattern->needles[pattern->num_needles++] = (uint8_t)*n;
+    }
+
+#ifdef HAVE_AVX2
+    ws_mempbrk_avx2_compile(pattern);
+#endif
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
@@ -64,10 +73,18 @@ ws_mempbrk_portable_exec(const uint8_t* haystack, size_t haystacklen, const ws_m
 WS_DLL_PUBLIC const uint8_t *
 ws_mempbrk_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
 {
+#ifdef HAVE_AVX2
+    if (haystacklen >= 32 && pattern->use_avx2)
+        return ws_mempbrk_avx2_exec(haystack, haystacklen, pattern, found_needle);
+#endif
 #ifdef HAVE_SSE4_2
     if (haystacklen >= 16 && pattern->use_sse42)
         return ws_mempbrk_sse42_exec(haystack, haystacklen, pattern, found_needle);
 #endif
+#ifdef WS_MEMPBRK_NEON
+    if (haystacklen >= 16 && pattern->num_needles)
+        return ws_mempbrk_neon_exec(haystack, haystacklen, pattern, found_needle);
+#endif
 
     return ws_mempbrk_portable_exec(haystack, haystacklen, pattern, found_needle);
 }
@@ -18,8 +18,23 @@
 
 /** The pattern object used for ws_mempbrk_exec().
  */
+/*
+ * Patterns with at most this many needles can also be searched by
+ * comparing whole vectors against each needle (AVX2 and NEON).
+ */
+#define WS_MEMPBRK_VEC_MAX_NEEDLES 8
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define WS_MEMPBRK_NEON 1
+#endif
+
 typedef struct {
     char patt[256];
+    uint8_t needles[WS_MEMPBRK_VEC_MAX_NEEDLES];
+    uint8_t num_needles;    /* 0 if there are too many for the vector kernels */
+#ifdef HAVE_AVX2
+    bool use_avx2;
+#endif
 #ifdef HAVE_SSE4_2
     bool use_sse42;
     __m128i mask;
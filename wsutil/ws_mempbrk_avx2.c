@@ -0,0 +1,85 @@
+/* ws_mempbrk_avx2.c
+ * mempbrk with AVX2 intrinsics, for patterns with only a few needles
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <immintrin.h>
+
+#include "ws_cpuid.h"
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+#include "bits_ctz.h"
+
+void
+ws_mempbrk_avx2_compile(ws_mempbrk_pattern* pattern)
+{
+    pattern->use_avx2 = pattern->num_needles > 0 && ws_cpuid_avx2();
+}
+
+/*
+ * Unlike pcmpistri, comparing against each needle in turn doesn't stop
+ * at a NUL byte, so binary data doesn't fall back to the portable loop.
+ */
+static inline uint32_t
+ws_mempbrk_avx2_match(const uint8_t *p, const __m256i *needles, unsigned num_needles)
+{
+    __m256i value = _mm256_loadu_si256((const __m256i *) (const void *) p);
+    __m256i match = _mm256_cmpeq_epi8(value, needles[0]);
+    unsigned i;
+
+    for (i = 1; i < num_needles; i++)
+        match = _mm256_or_si256(match, _mm256_cmpeq_epi8(value, needles[i]));
+
+    return (uint32_t) _mm256_movemask_epi8(match);
+}
+
+/* haystacklen must be at least 32 */
+const uint8_t *
+ws_mempbrk_avx2_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
+{
+    const uint8_t *haystack_end = haystack + haystacklen;
+    __m256i needles[WS_MEMPBRK_VEC_MAX_NEEDLES];
+    unsigned num_needles = pattern->num_needles;
+    uint32_t mask;
+    unsigned i;
+
+    for (i = 0; i < num_needles; i++)
+        needles[i] = _mm256_set1_epi8((char) pattern->needles[i]);
+
+    while (haystack_end - haystack >= 32) {
+        mask = ws_mempbrk_avx2_match(haystack, needles, num_needles);
+        if (mask)
+            goto found;
+        haystack += 32;
+    }
+
+    if (haystack == haystack_end)
+        return NULL;
+
+    /*
+     * Scan the last 32 bytes; the ones before haystack have already
+     * been checked and didn't match, so the first match is still the
+     * lowest set bit.
+     */
+    haystack = haystack_end - 32;
+    mask = ws_mempbrk_avx2_match(haystack, needles, num_needles);
+    if (!mask)
+        return NULL;
+
+found:
+    haystack += ws_ctz(mask);
+    if (found_needle)
+        *found_needle = *haystack;
+    return haystack;
+}
+
+#endif /* HAVE_AVX2 */
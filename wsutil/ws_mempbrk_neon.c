@@ -0,0 +1,76 @@
+/* ws_mempbrk_neon.c
+ * mempbrk with NEON intrinsics, for patterns with only a few needles
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "ws_mempbrk.h"
+
+#ifdef WS_MEMPBRK_NEON
+
+#include <arm_neon.h>
+
+#include "ws_mempbrk_int.h"
+#include "bits_ctz.h"
+
+/*
+ * NEON is part of the base AArch64 architecture, so there is nothing to
+ * check at run time.  The result is a 64-bit mask with 4 bits per byte,
+ * made by narrowing the comparison result, as there is no movemask.
+ */
+static inline uint64_t
+ws_mempbrk_neon_match(const uint8_t *p, const uint8x16_t *needles, unsigned num_needles)
+{
+    uint8x16_t value = vld1q_u8(p);
+    uint8x16_t match = vceqq_u8(value, needles[0]);
+    unsigned i;
+
+    for (i = 1; i < num_needles; i++)
+        match = vorrq_u8(match, vceqq_u8(value, needles[i]));
+
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+}
+
+/* haystacklen must be at least 16 */
+const uint8_t *
+ws_mempbrk_neon_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
+{
+    const uint8_t *haystack_end = haystack + haystacklen;
+    uint8x16_t needles[WS_MEMPBRK_VEC_MAX_NEEDLES];
+    unsigned num_needles = pattern->num_needles;
+    uint64_t mask;
+    unsigned i;
+
+    for (i = 0; i < num_needles; i++)
+        needles[i] = vdupq_n_u8(pattern->needles[i]);
+
+    while (haystack_end - haystack >= 16) {
+        mask = ws_mempbrk_neon_match(haystack, needles, num_needles);
+        if (mask)
+            goto found;
+        haystack += 16;
+    }
+
+    if (haystack == haystack_end)
+        return NULL;
+
+    /* As in ws_mempbrk_avx2_exec(), rescan the tail with an overlapping load. */
+    haystack = haystack_end - 16;
+    mask = ws_mempbrk_neon_match(haystack, needles, num_needles);
+    if (!mask)
+        return NULL;
+
+found:
+    haystack += ws_ctz(mask) >> 2;
+    if (found_needle)
+        *found_needle = *haystack;
+    return haystack;
+}
+
+#endif /* WS_MEMPBRK_NEON */
@@ -0,0 +1,230 @@
+/* ws_trace.c
+ * Tracing of the time spent in individual operations, written out in the
+ * Chrome trace event format.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_MAIN
+
+#include "ws_trace.h"
+
+#include <errno.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/strtoi.h>
+
+typedef struct {
+    const char *category;
+    const char *name;
+    int64_t     start;      /* g_get_monotonic_time() */
+    int64_t     duration;   /* microseconds */
+    unsigned    tid;
+} ws_trace_span_t;
+
+static bool            trace_enabled;
+static char           *trace_path;
+static ws_trace_span_t *trace_spans;
+static size_t          trace_max_spans;
+static int64_t         trace_min_duration;
+static int64_t         trace_epoch;
+/* Number of spans added so far; the ring slot is this modulo the size. */
+static volatile gint   trace_next;
+static volatile gint   trace_next_tid;
+
+static GPrivate trace_tid_key;
+
+void
+ws_trace_init(const char *path, size_t max_spans, int64_t min_duration)
+{
+    if (trace_enabled || max_spans == 0 || max_spans > G_MAXINT / 2) {
+        return;
+    }
+
+    trace_path = g_strdup(path);
+    trace_spans = g_new0(ws_trace_span_t, max_spans);
+    trace_max_spans = max_spans;
+    trace_min_duration = min_duration;
+    trace_epoch = g_get_monotonic_time();
+    trace_next = 0;
+    trace_enabled = true;
+}
+
+void
+ws_trace_init_from_env(void)
+{
+    const char *path = g_getenv("WIRESHARK_TRACE_FILE");
+    const char *s;
+    uint32_t max_spans = WS_TRACE_DEFAULT_MAX_SPANS;
+    int64_t min_duration = 0;
+
+    if (path == NULL || *path == '\0') {
+        return;
+    }
+    if ((s = g_getenv("WIRESHARK_TRACE_MAX_SPANS")) != NULL) {
+        if (!ws_strtou32(s, NULL, &max_spans) || max_spans == 0) {
+            ws_warning("Invalid WIRESHARK_TRACE_MAX_SPANS \"%s\"", s);
+            max_spans = WS_TRACE_DEFAULT_MAX_SPANS;
+        }
+    }
+    if ((s = g_getenv("WIRESHARK_TRACE_MIN_DURATION")) != NULL) {
+        if (!ws_strtoi64(s, NULL, &min_duration) || min_duration < 0) {
+            ws_warning("Invalid WIRESHARK_TRACE_MIN_DURATION \"%s\"", s);
+            min_duration = 0;
+        }
+    }
+    ws_trace_init(path, max_spans, min_duration);
+}
+
+bool
+ws_trace_enabled(void)
+{
+    return trace_enabled;
+}
+
+int64_t
+ws_trace_begin(void)
+{
+    return trace_enabled ? g_get_monotonic_time() : 0;
+}
+
+void
+ws_trace_end(const char *category, const char *name, int64_t start)
+{
+    if (start == 0 || !trace_enabled) {
+        return;
+    }
+    ws_trace_add(category, name, start, g_get_monotonic_time() - start);
+}
+
+/* Small per-thread IDs, so that the spans of each thread nest. */
+static unsigned
+trace_tid(void)
+{
+    unsigned tid = GPOINTER_TO_UINT(g_private_get(&trace_tid_key));
+
+    if (tid == 0) {
+        tid = (unsigned)g_atomic_int_add(&trace_next_tid, 1) + 1;
+        g_private_set(&trace_tid_key, GUINT_TO_POINTER(tid));
+    }
+    return tid;
+}
+
+void
+ws_trace_add(const char *category, const char *name, int64_t start, int64_t duration)
+{
+    ws_trace_span_t *span;
+    unsigned n;
+
+    if (!trace_enabled || duration < trace_min_duration) {
+        return;
+    }
+
+    n = (unsigned)g_atomic_int_add(&trace_next, 1);
+    span = &trace_spans[n % trace_max_spans];
+    span->category = category;
+    span->name = name;
+    span->start = start;
+    span->duration = duration;
+    span->tid = trace_tid();
+}
+
+bool
+ws_trace_write(FILE *fp)
+{
+    json_dumper dumper = {
+        .output_file = fp,
+    };
+    unsigned added, count, first, i;
+    int pid = ws_getpid();
+
+    if (!trace_enabled) {
+        return false;
+    }
+
+    added = (unsigned)g_atomic_int_get(&trace_next);
+    count = MIN(added, (unsigned)trace_max_spans);
+    first = added - count;
+
+    json_dumper_begin_object(&dumper);
+    json_dumper_set_member_name(&dumper, "traceEvents");
+    json_dumper_begin_array(&dumper);
+    for (i = 0; i < count; i++) {
+        const ws_trace_span_t *span = &trace_spans[(first + i) % trace_max_spans];
+
+        json_dumper_begin_object(&dumper);
+        json_dumper_set_member_name(&dumper, "name");
+        json_dumper_value_string(&dumper, span->name);
+        json_dumper_set_member_name(&dumper, "cat");
+        json_dumper_value_string(&dumper, span->category);
+        json_dumper_set_member_name(&dumper, "ph");
+        json_dumper_value_string(&dumper, "X");
+        json_dumper_set_member_name(&dumper, "ts");
+        json_dumper_value_anyf(&dumper, "%" PRId64, span->start - trace_epoch);
+        json_dumper_set_member_name(&dumper, "dur");
+        json_dumper_value_anyf(&dumper, "%" PRId64, span->duration);
+        json_dumper_set_member_name(&dumper, "pid");
+        json_dumper_value_anyf(&dumper, "%d", pid);
+        json_dumper_set_member_name(&dumper, "tid");
+        json_dumper_value_anyf(&dumper, "%u", span->tid);
+        json_dumper_end_object(&dumper);
+    }
+    json_dumper_end_array(&dumper);
+    json_dumper_set_member_name(&dumper, "otherData");
+    json_dumper_begin_object(&dumper);
+    json_dumper_set_member_name(&dumper, "spans_dropped");
+    json_dumper_value_anyf(&dumper, "%u", first);
+    json_dumper_end_object(&dumper);
+    json_dumper_end_object(&dumper);
+    fputc('\n', fp);
+
+    return json_dumper_finish(&dumper) && !ferror(fp);
+}
+
+void
+ws_trace_finish(void)
+{
+    FILE *fp;
+
+    if (!trace_enabled) {
+        return;
+    }
+
+    if (trace_path != NULL) {
+        fp = ws_fopen(trace_path, "w");
+        if (fp == NULL) {
+            ws_warning("Can't write trace to \"%s\": %s", trace_path, g_strerror(errno));
+        } else {
+            if (!ws_trace_write(fp)) {
+                ws_warning("Error writing trace to \"%s\"", trace_path);
+            }
+            fclose(fp);
+        }
+    }
+
+    trace_enabled = false;
+    g_free(trace_path);
+    trace_path = NULL;
+    g_free(trace_spans);
+    trace_spans = NULL;
+    trace_max_spans = 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,75 @@
+/** @file
+ * Tracing of the time spent in individual operations (reading a file,
+ * filtering it, dissecting a packet, ...), written out in the Chrome
+ * trace event format that Perfetto and chrome://tracing read.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_WS_TRACE_H__
+#define __WSUTIL_WS_TRACE_H__
+
+#include <stdio.h>
+
+#include <wireshark.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Spans are kept in a ring buffer, so a long run keeps only the most
+ * recent ones, and spans shorter than a minimum duration aren't kept at
+ * all. Both bound the cost of tracing. Span names and categories are
+ * not copied, so they must stay valid until the trace is written.
+ */
+
+#define WS_TRACE_DEFAULT_MAX_SPANS (256 * 1024)
+
+/** Start tracing, keeping up to max_spans of the spans that take at least
+ * min_duration microseconds. If path isn't NULL, ws_trace_finish()
+ * writes the trace to it. */
+WS_DLL_PUBLIC
+void ws_trace_init(const char *path, size_t max_spans, int64_t min_duration);
+
+/** Start tracing if the WIRESHARK_TRACE_FILE environment variable is set,
+ * using WIRESHARK_TRACE_MAX_SPANS and WIRESHARK_TRACE_MIN_DURATION if
+ * they're set. */
+WS_DLL_PUBLIC
+void ws_trace_init_from_env(void);
+
+WS_DLL_PUBLIC
+bool ws_trace_enabled(void);
+
+/** Start a span: returns the current time, or 0 if tracing is off. */
+WS_DLL_PUBLIC
+int64_t ws_trace_begin(void);
+
+/** End a span started with ws_trace_begin(). Does nothing if start is 0. */
+WS_DLL_PUBLIC
+void ws_trace_end(const char *category, const char *name, int64_t start);
+
+/** Add a span that started at start (in g_get_monotonic_time() units)
+ * and lasted duration microseconds. */
+WS_DLL_PUBLIC
+void ws_trace_add(const char *category, const char *name, int64_t start, int64_t duration);
+
+/** Write the spans kept so far, oldest first, as a Chrome trace event
+ * JSON document. */
+WS_DLL_PUBLIC
+bool ws_trace_write(FILE *fp);
+
+/** Write the trace to the file given to ws_trace_init(), if any, and stop
+ * tracing. */
+WS_DLL_PUBLIC
+void ws_trace_finish(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WSUTIL_WS_TRACE_H__ */
@@ -26,10 +26,9 @@ bool
 json_validate(const uint8_t *buf, const size_t len)
 {
     bool ret = true;
-    /* We expect no more than 1024 tokens */
+    /* Most documents need no more than 1024 tokens; larger ones get more */
     unsigned max_tokens = 1024;
     jsmntok_t* t;
-    jsmn_parser p;
     int rcode;
 
     /*
@@ -48,13 +47,9 @@ json_validate(const uint8_t *buf, const size_t len)
         return false;
     }
 
-    t = g_new0(jsmntok_t, max_tokens);
-
-    if (!t)
-        return false;
+    t = g_new(jsmntok_t, max_tokens);
 
-    jsmn_init(&p);
-    rcode = jsmn_parse(&p, buf, len, t, max_tokens);
+    rcode = json_parse_alloc((const char *)buf, len, &t, &max_tokens);
     if (rcode < 0) {
         switch (rcode) {
             case JSMN_ERROR_NOMEM:
@@ -87,6 +82,33 @@ json_parse(const char *buf, jsmntok_t *tokens, unsigned int max_tokens)
     return jsmn_parse(&p, buf, strlen(buf), tokens, max_tokens);
 }
 
+int
+json_parse_alloc(const char *buf, size_t len, jsmntok_t **tokens, unsigned int *max_tokens)
+{
+    jsmn_parser p;
+    int rcode;
+
+    if (*tokens == NULL || *max_tokens == 0) {
+        *max_tokens = 1024;
+        *tokens = g_renew(jsmntok_t, *tokens, *max_tokens);
+    }
+
+    /*
+     * jsmn_parse() stops at the token for which there was no room,
+     * leaving the parser state as it was before that token, so
+     * we can give it a larger array and let it carry on from there.
+     */
+    jsmn_init(&p);
+    while ((rcode = jsmn_parse(&p, buf, len, *tokens, *max_tokens)) == JSMN_ERROR_NOMEM) {
+        if (*max_tokens > G_MAXUINT / 2) {
+            break;
+        }
+        *max_tokens *= 2;
+        *tokens = g_renew(jsmntok_t, *tokens, *max_tokens);
+    }
+    return rcode;
+}
+
 static
 jsmntok_t *json_get_next_object(jsmntok_t *cur)
 {
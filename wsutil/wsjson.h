@@ -32,6 +32,17 @@ WS_DLL_PUBLIC bool json_validate(const uint8_t *buf, const size_t len);
 
 WS_DLL_PUBLIC int json_parse(const char *buf, jsmntok_t *tokens, unsigned int max_tokens);
 
+/**
+ * Parse the first len bytes of buf in a single pass, into an array of
+ * tokens that is grown with g_realloc() as needed.  *tokens and
+ * *max_tokens describe the array; they can be NULL and 0, or an array
+ * left by an earlier call, which is reused.  The caller must g_free()
+ * the array.
+ *
+ * Returns the number of tokens, or a negative jsmnerr value.
+ */
+WS_DLL_PUBLIC int json_parse_alloc(const char *buf, size_t len, jsmntok_t **tokens, unsigned int *max_tokens);
+
 /**
  * Get the pointer to an object belonging to parent object and named as the name variable.
  * Returns NULL if not found.